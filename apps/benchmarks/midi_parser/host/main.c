@@ -0,0 +1,138 @@
+// $Id$
+/*
+ * Host build of the MIDI Parser benchmark
+ * See README.txt for details
+ *
+ * The search functions of ../benchmark.c are executed NUM_LOOPS times
+ * (like the firmware does it) and this measurement is repeated NUM_ROUNDS
+ * times. The fastest round is reported to filter out disturbances of the
+ * host OS.
+ *
+ * One line is printed for each test:
+ *   test=<name> loops=<n> result=<n> time_us=<n.nnn>
+ *
+ * result is 0 if the search string has been found
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <string.h>
+#include <time.h>
+
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of search loops per measurement (same as in ../app.c)
+#ifndef NUM_LOOPS
+#define NUM_LOOPS 100
+#endif
+
+// number of measurements, the fastest one is reported
+#ifndef NUM_ROUNDS
+#define NUM_ROUNDS 1000
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef unsigned long long u64;
+
+typedef struct {
+  char *name;
+  s32 (*reset)(u32 par);
+  s32 (*start)(u32 par);
+} test_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// the AHB RAM variants of ../app.c are not relevant for the host
+static const test_t tests[] = {
+  { "linear_ram",           BENCHMARK_Reset_LinearRAM,          BENCHMARK_Start_LinearRAM },
+  { "linear_ram_known_len", BENCHMARK_Reset_LinearRAM_KnownLen, BENCHMARK_Start_LinearRAM_KnownLen },
+};
+
+#define NUM_TESTS (sizeof(tests)/sizeof(test_t))
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the monotonic time in nS
+/////////////////////////////////////////////////////////////////////////////
+static u64 HOST_TimeGet(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs a test and prints the results
+/////////////////////////////////////////////////////////////////////////////
+static void HOST_RunTest(const test_t *test)
+{
+  u64 min_time = ~0ULL;
+  s32 result = 0;
+  int round;
+
+  for(round=0; round<NUM_ROUNDS; ++round) {
+    test->reset(0);
+
+    u64 t0 = HOST_TimeGet();
+    int i;
+    for(i=0; i<NUM_LOOPS; ++i)
+      result |= test->start(0);
+    u64 time = HOST_TimeGet() - t0;
+
+    if( time < min_time )
+      min_time = time;
+  }
+
+  // time of a single search (like the firmware reports it)
+  u64 time_ns = min_time / NUM_LOOPS;
+
+  printf("test=%s loops=%d result=%d time_us=%llu.%03llu\n",
+	 test->name,
+	 NUM_LOOPS,
+	 (int)result,
+	 (unsigned long long)(time_ns / 1000),
+	 (unsigned long long)(time_ns % 1000));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main function
+// optional argument: name of the test which should be executed
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  BENCHMARK_Init(0);
+
+  int i;
+  for(i=0; i<NUM_TESTS; ++i) {
+    if( argc < 2 || strcmp(argv[1], tests[i].name) == 0 )
+      HOST_RunTest(&tests[i]);
+  }
+
+  return 0;
+}
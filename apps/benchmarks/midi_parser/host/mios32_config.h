@@ -0,0 +1,20 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// The boot message which is print during startup and returned on a SysEx query
+#define MIOS32_LCD_BOOT_MSG_LINE1 "Benchmark MIDI Parser"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(c) 2012 T.Klose"
+
+#define MIOS32_FAMILY_STR "EMULATION"
+#define MIOS32_BOARD_STR  "host"
+
+#endif /* _MIOS32_CONFIG_H */
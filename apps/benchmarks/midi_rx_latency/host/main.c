@@ -0,0 +1,345 @@
+// $Id$
+/*
+ * Host simulation of the MIDI receive latency
+ * See ../README.txt for details
+ *
+ * This is a model estimate: the MIOS32 code isn't executed, the task
+ * switches and execution times are modelled with the constants below.
+ *
+ * Simulates the MIDI task of programming_models/traditional/main.c with a
+ * resolution of 1 uS:
+ *   - poll:   TASK_MIDI_Hooks is woken up each mS by vTaskDelayUntil()
+ *   - notify: TASK_MIDI_Hooks is additionally woken up by MIOS32_MIDI_RxNotify()
+ *             (MIOS32_USE_MIDI_RX_NOTIFY)
+ *
+ * The latency is measured from the moment a complete MIDI event has been
+ * put into the receive buffer until APP_MIDI_NotifyPackage() is called.
+ *
+ * One line is printed for each scenario:
+ *   mode=<poll|notify> intf=<usb|uart> load=<idle|busy> events=<n>
+ *   min_us=<n> avg_us=<n> p50_us=<n> p90_us=<n> p99_us=<n> max_us=<n>
+ *   wakeups_per_sec=<n>
+ *
+ * With "-v" a histogram of the latencies is print in addition
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// simulated time for each scenario
+#ifndef SIM_SECONDS
+#define SIM_SECONDS 20
+#endif
+
+// average number of received MIDI events per second
+#ifndef EVENT_RATE
+#define EVENT_RATE 300
+#endif
+
+// max. execution time of APP_Tick() in the "busy" scenarios (uniformly distributed)
+#ifndef BUSY_APP_TICK_US
+#define BUSY_APP_TICK_US 600
+#endif
+
+// execution times of the MIDI task (rough estimations for a STM32F4 @ 168 MHz)
+#define PERIODIC_MS_US       5 // MIOS32_MIDI_Periodic_mS() + APP_MIDI_Tick()
+#define RECEIVE_HANDLER_US   2 // MIOS32_MIDI_Receive_Handler() without packages
+#define NOTIFY_PACKAGE_US    8 // APP_MIDI_NotifyPackage() per package
+#define NOTIFY_WAKEUP_US     3 // IRQ -> low prio IRQ -> semaphore -> context switch
+
+// one MIDI byte at 31250 baud
+#define UART_BYTE_US       320
+
+#define TICK_US           1000
+
+#define RX_BUFFER_SIZE     256
+#define MAX_EVENTS         (SIM_SECONDS*EVENT_RATE*2)
+
+#define HISTOGRAM_BIN_US   100
+#define HISTOGRAM_BINS      16
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef unsigned int u32;
+
+typedef enum {
+  MODE_POLL,
+  MODE_NOTIFY,
+} sim_mode_t;
+
+typedef enum {
+  INTF_USB,
+  INTF_UART,
+} sim_intf_t;
+
+typedef enum {
+  JOB_NONE,
+  JOB_HOOKS,
+  JOB_MIDI,
+} sim_job_t;
+
+typedef struct {
+  sim_mode_t mode;
+  sim_intf_t intf;
+  u32 app_tick_max_us;
+} scenario_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 random_seed_input;
+static u32 random_seed_rtos;
+
+static u32 rx_buffer[RX_BUFFER_SIZE]; // timestamps of complete events
+static u32 rx_buffer_tail;
+static u32 rx_buffer_size;
+
+static u32 latency[MAX_EVENTS];
+static u32 num_latencies;
+
+static u32 verbose;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Helper functions
+/////////////////////////////////////////////////////////////////////////////
+
+// deterministic random generator (xorshift), independent from the host libc
+// separate seeds ensure that all modes receive the same MIDI input
+static u32 Random(u32 *seed)
+{
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 17;
+  *seed ^= *seed << 5;
+  return *seed;
+}
+
+// exponentially distributed gap between two events
+static u32 RandomGap(void)
+{
+  double r = ((Random(&random_seed_input) & 0xffffff) + 1) / (double)0x1000000;
+  u32 gap = (u32)(-log(r) * (1000000.0 / EVENT_RATE));
+  return gap ? gap : 1;
+}
+
+static int CompareU32(const void *a, const void *b)
+{
+  u32 va = *(const u32 *)a;
+  u32 vb = *(const u32 *)b;
+  return (va > vb) - (va < vb);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Executes MIOS32_MIDI_Receive_Handler() at the given time
+// returns the execution time
+/////////////////////////////////////////////////////////////////////////////
+static u32 ReceiveHandler(u32 t)
+{
+  u32 duration = RECEIVE_HANDLER_US;
+
+  while( rx_buffer_size ) {
+    duration += NOTIFY_PACKAGE_US;
+
+    // APP_MIDI_NotifyPackage() is called at the beginning of the package processing
+    if( num_latencies < MAX_EVENTS )
+      latency[num_latencies++] = t + duration - NOTIFY_PACKAGE_US - rx_buffer[rx_buffer_tail];
+
+    rx_buffer_tail = (rx_buffer_tail + 1) % RX_BUFFER_SIZE;
+    --rx_buffer_size;
+  }
+
+  return duration;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs a single scenario
+/////////////////////////////////////////////////////////////////////////////
+static void RunScenario(scenario_t *s)
+{
+  u32 end = SIM_SECONDS * 1000000;
+  u32 t;
+
+  random_seed_input = 0x12345678;
+  random_seed_rtos = 0x87654321;
+  rx_buffer_tail = rx_buffer_size = 0;
+  num_latencies = 0;
+
+  // input
+  u32 next_byte_t = RandomGap();
+  u32 byte_ix = 0;
+
+  // RTOS
+  sim_job_t running = JOB_NONE;
+  u32 running_remaining = 0;
+  u32 hooks_ready = 0;
+  u32 hooks_duration = 0;
+  u32 midi_tick_ready = 0;
+  u32 midi_first = 0;
+  u32 semaphore = 0;
+  u32 semaphore_t = 0;
+  u32 wakeups = 0;
+
+  for(t=0; t<end; ++t) {
+    // MIDI input
+    if( t == next_byte_t ) {
+      u32 complete;
+
+      if( s->intf == INTF_USB ) {
+	// USB MIDI: a complete package is received with a single transfer
+	complete = 1;
+	next_byte_t = t + RandomGap();
+      } else {
+	// UART MIDI: 3 bytes, each one triggers the receive IRQ
+	complete = (++byte_ix >= 3);
+	if( complete ) {
+	  byte_ix = 0;
+	  next_byte_t = t + UART_BYTE_US + RandomGap();
+	} else {
+	  next_byte_t = t + UART_BYTE_US;
+	}
+      }
+
+      if( complete && rx_buffer_size < RX_BUFFER_SIZE ) {
+	rx_buffer[(rx_buffer_tail + rx_buffer_size) % RX_BUFFER_SIZE] = t;
+	++rx_buffer_size;
+      }
+
+      // MIOS32_MIDI_RxNotify()
+      if( s->mode == MODE_NOTIFY && !semaphore ) {
+	semaphore = 1;
+	semaphore_t = t + NOTIFY_WAKEUP_US;
+      }
+    }
+
+    // RTOS tick: TASK_Hooks and TASK_MIDI_Hooks are woken up
+    if( (t % TICK_US) == 0 ) {
+      hooks_ready = 1;
+      hooks_duration = s->app_tick_max_us ? (1 + Random(&random_seed_rtos) % s->app_tick_max_us) : 1;
+      midi_tick_ready = 1;
+      midi_first = Random(&random_seed_rtos) & 1; // both tasks have the same priority
+    }
+
+    // CPU
+    if( running_remaining ) {
+      if( --running_remaining == 0 )
+	running = JOB_NONE;
+    }
+
+    if( running == JOB_NONE ) {
+      u32 midi_ready = midi_tick_ready || (semaphore && t >= semaphore_t);
+
+      if( midi_ready && (!hooks_ready || midi_first) ) {
+	++wakeups;
+	running = JOB_MIDI;
+
+	u32 duration = 0;
+	if( midi_tick_ready ) {
+	  midi_tick_ready = 0;
+	  duration += PERIODIC_MS_US;
+	}
+	semaphore = 0;
+	running_remaining = duration + ReceiveHandler(t + duration);
+      } else if( hooks_ready ) {
+	hooks_ready = 0;
+	midi_first = 1; // round robin
+	running = JOB_HOOKS;
+	running_remaining = hooks_duration;
+      }
+    }
+  }
+
+  // statistics
+  qsort(latency, num_latencies, sizeof(u32), CompareU32);
+
+  double sum = 0;
+  u32 i;
+  for(i=0; i<num_latencies; ++i)
+    sum += latency[i];
+
+  printf("mode=%s intf=%s load=%s events=%u min_us=%u avg_us=%.1f p50_us=%u p90_us=%u p99_us=%u max_us=%u wakeups_per_sec=%u\n",
+	 (s->mode == MODE_POLL) ? "poll" : "notify",
+	 (s->intf == INTF_USB) ? "usb" : "uart",
+	 s->app_tick_max_us ? "busy" : "idle",
+	 num_latencies,
+	 num_latencies ? latency[0] : 0,
+	 num_latencies ? (sum / num_latencies) : 0.0,
+	 num_latencies ? latency[num_latencies/2] : 0,
+	 num_latencies ? latency[(num_latencies*90)/100] : 0,
+	 num_latencies ? latency[(num_latencies*99)/100] : 0,
+	 num_latencies ? latency[num_latencies-1] : 0,
+	 wakeups / SIM_SECONDS);
+
+  if( verbose ) {
+    u32 histogram[HISTOGRAM_BINS];
+    memset(histogram, 0, sizeof(histogram));
+
+    for(i=0; i<num_latencies; ++i) {
+      u32 bin = latency[i] / HISTOGRAM_BIN_US;
+      if( bin >= HISTOGRAM_BINS )
+	bin = HISTOGRAM_BINS - 1;
+      ++histogram[bin];
+    }
+
+    for(i=0; i<HISTOGRAM_BINS; ++i) {
+      u32 percent = num_latencies ? (histogram[i] * 100 + num_latencies/2) / num_latencies : 0;
+      printf("  %4u..%4u%s us: %5u ", i*HISTOGRAM_BIN_US, (i+1)*HISTOGRAM_BIN_US-1,
+	     (i == HISTOGRAM_BINS-1) ? "+" : " ", histogram[i]);
+      u32 j;
+      for(j=0; j<percent; ++j)
+	putchar('#');
+      putchar('\n');
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+
+  printf("# model estimate, not measured on hardware\n");
+
+  int load, intf, mode;
+  for(load=0; load<2; ++load) {
+    for(intf=0; intf<2; ++intf) {
+      for(mode=0; mode<2; ++mode) {
+	scenario_t s;
+	s.mode = mode ? MODE_NOTIFY : MODE_POLL;
+	s.intf = intf ? INTF_UART : INTF_USB;
+	s.app_tick_max_us = load ? BUSY_APP_TICK_US : 0;
+	RunScenario(&s);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,314 @@
+// $Id$
+/*
+ * Host benchmark of the OSC_CLIENT bundle mode
+ * See ../README.txt for details
+ *
+ * Sends the MIDI events of a sequencer step (note and CC on 16 tracks)
+ * with OSC_CLIENT_SendMIDIEvent(), calls OSC_CLIENT_Periodic_mS() after each
+ * step like the uIP task does each mS, and transfers the datagrams via a
+ * loopback UDP socket (stand-in for OSC_SERVER_SendPacket()).
+ * The receiver parses the datagrams with MIOS32_OSC_ParsePacket() and checks
+ * that all events arrive in the original order.
+ *
+ * One line is printed for each scenario:
+ *   transfer=<MIDI|Int.> bundle=<off|on> events=<n> datagrams=<n>
+ *   datagrams_per_step=<n> bytes=<n> send_us=<n> result=<ok|FAILED>
+ *
+ * The program returns 1 if any check failed
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <osc_server.h>
+#include <osc_client.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of sequencer steps for each scenario
+#ifndef NUM_STEPS
+#define NUM_STEPS 1000
+#endif
+
+#define NUM_TRACKS 16
+
+// a step sends a Note and a CC for each track
+#define MAX_EVENTS (NUM_STEPS*NUM_TRACKS*2)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static int tx_socket;
+static int rx_socket;
+static struct sockaddr_in rx_addr;
+
+static u32 num_datagrams;
+static u32 num_bytes;
+static double send_us;
+
+static mios32_midi_package_t sent_events[MAX_EVENTS];
+static u32 num_sent_events;
+static mios32_midi_package_t received_events[MAX_EVENTS];
+static u32 num_received_events;
+
+static u32 num_failed;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Debug messages are print to stdout
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stand-in for the OSC server: sends the datagram via the loopback interface
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_SERVER_SendPacket(u8 con, u8 *packet, u32 len)
+{
+  struct timespec t0, t1;
+
+  if( len == 0 )
+    return 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  ssize_t status = sendto(tx_socket, packet, len, 0, (struct sockaddr *)&rx_addr, sizeof(rx_addr));
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  send_us += (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+
+  if( status != len )
+    return -1;
+
+  ++num_datagrams;
+  num_bytes += len;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC methods of the receiver
+/////////////////////////////////////////////////////////////////////////////
+static void Received(mios32_midi_package_t p)
+{
+  if( num_received_events < MAX_EVENTS )
+    received_events[num_received_events++] = p;
+}
+
+static s32 Method_MIDI(mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  if( osc_args->num_args >= 1 && osc_args->arg_type[0] == 'm' )
+    Received(MIOS32_OSC_GetMIDI(osc_args->arg_ptr[0]));
+  return 0;
+}
+
+static s32 Method_Event(mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  if( osc_args->num_args >= 2 && osc_args->arg_type[0] == 'i' && osc_args->arg_type[1] == 'i' ) {
+    mios32_midi_package_t p;
+    p.ALL = 0;
+    p.type = (method_arg >> 4) & 0xf;
+    p.evnt0 = method_arg & 0xff;
+    p.evnt1 = MIOS32_OSC_GetInt(osc_args->arg_ptr[0]);
+    p.evnt2 = MIOS32_OSC_GetInt(osc_args->arg_ptr[1]);
+    Received(p);
+  }
+  return 0;
+}
+
+static const mios32_osc_search_tree_t parse_event[] = {
+  { "note", NULL, &Method_Event, 0x00000090 },
+  { "cc",   NULL, &Method_Event, 0x000000b0 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+static const mios32_osc_search_tree_t parse_root[] = {
+  { "midi1", NULL, &Method_MIDI, 0x00000000 },
+
+  { "1",  parse_event, NULL, 0x00000000 },
+  { "2",  parse_event, NULL, 0x00000001 },
+  { "3",  parse_event, NULL, 0x00000002 },
+  { "4",  parse_event, NULL, 0x00000003 },
+  { "5",  parse_event, NULL, 0x00000004 },
+  { "6",  parse_event, NULL, 0x00000005 },
+  { "7",  parse_event, NULL, 0x00000006 },
+  { "8",  parse_event, NULL, 0x00000007 },
+  { "9",  parse_event, NULL, 0x00000008 },
+  { "10", parse_event, NULL, 0x00000009 },
+  { "11", parse_event, NULL, 0x0000000a },
+  { "12", parse_event, NULL, 0x0000000b },
+  { "13", parse_event, NULL, 0x0000000c },
+  { "14", parse_event, NULL, 0x0000000d },
+  { "15", parse_event, NULL, 0x0000000e },
+  { "16", parse_event, NULL, 0x0000000f },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Receives and parses all pending datagrams
+/////////////////////////////////////////////////////////////////////////////
+static void Receive(void)
+{
+  u8 packet[2048];
+  ssize_t len;
+
+  while( (len = recv(rx_socket, packet, sizeof(packet), MSG_DONTWAIT)) > 0 ) {
+    s32 status = MIOS32_OSC_ParsePacket(packet, len, parse_root);
+    if( status < 0 ) {
+      printf("  invalid OSC packet, status %d\n", status);
+      ++num_failed;
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs a single scenario
+/////////////////////////////////////////////////////////////////////////////
+static void RunScenario(u8 transfer_mode, u8 bundle_mode)
+{
+  u32 step, track;
+
+  num_datagrams = num_bytes = 0;
+  send_us = 0;
+  num_sent_events = num_received_events = 0;
+
+  OSC_CLIENT_Init(0);
+  OSC_CLIENT_TransferModeSet(0, transfer_mode);
+  OSC_CLIENT_BundleModeSet(0, bundle_mode);
+
+  for(step=0; step<NUM_STEPS; ++step) {
+    for(track=0; track<NUM_TRACKS; ++track) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.evnt0 = 0x90 | track;
+      p.evnt1 = 0x24 + ((step + track) % 48);
+      p.evnt2 = 1 + (step % 127);
+      sent_events[num_sent_events++] = p;
+      OSC_CLIENT_SendMIDIEvent(0, p);
+
+      p.type = CC;
+      p.evnt0 = 0xb0 | track;
+      p.evnt1 = 0x10 + (track % 8);
+      p.evnt2 = step % 128;
+      sent_events[num_sent_events++] = p;
+      OSC_CLIENT_SendMIDIEvent(0, p);
+    }
+
+    // the uIP task flushes the bundles each mS
+    OSC_CLIENT_Periodic_mS();
+
+    Receive();
+  }
+
+  // wait for the last datagrams
+  usleep(10000);
+  Receive();
+
+  u8 ok = num_received_events == num_sent_events;
+  if( !ok ) {
+    printf("  received %u of %u events\n", num_received_events, num_sent_events);
+  } else {
+    u32 i;
+    for(i=0; i<num_sent_events; ++i) {
+      if( received_events[i].ALL != sent_events[i].ALL ) {
+	printf("  event #%u: received %08x, expected %08x\n", i, received_events[i].ALL, sent_events[i].ALL);
+	ok = 0;
+	break;
+      }
+    }
+  }
+
+  if( !ok )
+    ++num_failed;
+
+  printf("transfer=%s bundle=%s events=%u datagrams=%u datagrams_per_step=%.1f bytes=%u send_us=%.0f result=%s\n",
+	 OSC_CLIENT_TransferModeShortNameGet(transfer_mode),
+	 bundle_mode ? "on" : "off",
+	 num_sent_events,
+	 num_datagrams,
+	 (double)num_datagrams / NUM_STEPS,
+	 num_bytes,
+	 send_us,
+	 ok ? "ok" : "FAILED");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  // loopback UDP connection
+  tx_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  rx_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  if( tx_socket < 0 || rx_socket < 0 ) {
+    perror("socket");
+    return 1;
+  }
+
+  int rcvbuf = 4*1024*1024;
+  setsockopt(rx_socket, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  memset(&rx_addr, 0, sizeof(rx_addr));
+  rx_addr.sin_family = AF_INET;
+  rx_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  rx_addr.sin_port = 0; // any free port
+  socklen_t addr_len = sizeof(rx_addr);
+  if( bind(rx_socket, (struct sockaddr *)&rx_addr, sizeof(rx_addr)) < 0 ||
+      getsockname(rx_socket, (struct sockaddr *)&rx_addr, &addr_len) < 0 ) {
+    perror("bind");
+    return 1;
+  }
+
+  RunScenario(OSC_CLIENT_TRANSFER_MODE_MIDI, 0);
+  RunScenario(OSC_CLIENT_TRANSFER_MODE_MIDI, 1);
+  RunScenario(OSC_CLIENT_TRANSFER_MODE_INT, 0);
+  RunScenario(OSC_CLIENT_TRANSFER_MODE_INT, 1);
+
+  close(tx_socket);
+  close(rx_socket);
+
+  printf("%s: %u scenario(s) failed\n", num_failed ? "FAILED" : "PASSED", num_failed);
+
+  return num_failed ? 1 : 0;
+}
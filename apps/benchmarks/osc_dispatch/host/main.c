@@ -0,0 +1,381 @@
+// $Id$
+/*
+ * Host benchmark of the compiled OSC dispatcher
+ * See ../README.txt for details
+ *
+ * Generates OSC traffic like it is sent by TouchOSC, Lemur and MIDI bridges
+ * to the osc_server module (literal addresses, TouchOSC style "note_<n>"
+ * addresses, wildcard paths, unknown addresses, single messages and bundles),
+ * and parses it with MIOS32_OSC_ParsePacket() using a copy of the search
+ * tree of modules/uip_task_standard/osc_server.c
+ *
+ * The traffic is parsed first with the linear search, then again after
+ * MIOS32_OSC_CompileSearchTree(). All method calls (method, method_arg,
+ * path parts and first argument) are recorded and compared.
+ *
+ * One line is printed for each path:
+ *   path=<linear|compiled> packets=<n> messages=<n> calls=<n> ns_per_message=<n>
+ *
+ * The program returns 1 if the method calls are not identical
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of runs through the traffic for each path
+#ifndef NUM_RUNS
+#define NUM_RUNS 200
+#endif
+
+#define NUM_PACKETS   4000
+#define MAX_PACKET_SIZE 256
+#define MAX_CALLS     (NUM_PACKETS*8)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u8  method;
+  u8  num_path_parts;
+  u32 method_arg;
+  u32 path_hash;
+  s32 value;
+} call_t;
+
+typedef struct {
+  u32 len;
+  u8  data[MAX_PACKET_SIZE];
+} packet_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static packet_t packets[NUM_PACKETS];
+static u32 num_messages;
+
+static call_t *calls;
+static u32 num_calls;
+
+static call_t linear_calls[MAX_CALLS];
+static u32 num_linear_calls;
+static call_t compiled_calls[MAX_CALLS];
+static u32 num_compiled_calls;
+
+static u32 random_seed;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Debug messages are print to stdout
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC methods: record the call
+/////////////////////////////////////////////////////////////////////////////
+static s32 Record(u8 method, mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  if( calls == NULL || num_calls >= MAX_CALLS )
+    return 0;
+
+  call_t *c = &calls[num_calls++];
+  c->method = method;
+  c->num_path_parts = osc_args->num_path_parts;
+  c->method_arg = method_arg;
+
+  // the path parts reference the addresses of the search tree
+  u32 hash = 0;
+  int i;
+  for(i=0; i<osc_args->num_path_parts; ++i)
+    hash = hash*31 + (u32)(size_t)osc_args->path_part[i];
+  c->path_hash = hash;
+
+  c->value = (osc_args->num_args >= 1 && osc_args->arg_type[0] == 'i') ? MIOS32_OSC_GetInt(osc_args->arg_ptr[0]) : -1;
+
+  return 0;
+}
+
+static s32 Method_MIDI(mios32_osc_args_t *osc_args, u32 method_arg)      { return Record(1, osc_args, method_arg); }
+static s32 Method_MCMPP(mios32_osc_args_t *osc_args, u32 method_arg)     { return Record(2, osc_args, method_arg); }
+static s32 Method_EventTOSC(mios32_osc_args_t *osc_args, u32 method_arg) { return Record(3, osc_args, method_arg); }
+static s32 Method_Event(mios32_osc_args_t *osc_args, u32 method_arg)     { return Record(4, osc_args, method_arg); }
+static s32 Method_EventNRPN(mios32_osc_args_t *osc_args, u32 method_arg) { return Record(5, osc_args, method_arg); }
+static s32 Method_EventPB(mios32_osc_args_t *osc_args, u32 method_arg)   { return Record(6, osc_args, method_arg); }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Search tree (same structure like in modules/uip_task_standard/osc_server.c)
+/////////////////////////////////////////////////////////////////////////////
+
+static const mios32_osc_search_tree_t parse_mcmpp_value[] = {
+  { "*", NULL, &Method_MCMPP, 0x00000000 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+static const mios32_osc_search_tree_t parse_mcmpp[] = {
+  { "key",           parse_mcmpp_value, NULL, 0x00000090 },
+  { "polypressure",  parse_mcmpp_value, NULL, 0x000000a0 },
+  { "cc",            parse_mcmpp_value, NULL, 0x000000b0 },
+  { "programchange", parse_mcmpp_value, NULL, 0x000000c0 },
+  { "aftertouch",    parse_mcmpp_value, NULL, 0x000000d0 },
+  { "pitch",         parse_mcmpp_value, NULL, 0x000000e0 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+static const mios32_osc_search_tree_t parse_event[] = {
+  { "note_*",        NULL, &Method_EventTOSC, 0x00000090 },
+  { "polypressure_*",NULL, &Method_EventTOSC, 0x000000a0 },
+  { "cc_*",          NULL, &Method_EventTOSC, 0x000000b0 },
+  { "programchange_*", NULL, &Method_EventTOSC, 0x000000c0 },
+
+  { "note",          NULL, &Method_Event,     0x00000090 },
+  { "polypressure",  NULL, &Method_Event,     0x000000a0 },
+  { "cc",            NULL, &Method_Event,     0x000000b0 },
+  { "nrpn",          NULL, &Method_EventNRPN, 0x000000b0 },
+  { "programchange", NULL, &Method_Event,     0x000000c0 },
+  { "aftertouch",    NULL, &Method_Event,     0x000000b0 },
+  { "pitchbend",     NULL, &Method_EventPB,   0x000000e0 },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+static const mios32_osc_search_tree_t parse_root[] = {
+  { "midi",  NULL, &Method_MIDI, 0x00000000 },
+  { "midi1", NULL, &Method_MIDI, 0x00000000 },
+  { "midi2", NULL, &Method_MIDI, 0x00010000 },
+  { "midi3", NULL, &Method_MIDI, 0x00020000 },
+  { "midi4", NULL, &Method_MIDI, 0x00030000 },
+
+  { "mcmpp", parse_mcmpp, NULL, 0x00000000 },
+
+  { "1",  parse_event, NULL, 0x00000000 },
+  { "2",  parse_event, NULL, 0x00000001 },
+  { "3",  parse_event, NULL, 0x00000002 },
+  { "4",  parse_event, NULL, 0x00000003 },
+  { "5",  parse_event, NULL, 0x00000004 },
+  { "6",  parse_event, NULL, 0x00000005 },
+  { "7",  parse_event, NULL, 0x00000006 },
+  { "8",  parse_event, NULL, 0x00000007 },
+  { "9",  parse_event, NULL, 0x00000008 },
+  { "10", parse_event, NULL, 0x00000009 },
+  { "11", parse_event, NULL, 0x0000000a },
+  { "12", parse_event, NULL, 0x0000000b },
+  { "13", parse_event, NULL, 0x0000000c },
+  { "14", parse_event, NULL, 0x0000000d },
+  { "15", parse_event, NULL, 0x0000000e },
+  { "16", parse_event, NULL, 0x0000000f },
+
+  { NULL, NULL, NULL, 0 } // terminator
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Traffic generator
+/////////////////////////////////////////////////////////////////////////////
+
+// deterministic random generator (xorshift), independent from the host libc
+static u32 Random(void)
+{
+  random_seed ^= random_seed << 13;
+  random_seed ^= random_seed >> 17;
+  random_seed ^= random_seed << 5;
+  return random_seed;
+}
+
+// puts a message with two integer arguments into the buffer
+static u8 *PutMessage(u8 *buffer, char *path, s32 value1, s32 value2)
+{
+  buffer = MIOS32_OSC_PutString(buffer, path);
+  buffer = MIOS32_OSC_PutString(buffer, ",ii");
+  buffer = MIOS32_OSC_PutInt(buffer, value1);
+  buffer = MIOS32_OSC_PutInt(buffer, value2);
+  ++num_messages;
+  return buffer;
+}
+
+// generates a random address of the recorded traffic
+static void RandomPath(char *path)
+{
+  static const char *events[] = { "note", "cc", "polypressure", "programchange", "aftertouch", "pitchbend", "nrpn" };
+  static const char *tosc_events[] = { "note", "cc", "polypressure", "programchange" };
+  static const char *mcmpp[] = { "key", "cc", "pitch", "aftertouch" };
+
+  u32 r = Random() % 100;
+  u32 chn = 1 + Random() % 16;
+
+  if( r < 45 ) {
+    // literal channel events, e.g. /3/cc
+    sprintf(path, "/%u/%s", chn, events[Random() % 7]);
+  } else if( r < 75 ) {
+    // TouchOSC style: /3/note_60
+    sprintf(path, "/%u/%s_%u", chn, tosc_events[Random() % 4], Random() % 128);
+  } else if( r < 85 ) {
+    // pianist pro format: /mcmpp/key/60
+    sprintf(path, "/mcmpp/%s/%u", mcmpp[Random() % 4], Random() % 128);
+  } else if( r < 90 ) {
+    // wildcard paths
+    static const char *patterns[] = { "/*/note", "/1?/cc", "/midi?", "/?/note_*", "/mcmpp/*/1" };
+    strcpy(path, patterns[Random() % 5]);
+  } else if( r < 95 ) {
+    // unknown addresses
+    sprintf(path, "/%u/fader%u", chn, Random() % 8);
+  } else {
+    sprintf(path, "/%u/%s", chn, "note");
+  }
+}
+
+static void GenerateTraffic(void)
+{
+  u32 i;
+
+  random_seed = 0x12345678;
+  num_messages = 0;
+
+  for(i=0; i<NUM_PACKETS; ++i) {
+    packet_t *p = &packets[i];
+    u8 *end_ptr = p->data;
+    char path[64];
+
+    if( (Random() % 4) == 0 ) {
+      // bundle with up to 4 messages
+      mios32_osc_timetag_t timetag;
+      timetag.seconds = 0;
+      timetag.fraction = 1;
+      end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
+      end_ptr = MIOS32_OSC_PutTimetag(end_ptr, timetag);
+
+      u32 num = 1 + Random() % 4;
+      u32 j;
+      for(j=0; j<num; ++j) {
+	u8 *insert_len_ptr = end_ptr;
+	end_ptr += 4;
+	RandomPath(path);
+	end_ptr = PutMessage(end_ptr, path, Random() % 128, Random() % 128);
+	MIOS32_OSC_PutWord(insert_len_ptr, (u32)(end_ptr-insert_len_ptr-4));
+      }
+    } else {
+      RandomPath(path);
+      end_ptr = PutMessage(end_ptr, path, Random() % 128, Random() % 128);
+    }
+
+    p->len = (u32)(end_ptr - p->data);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parses the traffic NUM_RUNS times, the method calls of the first run are recorded
+/////////////////////////////////////////////////////////////////////////////
+static s32 ParseTraffic(const char *name, call_t *recorded_calls, u32 *num_recorded_calls)
+{
+  struct timespec t0, t1;
+  u32 run, i;
+
+  calls = recorded_calls;
+  num_calls = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for(run=0; run<NUM_RUNS; ++run) {
+    for(i=0; i<NUM_PACKETS; ++i) {
+      s32 status = MIOS32_OSC_ParsePacket(packets[i].data, packets[i].len, parse_root);
+      if( status < 0 ) {
+	printf("  packet #%u: parser returned %d\n", i, status);
+	return -1;
+      }
+    }
+
+    if( run == 0 ) {
+      *num_recorded_calls = num_calls;
+      calls = NULL;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+  printf("path=%s packets=%u messages=%u calls=%u ns_per_message=%.1f\n",
+	 name,
+	 NUM_PACKETS,
+	 num_messages,
+	 *num_recorded_calls,
+	 ns / ((double)NUM_RUNS * num_messages));
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  u32 num_failed = 0;
+
+  GenerateTraffic();
+
+  if( ParseTraffic("linear", linear_calls, &num_linear_calls) < 0 )
+    ++num_failed;
+
+  s32 status = MIOS32_OSC_CompileSearchTree(parse_root);
+  if( status < 0 ) {
+    printf("MIOS32_OSC_CompileSearchTree() failed with status %d\n", status);
+    ++num_failed;
+  }
+
+  if( ParseTraffic("compiled", compiled_calls, &num_compiled_calls) < 0 )
+    ++num_failed;
+
+  if( num_linear_calls != num_compiled_calls ) {
+    printf("  compiled path: %u method calls, expected %u\n", num_compiled_calls, num_linear_calls);
+    ++num_failed;
+  } else {
+    u32 i;
+    for(i=0; i<num_linear_calls; ++i) {
+      if( memcmp(&linear_calls[i], &compiled_calls[i], sizeof(call_t)) != 0 ) {
+	printf("  method call #%u differs\n", i);
+	++num_failed;
+	break;
+      }
+    }
+  }
+
+  printf("%s: %s\n", num_failed ? "FAILED" : "PASSED", num_failed ? "method calls differ" : "identical method calls");
+
+  return num_failed ? 1 : 0;
+}
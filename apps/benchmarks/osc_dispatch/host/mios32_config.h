@@ -0,0 +1,36 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// The boot message which is print during startup and returned on a SysEx query
+#define MIOS32_LCD_BOOT_MSG_LINE1 "OSC Dispatch Benchmark"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(c) 2009 T.Klose"
+
+#define MIOS32_FAMILY_STR "EMULATION"
+#define MIOS32_BOARD_STR  "host"
+
+// no hardware interfaces available: OSC packets are generated by main.c
+#define MIOS32_DONT_USE_USB
+#define MIOS32_DONT_USE_UART
+#define MIOS32_DONT_USE_IIC
+#define MIOS32_DONT_USE_USB_MIDI
+#define MIOS32_DONT_USE_UART_MIDI
+#define MIOS32_DONT_USE_IIC_MIDI
+#define MIOS32_DONT_USE_SPI_MIDI
+
+// enable the compiled OSC dispatcher (see MIOS32_OSC_CompileSearchTree())
+#define MIOS32_OSC_COMPILED_LEVELS 8
+
+// use printf instead of MIOS32_MIDI_SendDebugMessage to print debug messages
+#define DEBUG_MSG printf
+#define MIOS32_OSC_DEBUG_MSG printf
+
+#endif /* _MIOS32_CONFIG_H */
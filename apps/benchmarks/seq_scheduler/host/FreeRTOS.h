@@ -0,0 +1,14 @@
+// Dummy Header file - FreeRTOS not used by the host build
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdlib.h>
+
+#define pvPortMalloc malloc
+#define vPortFree    free
+
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#endif /* INC_FREERTOS_H */
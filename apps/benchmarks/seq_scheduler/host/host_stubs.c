@@ -0,0 +1,81 @@
+// $Id$
+/*
+ * Stub HAL for the host build of the MIDI Out Scheduler benchmark
+ * Only the functions which are referenced by mios32_midi.c and the
+ * sequencer modules are provided.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// IRQ: the benchmark is single threaded, nothing to disable
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Disable(void)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_IRQ_Enable(void)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Timer: the BPM generator isn't clocked by a timer, ticks are set by the
+// benchmark via SEQ_MIDI_OUT_Callback_BPM_TickGet_Set()
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_Init(u8 timer, u32 period, void (*_irq_handler)(void), u8 irq_priority)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_TIMER_ReInit(u8 timer, u32 period)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// System: only requested by SysEx queries
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_Reset(void)
+{
+  exit(0);
+  return 0; // no error
+}
+
+u32 MIOS32_SYS_ChipIDGet(void)
+{
+  return 0;
+}
+
+u32 MIOS32_SYS_FlashSizeGet(void)
+{
+  return 0;
+}
+
+u32 MIOS32_SYS_RAMSizeGet(void)
+{
+  return 0;
+}
+
+s32 MIOS32_SYS_SerialNumberGet(char *str)
+{
+  strcpy(str, "000000000000000000000000");
+  return 0; // no error
+}
@@ -0,0 +1,540 @@
+// $Id$
+/*
+ * Host build of the MIDI Out Scheduler benchmark
+ * See README.txt for details
+ *
+ * The real SEQ_MIDI_OUT, SEQ_BPM, MID_PARSER and MIOS32_MIDI modules are
+ * used, the BPM tick is provided by a deterministic tick source and MIDI
+ * packages are captured by the direct Tx callback of MIOS32_MIDI.
+ *
+ * One line is printed for each scenario:
+ *   scenario=<name> scheduler=<n> max_events=<n> ticks=<n> events=<n>
+ *   elapsed_us=<n> events_per_sec=<n> max_tick_us=<n.nnn>
+ *   max_allocated=<n> dropouts=<n> checksum=<hex>
+ *
+ * ticks, events, max_allocated, dropouts and checksum don't depend on the
+ * host, they can be used to detect functional regressions.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <seq_bpm.h>
+#include <seq_midi_out.h>
+#include <mid_parser.h>
+
+#include <string.h>
+#include <time.h>
+
+#include "mid_file.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of times each scenario is repeated (results are accumulated)
+#ifndef NUM_ROUNDS
+#define NUM_ROUNDS 20
+#endif
+
+// synthetic songs
+#define STRESS_PPQN         384
+#define STRESS_NUM_TRACKS   16
+#define STRESS_NUM_STEPS    1024
+#define STRESS_STEP_TICKS   (STRESS_PPQN/4)
+#define STRESS_NUM_ECHOS    4
+#define STRESS_ECHO_TICKS   (STRESS_STEP_TICKS/2)
+#define STRESS_HUMANIZE     8
+
+// all events are sent to this port (captured by the Tx callback)
+#define OUT_PORT USB0
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef unsigned long long u64;
+
+typedef struct {
+  char *name;
+  void (*reset)(void);
+  s32 (*tick)(u32 bpm_tick); // returns 0 once the song has been finished
+  void (*tick_late)(u32 bpm_tick); // optional: called between two handler calls of the same tick
+} scenario_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void MidiFile_Reset(void);
+static s32 MidiFile_Tick(u32 bpm_tick);
+static void Stress_Reset(void);
+static s32 Stress_Tick(u32 bpm_tick);
+static void Sustain_Reset(void);
+static s32 Sustain_Tick(u32 bpm_tick);
+static void ReSchedule_Reset(void);
+static s32 ReSchedule_Tick(u32 bpm_tick);
+static void Late_Reset(void);
+static s32 Late_Tick(u32 bpm_tick);
+static void Late_TickLate(u32 bpm_tick);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static const scenario_t scenarios[] = {
+  { "mb_midifile_demo", MidiFile_Reset, MidiFile_Tick, NULL },
+  { "stress_echo",      Stress_Reset,   Stress_Tick, NULL },
+  { "stress_sustain",   Sustain_Reset,  Sustain_Tick, NULL },
+  { "reschedule_mix",   ReSchedule_Reset, ReSchedule_Tick, NULL },
+  { "late_events",      Late_Reset,     Late_Tick, Late_TickLate },
+};
+
+#define NUM_SCENARIOS (sizeof(scenarios)/sizeof(scenario_t))
+
+static u32 host_bpm_tick;
+static u32 host_events;
+static u32 host_checksum;
+static u32 random_seed;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Deterministic tick source
+/////////////////////////////////////////////////////////////////////////////
+static s32 HOST_BpmIsRunning(void)
+{
+  return 1;
+}
+
+static u32 HOST_BpmTickGet(void)
+{
+  return host_bpm_tick;
+}
+
+static s32 HOST_BpmSet(float bpm)
+{
+  return 0; // tempo changes don't matter, ticks are generated as fast as possible
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Captures all outgoing MIDI packages
+/////////////////////////////////////////////////////////////////////////////
+static s32 HOST_MIDI_TxCallback(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  ++host_events;
+
+  // FNV-1a over tick, port and package
+  u32 data[3] = { host_bpm_tick, port, package.ALL };
+  u8 *ptr = (u8 *)data;
+  int i;
+  for(i=0; i<sizeof(data); ++i) {
+    host_checksum ^= ptr[i];
+    host_checksum *= 16777619;
+  }
+
+  return 1; // filter package (no interface available)
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reproducible random numbers for humanize and echo FX
+/////////////////////////////////////////////////////////////////////////////
+static u32 HOST_Random(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return ((random_seed >> 16) & 0x7fff) % range;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the monotonic time in nS
+/////////////////////////////////////////////////////////////////////////////
+static u64 HOST_TimeGet(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scenario: the MIDI file which is also played by the MBHP_CORE benchmark
+/////////////////////////////////////////////////////////////////////////////
+static s32 MidiFile_PlayEvent(u8 track, mios32_midi_package_t midi_package, u32 tick)
+{
+  // the parser doesn't initialize the tag and the unused byte of 2-byte events
+  // (would result into different checksums)
+  midi_package.cable = track;
+  if( midi_package.event == ProgramChange || midi_package.event == Aftertouch )
+    midi_package.evnt2 = 0;
+
+  seq_midi_out_event_type_t event_type = SEQ_MIDI_OUT_OnEvent;
+  if( midi_package.event == NoteOff || (midi_package.event == NoteOn && midi_package.velocity == 0) )
+    event_type = SEQ_MIDI_OUT_OffEvent;
+  else if( midi_package.event == CC )
+    event_type = SEQ_MIDI_OUT_CCEvent;
+
+  SEQ_MIDI_OUT_Send(OUT_PORT, midi_package, event_type, tick, 0);
+
+  return 0; // no error
+}
+
+static s32 MidiFile_PlayMeta(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick)
+{
+  return 0; // no error
+}
+
+static void MidiFile_Reset(void)
+{
+  MID_FILE_Init(0);
+  MID_PARSER_Init(0);
+  MID_PARSER_InstallFileCallbacks(&MID_FILE_read, &MID_FILE_eof, &MID_FILE_seek);
+  MID_PARSER_InstallEventCallbacks(&MidiFile_PlayEvent, &MidiFile_PlayMeta);
+
+  MID_FILE_open("dummy");
+  MID_PARSER_Read();
+}
+
+static s32 MidiFile_Tick(u32 bpm_tick)
+{
+  return MID_PARSER_FetchEvents(bpm_tick, 1) > 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scenario: 16 tracks playing 16th notes with humanize, echo repeats
+// and a CC for each step, MIDI clock is sent as well
+/////////////////////////////////////////////////////////////////////////////
+static void Stress_Reset(void)
+{
+  random_seed = 1;
+}
+
+static s32 Stress_Tick(u32 bpm_tick)
+{
+  if( (bpm_tick % (STRESS_PPQN/24)) == 0 ) {
+    mios32_midi_package_t p;
+    p.ALL = 0;
+    p.type = 0x5; // single byte
+    p.evnt0 = 0xf8;
+    SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_ClkEvent, bpm_tick, 0);
+  }
+
+  if( (bpm_tick % STRESS_STEP_TICKS) == 0 ) {
+    u8 track;
+    for(track=0; track<STRESS_NUM_TRACKS; ++track) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = CC;
+      p.event = CC;
+      p.chn = track;
+      p.cc_number = 1;
+      p.value = HOST_Random(128);
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_CCEvent, bpm_tick, 0);
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = track;
+      p.note = 36 + HOST_Random(48);
+      p.velocity = 100;
+      p.cable = track; // tag
+
+      int echo;
+      for(echo=0; echo<=STRESS_NUM_ECHOS; ++echo) {
+	u32 timestamp = bpm_tick + echo*STRESS_ECHO_TICKS + HOST_Random(STRESS_HUMANIZE);
+	u32 len = 1 + HOST_Random(2*STRESS_STEP_TICKS);
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnOffEvent, timestamp, len);
+	p.velocity = (p.velocity * 3) / 4;
+      }
+    }
+  }
+
+  return bpm_tick < (STRESS_NUM_STEPS*STRESS_STEP_TICKS);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scenario: 8 tracks playing sustained/glided notes - each note is
+// stopped with SEQ_MIDI_OUT_ReSchedule() when the next note is played.
+// 8 additional tracks play randomly placed notes with a different tag
+// (SEQ_MIDI_OUT_ReSchedule() stops searching at the first matching event
+// which is played earlier anyhow)
+/////////////////////////////////////////////////////////////////////////////
+static void Sustain_Reset(void)
+{
+  random_seed = 1;
+}
+
+static s32 Sustain_Tick(u32 bpm_tick)
+{
+  if( (bpm_tick % STRESS_STEP_TICKS) == 0 ) {
+    u8 track;
+    for(track=0; track<STRESS_NUM_TRACKS; ++track) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = track;
+      p.note = 36 + HOST_Random(48);
+      p.velocity = 100;
+      p.cable = track; // tag
+
+      if( track < (STRESS_NUM_TRACKS/2) ) {
+	// stop the previous note
+	SEQ_MIDI_OUT_ReSchedule(track, SEQ_MIDI_OUT_OffEvent, bpm_tick + 1, NULL);
+
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnEvent, bpm_tick, 0);
+	p.velocity = 0;
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+      } else {
+	// some additional events in the queue
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnOffEvent, bpm_tick + HOST_Random(4*STRESS_STEP_TICKS), STRESS_STEP_TICKS/2);
+      }
+    }
+  }
+
+  // stop the sustained notes of all tracks at the end of the song
+  if( bpm_tick == (STRESS_NUM_STEPS*STRESS_STEP_TICKS) )
+    SEQ_MIDI_OUT_ReScheduleTags((1 << (STRESS_NUM_TRACKS/2))-1, SEQ_MIDI_OUT_OffEvent, bpm_tick, NULL);
+
+  return bpm_tick < (STRESS_NUM_STEPS*STRESS_STEP_TICKS);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scenario: like stress_sustain, but short notes are played with the same
+// tag. SEQ_MIDI_OUT_ReSchedule() stops at the first Off event which is
+// played before the new timestamp, so that the sustained notes are only
+// stopped at some steps, and sometimes together with a short note.
+// This checks, that all scheduler methods re-schedule the same events
+// in the same order.
+/////////////////////////////////////////////////////////////////////////////
+static void ReSchedule_Reset(void)
+{
+  random_seed = 1;
+}
+
+static s32 ReSchedule_Tick(u32 bpm_tick)
+{
+  if( (bpm_tick % STRESS_STEP_TICKS) == 0 && bpm_tick < (STRESS_NUM_STEPS*STRESS_STEP_TICKS) ) {
+    u8 track;
+    for(track=0; track<STRESS_NUM_TRACKS/2; ++track) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = track;
+      p.note = 36 + HOST_Random(48);
+      p.velocity = 100;
+      p.cable = track; // tag
+
+      // stop the sustained notes
+      SEQ_MIDI_OUT_ReSchedule(track, SEQ_MIDI_OUT_OffEvent, bpm_tick + 1 + HOST_Random(STRESS_STEP_TICKS/2), NULL);
+
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnEvent, bpm_tick, 0);
+      p.velocity = 0;
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+
+      // a short note with the same tag at every second step
+      if( HOST_Random(2) ) {
+	p.note = 36 + HOST_Random(48);
+	p.velocity = 100;
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnEvent, bpm_tick, 0);
+	p.velocity = 0;
+	SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OffEvent, bpm_tick + 1 + HOST_Random(2*STRESS_STEP_TICKS), 0);
+      }
+    }
+  }
+
+  // stop the sustained notes of all tracks once the short notes have been played
+  if( bpm_tick == ((STRESS_NUM_STEPS+2)*STRESS_STEP_TICKS) )
+    SEQ_MIDI_OUT_ReScheduleTags((1 << (STRESS_NUM_TRACKS/2))-1, SEQ_MIDI_OUT_OffEvent, bpm_tick, NULL);
+
+  return bpm_tick < ((STRESS_NUM_STEPS+2)*STRESS_STEP_TICKS);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scenario: the handler is called twice per tick, and events are sent
+// between the two calls for the current and for past ticks, e.g. sustained
+// notes which are stopped at bpm_tick-1 like SEQ_CORE does.
+// The sorted list plays such events with the second handler call, all
+// scheduler methods have to send them at the same tick.
+/////////////////////////////////////////////////////////////////////////////
+static void Late_Reset(void)
+{
+  random_seed = 1;
+}
+
+static s32 Late_Tick(u32 bpm_tick)
+{
+  if( (bpm_tick % STRESS_STEP_TICKS) == 0 && bpm_tick < (STRESS_NUM_STEPS*STRESS_STEP_TICKS) ) {
+    u8 track;
+    for(track=0; track<STRESS_NUM_TRACKS/2; ++track) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = track;
+      p.note = 36 + HOST_Random(48);
+      p.velocity = 100;
+      p.cable = track; // tag
+
+      // sustained note, will be stopped by Late_TickLate()
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnEvent, bpm_tick, 0);
+      p.velocity = 0;
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+    }
+  }
+
+  // stop the remaining sustained notes at the end of the song
+  if( bpm_tick == (STRESS_NUM_STEPS*STRESS_STEP_TICKS) )
+    SEQ_MIDI_OUT_ReScheduleTags((1 << (STRESS_NUM_TRACKS/2))-1, SEQ_MIDI_OUT_OffEvent, bpm_tick, NULL);
+
+  return bpm_tick < (STRESS_NUM_STEPS*STRESS_STEP_TICKS);
+}
+
+static void Late_TickLate(u32 bpm_tick)
+{
+  u8 track;
+  for(track=0; track<STRESS_NUM_TRACKS/2; ++track) {
+    // stop the sustained notes of some tracks one tick before the next step
+    if( ((bpm_tick + 1) % STRESS_STEP_TICKS) == 0 && HOST_Random(2) )
+      SEQ_MIDI_OUT_ReSchedule(track, SEQ_MIDI_OUT_OffEvent, bpm_tick ? (bpm_tick-1) : 0, NULL);
+
+    // events for the current and past ticks, e.g. sent by a MIDI router
+    if( HOST_Random(16) == 0 ) {
+      mios32_midi_package_t p;
+
+      p.ALL = 0;
+      p.type = CC;
+      p.event = CC;
+      p.chn = track;
+      p.cc_number = 1;
+      p.value = HOST_Random(128);
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_CCEvent, bpm_tick, 0);
+
+      p.ALL = 0;
+      p.type = NoteOn;
+      p.event = NoteOn;
+      p.chn = track;
+      p.note = 36 + HOST_Random(48);
+      p.velocity = 100;
+      p.cable = track; // tag
+      SEQ_MIDI_OUT_Send(OUT_PORT, p, SEQ_MIDI_OUT_OnOffEvent, bpm_tick - HOST_Random(2), 1 + HOST_Random(STRESS_STEP_TICKS));
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs a scenario and prints the results
+/////////////////////////////////////////////////////////////////////////////
+static void HOST_RunScenario(const scenario_t *scenario)
+{
+  u32 ticks = 0;
+  u64 elapsed = 0;
+  u64 max_tick_time = 0;
+  int round;
+
+  host_events = 0;
+  host_checksum = 2166136261U;
+  seq_midi_out_max_allocated = 0;
+  seq_midi_out_dropouts = 0;
+
+  for(round=0; round<NUM_ROUNDS; ++round) {
+    SEQ_MIDI_OUT_FlushQueue();
+    scenario->reset();
+
+    // step through song until last position reached
+    // wait additional BPM ticks to ensure that all events have been played
+    host_bpm_tick = 0;
+    u8 song_running = 1;
+    while( song_running || seq_midi_out_allocated ) {
+      u64 t0 = HOST_TimeGet();
+
+      if( song_running )
+	song_running = scenario->tick(host_bpm_tick);
+      SEQ_MIDI_OUT_Handler();
+
+      if( scenario->tick_late != NULL ) {
+	if( song_running )
+	  scenario->tick_late(host_bpm_tick);
+	SEQ_MIDI_OUT_Handler();
+      }
+
+      u64 tick_time = HOST_TimeGet() - t0;
+      elapsed += tick_time;
+      if( tick_time > max_tick_time )
+	max_tick_time = tick_time;
+
+      ++host_bpm_tick;
+      ++ticks;
+    }
+  }
+
+  u64 events_per_sec = elapsed ? ((u64)host_events * 1000000000ULL / elapsed) : 0;
+
+  printf("scenario=%s scheduler=%d max_events=%d ticks=%u events=%u elapsed_us=%llu events_per_sec=%llu max_tick_us=%llu.%03llu max_allocated=%u dropouts=%u checksum=%08x\n",
+	 scenario->name,
+	 SEQ_MIDI_OUT_SCHEDULER,
+	 SEQ_MIDI_OUT_MAX_EVENTS,
+	 (unsigned)ticks,
+	 (unsigned)host_events,
+	 (unsigned long long)(elapsed / 1000),
+	 (unsigned long long)events_per_sec,
+	 (unsigned long long)(max_tick_time / 1000),
+	 (unsigned long long)(max_tick_time % 1000),
+	 (unsigned)seq_midi_out_max_allocated,
+	 (unsigned)seq_midi_out_dropouts,
+	 (unsigned)host_checksum);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main function
+// optional argument: name of the scenario which should be executed
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  MIOS32_MIDI_Init(0);
+  MIOS32_MIDI_DirectTxCallback_Init(HOST_MIDI_TxCallback);
+
+  SEQ_BPM_Init(0);
+  SEQ_BPM_PPQN_Set(STRESS_PPQN);
+
+  SEQ_MIDI_OUT_Init(0);
+  SEQ_MIDI_OUT_Callback_BPM_IsRunning_Set(HOST_BpmIsRunning);
+  SEQ_MIDI_OUT_Callback_BPM_TickGet_Set(HOST_BpmTickGet);
+  SEQ_MIDI_OUT_Callback_BPM_Set_Set(HOST_BpmSet);
+
+  int i;
+  for(i=0; i<NUM_SCENARIOS; ++i) {
+    if( argc < 2 || strcmp(argv[1], scenarios[i].name) == 0 )
+      HOST_RunScenario(&scenarios[i]);
+  }
+
+  SEQ_MIDI_OUT_FreeHeap();
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build
+ *
+ * this file allows to disable (or re-configure) default functions of MIOS32
+ * available switches are listed in $MIOS32_PATH/modules/mios32/MIOS32_CONFIG.txt
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// The boot message which is print during startup and returned on a SysEx query
+#define MIOS32_LCD_BOOT_MSG_LINE1 "MIDI Scheduler Benchmark"
+#define MIOS32_LCD_BOOT_MSG_LINE2 "(c) 2009 T.Klose"
+
+#define MIOS32_FAMILY_STR "EMULATION"
+#define MIOS32_BOARD_STR  "host"
+#define MIOS32_IIC_NUM 1
+
+// no hardware interfaces available: all MIDI packages are captured
+// by the direct Tx callback of MIOS32_MIDI
+#define MIOS32_DONT_USE_USB
+#define MIOS32_DONT_USE_UART
+#define MIOS32_DONT_USE_IIC
+#define MIOS32_DONT_USE_SPI
+#define MIOS32_DONT_USE_USB_MIDI
+#define MIOS32_DONT_USE_UART_MIDI
+#define MIOS32_DONT_USE_IIC_MIDI
+#define MIOS32_DONT_USE_SPI_MIDI
+
+// use printf instead of MIOS32_MIDI_SendDebugMessage to print debug messages
+#define DEBUG_MSG printf
+
+
+// memory alloccation method:
+// 0: internal static allocation with one byte for each flag
+// 1: internal static allocation with 8bit flags
+// 2: internal static allocation with 16bit flags
+// 3: internal static allocation with 32bit flags
+// 4: FreeRTOS based pvPortMalloc
+// 5: malloc provided by library
+#ifndef SEQ_MIDI_OUT_MALLOC_METHOD
+#define SEQ_MIDI_OUT_MALLOC_METHOD 3
+#endif
+
+// max number of scheduled events which will allocate memory
+// MAX_EVENTS must be a power of two! (e.g. 64, 128, 256, 512, ...)
+#ifndef SEQ_MIDI_OUT_MAX_EVENTS
+#define SEQ_MIDI_OUT_MAX_EVENTS 512
+#endif
+
+// enable seq_midi_out_max_allocated and seq_midi_out_dropouts
+#define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
+
+// scheduler method:
+// 0: sorted linked list (insert and re-schedule have to search through the whole queue)
+// 1: hierarchical timing wheel (insert, re-schedule and dispatch in constant time)
+#ifndef SEQ_MIDI_OUT_SCHEDULER
+#define SEQ_MIDI_OUT_SCHEDULER 0
+#endif
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1 @@
+// Dummy Header file - FreeRTOS not used by the host build
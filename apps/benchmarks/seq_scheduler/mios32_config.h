@@ -32,5 +32,10 @@
 // enable seq_midi_out_max_allocated and seq_midi_out_dropouts
 #define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
 
+// scheduler method:
+// 0: sorted linked list (insert and re-schedule have to search through the whole queue)
+// 1: hierarchical timing wheel (insert, re-schedule and dispatch in constant time)
+#define SEQ_MIDI_OUT_SCHEDULER 0
+
 
 #endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,936 @@
+// $Id$
+/*
+ * Host test of the .NGR script runner
+ *
+ * mbng_file_r.c runs the scripts twice against a mock event pool: once
+ * interpreted (line by line from file), once tokenized. All side effects
+ * (item values, MIDI output, LCD and log messages, meta events) are
+ * recorded together with the 1 mS tick in which they happened, and both
+ * traces have to be identical.
+ *
+ * The mock pool is created from the EVENT_* lines of the .NGC file with
+ * the same name. Between the script calls the pool is modified like on
+ * the hardware: item values change without notification, banks are
+ * switched (new pool generation), and items move to other pool addresses
+ * (new pool layout generation), so that the cached id references of the
+ * tokenized mode are checked.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <mios32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include <midi_port.h>
+#include <seq_bpm.h>
+#include <seq_midi_out.h>
+
+#include "tasks.h"
+#include "file.h"
+#include "mbng_file_r.h"
+#include "mbng_patch.h"
+#include "mbng_event.h"
+#include "mbng_lcd.h"
+
+
+// number of script calls per file, and max. number of 1 mS ticks per call
+#define NUM_CALLS       60
+#define MAX_CALL_TICKS  10000
+
+// scripts of ../cfg/tests which are checked if no file is given
+static const char *default_scripts[] = {
+  "../cfg/tests/runscr1",
+  "../cfg/tests/runscr2",
+  "../cfg/tests/runscr3",
+  "../cfg/tests/runscr4",
+  "../cfg/tests/runscr5",
+  "../cfg/tests/runscr6",
+  "../cfg/tests/multibnk",
+  "../cfg/tests/kb_6",
+  "../cfg/tests/rgbled_2",
+  "../cfg/tests/seq1",
+  "../cfg/tests/seq2",
+  "../cfg/tests/seq3",
+  "cache",
+  NULL
+};
+
+static int verbose;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Trace
+/////////////////////////////////////////////////////////////////////////////
+
+static char *trace;
+static u32 trace_len;
+static u32 trace_size;
+static u32 tick;
+
+static void trace_printf(const char *format, ...)
+{
+  char line[512];
+  int len = snprintf(line, sizeof(line), "%5u ", tick);
+
+  va_list args;
+  va_start(args, format);
+  len += vsnprintf(line + len, sizeof(line) - len, format, args);
+  va_end(args);
+  if( len >= (int)sizeof(line) - 1 )
+    len = sizeof(line) - 2;
+  line[len++] = '\n';
+
+  if( trace_len + len + 1 > trace_size ) {
+    trace_size = 2*trace_size + len + 1;
+    trace = realloc(trace, trace_size);
+  }
+  memcpy(trace + trace_len, line, len);
+  trace_len += len;
+  trace[trace_len] = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Mock event pool
+/////////////////////////////////////////////////////////////////////////////
+
+#define POOL_MAX_ITEMS 1024
+
+typedef struct {
+  mbng_event_item_id_t id;
+  u16 hw_id;
+  u16 value;
+  u8 bank;
+  u8 active;
+  s16 min;
+  s16 max;
+  u32 rgb;
+  u32 hsv;
+  u8 lock;
+  u8 no_dump;
+  u8 kb_transpose;
+  u8 kb_velocity_map;
+} pool_item_t;
+
+static pool_item_t pool[POOL_MAX_ITEMS];
+static u32 pool_num_items;
+static u32 pool_rotation; // pool index of an item is (item_ix + pool_rotation) % pool_num_items
+static u16 pool_generation;        // changes with the active state and the layout, like MBNG_EVENT
+static u16 pool_layout_generation; // changes if items move to other pool addresses
+static u8 selected_bank;
+static u8 num_banks;
+
+// each item occupies 0x20 bytes in the simulated pool
+static u16 pool_address(u32 item_ix)
+{
+  return (u16)(((item_ix + pool_rotation) % pool_num_items) * 0x20);
+}
+
+static pool_item_t *pool_item_at(u16 address)
+{
+  if( address & 0x1f )
+    return NULL;
+
+  u32 ix = address / 0x20;
+  if( ix >= pool_num_items )
+    return NULL;
+
+  return &pool[(ix + pool_num_items - pool_rotation % pool_num_items) % pool_num_items];
+}
+
+static void pool_update_active(void)
+{
+  u32 i;
+  for(i=0; i<pool_num_items; ++i) {
+    u8 active = !pool[i].bank || pool[i].bank == selected_bank;
+    if( pool[i].active != active ) {
+      pool[i].active = active;
+      ++pool_generation;
+    }
+  }
+}
+
+static s32 pool_load(const char *ngc_path)
+{
+  FILE *f = fopen(ngc_path, "r");
+  if( !f ) {
+    fprintf(stderr, "ERROR: %s not found!\n", ngc_path);
+    return -1;
+  }
+
+  pool_num_items = 0;
+  pool_rotation = 0;
+  num_banks = 1;
+
+  char line[1024];
+  while( fgets(line, sizeof(line), f) ) {
+    char *p = line;
+    while( *p == ' ' || *p == '\t' )
+      ++p;
+
+    if( strncasecmp(p, "EVENT_", 6) != 0 )
+      continue;
+
+    char controller[32];
+    int n = 0;
+    p += 6;
+    while( *p && !isspace((int)*p) && n < (int)sizeof(controller)-1 )
+      controller[n++] = *p++;
+    controller[n] = 0;
+
+    mbng_event_item_id_t ctrl = MBNG_EVENT_ItemIdFromControllerStrGet(controller);
+    if( ctrl == MBNG_EVENT_CONTROLLER_DISABLED || pool_num_items >= POOL_MAX_ITEMS )
+      continue;
+
+    // remove spaces around '=' (e.g. "id=  1  hw_id =  1")
+    char *src, *dst;
+    for(src=dst=p; *src; ++src) {
+      if( *src == ' ' || *src == '\t' ) {
+	char *next = src;
+	while( *next == ' ' || *next == '\t' )
+	  ++next;
+	if( *next == '=' || (dst > p && dst[-1] == '=') )
+	  continue;
+      }
+      *dst++ = *src;
+    }
+    *dst = 0;
+
+    int id = 0, hw_id = -1, bank = 0, value = 0;
+    char *tok;
+    for(tok=strtok(p, " \t\r\n"); tok; tok=strtok(NULL, " \t\r\n")) {
+      if( strncasecmp(tok, "id=", 3) == 0 )         id = atoi(tok+3);
+      else if( strncasecmp(tok, "hw_id=", 6) == 0 ) hw_id = atoi(tok+6);
+      else if( strncasecmp(tok, "bank=", 5) == 0 )  bank = atoi(tok+5);
+      else if( strncasecmp(tok, "value=", 6) == 0 ) value = atoi(tok+6);
+    }
+
+    if( id < 1 || id > 0xfff )
+      continue;
+
+    pool_item_t *item = &pool[pool_num_items++];
+    memset(item, 0, sizeof(pool_item_t));
+    item->id = ctrl | id;
+    item->hw_id = ctrl | ((hw_id >= 1) ? hw_id : id);
+    item->bank = bank;
+    item->value = value;
+    item->max = 127;
+    if( bank > num_banks )
+      num_banks = bank;
+  }
+
+  fclose(f);
+
+  selected_bank = 1;
+  ++pool_generation;
+  ++pool_layout_generation;
+  pool_update_active();
+
+  return pool_num_items;
+}
+
+static void pool_copy2user(u32 item_ix, mbng_event_item_t *item)
+{
+  pool_item_t *p = &pool[item_ix];
+
+  MBNG_EVENT_ItemInit(item, p->id);
+  item->hw_id = p->hw_id;
+  item->pool_address = pool_address(item_ix);
+  item->value = p->value;
+  item->bank = p->bank;
+  item->flags.active = p->active;
+  item->min = p->min;
+  item->max = p->max;
+  item->rgb.ALL = p->rgb;
+  item->hsv.ALL = p->hsv;
+}
+
+static pool_item_t *pool_item_from_user(mbng_event_item_t *item)
+{
+  pool_item_t *p = pool_item_at(item->pool_address);
+  return (p && p->id == item->id) ? p : NULL;
+}
+
+// searches in the order of the simulated pool addresses
+static s32 pool_search(u8 by_hw_id, mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+{
+  u32 pos;
+  for(pos=*continue_ix; pos<pool_num_items; ++pos) {
+    u32 i = (pos + pool_num_items - pool_rotation % pool_num_items) % pool_num_items;
+    pool_item_t *p = &pool[i];
+    u16 p_id = by_hw_id ? p->hw_id : p->id;
+
+    if( by_hw_id && !p->active )
+      continue;
+
+    if( (!id_end_range && p_id == id) ||
+	(id_end_range && p_id >= id && p_id <= id_end_range) ) {
+      pool_copy2user(i, item);
+      *continue_ix = (pos + 1 < pool_num_items) ? (pos + 1) : 0;
+      return 0; // item found
+    }
+  }
+
+  return -1; // not found
+}
+
+u16 MBNG_EVENT_PoolGenerationGet(void)
+{
+  return pool_generation;
+}
+
+u16 MBNG_EVENT_PoolLayoutGenerationGet(void)
+{
+  return pool_layout_generation;
+}
+
+s32 MBNG_EVENT_PoolItemValueGet(u16 address)
+{
+  pool_item_t *p = pool_item_at(address);
+  return p ? p->value : -1;
+}
+
+s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+{
+  return pool_search(0, id, id_end_range, item, continue_ix);
+}
+
+s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+{
+  return pool_search(1, hw_id, hw_id_end_range, item, continue_ix);
+}
+
+s32 MBNG_EVENT_ItemInit(mbng_event_item_t *item, mbng_event_item_id_t id)
+{
+  memset(item, 0, sizeof(mbng_event_item_t));
+  item->id = id;
+  item->hw_id = id;
+  item->pool_address = 0xffff; // invalid address
+  item->max = 127;
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8 fwd_enabled)
+{
+  pool_item_t *p = pool_item_from_user(item);
+  item->value = value;
+  if( p )
+    p->value = value;
+  trace_printf("receive %s:%d %d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff, (s16)value);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_NotifySendValue(mbng_event_item_t *item)
+{
+  trace_printf("notify %s:%d %d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff, (s16)item->value);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemSendVirtual(mbng_event_item_t *item, mbng_event_item_id_t send_id)
+{
+  trace_printf("virtual %s:%d %d rgb=%04x hsv=%08x", MBNG_EVENT_ItemControllerStrGet(send_id), send_id & 0xfff, (s16)item->value, item->rgb.ALL, item->hsv.ALL);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
+{
+  pool_item_t *p = pool_item_from_user(item);
+  if( !p )
+    return -1; // item not found
+
+  p->min = item->min;
+  p->max = item->max;
+  p->rgb = item->rgb.ALL;
+  p->hsv = item->hsv.ALL;
+  p->kb_transpose = item->custom_flags.KB.kb_transpose;
+  p->kb_velocity_map = item->custom_flags.KB.kb_velocity_map;
+  // modified in place: no new pool generation
+
+  trace_printf("modify %s:%d min=%d max=%d rgb=%04x hsv=%08x kb=%d:%d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff,
+	       p->min, p->max, p->rgb, p->hsv, p->kb_transpose, p->kb_velocity_map);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemSetLock(mbng_event_item_t *item, u8 lock)
+{
+  pool_item_t *p = pool_item_from_user(item);
+  if( p )
+    p->lock = lock;
+  trace_printf("lock %s:%d %d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff, lock);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemSetActive(mbng_event_item_t *item, u8 active)
+{
+  pool_item_t *p = pool_item_from_user(item);
+  if( p && p->active != active ) {
+    p->active = active;
+    ++pool_generation;
+  }
+  trace_printf("active %s:%d %d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff, active);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_ItemSetNoDump(mbng_event_item_t *item, u8 no_dump)
+{
+  pool_item_t *p = pool_item_from_user(item);
+  if( p )
+    p->no_dump = no_dump;
+  trace_printf("no_dump %s:%d %d", MBNG_EVENT_ItemControllerStrGet(item->id), item->id & 0xfff, no_dump);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_SelectedBankGet(void)
+{
+  return selected_bank;
+}
+
+s32 MBNG_EVENT_SelectedBankSet(u8 new_bank)
+{
+  if( new_bank < 1 || new_bank > num_banks )
+    return -1; // invalid bank
+
+  selected_bank = new_bank;
+  pool_update_active();
+  trace_printf("bank %d", new_bank);
+  return 0; // no error
+}
+
+const char *MBNG_EVENT_ItemControllerStrGet(mbng_event_item_id_t id)
+{
+  switch( id & 0xf000 ) {
+  case MBNG_EVENT_CONTROLLER_SENDER:        return "SENDER";
+  case MBNG_EVENT_CONTROLLER_RECEIVER:      return "RECEIVER";
+  case MBNG_EVENT_CONTROLLER_BUTTON:        return "BUTTON";
+  case MBNG_EVENT_CONTROLLER_LED:           return "LED";
+  case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: return "BUTTON_MATRIX";
+  case MBNG_EVENT_CONTROLLER_LED_MATRIX:    return "LED_MATRIX";
+  case MBNG_EVENT_CONTROLLER_ENC:           return "ENC";
+  case MBNG_EVENT_CONTROLLER_AIN:           return "AIN";
+  case MBNG_EVENT_CONTROLLER_AINSER:        return "AINSER";
+  case MBNG_EVENT_CONTROLLER_MF:            return "MF";
+  case MBNG_EVENT_CONTROLLER_CV:            return "CV";
+  case MBNG_EVENT_CONTROLLER_KB:            return "KB";
+  case MBNG_EVENT_CONTROLLER_RGBLED:        return "RGBLED";
+  }
+  return "DISABLED";
+}
+
+mbng_event_item_id_t MBNG_EVENT_ItemIdFromControllerStrGet(char *event)
+{
+  mbng_event_item_id_t id;
+  for(id=MBNG_EVENT_CONTROLLER_SENDER; id<=MBNG_EVENT_CONTROLLER_RGBLED; id+=0x1000) {
+    if( strcasecmp(event, MBNG_EVENT_ItemControllerStrGet(id)) == 0 )
+      return id;
+  }
+  return MBNG_EVENT_CONTROLLER_DISABLED;
+}
+
+mbng_event_type_t MBNG_EVENT_ItemTypeFromStrGet(char *event_type)
+{
+  if( strcasecmp(event_type, "NoteOff") == 0 )       return MBNG_EVENT_TYPE_NOTE_OFF;
+  if( strcasecmp(event_type, "NoteOnOff") == 0 )     return MBNG_EVENT_TYPE_NOTE_ON_OFF;
+  if( strcasecmp(event_type, "NoteOn") == 0 || strcasecmp(event_type, "Note") == 0 ) return MBNG_EVENT_TYPE_NOTE_ON;
+  if( strcasecmp(event_type, "PolyPressure") == 0 )  return MBNG_EVENT_TYPE_POLY_PRESSURE;
+  if( strcasecmp(event_type, "CC") == 0 )            return MBNG_EVENT_TYPE_CC;
+  if( strcasecmp(event_type, "ProgramChange") == 0 ) return MBNG_EVENT_TYPE_PROGRAM_CHANGE;
+  if( strcasecmp(event_type, "Aftertouch") == 0 )    return MBNG_EVENT_TYPE_AFTERTOUCH;
+  if( strcasecmp(event_type, "Pitchbend") == 0 )     return MBNG_EVENT_TYPE_PITCHBEND;
+  if( strcasecmp(event_type, "SysEx") == 0 )         return MBNG_EVENT_TYPE_SYSEX;
+  if( strcasecmp(event_type, "NRPN") == 0 )          return MBNG_EVENT_TYPE_NRPN;
+  if( strcasecmp(event_type, "Meta") == 0 )          return MBNG_EVENT_TYPE_META;
+  return MBNG_EVENT_TYPE_UNDEFINED;
+}
+
+mbng_event_sysex_var_t MBNG_EVENT_ItemSysExVarFromStrGet(char *sysex_var)
+{
+  if( strcasecmp(sysex_var, "dev") == 0 )   return MBNG_EVENT_SYSEX_VAR_DEV;
+  if( strcasecmp(sysex_var, "pat") == 0 )   return MBNG_EVENT_SYSEX_VAR_PAT;
+  if( strcasecmp(sysex_var, "bnk") == 0 )   return MBNG_EVENT_SYSEX_VAR_BNK;
+  if( strcasecmp(sysex_var, "ins") == 0 )   return MBNG_EVENT_SYSEX_VAR_INS;
+  if( strcasecmp(sysex_var, "chn") == 0 )   return MBNG_EVENT_SYSEX_VAR_CHN;
+  if( strcasecmp(sysex_var, "value") == 0 || strcasecmp(sysex_var, "val") == 0 ) return MBNG_EVENT_SYSEX_VAR_VAL;
+  return MBNG_EVENT_SYSEX_VAR_UNDEFINED;
+}
+
+// the meta types used by the test scripts
+static const struct {
+  const char *name;
+  mbng_event_meta_type_t type;
+  u8 num_bytes;
+} meta_types[] = {
+  { "SetBank",        MBNG_EVENT_META_TYPE_SET_BANK,         0 },
+  { "DecBank",        MBNG_EVENT_META_TYPE_DEC_BANK,         0 },
+  { "IncBank",        MBNG_EVENT_META_TYPE_INC_BANK,         0 },
+  { "CycleBank",      MBNG_EVENT_META_TYPE_CYCLE_BANK,       0 },
+  { "RunSection",     MBNG_EVENT_META_TYPE_RUN_SECTION,      1 },
+  { "RunStop",        MBNG_EVENT_META_TYPE_RUN_STOP,         0 },
+  { "MClkSetTempo",   MBNG_EVENT_META_TYPE_MCLK_SET_TEMPO,   0 },
+  { "MClkSetDivider", MBNG_EVENT_META_TYPE_MCLK_SET_DIVIDER, 0 },
+  { NULL }
+};
+
+const char *MBNG_EVENT_ItemMetaTypeStrGet(mbng_event_meta_type_t meta_type)
+{
+  int i;
+  for(i=0; meta_types[i].name; ++i)
+    if( meta_types[i].type == meta_type )
+      return meta_types[i].name;
+  return "Undefined";
+}
+
+mbng_event_meta_type_t MBNG_EVENT_ItemMetaTypeFromStrGet(char *meta_type)
+{
+  int i;
+  for(i=0; meta_types[i].name; ++i)
+    if( strcasecmp(meta_type, meta_types[i].name) == 0 )
+      return meta_types[i].type;
+  return MBNG_EVENT_META_TYPE_UNDEFINED;
+}
+
+u8 MBNG_EVENT_ItemMetaNumBytesGet(mbng_event_meta_type_t meta_type)
+{
+  int i;
+  for(i=0; meta_types[i].name; ++i)
+    if( meta_types[i].type == meta_type )
+      return meta_types[i].num_bytes;
+  return 0;
+}
+
+s32 MBNG_EVENT_ExecMeta(mbng_event_item_t *item)
+{
+  mbng_event_meta_type_t meta_type = item->stream_size ? item->stream[0] : MBNG_EVENT_META_TYPE_UNDEFINED;
+  trace_printf("meta %s %d %d", MBNG_EVENT_ItemMetaTypeStrGet(meta_type),
+	       (item->stream_size >= 2) ? item->stream[1] : -1, (s16)item->value);
+
+  switch( meta_type ) {
+  case MBNG_EVENT_META_TYPE_SET_BANK: MBNG_EVENT_SelectedBankSet(item->value); break;
+  case MBNG_EVENT_META_TYPE_DEC_BANK: MBNG_EVENT_SelectedBankSet(selected_bank - 1); break;
+  case MBNG_EVENT_META_TYPE_INC_BANK: MBNG_EVENT_SelectedBankSet(selected_bank + 1); break;
+  case MBNG_EVENT_META_TYPE_CYCLE_BANK: MBNG_EVENT_SelectedBankSet((selected_bank >= num_banks) ? 1 : (selected_bank + 1)); break;
+  default: break;
+  }
+
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_SendOptimizedNRPN(mios32_midi_port_t port, mios32_midi_chn_t chn, u16 nrpn_address, u16 nrpn_value, u8 msb_only)
+{
+  trace_printf("nrpn %02x %d %d %d", port, chn, nrpn_address, nrpn_value);
+  return 0; // no error
+}
+
+s32 MBNG_EVENT_SendSysExStream(mios32_midi_port_t port, mbng_event_item_t *item)
+{
+  char str[256];
+  int len = 0;
+  u32 i;
+  for(i=0; i<item->stream_size && len < (int)sizeof(str)-4; ++i)
+    len += sprintf(str + len, " %02x", item->stream[i]);
+  str[len] = 0;
+  trace_printf("sysex %02x%s value=%d", port, str, (s16)item->value);
+  return 0; // no error
+}
+
+s32 MBNG_LCD_PrintItemLabel(mbng_event_item_t *item, char *out_buffer, u32 max_buffer_len)
+{
+  trace_printf("lcd \"%s\" %d", item->label ? item->label : "", (s16)item->value);
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIDI
+/////////////////////////////////////////////////////////////////////////////
+
+static const struct {
+  char *name;
+  mios32_midi_port_t port;
+} midi_ports[] = {
+  { "USB1", USB0 }, { "USB2", USB1 }, { "OUT1", UART0 }, { "OUT2", UART1 },
+};
+
+s32 MIDI_PORT_OutNumGet(void)
+{
+  return sizeof(midi_ports)/sizeof(midi_ports[0]);
+}
+
+char *MIDI_PORT_OutNameGet(u8 port_ix)
+{
+  return midi_ports[port_ix].name;
+}
+
+mios32_midi_port_t MIDI_PORT_OutPortGet(u8 port_ix)
+{
+  return midi_ports[port_ix].port;
+}
+
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  trace_printf("midi %02x %02x %02x %02x", port, package.evnt0, package.evnt1, package.evnt2);
+  return 0; // no error
+}
+
+static s32 send_event(mios32_midi_port_t port, u8 evnt0, u8 evnt1, u8 evnt2)
+{
+  mios32_midi_package_t package;
+  package.ALL = 0;
+  package.type = evnt0 >> 4;
+  package.evnt0 = evnt0;
+  package.evnt1 = evnt1;
+  package.evnt2 = evnt2;
+  return MIOS32_MIDI_SendPackage(port, package);
+}
+
+s32 MIOS32_MIDI_SendNoteOff(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)      { return send_event(port, 0x80 | chn, note, vel); }
+s32 MIOS32_MIDI_SendNoteOn(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel)       { return send_event(port, 0x90 | chn, note, vel); }
+s32 MIOS32_MIDI_SendPolyPressure(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 val) { return send_event(port, 0xa0 | chn, note, val); }
+s32 MIOS32_MIDI_SendCC(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 cc_number, u8 val)      { return send_event(port, 0xb0 | chn, cc_number, val); }
+s32 MIOS32_MIDI_SendProgramChange(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 prg)         { return send_event(port, 0xc0 | chn, prg, 0); }
+s32 MIOS32_MIDI_SendAftertouch(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 val)            { return send_event(port, 0xd0 | chn, val, 0); }
+s32 MIOS32_MIDI_SendPitchBend(mios32_midi_port_t port, mios32_midi_chn_t chn, u16 val)            { return send_event(port, 0xe0 | chn, val & 0x7f, val >> 7); }
+
+s32 MIOS32_MIDI_SendDebugString(const char *str)
+{
+  // used for the LOG command
+  trace_printf("log \"%s\"", str);
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  // error messages are mode specific (line number vs. token position), they are not traced
+  if( verbose ) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+  }
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len)
+{
+  return 0; // no error
+}
+
+s32 SEQ_BPM_IsRunning(void)
+{
+  return 0; // SEND_SEQ sends directly
+}
+
+u32 SEQ_BPM_TickGet(void)
+{
+  return 0;
+}
+
+s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len)
+{
+  return 0; // not used while the sequencer is stopped
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Files are read from the host filesystem
+/////////////////////////////////////////////////////////////////////////////
+
+static char script_dir[256];
+static char *file_buffer;
+static u32 file_size;
+static u32 file_pos;
+
+s32 FILE_ReadOpen(file_t* file, char *filepath)
+{
+  char path[512];
+  int len = snprintf(path, sizeof(path), "%s%s", script_dir, filepath);
+  int i;
+  for(i=len-1; i>=0 && path[i] != '/'; --i)
+    path[i] = tolower((int)path[i]); // the scripts are stored with lower case names
+
+  FILE *f = fopen(path, "rb");
+  if( !f )
+    return FILE_ERR_OPEN_READ;
+
+  fseek(f, 0, SEEK_END);
+  file_size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  file_buffer = realloc(file_buffer, file_size + 1);
+  if( fread(file_buffer, 1, file_size, f) != file_size ) {
+    fclose(f);
+    return FILE_ERR_READ;
+  }
+  fclose(f);
+
+  file_pos = 0;
+  file->fptr = 0;
+  file->fsize = file_size;
+  return 0; // no error
+}
+
+s32 FILE_ReadReOpen(file_t* file)
+{
+  file_pos = file->fptr;
+  return 0; // no error
+}
+
+s32 FILE_ReadClose(file_t* file)
+{
+  file->fptr = file_pos;
+  return 0; // no error
+}
+
+s32 FILE_ReadSeek(u32 offset)
+{
+  file_pos = offset;
+  return 0; // no error
+}
+
+// same behaviour like FILE_ReadLine() of modules/file
+s32 FILE_ReadLine(u8 *buffer, u32 max_len)
+{
+  u32 num_read = 0;
+
+  while( file_pos < file_size ) {
+    *buffer = file_buffer[file_pos++];
+    ++num_read;
+
+    if( *buffer == '\n' || *buffer == '\r' )
+      break;
+
+    if( num_read < max_len )
+      ++buffer;
+  }
+
+  *buffer = 0;
+
+  return num_read;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Remaining dependencies
+/////////////////////////////////////////////////////////////////////////////
+
+mbng_patch_cfg_t mbng_patch_cfg;
+
+s32 MBNG_PATCH_Load(char *filename)
+{
+  trace_printf("load %s", filename);
+  return 0; // no error
+}
+
+xSemaphoreHandle xSDCardSemaphore;
+xSemaphoreHandle xMIDIOUTSemaphore;
+xSemaphoreHandle xLCDSemaphore;
+
+signed portBASE_TYPE xQueueTakeMutexRecursive(xQueueHandle xMutex, portTickType xTicksToWait)
+{
+  return pdTRUE;
+}
+
+signed portBASE_TYPE xQueueGiveMutexRecursive(xQueueHandle xMutex)
+{
+  return pdTRUE;
+}
+
+void *pvPortMalloc(size_t xSize)
+{
+  return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+  free(pv);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 random_seed;
+
+static u32 random_value(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return ((random_seed >> 16) & 0x7fff) % range;
+}
+
+// runs all calls of a script and returns the trace
+static s32 run_script(const char *script, u8 tokenized, char **result, u32 *num_lines)
+{
+  char ngc_path[512];
+  sprintf(ngc_path, "%s.ngc", script);
+  if( pool_load(ngc_path) < 0 )
+    return -1;
+
+  // the runner opens "/<NAME>.NGR"
+  char name[MBNG_FILE_R_FILENAME_LEN+1];
+  const char *base = strrchr(script, '/');
+  int dir_len = base ? (base - script) : 0;
+  base = base ? (base + 1) : script;
+  snprintf(script_dir, sizeof(script_dir), "%.*s", dir_len ? dir_len : 1, dir_len ? script : ".");
+  memset(name, 0, sizeof(name));
+  strncpy(name, base, MBNG_FILE_R_FILENAME_LEN);
+
+  trace_len = 0;
+  if( trace )
+    trace[0] = 0;
+  tick = 0;
+  random_seed = 0x4e4752; // same sequence for both modes
+  memset(&mbng_patch_cfg, 0, sizeof(mbng_patch_cfg));
+
+  MBNG_FILE_R_TokenizedNgrSet(tokenized);
+  MBNG_FILE_R_Unload();
+
+  int call;
+  for(call=0; call<NUM_CALLS; ++call) {
+    // values changed from the hardware (without new pool generation)
+    int i;
+    for(i=0; i<4 && pool_num_items; ++i)
+      pool[random_value(pool_num_items)].value = random_value(128);
+
+    // items moved to other pool addresses
+    if( (call % 5) == 4 ) {
+      ++pool_rotation;
+      ++pool_generation;
+      ++pool_layout_generation;
+    }
+
+    // another bank selected
+    if( (call % 7) == 6 && num_banks > 1 )
+      MBNG_EVENT_SelectedBankSet((selected_bank % num_banks) + 1);
+
+    u8 section = (call < 20) ? call : random_value(20);
+    s16 value = random_value(128);
+    trace_printf("call ^section=%d ^value=%d", section, value);
+
+    MBNG_FILE_R_ReadRequest(call ? NULL : name, section, value, 0);
+    int t;
+    for(t=0; t<MAX_CALL_TICKS; ++t) {
+      MBNG_FILE_R_CheckRequest();
+      ++tick;
+    }
+  }
+
+  // final pool content
+  u32 i;
+  for(i=0; i<pool_num_items; ++i) {
+    pool_item_t *p = &pool[i];
+    trace_printf("pool %s:%d value=%d active=%d", MBNG_EVENT_ItemControllerStrGet(p->id), p->id & 0xfff, (s16)p->value, p->active);
+  }
+
+  *result = strdup(trace ? trace : "");
+  *num_lines = 0;
+  char *c;
+  for(c=*result; *c; ++c)
+    if( *c == '\n' )
+      ++*num_lines;
+
+  return 0; // no error
+}
+
+// compares two traces line by line
+// the interpreted mode executes a request in the next 1 mS tick, the tokenized mode immediately.
+// Therefore a DELAY_MS in the first run of a script ends one tick later in the interpreted mode.
+// \returns the first different line of a, and in *b_line the line of b, or NULL if the traces match
+static const char *trace_compare(const char *a, const char *b, const char **b_line)
+{
+  while( *a || *b ) {
+    char *a_text, *b_text;
+    unsigned long a_tick = strtoul(a, &a_text, 10);
+    unsigned long b_tick = strtoul(b, &b_text, 10);
+    size_t a_len = strcspn(a_text, "\n");
+    size_t b_len = strcspn(b_text, "\n");
+
+    if( a_len != b_len || memcmp(a_text, b_text, a_len) != 0 || a_tick < b_tick || a_tick > b_tick + 1 ) {
+      *b_line = b;
+      return a;
+    }
+
+    a = a_text + a_len + (a_text[a_len] ? 1 : 0);
+    b = b_text + b_len + (b_text[b_len] ? 1 : 0);
+  }
+
+  return NULL; // traces match
+}
+
+static void trace_dump(const char *script, const char *mode, const char *content)
+{
+  char path[512];
+  const char *base = strrchr(script, '/');
+  sprintf(path, "%s_%s.trace", base ? (base + 1) : script, mode);
+
+  FILE *f = fopen(path, "w");
+  if( f ) {
+    fputs(content, f);
+    fclose(f);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char **scripts = default_scripts;
+  int num_errors = 0;
+  int dump = 0;
+
+  while( argc > 1 && argv[1][0] == '-' ) {
+    if( strcmp(argv[1], "-v") == 0 )
+      verbose = 1; // print the error messages of the scripts
+    else if( strcmp(argv[1], "-d") == 0 )
+      dump = 1; // write the traces into *.trace files
+    --argc;
+    ++argv;
+  }
+  if( argc > 1 )
+    scripts = (const char **)&argv[1];
+
+  int i;
+  for(i=0; scripts[i]; ++i) {
+    char *interpreted, *tokenized;
+    u32 interpreted_lines, tokenized_lines;
+
+    if( run_script(scripts[i], 0, &interpreted, &interpreted_lines) < 0 ||
+	run_script(scripts[i], 1, &tokenized, &tokenized_lines) < 0 ) {
+      ++num_errors;
+      continue;
+    }
+
+    if( dump ) {
+      trace_dump(scripts[i], "interpreted", interpreted);
+      trace_dump(scripts[i], "tokenized", tokenized);
+    }
+
+    const char *a, *b;
+    if( (a=trace_compare(interpreted, tokenized, &b)) == NULL ) {
+      printf("%-24s %6u events, interpreted == tokenized\n", scripts[i], interpreted_lines);
+    } else {
+      printf("%-24s FAILED\n  interpreted: %.*s\n  tokenized:   %.*s\n", scripts[i],
+	     (int)strcspn(a, "\n"), a, (int)strcspn(b, "\n"), b);
+      ++num_errors;
+    }
+
+    free(interpreted);
+    free(tokenized);
+  }
+
+  if( num_errors ) {
+    printf("%d script(s) FAILED\n", num_errors);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
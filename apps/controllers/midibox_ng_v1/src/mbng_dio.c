@@ -92,7 +92,7 @@ s32 MBNG_DIO_PortInit(u8 port, u8 output_mask)
 #if MBNG_PATCH_NUM_DIO > 2
   case 2: {
     int i;
-#if defined(MIOS32_FAMILY_STM32F4xx)
+#if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_POSIX)
     for(i=0; i<8; ++i) {
       MIOS32_BOARD_J10_PinInit(i+8, (output_mask & (1 << i)) ? MIOS32_BOARD_PIN_MODE_OUTPUT_PP : MIOS32_BOARD_PIN_MODE_INPUT_PU);
     }
@@ -132,7 +132,7 @@ u8 MBNG_DIO_PortGet(u8 port)
 
 #if MBNG_PATCH_NUM_DIO > 1
   case 1: {
-#if defined(MIOS32_FAMILY_STM32F4xx)
+#if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_POSIX)
     return MIOS32_BOARD_J10A_Get();
 #elif defined(MIOS32_FAMILY_LPC17xx)
     return MIOS32_BOARD_J10_Get();
@@ -144,7 +144,7 @@ u8 MBNG_DIO_PortGet(u8 port)
 
 #if MBNG_PATCH_NUM_DIO > 2
   case 2: {
-#if defined(MIOS32_FAMILY_STM32F4xx)
+#if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_POSIX)
     return MIOS32_BOARD_J10B_Get();
 #elif defined(MIOS32_FAMILY_LPC17xx)
     return MIOS32_BOARD_J28_Get();
@@ -179,7 +179,7 @@ s32 MBNG_DIO_PortSet(u8 port, u8 value)
 
 #if MBNG_PATCH_NUM_DIO > 1
   case 1: {
-#if defined(MIOS32_FAMILY_STM32F4xx)
+#if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_POSIX)
     MIOS32_BOARD_J10A_Set(value);
 #elif defined(MIOS32_FAMILY_LPC17xx)
     MIOS32_BOARD_J10_Set(value);
@@ -191,7 +191,7 @@ s32 MBNG_DIO_PortSet(u8 port, u8 value)
 
 #if MBNG_PATCH_NUM_DIO > 2
   case 2: {
-#if defined(MIOS32_FAMILY_STM32F4xx)
+#if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_POSIX)
     MIOS32_BOARD_J10B_Set(value);
 #elif defined(MIOS32_FAMILY_LPC17xx)
     MIOS32_BOARD_J28_Set(value);
@@ -129,6 +129,47 @@ static u16 event_pool_maps_begin;
 static u16 event_pool_num_items;
 static u16 event_pool_num_maps;
 
+// hash index for the MIDI receive path (see MBNG_EVENT_MIDI_NotifyPackage)
+// each receiving item is linked into a bucket which is selected by the first byte
+// of the stream and the key/CC number (resp. NRPN address). Items which can receive
+// any key/CC number (and PC, Aftertouch, PitchBend, ...) are linked into the
+// bucket of MBNG_EVENT_RECEIVE_KEY_ANY.
+// Without valid index (too many items, or items have been added) the pool will be searched linearly.
+// The indices are located in the default RAM section: on LPC17 the AHB RAM is already
+// occupied by the event pool and mbng_file_l, therefore only 256 items are indexed (2k)
+#if defined(MIOS32_FAMILY_STM32F4xx)
+# define MBNG_EVENT_INDEX_MAX_ITEMS 2048
+#elif defined(MIOS32_FAMILY_LPC17xx)
+# define MBNG_EVENT_INDEX_MAX_ITEMS 256
+#else
+# define MBNG_EVENT_INDEX_MAX_ITEMS 512
+#endif
+#define MBNG_EVENT_RECEIVE_INDEX_BUCKETS 256
+#define MBNG_EVENT_RECEIVE_INDEX_END     0xffff
+#define MBNG_EVENT_RECEIVE_KEY_ANY       0x0080
+#define MBNG_EVENT_RECEIVE_KEY_NRPN      0x8000
+static u16 receive_index_bucket[MBNG_EVENT_RECEIVE_INDEX_BUCKETS]; // first entry of a bucket
+static u16 receive_index_offset[MBNG_EVENT_INDEX_MAX_ITEMS]; // pool offset of the item
+static u16 receive_index_next[MBNG_EVENT_INDEX_MAX_ITEMS]; // next entry in the same bucket
+static u8 receive_index_valid;
+
+// sorted indices for MBNG_EVENT_ItemSearchById and MBNG_EVENT_ItemSearchByHwId
+// contain the pool offsets of all items, sorted by id (resp. hw_id) and pool position
+// continue_ix: index position + 1, flagged to distinguish it from a position of the linear search
+#define MBNG_EVENT_SEARCH_INDEX_CONTINUE 0x80000000
+static u16 search_index_id[MBNG_EVENT_INDEX_MAX_ITEMS];
+static u16 search_index_hw_id[MBNG_EVENT_INDEX_MAX_ITEMS];
+static u8 search_index_valid;
+
+// incremented whenever pool addresses, hw_ids or the active state of items have been changed,
+// but not if only values or other parameters are modified in place
+// allows to cache the results of MBNG_EVENT_ItemSearchByHwId (see MBNG_FILE_R)
+static u16 pool_generation;
+
+// incremented whenever pool addresses have been changed (items added or resized)
+// allows to cache the results of MBNG_EVENT_ItemSearchById (see MBNG_FILE_R)
+static u16 pool_layout_generation;
+
 // last active event
 mbng_event_item_id_t last_event_item_id;
 
@@ -184,6 +225,16 @@ static u8 lc_meters[LC_METERS_NUM_PORTS][LC_METERS_NUM_ITEMS];
 /////////////////////////////////////////////////////////////////////////////
 static s32 MBNG_EVENT_ItemCopy2User(mbng_event_pool_item_t* pool_item, mbng_event_item_t *item);
 static s32 MBNG_EVENT_ItemCopy2Pool(mbng_event_item_t *item, mbng_event_pool_item_t* pool_item);
+static s32 MBNG_EVENT_PoolItemReceive(mbng_event_pool_item_t *pool_item, u16 value, u8 secondary_value, u16 matrix_pin, u8 from_midi, u8 fwd_enabled);
+static mbng_event_pool_item_t *MBNG_EVENT_PoolItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, u32 *continue_ix);
+static mbng_event_pool_item_t *MBNG_EVENT_PoolItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, u32 *continue_ix);
+static s32 MBNG_EVENT_CondCheck(mbng_event_cond_t cond, u16 value);
+
+static s32 MBNG_EVENT_PoolIndexUpdate(void);
+static void MBNG_EVENT_PoolIndexShift(u16 item_offset, int len_diff);
+static s32 MBNG_EVENT_ReceiveIndexUpdate(void);
+static s32 MBNG_EVENT_SearchIndexUpdate(void);
+static s32 MBNG_EVENT_MIDI_ReceiveItem(mbng_event_pool_item_t *pool_item, u32 port_mask, mios32_midi_package_t midi_package, u16 nrpn_address, u16 nrpn_value, u8 nrpn_msb_only);
 
 static s32 MBNG_EVENT_LCMeters_Update(void);
 static s32 MBNG_EVENT_LCMeters_Set(u8 port_ix, u8 lc_meter_value);
@@ -376,6 +427,11 @@ s32 MBNG_EVENT_PoolClear(void)
   selected_bank = 1;
   num_banks = 0;
 
+  receive_index_valid = 0;
+  search_index_valid = 0;
+  ++pool_generation;
+  ++pool_layout_generation;
+
   return 0; // no error
 }
 
@@ -385,6 +441,7 @@ s32 MBNG_EVENT_PoolClear(void)
 s32 MBNG_EVENT_PoolUpdate(void)
 {
   num_banks = 0;
+  ++pool_generation;
 
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i;
@@ -406,6 +463,208 @@ s32 MBNG_EVENT_PoolUpdate(void)
     pool_ptr += pool_item->len;
   }
 
+  MBNG_EVENT_PoolIndexUpdate();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Builds all indices of the event pool
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_PoolIndexUpdate(void)
+{
+  s32 status = 0;
+
+  status |= MBNG_EVENT_ReceiveIndexUpdate();
+  status |= MBNG_EVENT_SearchIndexUpdate();
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Moves the pool offsets of all indexed items which are located behind the
+//! given item, used if the size of an item has been changed.\n
+//! The order of the indices doesn't change, therefore they don't need to be rebuilt.
+/////////////////////////////////////////////////////////////////////////////
+static void MBNG_EVENT_PoolIndexShift(u16 item_offset, int len_diff)
+{
+  u32 i;
+  for(i=0; i<event_pool_num_items; ++i) {
+    if( receive_index_valid && receive_index_offset[i] > item_offset )
+      receive_index_offset[i] += len_diff;
+
+    if( search_index_valid ) {
+      if( search_index_id[i] > item_offset )
+	search_index_id[i] += len_diff;
+      if( search_index_hw_id[i] > item_offset )
+	search_index_hw_id[i] += len_diff;
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the receive index bucket of a stream begin and key
+/////////////////////////////////////////////////////////////////////////////
+static u16 MBNG_EVENT_ReceiveIndexBucket(u8 evnt0, u16 key)
+{
+  return (evnt0 * 31 + (key ^ (key >> 7))) & (MBNG_EVENT_RECEIVE_INDEX_BUCKETS-1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the receive index bucket of a pool item
+//! Returns MBNG_EVENT_RECEIVE_INDEX_END if the item doesn't receive MIDI events
+/////////////////////////////////////////////////////////////////////////////
+static u16 MBNG_EVENT_ReceiveIndexItemBucket(mbng_event_pool_item_t *pool_item)
+{
+  if( !pool_item->len_stream || (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER )
+    return MBNG_EVENT_RECEIVE_INDEX_END; // item doesn't receive
+
+  u8 *stream = &pool_item->data_begin;
+  u16 key = MBNG_EVENT_RECEIVE_KEY_ANY;
+  mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+  if( event_type <= MBNG_EVENT_TYPE_CC ) {
+    // button/led matrices receive a range of keys
+    u16 hw_type = pool_item->hw_id & 0xf000;
+    if( !pool_item->flags.use_any_key_or_cc && pool_item->len_stream >= 2 &&
+	hw_type != MBNG_EVENT_CONTROLLER_BUTTON_MATRIX && hw_type != MBNG_EVENT_CONTROLLER_LED_MATRIX )
+      key = stream[1];
+  } else if( event_type == MBNG_EVENT_TYPE_NRPN && pool_item->len_stream >= 3 ) {
+    key = MBNG_EVENT_RECEIVE_KEY_NRPN | stream[1] | ((u16)stream[2] << 7);
+  }
+
+  return MBNG_EVENT_ReceiveIndexBucket(stream[0], key);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Builds the hash index which is used by MBNG_EVENT_MIDI_NotifyPackage
+//! Items are linked in pool order, so that they are received in the same
+//! order like with a linear search.
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_ReceiveIndexUpdate(void)
+{
+  receive_index_valid = 0;
+
+  if( event_pool_num_items > MBNG_EVENT_INDEX_MAX_ITEMS )
+    return -1; // pool will be searched linearly
+
+  u32 i;
+  for(i=0; i<MBNG_EVENT_RECEIVE_INDEX_BUCKETS; ++i)
+    receive_index_bucket[i] = MBNG_EVENT_RECEIVE_INDEX_END;
+
+  // link items in reverse order...
+  u8 *pool_ptr = (u8 *)&event_pool[0];
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    pool_ptr += pool_item->len;
+
+    u16 bucket = MBNG_EVENT_ReceiveIndexItemBucket(pool_item);
+    if( bucket == MBNG_EVENT_RECEIVE_INDEX_END )
+      continue; // item doesn't receive
+
+    receive_index_offset[i] = (u32)pool_item - (u32)&event_pool[0];
+    receive_index_next[i] = receive_index_bucket[bucket];
+    receive_index_bucket[bucket] = i;
+  }
+
+  // ...and revert the order of each bucket
+  for(i=0; i<MBNG_EVENT_RECEIVE_INDEX_BUCKETS; ++i) {
+    u16 entry = receive_index_bucket[i];
+    u16 prev_entry = MBNG_EVENT_RECEIVE_INDEX_END;
+    while( entry != MBNG_EVENT_RECEIVE_INDEX_END ) {
+      u16 next_entry = receive_index_next[entry];
+      receive_index_next[entry] = prev_entry;
+      prev_entry = entry;
+      entry = next_entry;
+    }
+    receive_index_bucket[i] = prev_entry;
+  }
+
+  receive_index_valid = 1;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the key of a search index entry
+/////////////////////////////////////////////////////////////////////////////
+static inline u16 MBNG_EVENT_SearchIndexKey(u16 offset, u8 by_hw_id)
+{
+  mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[offset];
+  return by_hw_id ? pool_item->hw_id : pool_item->id;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sorts a search index by id (resp. hw_id) and pool offset (Shell sort)
+/////////////////////////////////////////////////////////////////////////////
+static void MBNG_EVENT_SearchIndexSort(u16 *index, u32 num_entries, u8 by_hw_id)
+{
+  u32 gap;
+  for(gap=num_entries/2; gap>0; gap/=2) {
+    u32 i;
+    for(i=gap; i<num_entries; ++i) {
+      u16 offset = index[i];
+      u16 key = MBNG_EVENT_SearchIndexKey(offset, by_hw_id);
+      u32 j;
+      for(j=i; j>=gap; j-=gap) {
+	u16 prev_offset = index[j-gap];
+	u16 prev_key = MBNG_EVENT_SearchIndexKey(prev_offset, by_hw_id);
+	if( prev_key < key || (prev_key == key && prev_offset < offset) )
+	  break;
+	index[j] = prev_offset;
+      }
+      index[j] = offset;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the first position of a search index with a key >= the given id
+/////////////////////////////////////////////////////////////////////////////
+static u32 MBNG_EVENT_SearchIndexFind(u16 *index, u8 by_hw_id, mbng_event_item_id_t id)
+{
+  u32 lower = 0;
+  u32 upper = event_pool_num_items;
+
+  while( lower < upper ) {
+    u32 pos = (lower + upper) / 2;
+    if( MBNG_EVENT_SearchIndexKey(index[pos], by_hw_id) < id )
+      lower = pos + 1;
+    else
+      upper = pos;
+  }
+
+  return lower;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Builds the sorted indices which are used by MBNG_EVENT_ItemSearchById
+//! and MBNG_EVENT_ItemSearchByHwId
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_SearchIndexUpdate(void)
+{
+  search_index_valid = 0;
+
+  if( event_pool_num_items > MBNG_EVENT_INDEX_MAX_ITEMS )
+    return -1; // pool will be searched linearly
+
+  u8 *pool_ptr = (u8 *)&event_pool[0];
+  u32 i;
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    search_index_id[i] = (u32)pool_ptr - (u32)&event_pool[0];
+    search_index_hw_id[i] = search_index_id[i];
+    pool_ptr += pool_item->len;
+  }
+
+  MBNG_EVENT_SearchIndexSort(search_index_id, event_pool_num_items, 0);
+  MBNG_EVENT_SearchIndexSort(search_index_hw_id, event_pool_num_items, 1);
+
+  search_index_valid = 1;
+
   return 0; // no error
 }
 
@@ -529,6 +788,41 @@ s32 MBNG_EVENT_PoolMaxSizeGet(void)
   return MBNG_EVENT_POOL_MAX_SIZE;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//! \returns the pool generation, it changes whenever items have been added,
+//! resized, activated or deactivated, or if their hw_id has been changed.\n
+//! As long as the generation doesn't change, the pool_address of an item
+//! found with MBNG_EVENT_ItemSearchById/ByHwId stays valid.
+/////////////////////////////////////////////////////////////////////////////
+u16 MBNG_EVENT_PoolGenerationGet(void)
+{
+  return pool_generation;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns the pool layout generation, it only changes if items have been
+//! added or resized.\n
+//! As long as the layout generation doesn't change, the pool_address of an
+//! item found with MBNG_EVENT_ItemSearchById stays valid.
+/////////////////////////////////////////////////////////////////////////////
+u16 MBNG_EVENT_PoolLayoutGenerationGet(void)
+{
+  return pool_layout_generation;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns the value of the item at the given pool address
+//! \returns < 0 if the pool address is invalid
+/////////////////////////////////////////////////////////////////////////////
+s32 MBNG_EVENT_PoolItemValueGet(u16 pool_address)
+{
+  if( pool_address >= event_pool_maps_begin )
+    return -1; // invalid address
+
+  mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[pool_address];
+  return pool_item->value;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Adds a map to event pool
@@ -863,7 +1157,11 @@ s32 MBNG_EVENT_SelectedBankSet(u8 new_bank)
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
 
     if( pool_item->bank ) {
-      pool_item->flags.active = (pool_item->bank == new_bank);
+      u8 active = (pool_item->bank == new_bank);
+      if( pool_item->flags.active != active ) {
+	pool_item->flags.active = active;
+	++pool_generation;
+      }
     }
 
     pool_ptr += pool_item->len;
@@ -908,7 +1206,11 @@ s32 MBNG_EVENT_HwIdBankSet(u16 hw_id, u8 new_bank)
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
 
     if( (pool_item->hw_id & 0xfff) == hw_id && pool_item->bank ) {
-      pool_item->flags.active = (pool_item->bank == new_bank);
+      u8 active = (pool_item->bank == new_bank);
+      if( pool_item->flags.active != active ) {
+	pool_item->flags.active = active;
+	++pool_generation;
+      }
 
       // refresh active item
       if( pool_item->flags.active ) {
@@ -1057,6 +1359,98 @@ s32 MBNG_EVENT_ItemInit(mbng_event_item_t *item, mbng_event_item_id_t id)
   return 0; // no error
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//! Local functions to access a pool item in place
+//! They are used in timing critical parts to avoid a MBNG_EVENT_ItemCopy2User()
+//! if only a few parameters are required.
+//! The order of the extra parameters is defined by MBNG_EVENT_ItemCopy2Pool()
+/////////////////////////////////////////////////////////////////////////////
+static inline mbng_event_pool_item_t *MBNG_EVENT_PoolItemGet(u16 pool_address)
+{
+  if( pool_address >= (MBNG_EVENT_POOL_MAX_SIZE-1) )
+    return NULL;
+
+  return (mbng_event_pool_item_t *)&event_pool[pool_address];
+}
+
+static inline u8 *MBNG_EVENT_PoolItemExtraPar(mbng_event_pool_item_t *pool_item)
+{
+  return (u8 *)(&pool_item->data_begin + pool_item->len_stream + pool_item->len_label);
+}
+
+static inline u16 MBNG_EVENT_PoolItemFwdIdGet(mbng_event_pool_item_t *pool_item)
+{
+  extra_par_available_t extra_par_available; extra_par_available.ALL = pool_item->extra_par_available.ALL;
+  if( !extra_par_available.has_fwd_id )
+    return 0;
+
+  u8 *extra_par = MBNG_EVENT_PoolItemExtraPar(pool_item);
+  extra_par += extra_par_available.has_cond ? 4 : 0;
+  return extra_par[0] | (extra_par[1] << 8);
+}
+
+static inline s16 MBNG_EVENT_PoolItemMinGet(mbng_event_pool_item_t *pool_item)
+{
+  extra_par_available_t extra_par_available; extra_par_available.ALL = pool_item->extra_par_available.ALL;
+  if( !extra_par_available.has_min )
+    return 0;
+
+  u8 *extra_par = MBNG_EVENT_PoolItemExtraPar(pool_item);
+  extra_par += (extra_par_available.has_cond ? 4 : 0) +
+    2*(extra_par_available.has_fwd_id + extra_par_available.has_fwd_value);
+  return (s16)(extra_par[0] | (extra_par[1] << 8));
+}
+
+static inline s16 MBNG_EVENT_PoolItemMaxGet(mbng_event_pool_item_t *pool_item)
+{
+  extra_par_available_t extra_par_available; extra_par_available.ALL = pool_item->extra_par_available.ALL;
+  if( !extra_par_available.has_max )
+    return 127;
+
+  u8 *extra_par = MBNG_EVENT_PoolItemExtraPar(pool_item);
+  extra_par += (extra_par_available.has_cond ? 4 : 0) +
+    2*(extra_par_available.has_fwd_id + extra_par_available.has_fwd_value + extra_par_available.has_min);
+  return (s16)(extra_par[0] | (extra_par[1] << 8));
+}
+
+static inline mbng_event_cond_t MBNG_EVENT_PoolItemCondGet(mbng_event_pool_item_t *pool_item)
+{
+  mbng_event_cond_t cond;
+  extra_par_available_t extra_par_available; extra_par_available.ALL = pool_item->extra_par_available.ALL;
+  if( !extra_par_available.has_cond ) {
+    cond.ALL = 0;
+  } else {
+    u8 *extra_par = MBNG_EVENT_PoolItemExtraPar(pool_item);
+    cond.ALL = extra_par[0] | (extra_par[1] << 8) | (extra_par[2] << 16) | (extra_par[3] << 24);
+  }
+  return cond;
+}
+
+static inline u8 MBNG_EVENT_PoolItemMapGet(mbng_event_pool_item_t *pool_item)
+{
+  extra_par_available_t extra_par_available; extra_par_available.ALL = pool_item->extra_par_available.ALL;
+  if( !extra_par_available.has_map )
+    return 0;
+
+  u8 *extra_par = MBNG_EVENT_PoolItemExtraPar(pool_item);
+  extra_par += (extra_par_available.has_cond ? 4 : 0) +
+    2*(extra_par_available.has_fwd_id + extra_par_available.has_fwd_value + extra_par_available.has_min +
+       extra_par_available.has_max + extra_par_available.has_offset + extra_par_available.has_rgb) +
+    (extra_par_available.has_hsv ? 4 : 0);
+  return extra_par[0];
+}
+
+//! takes over a new value in the pool item
+//! the secondary value is only changed if the key_or_cc option is selected
+static inline void MBNG_EVENT_PoolItemValueSet(mbng_event_pool_item_t *pool_item, u16 value, u8 secondary_value, u8 from_midi)
+{
+  pool_item->value = value;
+  if( pool_item->flags.use_key_or_cc )
+    pool_item->secondary_value = secondary_value;
+  pool_item->flags.value_from_midi = from_midi;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Local function to copy a pool item into a "user" item
 /////////////////////////////////////////////////////////////////////////////
@@ -1427,6 +1821,12 @@ s32 MBNG_EVENT_ItemAdd(mbng_event_item_t *item)
   ++event_pool_num_items;
   event_pool_maps_begin += pool_item_len;
 
+  // indices will be updated with MBNG_EVENT_PoolUpdate()
+  receive_index_valid = 0;
+  search_index_valid = 0;
+  ++pool_generation;
+  ++pool_layout_generation;
+
   return 0; // no error
 }
 
@@ -1448,6 +1848,9 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 	return -2; // too much data
 
       int len_diff = pool_item_len - pool_item->len;
+      u16 prev_hw_id = pool_item->hw_id;
+      u8 prev_active = pool_item->flags.active;
+      u16 prev_bucket = MBNG_EVENT_ReceiveIndexItemBucket(pool_item);
       if( len_diff >= 0 && (event_pool_size+len_diff) > MBNG_EVENT_POOL_MAX_SIZE )
 	return -2; // out of storage 
 
@@ -1485,6 +1888,20 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 	MBNG_EVENT_ItemCopy2Pool(item, pool_item);
       }
 
+      // in-place modifications (e.g. value, RGB/HSV, min/max) don't affect cached search results
+      if( len_diff != 0 || pool_item->hw_id != prev_hw_id || pool_item->flags.active != prev_active )
+	++pool_generation;
+      if( len_diff != 0 )
+	++pool_layout_generation;
+
+      // update indices if hw_id or receive key have been changed, pool offsets can be moved
+      if( receive_index_valid || search_index_valid ) {
+	if( pool_item->hw_id != prev_hw_id || MBNG_EVENT_ReceiveIndexItemBucket(pool_item) != prev_bucket )
+	  MBNG_EVENT_PoolIndexUpdate();
+	else if( len_diff != 0 )
+	  MBNG_EVENT_PoolIndexShift((u32)pool_item - (u32)&event_pool[0], len_diff);
+      }
+
       return 0; // operation was successfull
     }
     pool_ptr += pool_item->len;
@@ -1494,12 +1911,34 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 }
 
 /////////////////////////////////////////////////////////////////////////////
-//! Search an item in event pool based on ID (optional within a range if id_end_range!= 0)
-//! \returns 0 and copies item into *item if found
-//! \returns -1 if item not found
+//! Local function to search an item in event pool based on ID, see MBNG_EVENT_ItemSearchById\n
+//! The item can be accessed in place, e.g. on the receive path
+//! \returns the pool item or NULL if item not found
 /////////////////////////////////////////////////////////////////////////////
-s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+static mbng_event_pool_item_t *MBNG_EVENT_PoolItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, u32 *continue_ix)
 {
+  if( search_index_valid ) {
+    // binary search in sorted index
+    u32 pos;
+    if( *continue_ix ) {
+      if( !(*continue_ix & MBNG_EVENT_SEARCH_INDEX_CONTINUE) )
+	return NULL; // search hasn't been started with index
+      pos = *continue_ix & 0xffff;
+    } else {
+      pos = MBNG_EVENT_SearchIndexFind(search_index_id, 0, id);
+    }
+
+    if( pos < event_pool_num_items ) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[search_index_id[pos]];
+      if( pool_item->id >= id && pool_item->id <= (id_end_range ? id_end_range : id) ) {
+	*continue_ix = MBNG_EVENT_SEARCH_INDEX_CONTINUE | (pos + 1);
+	return pool_item; // item found
+      }
+    }
+
+    return NULL; // not found
+  }
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -1514,8 +1953,6 @@ s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_e
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
     if( (!id_end_range && pool_item->id == id) ||
         (id_end_range && pool_item->id >= id && pool_item->id <= id_end_range) ) {
-      MBNG_EVENT_ItemCopy2User(pool_item, item);
-
       // pass pointer offset to pool item + index of pool item in continue_ix for continued search
       // skip this if the new values exceeding the 16bit boundary, or if this is the last pool item
       u32 next_pool_offset = (u32)pool_ptr - (u32)event_pool + pool_item->len;
@@ -1525,23 +1962,48 @@ s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_e
       else
 	*continue_ix = (next_pool_i << 16) | next_pool_offset;
 
-      return 0; // item found
+      return pool_item; // item found
     }
     pool_ptr += pool_item->len;
   }
 
-  return -1; // not found
+  return NULL; // not found
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! Search an item in event pool based on the HW ID (optional within a range if hw_id_end!= 0)
-//! Takes the selected bank into account (means: only an active item will be returned)
-//! \returns 0 and copies item into *item if found
-//! \returns -1 if item not found
+//! Local function to search an item in event pool based on the HW ID, see MBNG_EVENT_ItemSearchByHwId\n
+//! The item can be accessed in place, e.g. on the receive path
+//! \returns the pool item or NULL if item not found
 /////////////////////////////////////////////////////////////////////////////
-s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+static mbng_event_pool_item_t *MBNG_EVENT_PoolItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, u32 *continue_ix)
 {
+  if( search_index_valid ) {
+    // binary search in sorted index
+    u32 pos;
+    if( *continue_ix ) {
+      if( !(*continue_ix & MBNG_EVENT_SEARCH_INDEX_CONTINUE) )
+	return NULL; // search hasn't been started with index
+      pos = *continue_ix & 0xffff;
+    } else {
+      pos = MBNG_EVENT_SearchIndexFind(search_index_hw_id, 1, hw_id);
+    }
+
+    // skip items which are not active (e.g. located in another bank)
+    for(; pos < event_pool_num_items; ++pos) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[search_index_hw_id[pos]];
+      if( pool_item->hw_id < hw_id || pool_item->hw_id > (hw_id_end_range ? hw_id_end_range : hw_id) )
+	break;
+
+      if( pool_item->flags.active ) {
+	*continue_ix = MBNG_EVENT_SEARCH_INDEX_CONTINUE | (pos + 1);
+	return pool_item; // item found
+      }
+    }
+
+    return NULL; // not found
+  }
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -1558,8 +2020,6 @@ s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t
     if( pool_item->flags.active &&
         ((!hw_id_end_range && pool_item->hw_id == hw_id) ||
          (hw_id_end_range && pool_item->hw_id >= hw_id && pool_item->hw_id <= hw_id_end_range)) ) {
-      MBNG_EVENT_ItemCopy2User(pool_item, item);
-
       // pass pointer offset to pool item + index of pool item in continue_ix for continued search
       // skip this if the new values exceeding the 16bit boundary, or if this is the last pool item
       u32 next_pool_offset = (u32)pool_ptr - (u32)event_pool + pool_item->len;
@@ -1569,12 +2029,45 @@ s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t
       else
 	*continue_ix = (next_pool_i << 16) | next_pool_offset;
 
-      return 0; // item found
+      return pool_item; // item found
     }
     pool_ptr += pool_item->len;
   }
 
-  return -1; // not found
+  return NULL; // not found
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Search an item in event pool based on ID (optional within a range if id_end_range!= 0)
+//! \returns 0 and copies item into *item if found
+//! \returns -1 if item not found
+/////////////////////////////////////////////////////////////////////////////
+s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+{
+  mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemSearchById(id, id_end_range, continue_ix);
+  if( pool_item == NULL )
+    return -1; // not found
+
+  MBNG_EVENT_ItemCopy2User(pool_item, item);
+  return 0; // item found
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Search an item in event pool based on the HW ID (optional within a range if hw_id_end!= 0)
+//! Takes the selected bank into account (means: only an active item will be returned)
+//! \returns 0 and copies item into *item if found
+//! \returns -1 if item not found
+/////////////////////////////////////////////////////////////////////////////
+s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, mbng_event_item_t *item, u32 *continue_ix)
+{
+  mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemSearchByHwId(hw_id, hw_id_end_range, continue_ix);
+  if( pool_item == NULL )
+    return -1; // not found
+
+  MBNG_EVENT_ItemCopy2User(pool_item, item);
+  return 0; // item found
 }
 
 
@@ -1625,12 +2118,9 @@ s32 MBNG_EVENT_ItemRetrieveValues(mbng_event_item_id_t *id, s16 *value, u8 *seco
 s32 MBNG_EVENT_ItemCopyValueToPool(mbng_event_item_t *item)
 {
   // take over in pool item
-  if( item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
-    pool_item->value = item->value;
-    if( item->flags.use_key_or_cc ) // only change secondary value if key_or_cc option selected
-      pool_item->secondary_value = item->secondary_value;
-    pool_item->flags.value_from_midi = 0;
+  mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemGet(item->pool_address);
+  if( pool_item ) {
+    MBNG_EVENT_PoolItemValueSet(pool_item, item->value, item->secondary_value, 0);
   }
 
   return 0; // no error
@@ -1645,8 +2135,11 @@ s32 MBNG_EVENT_ItemSetActive(mbng_event_item_t *item, u8 active)
   // take over in pool item
   if( item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
+    u8 prev_active = pool_item->flags.active;
     pool_item->flags.active = active;
     item->flags.active = active;
+    if( pool_item->flags.active != prev_active )
+      ++pool_generation;
 
     if( active ) {
       u8 allow_refresh = 1;
@@ -1720,33 +2213,42 @@ s32 MBNG_EVENT_ItemSetMapIx(mbng_event_item_t *item, u8 map_ix)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ItemCheckMatchingCondition(mbng_event_item_t *item)
 {
-  if( !item->cond.condition )
+  return MBNG_EVENT_CondCheck(item->cond, item->value);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function to check the condition of an item with the given value,
+//! also used for pool items (see MBNG_EVENT_PoolItemValueTakeOver)
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_CondCheck(mbng_event_cond_t cond, u16 value)
+{
+  if( !cond.condition )
     return 1; // shortcut: no condition selected -> match
 
   // take value from another event?
   u16 cmp_value;
-  if( item->cond.hw_id ) {
-    mbng_event_item_t tmp_item;
+  if( cond.hw_id ) {
     u32 continue_ix = 0;
-    if( MBNG_EVENT_ItemSearchById(item->cond.hw_id, 0, &tmp_item, &continue_ix) < 0 ) {
+    mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemSearchById(cond.hw_id, 0, &continue_ix);
+    if( pool_item == NULL ) {
       return 0; // id doesn't exist -> no match
     }
-    cmp_value = tmp_item.value;
+    cmp_value = pool_item->value;
   } else {
     // take my own value
-    cmp_value = item->value;
+    cmp_value = value;
   }
 
   // check condition:
-  switch( item->cond.condition ) {
-  case MBNG_EVENT_IF_COND_EQ:                  return (cmp_value == item->cond.value) ? 1 : 0;
-  case MBNG_EVENT_IF_COND_EQ_STOP_ON_MATCH:    return (cmp_value == item->cond.value) ? 2 : 0;
-  case MBNG_EVENT_IF_COND_UNEQ:                return (cmp_value != item->cond.value) ? 1 : 0;
-  case MBNG_EVENT_IF_COND_UNEQ_STOP_ON_MATCH:  return (cmp_value != item->cond.value) ? 2 : 0;
-  case MBNG_EVENT_IF_COND_LT:                  return (cmp_value <  item->cond.value) ? 1 : 0;
-  case MBNG_EVENT_IF_COND_LT_STOP_ON_MATCH:    return (cmp_value <  item->cond.value) ? 2 : 0;
-  case MBNG_EVENT_IF_COND_LEQ:                 return (cmp_value <= item->cond.value) ? 1 : 0;
-  case MBNG_EVENT_IF_COND_LEQ_STOP_ON_MATCH:   return (cmp_value <= item->cond.value) ? 2 : 0;
+  switch( cond.condition ) {
+  case MBNG_EVENT_IF_COND_EQ:                  return (cmp_value == cond.value) ? 1 : 0;
+  case MBNG_EVENT_IF_COND_EQ_STOP_ON_MATCH:    return (cmp_value == cond.value) ? 2 : 0;
+  case MBNG_EVENT_IF_COND_UNEQ:                return (cmp_value != cond.value) ? 1 : 0;
+  case MBNG_EVENT_IF_COND_UNEQ_STOP_ON_MATCH:  return (cmp_value != cond.value) ? 2 : 0;
+  case MBNG_EVENT_IF_COND_LT:                  return (cmp_value <  cond.value) ? 1 : 0;
+  case MBNG_EVENT_IF_COND_LT_STOP_ON_MATCH:    return (cmp_value <  cond.value) ? 2 : 0;
+  case MBNG_EVENT_IF_COND_LEQ:                 return (cmp_value <= cond.value) ? 1 : 0;
+  case MBNG_EVENT_IF_COND_LEQ_STOP_ON_MATCH:   return (cmp_value <= cond.value) ? 2 : 0;
   }
 
   return 0;
@@ -2354,6 +2856,7 @@ s32 MBNG_EVENT_MidiLearnIt(mbng_event_item_id_t hw_id)
       MBNG_EVENT_MidiLearnModeSet(0); // disable learn mode
       return -3; // out of memory...
     }
+    MBNG_EVENT_PoolIndexUpdate();
     if( debug_verbose_level >= DEBUG_VERBOSE_LEVEL_INFO ) {
       DEBUG_MSG("[MIDI_LEARN] item id=%s:%d has been created.\n", MBNG_EVENT_ItemControllerStrGet(id), id & 0xfff);
     }
@@ -3973,12 +4476,9 @@ s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8
   item->flags.value_from_midi = from_midi;
 
   // take over in pool item
-  if( item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
-    pool_item->value = item->value;
-    if( item->flags.use_key_or_cc ) // only change secondary value if key_or_cc option selected
-      pool_item->secondary_value = item->secondary_value;
-    pool_item->flags.value_from_midi = from_midi;
+  mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemGet(item->pool_address);
+  if( pool_item ) {
+    MBNG_EVENT_PoolItemValueSet(pool_item, item->value, item->secondary_value, from_midi);
   }
 
   // item active?
@@ -4022,8 +4522,7 @@ s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8
 	item->value = mapped_value;
 
 	// store in pool
-	if( item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-	  mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
+	if( pool_item ) {
 	  pool_item->value = value;
 	}
       }
@@ -4055,8 +4554,7 @@ s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8
     }
 
     // store in pool
-    if( item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
+    if( pool_item ) {
       pool_item->value = item->value;
     }
 
@@ -4121,8 +4619,7 @@ s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8
 	MBNG_EVENT_ItemForwardToRadioGroup(item, item->flags.radio_group);
     }
 
-    if( item->flags.fwd_to_lcd && item->pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + item->pool_address);
+    if( item->flags.fwd_to_lcd && pool_item ) {
       pool_item->flags.update_lcd = 1;
       last_event_item_id = pool_item->id;
     }
@@ -4133,6 +4630,54 @@ s32 MBNG_EVENT_ItemReceive(mbng_event_item_t *item, u16 value, u8 from_midi, u8
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Local function which takes over a new value in place, like the first steps
+//! of MBNG_EVENT_ItemReceive
+//! \retval < 1 if the item doesn't need to be notified (inactive, or no matching condition)
+//! \retval >= 1 if MBNG_EVENT_ItemReceive has to be called
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_PoolItemValueTakeOver(mbng_event_pool_item_t *pool_item, u16 value, u8 secondary_value, u8 from_midi)
+{
+  // mapped value -> update ix
+  u8 map = MBNG_EVENT_PoolItemMapGet(pool_item);
+  if( map ) {
+    mbng_event_map_type_t map_type;
+    u8 *map_values;
+    int map_len = MBNG_EVENT_MapGet(map, &map_type, &map_values);
+    pool_item->map_ix = MBNG_EVENT_MapIxFromValue(map_type, map_values, map_len, value);
+  }
+
+  MBNG_EVENT_PoolItemValueSet(pool_item, value, secondary_value, from_midi);
+
+  if( !pool_item->flags.active )
+    return 0; // e.g. located in another bank
+
+  return MBNG_EVENT_CondCheck(MBNG_EVENT_PoolItemCondGet(pool_item), value);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Notifies a pool item about a new value, see MBNG_EVENT_ItemReceive\n
+//! Inactive items (e.g. located in another bank) and items without matching
+//! condition only store the value, this is done in place without copying the
+//! pool item into a "user" item.
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_PoolItemReceive(mbng_event_pool_item_t *pool_item, u16 value, u8 secondary_value, u16 matrix_pin, u8 from_midi, u8 fwd_enabled)
+{
+  // write operation locked?
+  if( from_midi && pool_item->flags.write_locked )
+    return 0; // stop here
+
+  if( MBNG_EVENT_PoolItemValueTakeOver(pool_item, value, secondary_value, from_midi) < 1 )
+    return 0; // stop here
+
+  mbng_event_item_t item;
+  MBNG_EVENT_ItemCopy2User(pool_item, &item);
+  item.secondary_value = secondary_value;
+  item.matrix_pin = matrix_pin;
+  return MBNG_EVENT_ItemReceive(&item, value, from_midi, fwd_enabled);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Called to forward an event
 /////////////////////////////////////////////////////////////////////////////
@@ -4151,15 +4696,38 @@ s32 MBNG_EVENT_ItemForward(mbng_event_item_t *item)
   ++recursion_ctr;
 
   // search for fwd item
-  mbng_event_item_t fwd_item;
   u32 continue_ix = 0;
   u32 num_forwarded = 0;
   do {
-    if( MBNG_EVENT_ItemSearchByHwId(item->fwd_id, 0, &fwd_item, &continue_ix) < 0 ) {
+    mbng_event_pool_item_t *pool_item = MBNG_EVENT_PoolItemSearchByHwId(item->fwd_id, 0, &continue_ix);
+    if( pool_item == NULL ) {
       break;
     } else {
       ++num_forwarded;
 
+      u16 value = (item->fwd_value == 0xffff) ? item->value : item->fwd_value; // with or without forward value
+
+      // only change secondary value if key_or_cc option selected, or if fwd item allows to change the key value
+      u8 secondary_value = pool_item->secondary_value;
+      if( pool_item->flags.use_key_or_cc || pool_item->flags.use_any_key_or_cc )
+	secondary_value = item->secondary_value;
+
+      // special: if EVENT_RECEIVER forwarded to EVENT_AIN, EVENT_AINSER or EVENT_BUTTON, send also MIDI event
+      u16 id_type = item->id & 0xf000;
+      u16 fwd_type = pool_item->id & 0xf000;
+      u8 send_midi = id_type == MBNG_EVENT_CONTROLLER_RECEIVER &&
+	(fwd_type == MBNG_EVENT_CONTROLLER_AIN ||
+	 fwd_type == MBNG_EVENT_CONTROLLER_AINSER ||
+	 fwd_type == MBNG_EVENT_CONTROLLER_BUTTON);
+
+      // items without matching condition only store the value, this is done in place
+      if( !send_midi && MBNG_EVENT_PoolItemValueTakeOver(pool_item, value, secondary_value, 0) < 1 )
+	continue;
+
+      mbng_event_item_t fwd_item;
+      MBNG_EVENT_ItemCopy2User(pool_item, &fwd_item);
+      fwd_item.secondary_value = secondary_value;
+
       // clear the custom flags if not the same event type, because they are very likely not compatible
       // see also http://midibox.org/forums/topic/19709-dio-matrix-going-haywire/#comment-171691
       if( ((fwd_item.id ^ item->id) & 0xf000) != 0 ) {
@@ -4167,23 +4735,10 @@ s32 MBNG_EVENT_ItemForward(mbng_event_item_t *item)
       }
 
       // notify item (will also store value in pool item)
-      if( fwd_item.flags.use_key_or_cc || fwd_item.flags.use_any_key_or_cc ) // only change secondary value if key_or_cc option selected, or if fwd item allows to change the key value
-	fwd_item.secondary_value = item->secondary_value;
-      if( item->fwd_value == 0xffff ) { // no forward value
-	if( MBNG_EVENT_ItemReceive(&fwd_item, item->value, 0, 1) == 2 )
-	  break; // stop has been requested
-      } else { // with forward value
-	if( MBNG_EVENT_ItemReceive(&fwd_item, item->fwd_value, 0, 1) == 2 )
-	  break; // stop has been requested
-      }
+      if( MBNG_EVENT_ItemReceive(&fwd_item, value, 0, 1) == 2 )
+	break; // stop has been requested
 
-      // special: if EVENT_RECEIVER forwarded to EVENT_AIN, EVENT_AINSER or EVENT_BUTTON, send also MIDI event
-      u16 id_type = item->id & 0xf000;
-      u16 fwd_type = fwd_item.id & 0xf000;
-      if( id_type == MBNG_EVENT_CONTROLLER_RECEIVER &&
-	  (fwd_type == MBNG_EVENT_CONTROLLER_AIN ||
-	   fwd_type == MBNG_EVENT_CONTROLLER_AINSER ||
-	   fwd_type == MBNG_EVENT_CONTROLLER_BUTTON) ) {
+      if( send_midi ) {
 	MBNG_EVENT_ItemSend(&fwd_item);
       }
     }
@@ -4213,50 +4768,56 @@ s32 MBNG_EVENT_ItemForwardToRadioGroup(mbng_event_item_t *item, u8 radio_group)
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
 
     if( pool_item->flags.radio_group == radio_group ) {
-      mbng_event_item_t fwd_item;
-      MBNG_EVENT_ItemCopy2User(pool_item, &fwd_item);
-
-      // clear the custom flags if not the same event type, because they are very likely not compatible
-      // see also http://midibox.org/forums/topic/19709-dio-matrix-going-haywire/#comment-171691
-      if( ((fwd_item.id ^ item->id) & 0xf000) != 0 ) {
-	fwd_item.custom_flags.ALL = 0;
-      }
-
       // value in range?
       // (currently only used to filter MIDI output of an EVENT_SENDER)
-      fwd_item.value = item->value; // forward the value of the sender
-      u8 value_in_range = (fwd_item.value >= fwd_item.min) && (fwd_item.value <= fwd_item.max);
+      u16 value = item->value; // forward the value of the sender
+      u8 value_in_range = (value >= MBNG_EVENT_PoolItemMinGet(pool_item)) && (value <= MBNG_EVENT_PoolItemMaxGet(pool_item));
 
       // sender/receiver will map the value
-      u16 fwd_id_type = fwd_item.id & 0xf000;
+      u16 fwd_id_type = pool_item->id & 0xf000;
       if( fwd_id_type == MBNG_EVENT_CONTROLLER_SENDER || fwd_id_type == MBNG_EVENT_CONTROLLER_RECEIVER ) {
 	s32 mapped_value;
-	if( (mapped_value=MBNG_EVENT_MapValue(fwd_item.map, fwd_item.value, 0, 0)) >= 0 ) {
-	  fwd_item.value = mapped_value;
+	if( (mapped_value=MBNG_EVENT_MapValue(MBNG_EVENT_PoolItemMapGet(pool_item), value, 0, 0)) >= 0 ) {
+	  value = mapped_value;
 	}
       }
 
-      // take over value of item in pool item
-      if( fwd_item.pool_address < (MBNG_EVENT_POOL_MAX_SIZE-1) ) {
-	mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)((u32)&event_pool[0] + fwd_item.pool_address);
-	pool_item->value = fwd_item.value;
+      // a "user" item is only required to notify the button/LED element, to send the MIDI value
+      // or to trigger forwarding - otherwise only the value has to be taken over
+      u8 notify = fwd_id_type == MBNG_EVENT_CONTROLLER_BUTTON ||
+	          fwd_id_type == MBNG_EVENT_CONTROLLER_LED ||
+	          (fwd_id_type == MBNG_EVENT_CONTROLLER_SENDER && value_in_range);
+
+      if( !notify && !MBNG_EVENT_PoolItemFwdIdGet(pool_item) ) {
+	// take over value of item in pool item
+	MBNG_EVENT_PoolItemValueSet(pool_item, value, pool_item->secondary_value, item->flags.value_from_midi);
+      } else {
+	mbng_event_item_t fwd_item;
+	MBNG_EVENT_ItemCopy2User(pool_item, &fwd_item);
+	fwd_item.value = value;
+
+	// clear the custom flags if not the same event type, because they are very likely not compatible
+	// see also http://midibox.org/forums/topic/19709-dio-matrix-going-haywire/#comment-171691
+	if( ((fwd_item.id ^ item->id) & 0xf000) != 0 ) {
+	  fwd_item.custom_flags.ALL = 0;
+	}
+
+	// take over value of item in pool item
+	MBNG_EVENT_PoolItemValueSet(pool_item, value, pool_item->secondary_value, item->flags.value_from_midi);
 	if( fwd_item.flags.use_key_or_cc ) // only change secondary value if key_or_cc option selected
-	  pool_item->secondary_value = fwd_item.secondary_value;
-	pool_item->flags.value_from_midi = item->flags.value_from_midi;
+	  fwd_item.secondary_value = item->secondary_value;
+
+	// notify button/LED element
+	if( fwd_id_type == MBNG_EVENT_CONTROLLER_BUTTON )
+	  MBNG_DIN_NotifyReceivedValue(&fwd_item);
+	else if( fwd_id_type == MBNG_EVENT_CONTROLLER_LED )
+	  MBNG_DOUT_NotifyReceivedValue(&fwd_item);
+	else if( fwd_id_type == MBNG_EVENT_CONTROLLER_SENDER && value_in_range ) // or send MIDI value?
+	  MBNG_EVENT_ItemSend(&fwd_item);
+
+	// and trigger forwarding
+	MBNG_EVENT_ItemForward(&fwd_item);
       }
-      if( fwd_item.flags.use_key_or_cc ) // only change secondary value if key_or_cc option selected
-	fwd_item.secondary_value = item->secondary_value;
-
-      // notify button/LED element
-      if( fwd_id_type == MBNG_EVENT_CONTROLLER_BUTTON )
-	MBNG_DIN_NotifyReceivedValue(&fwd_item);
-      else if( fwd_id_type == MBNG_EVENT_CONTROLLER_LED )
-	MBNG_DOUT_NotifyReceivedValue(&fwd_item);
-      else if( fwd_id_type == MBNG_EVENT_CONTROLLER_SENDER && value_in_range ) // or send MIDI value?
-	MBNG_EVENT_ItemSend(&fwd_item);
-
-      // and trigger forwarding
-      MBNG_EVENT_ItemForward(&fwd_item);
     }
 
     pool_ptr += pool_item->len;
@@ -4365,10 +4926,8 @@ s32 MBNG_EVENT_Refresh(void)
     }
 
     if( allow_refresh ) {
-      mbng_event_item_t item;
-      MBNG_EVENT_ItemCopy2User(pool_item, &item);
       pool_item->flags.update_lcd = 1; // force LCD update
-      MBNG_EVENT_ItemReceive(&item, pool_item->value, 1, 1);
+      MBNG_EVENT_PoolItemReceive(pool_item, pool_item->value, pool_item->secondary_value, 0, 1, 1);
     }
 
     pool_ptr += pool_item->len;
@@ -4390,10 +4949,7 @@ static s32 MBNG_EVENT_NotifySyxDump(u16 from_receiver, u16 dump_pos, u8 value)
     mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
     if( pool_item->syxdump_pos.pos == dump_pos &&
 	pool_item->syxdump_pos.receiver == from_receiver ) {
-
-      mbng_event_item_t item;
-      MBNG_EVENT_ItemCopy2User(pool_item, &item);
-      MBNG_EVENT_ItemReceive(&item, value, 1, 1);
+      MBNG_EVENT_PoolItemReceive(pool_item, value, pool_item->secondary_value, 0, 1, 1);
     }
     pool_ptr += pool_item->len;
   }
@@ -4664,107 +5220,141 @@ s32 MBNG_EVENT_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t
   }
 
   // search in pool for matching events
-  u8 evnt0 = midi_package.evnt0;
-  u8 evnt1 = midi_package.evnt1;
-  u8 *pool_ptr = (u8 *)&event_pool[0];
-  u32 i;
-  for(i=0; i<event_pool_num_items; ++i) {
-    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
-    if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
-      // first byte is matching - now we've a bit more time for checking
-      
-      if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) { // a sender doesn't receive
-	pool_ptr += pool_item->len;
-	continue;
+  if( !receive_index_valid ) {
+    // no index available: search through the whole pool
+    u8 *pool_ptr = (u8 *)&event_pool[0];
+    u32 i;
+    for(i=0; i<event_pool_num_items; ++i) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+      MBNG_EVENT_MIDI_ReceiveItem(pool_item, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
+      pool_ptr += pool_item->len;
+    }
+  } else {
+    // only the buckets of the received key/CC number, of items which receive any key/CC number
+    // and of the received NRPN address have to be checked
+    u8 evnt0 = midi_package.evnt0;
+    u16 bucket[3];
+    u16 entry[3];
+    int num_buckets = 0;
+    bucket[num_buckets++] = MBNG_EVENT_ReceiveIndexBucket(evnt0, midi_package.evnt1);
+    bucket[num_buckets++] = MBNG_EVENT_ReceiveIndexBucket(evnt0, MBNG_EVENT_RECEIVE_KEY_ANY);
+    if( nrpn_address != 0xffff )
+      bucket[num_buckets++] = MBNG_EVENT_ReceiveIndexBucket(evnt0, MBNG_EVENT_RECEIVE_KEY_NRPN | nrpn_address);
+
+    int i, j;
+    for(i=0; i<num_buckets; ++i) {
+      entry[i] = receive_index_bucket[bucket[i]];
+      for(j=0; j<i; ++j) {
+	if( bucket[j] == bucket[i] )
+	  entry[i] = MBNG_EVENT_RECEIVE_INDEX_END; // bucket already considered
       }
+    }
 
-      if( !(pool_item->enabled_ports & port_mask) ) { // port not enabled
-	pool_ptr += pool_item->len;
-	continue;
+    // merge the buckets, so that items are received in pool order
+    while( 1 ) {
+      int next = -1;
+      for(i=0; i<num_buckets; ++i) {
+	if( entry[i] != MBNG_EVENT_RECEIVE_INDEX_END &&
+	    (next < 0 || receive_index_offset[entry[i]] < receive_index_offset[entry[next]]) )
+	  next = i;
       }
 
-      mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
-      if( event_type <= MBNG_EVENT_TYPE_CC ) {
-	u8 *stream = &pool_item->data_begin;
-	if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	  if( item.flags.use_key_or_cc ) {
-	    item.secondary_value = midi_package.value;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.evnt1, 1, 1);
-	  } else {
-	    item.secondary_value = midi_package.evnt1;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
-	  }
+      if( next < 0 )
+	break;
+
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[receive_index_offset[entry[next]]];
+      entry[next] = receive_index_next[entry[next]];
+      MBNG_EVENT_MIDI_ReceiveItem(pool_item, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
+    }
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Forwards a received MIDI event to a pool item if it matches
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_MIDI_ReceiveItem(mbng_event_pool_item_t *pool_item, u32 port_mask, mios32_midi_package_t midi_package, u16 nrpn_address, u16 nrpn_value, u8 nrpn_msb_only)
+{
+  u8 evnt0 = midi_package.evnt0;
+  u8 evnt1 = midi_package.evnt1;
+
+  if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
+    // first byte is matching - now we've a bit more time for checking
+    
+    if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) { // a sender doesn't receive
+      return 0;
+    }
+
+    if( !(pool_item->enabled_ports & port_mask) ) { // port not enabled
+      return 0;
+    }
+
+    mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+    if( event_type <= MBNG_EVENT_TYPE_CC ) {
+      u8 *stream = &pool_item->data_begin;
+      if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
+	if( pool_item->flags.use_key_or_cc ) {
+	  MBNG_EVENT_PoolItemReceive(pool_item, midi_package.evnt1, midi_package.value, 0, 1, 1);
 	} else {
-	  // EXTRA for button/led matrices
-	  int matrix = (pool_item->hw_id & 0x0fff) - 1;
-	  int num_pins = -1;
-
-	  switch( pool_item->hw_id & 0xf000 ) {
-	  case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
-	      mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
-
-	      if( m->sr_din1 ) {
-		u8 row_size = m->sr_din2 ? 16 : 8;
-		num_pins = row_size * row_size;
-	      }
-	    }
-	  } break;
-	  case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
-	      mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
-
-	      if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
-		u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
-		num_pins = row_size * row_size;
-	      }
+	  MBNG_EVENT_PoolItemReceive(pool_item, midi_package.value, midi_package.evnt1, 0, 1, 1);
+	}
+      } else {
+	// EXTRA for button/led matrices
+	int matrix = (pool_item->hw_id & 0x0fff) - 1;
+	int num_pins = -1;
+
+	switch( pool_item->hw_id & 0xf000 ) {
+	case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
+	  if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
+	    mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
+
+	    if( m->sr_din1 ) {
+	      u8 row_size = m->sr_din2 ? 16 : 8;
+	      num_pins = row_size * row_size;
 	    }
-	  } break;
 	  }
-
-	  if( num_pins >= 0 ) {
-	    int first_evnt1 = stream[1];
-	    if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
-	      mbng_event_item_t item;
-	      MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	      item.matrix_pin = evnt1 - first_evnt1;
-	      MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
+	} break;
+	case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
+	  if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
+	    mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
+
+	    if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
+	      u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
+	      num_pins = row_size * row_size;
 	    }
 	  }
+	} break;
 	}
-      } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1, 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1 | ((u16)midi_package.value << 7), 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
-	u8 *stream = &pool_item->data_begin;
-	u16 expected_address = stream[1] | ((u16)stream[2] << 7);
-	mbng_event_nrpn_format_t nrpn_format = stream[3];
-	if( nrpn_address == expected_address &&
-	    (!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
 
-	  if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value / 128, 1, 1);
-	  else
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value, 1, 1);
+	if( num_pins >= 0 ) {
+	  int first_evnt1 = stream[1];
+	  if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
+	    MBNG_EVENT_PoolItemReceive(pool_item, midi_package.value, pool_item->secondary_value, evnt1 - first_evnt1, 1, 1);
+	  }
 	}
-      } else if( event_type >= MBNG_EVENT_TYPE_CLOCK && event_type <= MBNG_EVENT_TYPE_CONT ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, 0, 1, 1);
-      } else {
-	// no additional event types yet...
       }
+    } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
+      MBNG_EVENT_PoolItemReceive(pool_item, evnt1, pool_item->secondary_value, 0, 1, 1);
+    } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
+      MBNG_EVENT_PoolItemReceive(pool_item, evnt1 | ((u16)midi_package.value << 7), pool_item->secondary_value, 0, 1, 1);
+    } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
+      u8 *stream = &pool_item->data_begin;
+      u16 expected_address = stream[1] | ((u16)stream[2] << 7);
+      mbng_event_nrpn_format_t nrpn_format = stream[3];
+      if( nrpn_address == expected_address &&
+	  (!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
+	if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
+	  MBNG_EVENT_PoolItemReceive(pool_item, nrpn_value / 128, pool_item->secondary_value, 0, 1, 1);
+	else
+	  MBNG_EVENT_PoolItemReceive(pool_item, nrpn_value, pool_item->secondary_value, 0, 1, 1);
+      }
+    } else if( event_type >= MBNG_EVENT_TYPE_CLOCK && event_type <= MBNG_EVENT_TYPE_CONT ) {
+      MBNG_EVENT_PoolItemReceive(pool_item, 0, pool_item->secondary_value, 0, 1, 1);
+    } else {
+      // no additional event types yet...
     }
-    pool_ptr += pool_item->len;
   }
 
   return 0; // no error
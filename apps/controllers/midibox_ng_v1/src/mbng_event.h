@@ -425,6 +425,9 @@ extern s32 MBNG_EVENT_PoolNumItemsGet(void);
 extern s32 MBNG_EVENT_PoolNumMapsGet(void);
 extern s32 MBNG_EVENT_PoolSizeGet(void);
 extern s32 MBNG_EVENT_PoolMaxSizeGet(void);
+extern u16 MBNG_EVENT_PoolGenerationGet(void);
+extern u16 MBNG_EVENT_PoolLayoutGenerationGet(void);
+extern s32 MBNG_EVENT_PoolItemValueGet(u16 pool_address);
 
 extern s32 MBNG_EVENT_MapAdd(u8 map, mbng_event_map_type_t map_type, u8 *map_values, u16 len);
 extern s32 MBNG_EVENT_MapGet(u8 map, mbng_event_map_type_t *map_type, u8 **map_values);
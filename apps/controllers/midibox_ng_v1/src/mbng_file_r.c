@@ -53,10 +53,12 @@
 /////////////////////////////////////////////////////////////////////////////
 //! Tokenize the source file?
 /////////////////////////////////////////////////////////////////////////////
-#if defined(MIOS32_FAMILY_STM32F4xx)
-# define NGR_TOKENIZED 1
-#else
-# define NGR_TOKENIZED 0
+#ifndef NGR_TOKENIZED
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define NGR_TOKENIZED 1
+# else
+#  define NGR_TOKENIZED 0
+# endif
 #endif
 
 
@@ -75,7 +77,7 @@ static u8 if_state[IF_MAX_NESTING_LEVEL];
 #define NGR_TOKEN_MEM_SIZE 16384
 static u8 ngr_token_mem[NGR_TOKEN_MEM_SIZE];
 static u32 ngr_token_mem_end;
-static u8 if_offset[IF_MAX_NESTING_LEVEL];
+static u16 if_offset[IF_MAX_NESTING_LEVEL]; // position of the jump offset of the last IF/ELSEIF/ELSE token while tokenizing
 #endif
 
 static u32 ngr_token_mem_run_pos; // used by some debug messages
@@ -107,9 +109,9 @@ typedef enum {
   TOKEN_SET_KB_TRANSPOSE = 0x13, // followed by 3 bytes (TOKEN_VALUE_*) + operation (x bytes)
   TOKEN_SET_KB_VELOCITY_MAP = 0x14, // followed by 3 bytes (TOKEN_VALUE_*) + operation (x bytes)
 
-  TOKEN_IF              = 0x80, // +2 bytes for jump offset
-  TOKEN_ELSE            = 0x81, // +2 bytes for jump offset
-  TOKEN_ELSEIF          = 0x82, // +2 bytes for jump offset
+  TOKEN_IF              = 0x80, // +2 bytes for jump offset (position of the next ELSEIF/ELSE/ENDIF, 0 if unknown)
+  TOKEN_ELSE            = 0x81, // +2 bytes for jump offset (position of the ENDIF, 0 if unknown)
+  TOKEN_ELSEIF          = 0x82, // +2 bytes for jump offset (position of the next ELSEIF/ELSE/ENDIF, 0 if unknown)
   TOKEN_ENDIF           = 0x84,
 
   TOKEN_COND_EQ         = 0x90,
@@ -146,6 +148,9 @@ typedef enum {
   TOKEN_VALUE_SYSEX_INS = 0xbc,
   TOKEN_VALUE_SYSEX_CHN = 0xbd,
 
+  TOKEN_VALUE_ID_REF    = 0xbe, // +2 bytes for ID, +2 bytes for cached pool address, +2 bytes for pool layout generation
+  TOKEN_VALUE_HW_ID_REF = 0xbf, // +2 bytes for ID, +2 bytes for cached pool address, +2 bytes for pool generation
+
 } ngr_token_t;
 
 
@@ -567,6 +572,9 @@ static s32 get_dec(char *word)
 /////////////////////////////////////////////////////////////////////////////
 s32 lineIsEmpty(char *line)
 {
+  if( line == NULL )
+    return 1; // no remaining characters (ngr_strtok_r reached the end of line)
+
   while( *line ) {
     if( *line == '#' )
       return 1; // line is empty (allow comment)
@@ -634,6 +642,87 @@ static mbng_file_r_item_id_t parseId(char *parameter)
 }
 
 
+#if NGR_TOKENIZED
+/////////////////////////////////////////////////////////////////////////////
+//! help function which folds a tokenized math operation with two constant
+//! operands into a single constant token (called while tokenizing)
+//! \returns 1 if the operation has been folded
+/////////////////////////////////////////////////////////////////////////////
+static s32 foldTokenizedMath(u32 math_token_pos, u32 line)
+{
+  u32 pos = math_token_pos;
+  ngr_token_t math_token = ngr_token_mem[pos++];
+
+  s32 operand[2];
+  int i;
+  for(i=0; i<2; ++i) {
+    if( ngr_token_mem[pos] == TOKEN_VALUE_CONST8 && (pos+2) <= ngr_token_mem_end ) {
+      operand[i] = (u16)ngr_token_mem[pos+1];
+      pos += 2;
+    } else if( ngr_token_mem[pos] == TOKEN_VALUE_CONST16 && (pos+3) <= ngr_token_mem_end ) {
+      operand[i] = (s16)((u16)ngr_token_mem[pos+1] | ((u16)ngr_token_mem[pos+2] << 8));
+      pos += 3;
+    } else {
+      return 0; // no constant operand
+    }
+  }
+
+  if( pos != ngr_token_mem_end )
+    return 0; // unexpected tokens
+
+  s32 value;
+  switch( math_token ) {
+  case TOKEN_MATH_PLUS:   value = operand[0] + operand[1]; break;
+  case TOKEN_MATH_MINUS:  value = operand[0] - operand[1]; break;
+  case TOKEN_MATH_MUL:    value = operand[0] * operand[1]; break;
+  case TOKEN_MATH_DIV:    if( !operand[1] ) return 0; value = operand[0] / operand[1]; break;
+  case TOKEN_MATH_REMAIN: if( !operand[1] ) return 0; value = operand[0] % operand[1]; break;
+  case TOKEN_MATH_AND:    value = operand[0] & operand[1]; break;
+  case TOKEN_MATH_OR:     value = operand[0] | operand[1]; break;
+  case TOKEN_MATH_XOR:    value = operand[0] ^ operand[1]; break;
+  default:
+    return 0; // unsupported operator
+  }
+
+  if( value < -32768 || value > 32767 )
+    return 0; // can't be stored in a constant token
+
+  // replace the operation by the result
+  ngr_token_mem_end = math_token_pos;
+  if( value >= 0 && value <= 255 ) {
+    MBNG_FILE_R_PushToken(TOKEN_VALUE_CONST8, line);
+    MBNG_FILE_R_PushToken(value & 0xff, line);
+  } else {
+    MBNG_FILE_R_PushToken(TOKEN_VALUE_CONST16, line);
+    MBNG_FILE_R_PushToken((value >> 0) & 0xff, line);
+    MBNG_FILE_R_PushToken((value >> 8) & 0xff, line);
+  }
+
+  return 1; // folded
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! help function which stores the position of the next ELSEIF/ELSE/ENDIF
+//! token in the jump offset of the previous IF/ELSEIF/ELSE token of the same
+//! nesting level (called while tokenizing)
+/////////////////////////////////////////////////////////////////////////////
+static s32 insertTokenizedJump(u8 level)
+{
+  u32 pos = if_offset[level];
+
+  if( pos ) {
+    ngr_token_mem[pos+0] = (ngr_token_mem_end >> 0) & 0xff;
+    ngr_token_mem[pos+1] = (ngr_token_mem_end >> 8) & 0xff;
+  }
+
+  if_offset[level] = 0;
+
+  return 0; // no error
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! help function which determine a value of a condition
 //! \returns >= 0 if value is valid
@@ -664,6 +753,9 @@ static s32 parseValue(u32 line, char *command, char *value_str, u8 tokenize_req)
     char *lOperand = value_str;
     char *rOperand = value_str;
     ngr_token_t math_token = TOKEN_NOP;
+#if NGR_TOKENIZED
+    u32 math_token_pos = ngr_token_mem_end;
+#endif
     {
       int i;
       for(i=0; i<len; ++i, ++rOperand) {
@@ -720,6 +812,12 @@ static s32 parseValue(u32 line, char *command, char *value_str, u8 tokenize_req)
       return -1000000000;
     }
 
+#if NGR_TOKENIZED
+    if( tokenize_req ) { // constant expressions are calculated only once
+      foldTokenizedMath(math_token_pos, line);
+    }
+#endif
+
     switch( math_token ) {
     case TOKEN_MATH_PLUS:   return lValue + rValue;
     case TOKEN_MATH_MINUS:  return lValue - rValue;
@@ -819,10 +917,19 @@ static s32 parseValue(u32 line, char *command, char *value_str, u8 tokenize_req)
         return -1000000000; // exit due to error
       }
 
-      if( MBNG_FILE_R_PushToken(id.is_hw_id ? TOKEN_VALUE_HW_ID : TOKEN_VALUE_ID, line) < 0 ||
+      // the pool address will be resolved during the first execution
+      if( MBNG_FILE_R_PushToken(id.is_hw_id ? TOKEN_VALUE_HW_ID_REF : TOKEN_VALUE_ID_REF, line) < 0 ||
 	  MBNG_FILE_R_PushToken((id.id >> 0) & 0xff, line) < 0 ||
-	  MBNG_FILE_R_PushToken((id.id >> 8) & 0xff, line) < 0 )
+	  MBNG_FILE_R_PushToken((id.id >> 8) & 0xff, line) < 0 ||
+	  MBNG_FILE_R_PushToken(0xff, line) < 0 || // pool address
+	  MBNG_FILE_R_PushToken(0xff, line) < 0 ||
+	  MBNG_FILE_R_PushToken(0x00, line) < 0 || // pool generation
+	  MBNG_FILE_R_PushToken(0x00, line) < 0 )
 	return -1000000000; // exit due to error
+
+      // don't search the item now: like in interpreted mode, a missing item
+      // should only stop the script when the command is executed
+      return 0;
     }
 #endif
 
@@ -952,6 +1059,45 @@ static s32 parseTokenizedValue(void)
 	      is_hw_id ? "hw_id" : "id", MBNG_EVENT_ItemControllerStrGet(id), id & 0xfff, init_ngr_token_mem_run_pos);
     return -1000000000;
   } break;
+
+  case TOKEN_VALUE_ID_REF:
+  case TOKEN_VALUE_HW_ID_REF: {
+    u8 is_hw_id = token == TOKEN_VALUE_HW_ID_REF;
+    u8 *ref = (u8 *)&ngr_token_mem[ngr_token_mem_run_pos];
+    ngr_token_mem_run_pos += 6;
+
+    u16 id = (u16)ref[0] | ((u16)ref[1] << 8);
+    u16 pool_address = (u16)ref[2] | ((u16)ref[3] << 8);
+    u16 pool_generation = (u16)ref[4] | ((u16)ref[5] << 8);
+    // the item of an id only moves if the pool layout changes, the item of a hw_id also depends on the active state (banks)
+    u16 current_pool_generation = is_hw_id ? MBNG_EVENT_PoolGenerationGet() : MBNG_EVENT_PoolLayoutGenerationGet();
+
+    if( pool_address == 0xffff || pool_generation != current_pool_generation ) {
+      // resolve the item, the pool address is valid until the event pool has been changed
+      mbng_event_item_t item;
+      u32 continue_ix = 0;
+      if( (is_hw_id && MBNG_EVENT_ItemSearchByHwId(id, 0, &item, &continue_ix) < 0) ||
+	  (!is_hw_id && MBNG_EVENT_ItemSearchById(id, 0, &item, &continue_ix) < 0) ) {
+	DEBUG_MSG("[MBNG_FILE_R_Exec] ERROR: (%s)%s:%d not found in event pool at mem pos 0x%x!", 
+		  is_hw_id ? "hw_id" : "id", MBNG_EVENT_ItemControllerStrGet(id), id & 0xfff, init_ngr_token_mem_run_pos);
+	return -1000000000;
+      }
+
+      pool_address = item.pool_address;
+      ref[2] = (pool_address >> 0) & 0xff;
+      ref[3] = (pool_address >> 8) & 0xff;
+      ref[4] = (current_pool_generation >> 0) & 0xff;
+      ref[5] = (current_pool_generation >> 8) & 0xff;
+    }
+
+    s32 value = MBNG_EVENT_PoolItemValueGet(pool_address);
+    if( value < 0 ) {
+      DEBUG_MSG("[MBNG_FILE_R_Exec] ERROR: invalid pool address of (%s)%s:%d at mem pos 0x%x!", 
+		is_hw_id ? "hw_id" : "id", MBNG_EVENT_ItemControllerStrGet(id), id & 0xfff, init_ngr_token_mem_run_pos);
+      return -1000000000;
+    }
+    return (s16)value;
+  } break;
   case TOKEN_VALUE_ID_RANGE:
   case TOKEN_VALUE_HW_ID_RANGE: {
     // unsupported for value parts -- failsave:
@@ -1699,7 +1845,7 @@ s32 parseExecMeta(u32 line, char *command, char **brkt, u8 tokenize_req)
     item.stream[item.stream_size++] = value;
   }
 
-  if( strlen(brkt_local) ) {
+  if( brkt_local && strlen(brkt_local) ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
     DEBUG_MSG("[MBNG_FILE_R:%d] WARNING: more values specified than expected for meta type %s\n", line, MBNG_EVENT_ItemMetaTypeStrGet(meta_type));
 #endif
@@ -1899,7 +2045,6 @@ s32 setTokenizedValue(ngr_token_t token, u16 id, u16 range, s32 value, s32 (*exe
   case TOKEN_VALUE_ID_RANGE:
   case TOKEN_VALUE_HW_ID_RANGE: {
     u8 is_hw_id = token == TOKEN_VALUE_HW_ID || token == TOKEN_VALUE_HW_ID_RANGE;
-    u8 is_range = token == TOKEN_VALUE_ID_RANGE || token == TOKEN_VALUE_HW_ID_RANGE;
 
     // search for items with matching ID
     mbng_event_item_t item;
@@ -2361,8 +2506,9 @@ s32 MBNG_FILE_R_Parser(u32 line, char *line_buffer, u8 *if_state, u8 *nesting_le
 	} else {
 #if NGR_TOKENIZED
 	  if( tokenize_req ) { // store token
+	    if_offset[*nesting_level-1] = ngr_token_mem_end + 1;
 	    if( MBNG_FILE_R_PushToken(TOKEN_IF, line) < 0 ||
-		MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be determined during second pass
+		MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be inserted with the next ELSEIF/ELSE/ENDIF
 		MBNG_FILE_R_PushToken(0, line) < 0 ) // placeholder
 	      return 2; // exit due to error
 	  }
@@ -2400,8 +2546,10 @@ s32 MBNG_FILE_R_Parser(u32 line, char *line_buffer, u8 *if_state, u8 *nesting_le
 
 #if NGR_TOKENIZED
 	    if( tokenize_req ) { // store token
+	      insertTokenizedJump(*nesting_level-1);
+	      if_offset[*nesting_level-1] = ngr_token_mem_end + 1;
 	      if( MBNG_FILE_R_PushToken(TOKEN_ELSEIF, line) < 0 ||
-		MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be determined during second pass
+		MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be inserted with the next ELSEIF/ELSE/ENDIF
 		MBNG_FILE_R_PushToken(0, line) < 0 ) // placeholder
 		return 2; // exit due to error
 	    }
@@ -2443,6 +2591,7 @@ s32 MBNG_FILE_R_Parser(u32 line, char *line_buffer, u8 *if_state, u8 *nesting_le
       } else {
 #if NGR_TOKENIZED
 	if( tokenize_req ) { // store token
+	  insertTokenizedJump(*nesting_level-1);
 	  if( MBNG_FILE_R_PushToken(TOKEN_ENDIF, line) < 0 )
 	    return 2; // exit due to error
 	}
@@ -2474,8 +2623,10 @@ s32 MBNG_FILE_R_Parser(u32 line, char *line_buffer, u8 *if_state, u8 *nesting_le
       } else {
 #if NGR_TOKENIZED
 	if( tokenize_req ) { // store token
+	  insertTokenizedJump(*nesting_level-1);
+	  if_offset[*nesting_level-1] = ngr_token_mem_end + 1;
 	  if( MBNG_FILE_R_PushToken(TOKEN_ELSE, line) < 0 ||
-	      MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be determined during second pass
+	      MBNG_FILE_R_PushToken(0, line) < 0 || // placeholder - jump offset will be inserted with the next ELSEIF/ELSE/ENDIF
 	      MBNG_FILE_R_PushToken(0, line) < 0 ) // placeholder
 	    return 2; // exit due to error
 	}
@@ -2628,7 +2779,7 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 #else
 
   if( determine_if_offsets )
-    return -1; // 2nd pass not supported yet...
+    return -1; // not required anymore: jump offsets are inserted while tokenizing
 
   if( !cont_script ) {
     ngr_token_mem_run_pos = 0;
@@ -2648,8 +2799,8 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 
     /////////////////////////////////////////////////////////////////////////
     case TOKEN_IF: {
-      if_offset[nesting_level] = init_ngr_token_mem_run_pos;
-      ngr_token_mem_run_pos += 2; // offset not used yet!
+      u16 jump_pos = (u16)ngr_token_mem[ngr_token_mem_run_pos] | ((u16)ngr_token_mem[ngr_token_mem_run_pos+1] << 8);
+      ngr_token_mem_run_pos += 2;
 
       if( nesting_level >= IF_MAX_NESTING_LEVEL ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
@@ -2671,6 +2822,10 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 	    if_state[nesting_level-1] = match ? 1 : 0;
 	  }
 	}
+
+	// skip the non-matching block
+	if( if_state[nesting_level-1] != 1 && jump_pos )
+	  ngr_token_mem_run_pos = jump_pos;
       }
     } break;
 
@@ -2681,7 +2836,8 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
       DEBUG_MSG("[MBNG_FILE_R_Exec] ERROR: tried to execute an unexpected ELSEIF token at mem pos 0x%x!", init_ngr_token_mem_run_pos);
 #endif
       } else {
-	ngr_token_mem_run_pos += 2; // offset not used yet!
+	u16 jump_pos = (u16)ngr_token_mem[ngr_token_mem_run_pos] | ((u16)ngr_token_mem[ngr_token_mem_run_pos+1] << 8);
+	ngr_token_mem_run_pos += 2;
 
 	if( nesting_level >= 2 && if_state[nesting_level-2] != 1 ) { // this ELSIF is executed inside a non-matching block
 	  if_state[nesting_level-1] = 0;
@@ -2695,10 +2851,15 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 	      if_state[nesting_level-1] = match ? 1 : 0;
 	    }
 	  } else {
-	    parseTokenizedCondition(); // dummy
+	    if( !jump_pos )
+	      parseTokenizedCondition(); // dummy
 	    if_state[nesting_level-1] = 2; // IF has been processed
 	  }
 	}
+
+	// skip the non-matching block
+	if( if_state[nesting_level-1] != 1 && jump_pos )
+	  ngr_token_mem_run_pos = jump_pos;
       }
     } break;
 
@@ -2709,7 +2870,8 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 	DEBUG_MSG("[MBNG_FILE_R_Exec] ERROR: tried to execute an unexpected ELSE token at mem pos 0x%x!", init_ngr_token_mem_run_pos);
 #endif
       } else {
-	ngr_token_mem_run_pos += 2; // offset not used yet!
+	u16 jump_pos = (u16)ngr_token_mem[ngr_token_mem_run_pos] | ((u16)ngr_token_mem[ngr_token_mem_run_pos+1] << 8);
+	ngr_token_mem_run_pos += 2;
 
 	if( nesting_level >= 2 && if_state[nesting_level-2] != 1 ) { // this ELSE is executed inside a non-matching block
 	  if_state[nesting_level-1] = 0;
@@ -2720,6 +2882,10 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 	    if_state[nesting_level-1] = 2; // IF has been processed
 	  }
 	}
+
+	// skip the non-matching block
+	if( if_state[nesting_level-1] != 1 && jump_pos )
+	  ngr_token_mem_run_pos = jump_pos;
       }
     } break;
 
@@ -2810,13 +2976,16 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 #define STREAM_MAX_SIZE 256
       u8 stream[STREAM_MAX_SIZE];
 
+      u8 values_valid = 1;
       int i;
       for(i=0; i<stream_size && ngr_token_mem_run_pos < ngr_token_mem_end; ++i) {
 	s32 value = parseTokenizedValue();
+	if( value <= -1000000000 )
+	  values_valid = 0; // e.g. item not found: don't send, like in interpreted mode
 	stream[i] = value;
       }
 
-      if( if_condition_matching ) {
+      if( if_condition_matching && values_valid ) {
 	MUTEX_MIDIOUT_TAKE;
 	sendTokenized(port, event_type, stream, stream_size);
 	MUTEX_MIDIOUT_GIVE;
@@ -2834,13 +3003,16 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
 #define STREAM_MAX_SIZE 256
       u8 stream[STREAM_MAX_SIZE];
 
+      u8 values_valid = 1;
       int i;
       for(i=0; i<stream_size && ngr_token_mem_run_pos < ngr_token_mem_end; ++i) {
 	s32 value = parseTokenizedValue();
+	if( value <= -1000000000 )
+	  values_valid = 0; // e.g. item not found: don't send, like in interpreted mode
 	stream[i] = value;
       }
 
-      if( if_condition_matching ) {
+      if( if_condition_matching && values_valid ) {
 	MUTEX_MIDIOUT_TAKE;
 	sendSeqTokenized(delay, len, port, event_type, stream, stream_size);
 	MUTEX_MIDIOUT_GIVE;
@@ -2866,7 +3038,7 @@ s32 MBNG_FILE_R_Exec(u8 cont_script, u8 determine_if_offsets)
       s32 value = parseTokenizedValue();
       item.value = value;
 
-      if( if_condition_matching ) {
+      if( if_condition_matching && value >= -16384 && value <= 16383 ) {
 	MUTEX_MIDIOUT_TAKE;
 	MBNG_EVENT_ExecMeta(&item);
 	MUTEX_MIDIOUT_GIVE;
@@ -3034,9 +3206,6 @@ s32 MBNG_FILE_R_Read(char *filename, u8 cont_script, u8 tokenize_req)
   if( tokenize_req ) {
     // tokens valid as well
     info->tokenized = 1;
-
-    // run 2nd pass to insert jump offsets after IF/ELSE/ELSEIF
-    MBNG_FILE_R_Exec(0, 1); // cont_script, determine_if_offsets
   }
 #endif
 
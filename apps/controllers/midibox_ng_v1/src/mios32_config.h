@@ -181,6 +181,9 @@ extern char mbng_patch_max72xx_spi_rc_pin;
 // With "spi_midi" enable, the ENC28J60 driver will be disabled and OSC won't be available on board != LPC17 (which has an inbuilt ETH port)
 #define MIOS32_SPI_MIDI_NUM_PORTS 4
 
+// compile the OSC search tree of the osc_server for faster parsing
+#define MIOS32_OSC_COMPILED_LEVELS 8
+
 // map MIDI mutex to UIP task
 // located in app.c to access MIDI IN/OUT mutex from external
 extern void APP_MUTEX_MIDIOUT_Take(void);
@@ -0,0 +1,253 @@
+// $Id$
+/*
+ * Host build of the SD Card read/write check
+ *
+ * Runs the MIOS32_SDCARD driver and the FatFs disk I/O layer against the
+ * SPI based SD Card simulator (sdcard_sim.c), and checks:
+ *   - power-on sequence for SDHC (block addressing) and SDSC (byte addressing)
+ *   - single sector read/write (CMD17/CMD24)
+ *   - multi sector read/write (CMD18 + CMD12, CMD25 + stop token)
+ *   - disk_read/disk_write with count > 1 use a single multi block command
+ *
+ * One line is printed for each test:
+ *   test=<name> card=<SDHC|SDSC> result=<ok|FAILED> spi_bytes=<n>
+ *
+ * The program returns 1 if any test failed
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include <diskio.h>
+
+#include "sdcard_sim.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// max. number of sectors which are transfered by a single test
+#define MAX_SECTORS 32
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8 buffer[MAX_SECTORS*512];
+static u8 card_sdhc;
+static u32 num_failed;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Debug messages of mios32_sdcard.c and diskio.c are print to stdout
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Helper functions
+/////////////////////////////////////////////////////////////////////////////
+static void Result(const char *name, u8 ok)
+{
+  printf("test=%s card=%s result=%s spi_bytes=%u\n",
+	 name, card_sdhc ? "SDHC" : "SDSC", ok ? "ok" : "FAILED",
+	 SDCARD_SIM_StatsGet()->spi_bytes);
+
+  if( !ok )
+    ++num_failed;
+}
+
+// checks the command statistic of the simulator
+static u8 CheckCmds(u32 cmd17, u32 cmd18, u32 cmd12, u32 cmd24, u32 cmd25)
+{
+  sdcard_sim_stats_t *stats = SDCARD_SIM_StatsGet();
+  u8 ok = 1;
+
+  if( stats->cmd[17] != cmd17 || stats->cmd[18] != cmd18 || stats->cmd[12] != cmd12 ||
+      stats->cmd[24] != cmd24 || stats->cmd[25] != cmd25 ) {
+    printf("  unexpected commands: CMD17=%u CMD18=%u CMD12=%u CMD24=%u CMD25=%u\n",
+	   stats->cmd[17], stats->cmd[18], stats->cmd[12], stats->cmd[24], stats->cmd[25]);
+    ok = 0;
+  }
+
+  if( stats->errors ) {
+    printf("  %u protocol errors detected by simulator\n", stats->errors);
+    ok = 0;
+  }
+
+  return ok;
+}
+
+// compares the buffer with the simulated sectors
+static u8 CheckSectors(u32 sector, u32 count)
+{
+  u32 i;
+
+  for(i=0; i<count; ++i) {
+    u8 *sim_sector = SDCARD_SIM_SectorPtrGet(sector + i);
+    if( sim_sector == NULL || memcmp(sim_sector, &buffer[i*512], 512) != 0 ) {
+      printf("  data mismatch in sector %u\n", sector + i);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// fills the buffer with a pattern which differs from the initial sector content
+static void FillBuffer(u32 count, u8 seed)
+{
+  u32 i;
+
+  for(i=0; i<count*512; ++i)
+    buffer[i] = (u8)(i * 13 + seed) ^ 0xa5;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Tests
+/////////////////////////////////////////////////////////////////////////////
+static void TestPowerOn(void)
+{
+  SDCARD_SIM_StatsClear();
+  s32 status = MIOS32_SDCARD_PowerOn();
+  Result("power_on", status >= 0 && MIOS32_SDCARD_CheckAvailable(1) > 0 && SDCARD_SIM_StatsGet()->errors == 0);
+}
+
+static void TestSectorRead(void)
+{
+  SDCARD_SIM_StatsClear();
+  memset(buffer, 0, 512);
+  s32 status = MIOS32_SDCARD_SectorRead(10, buffer);
+  Result("sector_read", status >= 0 && CheckSectors(10, 1) && CheckCmds(1, 0, 0, 0, 0));
+}
+
+static void TestSectorWrite(void)
+{
+  SDCARD_SIM_StatsClear();
+  FillBuffer(1, 1);
+  s32 status = MIOS32_SDCARD_SectorWrite(11, buffer);
+  Result("sector_write", status >= 0 && CheckSectors(11, 1) && CheckCmds(0, 0, 0, 1, 0));
+}
+
+static void TestSectorsRead(u32 sector, u32 count)
+{
+  char name[40];
+  sprintf(name, "sectors_read_%u", count);
+
+  SDCARD_SIM_StatsClear();
+  memset(buffer, 0, count*512);
+  s32 status = MIOS32_SDCARD_SectorsRead(sector, buffer, count);
+  u8 ok = status >= 0 && CheckSectors(sector, count);
+  if( count > 1 )
+    ok = ok && CheckCmds(0, 1, 1, 0, 0);
+  else
+    ok = ok && CheckCmds(1, 0, 0, 0, 0);
+  Result(name, ok);
+}
+
+static void TestSectorsWrite(u32 sector, u32 count)
+{
+  char name[40];
+  sprintf(name, "sectors_write_%u", count);
+
+  SDCARD_SIM_StatsClear();
+  FillBuffer(count, sector);
+  s32 status = MIOS32_SDCARD_SectorsWrite(sector, buffer, count);
+  u8 ok = status >= 0 && CheckSectors(sector, count);
+  if( count > 1 )
+    ok = ok && CheckCmds(0, 0, 0, 0, 1);
+  else
+    ok = ok && CheckCmds(0, 0, 0, 1, 0);
+  Result(name, ok);
+}
+
+static void TestDiskIo(void)
+{
+  // write and read back 16 sectors via FatFs disk I/O layer
+  SDCARD_SIM_StatsClear();
+  FillBuffer(16, 0x33);
+  u8 ok = disk_write(0, buffer, 200, 16) == RES_OK && CheckSectors(200, 16);
+  memset(buffer, 0, 16*512);
+  ok = ok && disk_read(0, buffer, 200, 16) == RES_OK && CheckSectors(200, 16);
+  ok = ok && CheckCmds(0, 1, 1, 0, 1);
+  Result("disk_io_16", ok);
+}
+
+static void TestReadOutOfRange(void)
+{
+  // the last sectors are not available: error has to be reported, and the
+  // card has to accept commands thereafter
+  SDCARD_SIM_StatsClear();
+  s32 status = MIOS32_SDCARD_SectorsRead(SDCARD_SIM_NUM_SECTORS-2, buffer, 4);
+  u8 ok = status < 0;
+  ok = ok && MIOS32_SDCARD_SectorsRead(0, buffer, 2) >= 0 && CheckSectors(0, 2);
+  Result("read_out_of_range", ok && SDCARD_SIM_StatsGet()->errors == 0);
+}
+
+static void TestWriteOutOfRange(void)
+{
+  SDCARD_SIM_StatsClear();
+  FillBuffer(4, 0x77);
+  s32 status = MIOS32_SDCARD_SectorsWrite(SDCARD_SIM_NUM_SECTORS-2, buffer, 4);
+  u8 ok = status < 0 && CheckSectors(SDCARD_SIM_NUM_SECTORS-2, 2);
+  ok = ok && MIOS32_SDCARD_SectorsWrite(2, buffer, 2) >= 0 && CheckSectors(2, 2);
+  Result("write_out_of_range", ok && SDCARD_SIM_StatsGet()->errors == 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  SDCARD_SIM_VerboseSet(argc > 1 && strcmp(argv[1], "-v") == 0);
+
+  for(card_sdhc=0; card_sdhc<2; ++card_sdhc) {
+    SDCARD_SIM_Init(card_sdhc);
+    MIOS32_SDCARD_Init(0);
+
+    TestPowerOn();
+    TestSectorRead();
+    TestSectorWrite();
+    TestSectorsRead(20, 1);
+    TestSectorsRead(20, 2);
+    TestSectorsRead(100, MAX_SECTORS);
+    TestSectorsWrite(40, 1);
+    TestSectorsWrite(40, 2);
+    TestSectorsWrite(300, MAX_SECTORS);
+    TestDiskIo();
+    TestReadOutOfRange();
+    TestWriteOutOfRange();
+  }
+
+  printf("%s: %u test(s) failed\n", num_failed ? "FAILED" : "PASSED", num_failed);
+
+  return num_failed ? 1 : 0;
+}
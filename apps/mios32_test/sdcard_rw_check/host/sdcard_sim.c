@@ -0,0 +1,504 @@
+// $Id$
+/*
+ * SPI based SD Card simulator for the host build
+ *
+ * Replaces the MIOS32_SPI functions which are used by mios32_sdcard.c and
+ * emulates the SPI mode protocol of a SD Card on byte level:
+ *   - commands with R1, R2 (CMD13), R3 (CMD58) and R7 (CMD8) responses
+ *   - power-on sequence of SDv2 cards (CMD0, CMD8, ACMD41, CMD58)
+ *   - single block transfers (CMD17, CMD24)
+ *   - multi block transfers (CMD18 + CMD12, CMD25 + stop token)
+ *   - busy states after write operations and CMD12
+ *
+ * Each byte returned by MIOS32_SPI_TransferByte() is the byte which is shifted
+ * out by the card while the sent byte is received (full duplex).
+ *
+ * Protocol violations (e.g. a command while the card is busy, or a missing
+ * start token) are counted in sdcard_sim_stats_t.errors
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "sdcard_sim.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of bytes between command and response, and before data tokens
+#define NCR_BYTES 1
+#define NAC_BYTES 3
+
+// number of busy bytes after write operations
+#define BUSY_BYTES 4
+
+// number of ACMD41 commands until the card leaves the idle state
+#define INIT_ACMD41_NUM 3
+
+#define OUT_QUEUE_SIZE 1024
+
+typedef enum {
+  SIM_STATE_IDLE,             // waiting for command
+  SIM_STATE_READ_MULTI,       // sending blocks until CMD12 is received
+  SIM_STATE_WRITE_WAIT_TOKEN, // waiting for start token of CMD24
+  SIM_STATE_WRITE_MULTI_WAIT_TOKEN, // waiting for start/stop token of CMD25
+  SIM_STATE_WRITE_DATA,       // receiving data block + CRC
+} sim_state_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u8 sectors[SDCARD_SIM_NUM_SECTORS][512];
+
+static u8 card_sdhc;
+static u8 card_idle;
+static u8 card_acmd;
+static u8 card_acmd41_ctr;
+static u8 card_cs_active;
+static u8 card_verbose;
+
+static sim_state_t state;
+static u8 cmd_buffer[6];
+static u8 cmd_len;
+
+static u32 transfer_sector;
+static u8 transfer_multi;
+static u8 transfer_error;
+static u8 data_buffer[512+2];
+static u16 data_len;
+
+static u8 out_queue[OUT_QUEUE_SIZE];
+static u16 out_head;
+static u16 out_tail;
+
+static sdcard_sim_stats_t stats;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Output queue
+/////////////////////////////////////////////////////////////////////////////
+static void OutClear(void)
+{
+  out_head = out_tail = 0;
+}
+
+static u8 OutEmpty(void)
+{
+  return out_head == out_tail;
+}
+
+static void OutPush(u8 b)
+{
+  u16 next = (out_head + 1) % OUT_QUEUE_SIZE;
+  if( next == out_tail ) {
+    printf("[SDCARD_SIM] ERROR: output queue overrun!\n");
+    ++stats.errors;
+    return;
+  }
+  out_queue[out_head] = b;
+  out_head = next;
+}
+
+static u8 OutPop(void)
+{
+  if( OutEmpty() )
+    return 0xff;
+  u8 b = out_queue[out_tail];
+  out_tail = (out_tail + 1) % OUT_QUEUE_SIZE;
+  return b;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Converts the command address into a sector number
+// returns -1 if the sector doesn't exist
+/////////////////////////////////////////////////////////////////////////////
+static s32 AddressToSector(u32 addr)
+{
+  u32 sector = card_sdhc ? addr : (addr / 512);
+
+  if( (!card_sdhc && (addr % 512)) || sector >= SDCARD_SIM_NUM_SECTORS )
+    return -1;
+
+  return sector;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Queues the next data block of a read operation
+/////////////////////////////////////////////////////////////////////////////
+static void QueueReadBlock(void)
+{
+  int i;
+
+  if( transfer_error )
+    return; // no further blocks until CMD12 is received
+
+  if( transfer_sector >= SDCARD_SIM_NUM_SECTORS ) {
+    // out of range: error token, a multi block read has to be stopped with CMD12
+    for(i=0; i<NAC_BYTES; ++i)
+      OutPush(0xff);
+    OutPush(0x08);
+    transfer_error = 1;
+    return;
+  }
+
+  for(i=0; i<NAC_BYTES; ++i)
+    OutPush(0xff);
+  OutPush(0xfe); // start token
+  for(i=0; i<512; ++i)
+    OutPush(sectors[transfer_sector][i]);
+  OutPush(0xff); // CRC (ignored in SPI mode)
+  OutPush(0xff);
+
+  ++stats.sectors_read;
+  ++transfer_sector;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Executes a received command
+/////////////////////////////////////////////////////////////////////////////
+static void ExecuteCommand(void)
+{
+  u8 cmd = cmd_buffer[0] & 0x3f;
+  u32 addr = ((u32)cmd_buffer[1] << 24) | ((u32)cmd_buffer[2] << 16) | ((u32)cmd_buffer[3] << 8) | (u32)cmd_buffer[4];
+  u8 acmd = card_acmd;
+  int i;
+
+  card_acmd = 0;
+  ++stats.cmd[cmd];
+
+  if( card_verbose )
+    printf("[SDCARD_SIM] %sCMD%d 0x%08x\n", acmd ? "A" : "", cmd, addr);
+
+  if( cmd == 12 ) {
+    // CMD12 aborts a multi block read: the remaining data is discarded,
+    // a stuff byte is sent before the response, the card is busy thereafter
+    if( state != SIM_STATE_READ_MULTI && !transfer_multi ) {
+      printf("[SDCARD_SIM] ERROR: CMD12 without multi block transfer!\n");
+      ++stats.errors;
+    }
+    OutClear();
+    OutPush(0x3c); // stuff byte (undefined value)
+    OutPush(0x00); // R1
+    for(i=0; i<BUSY_BYTES; ++i)
+      OutPush(0x00);
+    state = SIM_STATE_IDLE;
+    transfer_multi = 0;
+    return;
+  }
+
+  if( state == SIM_STATE_READ_MULTI ) {
+    printf("[SDCARD_SIM] ERROR: CMD%d during multi block read!\n", cmd);
+    ++stats.errors;
+    OutClear();
+    state = SIM_STATE_IDLE;
+  }
+
+  for(i=0; i<NCR_BYTES; ++i)
+    OutPush(0xff);
+
+  u8 r1 = card_idle ? 0x01 : 0x00;
+  s32 sector;
+
+  switch( cmd ) {
+  case 0: // GO_IDLE_STATE
+    card_idle = 1;
+    card_acmd41_ctr = 0;
+    OutPush(0x01);
+    break;
+
+  case 8: // SEND_IF_COND: R7
+    OutPush(r1);
+    OutPush(0x00);
+    OutPush(0x00);
+    OutPush(0x01);
+    OutPush(addr & 0xff);
+    break;
+
+  case 55: // APP_CMD
+    card_acmd = 1;
+    OutPush(r1);
+    break;
+
+  case 41: // SEND_OP_COND (ACMD41)
+    if( !acmd ) {
+      OutPush(r1 | 0x04); // illegal command
+      break;
+    }
+    if( ++card_acmd41_ctr >= INIT_ACMD41_NUM )
+      card_idle = 0;
+    OutPush(card_idle ? 0x01 : 0x00);
+    break;
+
+  case 58: // READ_OCR: R3
+    OutPush(r1);
+    OutPush(card_sdhc ? 0xc0 : 0x80);
+    OutPush(0xff);
+    OutPush(0x80);
+    OutPush(0x00);
+    break;
+
+  case 13: // SEND_STATUS: R2
+    OutPush(r1);
+    OutPush(0x00);
+    break;
+
+  case 16: // SET_BLOCKLEN
+    OutPush((addr == 512) ? r1 : (r1 | 0x40));
+    break;
+
+  case 17: // READ_SINGLE_BLOCK
+  case 18: // READ_MULTIPLE_BLOCK
+    if( card_idle || (sector=AddressToSector(addr)) < 0 ) {
+      OutPush(r1 | 0x20); // address error
+      break;
+    }
+    OutPush(r1);
+    transfer_sector = sector;
+    transfer_error = 0;
+    QueueReadBlock();
+    if( cmd == 18 )
+      state = SIM_STATE_READ_MULTI;
+    break;
+
+  case 24: // WRITE_BLOCK
+  case 25: // WRITE_MULTIPLE_BLOCK
+    if( card_idle || (sector=AddressToSector(addr)) < 0 ) {
+      OutPush(r1 | 0x20); // address error
+      break;
+    }
+    OutPush(r1);
+    transfer_sector = sector;
+    transfer_multi = cmd == 25;
+    state = transfer_multi ? SIM_STATE_WRITE_MULTI_WAIT_TOKEN : SIM_STATE_WRITE_WAIT_TOKEN;
+    break;
+
+  default:
+    OutPush(r1 | 0x04); // illegal command
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Handles a byte which has been received by the card
+/////////////////////////////////////////////////////////////////////////////
+static void ReceiveByte(u8 b)
+{
+  int i;
+
+  switch( state ) {
+  case SIM_STATE_WRITE_WAIT_TOKEN:
+  case SIM_STATE_WRITE_MULTI_WAIT_TOKEN:
+    if( b == 0xff )
+      return;
+
+    if( state == SIM_STATE_WRITE_MULTI_WAIT_TOKEN && b == (0x40 | 12) ) {
+      // CMD12 aborts a multi block write after rejected data
+      state = SIM_STATE_IDLE;
+      cmd_buffer[0] = b;
+      cmd_len = 1;
+      return;
+    }
+
+    if( (state == SIM_STATE_WRITE_WAIT_TOKEN && b == 0xfe) ||
+	(state == SIM_STATE_WRITE_MULTI_WAIT_TOKEN && b == 0xfc) ) {
+      data_len = 0;
+      state = SIM_STATE_WRITE_DATA;
+    } else if( state == SIM_STATE_WRITE_MULTI_WAIT_TOKEN && b == 0xfd ) {
+      // stop token: one byte, followed by busy state
+      OutPush(0xff);
+      for(i=0; i<BUSY_BYTES; ++i)
+	OutPush(0x00);
+      state = SIM_STATE_IDLE;
+      transfer_multi = 0;
+    } else {
+      printf("[SDCARD_SIM] ERROR: unexpected token 0x%02x during write operation!\n", b);
+      ++stats.errors;
+      state = SIM_STATE_IDLE;
+    }
+    return;
+
+  case SIM_STATE_WRITE_DATA:
+    data_buffer[data_len++] = b;
+    if( data_len >= (512+2) ) {
+      if( transfer_sector >= SDCARD_SIM_NUM_SECTORS ) {
+	OutPush(0x0d); // data rejected due to write error
+	state = transfer_multi ? SIM_STATE_WRITE_MULTI_WAIT_TOKEN : SIM_STATE_IDLE;
+	return;
+      }
+
+      memcpy(sectors[transfer_sector], data_buffer, 512);
+      ++transfer_sector;
+      ++stats.sectors_written;
+
+      OutPush(0x05); // data accepted
+      for(i=0; i<BUSY_BYTES; ++i)
+	OutPush(0x00);
+
+      state = transfer_multi ? SIM_STATE_WRITE_MULTI_WAIT_TOKEN : SIM_STATE_IDLE;
+    }
+    return;
+
+  default:
+    // command parser (also active during multi block reads to receive CMD12)
+    if( cmd_len == 0 && (b & 0xc0) != 0x40 )
+      return; // no command start
+
+    if( cmd_len == 0 && !OutEmpty() && state != SIM_STATE_READ_MULTI ) {
+      // the card is still sending a response or is busy
+      u8 busy = 0;
+      for(i=out_tail; i!=out_head; i=(i+1)%OUT_QUEUE_SIZE)
+	if( out_queue[i] == 0x00 )
+	  busy = 1;
+      if( busy ) {
+	printf("[SDCARD_SIM] ERROR: command 0x%02x received while card is busy!\n", b);
+	++stats.errors;
+      }
+      OutClear();
+    }
+
+    cmd_buffer[cmd_len++] = b;
+    if( cmd_len >= 6 ) {
+      cmd_len = 0;
+      ExecuteCommand();
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulator functions
+/////////////////////////////////////////////////////////////////////////////
+s32 SDCARD_SIM_Init(u8 sdhc)
+{
+  u32 sector;
+  int i;
+
+  // pattern which depends on the sector number
+  for(sector=0; sector<SDCARD_SIM_NUM_SECTORS; ++sector)
+    for(i=0; i<512; ++i)
+      sectors[sector][i] = (u8)(sector * 7 + i);
+
+  card_sdhc = sdhc;
+  card_idle = 1;
+  card_acmd = 0;
+  card_acmd41_ctr = 0;
+  card_cs_active = 0;
+  state = SIM_STATE_IDLE;
+  cmd_len = 0;
+  OutClear();
+
+  return SDCARD_SIM_StatsClear();
+}
+
+s32 SDCARD_SIM_VerboseSet(u8 verbose)
+{
+  card_verbose = verbose;
+  return 0; // no error
+}
+
+s32 SDCARD_SIM_StatsClear(void)
+{
+  memset(&stats, 0, sizeof(stats));
+  return 0; // no error
+}
+
+sdcard_sim_stats_t *SDCARD_SIM_StatsGet(void)
+{
+  return &stats;
+}
+
+u8 *SDCARD_SIM_SectorPtrGet(u32 sector)
+{
+  return (sector < SDCARD_SIM_NUM_SECTORS) ? sectors[sector] : NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SPI functions used by mios32_sdcard.c
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_IO_Init(u8 spi, mios32_spi_pin_driver_t spi_pin_driver)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_SPI_TransferModeInit(u8 spi, mios32_spi_mode_t spi_mode, mios32_spi_prescaler_t spi_prescaler)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_SPI_RC_PinSet(u8 spi, u8 rc_pin, u8 pin_value)
+{
+  u8 active = pin_value ? 0 : 1;
+
+  if( card_cs_active && !active && state == SIM_STATE_READ_MULTI ) {
+    printf("[SDCARD_SIM] ERROR: chip select deactivated during multi block read!\n");
+    ++stats.errors;
+    OutClear();
+    state = SIM_STATE_IDLE;
+  }
+
+  card_cs_active = active;
+  return 0; // no error
+}
+
+s32 MIOS32_SPI_TransferByte(u8 spi, u8 b)
+{
+  ++stats.spi_bytes;
+
+  if( !card_cs_active )
+    return 0xff; // card not selected
+
+  u8 ret = OutPop();
+  ReceiveByte(b);
+
+  // continue multi block read
+  if( state == SIM_STATE_READ_MULTI && OutEmpty() )
+    QueueReadBlock();
+
+  return ret;
+}
+
+s32 MIOS32_SPI_TransferBlock(u8 spi, u8 *send_buffer, u8 *receive_buffer, u16 len, void *callback)
+{
+  u32 i;
+
+  for(i=0; i<len; ++i) {
+    u8 b = MIOS32_SPI_TransferByte(spi, send_buffer ? send_buffer[i] : 0xff);
+    if( receive_buffer )
+      receive_buffer[i] = b;
+  }
+
+  if( callback )
+    ((void (*)(void))callback)();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Delay: not required
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+  return 0; // no error
+}
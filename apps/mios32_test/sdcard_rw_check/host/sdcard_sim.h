@@ -0,0 +1,51 @@
+// $Id$
+/*
+ * SPI based SD Card simulator for the host build
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _SDCARD_SIM_H
+#define _SDCARD_SIM_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of simulated sectors (512 bytes each)
+#ifndef SDCARD_SIM_NUM_SECTORS
+#define SDCARD_SIM_NUM_SECTORS 1024
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32 cmd[64];        // number of received commands (index: command number)
+  u32 sectors_read;   // number of transfered sectors
+  u32 sectors_written;
+  u32 spi_bytes;      // number of transfered SPI bytes
+  u32 errors;         // protocol violations detected by the simulator
+} sdcard_sim_stats_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 SDCARD_SIM_Init(u8 sdhc);
+extern s32 SDCARD_SIM_VerboseSet(u8 verbose);
+extern s32 SDCARD_SIM_StatsClear(void);
+extern sdcard_sim_stats_t *SDCARD_SIM_StatsGet(void);
+extern u8 *SDCARD_SIM_SectorPtrGet(u32 sector);
+
+
+#endif /* _SDCARD_SIM_H */
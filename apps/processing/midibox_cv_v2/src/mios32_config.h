@@ -91,6 +91,9 @@
 // enable ESP8266 support for OSC Server/Client
 #define OSC_SERVER_ESP8266_ENABLED 1
 
+// compile the OSC search tree of the osc_server for faster parsing
+#define MIOS32_OSC_COMPILED_LEVELS 8
+
 // support direct send command
 #define ESP8266_TERMINAL_DIRECT_SEND_CMD 1
 
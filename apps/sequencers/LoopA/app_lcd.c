@@ -495,6 +495,33 @@ s32 APP_LCD_GCursorSet(u16 x, u16 y)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Selects a window for the following data bytes and enables RAM write
+// The display RAM address wraps within the window, so that only the
+// (column_end-column_start+1)*2*(row_end-row_start+1) bytes of the window
+// have to be sent.
+// IN: <column_start>, <column_end>: 0..63, one column = 4 pixels = 2 bytes
+//     <row_start>, <row_end>: 0..63
+// OUT: returns < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_WindowSet(u8 column_start, u8 column_end, u8 row_start, u8 row_end)
+{
+  s32 error = 0;
+
+  error |= APP_LCD_Cmd(0x15); // Column
+  error |= APP_LCD_Data(column_start + 0x1c);
+  error |= APP_LCD_Data(column_end + 0x1c);
+
+  error |= APP_LCD_Cmd(0x75); // Row
+  error |= APP_LCD_Data(row_start);
+  error |= APP_LCD_Data(row_end);
+
+  error |= APP_LCD_Cmd(0x5c); // Write RAM
+
+  return error;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Initializes a single special character
 // IN: character number (0-7) in <num>, pattern in <table[8]>
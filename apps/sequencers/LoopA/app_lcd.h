@@ -53,6 +53,7 @@ extern s32 APP_LCD_Cmd(u8 cmd);
 extern s32 APP_LCD_Clear(void);
 extern s32 APP_LCD_CursorSet(u16 column, u16 line);
 extern s32 APP_LCD_GCursorSet(u16 x, u16 y);
+extern s32 APP_LCD_WindowSet(u8 column_start, u8 column_end, u8 row_start, u8 row_end);
 extern s32 APP_LCD_SpecialCharInit(u8 num, u8 table[8]);
 extern s32 APP_LCD_BColourSet(u32 rgb);
 extern s32 APP_LCD_FColourSet(u32 rgb);
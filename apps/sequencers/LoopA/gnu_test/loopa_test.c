@@ -0,0 +1,372 @@
+// $Id$
+/*
+ * Host test of the LoopA clip player
+ *
+ * loopa.c is compiled against stubs of the UI, screen, setup and MIDI
+ * output layers. loopaSeqTick() is called for each bpm tick like by the
+ * sequencer task, and the played notes are compared with a reference
+ * which checks all notes of the active clips with quantizeTransform() at
+ * each tick (the algorithm which was used before the play index).
+ *
+ * The test cases mute and unmute tracks in the middle of a clip, so that
+ * the play cursor has to advance while a track is muted, and combine this
+ * with beatloop jumps and clip restarts.
+ *
+ * Usage: loopa_test [-v]
+ *   -v: print each played note
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "commonIncludes.h"
+#include "loopa.h"
+#include "ui.h"
+#include "screen.h"
+#include "voxelspace.h"
+#include "setup.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Played notes
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_PLAYED 4096
+
+typedef struct {
+  u32 tick;
+  u8 chn;
+  u8 note;
+} played_note_t;
+
+static played_note_t played[MAX_PLAYED];
+static int num_played;
+
+static played_note_t expected[MAX_PLAYED];
+static int num_expected;
+
+static int verbose;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs of the MIOS32 and LoopA layers which are not part of the test
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  if( package.type == NoteOn && package.velocity > 0 && package.chn < TRACKS ) {
+    if( num_played < MAX_PLAYED ) {
+      played[num_played].tick = tick_;
+      played[num_played].chn = package.chn;
+      played[num_played].note = package.note;
+      ++num_played;
+    }
+    if( verbose )
+      printf("  %5u: track %d note %3d\n", (unsigned)tick_, package.chn + 1, package.note);
+  }
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...) { return 0; }
+s32 MIOS32_DOUT_PinSet(u32 pin, u32 value) { return 0; }
+s32 MIDI_ROUTER_SendMIDIClockEvent(u8 evnt0, u32 bpm_tick) { return 0; }
+
+static u16 bpm_ppqn = 384;
+s32 SEQ_BPM_Init(u32 mode) { return 0; }
+s32 SEQ_BPM_PPQN_Set(u16 ppqn) { bpm_ppqn = ppqn; return 0; }
+s32 SEQ_BPM_PPQN_Get(void) { return bpm_ppqn; }
+s32 SEQ_BPM_Set(float bpm) { return 0; }
+s32 SEQ_BPM_TickSet(u32 tick) { return 0; }
+s32 SEQ_BPM_IsRunning(void) { return 1; }
+s32 SEQ_BPM_Stop(void) { return 0; }
+s32 SEQ_BPM_ChkReqStop(void) { return 0; }
+s32 SEQ_BPM_ChkReqCont(void) { return 0; }
+s32 SEQ_BPM_ChkReqStart(void) { return 0; }
+s32 SEQ_BPM_ChkReqSongPos(u16 *new_song_pos) { return 0; }
+s32 SEQ_BPM_ChkReqClk(u32 *bpm_tick_ptr) { return 0; }
+
+s32 FILE_ReadOpen(file_t* file, char *filepath) { return -1; }
+s32 FILE_ReadClose(file_t *file) { return 0; }
+s32 FILE_ReadBuffer(u8 *buffer, u32 len) { return -1; }
+s32 FILE_WriteOpen(char *filepath, u8 create_dir) { return -1; }
+s32 FILE_WriteClose(void) { return 0; }
+s32 FILE_WriteBuffer(u8 *buffer, u32 len) { return -1; }
+
+xSemaphoreHandle xSDCardSemaphore;
+xSemaphoreHandle xDigitalOutSemaphore;
+void vPortEnterCritical(void) {}
+void vPortExitCritical(void) {}
+signed portBASE_TYPE xQueueTakeMutexRecursive(xQueueHandle xMutex, portTickType xBlockTime) { return pdTRUE; }
+signed portBASE_TYPE xQueueGiveMutexRecursive(xQueueHandle xMutex) { return pdTRUE; }
+
+s32 LoopA_MIDI_OUT_Callback_MIDI_SendPackage_Set(void *_callback_midi_send_package) { return 0; }
+s32 LoopA_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package,
+                        loopa_midi_out_event_type_t event_type, u32 ticksUntilPlayback, u32 len) { return 0; }
+s32 LoopA_MIDI_OUT_FlushQueue(void) { return 0; }
+void LoopA_MIDI_OUT_Tick() {}
+
+const u8 HW_LED_SCENE_1 = 0;
+const u8 HW_LED_SCENE_2 = 0;
+const u8 HW_LED_SCENE_3 = 0;
+const u8 HW_LED_SCENE_4 = 0;
+const u8 HW_LED_SCENE_5 = 0;
+const u8 HW_LED_SCENE_6 = 0;
+
+u8 configChangesToBeWritten_;
+s8 gcBeatLEDsEnabled_;
+enum FollowtrackTypeEnum gcFollowtrackType_;
+enum FootswitchActionEnum gcFootswitch1Action_;
+enum FootswitchActionEnum gcFootswitch2Action_;
+s16 gcLastUsedSessionNumber_;
+mios32_midi_port_t gcMetronomePort_;
+u8 gcMetronomeChannel_;
+u8 gcMetronomeNoteM_;
+u8 gcMetronomeNoteB_;
+
+u8 isInstrument(s8 loopaPortNumber) { return 0; }
+mios32_midi_port_t getMIOSPortNumberFromLoopAPortNumber(s8 loopaPortNumber) { return loopaPortNumber; }
+u8 getInstrumentChannelNumberFromLoopAPortNumber(s8 loopaPortNumber) { return 0; }
+void readSetup() {}
+
+void calcField(void) {}
+void clipClear() {}
+void jumpToNextScene() {}
+void jumpToPreviousScene() {}
+void switchToNextTrack() {}
+void switchToPreviousTrack() {}
+s32 seqArmButton(void) { return 0; }
+s32 seqPlayStopButton(void) { return 0; }
+void setActivePage(enum LoopAPage page) {}
+void setActiveScene(u8 sceneNumber) { activeScene_ = sceneNumber; }
+void setActiveTrack(u8 trackNumber) { activeTrack_ = trackNumber; }
+void updateBeatLEDsAndClipPositions(u32 bpm_tick) {}
+void updateLiveLEDs() {}
+void updateSwitchLED(u8 number, u8 newState) {}
+void screenFormattedFlashMessage(const char* format, ...) {}
+void screenSetClipSelected(u8 clipNumber) {}
+void screenSetSceneChangeInTicks(u8 ticks) {}
+void screenShowLoopaLogo(u8 showLogo) {}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test setup
+/////////////////////////////////////////////////////////////////////////////
+
+// random clip content of a track (notes at random ticks, some of them sharing a tick)
+static void fillClip(u8 track, u16 steps, int num_notes)
+{
+  int i;
+
+  clipSteps_[track][activeScene_] = steps;
+  clipNotesSize_[track][activeScene_] = num_notes;
+  for(i=0; i<num_notes; ++i) {
+    NoteData *n = &clipNotes_[track][activeScene_][i];
+    n->tick = (i % 5 == 4) ? clipNotes_[track][activeScene_][i-1].tick : (rand() % stepToTick(steps));
+    n->length = 1 + (rand() % 48);
+    n->note = 36 + (rand() % 48);
+    n->velocity = 1 + (rand() % 127);
+  }
+
+  invalidateClipIndex(track);
+}
+
+static void resetTest(void)
+{
+  u8 track;
+
+  seqInit();
+  SEQ_BPM_PPQN_Set(TICKS_PER_QUARTERNOTE);
+  for(track=0; track<TRACKS; ++track) {
+    trackMidiOutChannel_[track] = track;
+    trackLiveTranspose_[track] = 0;
+  }
+
+  tick_ = 0xffffffff; // so that bpm tick 0 isn't taken as already encountered
+  num_played = 0;
+  num_expected = 0;
+}
+
+// the notes which have to be played at the current tick: the former loop over all clip notes
+static void addExpected(u32 bpmTick)
+{
+  u8 track;
+
+  for(track=0; track<TRACKS; ++track) {
+    if( trackMute_[track] )
+      continue;
+
+    u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
+    u16 i;
+    for(i=0; i<clipNotesSize_[track][activeScene_]; ++i) {
+      NoteData *n = &clipNotes_[track][activeScene_][i];
+      if( n->length > 0 && n->velocity > 0 && quantizeTransform(track, i) == clipNoteTime ) {
+        if( num_expected < MAX_PLAYED ) {
+          expected[num_expected].tick = bpmTick;
+          expected[num_expected].chn = track;
+          expected[num_expected].note = n->note;
+          ++num_expected;
+        }
+      }
+    }
+  }
+}
+
+static int compareNotes(const void *a, const void *b)
+{
+  const played_note_t *pa = (const played_note_t *)a;
+  const played_note_t *pb = (const played_note_t *)b;
+
+  if( pa->tick != pb->tick )
+    return (pa->tick < pb->tick) ? -1 : 1;
+  if( pa->chn != pb->chn )
+    return pa->chn - pb->chn;
+  return pa->note - pb->note;
+}
+
+// plays <num_ticks> bpm ticks; mute_tick/unmute_tick: (un)mute <mute_track> before this tick (-1: never)
+static void play(u32 num_ticks, u8 mute_track, s32 mute_tick, s32 unmute_tick)
+{
+  u32 bpmTick = 0;
+  u32 t;
+
+  for(t=0; t<num_ticks; ++t) {
+    if( t == mute_tick )
+      trackMute_[mute_track] = 1;
+    if( t == unmute_tick )
+      trackMute_[mute_track] = 0;
+
+    loopaSeqTick(bpmTick);
+
+    // a beatloop jump changes tick_ - the sequencer continues from there
+    addExpected(tick_);
+    bpmTick = tick_ + 1;
+  }
+}
+
+static int checkResult(const char *name)
+{
+  int i;
+
+  // notes of the same tick may be played in any track/note order
+  qsort(played, num_played, sizeof(played_note_t), compareNotes);
+  qsort(expected, num_expected, sizeof(played_note_t), compareNotes);
+
+  int failed = (num_played != num_expected);
+  for(i=0; !failed && i<num_played; ++i)
+    if( compareNotes(&played[i], &expected[i]) != 0 )
+      failed = 1;
+
+  printf("%-40s %4d notes played, %4d expected: %s\n", name, num_played, num_expected, failed ? "FAILED" : "ok");
+
+  if( failed ) {
+    for(i=0; i<num_played || i<num_expected; ++i) {
+      if( i >= num_played || i >= num_expected || compareNotes(&played[i], &expected[i]) != 0 ) {
+        if( i < num_expected )
+          printf("  first difference: expected tick %u track %d note %d\n", (unsigned)expected[i].tick, expected[i].chn + 1, expected[i].note);
+        if( i < num_played )
+          printf("  first difference: played   tick %u track %d note %d\n", (unsigned)played[i].tick, played[i].chn + 1, played[i].note);
+        break;
+      }
+    }
+  }
+
+  return failed;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test cases
+/////////////////////////////////////////////////////////////////////////////
+static int testPlay(void)
+{
+  resetTest();
+  fillClip(0, 16, 40);
+  fillClip(1, 12, 30);
+  play(3*stepToTick(16), 0, -1, -1);
+  return checkResult("play");
+}
+
+static int testMuteAdvanceUnmute(void)
+{
+  u32 clipTicks = stepToTick(16);
+
+  resetTest();
+  fillClip(0, 16, 40);
+  fillClip(1, 16, 20);
+
+  // muted after a quarter, unmuted after three quarters of the second loop:
+  // the cursor has to advance over the notes in between, the rest of the loop has to be played
+  play(3*clipTicks, 0, clipTicks + clipTicks/4, clipTicks + 3*clipTicks/4);
+  return checkResult("mute/advance/unmute");
+}
+
+static int testUnmuteAtNote(void)
+{
+  u32 clipTicks = stepToTick(16);
+
+  resetTest();
+  fillClip(0, 16, 40);
+
+  // unmute exactly at the tick of a note
+  u32 noteTick = quantizeTransform(0, 7);
+  play(3*clipTicks, 0, clipTicks/8, clipTicks + noteTick);
+  return checkResult("mute/unmute at a note tick");
+}
+
+static int testMuteOverLoopStart(void)
+{
+  u32 clipTicks = stepToTick(16);
+
+  resetTest();
+  fillClip(0, 16, 40);
+
+  // muted at the end of the first loop, unmuted in the middle of the second one
+  play(3*clipTicks, 0, clipTicks - clipTicks/8, clipTicks + clipTicks/2);
+  return checkResult("mute over the loop start");
+}
+
+static int testMuteWithBeatloop(void)
+{
+  u32 clipTicks = stepToTick(16);
+
+  resetTest();
+  fillClip(0, 16, 40);
+  fillClip(1, 8, 20);
+  liveBeatLoop_ = 7; // jumps forward and back while playing
+
+  play(4*clipTicks, 1, clipTicks/3, 2*clipTicks + clipTicks/5);
+  return checkResult("mute/unmute with beatloop jumps");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int failed = 0;
+
+  verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+  srand(1);
+
+  failed += testPlay();
+  failed += testMuteAdvanceUnmute();
+  failed += testUnmuteAtNote();
+  failed += testMuteOverLoopStart();
+  failed += testMuteWithBeatloop();
+
+  if( failed ) {
+    printf("%d test(s) failed\n", failed);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
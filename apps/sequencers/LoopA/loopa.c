@@ -93,6 +93,32 @@ s8 liveTransposeRequested_ = 0;       // If != active liveTranspose_, perform a
 u16 clipActiveNote_[TRACKS][SCENES];  // currently active edited note number, when in noteroll editor
 s8 valueEncoderAccel_ = 0;            // 1: value encoder pushed (while turning) -> accellerate data inputs
 
+// --- Clip play index (not on disk) ---
+typedef struct
+{
+   u16 tick;                          // transformed (stretched, scrolled, quantized) note tick
+   u16 note;                          // note number in clipNotes_
+} ClipIndexEntry;
+
+typedef struct
+{
+   ClipIndexEntry entries[MAXNOTES];  // playable notes of the active clip, sorted by transformed tick
+   u16 size;                          // number of entries
+   u16 cursor;                        // next entry to be played
+   u32 nextTick;                      // clip tick expected at the next bpm tick, otherwise the cursor will be repositioned
+   u8 valid;                          // 0: notes have been changed, rebuild the index before playing
+
+   // clip settings the index has been built for (rebuilt automatically if changed)
+   u8 scene;
+   u16 steps;
+   u32 quantize;
+   s16 scroll;
+   u8 stretch;
+   s8 swing;
+} ClipIndex;
+
+static ClipIndex clipIndex_[TRACKS];  // play index of the clip in the active scene of each track
+
 // =================================================================================================
 
 
@@ -176,10 +202,12 @@ u32 quantize(u32 tick, u32 quantizeMeasure, s8 swingPercent, u32 clipLengthInTic
 
 
 /**
- * Transform (stretch, scroll, probabilities/random) and then quantize/apply swing to a note in a clip
+ * Transform (stretch, scroll) and then quantize/apply swing to a note in a clip
+ * The result only depends on the clip settings, not on the probability clip fx
+ * @return transformed tick or -1, if the note is outside of the clip
  *
  */
-s32 quantizeTransform(u8 clip, u16 noteNumber)
+s32 transformTick(u8 clip, u16 noteNumber)
 {
    // Idea: scroll first, and modulo-map to trackstart/end boundaries
    //       scale afterwards
@@ -198,24 +226,51 @@ s32 quantizeTransform(u8 clip, u16 noteNumber)
    if (tick >= clipLengthInTicks)
       return -1;
 
-   // if clip fx probabilities/randomization is on, only consider notes that pass the random test
+   // scroll
+   tick += clipScroll_[clip][activeScene_] * TICKS_PER_STEP;
+
+   while (tick < 0)
+      tick += clipLengthInTicks;
+
+   tick %= clipLengthInTicks;
+
+   return quantize(tick, quantizeMeasure, clipFxSwing_[clip][activeScene_], clipLengthInTicks);
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * If clip fx probabilities/randomization is on, check if the note passes the random test
+ * @return 1, if the note should be dropped
+ *
+ */
+u8 isDroppedByProbability(u8 clip, u16 noteNumber)
+{
    s8 randomMinimum = clipFxProbability_[clip][activeScene_];
    if (randomMinimum)
    {
       srand(((millisecondsSinceStartup_ >> 5U) << 8U) + noteNumber);  // Newly rerandomize every ~ 32ms
       if ((rand() % 100) < randomMinimum)
-         return -1;
+         return 1;
    }
 
-   // scroll
-   tick += clipScroll_[clip][activeScene_] * TICKS_PER_STEP;
+   return 0;
+}
+// -------------------------------------------------------------------------------------------------
 
-   while (tick < 0)
-      tick += clipLengthInTicks;
 
-   tick %= clipLengthInTicks;
+/**
+ * Transform (stretch, scroll, probabilities/random) and then quantize/apply swing to a note in a clip
+ *
+ */
+s32 quantizeTransform(u8 clip, u16 noteNumber)
+{
+   s32 tick = transformTick(clip, noteNumber);
 
-   return quantize(tick, quantizeMeasure, clipFxSwing_[clip][activeScene_], clipLengthInTicks);
+   if (tick < 0 || isDroppedByProbability(clip, noteNumber))
+      return -1;
+
+   return tick;
 }
 // -------------------------------------------------------------------------------------------------
 
@@ -230,6 +285,135 @@ u32 getClipLengthInTicks(u8 clip)
 // -------------------------------------------------------------------------------------------------
 
 
+/**
+ * Notes of the clip in the active scene of a track have been changed (recorded, edited, cleared, loaded...),
+ * rebuild the play index before the next note is played
+ *
+ */
+void invalidateClipIndex(u8 clip)
+{
+   clipIndex_[clip].valid = 0;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Rebuild the play index of the clip in the active scene, if notes or transformation settings have changed
+ *
+ */
+static void updateClipIndex(u8 clip)
+{
+   ClipIndex *index = &clipIndex_[clip];
+
+   if (index->valid &&
+       index->scene == activeScene_ &&
+       index->steps == clipSteps_[clip][activeScene_] &&
+       index->quantize == clipFxQuantize_[clip][activeScene_] &&
+       index->scroll == clipScroll_[clip][activeScene_] &&
+       index->stretch == clipStretch_[clip][activeScene_] &&
+       index->swing == clipFxSwing_[clip][activeScene_])
+      return; // index still up to date
+
+   index->size = 0;
+
+   u16 i;
+   for (i = 0; i < clipNotesSize_[clip][activeScene_]; i++)
+   {
+      if (clipNotes_[clip][activeScene_][i].length > 0) // not still being held/recorded!
+      {
+         s32 tick = transformTick(clip, i);
+         if (tick >= 0 && tick < getClipLengthInTicks(clip))
+         {
+            // insertion sort by tick, notes with the same tick stay in clip note order
+            // (recorded clips are almost sorted already)
+            u16 pos = index->size++;
+            while (pos > 0 && index->entries[pos - 1].tick > tick)
+            {
+               index->entries[pos] = index->entries[pos - 1];
+               pos--;
+            }
+
+            index->entries[pos].tick = tick;
+            index->entries[pos].note = i;
+         }
+      }
+   }
+
+   index->scene = activeScene_;
+   index->steps = clipSteps_[clip][activeScene_];
+   index->quantize = clipFxQuantize_[clip][activeScene_];
+   index->scroll = clipScroll_[clip][activeScene_];
+   index->stretch = clipStretch_[clip][activeScene_];
+   index->swing = clipFxSwing_[clip][activeScene_];
+   index->valid = 1;
+   index->nextTick = 0xFFFFFFFF; // reposition cursor
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Position the play cursor of a clip to the first note at or after the given clip tick
+ *
+ */
+static void seekClipIndex(u8 clip, u32 clipNoteTime)
+{
+   ClipIndex *index = &clipIndex_[clip];
+   u16 lo = 0;
+   u16 hi = index->size;
+
+   while (lo < hi)
+   {
+      u16 mid = (lo + hi) >> 1U;
+      if (index->entries[mid].tick < clipNoteTime)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   index->cursor = lo;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Get the next note of a clip, that is due at the given clip tick
+ * The cursor advances linearly while the clip is playing, it is repositioned on jumps (beatloop, song position)
+ * and after the index has been rebuilt
+ * @return note number or -1, if no (more) notes are due
+ *
+ */
+static s32 nextDueClipNote(u8 clip, u32 clipNoteTime)
+{
+   ClipIndex *index = &clipIndex_[clip];
+
+   if (index->cursor < index->size && index->entries[index->cursor].tick == clipNoteTime)
+      return index->entries[index->cursor++].note;
+
+   return -1;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Prepare playing a clip at the given clip tick: rebuild the index if required, reposition the cursor on jumps
+ *
+ */
+static void startClipTick(u8 clip, u32 clipNoteTime)
+{
+   ClipIndex *index = &clipIndex_[clip];
+
+   updateClipIndex(clip);
+
+   if (clipNoteTime != index->nextTick || clipNoteTime == 0) // jumped or restarted clip
+      seekClipIndex(clip, clipNoteTime);
+
+   index->nextTick = clipNoteTime + 1;
+   if (index->nextTick >= getClipLengthInTicks(clip))
+      index->nextTick = 0;
+}
+// -------------------------------------------------------------------------------------------------
+
+
 /**
  * Request (or cancel) a synced mute/unmute toggle
  *
@@ -563,6 +747,10 @@ void loadSession(u16 sessionNumber)
 
    MUTEX_SDCARD_GIVE;
 
+   u8 track;
+   for (track = 0; track < TRACKS; track++)
+      invalidateClipIndex(track);
+
    setActiveScene(activeScene_);
    screenSetClipSelected(activeTrack_);
    updateLiveLEDs();
@@ -767,16 +955,18 @@ s32 loopaSeqTick(u32 bpmTick)
       {
          s8 liveTransposeSemi = trackLiveTranspose_[track] ? liveTransposeSemitones_[liveTranspose_ + 7] : 0;
 
+         u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
+         startClipTick(track, clipNoteTime);
+
          if (!trackMute_[track])
          {
-            u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
-            u16 i;
+            s32 i;
 
-            for (i = 0; i < clipNotesSize_[track][activeScene_]; i++) // i: clip notes iterator
+            while ((i = nextDueClipNote(track, clipNoteTime)) >= 0) // i: clip notes due at this tick
             {
                if (clipNotes_[track][activeScene_][i].length > 0) // not still being held/recorded!
                {
-                  if (quantizeTransform(track, i) == clipNoteTime)
+                  if (!isDroppedByProbability(track, i))
                   {
                      // If cursor erase is activated on the active track, set velocity of this note to zero, erase it, don't play it
                      if (cursorEraseActive_ && track == activeTrack_)
@@ -823,20 +1013,25 @@ s32 loopaSeqTick(u32 bpmTick)
          {
             if (cursorEraseActive_)
             {
-               u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
-               u16 i;
+               s32 i;
 
-               for (i = 0; i < clipNotesSize_[track][activeScene_]; i++) // i: clip notes iterator
+               while ((i = nextDueClipNote(track, clipNoteTime)) >= 0) // i: clip notes due at this tick
                {
                   if (clipNotes_[track][activeScene_][i].length > 0) // not still being held/recorded!
                   {
-                     if (quantizeTransform(track, i) == clipNoteTime)
+                     if (!isDroppedByProbability(track, i))
                      {
                         clipNotes_[track][activeScene_][i].velocity = 0;
                      }
                   }
                }
             }
+            else
+            {
+               // advance the play cursor anyway, so that it points to the next due note when the track is unmuted
+               while (nextDueClipNote(track, clipNoteTime) >= 0)
+                  ;
+            }
          }
       }
 
@@ -987,6 +1182,7 @@ s32 seqInit()
       trackMidiForward_[i] = 0;    // Disable note forwarding/live play on this track by default
       trackLiveTranspose_[i] = 1;  // Enable live transposition of notes on this track by default
       trackMuteToggleRequested_[i] = 0;
+      invalidateClipIndex(i);
 
       for (j = 0; j < SCENES; j++)
       {
@@ -1092,6 +1288,8 @@ void loopaRecord(mios32_midi_port_t port, mios32_midi_package_t midi_package)
                // screenFormattedFlashMessage("Note %d on - ptr %d", midi_package.note, clipNoteNumber);
                if (!reusedDeletedNote)
                   clipNotesSize_[activeTrack_][activeScene_]++;
+
+               invalidateClipIndex(activeTrack_);
             }
             else if (midi_package.type == NoteOff || (midi_package.type == NoteOn && midi_package.velocity == 0))
             {
@@ -1109,6 +1307,7 @@ void loopaRecord(mios32_midi_port_t port, mios32_midi_package_t midi_package)
 
                   // screenFormattedFlashMessage("o %d - p %d - l %d", midi_package.note, notePtr, len);
                   clipNotes_[activeTrack_][activeScene_][notePtr].length = len;
+                  invalidateClipIndex(activeTrack_);
                }
                notePtrsOn_[midi_package.note] = -1;
             }
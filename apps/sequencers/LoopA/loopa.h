@@ -126,12 +126,21 @@ u32 boundTickToClipSteps(u32 tick, u8 clip);
 // Quantize a tick time event
 u32 quantize(u32 tick, u32 quantizeMeasure, s8 swingPercent, u32 clipLengthInTicks);
 
+// Transform (stretch, scroll) and then quantize/apply swing a note in a clip, without probabilities/random
+s32 transformTick(u8 clip, u16 noteNumber);
+
+// Check, if a note in a clip is dropped by the probability clip fx
+u8 isDroppedByProbability(u8 clip, u16 noteNumber);
+
 // Transform (stretch, scroll, probabilities/random) and then quantize/apply swing a note in a clip
 s32 quantizeTransform(u8 clip, u16 noteNumber);
 
 // Get the clip length in ticks
 u32 getClipLengthInTicks(u8 clip);
 
+// Notes of the clip in the active scene have been changed, rebuild the play index before playing
+void invalidateClipIndex(u8 clip);
+
 // Request (or cancel) a synced mute/unmute toggle
 void toggleMute(u8 clipNumber);
 
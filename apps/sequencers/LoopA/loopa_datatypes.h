@@ -1,3 +1,8 @@
+#ifdef MIOS32_FAMILY_POSIX
+// host build: the 32bit types of the POSIX family, "long" has 64 bits there
+#include <mios32_datatypes.h>
+#else
+
 typedef signed long  s32;
 typedef signed short s16;
 typedef signed char  s8;
@@ -39,3 +44,5 @@ typedef volatile unsigned char  const vuc8;   /* Read Only */
 #define U32_MAX    ((u32)4294967295uL)
 #define S32_MAX    ((s32)2147483647)
 #define S32_MIN    ((s32)-2147483648)
+
+#endif
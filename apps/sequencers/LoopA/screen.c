@@ -20,6 +20,8 @@
 // --- globals ---
 
 u8 screen[64][128];             // Screen buffer [y][x]
+static u8 screenOLED_[64][128]; // Content of the OLED RAM (last pushed screen buffer after inversion/flash) [y][x]
+static u8 screenOLEDValid_ = 0; // 0: OLED RAM content is unknown (e.g. after startup), push the whole screen buffer
 
 u8 screenShowLoopaLogo_;
 u8 screenShowShift_ = 0;
@@ -1727,6 +1729,116 @@ int isScreensaverActive()
 // ----------------------------------------------------------------------------------------
 
 
+/**
+ * Push a window of the OLED RAM copy to the OLED
+ *
+ */
+static void flushWindow(u8 startRow, u8 endRow, u8 startColumn, u8 endColumn)
+{
+   APP_LCD_WindowSet(startColumn, endColumn, startRow, endRow);
+
+   u8 x, y;
+   for (y = startRow; y <= endRow; y++)
+      for (x = startColumn * 2; x <= endColumn * 2 + 1; x++)
+         APP_LCD_Data(screenOLED_[y][x]);
+}
+// ----------------------------------------------------------------------------------------
+
+
+/**
+ * Push the changed parts of the screen buffer to the OLED and clear the screen buffer
+ *
+ * The OLED is only addressed in windows of changed pixels, consecutive lines with the same changed
+ * columns are merged into one window. Unchanged frames are not sent at all.
+ *
+ */
+static void flushScreen(u8 flash)
+{
+   s16 windowStartRow = -1; // currently collected window, -1: no window
+   u8 windowEndRow = 0;
+   u8 windowStartColumn = 0;
+   u8 windowEndColumn = 0;
+   u8 flushed = 0;
+
+   u8 i, j;
+   for (j = 0; j < 64; j++)
+   {
+      s16 firstChanged = -1;
+      u8 lastChanged = 0;
+
+      for (i = 0; i < 128; i++)
+      {
+         // two pixels at once...
+         u8 out = screen[j][i];
+
+         if (gcInvertOLED_)
+         {
+            // Screen inversion routine for white frontpanels :)
+            u8 first = out >> 4U;
+            u8 second = out % 16;
+
+            first = 15 - first;
+            second = 15 - second;
+            out = (first << 4U) + second;
+         }
+
+         if (flash && out == 0)
+            out = flash; // normally raise dark level slightly, but more intensively after 16 16th notes during flash
+
+         if (out != screenOLED_[j][i] || !screenOLEDValid_)
+         {
+            screenOLED_[j][i] = out;
+
+            if (firstChanged < 0)
+               firstChanged = i;
+            lastChanged = i;
+         }
+      }
+
+      memset(screen[j], 0, 128); // clear pixels for next frame
+
+      // one OLED column contains 4 pixels (two bytes)
+      u8 startColumn = firstChanged >> 1U;
+      u8 endColumn = lastChanged >> 1U;
+
+      // line can be merged with the current window?
+      if (firstChanged >= 0 && windowStartRow >= 0 && windowEndRow == j - 1 &&
+          windowStartColumn == startColumn && windowEndColumn == endColumn)
+      {
+         windowEndRow = j;
+         continue;
+      }
+
+      if (windowStartRow >= 0)
+      {
+         flushWindow(windowStartRow, windowEndRow, windowStartColumn, windowEndColumn);
+         windowStartRow = -1;
+         flushed = 1;
+      }
+
+      if (firstChanged >= 0)
+      {
+         windowStartRow = windowEndRow = j;
+         windowStartColumn = startColumn;
+         windowEndColumn = endColumn;
+      }
+   }
+
+   if (windowStartRow >= 0)
+   {
+      flushWindow(windowStartRow, windowEndRow, windowStartColumn, windowEndColumn);
+      flushed = 1;
+   }
+
+   // restore the full screen window, which is expected by APP_LCD_Clear() and testScreen()
+   if (flushed)
+      APP_LCD_WindowSet(0, 63, 0, 63);
+
+   screenOLEDValid_ = 1;
+}
+// ----------------------------------------------------------------------------------------
+
+
 /**
  * Display the current screen buffer (once per frame, called in app.c scheduler)
  *
@@ -1734,8 +1846,6 @@ int isScreensaverActive()
 static u32 frameCounter_ = 0;
 void display()
 {
-   u8 i, j;
-
    frameCounter_++;
 
    if (isScreensaverActive() && hw_enabled != HARDWARE_LOOPA_TESTMODE)
@@ -1947,42 +2057,8 @@ void display()
       screenshotRequested_ = 0;
    }
 
-   // Push screen buffer to screen
-   for (j = 0; j < 64; j++)
-   {
-      APP_LCD_Cmd(0x15);
-      APP_LCD_Data(0+0x1c);
-
-      APP_LCD_Cmd(0x75);
-      APP_LCD_Data(j);
-
-      APP_LCD_Cmd(0x5c);
-
-      u8 bgcol = 0;
-      for (i = 0; i < 128; i++)
-      {
-         // two pixels at once...
-         u8 out = screen[j][i];
-
-         if (gcInvertOLED_)
-         {
-            // Screen inversion routine for white frontpanels :)
-            u8 first = out >> 4U;
-            u8 second = out % 16;
-
-            first = 15 - first;
-            second = 15 - second;
-            out = (first << 4U) + second;
-         }
-
-         if (flash && out == 0)
-            APP_LCD_Data(flash); // normally raise dark level slightly, but more intensively after 16 16th notes during flash
-         else
-            APP_LCD_Data(out);
-
-         screen[j][i] = bgcol; // clear written pixels
-      }
-   }
+   // Push changed parts of the screen buffer to screen
+   flushScreen(flash);
 
    if (flash)
       oledBeatFlashState_ = 0;
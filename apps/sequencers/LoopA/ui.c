@@ -863,6 +863,7 @@ void clipZoom()
 void clipClear()
 {
    clipNotesSize_[activeTrack_][activeScene_] = 0;
+   invalidateClipIndex(activeTrack_);
 
    u8 i;
    for (i=0; i<128; i++)
@@ -925,6 +926,7 @@ void clipFreeze()
 
    optimizedAmount = clipNotesSize_[activeTrack_][activeScene_] - optimizedNotes;
    clipNotesSize_[activeTrack_][activeScene_] = optimizedNotes;
+   invalidateClipIndex(activeTrack_);
 
    screenFormattedFlashMessage("%d notes optimized", optimizedAmount);
 }
@@ -1536,6 +1538,7 @@ void loopaButtonPressed(s32 pin)
                clipStretch_[activeTrack_][activeScene_] = copiedClipStretch_;
                memcpy(clipNotes_[activeTrack_][activeScene_], copiedClipNotes_, sizeof(copiedClipNotes_));
                clipNotesSize_[activeTrack_][activeScene_] = copiedClipNotesSize_;
+               invalidateClipIndex(activeTrack_);
                screenFormattedFlashMessage("pasted clip from buffer");
             }
             else
@@ -2267,6 +2270,7 @@ void loopaEncoderTurned(s32 encoder, s32 incrementer)
                newTick = (newTick / TICKS_PER_STEP) * TICKS_PER_STEP;
 
                clipNotes_[activeTrack_][activeScene_][activeNote].tick = (u16) newTick;
+               invalidateClipIndex(activeTrack_);
             }
          } else if (command_ == COMMAND_NOTE_KEY)
          {
@@ -2305,6 +2309,7 @@ void loopaEncoderTurned(s32 encoder, s32 incrementer)
                   newLength = 1536;
 
                clipNotes_[activeTrack_][activeScene_][activeNote].length = (u16) newLength;
+               invalidateClipIndex(activeTrack_);
             }
          } else if (command_ == COMMAND_NOTE_VELOCITY)
          {
@@ -578,6 +578,18 @@ s32 SEQ_FILE_GC_Read(void)
 		OSC_CLIENT_TransferModeSet(con, value);
 	      }
 	    }
+	  } else if( strcmp(parameter, "OSC_BundleMode") == 0 ) {
+	    if( value > OSC_SERVER_NUM_CONNECTIONS ) {
+	      DEBUG_MSG("[SEQ_FILE_GC] ERROR invalid connection number for parameter '%s'\n", parameter);
+	    } else {
+	      u8 con = value;
+	      word = strtok_r(NULL, separators, &brkt);
+	      if( (value=get_dec(word)) < 0 || value > 1 ) {
+		DEBUG_MSG("[SEQ_FILE_GC] ERROR invalid bundle mode for parameter '%s'\n", parameter);
+	      } else {
+		OSC_CLIENT_BundleModeSet(con, value);
+	      }
+	    }
 #endif
 #endif
 	  } else {
@@ -904,6 +916,9 @@ static s32 SEQ_FILE_GC_Write_Hlp(u8 write_to_file)
 
     sprintf(line_buffer, "OSC_TransferMode %d %d\n", con, OSC_CLIENT_TransferModeGet(con));
     FLUSH_BUFFER;
+
+    sprintf(line_buffer, "OSC_BundleMode %d %d\n", con, OSC_CLIENT_BundleModeGet(con));
+    FLUSH_BUFFER;
   }
 #endif
 #endif
@@ -78,7 +78,7 @@ extern void APP_SendDebugMessage(char *format, ...);
 #ifdef MBSEQV4P
 # define MIOS32_HEAP_SIZE 20*1024
 #else
-# define MIOS32_HEAP_SIZE 13*1024
+# define MIOS32_HEAP_SIZE 15*1024
 #endif
 
 // for LPC17: simplify allocation of large arrays
@@ -129,7 +129,7 @@ extern void APP_SendDebugMessage(char *format, ...);
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 
 // max number of scheduled events which will allocate memory
-// each event allocates 12 bytes
+// each event allocates 24 bytes
 // MAX_EVENTS must be a power of two! (e.g. 64, 128, 256, 512, ...)
 #define SEQ_MIDI_OUT_MAX_EVENTS 256
 
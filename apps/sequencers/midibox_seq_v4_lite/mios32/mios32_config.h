@@ -55,7 +55,7 @@ extern void APP_SendDebugMessage(char *format, ...);
 // Sequencer could crash with hardfault on a buffer overrun
 
 // reserved memory for FreeRTOS pvPortMalloc function
-#define MIOS32_HEAP_SIZE 13*1024
+#define MIOS32_HEAP_SIZE 15*1024
 
 // for LPC17: simplify alloction of large arrays
 #if defined(MIOS32_FAMILY_LPC17xx)
@@ -91,7 +91,7 @@ extern void APP_SendDebugMessage(char *format, ...);
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 
 // max number of scheduled events which will allocate memory
-// each event allocates 12 bytes
+// each event allocates 24 bytes
 // MAX_EVENTS must be a power of two! (e.g. 64, 128, 256, 512, ...)
 #define SEQ_MIDI_OUT_MAX_EVENTS 256
 
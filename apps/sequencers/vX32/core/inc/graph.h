@@ -24,7 +24,11 @@ stay tuned for UI prototyping courtesy of lucem!
 #endif
 
 #ifndef MAX_INDEGREE                                                            // number of patch cables going IN to any module
-#define MAX_INDEGREE 0xfe                                                       // Maximum 254, They're dynamically allocated
+#define MAX_INDEGREE 0xfe                                                       // Maximum 254
+#endif
+
+#ifndef MAX_EDGES                                                               // number of patch cables in the whole rack
+#define MAX_EDGES 0x80                                                          // Maximum 254. They're statically allocated, so that patching doesn't need the heap
 #endif
 
 
@@ -72,6 +76,15 @@ typedef struct {
 } outbuffer_t;
 
 
+typedef struct {                                                                // type for an entry of the execution plan
+    void (*msgxlate) (unsigned char tail_nodeID, unsigned char tail_port
+                    , unsigned char head_nodeID, unsigned char head_port);      // translator copied from the edge, so it needn't be looked up while ticking
+    unsigned char tailport;                                                     // port we're going from (offset into node[].ports)
+    unsigned char headnodeID;                                                   // node we're going to
+    unsigned char headport;                                                     // port we're going to (offset into node[].ports)
+} planedge_t;
+
+
 typedef union {
     struct {
         unsigned all: 8;
@@ -79,6 +92,7 @@ typedef union {
     struct {
         unsigned deleting: 1;
         unsigned tickseen: 1;
+        unsigned topovisited: 1;                                                // used by the topological sort to mark nodes it has already seen
     };
 } nodestatus_t;
 
@@ -96,6 +110,10 @@ typedef struct {
     unsigned char outbuffer_size;                                               // size in bytes of each of those buffers (eg mios package type is 5, for: port, status, channel, note number, velocity)
     unsigned char outbuffer_req;                                                // counter of how many buffers should be sent, and are filled and ready to go (eg 2 would send only two of your 3 midi notes as per the above examples))
     
+    unsigned char topoindex;                                                    // position of this node in topoList[]. DEAD_NODEID if it's not sorted
+    unsigned char planedge;                                                     // index of the first outward edge of this node in edgePlan[]
+    unsigned char planedge_count;                                               // number of outward edges of this node in edgePlan[]
+    
     struct edge_t *edgelist;                                                    // linked list of outward edges (patch cables going from here to elsewhere)
     struct edge_t *edgelist_in;                                                 // linked list of inward edges (patch cables coming from elsewhere to here)
     
@@ -108,18 +126,15 @@ typedef struct {
 } node_t;
 
 
-typedef struct nodelist_t {                                                     // linked list for node IDs
-    unsigned char nodeID;                                                       // this node ID (the array element in nodes[]
-    struct nodelist_t *next;                                                    // pointer to the next
-} nodelist_t;
-
-
-
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
 /////////////////////////////////////////////////////////////////////////////
 
-extern nodelist_t *topoListHead;                                                // list of topologically sorted nodeIDs
+extern unsigned char topoList[MAX_NODES];                                       // array of topologically sorted nodeIDs
+
+extern unsigned char topo_Count;                                                // count of nodes in topoList
+
+extern planedge_t edgePlan[MAX_EDGES];                                          // outward edges of all nodes, grouped by node in topological order
 
 extern node_t node[MAX_NODES];                                                  // array of sructs to hold node/module info
 
@@ -188,8 +203,15 @@ void (*Edge_Get_Xlator(unsigned char tail_nodeID, unsigned char tail_port
 
 extern unsigned char TopoSort(void);                                            // does a topological sort of all active nodes
 
+extern unsigned char TopoSort_Insert(unsigned char tail_nodeID
+                                    , unsigned char head_nodeID);               // fixes the topological order for a new edge, fails on a cycle
+
+extern void TopoSort_Remove(unsigned char nodeID);                              // removes a node from the topological order
+
 void TopoList_Clear(void);                                                      // trashes the topo sort list
 
+extern void TopoPlan_Build(void);                                               // rebuilds edgePlan[] after the edges or their order have changed
+
 
 
 #endif /* _GRAPH_H */
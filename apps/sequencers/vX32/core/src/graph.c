@@ -38,7 +38,19 @@ stay tuned for UI prototyping courtesy of lucem!
 
 node_t node[MAX_NODES];                                                         // array of sructs to hold node/module info
 
-nodelist_t *topoListHead;                                                       // list of topologically sorted nodeIDs
+unsigned char topoList[MAX_NODES];                                              // array of topologically sorted nodeIDs
+
+unsigned char topo_Count;                                                       // count of nodes in topoList
+
+planedge_t edgePlan[MAX_EDGES];                                                 // outward edges of all nodes, grouped by node in topological order
+
+edge_t edgePool[MAX_EDGES];                                                     // storage for all edges
+
+edge_t *edgeFreeList;                                                           // linked list of unused edges in edgePool
+
+unsigned char topoStack[MAX_NODES];                                             // work arrays for TopoSort_Insert()
+unsigned char topoFwd[MAX_NODES];
+unsigned char topoBwd[MAX_NODES];
 
 unsigned char node_Count;                                                       // count of active nodes
 
@@ -53,6 +65,12 @@ unsigned char NodeID_Gen(void);
 
 unsigned char NodeID_Free(unsigned char nodeID);                                // mark this node ID available
 
+edge_t *Edge_Alloc(void);                                                       // takes an edge from the pool
+
+void Edge_Free(edge_t *edge);                                                   // returns an edge to the pool
+
+void TopoSort_ByIndex(unsigned char *nodelist, unsigned char count);           // sorts a list of node IDs by their topoindex
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -85,11 +103,19 @@ void Graph_Init(void) {
         node[n].privvars = NULL;
         node[n].edgelist = NULL;
         node[n].edgelist_in = NULL;
+        node[n].topoindex = DEAD_NODEID;
+        node[n].planedge = 0;
+        node[n].planedge_count = 0;
         
     }
     
-    topoListHead = NULL;                                                        // make topo list not exist yet
+    topo_Count = 0;                                                             // make topo list not exist yet
     
+    edgeFreeList = NULL;
+    for (n = 0; n < MAX_EDGES; n++) {                                           // put all edges into the free list
+        edgePool[n].next = edgeFreeList;
+        edgeFreeList = &edgePool[n];
+    }
     
 }
 
@@ -106,7 +132,7 @@ unsigned char Node_Add(unsigned char moduletype) {
         DEBUG_MSG("[vX][node] Adding new node with module type %d\n", moduletype);
 #endif
 
-    nodelist_t *topoinsert;
+    unsigned char n;
     unsigned char newnodeID;
     if (node_Count < MAX_NODES-1) {                                             // handle max nodes
         if (moduletype < MAX_MODULETYPES) {                                     // make sure the moduletype is legal
@@ -118,10 +144,14 @@ unsigned char Node_Add(unsigned char moduletype) {
 #if vX_DEBUG_VERBOSE_LEVEL >= 3
         DEBUG_MSG("[vX] Initing graph for new node\n");
 #endif
-                topoinsert = topoListHead;                                      // save the topolist root
-                topoListHead = pvPortMalloc(sizeof(nodelist_t));                // replace the topolist root with new space
-                topoListHead->next = topoinsert;                                // restore the old root to the next pointer
-                topoListHead->nodeID = newnodeID;                               // and insert the new node at the root
+                for (n = topo_Count; n > 0; n--) {                              // make room at the root of the topolist
+                    topoList[n] = topoList[n-1];
+                    node[(topoList[n])].topoindex = n;
+                }
+                topoList[0] = newnodeID;                                        // and insert the new node at the root
+                node[newnodeID].topoindex = 0;
+                node[newnodeID].planedge = 0;                                   // it has no edges yet, so the plan stays valid
+                topo_Count++;
                 Mod_Init_Graph(newnodeID, moduletype);                          // initialise the module hosted by this node
                 node[newnodeID].process_req++;
                 Mod_PreProcess(newnodeID);                                      // if it's sorted ok, process from here down
@@ -257,7 +287,7 @@ unsigned char Node_Del(unsigned char delnodeID) {
                 while (edgepointer != NULL) {                                   // for the current pointer
                     prevedge = edgepointer;                                     // save the current edge
                     edgepointer = edgepointer->head_next;                       // step to the next edge
-                    returnval += Edge_Del(prevedge, DONT_TOPOSORT);             // delete the previous edge without doing a TopoSort
+                    returnval += Edge_Del(prevedge, DONT_TOPOSORT);             // delete the previous edge without rebuilding the plan
                     
                 }
                 
@@ -271,7 +301,7 @@ unsigned char Node_Del(unsigned char delnodeID) {
                 while (edgepointer != NULL) {                                   // until weve done this to the last edge
                     prevedge = edgepointer;                                     // save the current edge
                     edgepointer = edgepointer->next;                            // step to the next edge
-                    returnval += Edge_Del(prevedge, DONT_TOPOSORT);             // delete the previous edge without doing a TopoSort
+                    returnval += Edge_Del(prevedge, DONT_TOPOSORT);             // delete the previous edge without rebuilding the plan
                 }
                 
             }
@@ -279,6 +309,7 @@ unsigned char Node_Del(unsigned char delnodeID) {
 #if vX_DEBUG_VERBOSE_LEVEL >= 2
         DEBUG_MSG("[vX] Freeing node ID\n");
 #endif
+            TopoSort_Remove(delnodeID);                                         // take the node out of the topo list, the order of the others stays valid
             if (NodeID_Free(delnodeID) != DEAD_NODEID) {                        // free the node id
                 Mod_UnInit_Graph(delnodeID);                                    // uninit the module
             } else {
@@ -288,7 +319,7 @@ unsigned char Node_Del(unsigned char delnodeID) {
                 returnval = 9;                                                  // freeing the nodeID failed
             }
             
-            returnval += TopoSort();                                            // catch up with the TopoSort we skipped and return error if it fails
+            TopoPlan_Build();                                                   // catch up with the plan rebuilds we skipped
             Mod_PreProcess(DEAD_NODEID);                                        // and preprocess
             
         } else {
@@ -501,8 +532,39 @@ edge_t *Edge_Add(unsigned char tail_nodeID, unsigned char tail_port, unsigned ch
                 if ((tail_port < mod_Ports[(node[tail_nodeID].moduletype)]) 
                 && (head_port < mod_Ports[(node[head_nodeID].moduletype)])) {   // if the ports are valid
                     
-                    edge_t *newedge = pvPortMalloc(sizeof(edge_t));             // malloc a new edge_t, store pointer in temp var
-                    edge_t *edgepointer = node[tail_nodeID].edgelist;           // load up the edge list header
+                    void (*msgxlate) (unsigned char tail_nodeID, unsigned char tail_port
+                                    , unsigned char head_nodeID, unsigned char head_port);
+                    edge_t *edgepointer;
+                    
+                    msgxlate = Edge_Get_Xlator(tail_nodeID, tail_port, 
+                                               head_nodeID, head_port);
+                    if (msgxlate == NULL) {
+#if vX_DEBUG_VERBOSE_LEVEL >= 1
+        DEBUG_MSG("[vX][edge] Edge add failed, cannot be translated\n");
+#endif
+                        return NULL;                                            // if this edge can't be translated, don't add it
+                    }
+                    
+                    
+                    newedge = Edge_Alloc();                                     // take a new edge_t from the pool
+                    if (newedge == NULL) {
+#if vX_DEBUG_VERBOSE_LEVEL >= 1
+        DEBUG_MSG("[vX][edge] Edge add failed, no free edges\n");
+#endif
+                        return NULL;                                            // all MAX_EDGES are in use
+                    }
+                    
+                    
+                    if (TopoSort_Insert(tail_nodeID, head_nodeID) != 0) {       // topo search will barf on a cycle
+#if vX_DEBUG_VERBOSE_LEVEL >= 1
+        DEBUG_MSG("[vX][edge] Topo sort failed, edge would create a cycle\n");
+#endif
+#if vX_DEBUG_VERBOSE_LEVEL >= 9
+        DEBUG_MSG("[vX][edge] Singular matrix, fuck you! (coder humour, sorry)\n");
+#endif
+                        Edge_Free(newedge);                                     // give the edge back, the order hasn't been touched
+                        return NULL;                                            // nILS - "when the user creates a cycle just pop up a message saying "Singular matrix. Fuck you."" ...LOL!
+                    }
                     
 #if vX_DEBUG_VERBOSE_LEVEL >= 2
         DEBUG_MSG("[vX] Inserting edge into tail node edge list\n");
@@ -538,47 +600,21 @@ edge_t *Edge_Add(unsigned char tail_nodeID, unsigned char tail_port, unsigned ch
                     newedge->headport = head_port;
                     newedge->next = NULL;
                     newedge->head_next = NULL;
-                    newedge->msgxlate = Edge_Get_Xlator(tail_nodeID, tail_port, 
-                                                        head_nodeID, head_port);
+                    newedge->msgxlate = msgxlate;
                     
                     (node[head_nodeID].indegree)++;                             // increment the indegree of the head node
                     
                     
-                    if (newedge->msgxlate == NULL) {
-#if vX_DEBUG_VERBOSE_LEVEL >= 1
-        DEBUG_MSG("[vX][edge] Edge add failed, cannot be translated\n");
-#endif
-                        Edge_Del(newedge, DONT_TOPOSORT);                       // if this edge can't be translated, delete it
-                        return NULL;
-                    }
-                    
-                    
                     Mod_TickPriority(head_nodeID);                              // fix downstreamticks
                     
+                    TopoPlan_Build();                                           // put the new edge into the execution plan
                     
-                    if (TopoSort() != 0) {                                      // topo search will barf on a cycle
-#if vX_DEBUG_VERBOSE_LEVEL >= 1
-        DEBUG_MSG("[vX][edge] Topo sort failed, deleting edge\n");
-#endif
-#if vX_DEBUG_VERBOSE_LEVEL >= 9
-        DEBUG_MSG("[vX][edge] Singular matrix, fuck you! (coder humour, sorry)\n");
-#endif
-                        if (Edge_Del(newedge, DO_TOPOSORT) != 0) {              // if it does delete the culprit and try again.
-#if vX_DEBUG_VERBOSE_LEVEL >= 1
-        DEBUG_MSG("[vX][edge] Topo sort failed again, this should never happen\n");
-#endif
-                            return NULL;                                        // if it doesn't sort cleanly like before... something has gone very wrong
-                        }
-                        
-                        return NULL;                                            // nILS - "when the user creates a cycle just pop up a message saying "Singular matrix. Fuck you."" ...LOL!
-                    } else {
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
         DEBUG_MSG("[vX][edge] Edge added successfully, marking nodes for preprocessing\n");
 #endif
-                        node[tail_nodeID].process_req++;
-                        Mod_PreProcess(tail_nodeID);                            // if it's sorted ok, process from here down
-                        return newedge;                                         // and return the pointer to the new edge
-                    }
+                    node[tail_nodeID].process_req++;
+                    Mod_PreProcess(tail_nodeID);                                // if it's sorted ok, process from here down
+                    return newedge;                                             // and return the pointer to the new edge
                     
                 } else {
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
@@ -618,9 +654,10 @@ edge_t *Edge_Add(unsigned char tail_nodeID, unsigned char tail_port, unsigned ch
 
 /////////////////////////////////////////////////////////////////////////////
 // Deleted an edge
-// in: pointer to the edge, flag whether to topo sort or not. 
+// in: pointer to the edge, flag whether to rebuild the plan or not. 
 //   usually the dosort flag should be 1,
-//   if it's not you must do the topo sort manually
+//   if it's not you must call TopoPlan_Build() manually
+//   (the topological order stays valid when an edge is removed)
 // out: error code, 0 is success
 /////////////////////////////////////////////////////////////////////////////
 
@@ -681,25 +718,25 @@ unsigned char Edge_Del(edge_t *deledge, unsigned char dosort) {
                 Mod_DeadPort((deledge->headnodeID), (deledge->headport));       // fill the head port with a dead value
                 
                 (node[(deledge->headnodeID)].indegree)--;                       // decrement the head node's indegree
-                vPortFree(deledge);                                             // delete the edge
+                Edge_Free(deledge);                                             // delete the edge
                 
                 
                 Mod_TickPriority(tailnodeID);                                   // fix downstreamticks
                 
                 if (dosort > 0) {
-                    return TopoSort();                                          // redo the TopoSort if signalled to
-                    Mod_PreProcess(tailnodeID);                                 // and preprocess
+                    TopoPlan_Build();                                           // take the edge out of the plan if signalled to
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
-        DEBUG_MSG("[vX][edge] Delete successful, topo sort and preprocess done\n");
+        DEBUG_MSG("[vX][edge] Delete successful, plan rebuilt\n");
 #endif
                 } else {
-                    return 0;                                                   // otherwise just return successful
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
-        DEBUG_MSG("[vX][edge] Delete successful, topo sort and preprocess required\n");
+        DEBUG_MSG("[vX][edge] Delete successful, plan rebuild required\n");
 #endif
                     
                 }
                 
+                return 0;                                                       // return successful
+                
                 
                 
             } else {
@@ -864,8 +901,39 @@ void (*Edge_Get_Xlator(unsigned char tail_nodeID, unsigned char tail_port
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Take an edge from the pool
+// needs to be returned again using Edge_Free()
+// out: pointer to the edge, NULL if all edges are in use
+/////////////////////////////////////////////////////////////////////////////
+
+edge_t *Edge_Alloc(void) {
+    edge_t *newedge = edgeFreeList;
+    if (newedge != NULL) {
+        edgeFreeList = newedge->next;                                           // unlink the first free edge
+    }
+    
+    return newedge;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Return an edge to the pool
+// in: pointer to the edge, as taken by Edge_Alloc()
+/////////////////////////////////////////////////////////////////////////////
+
+void Edge_Free(edge_t *edge) {
+    edge->next = edgeFreeList;                                                  // put it at the front of the free list
+    edgeFreeList = edge;
+}
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Topological sort
+// sorts all nodes from scratch, TopoSort_Insert() keeps the order
+// up to date when edges are added, so this is normally not required
 // out: error code. 0 is good.
 /////////////////////////////////////////////////////////////////////////////
 
@@ -874,17 +942,10 @@ unsigned char TopoSort(void) {
     unsigned char returnval = 0;
     unsigned char test_node_Count = 0;
     unsigned char sorted_node_Count = 0;
-    unsigned char indegreezero_count = 0;
-    
-    nodelist_t *indegreezerohead = NULL;                                        // create a node list for nodes with indegree 0
-    nodelist_t *indegreezerotail = NULL;                                        // prep the list
-    nodelist_t *indegreezero = indegreezerohead;
+    unsigned char visit_node_Count = 0;
     
     edge_t *edgepointer;
     
-    nodelist_t *topolist;
-    nodelist_t *topolisttail = NULL;
-    
     TopoList_Clear();
     
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
@@ -901,13 +962,7 @@ unsigned char TopoSort(void) {
 #if vX_DEBUG_VERBOSE_LEVEL >= 3
         DEBUG_MSG("[vX] It is a root node\n");
 #endif
-                    indegreezero = indegreezerohead;
-                    indegreezerohead = pvPortMalloc(sizeof(nodelist_t));        // create a node list for nodes with indegree 0
-                    if (indegreezero_count == 0) 
-                    indegreezerotail = indegreezerohead;                        // and set the tail of the list to that entry. well use that later
-                    indegreezerohead->nodeID = n;
-                    indegreezerohead->next = indegreezero;
-                    indegreezero_count++;
+                    topoList[sorted_node_Count++] = n;                          // the topo list itself is the queue of nodes with indegree 0
                 }
                 
                 node[n].indegree_uv = node[n].indegree;                         // set the unvisited indegree to match the real indegree
@@ -919,44 +974,30 @@ unsigned char TopoSort(void) {
         }
         
 #if vX_DEBUG_VERBOSE_LEVEL >= 2
-        DEBUG_MSG("[vX] Scanned all nodes. Total count %d, Root node count %d\n", test_node_Count, indegreezero_count);
+        DEBUG_MSG("[vX] Scanned all nodes. Total count %d, Root node count %d\n", test_node_Count, sorted_node_Count);
 #endif
         
         if (test_node_Count == node_Count) {                                    // and if it matches the expected node count
-            while (indegreezerohead != NULL) {                                  // while there's anything in indegreezero list
-                topolist = pvPortMalloc(sizeof(nodelist_t));
-                if (sorted_node_Count == 0) {
-                    topoListHead = topolist;
-                } else {
-                    topolisttail->next = topolist;
-                }
-                
-                topolist->nodeID = indegreezerohead->nodeID;                    // copy this node out of indegreezero into topolist 
-                topolist->next = NULL;                                          // prepare the topo list pointer for the next node to be sorted
-                topolisttail = topolist;
-                sorted_node_Count++;                                            // count the sorted nodes
+            while (visit_node_Count < sorted_node_Count) {                      // while there's anything in the queue
+                n = topoList[visit_node_Count];
+                node[n].topoindex = visit_node_Count++;                         // this node is sorted now
                 
 #if vX_DEBUG_VERBOSE_LEVEL >= 3
-        DEBUG_MSG("[vX] Added node %d to list\n", indegreezerohead->nodeID);
+        DEBUG_MSG("[vX] Added node %d to list\n", n);
 #endif
                 
-                edgepointer = node[(indegreezerohead->nodeID)].edgelist;        // load up the first edge for this node
+                edgepointer = node[n].edgelist;                                 // load up the first edge for this node
                 while (edgepointer != NULL) {                                   // for each outward edge on this node
                     if (--(node[(edgepointer->headnodeID)].indegree_uv) == 0) { // visit the headnode, and if this is the last inward edge
-                        indegreezerotail->next = 
-                                    pvPortMalloc(sizeof(nodelist_t));           // add a new entry to the tail end of the indegreezero list
-                        indegreezerotail = indegreezerotail->next;              // fix the pointer to the tail end of the indegreezero list
-                        indegreezerotail->nodeID = edgepointer->headnodeID;     // add node id to the tail end of the indegreezero list
-                        indegreezerotail->next = NULL;                          // init the new entry
-                        
+                        topoList[sorted_node_Count++] = edgepointer->headnodeID;// add it to the tail end of the queue
                     }
                     edgepointer = edgepointer->next;
                 }
-                indegreezero = indegreezerohead;                                // backup the pointer before we...
-                indegreezerohead = indegreezerohead->next;                      // then restore the pointer to the new head which cantains the next node with unvisited inward edges
-                vPortFree(indegreezero);                                        // remove this node from the head of indegreezero
+                
             }
             
+            topo_Count = sorted_node_Count;
+            
 #if vX_DEBUG_VERBOSE_LEVEL >= 2
         DEBUG_MSG("[vX] Sorted %d nodes\n", sorted_node_Count);
 #endif
@@ -969,6 +1010,8 @@ unsigned char TopoSort(void) {
             
                 TopoList_Clear();                                               // mark this topo list dead
                 returnval = 4;                                                  // they weren't all sorted so there's a cycle 
+            } else {
+                TopoPlan_Build();                                               // sorted ok, so rebuild the plan in the new order
             }
             
         } else {
@@ -998,24 +1041,216 @@ unsigned char TopoSort(void) {
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Incremental topological sort for a new edge
+// call this before the edge is added. If the tail node is already sorted
+// in front of the head node there's nothing to do. Otherwise only the nodes
+// between both positions are searched: the ones reachable from the head and
+// the ones which reach the tail swap their places, keeping their own order.
+// The rest of the list isn't touched.
+// in: tail node ID, head node ID of the new edge
+// out: error code. 0 is good, 4 if the edge would create a cycle
+/////////////////////////////////////////////////////////////////////////////
+
+unsigned char TopoSort_Insert(unsigned char tail_nodeID, unsigned char head_nodeID) {
+    unsigned char lowerbound = node[head_nodeID].topoindex;
+    unsigned char upperbound = node[tail_nodeID].topoindex;
+    unsigned char stack_count = 0;
+    unsigned char fwd_count = 0;
+    unsigned char bwd_count = 0;
+    unsigned char f, b, n;
+    unsigned char thisnodeID;
+    edge_t *edgepointer;
+    
+    if ((lowerbound >= topo_Count) || (upperbound >= topo_Count)) {
+#if vX_DEBUG_VERBOSE_LEVEL >= 1
+        DEBUG_MSG("[vX][topo] Insert failed, node is not sorted\n");
+#endif
+        return 2;                                                               // handle nodes which aren't in the list
+    }
+    
+    if (lowerbound > upperbound) return 0;                                      // already in the right order
+    
+#if vX_DEBUG_VERBOSE_LEVEL >= 2
+        DEBUG_MSG("[vX][topo] Reordering positions %d to %d\n", lowerbound, upperbound);
+#endif
+    
+    topoStack[stack_count++] = head_nodeID;                                     // search downstream from the head node
+    node[head_nodeID].status.topovisited = 1;
+    while (stack_count > 0) {
+        thisnodeID = topoStack[--stack_count];
+        topoFwd[fwd_count++] = thisnodeID;
+        edgepointer = node[thisnodeID].edgelist;
+        while (edgepointer != NULL) {                                           // for each outward edge
+            n = edgepointer->headnodeID;
+            if (n == tail_nodeID) {                                             // if we get back to the tail node, it's a cycle
+                for (f = 0; f < fwd_count; f++) 
+                    node[(topoFwd[f])].status.topovisited = 0;                  // so clean up the marks
+                while (stack_count > 0) 
+                    node[(topoStack[--stack_count])].status.topovisited = 0;
+#if vX_DEBUG_VERBOSE_LEVEL >= 2
+        DEBUG_MSG("[vX][topo] Insert failed, cycle found\n");
+#endif
+                return 4;
+            }
+            
+            if ((node[n].status.topovisited == 0) && 
+                (node[n].topoindex < upperbound)) {                             // nodes behind the tail node can stay where they are
+                node[n].status.topovisited = 1;
+                topoStack[stack_count++] = n;
+            }
+            
+            edgepointer = edgepointer->next;
+        }
+        
+    }
+    
+    topoStack[stack_count++] = tail_nodeID;                                     // search upstream from the tail node
+    node[tail_nodeID].status.topovisited = 1;
+    while (stack_count > 0) {
+        thisnodeID = topoStack[--stack_count];
+        topoBwd[bwd_count++] = thisnodeID;
+        edgepointer = node[thisnodeID].edgelist_in;
+        while (edgepointer != NULL) {                                           // for each inward edge
+            n = edgepointer->tailnodeID;
+            if ((node[n].status.topovisited == 0) && 
+                (node[n].topoindex > lowerbound)) {                             // nodes in front of the head node can stay where they are
+                node[n].status.topovisited = 1;
+                topoStack[stack_count++] = n;
+            }
+            
+            edgepointer = edgepointer->head_next;
+        }
+        
+    }
+    
+    TopoSort_ByIndex(topoFwd, fwd_count);                                       // keep the order within both groups
+    TopoSort_ByIndex(topoBwd, bwd_count);
+    
+    f = 0;                                                                      // collect the positions of both groups in ascending order
+    b = 0;
+    for (n = 0; n < (fwd_count + bwd_count); n++) {
+        if ((b >= bwd_count) || 
+            ((f < fwd_count) && (node[(topoFwd[f])].topoindex < node[(topoBwd[b])].topoindex))) {
+            topoStack[n] = node[(topoFwd[f++])].topoindex;
+        } else {
+            topoStack[n] = node[(topoBwd[b++])].topoindex;
+        }
+        
+    }
+    
+    for (n = 0; n < bwd_count; n++) {                                           // the upstream group takes the first positions
+        thisnodeID = topoBwd[n];
+        node[thisnodeID].topoindex = topoStack[n];
+        node[thisnodeID].status.topovisited = 0;
+        topoList[(topoStack[n])] = thisnodeID;
+    }
+    
+    for (n = 0; n < fwd_count; n++) {                                           // and the downstream group the rest
+        thisnodeID = topoFwd[n];
+        node[thisnodeID].topoindex = topoStack[bwd_count + n];
+        node[thisnodeID].status.topovisited = 0;
+        topoList[(topoStack[bwd_count + n])] = thisnodeID;
+    }
+    
+    return 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sort a list of node IDs by their position in the topo list
+// in: pointer to the list, count of node IDs in the list
+/////////////////////////////////////////////////////////////////////////////
+
+void TopoSort_ByIndex(unsigned char *nodelist, unsigned char count) {
+    unsigned char i, j;
+    unsigned char thisnodeID;
+    for (i = 1; i < count; i++) {                                               // insertion sort, the lists are short
+        thisnodeID = nodelist[i];
+        for (j = i; (j > 0) && (node[(nodelist[j-1])].topoindex > node[thisnodeID].topoindex); j--) {
+            nodelist[j] = nodelist[j-1];
+        }
+        nodelist[j] = thisnodeID;
+    }
+    
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Remove a node from the topological sort list
+// the order of the remaining nodes stays valid
+// in: node ID
+/////////////////////////////////////////////////////////////////////////////
+
+void TopoSort_Remove(unsigned char nodeID) {
+    unsigned char n = node[nodeID].topoindex;
+    if (n < topo_Count) {
+        topo_Count--;
+        for (; n < topo_Count; n++) {                                           // close the gap
+            topoList[n] = topoList[n+1];
+            node[(topoList[n])].topoindex = n;
+        }
+        
+    }
+    
+    node[nodeID].topoindex = DEAD_NODEID;
+    node[nodeID].planedge_count = 0;
+}
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Topological sort list clear
 /////////////////////////////////////////////////////////////////////////////
 
 void TopoList_Clear(void) {
+    unsigned char n;
     
 #if vX_DEBUG_VERBOSE_LEVEL >= 2
         DEBUG_MSG("[vX][topo] Clearing Topological Sort List\n");
 #endif
-    nodelist_t *topolist;
-    while (topoListHead != NULL) {                                              // lets play trash the topo list
-        topolist = topoListHead;                                                // backup the pointer
-        topoListHead = topoListHead->next;                                      // advance to the next entry
-        vPortFree(topolist);                                                    // free up the previous entry
-    }                                                                           // rinse... repeat
+    for (n = 0; n < MAX_NODES; n++) {                                           // lets play trash the topo list
+        node[n].topoindex = DEAD_NODEID;
+        node[n].planedge_count = 0;
+    }
+    
+    topo_Count = 0;
     
 }
 
-// todo
 
-// better memory allocation is a must... or is it? heheheh
+
+/////////////////////////////////////////////////////////////////////////////
+// Build the execution plan
+// copies the outward edges of all nodes in topological order into the
+// flat edgePlan[] array, so that Mod_Propagate() doesn't have to follow
+// the edge lists. Must be called after edges or the order have changed.
+/////////////////////////////////////////////////////////////////////////////
+
+void TopoPlan_Build(void) {
+    unsigned char n;
+    unsigned char planindex = 0;
+    unsigned char thisnodeID;
+    edge_t *edgepointer;
+    planedge_t *planedge = edgePlan;
+    
+    for (n = 0; n < topo_Count; n++) {                                          // for each node in the topo list
+        thisnodeID = topoList[n];
+        node[thisnodeID].planedge = planindex;
+        edgepointer = node[thisnodeID].edgelist;
+        while (edgepointer != NULL) {                                           // copy out each outward edge
+            planedge->msgxlate = edgepointer->msgxlate;
+            planedge->tailport = edgepointer->tailport;
+            planedge->headnodeID = edgepointer->headnodeID;
+            planedge->headport = edgepointer->headport;
+            planedge++;
+            planindex++;
+            edgepointer = edgepointer->next;
+        }
+        
+        node[thisnodeID].planedge_count = planindex - node[thisnodeID].planedge;
+    }
+    
+}
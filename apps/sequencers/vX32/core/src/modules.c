@@ -146,16 +146,15 @@ void Mod_Tick_Node(unsigned char nodeID) {
 /////////////////////////////////////////////////////////////////////////////
 
 void Mod_Propagate(unsigned char nodeID) {
-    if (nodeID < DEAD_NODEID) {
+    if (nodeID < MAX_NODES) {
         if ((node[nodeID].indegree) < DEAD_INDEGREE) {                          // handle node isnt dead with indegree 0xff
-            edge_t *edgepointer = node[nodeID].edgelist;                        // load up the list header
-            while (edgepointer != NULL) {                                       // if there's any edges, then...
-                if (edgepointer->msgxlate != NULL) {
-                    edgepointer->msgxlate                                       // according to the source and destination port types
-                        (nodeID, edgepointer->tailport
-                        , edgepointer->headnodeID, edgepointer->headport);      // send data from tail to head
-                }
-                edgepointer = edgepointer->next;                                // search through the list
+            planedge_t *planedge = &edgePlan[(node[nodeID].planedge)];          // this node's edges are in one block of the plan
+            unsigned char edges = node[nodeID].planedge_count;
+            while (edges-- > 0) {                                               // if there's any edges, then...
+                planedge->msgxlate                                              // according to the source and destination port types
+                    (nodeID, planedge->tailport
+                    , planedge->headnodeID, planedge->headport);                // send data from tail to head
+                planedge++;
             }                                                                   // until all edges are done
             
         }
@@ -172,22 +171,19 @@ void Mod_Propagate(unsigned char nodeID) {
 /////////////////////////////////////////////////////////////////////////////
 
 void Mod_PreProcess(unsigned char startnodeID) {
-    nodelist_t *topolist;
+    unsigned char topoindex;
     unsigned char procnodeID;
     do {
         if (node_Count > 0) {                                                   // handle no nodes
-            topolist = topoListHead;                                            // follow list of topo sorted nodeIDs
-            if (topolist != NULL) {                                             // handle dead list
+            topoindex = 0;                                                      // follow list of topo sorted nodeIDs
+            if (topo_Count > 0) {                                               // handle dead list
                 if ((mClock.status.reset_req == 0)                              // force processing from root if global reset requested
-                    && (startnodeID < DEAD_NODEID)) {                           // otherwise if we are not requested to process from the root
-                    while ((topolist->nodeID) != startnodeID) {                 // search for the start node
-                        topolist = topolist->next;                              // through each entry in the topolist
-                    }                                                           // until we have the one we want
-                    
-                }
+                    && (startnodeID < MAX_NODES)) {                             // otherwise if we are not requested to process from the root
+                    topoindex = node[startnodeID].topoindex;                    // start at the position of the start node
+                }                                                               // (nothing is processed if it isn't sorted)
                 
-                while (topolist != NULL) {                                      // for each entry in the topolist from there on
-                    procnodeID = topolist->nodeID;                              // get the nodeID
+                while (topoindex < topo_Count) {                                // for each entry in the topolist from there on
+                    procnodeID = topoList[topoindex];                           // get the nodeID
                     if (procnodeID < MAX_NODES) {                               // only process nodes which...
                         if (
                             (
@@ -221,7 +217,7 @@ void Mod_PreProcess(unsigned char startnodeID) {
                         
                     }
                     
-                    topolist = topolist->next;                                  // and move onto the next node in the sorted list
+                    topoindex++;                                                // and move onto the next node in the sorted list
                 }
                 
             }
@@ -240,15 +236,14 @@ void Mod_PreProcess(unsigned char startnodeID) {
 /////////////////////////////////////////////////////////////////////////////
 
 void Mod_Tick(void) {
-    nodelist_t *topolist;
+    unsigned char topoindex;
     unsigned char ticknodeID;
     unsigned char module_ticked = DEAD_NODEID;
     
     if (mClock.status.run > 0) {                                                // if we're playing
         if (node_Count > 0) {                                                   // handle no nodes
-            topolist = topoListHead;                                            // follow list of topo sorted nodeIDs, to send their outbuffers
-            while (topolist != NULL) {                                          // for each entry in the topolist
-                ticknodeID = topolist->nodeID;                                  // get the nodeID
+            for (topoindex = 0; topoindex < topo_Count; topoindex++) {          // follow list of topo sorted nodeIDs, to send their outbuffers
+                ticknodeID = topoList[topoindex];                               // get the nodeID
                 if (ticknodeID < MAX_NODES) {                                   // if the nodeID is valid
                     if (node[ticknodeID].indegree < DEAD_INDEGREE) {            // if the module is active
                         if (node[ticknodeID].nexttick < DEAD_TIMESTAMP) {       // if the module is clocked
@@ -273,14 +268,12 @@ void Mod_Tick(void) {
                     
                 }
                 
-                topolist = topolist->next;                                      // and move onto the next node in the sorted list
             }
             
             
             
-            topolist = topoListHead;                                            // follow list of topo sorted nodeIDs, this time to deal with the timestamps
-            while (topolist != NULL) {                                          // for each entry in the topolist
-                ticknodeID = topolist->nodeID;                                  // get the nodeID
+            for (topoindex = 0; topoindex < topo_Count; topoindex++) {          // follow list of topo sorted nodeIDs, this time to deal with the timestamps
+                ticknodeID = topoList[topoindex];                               // get the nodeID
                 if (node[ticknodeID].status.tickseen > 0) {                     // if that clock has ticked
 #if vX_DEBUG_VERBOSE_LEVEL >= 1
     DEBUG_MSG("[vX] Ticking node %d\n", ticknodeID);
@@ -294,7 +287,6 @@ void Mod_Tick(void) {
                     node[ticknodeID].status.tickseen = 0;
                 }
                 
-                topolist = topolist->next;                                      // and move onto the next node in the sorted list
             }
             
             
@@ -459,6 +451,7 @@ void Mod_Init_Graph(unsigned char nodeID, unsigned char moduletype) {
     
     node[nodeID].edgelist = NULL;
     node[nodeID].edgelist_in = NULL;
+    node[nodeID].planedge_count = 0;
     
     node[nodeID].outbuffer_size = mod_SendData_Type[(mod_ModuleData_Type[moduletype]->buffertype)].buffer_size;
     
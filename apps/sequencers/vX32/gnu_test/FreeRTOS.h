@@ -0,0 +1,27 @@
+/* $Id$ */
+/*
+ * Replaces FreeRTOS for the host test of the vX32 graph.
+ * Only the types and the heap functions used by the core are declared,
+ * the heap is provided by vx_test.c so that allocations can be counted.
+ * portmacro.h, task.h, queue.h and semphr.h of this directory are empty.
+ */
+
+#ifndef _FREERTOS_H
+#define _FREERTOS_H
+
+#include <stddef.h>
+
+typedef void *xSemaphoreHandle;
+typedef void *xTaskHandle;
+typedef unsigned int portTickType;
+
+#define pdTRUE  1
+#define pdFALSE 0
+
+#define xSemaphoreTake(sem, ticks) pdTRUE
+#define xSemaphoreGive(sem)
+
+extern void *pvPortMalloc(size_t xWantedSize);
+extern void vPortFree(void *pv);
+
+#endif /* _FREERTOS_H */
@@ -0,0 +1,13 @@
+/* $Id$ */
+/*
+ * Replaces mios32.h for the host test of the vX32 graph.
+ * Only the data types and MIDI definitions used by the core are included.
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <mios32_datatypes.h>
+#include <mios32_midi.h>
+
+#endif /* _MIOS32_H */
@@ -0,0 +1,2 @@
+/* $Id$ */
+/* empty, see FreeRTOS.h of this directory */
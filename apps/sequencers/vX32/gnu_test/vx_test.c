@@ -0,0 +1,517 @@
+/* $Id$ */
+/*
+ * Host test of the vX32 graph
+ *
+ * graph.c, modules.c, mod_xlate.c and mod_send.c of the core are compiled
+ * for the host. The module types are replaced by test modules which add up
+ * their inputs, and clock modules which tick with different periods.
+ *
+ * - random patches are created and removed, after each step the
+ *   topological order and the execution plan are checked against the
+ *   edge lists, and cycles have to be rejected exactly when the head node
+ *   already reaches the tail node
+ * - a chain which is patched against the current order has to propagate
+ *   a value to its end within a single preprocessing run
+ * - the time per rack tick, per incremental patch and per full TopoSort()
+ *   is measured on a full rack which is re-patched while it's running
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <mios32.h>
+
+#include "app.h"
+#include "graph.h"
+#include "mclock.h"
+#include "modules.h"
+
+#include <seq_midi_out.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test modules
+// all types use the same ports: a timestamp input at 0, two value inputs
+// at 4 and 5, and two value outputs at 6 and 7
+/////////////////////////////////////////////////////////////////////////////
+
+#define TEST_PORTS 8
+#define TEST_PRIVVARS 4
+
+#define TEST_PORT_TIME 0
+#define TEST_PORT_IN_A 4
+#define TEST_PORT_IN_B 5
+#define TEST_PORT_OUT 6
+#define TEST_PORT_OUT2 7
+
+static const unsigned char test_ValidPorts[] = { TEST_PORT_TIME, TEST_PORT_IN_A, TEST_PORT_IN_B, TEST_PORT_OUT, TEST_PORT_OUT2 };
+
+static mod_portdata_t test_PortTypes[TEST_PORTS] = {
+    {MOD_PORTTYPE_TIMESTAMP, "Clock   "},
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {MOD_PORTTYPE_VALUE, "In A    "},
+    {MOD_PORTTYPE_VALUE, "In B    "},
+    {MOD_PORTTYPE_VALUE, "Out     "},
+    {MOD_PORTTYPE_VALUE, "Out 2   "},
+};
+
+static mod_portdata_t test_PrivVarTypes[TEST_PRIVVARS] = {
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {DEAD_PORTTYPE, "NoPatch!"},
+    {DEAD_PORTTYPE, "NoPatch!"},
+};
+
+static unsigned long test_proc_calls;
+static unsigned long test_tick_calls;
+
+static void Test_Init(unsigned char nodeID) {
+    memset(node[nodeID].ports, 0, TEST_PORTS);
+}
+
+static void Test_Proc(unsigned char nodeID) {
+    signed char *ports = node[nodeID].ports;
+    ports[TEST_PORT_OUT] = ports[TEST_PORT_IN_A] + ports[TEST_PORT_IN_B] + 1;
+    ports[TEST_PORT_OUT2] = ports[TEST_PORT_OUT];
+    ++test_proc_calls;
+}
+
+static void Test_Tick(unsigned char nodeID) {
+    ++test_tick_calls;
+}
+
+static void Test_UnInit(unsigned char nodeID) {
+}
+
+static u32 Test_ClockPeriod(unsigned char nodeID) {
+    return 24 + 24 * (nodeID % 4);
+}
+
+static void Test_Init_Clock(unsigned char nodeID) {
+    Test_Init(nodeID);
+    Mod_SetNextTick(nodeID, Test_ClockPeriod(nodeID), NULL);
+    *(u32 *)&node[nodeID].ports[TEST_PORT_TIME] = node[nodeID].nexttick;
+}
+
+static void Test_Tick_Clock(unsigned char nodeID) {
+    ++test_tick_calls;
+    Mod_SetNextTick(nodeID, node[nodeID].nexttick + Test_ClockPeriod(nodeID), NULL);
+    *(u32 *)&node[nodeID].ports[TEST_PORT_TIME] = node[nodeID].nexttick;
+}
+
+#define TEST_MODULETYPE_CLOCK MOD_MODULETYPE_SCLK
+#define TEST_MODULETYPE_ADD   MOD_MODULETYPE_SXH
+
+mod_moduledata_t mod_SClk_ModuleData = {
+    &Test_Init_Clock, &Test_Proc, &Test_Tick_Clock, &Test_UnInit,
+    TEST_PORTS, TEST_PRIVVARS, 0, MOD_SEND_TYPE_DUMMY,
+    test_PortTypes, test_PrivVarTypes, "TstClk ",
+};
+
+mod_moduledata_t mod_Seq_ModuleData = {
+    &Test_Init, &Test_Proc, &Test_Tick, &Test_UnInit,
+    TEST_PORTS, TEST_PRIVVARS, 0, MOD_SEND_TYPE_DUMMY,
+    test_PortTypes, test_PrivVarTypes, "TstSeq ",
+};
+
+mod_moduledata_t mod_MIDIOut_ModuleData = {
+    &Test_Init, &Test_Proc, &Test_Tick, &Test_UnInit,
+    TEST_PORTS, TEST_PRIVVARS, 0, MOD_SEND_TYPE_DUMMY,
+    test_PortTypes, test_PrivVarTypes, "TstOut ",
+};
+
+mod_moduledata_t mod_SxH_ModuleData = {
+    &Test_Init, &Test_Proc, &Test_Tick, &Test_UnInit,
+    TEST_PORTS, TEST_PRIVVARS, 0, MOD_SEND_TYPE_DUMMY,
+    test_PortTypes, test_PrivVarTypes, "TstAdd ",
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Replacements for mclock.c, the FreeRTOS heap and MIOS32
+/////////////////////////////////////////////////////////////////////////////
+
+mclock_t mClock;
+u32 mod_Tick_Timestamp;
+
+static unsigned long heap_calls;
+
+void *pvPortMalloc(size_t xWantedSize) {
+    ++heap_calls;
+    return malloc(xWantedSize);
+}
+
+void vPortFree(void *pv) {
+    if (pv != NULL) ++heap_calls;
+    free(pv);
+}
+
+s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len) {
+    return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Helpers
+/////////////////////////////////////////////////////////////////////////////
+
+static unsigned int rnd_state;
+
+static unsigned int rnd(unsigned int range) {
+    rnd_state = rnd_state * 1103515245 + 12345;
+    return ((rnd_state >> 16) & 0x7fff) % range;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int errors;
+
+#define CHECK(cond, ...) do { if (!(cond)) { ++errors; printf("FAILED at line %d: ", __LINE__); printf(__VA_ARGS__); printf("\n"); if (errors >= 20) exit(1); } } while (0)
+
+static int live(unsigned char nodeID) {
+    return node[nodeID].indegree < DEAD_INDEGREE;
+}
+
+static unsigned char random_live_node(void) {
+    unsigned char n;
+    do {
+        n = rnd(MAX_NODES);
+    } while (!live(n));
+    return n;
+}
+
+static unsigned int count_edges(void) {
+    unsigned int count = 0;
+    unsigned char n;
+    edge_t *edgepointer;
+    for (n = 0; n < MAX_NODES; n++) {
+        if (live(n)) {
+            for (edgepointer = node[n].edgelist; edgepointer != NULL; edgepointer = edgepointer->next)
+                ++count;
+        }
+    }
+    return count;
+}
+
+// reference search which doesn't depend on the topo order
+static int reaches(unsigned char from, unsigned char to) {
+    unsigned char stack[MAX_NODES];
+    unsigned char seen[MAX_NODES];
+    unsigned int sp = 0;
+    edge_t *edgepointer;
+
+    memset(seen, 0, sizeof(seen));
+    stack[sp++] = from;
+    seen[from] = 1;
+    while (sp > 0) {
+        unsigned char n = stack[--sp];
+        if (n == to) return 1;
+        for (edgepointer = node[n].edgelist; edgepointer != NULL; edgepointer = edgepointer->next) {
+            if (!seen[edgepointer->headnodeID]) {
+                seen[edgepointer->headnodeID] = 1;
+                stack[sp++] = edgepointer->headnodeID;
+            }
+        }
+    }
+    return 0;
+}
+
+// checks topoList, topoindex and edgePlan against the edge lists
+static void check_graph(const char *context) {
+    unsigned char seen[MAX_NODES];
+    unsigned char i, n;
+    unsigned int planindex = 0;
+    edge_t *edgepointer;
+
+    CHECK(topo_Count == node_Count, "%s: topo_Count %d != node_Count %d", context, topo_Count, node_Count);
+
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < topo_Count; i++) {
+        n = topoList[i];
+        CHECK(n < MAX_NODES && live(n), "%s: dead node %d in topoList", context, n);
+        if (n >= MAX_NODES) return;
+        CHECK(!seen[n], "%s: node %d twice in topoList", context, n);
+        seen[n] = 1;
+        CHECK(node[n].topoindex == i, "%s: node %d has topoindex %d, expected %d", context, n, node[n].topoindex, i);
+        CHECK(node[n].status.topovisited == 0, "%s: node %d still marked", context, n);
+
+        CHECK(node[n].planedge == planindex, "%s: plan of node %d starts at %d, expected %d", context, n, node[n].planedge, planindex);
+        for (edgepointer = node[n].edgelist; edgepointer != NULL; edgepointer = edgepointer->next) {
+            planedge_t *planedge = &edgePlan[planindex++];
+            CHECK(node[n].topoindex < node[edgepointer->headnodeID].topoindex,
+                  "%s: edge %d->%d against the order (%d >= %d)", context, n, edgepointer->headnodeID,
+                  node[n].topoindex, node[edgepointer->headnodeID].topoindex);
+            CHECK(planedge->msgxlate == edgepointer->msgxlate && planedge->tailport == edgepointer->tailport &&
+                  planedge->headnodeID == edgepointer->headnodeID && planedge->headport == edgepointer->headport,
+                  "%s: plan entry %d doesn't match edge %d->%d", context, planindex - 1, n, edgepointer->headnodeID);
+        }
+        CHECK(node[n].planedge_count == planindex - node[n].planedge, "%s: node %d has %d plan entries, expected %d",
+              context, n, node[n].planedge_count, planindex - node[n].planedge);
+    }
+
+    for (n = 0; n < MAX_NODES; n++) {
+        if (live(n)) {
+            CHECK(seen[n], "%s: live node %d missing in topoList", context, n);
+        }
+    }
+}
+
+static void rack_init(void) {
+    unsigned char n;
+    for (n = 0; n < MAX_NODES; n++) {                                           // like after startup: remove what's left from the previous test
+        if (live(n)) Node_Del(n);
+    }
+    Graph_Init();
+    memset(&mClock, 0, sizeof(mClock));
+    mod_Tick_Timestamp = 0;
+}
+
+static void rack_tick(void) {                                                   // like vX_Task_Rack_Tick()
+    ++mod_Tick_Timestamp;
+    Mod_PreProcess(DEAD_NODEID);
+    Mod_Tick();
+}
+
+static edge_t *random_edge(void) {
+    unsigned char n;
+    unsigned int e;
+    edge_t *edgepointer;
+    unsigned int edges = count_edges();
+    if (edges == 0) return NULL;
+
+    e = rnd(edges);
+    for (n = 0; n < MAX_NODES; n++) {
+        if (live(n)) {
+            for (edgepointer = node[n].edgelist; edgepointer != NULL; edgepointer = edgepointer->next) {
+                if (e-- == 0) return edgepointer;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int try_patch(void) {
+    unsigned char tail = random_live_node();
+    unsigned char head = random_live_node();
+    unsigned char tail_port = test_ValidPorts[rnd(sizeof(test_ValidPorts))];
+    unsigned char head_port = test_ValidPorts[rnd(sizeof(test_ValidPorts))];
+    unsigned int edges = count_edges();
+    int expect_cycle;
+    unsigned long heap_before;
+    edge_t *newedge;
+
+    if (tail == head) return 0;
+
+    expect_cycle = reaches(head, tail);
+    heap_before = heap_calls;
+    newedge = Edge_Add(tail, tail_port, head, head_port);
+    CHECK(heap_calls == heap_before, "Edge_Add used the heap");
+
+    if (expect_cycle) {
+        CHECK(newedge == NULL, "edge %d->%d creates a cycle but was added", tail, head);
+    } else if (edges >= MAX_EDGES) {
+        CHECK(newedge == NULL, "edge %d->%d added although all edges are in use", tail, head);
+    } else {
+        CHECK(newedge != NULL, "edge %d->%d was rejected", tail, head);
+    }
+    CHECK(count_edges() == edges + (newedge != NULL), "edge count mismatch after Edge_Add");
+    return newedge != NULL;
+}
+
+static void try_unpatch(void) {
+    edge_t *deledge = random_edge();
+    unsigned long heap_before;
+    unsigned int edges = count_edges();
+    if (deledge == NULL) return;
+
+    heap_before = heap_calls;
+    CHECK(Edge_Del(deledge, DO_TOPOSORT) == 0, "Edge_Del failed");
+    CHECK(heap_calls == heap_before, "Edge_Del used the heap");
+    CHECK(count_edges() == edges - 1, "edge count mismatch after Edge_Del");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Random patches: add/remove nodes and edges, check after each step
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_random(unsigned int steps) {
+    unsigned int step;
+    unsigned int added = 0, rejected = 0, fullsorts = 0;
+    char context[64];
+
+    rack_init();
+
+    for (step = 0; step < steps; step++) {
+        unsigned int op = rnd(100);
+        sprintf(context, "step %u", step);
+
+        if (node_Count < 2 || (op < 8 && node_Count < MAX_NODES-1)) {
+            CHECK(Node_Add(rnd(MAX_MODULETYPES)) < MAX_NODES, "%s: Node_Add failed", context);
+        } else if (op < 12) {
+            CHECK(Node_Del(random_live_node()) == 0, "%s: Node_Del failed", context);
+        } else if (op < 70) {
+            if (try_patch()) ++added; else ++rejected;
+        } else if (op < 99) {
+            try_unpatch();
+        } else {
+            CHECK(TopoSort() == 0, "%s: TopoSort failed", context);
+            ++fullsorts;
+        }
+
+        check_graph(context);
+    }
+
+    printf("random patches: %u steps, %u edges added, %u rejected, %u full sorts, %u nodes and %u edges left\n",
+           steps, added, rejected, fullsorts, node_Count, count_edges());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// A chain which is patched against the current order
+// each insertion moves the whole chain behind the new tail node
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_chain(void) {
+    unsigned char chain[MAX_NODES];
+    unsigned char length = MAX_NODES-2;
+    unsigned char n;
+    unsigned long proc_before;
+
+    rack_init();
+
+    for (n = 0; n < length; n++) {                                              // new nodes are inserted at the root, so chain[0] ends up last
+        chain[n] = Node_Add(TEST_MODULETYPE_ADD);
+    }
+    check_graph("chain nodes");
+
+    for (n = length-1; n > 0; n--) {                                            // patch from the end of the chain towards its start
+        CHECK(Edge_Add(chain[n-1], TEST_PORT_OUT, chain[n], TEST_PORT_IN_A) != NULL, "chain edge %d failed", n);
+    }
+    check_graph("chain edges");
+    CHECK(Edge_Add(chain[length-1], TEST_PORT_OUT, chain[0], TEST_PORT_IN_B) == NULL, "chain loop wasn't rejected");
+    check_graph("chain loop");
+
+    node[chain[0]].ports[TEST_PORT_IN_A] = 10;                                  // feed the chain
+    node[chain[0]].process_req++;
+    proc_before = test_proc_calls;
+    Mod_PreProcess(DEAD_NODEID);                                                // one run must be enough in topological order
+    CHECK(node[chain[length-1]].ports[TEST_PORT_OUT] == (signed char)(10 + length),
+          "chain output is %d, expected %d", node[chain[length-1]].ports[TEST_PORT_OUT], (signed char)(10 + length));
+    CHECK(test_proc_calls - proc_before == length, "chain processed %lu nodes, expected %d", test_proc_calls - proc_before, length);
+
+    CHECK(Edge_Del(Edge_GetID(chain[length/2], TEST_PORT_OUT, chain[length/2+1], TEST_PORT_IN_A), DO_TOPOSORT) == 0, "chain unpatch failed");
+    CHECK(Node_Del(chain[length/2]) == 0, "chain node delete failed");
+    check_graph("chain cut");
+
+    printf("chain of %d nodes patched in reverse order: ok\n", length);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Timing on a full rack which is re-patched while it's running
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_timing(unsigned int ticks) {
+    unsigned char n;
+    unsigned int t;
+    double start, tick_ns = 0, tick_max = 0;
+    double patch_ns = 0, patch_max = 0, sort_ns = 0, sort_max = 0;
+    unsigned int patches = 0, sorts = 0;
+    unsigned long tick_calls_before;
+    unsigned int edges;
+
+    rack_init();
+    mClock.status.run = 1;
+
+    for (n = 0; n < MAX_NODES-2; n++) {
+        Node_Add((n % 8) == 0 ? TEST_MODULETYPE_CLOCK : TEST_MODULETYPE_ADD);
+    }
+    while (count_edges() < MAX_EDGES * 3 / 4) {
+        try_patch();
+    }
+    check_graph("timing rack");
+    edges = count_edges();
+
+    for (t = 0; t < ticks / 10; t++) rack_tick();                               // settle
+
+    tick_calls_before = test_tick_calls;
+    for (t = 0; t < ticks; t++) {
+        double d;
+
+        start = now_ns();
+        rack_tick();
+        d = now_ns() - start;
+        tick_ns += d;
+        if (d > tick_max) tick_max = d;
+
+        if ((t % 16) == 0) {                                                    // re-patch while running
+            edge_t *deledge = random_edge();
+            unsigned int attempts;
+            start = now_ns();
+            if (deledge != NULL) Edge_Del(deledge, DO_TOPOSORT);
+            for (attempts = 0; attempts < 16 && !try_patch(); attempts++);     // rejected cycles are part of the cost
+            d = now_ns() - start;
+            patch_ns += d;
+            if (d > patch_max) patch_max = d;
+            ++patches;
+        } else if ((t % 16) == 8) {                                             // what a full sort would cost instead
+            start = now_ns();
+            TopoSort();
+            d = now_ns() - start;
+            sort_ns += d;
+            if (d > sort_max) sort_max = d;
+            ++sorts;
+        }
+    }
+    check_graph("timing end");
+
+    printf("rack with %d nodes and %u..%u edges, %u ticks, %lu module ticks, %u re-patches\n",
+           node_Count, edges, count_edges(), ticks, test_tick_calls - tick_calls_before, patches);
+    printf("  rack tick:              %8.0f nS average, %8.0f nS max\n", tick_ns / ticks, tick_max);
+    printf("  edge delete + add:      %8.0f nS average, %8.0f nS max (incl. rejected cycles and preprocessing)\n", patch_ns / patches, patch_max);
+    printf("  full TopoSort + plan:   %8.0f nS average, %8.0f nS max\n", sort_ns / sorts, sort_max);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[]) {
+    rnd_state = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    printf("vX32 graph test, seed %u, MAX_NODES %d, MAX_EDGES %d\n", rnd_state, MAX_NODES, MAX_EDGES);
+
+    Mod_Init_ModuleData();
+    Graph_Init();
+
+    test_random(200000);
+    test_chain();
+    test_timing(100000);
+
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+
+    printf("All tests passed\n");
+    return 0;
+}
@@ -22,12 +22,19 @@
 #include <file.h>
 #include <string.h>
 
-// Task stuff - the bank switch scanning is lower priority than the voice processing
+// Task stuff - the bank switch scanning and sample streaming is lower priority than the voice processing
 #define PRIORITY_VOICE_TASK	( tskIDLE_PRIORITY + 3 )
+#define PRIORITY_STREAM_TASK	( tskIDLE_PRIORITY + 2 )
 #define PRIORITY_BANKSWITCH_TASK	( tskIDLE_PRIORITY + 2 )
 static void TASK_VOICE_SCAN(void *pvParameters);
+static void TASK_STREAM(void *pvParameters);
 static void TASK_BANKSWITCH_SCAN(void *pvParameters);
 
+// SD Card access of the stream task and of Open_Bank (called from MIDI and bankswitch task) is serialized
+static xSemaphoreHandle xSDCardSemaphore;
+#define MUTEX_SDCARD_TAKE { while( xSemaphoreTakeRecursive(xSDCardSemaphore, (portTickType)1) != pdTRUE ); }
+#define MUTEX_SDCARD_GIVE { xSemaphoreGiveRecursive(xSDCardSemaphore); }
+
 /////////////////////////////////////////////////////////////////////////////
 // Local definitions
 /////////////////////////////////////////////////////////////////////////////
@@ -38,11 +45,17 @@ static void TASK_BANKSWITCH_SCAN(void *pvParameters);
 // Following accounts for: 7 bits (envelope decay) + 7 bits (velocity related volume) + 1-3 bits (mixing up to 8 samples but depends how hot your samples are)
 #define SAMPLE_SCALING 15        // Number of bits to scale samples down by in order to not distort - added 7 bits for midi volume now
 
-#define MAX_TIME_IN_DMA 45		// Time (*0.1ms) to read sample data for, e.g. 40 = 4.0 mS
-
 #define SAMPLE_BUFFER_SIZE 512  // -> 512 L/R samples, 80 Hz refill rate (11.6~ mS period). DMA refill routine called every 5.8mS.
 // NB sample rate and SPI prescaler set in mios32_config file - at 44.1kHz, reading 2 bytes per sample is SD card average rate of 86.13kB/s for a single sample
 
+// Sample data is pre-read by TASK_STREAM into a ring of sectors for each voice, the DMA routine only mixes from RAM
+// Each DMA refill consumes SAMPLE_BUFFER_SIZE bytes (= one sector) per voice
+#define STREAM_SECTOR_SIZE 512
+#ifndef STREAM_RING_SECTORS
+#define STREAM_RING_SECTORS 4	// sectors per voice -> 4 * 5.8 mS = 23 mS read ahead (costs POLYPHONY*STREAM_RING_SECTORS*512 bytes RAM)
+#endif
+#define STREAM_SAMPLE_NONE 0xff	// stream slot is free
+
 #define DEBUG_VERBOSE_LEVEL 10
 #define DEBUG_MSG MIOS32_MIDI_SendDebugMessage
 
@@ -90,9 +103,19 @@ static u8 sample_decval[NUM_SAMPLES_TO_OPEN];	// Decay time read in from bank fi
 static u8 no_decay;								// Used to speed up decay routine if this bank has no decay time
 static u8 hold_sample[NUM_SAMPLES_TO_OPEN];		// Used to hold sample (for drums)
 static file_t samplefile_fileinfo[NUM_SAMPLES_TO_OPEN];	// Create the right number of file descriptors
-static u8 samplebyte_buf[POLYPHONY][SAMPLE_BUFFER_SIZE];	// Create a buffer for each voice
 static u32 sample_cluster_cache[NUM_SAMPLES_TO_OPEN][CLUSTER_CACHE_SIZE];	// Array of sample cluster positions on SD card
 
+// Stream slots: one ring of pre-read sectors for each voice
+// read_ctr is only incremented by TASK_STREAM, play_ctr only by the DMA routine, the ring contains read_ctr-play_ctr sectors
+// A slot is (re)assigned by TASK_VOICE_SCAN, the generation counter allows TASK_STREAM to drop sectors which have been read for a previous assignment
+static u8 voice_stream[POLYPHONY];	// Stream slot used by each voice
+static u8 stream_sample[POLYPHONY];	// Sample streamed by the slot, STREAM_SAMPLE_NONE if free
+static u8 stream_generation[POLYPHONY];	// Incremented on each (re)assignment
+static volatile u32 stream_read_ctr[POLYPHONY];	// Number of sectors read into the ring
+static volatile u32 stream_play_ctr[POLYPHONY];	// Number of sectors mixed by the DMA routine
+static u8 stream_ring[POLYPHONY][STREAM_RING_SECTORS][STREAM_SECTOR_SIZE];
+static volatile u32 stream_underrun_ctr;	// Number of buffers of playing voices which couldn't be mixed since the ring was empty
+
 static u8 sample_bank_no=1;	// The sample bank number being played
 static u8 switch_bank_no=1;	// The sample bank selected via switch for J10 
 static u8 damper_pedal=0;	// Damper pedal on channel 1
@@ -136,24 +159,29 @@ s32 SAMP_FILE_open(u8 sample_n, char fname[])
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// reads <len> bytes from the .mid file into <buffer>
-// returns number of read bytes
+// reads up to <num_sectors> consecutive sectors of the sample file into <buffer>,
+// starting at sector <sector_ix> of the file
+// consecutive sectors of the same cluster are read with a single multi-block command
+// returns number of read sectors
 /////////////////////////////////////////////////////////////////////////////
-int SAMP_FILE_read(void *buffer, u32 len, u8 sample_n)
+int SAMP_FILE_read(void *buffer, u32 sector_ix, u32 num_sectors, u8 sample_n)
 {
-  // determine sector based on sample position
-  u32 pos = samplefile_pos[sample_n];
-  u32 sector_ix = pos / 512;
+  // determine physical sector based on cached cluster positions
   u32 sectors_per_cluster = FILE_VolumeSectorsPerCluster();
   u32 cluster_ix = sector_ix / sectors_per_cluster;
   if( cluster_ix >= CLUSTER_CACHE_SIZE )
     return -1;
 
+  // don't cross the cluster boundary
+  u32 cluster_sector = sector_ix % sectors_per_cluster;
+  if( num_sectors > (sectors_per_cluster - cluster_sector) )
+    num_sectors = sectors_per_cluster - cluster_sector;
+
   u32 cluster = sample_cluster_cache[sample_n][cluster_ix];
-  u32 phys_sector = FILE_VolumeCluster2Sector(cluster) + (sector_ix % sectors_per_cluster);
-  if( MIOS32_SDCARD_SectorRead(phys_sector, buffer) < 0 )
+  u32 phys_sector = FILE_VolumeCluster2Sector(cluster) + cluster_sector;
+  if( MIOS32_SDCARD_SectorsRead(phys_sector, buffer, num_sectors) < 0 )
     return -2;
-  return len;
+  return num_sectors;
 }
 
 void Open_Bank(u8 b_num)	// Open the bank number passed and parse the bank information, load samples, set midi notes, number of samples and cache cluster positions
@@ -326,14 +354,19 @@ void APP_Init(void)
   // allow SD Card access
   sdcard_access_allowed = 1;  
 
+  // all stream slots are free
+  u8 slot;
+  for(slot=0; slot<POLYPHONY; ++slot)
+    stream_sample[slot] = STREAM_SAMPLE_NONE;
+
   // init Synth
   SYNTH_Init(0);
   DEBUG_MSG("Synth init done."); 
 
-  MIOS32_STOPWATCH_Init(100);		// Use stopwatch in 100uS accuracy
-  
-  // Start tasks for voice processing and bank switch scanning
+  // Start tasks for voice processing, sample streaming and bank switch scanning
+  xSDCardSemaphore = xSemaphoreCreateRecursiveMutex();
   xTaskCreate(TASK_VOICE_SCAN, (signed portCHAR *)"VOICE_SCAN", configMINIMAL_STACK_SIZE, NULL, PRIORITY_VOICE_TASK, NULL);
+  xTaskCreate(TASK_STREAM, (signed portCHAR *)"STREAM", configMINIMAL_STACK_SIZE, NULL, PRIORITY_STREAM_TASK, NULL);
   xTaskCreate(TASK_BANKSWITCH_SCAN, (signed portCHAR *)"BANKSWITCH_SCAN", configMINIMAL_STACK_SIZE, NULL, PRIORITY_BANKSWITCH_TASK, NULL);
 }
 
@@ -386,7 +419,9 @@ void APP_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t midi_
 		DEBUG_MSG("MIDI Program Change received - Changing bank to %d",sample_bank_no);
 		sdcard_access_allowed=0;
 		DEBUG_MSG("Opening new sample bank");
+		MUTEX_SDCARD_TAKE;
 		Open_Bank(sample_bank_no);	// Load relevant bank
+		MUTEX_SDCARD_GIVE;
 		sdcard_access_allowed=1;
 	}
   else if (midi_package.chn==midichannel && midi_package.type==CC && midi_package.evnt1==7) // Volume message
@@ -442,52 +477,55 @@ void SYNTH_ReloadSampleBuffer(u32 state)
 	}
 
   // Each sample buffer entry contains the L/R 32 bit values
-  // Each call of this routine will need to read in SAMPLE_BUFFER_SIZE/2 samples, each of which requires 16 bits
-  // Therefore for mono samples, we'll need to read in SAMPLE_BUFFER_SIZE bytes
+  // Each call of this routine will need SAMPLE_BUFFER_SIZE/2 samples, each of which requires 16 bits
+  // Therefore for mono samples, one sector (SAMPLE_BUFFER_SIZE bytes) is taken from the stream ring of each voice
+  // The sectors have been pre-read by TASK_STREAM, no SD Card access here!
 
   u8 voice;
 
   s16 OutWavs16;	// 16 bit output to DAC
   s32 OutWavs32;	// 32 bit accumulator to mix samples into
-  u32 ms_so_far;		// used to measure time of DMA routine
+  u8 *mix_buf[POLYPHONY];	// sectors to mix
+  s16 mix_velocity[POLYPHONY];
+  u8 mix_num=0;
 
-  MIOS32_STOPWATCH_Reset();			// Reset the stopwatch at start of DMA routine
   MIOS32_BOARD_LED_Set(0x1, 0x1);	// Turn on LED at start of DMA routine
-  
 
 	// Here we have voice_no samples to play simultaneously, and the samples contained in voice_samples array
-
-	if(voice_no)	// if there's anything to play, read the samples and mix otherwise output silence
+	for(voice=0;voice<voice_no;voice++)
 	{
-		for(voice=0;voice<voice_no;voice++) 	// read up to SAMPLE_BUFFER_SIZE characters into buffer for each voice
+		u8 slot=voice_stream[voice];
+		u8 samp_no=voice_samples[voice];
+		u32 play_ctr=stream_play_ctr[slot];
+
+		if(stream_read_ctr[slot]==play_ctr)	// ring empty: skip this voice for one buffer
 		{
-			if(SAMP_FILE_read(samplebyte_buf[voice],SAMPLE_BUFFER_SIZE,voice_samples[voice])<0) // Read in the appropriate number of sectors for each sample thats on
-			{	// if <0 then there was an error reading, so turn this sample off and mute it
-			 sample_on[voice_samples[voice]]=0; // Turn sample off
-			 voice_velocity[voice]=0;			// Silence it in the mix as we don't have a complete buffer
-			}
-			
-			samplefile_pos[voice_samples[voice]]+=SAMPLE_BUFFER_SIZE;	// Move along the file position by the read buffer size
-			if(samplefile_pos[voice_samples[voice]] >= samplefile_len[voice_samples[voice]]) // We've reached EOF - don't play this sample next time and also free up the voice
-			{ 
-				sample_on[voice_samples[voice]]=0; // Turn sample off
-				//DEBUG_MSG("Reached EOF on sample %d",voice_samples[voice]);
-			}
-			 ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-			if(ms_so_far>MAX_TIME_IN_DMA)				
-				{ 
-				 DEBUG_MSG("Abandoning DMA routine after %d.%d ms, after %d voices out of %d",ms_so_far/10,ms_so_far%10,voice+1,voice_no);
-				 voice_no=voice+1;	// don't mix un-read voices (eg if break after 1st voice, voice_no should =1)
-				 break;	// go straight to sample mixing
-				}
+			if(play_ctr)	// the first sector of a new voice is normally still being read, only count gaps of a playing voice
+				++stream_underrun_ctr;
+			continue;
+		}
+
+		mix_buf[mix_num]=stream_ring[slot][play_ctr % STREAM_RING_SECTORS];	// sector can't be overwritten before this routine returns
+		mix_velocity[mix_num]=voice_velocity[voice];
+		mix_num++;
+		stream_play_ctr[slot]=play_ctr+1;	// TASK_STREAM can refill this sector afterwards
+
+		samplefile_pos[samp_no]+=SAMPLE_BUFFER_SIZE;	// Move along the file position by the read buffer size
+		if(samplefile_pos[samp_no] >= samplefile_len[samp_no]) // We've reached EOF - don't play this sample next time and also free up the voice
+		{
+			sample_on[samp_no]=0; // Turn sample off
+			//DEBUG_MSG("Reached EOF on sample %d",samp_no);
 		}
+	}
 
+	if(mix_num)	// if there's anything to play, mix the samples otherwise output silence
+	{
 		for(i=0; i<SAMPLE_BUFFER_SIZE; i+=2) // Fill half the sample buffer
 			{	
 				OutWavs32=0;	// zero the voice accumulator for this sample output
-				for(voice=0;voice<voice_no;voice++)
+				for(voice=0;voice<mix_num;voice++)
 				{
-						OutWavs32+=voice_velocity[voice]*(s16)((samplebyte_buf[voice][i+1] << 8) + samplebyte_buf[voice][i]);		// else mix it in
+						OutWavs32+=mix_velocity[voice]*(s16)((mix_buf[voice][i+1] << 8) + mix_buf[voice][i]);		// else mix it in
 				}
 				OutWavs32 = (OutWavs32>>SAMPLE_SCALING);	// Round down the wave to prevent distortion, and factor in the velocity multiply
 				if(OutWavs32>32767) { OutWavs32=32767; }	// Saturate positive
@@ -508,8 +546,6 @@ void SYNTH_ReloadSampleBuffer(u32 state)
 	 }
 
 	 MIOS32_BOARD_LED_Set(0x1, 0x0);	// Turn off LED at end of DMA routine
-	//ms_so_far= MIOS32_STOPWATCH_ValueGet();	// Check how long we've been in the routine up until this point
-	//DEBUG_MSG("%d.%d ms,%d.%d ms,%d.%d ms, %d voices",ms2_so_far/10,ms2_so_far%10,ms3_so_far/10,ms3_so_far%10,ms_so_far/10,ms_so_far%10,voice_no);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -548,6 +584,9 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 {
   u8 samp_no;
   u8 new_voice_no;
+  u8 new_voice_samples[POLYPHONY];
+  s16 new_voice_velocity[POLYPHONY];
+  u8 new_voice_restart[POLYPHONY];
   
   portTickType xLastExecutionTime;
 
@@ -570,15 +609,16 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 				{
 				 if(sample_on[samp_no]<0)	// We want to play this voice (either newly triggered =1 or continue playing =2)
 					{
-						voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
-						//voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]);	// Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
-						voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);    // Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
-						new_voice_no++;							// And increment number of voices in use
+						new_voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
+						//new_voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]);	// Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
+						new_voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);    // Assign velocity to voice - cast required to ensure the voice accumulation multiply is fast signed 16 bit
+						new_voice_restart[new_voice_no]=0;
 						if(sample_on[samp_no]==-1)					// Newly triggered sample (set to -1 by midi receive routine)
 						{
-						 samplefile_pos[samp_no]=0;	// Mark at position zero (used for sector reads and EOF calculations)
+						 new_voice_restart[new_voice_no]=1;	// Restart stream at position zero
 						 sample_on[samp_no]=-2;		// Mark as on and don't retrigger on next loop
 						 }
+						new_voice_no++;							// And increment number of voices in use
 					}
 				
 				}
@@ -595,8 +635,9 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 					{
 					if(sample_on[samp_no]>0)	// positive number = decaying
 						{
-							voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
-							voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);					
+							new_voice_samples[new_voice_no]=samp_no;	// Assign the next available voice to this sample number
+							new_voice_velocity[new_voice_no]=(s16)(sample_vel[samp_no]*midi_volume);					
+							new_voice_restart[new_voice_no]=0;
 							new_voice_no++;							// And increment number of voices in use				
 							sample_on[samp_no]--;				// Decrement decay time
 							if(sample_on[samp_no]<0) { sample_vel[samp_no]=0; sample_on[samp_no]=0;}	// If finished decaying mark as off
@@ -616,11 +657,137 @@ static void TASK_VOICE_SCAN(void *pvParameters)
 			}
 		}
 
+	// Assign stream slots and publish the new voices to the DMA routine
+	u8 voice, slot;
+	MIOS32_IRQ_Disable();
+	for(slot=0;slot<POLYPHONY;slot++)	// free slots of samples which are not played anymore
+	{
+		if(stream_sample[slot]==STREAM_SAMPLE_NONE) { continue; }
+		for(voice=0;voice<new_voice_no;voice++)
+		{
+			if(new_voice_samples[voice]==stream_sample[slot]) { break; }
+		}
+		if(voice==new_voice_no) { stream_sample[slot]=STREAM_SAMPLE_NONE; }
+	}
+
+	for(voice=0;voice<new_voice_no;voice++)
+	{
+		samp_no=new_voice_samples[voice];
+		for(slot=0;slot<POLYPHONY;slot++)	// slot already streaming this sample?
+		{
+			if(stream_sample[slot]==samp_no) { break; }
+		}
+		if(slot==POLYPHONY)	// otherwise take a free one (there is always one, since each voice plays a different sample)
+		{
+			for(slot=0;slot<POLYPHONY;slot++)
+			{
+				if(stream_sample[slot]==STREAM_SAMPLE_NONE) { break; }
+			}
+			new_voice_restart[voice]=1;
+		}
+
+		if(new_voice_restart[voice])	// start streaming from position zero
+		{
+			stream_sample[slot]=samp_no;
+			stream_generation[slot]++;
+			stream_read_ctr[slot]=0;
+			stream_play_ctr[slot]=0;
+			samplefile_pos[samp_no]=0;	// Mark at position zero (used for EOF calculations)
+		}
+
+		voice_stream[voice]=slot;
+		voice_samples[voice]=samp_no;
+		voice_velocity[voice]=new_voice_velocity[voice];
+	}
+
 	voice_no=new_voice_no;	// Set the global voice count now we're done
+	MIOS32_IRQ_Enable();
 	
 	}
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+// This task pre-reads the sample data of all voices into the stream rings
+// The ring with the lowest fill level is served first, so that the number of
+// voices is only limited by the SD Card throughput
+/////////////////////////////////////////////////////////////////////////////
+static void TASK_STREAM(void *pvParameters)
+{
+  u32 last_report_time = xTaskGetTickCount();
+
+  while( 1 ) {
+#if DEBUG_VERBOSE_LEVEL >= 2
+    if( stream_underrun_ctr && (xTaskGetTickCount() - last_report_time) >= (1000 / portTICK_RATE_MS) ) {
+      last_report_time = xTaskGetTickCount();
+      DEBUG_MSG("[STREAM] %d voice buffers skipped, SD Card too slow", stream_underrun_ctr);
+      stream_underrun_ctr = 0;
+    }
+#endif
+
+    u8 slot;
+    u8 best_slot = POLYPHONY;
+    u8 best_generation = 0;
+    u8 best_sample = 0;
+    u32 best_read_ctr = 0;
+    u32 best_fill = STREAM_RING_SECTORS;
+
+    MUTEX_SDCARD_TAKE;
+
+    // search for the ring with the lowest fill level
+    MIOS32_IRQ_Disable();
+    for(slot=0; slot<POLYPHONY; ++slot) {
+      u8 samp_no = stream_sample[slot];
+      if( samp_no == STREAM_SAMPLE_NONE )
+	continue;
+
+      u32 read_ctr = stream_read_ctr[slot];
+      u32 fill = read_ctr - stream_play_ctr[slot];
+      if( fill < best_fill && (read_ctr * STREAM_SECTOR_SIZE) < samplefile_len[samp_no] ) {
+	best_slot = slot;
+	best_generation = stream_generation[slot];
+	best_sample = samp_no;
+	best_read_ctr = read_ctr;
+	best_fill = fill;
+      }
+    }
+    MIOS32_IRQ_Enable();
+
+    if( best_slot == POLYPHONY || !sdcard_access_allowed ) {
+      MUTEX_SDCARD_GIVE;
+
+      // nothing to do: check again in 1 mS
+      vTaskDelay(1 / portTICK_RATE_MS);
+      continue;
+    }
+
+    // read free sectors up to the end of the ring buffer, and not beyond the end of the file
+    u32 ring_pos = best_read_ctr % STREAM_RING_SECTORS;
+    u32 num_sectors = STREAM_RING_SECTORS - best_fill;
+    if( num_sectors > (STREAM_RING_SECTORS - ring_pos) )
+      num_sectors = STREAM_RING_SECTORS - ring_pos;
+    u32 remaining_sectors = (samplefile_len[best_sample] - best_read_ctr * STREAM_SECTOR_SIZE + STREAM_SECTOR_SIZE - 1) / STREAM_SECTOR_SIZE;
+    if( num_sectors > remaining_sectors )
+      num_sectors = remaining_sectors;
+
+    int status = SAMP_FILE_read(stream_ring[best_slot][ring_pos], best_read_ctr, num_sectors, best_sample);
+
+    MUTEX_SDCARD_GIVE;
+
+    MIOS32_IRQ_Disable();
+    if( stream_generation[best_slot] == best_generation && stream_sample[best_slot] == best_sample ) { // slot hasn't been reassigned meanwhile
+      if( status > 0 )
+	stream_read_ctr[best_slot] = best_read_ctr + status;
+      else {
+	// if <0 then there was an error reading, so turn this sample off
+	sample_on[best_sample] = 0;
+	stream_sample[best_slot] = STREAM_SAMPLE_NONE;
+      }
+    }
+    MIOS32_IRQ_Enable();
+  }
+}
+
 static void TASK_BANKSWITCH_SCAN(void *pvParameters)
 {
  u8 this_bank;
@@ -642,7 +809,9 @@ static void TASK_BANKSWITCH_SCAN(void *pvParameters)
 				DEBUG_MSG("Changing bank to %d",sample_bank_no);
 				sdcard_access_allowed=0;
 				DEBUG_MSG("Opening new sample bank");
+				MUTEX_SDCARD_TAKE;
 				Open_Bank(sample_bank_no);	// Load relevant bank
+				MUTEX_SDCARD_GIVE;
 				sdcard_access_allowed=1;
 			}
 	}
@@ -49,6 +49,31 @@ double mixer_value2;
 double mixer_value3;
 
 
+//==============================================================================
+// Renders the current block of a SID in a worker thread
+class ReSidRenderJob : public ThreadPoolJob
+{
+public:
+    ReSidRenderJob(SidBlockRenderer *_sidBlockRenderer, int _sidNum)
+        : ThreadPoolJob("reSID")
+        , sidBlockRenderer(_sidBlockRenderer)
+        , sidNum(_sidNum)
+        , numSamples(0)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        sidBlockRenderer->render(sidNum, numSamples);
+        return jobHasFinished;
+    }
+
+    SidBlockRenderer *sidBlockRenderer;
+    int sidNum;
+    int numSamples;
+};
+
+
 //==============================================================================
 MidiboxSidAudioProcessor::MidiboxSidAudioProcessor()
 {
@@ -65,11 +90,17 @@ MidiboxSidAudioProcessor::MidiboxSidAudioProcessor()
     mixer_value2 = 1.0f;
     mixer_value3 = 1.0f;
     reSidSampleRate = 44100.0f;
+    reSidWriteOffset = 0;
 
 #if SID_NUM
     reSidEnabled = 1;
+    sidBlockRenderer = new SidBlockRenderer(SID_NUM);
+    sidBlockRenderer->setSamplingParameters(RESID_FREQUENCY, reSidSampleRate);
+    reSidThreadPool = (SID_NUM > 1) ? new ThreadPool(SID_NUM - 1) : NULL;
     for(int i=0; i<SID_NUM; ++i) {
         reSID[i] = new SID;
+        sidBlockRenderer->setSid(i, reSID[i]);
+        reSidRenderJob[i] = (i > 0) ? new ReSidRenderJob(sidBlockRenderer, i) : NULL;
         reSID[i]->set_chip_model(RESID_MODEL);
         reSID[i]->reset();
         if( !reSID[i]->set_sampling_parameters(RESID_FREQUENCY, RESID_SAMPLING_METHOD, reSidSampleRate) ) {
@@ -111,9 +142,12 @@ MidiboxSidAudioProcessor::MidiboxSidAudioProcessor()
 MidiboxSidAudioProcessor::~MidiboxSidAudioProcessor()
 {
 #if SID_NUM
+    delete reSidThreadPool;
     for(int i=0; i<SID_NUM; ++i) {
+        delete reSidRenderJob[i];
         delete reSID[i];
     }
+    delete sidBlockRenderer;
 #endif
 }
 
@@ -276,6 +310,8 @@ void MidiboxSidAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
 #if SID_NUM
     reSidEnabled = 1;
     reSidSampleRate = sampleRate;
+    sidBlockRenderer->setSamplingParameters(RESID_FREQUENCY, reSidSampleRate);
+    sidBlockRenderer->prepare(samplesPerBlock);
 
     for(int i=0; i<SID_NUM; ++i) {
         reSID[i]->reset();
@@ -357,31 +393,48 @@ void MidiboxSidAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuff
     
         // number of samples which have to be rendered
         int numSamples = buffer.getNumSamples();
-    
-        // add SID sound(s) to output(s)
-        // TK: this nested loop isn't optimal for CPU load, but we have to ensure that all SIDs are in lock-step
+        sidBlockRenderer->prepare(numSamples);
+
+        // update sound engine
+        // register changes are queued with their sample offset, so that all SIDs
+        // are in lock-step, although they are rendered independently
         for(int i=0; i<numSamples; ++i) {
-            // update sound engine
             mbSidUpdateCounter += (double)MBSID_UPDATE_FRQ / reSidSampleRate;
             if( mbSidUpdateCounter >= 1.0 ) {
                 mbSidUpdateCounter -= 1.0;
 #if RESID_PLAY_TESTTONE == 0
+                reSidWriteOffset = i;
                 mbSidEnvironment.tick();
                 RESID_Update(0);
 #endif
             }
+        }
+        reSidWriteOffset = 0;
+
+        // render the SIDs which are assigned to an output channel
+        // SID 0 is rendered by this thread, the remaining SIDs in parallel by the worker pool
+        int numSids = jmin(numChannels, SID_NUM);
+        for(int sid=1; sid<numSids; ++sid) {
+            reSidRenderJob[sid]->numSamples = numSamples;
+            reSidThreadPool->addJob(reSidRenderJob[sid], false);
+        }
 
-            for(int channel = 0; channel < numChannels; ++channel) {
-                // poll for next sample
-                short sample_buf;
-                cycle_count delta_t = 1;
-                while( !reSID[channel]->clock(delta_t, &sample_buf, 1) )
-                    if( !delta_t ) // delta_t can be changed by clock()
-                        delta_t = 1;
+        if( numSids > 0 )
+            sidBlockRenderer->render(0, numSamples);
 
-                float currentSample = (float)sample_buf / 32768.0;
-                *buffer.getSampleData(channel, i) = currentSample;
-            }
+        // SIDs without output channel only execute the queued register writes
+        for(int sid=numSids; sid<SID_NUM; ++sid)
+            sidBlockRenderer->render(sid, 0);
+
+        for(int sid=1; sid<numSids; ++sid)
+            reSidThreadPool->waitForJobToFinish(reSidRenderJob[sid], -1);
+
+        // add SID sound(s) to output(s)
+        for(int channel = 0; channel < numSids; ++channel) {
+            const short *samples = sidBlockRenderer->getSamples(channel);
+            float *channelData = buffer.getSampleData(channel);
+            for(int i=0; i<numSamples; ++i)
+                channelData[i] = (float)samples[i] / 32768.0;
         }
     }
 #endif
@@ -533,7 +586,8 @@ s32 MidiboxSidAudioProcessor::RESID_Update(u32 mode)
             u8 data;
             if( (data=sidRegs[sid].ALL[reg]) != sidRegsShadow[sid].ALL[reg] || mode >= 1 ) {
                 sidRegsShadow[sid].ALL[reg] = data;
-                reSID[sid]->write(reg, data);
+                // executed by the block renderer before the sample at reSidWriteOffset
+                sidBlockRenderer->queueWrite(sid, reSidWriteOffset, reg, data);
             }
         }
     }
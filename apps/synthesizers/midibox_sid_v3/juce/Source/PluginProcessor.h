@@ -15,6 +15,7 @@
 #include <JuceHeader.h>
 
 #include "../resid/resid.h"
+#include "SidBlockRenderer.h"
 #include "MbSidEnvironment.h"
 #include "MidiProcessing.h"
 
@@ -24,6 +25,8 @@
 #define SID_NUM 2
 
 
+class ReSidRenderJob;
+
 //==============================================================================
 /**
 */
@@ -112,11 +115,17 @@ public:
 #if SID_NUM
     SID *reSID[SID_NUM];
     MbSidEnvironment mbSidEnvironment;
+
+    // the SIDs are rendered block-wise, SID 0 by the audio thread, the others by a worker pool
+    SidBlockRenderer *sidBlockRenderer;
+    ThreadPool *reSidThreadPool;
+    ReSidRenderJob *reSidRenderJob[SID_NUM];
 #endif
   
     int reSidEnabled;
     double reSidSampleRate;
     double reSidDeltaCycleCounter;
+    int reSidWriteOffset; // sample offset of register writes within the current block
 
     double mbSidUpdateCounter;
 
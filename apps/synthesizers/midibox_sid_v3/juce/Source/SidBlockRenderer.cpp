@@ -0,0 +1,156 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Block based reSID rendering
+ * See SidBlockRenderer.h for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#include "SidBlockRenderer.h"
+
+
+// max. number of register writes per update cycle and SID
+// (used to reserve memory, so that the queue doesn't allocate while rendering)
+#define SID_BLOCK_RENDERER_WRITES_PER_UPDATE 32
+
+// samples per update cycle at the highest expected sample rate (192 kHz @ 1 kHz update rate)
+#define SID_BLOCK_RENDERER_MIN_SAMPLES_PER_UPDATE 192
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Constructor
+/////////////////////////////////////////////////////////////////////////////
+SidBlockRenderer::SidBlockRenderer(int numSids)
+    : slots(numSids)
+    , cyclesPerSample(1)
+{
+    for(int sid=0; sid<numSids; ++sid)
+        slots[sid].reSid = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Destructor
+/////////////////////////////////////////////////////////////////////////////
+SidBlockRenderer::~SidBlockRenderer()
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Assigns a reSID instance
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::setSid(int sidNum, SID *reSid)
+{
+    slots[sidNum].reSid = reSid;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sampling parameters: only used to determine the number of cycles which
+// have to be passed to reSID for a given number of samples
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::setSamplingParameters(double clockFrequency, double sampleRate)
+{
+    cyclesPerSample = (cycle_count)(clockFrequency / sampleRate) + 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocates the buffers
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::prepare(int maxSamples)
+{
+    for(unsigned sid=0; sid<slots.size(); ++sid) {
+        Slot &slot = slots[sid];
+
+        if( (int)slot.samples.size() < maxSamples )
+            slot.samples.resize(maxSamples);
+
+        unsigned maxWrites = (maxSamples / SID_BLOCK_RENDERER_MIN_SAMPLES_PER_UPDATE + 2) * SID_BLOCK_RENDERER_WRITES_PER_UPDATE;
+        if( slot.writes.capacity() < maxWrites )
+            slot.writes.reserve(maxWrites);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Queues a register write
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::queueWrite(int sidNum, int offset, unsigned char reg, unsigned char data)
+{
+    Write write;
+    write.offset = offset;
+    write.reg = reg;
+    write.data = data;
+    slots[sidNum].writes.push_back(write);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Renders a block
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::render(int sidNum, int numSamples)
+{
+    Slot &slot = slots[sidNum];
+
+    if( (int)slot.samples.size() < numSamples )
+        slot.samples.resize(numSamples);
+
+    // render the sub-blocks between register writes
+    // the writes are queued in chronological order
+    int offset = 0;
+    for(unsigned i=0; i<slot.writes.size(); ++i) {
+        const Write &write = slot.writes[i];
+
+        int writeOffset = write.offset;
+        if( writeOffset > numSamples )
+            writeOffset = numSamples;
+
+        if( writeOffset > offset ) {
+            renderSamples(slot, offset, writeOffset - offset);
+            offset = writeOffset;
+        }
+
+        slot.reSid->write(write.reg, write.data);
+    }
+    slot.writes.clear();
+
+    renderSamples(slot, offset, numSamples - offset);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the rendered samples
+/////////////////////////////////////////////////////////////////////////////
+const short *SidBlockRenderer::getSamples(int sidNum) const
+{
+    return slots[sidNum].samples.empty() ? 0 : &slots[sidNum].samples[0];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Renders a sub-block with the buffered clock() function of reSID
+/////////////////////////////////////////////////////////////////////////////
+void SidBlockRenderer::renderSamples(Slot &slot, int offset, int numSamples)
+{
+    short *buffer = &slot.samples[offset];
+
+    // delta_t covers one sample more than requested, so that reSID returns
+    // as soon as numSamples have been rendered: the remaining cycles are not
+    // clocked, and register writes are executed at the same SID cycle like
+    // with sample-by-sample clocking
+    while( numSamples > 0 ) {
+        cycle_count delta_t = (numSamples + 1) * cyclesPerSample;
+        int rendered = slot.reSid->clock(delta_t, buffer, numSamples);
+        buffer += rendered;
+        numSamples -= rendered;
+    }
+}
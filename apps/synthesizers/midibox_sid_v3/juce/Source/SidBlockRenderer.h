@@ -0,0 +1,74 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Block based reSID rendering
+ *
+ * Register writes of the sound engine are queued with their sample offset
+ * within the audio block. Each SID renders the whole block with the buffered
+ * clock() function of reSID, and executes the queued writes at their offsets.
+ * Since the SIDs don't share any state, render() can be called for different
+ * SIDs from different threads.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _SID_BLOCK_RENDERER_H
+#define _SID_BLOCK_RENDERER_H
+
+#include "../resid/resid.h"
+#include <vector>
+
+class SidBlockRenderer
+{
+public:
+
+    SidBlockRenderer(int numSids);
+    ~SidBlockRenderer();
+
+    // assigns a reSID instance to a SID slot
+    void setSid(int sidNum, SID *reSid);
+
+    // has to be called whenever the sampling parameters of the reSID instances are changed
+    void setSamplingParameters(double clockFrequency, double sampleRate);
+
+    // allocates the buffers for blocks of up to maxSamples
+    // (memory is only allocated if the block size grows)
+    void prepare(int maxSamples);
+
+    // queues a register write which is executed before the sample at <offset> is rendered
+    void queueWrite(int sidNum, int offset, unsigned char reg, unsigned char data);
+
+    // renders <numSamples> samples and executes all queued register writes
+    // numSamples can be 0 to execute the writes only
+    void render(int sidNum, int numSamples);
+
+    // returns the samples of the last render() call
+    const short *getSamples(int sidNum) const;
+
+protected:
+
+    struct Write {
+        int offset;
+        unsigned char reg;
+        unsigned char data;
+    };
+
+    struct Slot {
+        SID *reSid;
+        std::vector<Write> writes;
+        std::vector<short> samples;
+    };
+
+    std::vector<Slot> slots;
+    cycle_count cyclesPerSample;
+
+    void renderSamples(Slot &slot, int offset, int numSamples);
+};
+
+#endif /* _SID_BLOCK_RENDERER_H */
@@ -0,0 +1,21 @@
+// $Id$
+/*
+ * juce_core configuration of the render benchmark
+ * Replaces ../JuceLibraryCode/AppConfig.h, which enables all modules of the plugin
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _BENCHMARK_APPCONFIG_H
+#define _BENCHMARK_APPCONFIG_H
+
+#define JUCE_MODULE_AVAILABLE_juce_core 1
+#define JUCE_STANDALONE_APPLICATION     1
+
+#endif /* _BENCHMARK_APPCONFIG_H */
@@ -0,0 +1,332 @@
+// $Id$
+/*
+ * Offline render benchmark for the reSID integration of the MIDIbox SID V3 plugin
+ * (headless, only juce_core of JuceLibraryCode is required)
+ *
+ * Renders NUM_SECONDS of audio for 1..MAX_SIDS SIDs with:
+ *   - sample:  the former processBlock() loop, all SIDs clocked sample by sample in lock-step
+ *   - block:   SidBlockRenderer, all SIDs rendered by a single thread
+ *   - threads: SidBlockRenderer, one SID rendered by the main thread, the
+ *              remaining SIDs by the juce::ThreadPool of the plugin
+ *
+ * The sound engine is simulated by register writes at the MBSID update
+ * frequency (vibrato, PWM, filter sweep and retriggered gates on all voices).
+ *
+ * One line is printed for each test:
+ *   sids=<n> method=<name> realtime_factor=<x.xx> match=<yes|no>
+ *
+ * realtime_factor: rendered audio time / CPU (wall clock) time
+ * match: output is identical to the "sample" method
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include "AppConfig.h"
+#include "juce_core/juce_core.h"
+#include "../Source/SidBlockRenderer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+
+// same parameters like in PluginProcessor.cpp
+#define MBSID_UPDATE_FRQ 1000
+#define RESID_SAMPLING_METHOD SAMPLE_INTERPOLATE
+#define RESID_FREQUENCY 1000000
+#define RESID_MODEL MOS8580
+
+#ifndef SAMPLE_RATE
+#define SAMPLE_RATE 44100.0
+#endif
+
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 512
+#endif
+
+#ifndef NUM_SECONDS
+#define NUM_SECONDS 10
+#endif
+
+#ifndef MAX_SIDS
+#define MAX_SIDS 8
+#endif
+
+
+// these global variables are used by ReSID
+double mixer_value1;
+double mixer_value2;
+double mixer_value3;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Simulated sound engine: returns the register values of a SID at the given update cycle
+/////////////////////////////////////////////////////////////////////////////
+static void engineTick(unsigned char *regs, int sid, unsigned tick)
+{
+    for(int voice=0; voice<3; ++voice) {
+        unsigned char *v = &regs[7*voice];
+        unsigned frq = 4000 + 1500*voice + 500*sid + ((tick * (3+voice)) % 200);
+        unsigned pw = 0x400 + ((tick * (5+sid)) & 0x3ff);
+        v[0] = frq & 0xff;
+        v[1] = frq >> 8;
+        v[2] = pw & 0xff;
+        v[3] = pw >> 8;
+        v[4] = (voice == 2 ? 0x20 : 0x40) | ((((tick + 37*voice) % 250) < 200) ? 0x01 : 0x00); // retriggered gate
+        v[5] = 0x22;
+        v[6] = 0xa8;
+    }
+
+    unsigned cutoff = 200 + ((tick * 3) % 1800);
+    regs[21] = cutoff & 0x07;
+    regs[22] = cutoff >> 3;
+    regs[23] = 0x87;
+    regs[24] = 0x1f;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// SID setup and register updates (as done by RESID_Update() of the plugin)
+/////////////////////////////////////////////////////////////////////////////
+class Emulation
+{
+public:
+    Emulation(int _numSids)
+        : numSids(_numSids)
+        , renderer(_numSids)
+        , updateCounter(0)
+        , tickCounter(0)
+    {
+        for(int sid=0; sid<numSids; ++sid) {
+            reSID[sid] = new SID;
+            reSID[sid]->set_chip_model(RESID_MODEL);
+            reSID[sid]->reset();
+            reSID[sid]->set_sampling_parameters(RESID_FREQUENCY, RESID_SAMPLING_METHOD, SAMPLE_RATE);
+            renderer.setSid(sid, reSID[sid]);
+            memset(regs[sid], 0, sizeof(regs[sid]));
+            memset(shadow[sid], 0, sizeof(shadow[sid]));
+        }
+        renderer.setSamplingParameters(RESID_FREQUENCY, SAMPLE_RATE);
+        renderer.prepare(BLOCK_SIZE);
+    }
+
+    ~Emulation()
+    {
+        for(int sid=0; sid<numSids; ++sid)
+            delete reSID[sid];
+    }
+
+    // returns true if the engine has to be updated before the next sample
+    bool updateRequired(void)
+    {
+        updateCounter += (double)MBSID_UPDATE_FRQ / SAMPLE_RATE;
+        if( updateCounter >= 1.0 ) {
+            updateCounter -= 1.0;
+            return true;
+        }
+        return false;
+    }
+
+    // updates the engine; register changes are written directly (offset < 0) or queued
+    void update(int offset)
+    {
+        ++tickCounter;
+        for(int sid=0; sid<numSids; ++sid) {
+            engineTick(regs[sid], sid, tickCounter);
+            for(int reg=0; reg<25; ++reg) {
+                if( regs[sid][reg] != shadow[sid][reg] ) {
+                    shadow[sid][reg] = regs[sid][reg];
+                    if( offset < 0 )
+                        reSID[sid]->write(reg, regs[sid][reg]);
+                    else
+                        renderer.queueWrite(sid, offset, reg, regs[sid][reg]);
+                }
+            }
+        }
+    }
+
+    int numSids;
+    SID *reSID[MAX_SIDS];
+    SidBlockRenderer renderer;
+    unsigned char regs[MAX_SIDS][25];
+    unsigned char shadow[MAX_SIDS][25];
+    double updateCounter;
+    unsigned tickCounter;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Renders the current block of a SID in a worker thread
+// (same job and juce::ThreadPool like in PluginProcessor.cpp)
+/////////////////////////////////////////////////////////////////////////////
+class ReSidRenderJob : public juce::ThreadPoolJob
+{
+public:
+    ReSidRenderJob(SidBlockRenderer *_sidBlockRenderer, int _sidNum)
+        : juce::ThreadPoolJob("reSID")
+        , sidBlockRenderer(_sidBlockRenderer)
+        , sidNum(_sidNum)
+        , numSamples(0)
+    {
+    }
+
+    JobStatus runJob()
+    {
+        sidBlockRenderer->render(sidNum, numSamples);
+        return jobHasFinished;
+    }
+
+    SidBlockRenderer *sidBlockRenderer;
+    int sidNum;
+    int numSamples;
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Worker pool for the "threads" method
+/////////////////////////////////////////////////////////////////////////////
+class WorkerPool
+{
+public:
+    WorkerPool(SidBlockRenderer *_renderer, int _numSids)
+        : renderer(_renderer)
+        , numSids(_numSids)
+    {
+        // SID 0 is rendered by the calling thread
+        threadPool = (numSids > 1) ? new juce::ThreadPool(numSids - 1) : NULL;
+        for(int sid=0; sid<numSids; ++sid)
+            renderJob[sid] = new ReSidRenderJob(renderer, sid);
+    }
+
+    ~WorkerPool()
+    {
+        delete threadPool;
+        for(int sid=0; sid<numSids; ++sid)
+            delete renderJob[sid];
+    }
+
+    // same sequence like in MidiboxSidAudioProcessor::processBlock()
+    void render(int numSamples)
+    {
+        for(int sid=1; sid<numSids; ++sid) {
+            renderJob[sid]->numSamples = numSamples;
+            threadPool->addJob(renderJob[sid], false);
+        }
+
+        renderer->render(0, numSamples);
+
+        for(int sid=1; sid<numSids; ++sid)
+            threadPool->waitForJobToFinish(renderJob[sid], -1);
+    }
+
+protected:
+    SidBlockRenderer *renderer;
+    int numSids;
+    juce::ThreadPool *threadPool;
+    ReSidRenderJob *renderJob[MAX_SIDS];
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Render methods, the output of all SIDs is stored in <out> (interleaved)
+/////////////////////////////////////////////////////////////////////////////
+enum Method { METHOD_SAMPLE, METHOD_BLOCK, METHOD_THREADS };
+static const char *methodName[] = { "sample", "block", "threads" };
+
+static void render(Method method, int numSids, int totalSamples, short *out)
+{
+    Emulation emu(numSids);
+    WorkerPool *pool = (method == METHOD_THREADS) ? new WorkerPool(&emu.renderer, numSids) : NULL;
+
+    for(int blockStart=0; blockStart<totalSamples; blockStart+=BLOCK_SIZE) {
+        int numSamples = totalSamples - blockStart;
+        if( numSamples > BLOCK_SIZE )
+            numSamples = BLOCK_SIZE;
+        short *blockOut = &out[blockStart * numSids];
+
+        if( method == METHOD_SAMPLE ) {
+            for(int i=0; i<numSamples; ++i) {
+                if( emu.updateRequired() )
+                    emu.update(-1);
+
+                for(int sid=0; sid<numSids; ++sid) {
+                    short sample_buf;
+                    cycle_count delta_t = 1;
+                    while( !emu.reSID[sid]->clock(delta_t, &sample_buf, 1) )
+                        if( !delta_t ) // delta_t can be changed by clock()
+                            delta_t = 1;
+                    blockOut[i*numSids + sid] = sample_buf;
+                }
+            }
+        } else {
+            for(int i=0; i<numSamples; ++i) {
+                if( emu.updateRequired() )
+                    emu.update(i);
+            }
+
+            if( pool )
+                pool->render(numSamples);
+            else {
+                for(int sid=0; sid<numSids; ++sid)
+                    emu.renderer.render(sid, numSamples);
+            }
+
+            for(int sid=0; sid<numSids; ++sid) {
+                const short *samples = emu.renderer.getSamples(sid);
+                for(int i=0; i<numSamples; ++i)
+                    blockOut[i*numSids + sid] = samples[i];
+            }
+        }
+    }
+
+    delete pool;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+static double timeNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int totalSamples = (int)(NUM_SECONDS * SAMPLE_RATE);
+    std::vector<short> reference(totalSamples * MAX_SIDS);
+    std::vector<short> out(totalSamples * MAX_SIDS);
+    int numMismatches = 0;
+
+    printf("sample_rate=%d block_size=%d seconds=%d\n", (int)SAMPLE_RATE, BLOCK_SIZE, NUM_SECONDS);
+
+    for(int numSids=1; numSids<=MAX_SIDS; numSids*=2) {
+        for(int method=METHOD_SAMPLE; method<=METHOD_THREADS; ++method) {
+            short *buffer = (method == METHOD_SAMPLE) ? &reference[0] : &out[0];
+
+            double start = timeNow();
+            render((Method)method, numSids, totalSamples, buffer);
+            double elapsed = timeNow() - start;
+
+            bool match = (method == METHOD_SAMPLE) ||
+                memcmp(&reference[0], &out[0], totalSamples * numSids * sizeof(short)) == 0;
+            if( !match )
+                ++numMismatches;
+
+            printf("sids=%d method=%s realtime_factor=%.2f match=%s\n",
+                   numSids, methodName[method], NUM_SECONDS / elapsed, match ? "yes" : "no");
+        }
+    }
+
+    return numMismatches ? 1 : 0;
+}
@@ -0,0 +1,637 @@
+// $Id$
+/*
+ * Host test of the BSL SysEx handler
+ *
+ * bsl_sysex.c is compiled for STM32F4 and runs against a simulated flash
+ * and a virtual MIDI pipe with transfer time and latency. The uploader
+ * works like MIOS Studio: the old protocol waits for the acknowledge of
+ * each block, the new one compares the checksums of the flash sectors
+ * first and keeps several sequenced blocks in flight.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <mios32.h>
+#include "bsl_sysex.h"
+
+// simulated memories at the STM32F407 addresses (bsl_sysex.c accesses them directly)
+#define FLASH_BASE_ADDR   0x08000000
+#define FLASH_SIZE        (1024*1024)
+#define BSL_SIZE          0x4000
+#define SRAM_BASE_ADDR    0x20000000
+#define SRAM_SIZE         (128*1024)
+
+// flash timing (typical values of the STM32F407 datasheet, x32 parallelism)
+#define FLASH_PROGRAM_WORD_US  16
+#define FLASH_ERASE_16K_US     250000
+#define FLASH_ERASE_64K_US     550000
+#define FLASH_ERASE_128K_US    1000000
+
+// virtual MIDI pipe: USB MIDI with ~50 kb/s and some mS latency through the MIDI driver of the host
+#define PIPE_BYTE_US      20
+#define PIPE_LATENCY_US   2000
+#define PIPE_SIZE         256
+
+// uploader settings like in MIOS Studio
+#define DEVICE_ID         0x00
+#define BLOCK_SIZE        0x100
+#define TIMEOUT_US        1000000
+#define MAX_RETRIES       16
+#define WINDOW_SIZE       4
+
+// the application image: 500k with a gap which isn't located at a sector start
+#define IMAGE_ADDR        (FLASH_BASE_ADDR + BSL_SIZE)
+#define IMAGE_SIZE        (500*1024)
+#define IMAGE_NUM_BLOCKS  (IMAGE_SIZE / BLOCK_SIZE)
+#define IMAGE_GAP_ADDR    0x08030000
+#define IMAGE_GAP_SIZE    0x400
+
+
+// ------- types -------
+typedef struct {
+  uint64_t time; // arrival time in uS
+  u32 len;
+  u8 data[BSL_SYSEX_BUFFER_SIZE];
+} pipe_msg_t;
+
+typedef struct {
+  pipe_msg_t msg[PIPE_SIZE];
+  u32 head;
+  u32 tail;
+  uint64_t link_free; // the link is busy until this time
+  u32 num_msgs;
+  u32 num_bytes;
+  u32 drop_interval;    // fault injection: drop each n-th message
+  u32 corrupt_interval; // fault injection: flip a bit of each n-th message
+} pipe_t;
+
+typedef struct {
+  u32 erases;
+  u32 programmed_words;
+  u32 program_errors;
+  u32 queries;
+  u32 skipped_blocks;
+  u32 recovered_errors;
+  u32 faults;
+} stats_t;
+
+
+// ------- variables -------
+const u8 mios32_midi_sysex_header[5] = { 0xf0, 0x00, 0x00, 0x7e, 0x32 };
+
+static pipe_t host_to_core;
+static pipe_t core_to_host;
+static uint64_t host_time; // uS
+static uint64_t core_time; // uS
+static stats_t stats;
+
+// core state
+static u8 legacy_bsl; // if set, commands 0x03 and 0x04 are rejected like by an older BSL
+static u8 sysex_ctr;
+static u8 sysex_mine;
+static u8 sysex_cmd_received;
+static u8 sysex_cmd;
+
+static u8 bsl_image[BSL_SIZE];
+static u8 image[IMAGE_SIZE];
+static u8 image_block_valid[IMAGE_NUM_BLOCKS];
+static u32 blocks[IMAGE_NUM_BLOCKS];
+static int num_blocks;
+
+
+// ------- local prototypes -------
+static void pipe_send(pipe_t *p, uint64_t time, u8 *data, u32 len);
+static pipe_msg_t *host_receive(uint64_t deadline);
+static void core_receive(pipe_msg_t *m);
+static u32 image_crc32(u32 addr, u32 len);
+static int upload_legacy(u32 *upload_blocks, int num_upload_blocks);
+static int upload(void);
+static void scenario(const char *name, int use_new_protocol);
+
+
+// ------- main -------
+int main(void){
+  int i;
+
+  // map the simulated memories
+  if( mmap((void *)FLASH_BASE_ADDR, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)FLASH_BASE_ADDR ||
+      mmap((void *)SRAM_BASE_ADDR, SRAM_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)SRAM_BASE_ADDR ) {
+    printf("Failed to map the simulated memories\n");
+    exit(1);
+  }
+
+  srand(1);
+  for(i=0; i<BSL_SIZE; ++i)
+    bsl_image[i] = ((u8 *)FLASH_BASE_ADDR)[i] = rand();
+
+  for(i=0; i<IMAGE_SIZE; ++i)
+    image[i] = rand();
+  for(i=0; i<IMAGE_NUM_BLOCKS; ++i) {
+    u32 addr = IMAGE_ADDR + i*BLOCK_SIZE;
+    image_block_valid[i] = !(addr >= IMAGE_GAP_ADDR && addr < (IMAGE_GAP_ADDR + IMAGE_GAP_SIZE));
+    if( image_block_valid[i] )
+      blocks[num_blocks++] = addr;
+  }
+
+  BSL_SYSEX_Init(0);
+
+  scenario("old protocol, changed image", 0);
+  scenario("new protocol, changed image", 1);
+
+  // change some bytes in sector 3 and sector 6
+  image[0x0800c100 - IMAGE_ADDR] ^= 0xff;
+  image[0x08050010 - IMAGE_ADDR] ^= 0xff;
+  scenario("new protocol, 2 sectors changed", 1);
+  scenario("new protocol, same image again", 1);
+
+  host_to_core.drop_interval = 37;
+  host_to_core.corrupt_interval = 53;
+  core_to_host.drop_interval = 41;
+  scenario("new protocol, changed image, lost and corrupted messages", 1);
+  host_to_core.drop_interval = 0;
+  host_to_core.corrupt_interval = 0;
+  core_to_host.drop_interval = 0;
+
+  legacy_bsl = 1;
+  scenario("new protocol with old BSL, changed image", 1);
+  legacy_bsl = 0;
+
+  printf("All tests passed\n");
+
+  return 0;
+}
+
+
+// ------- scenario -------
+// writes an older image into the flash, uploads the current one and checks the flash content
+static void scenario(const char *name, int use_new_protocol){
+  int i;
+  int status;
+
+  // bsl_sysex.c isn't reset between the uploads, the erase state has to be handled by the protocol
+  if( strstr(name, "changed image") ) {
+    for(i=BSL_SIZE; i<FLASH_SIZE; ++i)
+      ((u8 *)FLASH_BASE_ADDR)[i] = rand();
+  }
+
+  memset(&stats, 0, sizeof(stats_t));
+  host_to_core.head = host_to_core.tail = host_to_core.num_msgs = host_to_core.num_bytes = 0;
+  core_to_host.head = core_to_host.tail = core_to_host.num_msgs = core_to_host.num_bytes = 0;
+  host_to_core.link_free = core_to_host.link_free = 0;
+  host_time = core_time = 0;
+
+  status = use_new_protocol ? upload() : upload_legacy(blocks, num_blocks);
+  uint64_t upload_time = host_time;
+
+  // process remaining messages
+  while( host_receive(host_time + 10*TIMEOUT_US) != NULL );
+
+  printf("%s:\n", name);
+  printf("  %6.2f s, %5d messages/%7d bytes sent, %5d received, %d queries, %d blocks skipped\n",
+	 (float)upload_time / 1000000, host_to_core.num_msgs, host_to_core.num_bytes, core_to_host.num_msgs,
+	 stats.queries, stats.skipped_blocks);
+  printf("  %d sectors erased, %d words programmed, %d recovered errors, %d injected faults\n",
+	 stats.erases, stats.programmed_words, stats.recovered_errors, stats.faults);
+
+  if( status < 0 ) {
+    printf("Upload failed with status %d\n", status);
+    exit(1);
+  }
+
+  if( stats.program_errors ) {
+    printf("%d words have been programmed without erasing the sector\n", stats.program_errors);
+    exit(1);
+  }
+
+  if( memcmp((u8 *)FLASH_BASE_ADDR, bsl_image, BSL_SIZE) != 0 ) {
+    printf("BSL range has been overwritten\n");
+    exit(1);
+  }
+
+  for(i=0; i<IMAGE_NUM_BLOCKS; ++i) {
+    if( image_block_valid[i] && memcmp((u8 *)(uintptr_t)(IMAGE_ADDR + i*BLOCK_SIZE), &image[i*BLOCK_SIZE], BLOCK_SIZE) != 0 ) {
+      printf("Flash content at 0x%08x doesn't match\n", IMAGE_ADDR + i*BLOCK_SIZE);
+      exit(1);
+    }
+  }
+}
+
+
+// ------- virtual MIDI pipe -------
+static void pipe_send(pipe_t *p, uint64_t time, u8 *data, u32 len){
+  ++p->num_msgs;
+  p->num_bytes += len;
+
+  // messages are transfered one after another
+  if( p->link_free < time )
+    p->link_free = time;
+  p->link_free += len * PIPE_BYTE_US;
+
+  if( p->drop_interval && (p->num_msgs % p->drop_interval) == 0 ) {
+    ++stats.faults;
+    return;
+  }
+
+  if( (p->tail - p->head) >= PIPE_SIZE ) {
+    printf("Pipe overrun\n");
+    exit(1);
+  }
+
+  pipe_msg_t *m = &p->msg[p->tail++ % PIPE_SIZE];
+  m->time = p->link_free + PIPE_LATENCY_US;
+  m->len = len;
+  memcpy(m->data, data, len);
+
+  if( p->corrupt_interval && (p->num_msgs % p->corrupt_interval) == 0 ) {
+    ++stats.faults;
+    m->data[len/2] ^= 0x01;
+  }
+}
+
+// returns the next message for the host which is received before the deadline
+// the core processes its incoming messages meanwhile
+static pipe_msg_t *host_receive(uint64_t deadline){
+  static pipe_msg_t msg;
+
+  while( 1 ) {
+    pipe_msg_t *core_msg = (host_to_core.head != host_to_core.tail) ? &host_to_core.msg[host_to_core.head % PIPE_SIZE] : NULL;
+    pipe_msg_t *host_msg = (core_to_host.head != core_to_host.tail) ? &core_to_host.msg[core_to_host.head % PIPE_SIZE] : NULL;
+
+    if( core_msg && (!host_msg || core_msg->time < host_msg->time) ) {
+      ++host_to_core.head;
+      memcpy(&msg, core_msg, sizeof(pipe_msg_t));
+      core_receive(&msg);
+    } else if( host_msg && host_msg->time <= deadline ) {
+      ++core_to_host.head;
+      memcpy(&msg, host_msg, sizeof(pipe_msg_t));
+      if( host_time < msg.time )
+	host_time = msg.time;
+      return &msg;
+    } else {
+      host_time = deadline;
+      return NULL;
+    }
+  }
+}
+
+
+// ------- core: MIOS32 SysEx parser and functions used by bsl_sysex.c -------
+static void core_send_disack(u8 error){
+  u8 buffer[9] = { 0xf0, 0x00, 0x00, 0x7e, 0x32, DEVICE_ID, MIOS32_MIDI_SYSEX_DISACK, error, 0xf7 };
+  MIOS32_MIDI_SendSysEx(USB0, buffer, sizeof(buffer));
+}
+
+static void core_cmd(mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in){
+  if( (legacy_bsl && (sysex_cmd == 0x03 || sysex_cmd == 0x04)) ||
+      BSL_SYSEX_Cmd(USB0, cmd_state, midi_in, sysex_cmd) < 0 ) {
+    // like MIOS32_MIDI_SYSEX_Cmd()
+    core_send_disack(MIOS32_MIDI_SYSEX_DISACK_INVALID_COMMAND);
+    sysex_ctr = sysex_mine = sysex_cmd_received = sysex_cmd = 0;
+  }
+}
+
+static void core_receive(pipe_msg_t *m){
+  u32 i;
+
+  if( core_time < m->time )
+    core_time = m->time;
+
+  for(i=0; i<m->len; ++i) {
+    u8 midi_in = m->data[i];
+
+    if( !sysex_mine ) {
+      if( (sysex_ctr < sizeof(mios32_midi_sysex_header) && midi_in != mios32_midi_sysex_header[sysex_ctr]) ||
+	  (sysex_ctr == sizeof(mios32_midi_sysex_header) && midi_in != DEVICE_ID) ) {
+	sysex_ctr = 0;
+      } else if( ++sysex_ctr > sizeof(mios32_midi_sysex_header) ) {
+	sysex_mine = 1;
+      }
+    } else if( midi_in >= 0x80 ) {
+      if( midi_in == 0xf7 && sysex_cmd_received )
+	core_cmd(MIOS32_MIDI_SYSEX_CMD_STATE_END, midi_in);
+      sysex_ctr = sysex_mine = sysex_cmd_received = sysex_cmd = 0;
+    } else if( !sysex_cmd_received ) {
+      sysex_cmd_received = 1;
+      sysex_cmd = midi_in;
+      core_cmd(MIOS32_MIDI_SYSEX_CMD_STATE_BEGIN, midi_in);
+    } else {
+      core_cmd(MIOS32_MIDI_SYSEX_CMD_STATE_CONT, midi_in);
+    }
+  }
+}
+
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count){
+  pipe_send(&core_to_host, core_time, stream, count);
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...){
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  return 0;
+}
+
+s32 MIOS32_MIDI_Periodic_mS(void){ return 0; }
+s32 MIOS32_MIDI_DebugPortSet(mios32_midi_port_t port){ return 0; }
+u8  MIOS32_MIDI_DeviceIDGet(void){ return DEVICE_ID; }
+s32 MIOS32_STOPWATCH_Reset(void){ return 0; }
+u32 MIOS32_SYS_FlashSizeGet(void){ return FLASH_SIZE; }
+u32 MIOS32_SYS_RAMSizeGet(void){ return SRAM_SIZE; }
+
+
+// ------- simulated flash -------
+void FLASH_InstructionCacheReset(void){}
+void FLASH_DataCacheReset(void){}
+void FLASH_Unlock(void){}
+void FLASH_ClearFlag(u32 FLASH_FLAG){}
+
+FLASH_Status FLASH_EraseSector(u32 FLASH_Sector, u8 VoltageRange){
+  int sector = FLASH_Sector / FLASH_Sector_1;
+  u32 addr = (sector < 4) ? (sector * 0x4000) : ((sector == 4) ? 0x10000 : ((sector - 4) * 0x20000));
+  u32 len = (sector < 4) ? 0x4000 : ((sector == 4) ? 0x10000 : 0x20000);
+
+  if( sector == 0 ) {
+    printf("BSL sector has been erased\n");
+    exit(1);
+  }
+
+  memset((u8 *)(uintptr_t)(FLASH_BASE_ADDR + addr), 0xff, len);
+  core_time += (len == 0x4000) ? FLASH_ERASE_16K_US : ((len == 0x10000) ? FLASH_ERASE_64K_US : FLASH_ERASE_128K_US);
+  ++stats.erases;
+
+  return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramWord(u32 Address, u32 Data){
+  u32 *word = (u32 *)(uintptr_t)Address;
+
+  // bits can only be cleared, otherwise the sector hasn't been erased before
+  if( (*word & Data) != Data )
+    ++stats.program_errors;
+
+  *word &= Data;
+  core_time += FLASH_PROGRAM_WORD_US;
+  ++stats.programmed_words;
+
+  return FLASH_COMPLETE;
+}
+
+
+// ------- host: SysEx messages -------
+static u8 *host_header(u8 *buffer, u8 cmd){
+  memcpy(buffer, mios32_midi_sysex_header, sizeof(mios32_midi_sysex_header));
+  buffer += sizeof(mios32_midi_sysex_header);
+  *buffer++ = DEVICE_ID;
+  *buffer++ = cmd;
+  return buffer;
+}
+
+static u8 *host_addr_len(u8 *buffer, u32 addr, u32 len, u8 *checksum){
+  *checksum += *buffer++ = (addr >> 25) & 0x7f;
+  *checksum += *buffer++ = (addr >> 18) & 0x7f;
+  *checksum += *buffer++ = (addr >> 11) & 0x7f;
+  *checksum += *buffer++ = (addr >>  4) & 0x7f;
+  *checksum += *buffer++ = (len >> 25) & 0x7f;
+  *checksum += *buffer++ = (len >> 18) & 0x7f;
+  *checksum += *buffer++ = (len >> 11) & 0x7f;
+  *checksum += *buffer++ = (len >>  4) & 0x7f;
+  return buffer;
+}
+
+// sends a block with command 0x02, or with 0x04 if a sequence number is given
+static void host_send_block(u32 addr, s32 seq){
+  u8 buffer[BSL_SYSEX_BUFFER_SIZE];
+  u8 checksum = 0;
+  u8 *p = host_header(buffer, (seq < 0) ? 0x02 : 0x04);
+  u8 value7 = 0;
+  int bit_ctr7 = 0;
+  int i;
+
+  if( seq >= 0 )
+    checksum += *p++ = seq & 0x7f;
+  p = host_addr_len(p, addr, BLOCK_SIZE, &checksum);
+
+  for(i=0; i<BLOCK_SIZE; ++i) {
+    u8 value8 = image[addr - IMAGE_ADDR + i];
+    int bit_ctr8;
+    for(bit_ctr8=0; bit_ctr8<8; ++bit_ctr8) {
+      value7 = (value7 << 1) | ((value8 & 0x80) ? 1 : 0);
+      value8 <<= 1;
+      if( ++bit_ctr7 >= 7 ) {
+	checksum += *p++ = value7;
+	value7 = 0;
+	bit_ctr7 = 0;
+      }
+    }
+  }
+  if( bit_ctr7 )
+    checksum += *p++ = value7 << (7-bit_ctr7);
+
+  *p++ = -checksum & 0x7f;
+  *p++ = 0xf7;
+  pipe_send(&host_to_core, host_time, buffer, p - buffer);
+}
+
+static void host_send_checksum_request(u32 addr, u32 len){
+  u8 buffer[32];
+  u8 checksum = 0;
+  u8 *p = host_header(buffer, 0x03);
+
+  p = host_addr_len(p, addr, len, &checksum);
+  *p++ = 0xf7;
+  pipe_send(&host_to_core, host_time, buffer, p - buffer);
+  ++stats.queries;
+}
+
+static int host_is_mine(pipe_msg_t *m, u8 cmd, u32 min_len){
+  return m->len >= min_len &&
+    memcmp(m->data, mios32_midi_sysex_header, sizeof(mios32_midi_sysex_header)) == 0 &&
+    m->data[5] == DEVICE_ID &&
+    m->data[6] == cmd;
+}
+
+// returns 0 on acknowledge, the error code on disacknowledge and -1 if the message isn't an acknowledge
+// *seq is -1 if no sequence number has been returned
+static int host_parse_ack(pipe_msg_t *m, s32 *seq){
+  int ack = host_is_mine(m, MIOS32_MIDI_SYSEX_ACK, 9);
+  if( !ack && !host_is_mine(m, MIOS32_MIDI_SYSEX_DISACK, 9) )
+    return -1;
+
+  *seq = (m->len >= 10 && m->data[8] < 0x80) ? m->data[8] : -1;
+  return ack ? 0 : m->data[7];
+}
+
+// returns 0 if the message contains a valid checksum reply
+static int host_parse_checksum(pipe_msg_t *m, u32 *addr, u32 *len, u32 *crc){
+  u8 checksum = 0;
+  int i;
+
+  if( !host_is_mine(m, 0x03, 22) || m->data[21] != 0xf7 )
+    return -1;
+
+  for(i=7; i<20; ++i)
+    checksum += m->data[i];
+  if( (-checksum & 0x7f) != m->data[20] )
+    return -1;
+
+  *addr = (m->data[7] << 25) | (m->data[8] << 18) | (m->data[9] << 11) | (m->data[10] << 4);
+  *len = (m->data[11] << 25) | (m->data[12] << 18) | (m->data[13] << 11) | (m->data[14] << 4);
+  *crc = ((u32)m->data[15] << 28) | (m->data[16] << 21) | (m->data[17] << 14) | (m->data[18] << 7) | m->data[19];
+  return 0;
+}
+
+// CRC32 of the image, bytes which are not part of the image are erased
+static u32 image_crc32(u32 addr, u32 len){
+  u32 crc = 0xffffffff;
+  u32 i;
+
+  for(i=0; i<len; ++i, ++addr) {
+    u8 b = 0xff;
+    if( addr >= IMAGE_ADDR && addr < (IMAGE_ADDR + IMAGE_SIZE) && image_block_valid[(addr - IMAGE_ADDR) / BLOCK_SIZE] )
+      b = image[addr - IMAGE_ADDR];
+
+    int bit_ctr;
+    crc ^= b;
+    for(bit_ctr=0; bit_ctr<8; ++bit_ctr)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+  }
+
+  return ~crc;
+}
+
+
+// ------- host: uploads -------
+// old protocol: each block is acknowledged before the next one is sent
+static int upload_legacy(u32 *upload_blocks, int num_upload_blocks){
+  int block;
+
+  for(block=0; block<num_upload_blocks; ++block) {
+    int retry;
+    for(retry=0; retry<MAX_RETRIES; ++retry) {
+      uint64_t deadline = host_time + TIMEOUT_US;
+      pipe_msg_t *m;
+      int error = -1;
+      s32 seq;
+
+      host_send_block(upload_blocks[block], -1);
+      while( (m = host_receive(deadline)) != NULL && (error = host_parse_ack(m, &seq)) < 0 );
+
+      if( error == 0 )
+	break;
+      ++stats.recovered_errors;
+    }
+
+    if( retry >= MAX_RETRIES )
+      return -1;
+  }
+
+  return 0;
+}
+
+// new protocol: compare checksums of the erase units, upload the changed ones with up to
+// WINDOW_SIZE sequenced blocks in flight. Falls back to the old protocol if the BSL doesn't support it
+static int upload(void){
+  static u32 upload_blocks[IMAGE_NUM_BLOCKS];
+  int num_upload_blocks = 0;
+  int block = 0;
+
+  while( block < num_blocks ) {
+    u32 addr = blocks[block];
+    u32 unit_addr, unit_len, crc;
+    int retry;
+
+    for(retry=0; retry<MAX_RETRIES; ++retry) {
+      uint64_t deadline = host_time + TIMEOUT_US;
+      pipe_msg_t *m;
+      int error = -1;
+      s32 seq;
+
+      host_send_checksum_request(addr, BLOCK_SIZE);
+      while( (m = host_receive(deadline)) != NULL ) {
+	if( host_parse_checksum(m, &unit_addr, &unit_len, &crc) == 0 && addr >= unit_addr && addr < (unit_addr + unit_len) )
+	  break;
+	if( (error = host_parse_ack(m, &seq)) > 0 )
+	  break;
+      }
+
+      if( error == MIOS32_MIDI_SYSEX_DISACK_INVALID_COMMAND )
+	return upload_legacy(blocks, num_blocks);
+      if( m != NULL && error < 0 )
+	break;
+      ++stats.recovered_errors;
+    }
+
+    if( retry >= MAX_RETRIES )
+      return -2;
+
+    // take over all blocks of the erase unit
+    int changed = image_crc32(unit_addr, unit_len) != crc;
+    for(; block < num_blocks && blocks[block] < (unit_addr + unit_len); ++block) {
+      if( changed )
+	upload_blocks[num_upload_blocks++] = blocks[block];
+      else
+	++stats.skipped_blocks;
+    }
+  }
+
+  // sequenced upload (go-back-n: blocks are only written in sequence order by the core)
+  int base = 0;
+  int next = 0;
+  int retry = 0;
+  int resent = 0; // set after a go-back until the core acknowledges again
+  while( base < num_upload_blocks ) {
+    for(; next < num_upload_blocks && (next - base) < WINDOW_SIZE; ++next)
+      host_send_block(upload_blocks[next], next & 0x7f);
+
+    pipe_msg_t *m = host_receive(host_time + TIMEOUT_US);
+    if( m == NULL ) {
+      if( ++retry >= MAX_RETRIES )
+	return -3;
+      ++stats.recovered_errors;
+      next = base;
+      resent = 1;
+      continue;
+    }
+
+    s32 seq;
+    int error = host_parse_ack(m, &seq);
+    if( error < 0 || seq < 0 )
+      continue;
+
+    int distance = (seq - base) & 0x7f;
+    if( distance >= (next - base) )
+      continue; // not in flight anymore
+
+    if( error == 0 ) {
+      // the core writes in sequence order: all previous blocks have been written as well
+      base += distance + 1;
+      retry = 0;
+      resent = 0;
+    } else if( (error == MIOS32_MIDI_SYSEX_DISACK_OUT_OF_SEQUENCE) ? !resent : (distance == 0) ) {
+      // a block got lost or has been rejected: send it and the following blocks again
+      // further "out of sequence" replies belong to the blocks which have been sent before
+      if( ++retry >= MAX_RETRIES )
+	return -4;
+      ++stats.recovered_errors;
+      next = base;
+      resent = 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+// $Id$
+/*
+ * Replaces the STM32F4 library configuration for the host test of the
+ * BSL SysEx handler: only the flash functions used by bsl_sysex.c are
+ * declared, they access the simulated flash of bsl_test.c
+ */
+
+#ifndef _STM32F4XX_CONF_H
+#define _STM32F4XX_CONF_H
+
+#include <stdint.h>
+#include <mios32_datatypes.h>
+
+typedef enum
+{ 
+  FLASH_BUSY = 1,
+  FLASH_ERROR_PGS,
+  FLASH_ERROR_PGP,
+  FLASH_ERROR_PGA,
+  FLASH_ERROR_WRP,
+  FLASH_ERROR_PROGRAM,
+  FLASH_ERROR_OPERATION,
+  FLASH_COMPLETE
+} FLASH_Status;
+
+#define VoltageRange_3     ((u8)0x02)
+
+#define FLASH_Sector_0     ((u16)0x0000)
+#define FLASH_Sector_1     ((u16)0x0008)
+#define FLASH_Sector_2     ((u16)0x0010)
+#define FLASH_Sector_3     ((u16)0x0018)
+#define FLASH_Sector_4     ((u16)0x0020)
+#define FLASH_Sector_5     ((u16)0x0028)
+#define FLASH_Sector_6     ((u16)0x0030)
+#define FLASH_Sector_7     ((u16)0x0038)
+#define FLASH_Sector_8     ((u16)0x0040)
+#define FLASH_Sector_9     ((u16)0x0048)
+#define FLASH_Sector_10    ((u16)0x0050)
+#define FLASH_Sector_11    ((u16)0x0058)
+
+extern void FLASH_InstructionCacheReset(void);
+extern void FLASH_DataCacheReset(void);
+extern void FLASH_Unlock(void);
+extern FLASH_Status FLASH_EraseSector(u32 FLASH_Sector, u8 VoltageRange);
+extern FLASH_Status FLASH_ProgramWord(u32 Address, u32 Data);
+extern void FLASH_ClearFlag(u32 FLASH_FLAG);
+
+#endif /* _STM32F4XX_CONF_H */
@@ -25,9 +25,9 @@
 // Local Macros
 /////////////////////////////////////////////////////////////////////////////
 
-#define MEM32(addr) (*((volatile u32 *)(addr)))
-#define MEM16(addr) (*((volatile u16 *)(addr)))
-#define MEM8(addr)  (*((volatile u8  *)(addr)))
+#define MEM32(addr) (*((volatile u32 *)(size_t)(addr)))
+#define MEM16(addr) (*((volatile u16 *)(size_t)(addr)))
+#define MEM8(addr)  (*((volatile u8  *)(size_t)(addr)))
 
 
 #if defined(MIOS32_FAMILY_STM32F10x)
@@ -137,13 +137,17 @@ static s32 prepare_sector(unsigned start_sector, unsigned end_sector, unsigned c
 /////////////////////////////////////////////////////////////////////////////
 
 static s32 BSL_SYSEX_Cmd_ReadMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in);
-static s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in);
+static s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in, u8 with_seq);
+static s32 BSL_SYSEX_Cmd_ChecksumMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in);
 
 static s32 BSL_SYSEX_RecAddrAndLen(u8 midi_in);
 
-static s32 BSL_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_arg);
+static s32 BSL_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_arg, s32 seq);
 static s32 BSL_SYSEX_SendMem(mios32_midi_port_t port, u32 addr, u32 len);
-static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer);
+static s32 BSL_SYSEX_SendChecksum(mios32_midi_port_t port, u32 addr, u32 len);
+static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer, u8 erase_again);
+static s32 BSL_SYSEX_EraseUnitGet(u32 addr, u32 len, u32 *unit_addr, u32 *unit_len);
+static u32 BSL_SYSEX_CRC32(u32 addr, u32 len);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -157,6 +161,8 @@ static u32 sysex_len;
 static u8 sysex_checksum;
 static u8 sysex_received_checksum;
 static u32 sysex_receive_ctr;
+static u8 sysex_seq;
+static u8 sysex_expected_seq;
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -181,6 +187,9 @@ s32 BSL_SYSEX_Init(u32 mode)
   // so long flash hasn't been programmed completely
   halt_state = 0;
 
+  // the first block of a sequenced upload has sequence number 0
+  sysex_expected_seq = 0;
+
   return 0; // no error
 }
 
@@ -232,7 +241,13 @@ s32 BSL_SYSEX_Cmd(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_sta
       BSL_SYSEX_Cmd_ReadMem(port, cmd_state, midi_in);
       break;
     case 0x02:
-      BSL_SYSEX_Cmd_WriteMem(port, cmd_state, midi_in);
+      BSL_SYSEX_Cmd_WriteMem(port, cmd_state, midi_in, 0);
+      break;
+    case 0x03:
+      BSL_SYSEX_Cmd_ChecksumMem(port, cmd_state, midi_in);
+      break;
+    case 0x04:
+      BSL_SYSEX_Cmd_WriteMem(port, cmd_state, midi_in, 1);
       break;
 
     default:
@@ -271,7 +286,7 @@ s32 BSL_SYSEX_Cmd_ReadMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t
       // did we reach payload state?
       if( sysex_rec_state != BSL_SYSEX_REC_PAYLOAD ) {
 	// not enough bytes received
-	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_LESS_BYTES_THAN_EXP);
+	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_LESS_BYTES_THAN_EXP, -1);
       } else {
 	// send dump
 	BSL_SYSEX_SendMem(port, sysex_addr, sysex_len);
@@ -286,17 +301,25 @@ s32 BSL_SYSEX_Cmd_ReadMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t
 
 /////////////////////////////////////////////////////////////////////////////
 // Command 02: Write Memory handler
-/////////////////////////////////////////////////////////////////////////////
-s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in)
+// Command 04: Write Memory with sequence number
+// The sequence number is sent before the address, and returned with the
+// acknowledge, so that the host can send the next blocks before the previous
+// ones have been acknowledged. Blocks are only written in sequence order,
+// a block which has been received again (e.g. the acknowledge got lost) is
+// only acknowledged again.
+/////////////////////////////////////////////////////////////////////////////
+s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in, u8 with_seq)
 {
   static u32 bit_ctr8 = 0;
   static u32 value8 = 0;
+  s32 seq = with_seq ? sysex_seq : -1;
 
   switch( cmd_state ) {
 
     case MIOS32_MIDI_SYSEX_CMD_STATE_BEGIN:
       // set initial receive state and address/len
-      sysex_rec_state = BSL_SYSEX_REC_A3;
+      sysex_rec_state = with_seq ? BSL_SYSEX_REC_SEQ : BSL_SYSEX_REC_A3;
+      sysex_seq = 0;
       sysex_addr = 0;
       sysex_len = 0;
       // clear checksum and receive counters
@@ -309,7 +332,11 @@ s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_
       break;
 
     case MIOS32_MIDI_SYSEX_CMD_STATE_CONT:
-      if( sysex_rec_state < BSL_SYSEX_REC_PAYLOAD ) {
+      if( sysex_rec_state == BSL_SYSEX_REC_SEQ ) {
+	sysex_checksum += midi_in;
+	sysex_seq = midi_in;
+	sysex_rec_state = BSL_SYSEX_REC_A3;
+      } else if( sysex_rec_state < BSL_SYSEX_REC_PAYLOAD ) {
 	sysex_checksum += midi_in;
 	BSL_SYSEX_RecAddrAndLen(midi_in);
       } else if( sysex_rec_state == BSL_SYSEX_REC_PAYLOAD ) {
@@ -348,25 +375,40 @@ s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_
 	MIOS32_MIDI_SendDebugMessage("[BSL_SYSEX] expected %d, got %d bytes (retry)\n", sysex_len, sysex_receive_ctr);
 #endif
 	// not enough bytes received
-	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_LESS_BYTES_THAN_EXP);
+	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_LESS_BYTES_THAN_EXP, seq);
       } else if( sysex_rec_state == BSL_SYSEX_REC_INVALID ) {
 	// too many bytes received
-	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_MORE_BYTES_THAN_EXP);
+	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_MORE_BYTES_THAN_EXP, seq);
       } else if( sysex_received_checksum != (-sysex_checksum & 0x7f) ) {
 	// notify that wrong checksum has been received
-	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_WRONG_CHECKSUM);
+	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_WRONG_CHECKSUM, seq);
+      } else if( with_seq && sysex_seq != sysex_expected_seq ) {
+	if( ((sysex_expected_seq - sysex_seq) & 0x7f) <= BSL_SYSEX_SEQ_HISTORY ) {
+	  // block has already been written, but the host didn't get the acknowledge
+	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_ACK, -sysex_checksum & 0x7f, seq);
+	} else {
+	  // a previous block got lost - ignore the following blocks until the host sends it again
+	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_OUT_OF_SEQUENCE, seq);
+	}
+
+	MIOS32_MIDI_Periodic_mS();
       } else {
 	// enter halt state (can only be released via BSL reset)
 	halt_state = 1;
 
 	// write received data into memory
+	// the host sends a flash unit with sequenced blocks only if its checksum
+	// differs, so it has to be erased again when the first block is written
 	s32 error;
-	if( (error = BSL_SYSEX_WriteMem(sysex_addr, sysex_len, sysex_buffer)) ) {
+	if( (error = BSL_SYSEX_WriteMem(sysex_addr, sysex_len, sysex_buffer, with_seq)) ) {
 	  // write failed - return negated error status
-	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, -error);
+	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, -error, seq);
 	} else {
 	  // notify that bytes have been received by returning checksum
-	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_ACK, -sysex_checksum & 0x7f);
+	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_ACK, -sysex_checksum & 0x7f, seq);
+
+	  if( with_seq )
+	    sysex_expected_seq = (sysex_expected_seq + 1) & 0x7f;
 	}
 
 	// enfore immediate MIDI queue flush
@@ -380,6 +422,53 @@ s32 BSL_SYSEX_Cmd_WriteMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Command 03: Checksum Memory handler
+// Returns the range and CRC32 of the flash erase unit (page or sector) which
+// contains the given address, so that the host can skip all blocks of this
+// unit if they are already up-to-date. For SRAM the given range is taken.
+// A checksum request starts a new sequenced upload (command 04).
+/////////////////////////////////////////////////////////////////////////////
+s32 BSL_SYSEX_Cmd_ChecksumMem(mios32_midi_port_t port, mios32_midi_sysex_cmd_state_t cmd_state, u8 midi_in)
+{
+  switch( cmd_state ) {
+
+    case MIOS32_MIDI_SYSEX_CMD_STATE_BEGIN:
+      // set initial receive state and address/len
+      sysex_rec_state = BSL_SYSEX_REC_A3;
+      sysex_addr = 0;
+      sysex_len = 0;
+      break;
+
+    case MIOS32_MIDI_SYSEX_CMD_STATE_CONT:
+      if( sysex_rec_state < BSL_SYSEX_REC_PAYLOAD )
+	BSL_SYSEX_RecAddrAndLen(midi_in);
+      break;
+
+    default: // BSL_SYSEX_CMD_STATE_END
+      // did we reach payload state?
+      if( sysex_rec_state != BSL_SYSEX_REC_PAYLOAD ) {
+	// not enough bytes received
+	BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, MIOS32_MIDI_SYSEX_DISACK_LESS_BYTES_THAN_EXP, -1);
+      } else {
+	u32 unit_addr, unit_len;
+	s32 error;
+	if( (error = BSL_SYSEX_EraseUnitGet(sysex_addr, sysex_len, &unit_addr, &unit_len)) ) {
+	  BSL_SYSEX_SendAck(port, MIOS32_MIDI_SYSEX_DISACK, -error, -1);
+	} else {
+	  sysex_expected_seq = 0;
+	  BSL_SYSEX_SendChecksum(port, unit_addr, unit_len);
+	}
+      }
+
+      MIOS32_MIDI_Periodic_mS();
+      break;
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Help function to receive address and length
 /////////////////////////////////////////////////////////////////////////////
@@ -410,8 +499,9 @@ static s32 BSL_SYSEX_RecAddrAndLen(u8 midi_in)
 /////////////////////////////////////////////////////////////////////////////
 // This function sends a SysEx acknowledge to notify the user about the received command
 // expects acknowledge code (e.g. 0x0f for good, 0x0e for error) and additional argument
+// the sequence number is appended if >= 0
 /////////////////////////////////////////////////////////////////////////////
-static s32 BSL_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_arg)
+static s32 BSL_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_arg, s32 seq)
 {
   u8 sysex_buffer[32]; // should be enough?
   u8 *sysex_buffer_ptr = &sysex_buffer[0];
@@ -426,12 +516,14 @@ static s32 BSL_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ack_arg)
   // send ack code and argument
   *sysex_buffer_ptr++ = ack_code;
   *sysex_buffer_ptr++ = ack_arg;
+  if( seq >= 0 )
+    *sysex_buffer_ptr++ = seq & 0x7f;
 
   // send footer
   *sysex_buffer_ptr++ = 0xf7;
 
   // finally send SysEx stream
-  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)sysex_buffer_ptr - ((u32)&sysex_buffer[0]));
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
 }
 
 
@@ -457,7 +549,7 @@ s32 BSL_SYSEX_SendUploadReq(mios32_midi_port_t port)
   *sysex_buffer_ptr++ = 0xf7;
 
   // finally send SysEx stream
-  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)sysex_buffer_ptr - ((u32)&sysex_buffer[0]));
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
 }
 
 
@@ -522,15 +614,138 @@ s32 BSL_SYSEX_SendMem(mios32_midi_port_t port, u32 addr, u32 len)
   *sysex_buffer_ptr++ = 0xf7;
 
   // finally send SysEx stream
-  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)sysex_buffer_ptr - ((u32)&sysex_buffer[0]));
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function sends the address range and CRC32 of a memory range
+// We expect that address and length are aligned to 16
+/////////////////////////////////////////////////////////////////////////////
+static s32 BSL_SYSEX_SendChecksum(mios32_midi_port_t port, u32 addr, u32 len)
+{
+  u8 sysex_buffer[32]; // should be enough?
+  u8 *sysex_buffer_ptr = &sysex_buffer[0];
+  u8 checksum = 0;
+  int i;
+
+  for(i=0; i<sizeof(mios32_midi_sysex_header); ++i)
+    *sysex_buffer_ptr++ = mios32_midi_sysex_header[i];
+
+  // device ID
+  *sysex_buffer_ptr++ = MIOS32_MIDI_DeviceIDGet();
+
+  // "checksum mem" command
+  *sysex_buffer_ptr++ = 0x03;
+
+  // send 32bit address (divided by 16) in 7bit format
+  checksum += *sysex_buffer_ptr++ = (addr >> 25) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (addr >> 18) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (addr >> 11) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (addr >>  4) & 0x7f;
+
+  // send 32bit range (divided by 16) in 7bit format
+  checksum += *sysex_buffer_ptr++ = (len >> 25) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (len >> 18) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (len >> 11) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (len >>  4) & 0x7f;
+
+  // send 32bit CRC in 7bit format
+  u32 crc = BSL_SYSEX_CRC32(addr, len);
+  checksum += *sysex_buffer_ptr++ = (crc >> 28) & 0x0f;
+  checksum += *sysex_buffer_ptr++ = (crc >> 21) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (crc >> 14) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (crc >>  7) & 0x7f;
+  checksum += *sysex_buffer_ptr++ = (crc >>  0) & 0x7f;
+
+  // send checksum
+  *sysex_buffer_ptr++ = -checksum & 0x7f;
+
+  // send footer
+  *sysex_buffer_ptr++ = 0xf7;
+
+  // finally send SysEx stream
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function calculates the CRC32 (IEEE 802.3) of a memory range
+// (bitwise, the BSL has no space for a lookup table)
+/////////////////////////////////////////////////////////////////////////////
+static u32 BSL_SYSEX_CRC32(u32 addr, u32 len)
+{
+  u32 crc = 0xffffffff;
+  int i;
+
+  for(i=0; i<len; ++i) {
+    int bit_ctr;
+    crc ^= MEM8(addr+i);
+    for(bit_ctr=0; bit_ctr<8; ++bit_ctr)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+  }
+
+  return ~crc;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// This function returns the range which is erased together with the given
+// address, for SRAM the given range is returned
+/////////////////////////////////////////////////////////////////////////////
+static s32 BSL_SYSEX_EraseUnitGet(u32 addr, u32 len, u32 *unit_addr, u32 *unit_len)
+{
+  // check for flash memory range
+  if( addr >= FLASH_START_ADDR && addr <= FLASH_END_ADDR ) {
+#if defined(MIOS32_FAMILY_STM32F10x)
+    *unit_addr = addr & ~(FLASH_PAGE_SIZE-1);
+    *unit_len = FLASH_PAGE_SIZE;
+#elif defined(MIOS32_FAMILY_STM32F4xx)
+    // note: sector 0 is never found, its base address is 0xffffffff
+    int sector;
+    for(sector=MAX_FLASH_SECTOR-1; sector>0 && addr < flash_sector_map[sector][0]; --sector);
+
+    u32 unit_end = (sector < (MAX_FLASH_SECTOR-1)) ? flash_sector_map[sector+1][0] : (FLASH_END_ADDR+1);
+    if( unit_end > (FLASH_END_ADDR+1) )
+      unit_end = FLASH_END_ADDR+1;
+
+    *unit_addr = flash_sector_map[sector][0];
+    *unit_len = unit_end - *unit_addr;
+#elif defined(MIOS32_FAMILY_LPC17xx)
+    int sector;
+    for(sector=USER_START_SECTOR; sector<=MAX_USER_SECTOR && addr > sector_end_map[sector]; ++sector);
+    if( sector > MAX_USER_SECTOR )
+      return -MIOS32_MIDI_SYSEX_DISACK_WRONG_ADDR_RANGE;
+
+    *unit_addr = sector_start_map[sector];
+    *unit_len = sector_end_map[sector] - sector_start_map[sector] + 1;
+#else
+# error "Flash Programming not prepared for this family"
+#endif
+
+    return 0; // no error
+  }
+
+  // check for SRAM memory range
+  if( addr >= SRAM_START_ADDR && addr <= SRAM_END_ADDR ) {
+    *unit_addr = addr;
+    *unit_len = len;
+
+    return 0; // no error
+  }
+
+  // invalid address
+  return -MIOS32_MIDI_SYSEX_DISACK_WRONG_ADDR_RANGE;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
 // This function writes into a memory
 // We expect that address and length are aligned to 4
+// If erase_again is set, a flash sector is erased when its start address is
+// written, even if it has already been erased before
 /////////////////////////////////////////////////////////////////////////////
-static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer)
+static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer, u8 erase_again)
 {
   // check for alignment
   if( (addr % 4) || (len % 4) )
@@ -583,6 +798,9 @@ static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer)
 	    }
 
 	    u32 flash_sector_mask = (1 << sector);
+	    if( erase_again ) {
+	      flash_erase_done &= ~flash_sector_mask;
+	    }
 	    if( !(flash_erase_done & flash_sector_mask) ) {
 	      erase_required = 1;
 	      flash_erase_done |= flash_sector_mask;
@@ -659,7 +877,7 @@ static s32 BSL_SYSEX_WriteMem(u32 addr, u32 len, u8 *buffer)
   if( addr >= SRAM_START_ADDR && addr <= SRAM_END_ADDR ) {
 
     // transfer buffer into SRAM
-    memcpy((u8 *)addr, (u8 *)buffer, len);
+    memcpy((u8 *)(size_t)addr, (u8 *)buffer, len);
 
     return 0; // no error
   }
@@ -29,6 +29,11 @@
 // + some bytes to send the header
 #define BSL_SYSEX_BUFFER_SIZE (((BSL_SYSEX_MAX_BYTES*8)/7) + 20)
 
+// sequence numbers of the "write mem with sequence number" command (0x04) are 7bit values.
+// A block which has been received again with a sequence number within this distance
+// below the expected one is acknowledged without writing it again (the ack got lost)
+#define BSL_SYSEX_SEQ_HISTORY 64
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Type definitions
@@ -49,7 +54,8 @@ typedef enum {
   BSL_SYSEX_REC_CHECKSUM,
   BSL_SYSEX_REC_ID,
   BSL_SYSEX_REC_ID_OK,
-  BSL_SYSEX_REC_INVALID
+  BSL_SYSEX_REC_INVALID,
+  BSL_SYSEX_REC_SEQ
 } bsl_sysex_rec_state_t;
 
 
@@ -0,0 +1,107 @@
+# $Id$
+#
+# Build rules for the POSIX emulation (MIOS32_FAMILY=POSIX)
+# Included by common.mk, so that the Makefile of an application doesn't need to be changed.
+#
+# The application is built with the compiler of the host, the result is an
+# executable which can be started from a shell (see $(MIOS32_PATH)/mios32/POSIX/README.txt)
+#
+
+# if MIOS32_SHELL environment variable hasn't been set by the user, set it here
+MIOS32_SHELL ?= sh
+export MIOS32_SHELL
+
+# select host tools
+# can be optionally overruled via environment variable, e.g. MIOS32_POSIX_CC=clang
+MIOS32_POSIX_CC ?= gcc
+
+CC      = $(MIOS32_POSIX_CC)
+SIZE    = size
+
+# additional compiler flags, e.g. MIOS32_POSIX_CFLAGS=-m32 to get the same
+# pointer size like on the target (requires multilib support of the host compiler)
+MIOS32_POSIX_CFLAGS ?=
+
+# where should the output files be located
+PROJECT_OUT ?= $(PROJECT)_build
+
+# default linker flags
+LDFLAGS += $(MIOS32_POSIX_CFLAGS) -lpthread -lrt -lm -lstdc++
+
+# define C flags
+# mios32/POSIX/include contains the 32bit datatypes for LP64 hosts (long is 64bit wide),
+# it has to be searched before $(MIOS32_PATH)/include/mios32
+CFLAGS += $(MIOS32_POSIX_CFLAGS) $(C_DEFINES) -I $(MIOS32_PATH)/mios32/POSIX/include $(C_INCLUDE) -Wall -Wno-format -Wno-switch -Wno-strict-aliasing
+
+# define CPP flags
+CPPFLAGS += $(CFLAGS) -fno-rtti -fno-exceptions -Wno-write-strings
+
+# convert .c/.cpp -> .o
+THUMB_OBJS = $(THUMB_SOURCE:.c=.o)
+THUMB_CPP_OBJS = $(THUMB_CPP_SOURCE:.cpp=.o)
+
+# list of all objects (assembly and ARM sources are not relevant for the host)
+ALL_OBJS = $(addprefix $(PROJECT_OUT)/, $(THUMB_OBJS) $(THUMB_CPP_OBJS))
+
+# list of all dependency files
+ALL_DFILES = $(ALL_OBJS:.o=.d)
+
+# which directories contain source files?
+DIRS = $(dir $(THUMB_OBJS) $(THUMB_CPP_OBJS))
+
+# add files for distribution
+DIST += $(MIOS32_PATH)/include/makefile/common.mk $(MIOS32_PATH)/include/makefile/POSIXcommon.mk $(MIOS32_PATH)/include/c
+
+# default rule
+all: dirs $(PROJECT_OUT)/$(PROJECT) projectinfo
+
+# define debug/release target for easier use in codeblocks
+debug: all
+Debug: all
+release: all
+Release: all
+
+# create the output directories
+dirs:
+	@-if [ ! -e $(PROJECT_OUT) ]; then mkdir $(PROJECT_OUT); fi;
+	@-$(foreach DIR,$(DIRS), if [ ! -e $(PROJECT_OUT)/$(DIR) ]; \
+	 then mkdir -p $(PROJECT_OUT)/$(DIR); fi; )
+
+# rule to create the executable
+$(PROJECT_OUT)/$(PROJECT): $(ALL_OBJS)
+	@$(CC) $(ALL_OBJS) $(LIBS) $(LDFLAGS) -o$@
+
+# rule to output project informations
+projectinfo: $(PROJECT_OUT)/$(PROJECT)
+	@echo "-------------------------------------------------------------------------------"
+	@echo "Application successfully built for:"
+	@echo "Processor: $(PROCESSOR)"
+	@echo "Family:    $(FAMILY)"
+	@echo "Board:     $(BOARD)"
+	@echo "LCD:       $(LCD)"
+	@echo "Executable: $(PROJECT_OUT)/$(PROJECT)"
+	@echo "-------------------------------------------------------------------------------"
+	$(SIZE) $(PROJECT_OUT)/$(PROJECT)
+
+# output directories have to be available before objects are created (parallel builds)
+$(ALL_OBJS): | dirs
+
+# default rule for compiling .c programs
+$(PROJECT_OUT)/%.o: %.c
+	@echo Creating object file for $(notdir $<)
+	@$(CC) -MMD -MP $(CFLAGS) -c $< -o $@
+
+$(PROJECT_OUT)/%.o: %.cpp
+	@echo Creating object file for $(notdir $<)
+	@$(CC) -MMD -MP $(CPPFLAGS) -c $< -o $@
+
+# Includes the .d files so it knows the exact dependencies for every
+# source.
+-include $(ALL_DFILES)
+
+# clean temporary files
+clean:
+	rm -rf $(PROJECT_OUT)
+
+# clean temporary files + project image (compatible to common.mk)
+cleanall: clean
@@ -43,6 +43,8 @@ extern "C" {
 # include <mios32_datatypes.h>
 #elif defined(MIOS32_FAMILY_MIOSJUCE)
 # include <mios32_datatypes.h>
+#elif defined(MIOS32_FAMILY_POSIX)
+# include <mios32_datatypes.h>
 #else
 # include <mios32_datatypes.h>
 # warning "Unsupported MIOS32_FAMILY selected!"
@@ -100,6 +102,11 @@ extern "C" {
 #include <mios32_sdcard.h>
 #include <mios32_enc28j60.h>
 
+#if defined(MIOS32_FAMILY_POSIX)
+// host services of the POSIX emulation (located in $MIOS32_PATH/mios32/POSIX)
+#include <mios32_posix.h>
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global definitions
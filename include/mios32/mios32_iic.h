@@ -29,6 +29,8 @@
 #elif defined(MIOS32_FAMILY_LPC17xx)
 // The third IIC port at J4B is disabled by default so that the app can decide if it's used for UART or IIC
 #define MIOS32_IIC_NUM 2
+#elif defined(MIOS32_FAMILY_POSIX) || defined(MIOS32_FAMILY_EMULATION)
+#define MIOS32_IIC_NUM 2
 #else
 #define MIOS32_IIC_NUM 1
 # warning "mios32_iic.h not prepared for this derivative"
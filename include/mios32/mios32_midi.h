@@ -56,6 +56,7 @@
 #define MIOS32_MIDI_SYSEX_DISACK_INVALID_COMMAND      0x0e
 #define MIOS32_MIDI_SYSEX_DISACK_PROG_ID_NOT_ALLOWED  0x0f
 #define MIOS32_MIDI_SYSEX_DISACK_UNSUPPORTED_DEBUG    0x10
+#define MIOS32_MIDI_SYSEX_DISACK_OUT_OF_SEQUENCE      0x11
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -254,6 +255,9 @@ extern s32 MIOS32_MIDI_DirectRxCallback_Init(s32 (*callback_rx)(mios32_midi_port
 extern s32 MIOS32_MIDI_SendByteToRxCallback(mios32_midi_port_t port, u8 midi_byte);
 extern s32 MIOS32_MIDI_SendPackageToRxCallback(mios32_midi_port_t port, mios32_midi_package_t midi_package);
 
+extern s32 MIOS32_MIDI_RxNotifyCallback_Init(void (*callback_rx_notify)(void));
+extern s32 MIOS32_MIDI_RxNotify(void);
+
 extern s32 MIOS32_MIDI_DefaultPortSet(mios32_midi_port_t port);
 extern mios32_midi_port_t MIOS32_MIDI_DefaultPortGet(void);
 
@@ -29,6 +29,18 @@
 #define MIOS32_OSC_MAX_ARGS 8
 #endif
 
+// OSC: number of search tree levels which can be compiled with MIOS32_OSC_CompileSearchTree()
+// 0 disables the compiled dispatcher (default), search trees will be parsed linearly
+#ifndef MIOS32_OSC_COMPILED_LEVELS
+#define MIOS32_OSC_COMPILED_LEVELS 0
+#endif
+
+// OSC: size of the pool for compiled search trees (in halfwords)
+// each level allocates ca. 4 halfwords per node
+#ifndef MIOS32_OSC_COMPILED_POOL_SIZE
+#define MIOS32_OSC_COMPILED_POOL_SIZE 256
+#endif
+
 // the output function which is used to print debug messages
 // could be replaced by printf (e.g. for emulations)
 #ifndef MIOS32_OSC_DEBUG_MSG
@@ -104,6 +116,7 @@ extern mios32_midi_package_t MIOS32_OSC_GetMIDI(u8 *buffer);
 extern u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p);
 
 extern s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree);
+extern s32 MIOS32_OSC_CompileSearchTree(const mios32_osc_search_tree_t *search_tree);
 
 extern s32 MIOS32_OSC_SendDebugMessage(mios32_osc_args_t *osc_args, u32 method_arg);
 
@@ -371,6 +371,9 @@ static void MIOS32_USB_MIDI_RxBufferHandler(u8 bEP)
 	}
       }
 
+      // wake up the MIDI task (if enabled in the programming model)
+      MIOS32_MIDI_RxNotify();
+
       // make sure RD_EN is clear
       LPC_USB->USBCtrl = 0;
 
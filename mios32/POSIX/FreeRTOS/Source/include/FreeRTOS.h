@@ -0,0 +1,33 @@
+/*
+	FreeRTOS Emu (POSIX)
+*/
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+
+/*
+ * Include the generic headers required for the FreeRTOS port being used.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Basic FreeRTOS definitions. */
+#include "projdefs.h"
+
+/* Application specific configuration options. */
+#include "FreeRTOSConfig.h"
+
+/* Definitions specific to the port being used. */
+#include "portable.h"
+
+
+/* Names of the FreeRTOS V8+ API which are used by newer code */
+typedef portTickType TickType_t;
+typedef portBASE_TYPE BaseType_t;
+typedef unsigned portBASE_TYPE UBaseType_t;
+typedef portSTACK_TYPE StackType_t;
+typedef pdTASK_CODE TaskFunction_t;
+
+
+#endif /* INC_FREERTOS_H */
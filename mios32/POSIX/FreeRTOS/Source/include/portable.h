@@ -0,0 +1,35 @@
+/*
+	FreeRTOS Emu (POSIX)
+*/
+
+/*-----------------------------------------------------------
+ * Portable layer API.  Each function must be defined for each port.
+ *----------------------------------------------------------*/
+
+#ifndef PORTABLE_H
+#define PORTABLE_H
+
+/* Include the macro file relevant to the port being used. */
+
+#ifdef MIOS32_FAMILY_POSIX
+	#include "../portable/GCC/POSIX/portmacro.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* the heap is managed by the C library of the host */
+void *pvPortMalloc( size_t xSize );
+void vPortFree( void *pv );
+void vPortInitialiseBlocks( void );
+size_t xPortGetFreeHeapSize( void );
+void vPortMallocDebugInfo( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTABLE_H */
@@ -0,0 +1,44 @@
+/*
+	FreeRTOS Emu (POSIX)
+*/
+
+#ifndef INC_FREERTOS_H
+	#error "#include FreeRTOS.h" must appear in source files before "#include semphr.h"
+#endif
+
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+typedef xQueueHandle xSemaphoreHandle;
+typedef xSemaphoreHandle SemaphoreHandle_t;
+
+#define semGIVE_BLOCK_TIME					( ( portTickType ) 0U )
+
+
+#define vSemaphoreCreateBinary( xSemaphore ) \
+	{ \
+		( xSemaphore ) = xQueueGenericCreate( 1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE ); \
+		if( ( xSemaphore ) != NULL ) \
+			( void ) xSemaphoreGive( ( xSemaphore ) ); \
+	}
+
+#define xSemaphoreCreateBinary() xQueueGenericCreate( 1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE )
+#define xSemaphoreCreateMutex() xQueueCreateMutex( queueQUEUE_TYPE_MUTEX )
+#define xSemaphoreCreateRecursiveMutex() xQueueCreateMutex( queueQUEUE_TYPE_RECURSIVE_MUTEX )
+#define xSemaphoreCreateCounting( uxMaxCount, uxInitialCount ) xQueueCreateCountingSemaphore( ( uxMaxCount ), ( uxInitialCount ) )
+#define vSemaphoreDelete( xSemaphore ) vQueueDelete( ( xQueueHandle ) ( xSemaphore ) )
+
+#define xSemaphoreTake( xSemaphore, xBlockTime ) xQueueGenericReceive( ( xQueueHandle ) ( xSemaphore ), NULL, ( xBlockTime ), pdFALSE )
+#define xSemaphoreGive( xSemaphore ) xQueueGenericSend( ( xQueueHandle ) ( xSemaphore ), NULL, semGIVE_BLOCK_TIME, queueSEND_TO_BACK )
+#define xSemaphoreTakeRecursive( xMutex, xBlockTime ) xQueueTakeMutexRecursive( ( xMutex ), ( xBlockTime ) )
+#define xSemaphoreGiveRecursive( xMutex ) xQueueGiveMutexRecursive( ( xMutex ) )
+
+#define xSemaphoreGiveFromISR( xSemaphore, pxHigherPriorityTaskWoken ) xQueueGenericSendFromISR( ( xQueueHandle ) ( xSemaphore ), NULL, ( pxHigherPriorityTaskWoken ), queueSEND_TO_BACK )
+#define xSemaphoreTakeFromISR( xSemaphore, pxHigherPriorityTaskWoken ) xQueueReceiveFromISR( ( xQueueHandle ) ( xSemaphore ), NULL, ( pxHigherPriorityTaskWoken ) )
+
+#define uxSemaphoreGetCount( xSemaphore ) uxQueueMessagesWaiting( ( xQueueHandle ) ( xSemaphore ) )
+
+#endif /* SEMAPHORE_H */
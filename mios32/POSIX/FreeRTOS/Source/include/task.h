@@ -0,0 +1,85 @@
+/*
+	FreeRTOS Emu (POSIX)
+*/
+
+
+#ifndef INC_FREERTOS_H
+	#error "#include FreeRTOS.h" must appear in source files before "#include task.h"
+#endif
+
+
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "portable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define tskKERNEL_VERSION_NUMBER "POSIX"
+
+/* priorities are accepted but ignored - the host OS schedules the threads */
+#define tskIDLE_PRIORITY			( ( unsigned portBASE_TYPE ) 0 )
+
+#define taskYIELD()					portYIELD()
+#define taskENTER_CRITICAL()		portENTER_CRITICAL()
+#define taskEXIT_CRITICAL()			portEXIT_CRITICAL()
+#define taskDISABLE_INTERRUPTS()	portDISABLE_INTERRUPTS()
+#define taskENABLE_INTERRUPTS()		portENABLE_INTERRUPTS()
+
+#define taskSCHEDULER_NOT_STARTED	( ( portBASE_TYPE ) 1 )
+#define taskSCHEDULER_RUNNING		( ( portBASE_TYPE ) 2 )
+
+typedef struct tskTaskControlBlock *xTaskHandle;
+typedef xTaskHandle TaskHandle_t;
+
+
+signed portBASE_TYPE xTaskCreate( pdTASK_CODE pvTaskCode, const char * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portBASE_TYPE uxPriority, xTaskHandle *pxCreatedTask );
+
+void vTaskDelete( xTaskHandle pxTaskToDelete );
+
+void vTaskStartScheduler( void );
+
+portBASE_TYPE xTaskGetSchedulerState( void );
+
+portTickType xTaskGetTickCount( void );
+
+portTickType xTaskGetTickCountFromISR( void );
+
+void vTaskDelay( portTickType xTicksToDelay );
+
+void vTaskDelayUntil( portTickType * const pxPreviousWakeTime, portTickType xTimeIncrement );
+
+void vTaskSuspend( xTaskHandle pxTaskToSuspend );
+
+void vTaskResume( xTaskHandle pxTaskToResume );
+
+void vTaskSuspendAll( void );
+
+signed portBASE_TYPE xTaskResumeAll( void );
+
+xTaskHandle xTaskGetCurrentTaskHandle( void );
+
+unsigned portBASE_TYPE uxTaskPriorityGet( xTaskHandle pxTask );
+
+void vTaskPrioritySet( xTaskHandle pxTask, unsigned portBASE_TYPE uxNewPriority );
+
+unsigned portBASE_TYPE uxTaskGetNumberOfTasks( void );
+
+void vTaskList( signed char *pcWriteBuffer );
+
+void vTaskGetRunTimeStats( signed char *pcWriteBuffer );
+
+
+/* application hooks (see FreeRTOSConfig.h) */
+extern void vApplicationTickHook( void );
+extern void vApplicationIdleHook( void );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TASK_H */
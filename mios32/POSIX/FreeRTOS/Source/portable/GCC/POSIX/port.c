@@ -0,0 +1,92 @@
+/*
+	FreeRTOS Emu (POSIX)
+
+	Critical sections are mapped to MIOS32_IRQ_Disable/Enable, which lock the
+	recursive mutex that also serializes the emulated interrupt handlers.
+
+	The heap is managed by the C library of the host. Allocated bytes are
+	counted against configTOTAL_HEAP_SIZE, so that xPortGetFreeHeapSize()
+	still reports how much of the target heap an application would consume.
+*/
+
+#include <sched.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include <mios32.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+static size_t xHeapBytesUsed = 0;
+
+
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	MIOS32_IRQ_Disable();
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	MIOS32_IRQ_Enable();
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	sched_yield();
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xSize )
+{
+	void *pvReturn = malloc( xSize );
+
+	if( pvReturn != NULL )
+		__atomic_add_fetch( &xHeapBytesUsed, malloc_usable_size( pvReturn ), __ATOMIC_RELAXED );
+#if configUSE_MALLOC_FAILED_HOOK
+	else if( xSize > 0 )
+	{
+		extern void vApplicationMallocFailedHook( void );
+		vApplicationMallocFailedHook();
+	}
+#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+	if( pv != NULL )
+	{
+		__atomic_sub_fetch( &xHeapBytesUsed, malloc_usable_size( pv ), __ATOMIC_RELAXED );
+		free( pv );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	size_t xUsed = __atomic_load_n( &xHeapBytesUsed, __ATOMIC_RELAXED );
+	return ( xUsed < configTOTAL_HEAP_SIZE ) ? ( configTOTAL_HEAP_SIZE - xUsed ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortMallocDebugInfo( void )
+{
+	s32 heap_size = configTOTAL_HEAP_SIZE;
+	s32 free_heap = xPortGetFreeHeapSize();
+	s32 used_heap = heap_size - free_heap;
+
+	MIOS32_MIDI_SendDebugMessage("Heap: %d of %d bytes used (%d%%), %d bytes free (managed by the host C library)", used_heap, heap_size, (used_heap*100)/heap_size, free_heap);
+}
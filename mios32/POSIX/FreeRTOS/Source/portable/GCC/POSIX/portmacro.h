@@ -0,0 +1,66 @@
+/*
+	FreeRTOS Emu (POSIX)
+*/
+
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		int	/* 32bit like on the target, also with LP64 */
+#define portSHORT		short
+#define portSTACK_TYPE	unsigned portLONG
+#define portBASE_TYPE	long
+
+typedef uint32_t portTickType;
+#define portMAX_DELAY ( portTickType ) 0xffffffff
+
+
+/* Architecture specifics. */
+#define portTICK_RATE_MS			( ( portTickType ) 1000 / configTICK_RATE_HZ )
+#define portTICK_PERIOD_MS			portTICK_RATE_MS
+#define portBYTE_ALIGNMENT			8
+#define portSTACK_GROWTH			( -1 )
+
+
+/* Scheduler utilities.
+ * Tasks are running as POSIX threads, the host OS schedules them. */
+extern void vPortYield( void );
+#define portYIELD()					vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired ) portYIELD()
+#define portYIELD_FROM_ISR( x )		portEND_SWITCHING_ISR( x )
+
+
+/* Critical section management.
+ * There are no interrupts: timer, tick and MIDI receive threads take the same
+ * (recursive) lock like MIOS32_IRQ_Disable() before they call their handlers */
+extern void vPortEnterCritical( void );
+extern void vPortExitCritical( void );
+#define portDISABLE_INTERRUPTS()	vPortEnterCritical()
+#define portENABLE_INTERRUPTS()		vPortExitCritical()
+#define portENTER_CRITICAL()		vPortEnterCritical()
+#define portEXIT_CRITICAL()			vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()		( vPortEnterCritical(), 0 )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	( ( void ) ( x ), vPortExitCritical() )
+
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
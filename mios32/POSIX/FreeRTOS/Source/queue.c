@@ -0,0 +1,337 @@
+/*
+	FreeRTOS Emu (POSIX)
+
+	Queues, semaphores and mutexes are based on a ring buffer which is
+	protected by a pthread mutex. Waiting tasks block on a condition variable
+	which uses CLOCK_MONOTONIC, so that timeouts are not affected by changes
+	of the wall clock.
+
+	Semaphores and mutexes are queues with an item size of 0, the number of
+	"messages" is the semaphore count. Mutexes additionally store the owner
+	thread, which is required for recursive mutexes.
+
+	The FromISR variants never block, and they never request a context
+	switch since the host OS wakes up the waiting threads.
+*/
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+
+typedef struct QueueDefinition
+{
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+
+	unsigned char ucQueueType;
+	unsigned portBASE_TYPE uxLength;
+	unsigned portBASE_TYPE uxItemSize;
+	unsigned portBASE_TYPE uxMessagesWaiting;
+	unsigned portBASE_TYPE uxReadIx;
+	unsigned char *pucItems;
+
+	/* only used by mutexes */
+	pthread_t xOwner;
+	unsigned portBASE_TYPE uxRecursiveCallCount;
+} xQUEUE;
+
+
+/*-----------------------------------------------------------*/
+
+static void prvTimeoutToTimespec( portTickType xTicksToWait, struct timespec *pxTime )
+{
+	clock_gettime( CLOCK_MONOTONIC, pxTime );
+	pxTime->tv_sec += ( xTicksToWait * portTICK_RATE_MS ) / 1000;
+	pxTime->tv_nsec += ( ( xTicksToWait * portTICK_RATE_MS ) % 1000 ) * 1000000L;
+	if( pxTime->tv_nsec >= 1000000000L )
+	{
+		pxTime->tv_nsec -= 1000000000L;
+		++pxTime->tv_sec;
+	}
+}
+
+/* waits for a change of the queue, returns pdFALSE on timeout
+ * must be called with locked queue mutex */
+static portBASE_TYPE prvWait( xQUEUE *pxQueue, portTickType xTicksToWait, const struct timespec *pxTimeout )
+{
+	if( xTicksToWait == 0 )
+		return pdFALSE;
+
+	if( xTicksToWait == portMAX_DELAY )
+	{
+		pthread_cond_wait( &pxQueue->xCond, &pxQueue->xMutex );
+		return pdTRUE;
+	}
+
+	return pthread_cond_timedwait( &pxQueue->xCond, &pxQueue->xMutex, pxTimeout ) == ETIMEDOUT ? pdFALSE : pdTRUE;
+}
+
+static void prvCopyDataToQueue( xQUEUE *pxQueue, const void *pvItemToQueue, portBASE_TYPE xPosition )
+{
+	if( pxQueue->uxItemSize == 0 )
+	{
+		if( pxQueue->ucQueueType == queueQUEUE_TYPE_MUTEX || pxQueue->ucQueueType == queueQUEUE_TYPE_RECURSIVE_MUTEX )
+			pxQueue->uxRecursiveCallCount = 0;
+		++pxQueue->uxMessagesWaiting;
+		return;
+	}
+
+	unsigned portBASE_TYPE uxWriteIx;
+	if( xPosition == queueOVERWRITE && pxQueue->uxMessagesWaiting == pxQueue->uxLength )
+	{
+		uxWriteIx = pxQueue->uxReadIx;
+	}
+	else if( xPosition == queueSEND_TO_FRONT )
+	{
+		pxQueue->uxReadIx = ( pxQueue->uxReadIx + pxQueue->uxLength - 1 ) % pxQueue->uxLength;
+		uxWriteIx = pxQueue->uxReadIx;
+		++pxQueue->uxMessagesWaiting;
+	}
+	else
+	{
+		uxWriteIx = ( pxQueue->uxReadIx + pxQueue->uxMessagesWaiting ) % pxQueue->uxLength;
+		++pxQueue->uxMessagesWaiting;
+	}
+
+	memcpy( &pxQueue->pucItems[ uxWriteIx * pxQueue->uxItemSize ], pvItemToQueue, pxQueue->uxItemSize );
+}
+
+static void prvCopyDataFromQueue( xQUEUE *pxQueue, void *pvBuffer, portBASE_TYPE xJustPeeking )
+{
+	if( pxQueue->uxItemSize > 0 && pvBuffer != NULL )
+		memcpy( pvBuffer, &pxQueue->pucItems[ pxQueue->uxReadIx * pxQueue->uxItemSize ], pxQueue->uxItemSize );
+
+	if( !xJustPeeking )
+	{
+		if( pxQueue->uxItemSize > 0 )
+			pxQueue->uxReadIx = ( pxQueue->uxReadIx + 1 ) % pxQueue->uxLength;
+		--pxQueue->uxMessagesWaiting;
+
+		if( pxQueue->ucQueueType == queueQUEUE_TYPE_MUTEX || pxQueue->ucQueueType == queueQUEUE_TYPE_RECURSIVE_MUTEX )
+		{
+			pxQueue->xOwner = pthread_self();
+			pxQueue->uxRecursiveCallCount = 1;
+		}
+	}
+}
+
+/*-----------------------------------------------------------*/
+
+xQueueHandle xQueueGenericCreate( unsigned portBASE_TYPE uxQueueLength, unsigned portBASE_TYPE uxItemSize, unsigned char ucQueueType )
+{
+	xQUEUE *pxQueue;
+	pthread_condattr_t xCondAttr;
+
+	if( uxQueueLength == 0 )
+		return NULL;
+
+	pxQueue = ( xQUEUE * ) calloc( 1, sizeof( xQUEUE ) );
+	if( pxQueue == NULL )
+		return NULL;
+
+	if( uxItemSize > 0 )
+	{
+		pxQueue->pucItems = ( unsigned char * ) malloc( uxQueueLength * uxItemSize );
+		if( pxQueue->pucItems == NULL )
+		{
+			free( pxQueue );
+			return NULL;
+		}
+	}
+
+	pxQueue->ucQueueType = ucQueueType;
+	pxQueue->uxLength = uxQueueLength;
+	pxQueue->uxItemSize = uxItemSize;
+
+	pthread_mutex_init( &pxQueue->xMutex, NULL );
+	pthread_condattr_init( &xCondAttr );
+	pthread_condattr_setclock( &xCondAttr, CLOCK_MONOTONIC );
+	pthread_cond_init( &pxQueue->xCond, &xCondAttr );
+	pthread_condattr_destroy( &xCondAttr );
+
+	return pxQueue;
+}
+/*-----------------------------------------------------------*/
+
+xQueueHandle xQueueCreateMutex( unsigned char ucQueueType )
+{
+	xQUEUE *pxQueue = xQueueGenericCreate( 1, 0, ucQueueType );
+
+	/* mutexes are available after creation */
+	if( pxQueue != NULL )
+		pxQueue->uxMessagesWaiting = 1;
+
+	return pxQueue;
+}
+/*-----------------------------------------------------------*/
+
+xQueueHandle xQueueCreateCountingSemaphore( unsigned portBASE_TYPE uxMaxCount, unsigned portBASE_TYPE uxInitialCount )
+{
+	xQUEUE *pxQueue = xQueueGenericCreate( uxMaxCount, 0, queueQUEUE_TYPE_COUNTING_SEMAPHORE );
+
+	if( pxQueue != NULL )
+		pxQueue->uxMessagesWaiting = uxInitialCount;
+
+	return pxQueue;
+}
+/*-----------------------------------------------------------*/
+
+void vQueueDelete( xQueueHandle xQueue )
+{
+	pthread_cond_destroy( &xQueue->xCond );
+	pthread_mutex_destroy( &xQueue->xMutex );
+	free( xQueue->pucItems );
+	free( xQueue );
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueGenericReset( xQueueHandle xQueue, signed portBASE_TYPE xNewQueue )
+{
+	( void ) xNewQueue;
+
+	pthread_mutex_lock( &xQueue->xMutex );
+	xQueue->uxMessagesWaiting = 0;
+	xQueue->uxReadIx = 0;
+	pthread_cond_broadcast( &xQueue->xCond );
+	pthread_mutex_unlock( &xQueue->xMutex );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueGenericSend( xQueueHandle xQueue, const void * const pvItemToQueue, portTickType xTicksToWait, portBASE_TYPE xCopyPosition )
+{
+	struct timespec xTimeout;
+
+	if( xTicksToWait != 0 && xTicksToWait != portMAX_DELAY )
+		prvTimeoutToTimespec( xTicksToWait, &xTimeout );
+
+	pthread_mutex_lock( &xQueue->xMutex );
+	for( ;; )
+	{
+		if( xQueue->uxMessagesWaiting < xQueue->uxLength || xCopyPosition == queueOVERWRITE )
+		{
+			prvCopyDataToQueue( xQueue, pvItemToQueue, xCopyPosition );
+			pthread_cond_broadcast( &xQueue->xCond );
+			pthread_mutex_unlock( &xQueue->xMutex );
+			return pdPASS;
+		}
+
+		if( !prvWait( xQueue, xTicksToWait, &xTimeout ) )
+		{
+			pthread_mutex_unlock( &xQueue->xMutex );
+			return errQUEUE_FULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueGenericSendFromISR( xQueueHandle xQueue, const void * const pvItemToQueue, signed portBASE_TYPE *pxHigherPriorityTaskWoken, portBASE_TYPE xCopyPosition )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+		*pxHigherPriorityTaskWoken = pdFALSE;
+
+	return xQueueGenericSend( xQueue, pvItemToQueue, 0, xCopyPosition );
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueGenericReceive( xQueueHandle xQueue, void * const pvBuffer, portTickType xTicksToWait, portBASE_TYPE xJustPeeking )
+{
+	struct timespec xTimeout;
+
+	if( xTicksToWait != 0 && xTicksToWait != portMAX_DELAY )
+		prvTimeoutToTimespec( xTicksToWait, &xTimeout );
+
+	pthread_mutex_lock( &xQueue->xMutex );
+	for( ;; )
+	{
+		if( xQueue->uxMessagesWaiting > 0 )
+		{
+			prvCopyDataFromQueue( xQueue, pvBuffer, xJustPeeking );
+			pthread_cond_broadcast( &xQueue->xCond );
+			pthread_mutex_unlock( &xQueue->xMutex );
+			return pdPASS;
+		}
+
+		if( !prvWait( xQueue, xTicksToWait, &xTimeout ) )
+		{
+			pthread_mutex_unlock( &xQueue->xMutex );
+			return errQUEUE_EMPTY;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueReceiveFromISR( xQueueHandle xQueue, void * const pvBuffer, signed portBASE_TYPE *pxHigherPriorityTaskWoken )
+{
+	if( pxHigherPriorityTaskWoken != NULL )
+		*pxHigherPriorityTaskWoken = pdFALSE;
+
+	return xQueueGenericReceive( xQueue, pvBuffer, 0, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueTakeMutexRecursive( xQueueHandle xMutex, portTickType xTicksToWait )
+{
+	pthread_mutex_lock( &xMutex->xMutex );
+	if( xMutex->uxMessagesWaiting == 0 && xMutex->uxRecursiveCallCount > 0 && pthread_equal( xMutex->xOwner, pthread_self() ) )
+	{
+		++xMutex->uxRecursiveCallCount;
+		pthread_mutex_unlock( &xMutex->xMutex );
+		return pdPASS;
+	}
+	pthread_mutex_unlock( &xMutex->xMutex );
+
+	return xQueueGenericReceive( xMutex, NULL, xTicksToWait, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xQueueGiveMutexRecursive( xQueueHandle xMutex )
+{
+	pthread_mutex_lock( &xMutex->xMutex );
+	if( xMutex->uxMessagesWaiting > 0 || xMutex->uxRecursiveCallCount == 0 || !pthread_equal( xMutex->xOwner, pthread_self() ) )
+	{
+		pthread_mutex_unlock( &xMutex->xMutex );
+		return pdFAIL; /* not the owner */
+	}
+
+	if( --xMutex->uxRecursiveCallCount == 0 )
+	{
+		xMutex->uxMessagesWaiting = 1;
+		pthread_cond_broadcast( &xMutex->xCond );
+	}
+	pthread_mutex_unlock( &xMutex->xMutex );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portBASE_TYPE uxQueueMessagesWaiting( const xQueueHandle xQueue )
+{
+	unsigned portBASE_TYPE uxReturn;
+
+	pthread_mutex_lock( &xQueue->xMutex );
+	uxReturn = xQueue->uxMessagesWaiting;
+	pthread_mutex_unlock( &xQueue->xMutex );
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portBASE_TYPE uxQueueSpacesAvailable( const xQueueHandle xQueue )
+{
+	unsigned portBASE_TYPE uxReturn;
+
+	pthread_mutex_lock( &xQueue->xMutex );
+	uxReturn = xQueue->uxLength - xQueue->uxMessagesWaiting;
+	pthread_mutex_unlock( &xQueue->xMutex );
+
+	return uxReturn;
+}
@@ -0,0 +1,387 @@
+/*
+	FreeRTOS Emu (POSIX)
+
+	Each task is a POSIX thread which starts once vTaskStartScheduler() has
+	been called. The thread which called vTaskStartScheduler() continues as
+	idle task.
+
+	The tick count is derived from CLOCK_MONOTONIC (1 tick = 1 mS), and delays
+	are absolute clock_nanosleep() calls, so that periodic tasks don't drift.
+	A separate thread calls vApplicationTickHook() each mS within a critical
+	section, like the SysTick IRQ does on the target.
+
+	Task priorities are stored, but ignored: the host OS schedules the threads.
+	Only the calling task can suspend or delete itself.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+typedef struct tskTaskControlBlock
+{
+	pthread_t xThread;
+	pdTASK_CODE pxTaskCode;
+	void *pvParameters;
+	unsigned portBASE_TYPE uxPriority;
+	unsigned portBASE_TYPE uxTaskNumber;
+	unsigned char ucSuspended;
+	char pcTaskName[ configMAX_TASK_NAME_LEN ];
+	struct tskTaskControlBlock *pxNext;
+} tskTCB;
+
+
+/* protects the task list, the scheduler start and the suspend flags */
+static pthread_mutex_t xTaskMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xTaskCond = PTHREAD_COND_INITIALIZER;
+
+static tskTCB *pxTaskList = NULL;
+static unsigned portBASE_TYPE uxCurrentNumberOfTasks = 0;
+static unsigned portBASE_TYPE uxTaskNumber = 0;
+
+static portBASE_TYPE xSchedulerRunning = pdFALSE;
+static struct timespec xStartTime;
+
+static __thread tskTCB *pxCurrentTCB = NULL;
+
+
+/*-----------------------------------------------------------*/
+
+/* absolute CLOCK_MONOTONIC time of the given tick */
+static void prvTickToTimespec( portTickType xTick, struct timespec *pxTime )
+{
+	/* the tick counter wraps after 49 days - calculate relative to the current tick */
+	struct timespec xNow;
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	long long llNowMs = ( xNow.tv_sec - xStartTime.tv_sec ) * 1000LL + ( xNow.tv_nsec - xStartTime.tv_nsec ) / 1000000LL;
+	long long llTickMs = llNowMs + ( int32_t ) ( xTick - ( portTickType ) llNowMs );
+
+	pxTime->tv_sec = xStartTime.tv_sec + llTickMs / 1000;
+	pxTime->tv_nsec = xStartTime.tv_nsec + ( llTickMs % 1000 ) * 1000000L;
+	if( pxTime->tv_nsec >= 1000000000L )
+	{
+		pxTime->tv_nsec -= 1000000000L;
+		++pxTime->tv_sec;
+	}
+}
+
+static void prvSleepUntilTick( portTickType xTick )
+{
+	struct timespec xWakeTime;
+	prvTickToTimespec( xTick, &xWakeTime );
+	while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xWakeTime, NULL ) == EINTR );
+}
+
+/*-----------------------------------------------------------*/
+
+static void *prvTaskThread( void *pvParameters )
+{
+	tskTCB *pxTCB = ( tskTCB * ) pvParameters;
+	pxCurrentTCB = pxTCB;
+
+	/* wait for vTaskStartScheduler() */
+	pthread_mutex_lock( &xTaskMutex );
+	while( !xSchedulerRunning )
+		pthread_cond_wait( &xTaskCond, &xTaskMutex );
+	pthread_mutex_unlock( &xTaskMutex );
+
+	pxTCB->pxTaskCode( pxTCB->pvParameters );
+
+	/* tasks shouldn't return - handle it like on the target */
+	vTaskDelete( NULL );
+	return NULL;
+}
+
+static void *prvTickThread( void *pvParameters )
+{
+	portTickType xTick = 0;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		prvSleepUntilTick( ++xTick );
+
+		/* skip ticks if the host couldn't serve the thread for more than 5 mS */
+		portTickType xCurrentTick = xTaskGetTickCount();
+		if( ( int32_t ) ( xCurrentTick - xTick ) > 5 )
+			xTick = xCurrentTick;
+
+#if configUSE_TICK_HOOK
+		portENTER_CRITICAL();
+		vApplicationTickHook();
+		portEXIT_CRITICAL();
+#endif
+	}
+
+	return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xTaskCreate( pdTASK_CODE pvTaskCode, const char * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portBASE_TYPE uxPriority, xTaskHandle *pxCreatedTask )
+{
+	/* the stack depth is ignored: threads get the default stack of the host */
+	( void ) usStackDepth;
+
+	tskTCB *pxTCB = ( tskTCB * ) calloc( 1, sizeof( tskTCB ) );
+	if( pxTCB == NULL )
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+
+	pxTCB->pxTaskCode = pvTaskCode;
+	pxTCB->pvParameters = pvParameters;
+	pxTCB->uxPriority = uxPriority;
+	strncpy( pxTCB->pcTaskName, pcName ? pcName : "", configMAX_TASK_NAME_LEN - 1 );
+
+	pthread_mutex_lock( &xTaskMutex );
+	pxTCB->uxTaskNumber = ++uxTaskNumber;
+	pxTCB->pxNext = pxTaskList;
+	pxTaskList = pxTCB;
+	++uxCurrentNumberOfTasks;
+
+	if( pthread_create( &pxTCB->xThread, NULL, prvTaskThread, pxTCB ) != 0 )
+	{
+		pxTaskList = pxTCB->pxNext;
+		--uxCurrentNumberOfTasks;
+		pthread_mutex_unlock( &xTaskMutex );
+		free( pxTCB );
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+	pthread_detach( pxTCB->xThread );
+	pthread_mutex_unlock( &xTaskMutex );
+
+	if( pxCreatedTask != NULL )
+		*pxCreatedTask = pxTCB;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelete( xTaskHandle pxTaskToDelete )
+{
+	tskTCB *pxTCB = pxTaskToDelete ? pxTaskToDelete : pxCurrentTCB;
+	tskTCB **ppxIterator;
+
+	if( pxTCB == NULL || pxTCB != pxCurrentTCB )
+		return; /* not supported by the emulation */
+
+	pthread_mutex_lock( &xTaskMutex );
+	for( ppxIterator = &pxTaskList; *ppxIterator != NULL; ppxIterator = &( *ppxIterator )->pxNext )
+	{
+		if( *ppxIterator == pxTCB )
+		{
+			*ppxIterator = pxTCB->pxNext;
+			--uxCurrentNumberOfTasks;
+			break;
+		}
+	}
+	pthread_mutex_unlock( &xTaskMutex );
+
+	free( pxTCB );
+	pxCurrentTCB = NULL;
+	pthread_exit( NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskStartScheduler( void )
+{
+	pthread_t xTickThread;
+
+	pthread_mutex_lock( &xTaskMutex );
+	clock_gettime( CLOCK_MONOTONIC, &xStartTime );
+	__atomic_store_n( &xSchedulerRunning, pdTRUE, __ATOMIC_RELEASE );
+	pthread_cond_broadcast( &xTaskCond );
+	pthread_mutex_unlock( &xTaskMutex );
+
+	if( pthread_create( &xTickThread, NULL, prvTickThread, NULL ) != 0 )
+	{
+		perror( "vTaskStartScheduler" );
+		return;
+	}
+
+	/* the calling thread continues as idle task */
+	for( ;; )
+	{
+#if configUSE_IDLE_HOOK
+		vApplicationIdleHook();
+#endif
+		/* leave the CPU to the tasks and other processes */
+		struct timespec xDelay = { 0, 1000000L };
+		nanosleep( &xDelay, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xTaskGetSchedulerState( void )
+{
+	return __atomic_load_n( &xSchedulerRunning, __ATOMIC_ACQUIRE ) ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+/*-----------------------------------------------------------*/
+
+portTickType xTaskGetTickCount( void )
+{
+	struct timespec xNow;
+
+	if( !__atomic_load_n( &xSchedulerRunning, __ATOMIC_ACQUIRE ) )
+		return 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( portTickType ) ( ( xNow.tv_sec - xStartTime.tv_sec ) * 1000LL + ( xNow.tv_nsec - xStartTime.tv_nsec ) / 1000000LL );
+}
+/*-----------------------------------------------------------*/
+
+portTickType xTaskGetTickCountFromISR( void )
+{
+	return xTaskGetTickCount();
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( portTickType xTicksToDelay )
+{
+	if( xTicksToDelay == 0 )
+		sched_yield();
+	else
+		prvSleepUntilTick( xTaskGetTickCount() + xTicksToDelay );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUntil( portTickType * const pxPreviousWakeTime, portTickType xTimeIncrement )
+{
+	portTickType xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
+	*pxPreviousWakeTime = xTimeToWake;
+
+	if( ( int32_t ) ( xTimeToWake - xTaskGetTickCount() ) > 0 )
+		prvSleepUntilTick( xTimeToWake );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSuspend( xTaskHandle pxTaskToSuspend )
+{
+	tskTCB *pxTCB = pxTaskToSuspend ? pxTaskToSuspend : pxCurrentTCB;
+
+	if( pxTCB == NULL || pxTCB != pxCurrentTCB )
+		return; /* not supported by the emulation */
+
+	pthread_mutex_lock( &xTaskMutex );
+	pxTCB->ucSuspended = pdTRUE;
+	while( pxTCB->ucSuspended )
+		pthread_cond_wait( &xTaskCond, &xTaskMutex );
+	pthread_mutex_unlock( &xTaskMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskResume( xTaskHandle pxTaskToResume )
+{
+	if( pxTaskToResume == NULL )
+		return;
+
+	pthread_mutex_lock( &xTaskMutex );
+	pxTaskToResume->ucSuspended = pdFALSE;
+	pthread_cond_broadcast( &xTaskCond );
+	pthread_mutex_unlock( &xTaskMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskSuspendAll( void )
+{
+	/* no task switches can be prevented - block the emulated IRQs and all other critical sections instead */
+	portENTER_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+signed portBASE_TYPE xTaskResumeAll( void )
+{
+	portEXIT_CRITICAL();
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+xTaskHandle xTaskGetCurrentTaskHandle( void )
+{
+	return pxCurrentTCB;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portBASE_TYPE uxTaskPriorityGet( xTaskHandle pxTask )
+{
+	tskTCB *pxTCB = pxTask ? pxTask : pxCurrentTCB;
+	return pxTCB ? pxTCB->uxPriority : tskIDLE_PRIORITY;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskPrioritySet( xTaskHandle pxTask, unsigned portBASE_TYPE uxNewPriority )
+{
+	tskTCB *pxTCB = pxTask ? pxTask : pxCurrentTCB;
+	if( pxTCB != NULL )
+		pxTCB->uxPriority = uxNewPriority;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portBASE_TYPE uxTaskGetNumberOfTasks( void )
+{
+	return uxCurrentNumberOfTasks;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskList( signed char *pcWriteBuffer )
+{
+	tskTCB *pxTCB;
+	char *pcBuffer = ( char * ) pcWriteBuffer;
+
+	*pcBuffer = 0;
+
+	pthread_mutex_lock( &xTaskMutex );
+	for( pxTCB = pxTaskList; pxTCB != NULL; pxTCB = pxTCB->pxNext )
+	{
+		/* state and stack high water mark aren't available */
+		pcBuffer += sprintf( pcBuffer, "%s\t\t%c\t%u\t%u\t%u\r\n",
+							 pxTCB->pcTaskName,
+							 pxTCB->ucSuspended ? 'S' : 'R',
+							 ( unsigned ) pxTCB->uxPriority,
+							 0,
+							 ( unsigned ) pxTCB->uxTaskNumber );
+	}
+	pthread_mutex_unlock( &xTaskMutex );
+}
+/*-----------------------------------------------------------*/
+
+void vTaskGetRunTimeStats( signed char *pcWriteBuffer )
+{
+	tskTCB *pxTCB;
+	char *pcBuffer = ( char * ) pcWriteBuffer;
+	struct timespec xTime;
+	unsigned long long ullTotalTime;
+
+	*pcBuffer = 0;
+
+	/* CPU time of the threads in uS, percentage of the CPU time of the process */
+	clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &xTime );
+	ullTotalTime = xTime.tv_sec * 1000000ULL + xTime.tv_nsec / 1000;
+	if( ullTotalTime == 0 )
+		ullTotalTime = 1;
+
+	pthread_mutex_lock( &xTaskMutex );
+	for( pxTCB = pxTaskList; pxTCB != NULL; pxTCB = pxTCB->pxNext )
+	{
+		clockid_t xClock;
+		unsigned long long ullTaskTime = 0;
+
+		if( pthread_getcpuclockid( pxTCB->xThread, &xClock ) == 0 && clock_gettime( xClock, &xTime ) == 0 )
+			ullTaskTime = xTime.tv_sec * 1000000ULL + xTime.tv_nsec / 1000;
+
+		unsigned uPercentage = ( unsigned ) ( ( ullTaskTime * 100 ) / ullTotalTime );
+		if( uPercentage > 0 )
+			pcBuffer += sprintf( pcBuffer, "%s\t\t%llu\t\t%u%%\r\n", pxTCB->pcTaskName, ullTaskTime, uPercentage );
+		else
+			pcBuffer += sprintf( pcBuffer, "%s\t\t%llu\t\t<1%%\r\n", pxTCB->pcTaskName, ullTaskTime );
+	}
+	pthread_mutex_unlock( &xTaskMutex );
+}
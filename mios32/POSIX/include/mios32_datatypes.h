@@ -0,0 +1,72 @@
+// $Id$
+/*
+ * Defines data types for 32bit processors
+ * compatible with stm32f10x.h
+ *
+ * Variant for host builds on LP64 systems (e.g. Linux x86_64), where long
+ * is 64bit wide: int is used for the 32bit types instead.
+ * Host builds put $(MIOS32_PATH)/mios32/POSIX/include in front of
+ * $(MIOS32_PATH)/include/mios32, so that this file replaces the original
+ * mios32_datatypes.h
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_DATATYPES_H
+#define _MIOS32_DATATYPES_H
+
+// following check to ensure that typedefs won't be declared again from stm32f10x.h
+#if !defined(__STM32F10x_H) && !defined(__STM32F4xx_H)
+
+typedef signed int   s32;
+typedef signed short s16;
+typedef signed char  s8;
+
+typedef signed int   const sc32;  /* Read Only */
+typedef signed short const sc16;  /* Read Only */
+typedef signed char  const sc8;   /* Read Only */
+
+typedef volatile signed int   vs32;
+typedef volatile signed short vs16;
+typedef volatile signed char  vs8;
+
+typedef volatile signed int   const vsc32;  /* Read Only */
+typedef volatile signed short const vsc16;  /* Read Only */
+typedef volatile signed char  const vsc8;   /* Read Only */
+
+typedef unsigned int   u32;
+typedef unsigned short u16;
+typedef unsigned char  u8;
+
+typedef unsigned int   const uc32;  /* Read Only */
+typedef unsigned short const uc16;  /* Read Only */
+typedef unsigned char  const uc8;   /* Read Only */
+
+typedef volatile unsigned int   vu32;
+typedef volatile unsigned short vu16;
+typedef volatile unsigned char  vu8;
+
+typedef volatile unsigned int   const vuc32;  /* Read Only */
+typedef volatile unsigned short const vuc16;  /* Read Only */
+typedef volatile unsigned char  const vuc8;   /* Read Only */
+
+#define U8_MAX     ((u8)255)
+#define S8_MAX     ((s8)127)
+#define S8_MIN     ((s8)-128)
+#define U16_MAX    ((u16)65535u)
+#define S16_MAX    ((s16)32767)
+#define S16_MIN    ((s16)-32768)
+#define U32_MAX    ((u32)4294967295uL)
+#define S32_MAX    ((s32)2147483647)
+#define S32_MIN    ((s32)-2147483648)
+
+#endif
+
+#endif /* _MIOS32_DATATYPES_H */
+
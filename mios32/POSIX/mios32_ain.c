@@ -0,0 +1,159 @@
+// $Id$
+//! \defgroup MIOS32_AIN
+//!
+//! AIN driver for the POSIX emulation
+//! 
+//! No analog inputs are available on the host: MIOS32_AIN_PinGet() returns
+//! 0 for all pins which are enabled in MIOS32_AIN_CHANNEL_MASK, and the
+//! handler never notifies changes.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_AIN)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of pins like on the target (8 analog channels, multiplied by MUX pins)
+#define NUM_AIN_PINS (8 * (1 << MIOS32_AIN_MUX_PINS))
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_AIN_CHANNEL_MASK
+static u16 ain_deadband;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes AIN driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no AIN pins selected
+#else
+  ain_deadband = MIOS32_AIN_DEADBAND;
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs a service prepare callback function (never called by the emulation)
+//! \param[in] *_callback_service_prepare pointer to callback function
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_ServicePrepareCallback_Init(void *_service_prepare_callback)
+{
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns value of an AIN Pin
+//! \param[in] pin number
+//! \return AIN pin value (always 0)
+//! \return -1 if pin doesn't exist
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_PinGet(u32 pin)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  // check if pin exists
+  if( pin >= NUM_AIN_PINS )
+    return -1;
+
+  return 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return the deadband which is used to notify changes
+//! \return < 0 on error
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_DeadbandGet(void)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return ain_deadband;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sets the difference between last and current pot value which has to
+//! be achieved to trigger the callback function passed to AINSER_Handler()
+//! \return < 0 on error
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_DeadbandSet(u16 deadband)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  ain_deadband = deadband;
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks for pin changes (there are none on the host)
+//! \param[in] _callback pointer to callback function
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_Handler(void *_callback)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts an ADC conversion (nothing to do on the host)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_AIN_StartConversions(void)
+{
+#if !MIOS32_AIN_CHANNEL_MASK
+  return -1; // no analog input selected
+#else
+  return 0; // no error
+#endif
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_AIN */
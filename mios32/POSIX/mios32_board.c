@@ -0,0 +1,535 @@
+// $Id$
+//! \defgroup MIOS32_BOARD
+//!
+//! Development Board specific functions for the POSIX emulation
+//!
+//! There is no hardware behind the pins: the J5/J10 pin states and the
+//! LEDs are stored in variables, so that an application reads back what it
+//! has written. Inputs with pull-up read 1, all other inputs read 0.
+//! The J15 LCD port accepts all accesses and never reports a busy display,
+//! the data is dropped.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_BOARD)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// same like MBHP_CORE_STM32F4
+#if !defined(MIOS32_BOARD_J15_LED_NUM)
+# define MIOS32_BOARD_J15_LED_NUM 4
+#endif
+
+#define J5_NUM_PINS  8
+#define J10_NUM_PINS 16
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u16 enable_mask;
+  u16 input_mask;
+  u16 pullup_mask;
+  u16 output_value;
+} emu_port_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if !defined(MIOS32_DONT_USE_BOARD_LED)
+static u32 led_value;
+#endif
+#if !defined(MIOS32_DONT_USE_BOARD_J5)
+static emu_port_t j5;
+#endif
+#if !defined(MIOS32_DONT_USE_BOARD_J10)
+static emu_port_t j10;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes MIOS32_BOARD driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+#if !defined(MIOS32_DONT_USE_BOARD_J5)
+  j5.enable_mask = 0;
+#endif
+#if !defined(MIOS32_DONT_USE_BOARD_J10)
+  j10.enable_mask = 0;
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internally used help functions which emulate a port
+/////////////////////////////////////////////////////////////////////////////
+#if !defined(MIOS32_DONT_USE_BOARD_J5) || !defined(MIOS32_DONT_USE_BOARD_J10)
+static s32 MIOS32_BOARD_PortPinInitHlp(emu_port_t *port, u8 pin, mios32_board_pin_mode_t mode)
+{
+  u16 mask = 1 << pin;
+
+  switch( mode ) {
+  case MIOS32_BOARD_PIN_MODE_IGNORE:
+    port->enable_mask &= ~mask;
+    return 0; // don't touch
+  case MIOS32_BOARD_PIN_MODE_ANALOG:
+  case MIOS32_BOARD_PIN_MODE_INPUT:
+  case MIOS32_BOARD_PIN_MODE_INPUT_PD:
+    port->input_mask |= mask;
+    port->pullup_mask &= ~mask;
+    break;
+  case MIOS32_BOARD_PIN_MODE_INPUT_PU:
+    port->input_mask |= mask;
+    port->pullup_mask |= mask;
+    break;
+  case MIOS32_BOARD_PIN_MODE_OUTPUT_PP:
+  case MIOS32_BOARD_PIN_MODE_OUTPUT_OD:
+    port->input_mask &= ~mask;
+    break;
+  default:
+    return -2; // invalid pin mode
+  }
+
+  port->enable_mask |= mask;
+
+  return 0; // no error
+}
+
+static s32 MIOS32_BOARD_PortSetHlp(emu_port_t *port, u16 value, u16 mask)
+{
+  mask &= port->enable_mask;
+  port->output_value = (port->output_value & ~mask) | (value & mask);
+
+  return 0; // no error
+}
+
+static s32 MIOS32_BOARD_PortGetHlp(emu_port_t *port)
+{
+  // outputs read back their value, inputs their pull device
+  u16 value = (port->output_value & ~port->input_mask) | (port->pullup_mask & port->input_mask);
+
+  return value & port->enable_mask;
+}
+#endif
+
+
+#if !defined(MIOS32_DONT_USE_BOARD_LED)
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes LEDs of the board
+//! \param[in] leds mask contains a flag for each LED which should be initialized<BR>
+//! <UL>
+//!   <LI>POSIX: 4 LEDs like MBHP_CORE_STM32F4 (flag 0: green, flag1: orange, flag2: red, flag3: blue)
+//! </UL>
+//! \return 0 if initialisation passed
+//! \return -1 if no LEDs specified for board
+//! \return -2 if one or more LEDs not available on board
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_LED_Init(u32 leds)
+{
+  if( leds & ~((1 << MIOS32_BOARD_J15_LED_NUM)-1) )
+    return -2; // LED doesn't exist
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sets one or more LEDs to the given value(s)
+//! \param[in] leds mask contains a flag for each LED which should be changed
+//! \param[in] value contains the value which should be set
+//! \return 0 if initialisation passed
+//! \return -1 if no LEDs specified for board
+//! \return -2 if one or more LEDs not available on board
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_LED_Set(u32 leds, u32 value)
+{
+  u32 available = (1 << MIOS32_BOARD_J15_LED_NUM)-1;
+
+  led_value = (led_value & ~(leds & available)) | (value & leds & available);
+
+  if( leds & ~available )
+    return -2; // LED doesn't exist
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the status of all LEDs
+//! \return status of all LEDs
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_BOARD_LED_Get(void)
+{
+  return led_value;
+}
+
+#endif
+
+#if !defined(MIOS32_DONT_USE_BOARD_J5)
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes a J5 pin
+//! \param[in] pin the pin number (0..7)
+//! \param[in] mode the pin mode
+//!   <UL>
+//!     <LI>MIOS32_BOARD_PIN_MODE_IGNORE: configuration shouldn't be touched
+//!     <LI>MIOS32_BOARD_PIN_MODE_ANALOG: select analog input mode (default)
+//!     <LI>MIOS32_BOARD_PIN_MODE_INPUT: pin is used as input w/o pull device (floating)
+//!     <LI>MIOS32_BOARD_PIN_MODE_INPUT_PD: pin is used as input, internal pull down enabled
+//!     <LI>MIOS32_BOARD_PIN_MODE_INPUT_PU: pin is used as input, internal pull up enabled
+//!     <LI>MIOS32_BOARD_PIN_MODE_OUTPUT_PP: pin is used as output in push-pull mode
+//!     <LI>MIOS32_BOARD_PIN_MODE_OUTPUT_OD: pin is used as output in open drain mode
+//!   </UL>
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  if( pin >= J5_NUM_PINS )
+    return -1; // pin not supported
+
+  return MIOS32_BOARD_PortPinInitHlp(&j5, pin, mode);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets all pins of J5 at once
+//! \param[in] value 8 bits which are forwarded to J5A/B
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_Set(u16 value)
+{
+  return MIOS32_BOARD_PortSetHlp(&j5, value, 0xffff);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets a single pin of J5
+//! \param[in] pin the pin number (0..7)
+//! \param[in] value the pin value (0 or 1)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_PinSet(u8 pin, u8 value)
+{
+  if( pin >= J5_NUM_PINS )
+    return -1; // pin not supported
+
+  if( !(j5.enable_mask & (1 << pin)) )
+    return -2; // pin disabled
+
+  return MIOS32_BOARD_PortSetHlp(&j5, value ? 0xffff : 0x0000, 1 << pin);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of all pins of J5
+//! \return 8 bits which are forwarded from J5A/B
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_Get(void)
+{
+  return MIOS32_BOARD_PortGetHlp(&j5);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of a single pin of J5
+//! \param[in] pin the pin number (0..7)
+//! \return < 0 if pin not available
+//! \return >= 0: input state of pin
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J5_PinGet(u8 pin)
+{
+  if( pin >= J5_NUM_PINS )
+    return -1; // pin not supported
+
+  if( !(j5.enable_mask & (1 << pin)) )
+    return -2; // pin disabled
+
+  return (MIOS32_BOARD_PortGetHlp(&j5) >> pin) & 1;
+}
+
+#endif
+
+#if !defined(MIOS32_DONT_USE_BOARD_J10)
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes a J10 pin
+//! \param[in] pin the pin number (0..15)
+//! \param[in] mode the pin mode (see MIOS32_BOARD_J5_PinInit())
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  if( pin >= J10_NUM_PINS )
+    return -1; // pin not supported
+
+  return MIOS32_BOARD_PortPinInitHlp(&j10, pin, mode);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets all pins of J10 at once
+//! \param[in] value 16 bits which are forwarded to J10
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_Set(u16 value)
+{
+  return MIOS32_BOARD_PortSetHlp(&j10, value, 0xffff);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets a single pin of J10
+//! \param[in] pin the pin number (0..15)
+//! \param[in] value the pin value (0 or 1)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_PinSet(u8 pin, u8 value)
+{
+  if( pin >= J10_NUM_PINS )
+    return -1; // pin not supported
+
+  if( !(j10.enable_mask & (1 << pin)) )
+    return -2; // pin disabled
+
+  return MIOS32_BOARD_PortSetHlp(&j10, value ? 0xffff : 0x0000, 1 << pin);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of all pins of J10
+//! \return 16 bits which are forwarded from J10
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_Get(void)
+{
+  return MIOS32_BOARD_PortGetHlp(&j10);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of a single pin of J10
+//! \param[in] pin the pin number (0..15)
+//! \return < 0 if pin not available
+//! \return >= 0: input state of pin
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10_PinGet(u8 pin)
+{
+  if( pin >= J10_NUM_PINS )
+    return -1; // pin not supported
+
+  if( !(j10.enable_mask & (1 << pin)) )
+    return -2; // pin disabled
+
+  return (MIOS32_BOARD_PortGetHlp(&j10) >> pin) & 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of all pins of J10A (J10[7:0])
+//! \return 8 bits which are forwarded from J10A
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10A_Get(void)
+{
+  return MIOS32_BOARD_PortGetHlp(&j10) & 0xff;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets all pins of J10A (J10[7:0]) at once
+//! \param[in] value 8 bits which are forwarded to J10A
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10A_Set(u8 value)
+{
+  return MIOS32_BOARD_PortSetHlp(&j10, value, 0x00ff);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of all pins of J10B (J10[15:8])
+//! \return 8 bits which are forwarded from J10B
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10B_Get(void)
+{
+  return MIOS32_BOARD_PortGetHlp(&j10) >> 8;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sets all pins of J10B (J10[15:8]) at once
+//! \param[in] value 8 bits which are forwarded to J10B
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J10B_Set(u8 value)
+{
+  return MIOS32_BOARD_PortSetHlp(&j10, (u16)value << 8, 0xff00);
+}
+
+#endif
+
+#if !defined(MIOS32_DONT_USE_BOARD_J28)
+
+/////////////////////////////////////////////////////////////////////////////
+//! J28 is not available (like on MBHP_CORE_STM32F4)
+//! \return -1
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J28_PinInit(u8 pin, mios32_board_pin_mode_t mode)
+{
+  return -1; // MIOS32_BOARD_J28 not supported
+}
+
+s32 MIOS32_BOARD_J28_Set(u16 value)
+{
+  return -1; // MIOS32_BOARD_J28 not supported
+}
+
+s32 MIOS32_BOARD_J28_PinSet(u8 pin, u8 value)
+{
+  return -1; // MIOS32_BOARD_J28 not supported
+}
+
+s32 MIOS32_BOARD_J28_Get(void)
+{
+  return -1; // MIOS32_BOARD_J28 not supported
+}
+
+s32 MIOS32_BOARD_J28_PinGet(u8 pin)
+{
+  return -1; // MIOS32_BOARD_J28 not supported
+}
+
+#endif
+
+#if !defined(MIOS32_DONT_USE_BOARD_J15)
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the J15 port
+//! \param[in] mode 
+//! <UL>
+//!   <LI>0: J15 pins are configured in Push Pull Mode (3.3V)
+//!   <LI>1: J15 pins are configured in Open Drain mode (perfect for 3.3V->5V levelshifting)
+//! </UL>
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J15_PortInit(u32 mode)
+{
+  // currently only mode 0 and 1 supported
+  if( mode != 0 && mode != 1 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! The J15 outputs are dropped by the emulation
+//! \return 0
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J15_DataSet(u8 data)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_BOARD_J15_SerDataShift(u8 data)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_BOARD_J15_RS_Set(u8 rs)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_BOARD_J15_RW_Set(u8 rw)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_BOARD_J15_E_Set(u8 lcd, u8 e)
+{
+  return 0; // no error
+}
+
+s32 MIOS32_BOARD_J15_D7InPullUpEnable(u8 enable)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the state of the D7_IN pin
+//! return 0: the emulated LCD is never busy
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J15_GetD7In(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function is used by LCD drivers under $MIOS32_PATH/modules/app_lcd
+//! to poll the busy bit (D7) of a LCD
+//! \param[in] lcd display port (0=J15A, 1=J15B)
+//! \param[in] time_out how many times should the busy bit be polled?
+//! return 0: the emulated LCD is never busy
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_J15_PollUnbusy(u8 lcd, u32 time_out)
+{
+  return 0; // no error
+}
+
+#endif
+
+#if !defined(MIOS32_DONT_USE_BOARD_DAC)
+
+/////////////////////////////////////////////////////////////////////////////
+//! No DAC channels are available on the host
+//! \return -1
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_BOARD_DAC_PinInit(u8 chn, u8 enable)
+{
+  return -1; // channel not supported
+}
+
+s32 MIOS32_BOARD_DAC_PinSet(u8 chn, u16 value)
+{
+  return -1; // channel not supported
+}
+
+#endif
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_BOARD */
@@ -0,0 +1,20 @@
+// $Id$
+//
+// There is no bootloader for the POSIX emulation: the application is
+// started and terminated from the shell of the host.
+//
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
@@ -0,0 +1,86 @@
+// $Id$
+//! \defgroup MIOS32_DELAY
+//!
+//! Delay functions for the POSIX emulation
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <errno.h>
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_DELAY)
+
+// delays below this value are busy-waiting, since the wake-up latency of the
+// host scheduler is in the same range
+#ifndef MIOS32_DELAY_SPIN_LIMIT_US
+#define MIOS32_DELAY_SPIN_LIMIT_US 100
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the MIOS32_DELAY functions<BR>
+//! Nothing to do on the host, CLOCK_MONOTONIC is used.
+//!
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DELAY_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Waits for a specific number of uS<BR>
+//! Example:<BR>
+//! \code
+//!   // wait for 500 uS
+//!   MIOS32_DELAY_Wait_uS(500);
+//! \endcode
+//! \param[in] uS delay (1..65535 microseconds)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DELAY_Wait_uS(u16 uS)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  end.tv_nsec += uS * 1000L;
+  if( end.tv_nsec >= 1000000000L ) {
+    end.tv_nsec -= 1000000000L;
+    ++end.tv_sec;
+  }
+
+  if( uS >= MIOS32_DELAY_SPIN_LIMIT_US ) {
+    while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &end, NULL) == EINTR );
+  } else {
+    struct timespec now;
+    do {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+    } while( now.tv_sec < end.tv_sec || (now.tv_sec == end.tv_sec && now.tv_nsec < end.tv_nsec) );
+  }
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_DELAY */
@@ -0,0 +1,25 @@
+# $Id$
+# defines additional rules for MIOS32 family
+#
+# POSIX emulation: MIOS32 applications are running as a process on the host,
+# see also README.txt in this directory
+
+# enhance include path
+C_INCLUDE +=	-I $(MIOS32_PATH)/mios32/$(FAMILY)
+
+
+# add modules to thumb sources
+THUMB_SOURCE += \
+	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_posix.c
+
+
+# optional ALSA sequencer backend (requires the libasound development files)
+MIOS32_POSIX_ALSA ?= 0
+ifeq ($(MIOS32_POSIX_ALSA),1)
+CFLAGS += -DMIOS32_POSIX_USE_ALSA
+LIBS += -lasound
+endif
+
+
+# directories and files that should be part of the distribution (release) package
+DIST += $(MIOS32_PATH)/mios32/$(FAMILY)
@@ -0,0 +1,65 @@
+// $Id$
+//! \defgroup MIOS32_I2S
+//!
+//! I2S Functions
+//!
+//! Not supported by the POSIX emulation: there is no audio output, and the
+//! buffer reload callback is never invoked.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally *ENABLED* in a local mios32_config.h file (included from mios32.h)
+#if defined(MIOS32_USE_I2S)
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes I2S interface
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Init(u32 mode)
+{
+  return -1; // not supported
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts DMA driven I2S transfers
+//! \param[in] *buffer pointer to sample buffer (contains L/R halfword)
+//! \param[in] len size of audio buffer
+//! \param[in] _callback callback function
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Start(u32 *buffer, u16 len, void *_callback)
+{
+  return -1; // not supported
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Stops DMA driven I2S transfers
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_I2S_Stop(void)
+{
+  return -1; // not supported
+}
+
+//! \}
+
+#endif /* MIOS32_USE_I2S */
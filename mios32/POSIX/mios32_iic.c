@@ -0,0 +1,227 @@
+// $Id$
+//! \defgroup MIOS32_IIC
+//!
+//! IIC driver for the POSIX emulation
+//!
+//! The semaphore handling works like on the target, but no device is
+//! connected to the emulated busses: each transfer terminates with
+//! MIOS32_IIC_ERROR_SLAVE_NOT_CONNECTED, so that drivers which scan the
+//! bus for modules (e.g. MIOS32_IIC_MIDI, MIOS32_IIC_BS) don't find any.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <sched.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_IIC)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  volatile u8 iic_semaphore;
+  volatile s32 transfer_error;
+  volatile s32 last_transfer_error;
+} iic_rec_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static iic_rec_t iic_rec[MIOS32_IIC_NUM];
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes IIC driver
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  int i;
+  for(i=0; i<MIOS32_IIC_NUM; ++i) {
+    iic_rec[i].iic_semaphore = 0;
+    iic_rec[i].transfer_error = 0;
+    iic_rec[i].last_transfer_error = 0;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Semaphore handling: requests the IIC interface
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \param[in] semaphore_type is either IIC_Blocking or IIC_Non_Blocking
+//! \return Non_Blocking: returns -1 to request a retry
+//! \return 0 if IIC interface free
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferBegin(u8 iic_port, mios32_iic_semaphore_t semaphore_type)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  iic_rec_t *iicx = &iic_rec[iic_port];// simplify addressing of record
+  s32 status = -1;
+
+  do {
+    MIOS32_IRQ_Disable();
+    if( !iicx->iic_semaphore ) {
+      iicx->iic_semaphore = 1;
+      status = 0;
+    }
+    MIOS32_IRQ_Enable();
+
+    if( status != 0 && semaphore_type == IIC_Blocking )
+      sched_yield();
+  } while( semaphore_type == IIC_Blocking && status != 0 );
+
+  // clear transfer errors of last transmission
+  iicx->last_transfer_error = 0;
+  iicx->transfer_error = 0;
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Semaphore handling: releases the IIC interface for other tasks
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferFinished(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  iic_rec[iic_port].iic_semaphore = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the last transfer error<BR>
+//! Will be updated by MIOS32_IIC_TransferCheck(), so that the error status
+//! doesn't get lost (the check function will return 0 when called again)<BR>
+//! Will be cleared when a new transfer has been started successfully
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return last error status
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_LastErrorGet(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  return iic_rec[iic_port].last_transfer_error;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks if transfer is finished
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return 0 if no ongoing transfer
+//! \return < 0 if error during transfer
+//! \note Note that the semaphore will be released automatically after an error
+//! (MIOS32_IIC_TransferBegin() has to be called again)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferCheck(u8 iic_port)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  iic_rec_t *iicx = &iic_rec[iic_port];// simplify addressing of record
+
+  // error during transfer?
+  // (must be done *before* checking for ongoing transfer, as the transfer will be stopped on errors)
+  if( iicx->transfer_error ) {
+    iicx->last_transfer_error = iicx->transfer_error;
+    iicx->transfer_error = 0;
+    // release semaphore for easier programming at user level
+    iicx->iic_semaphore = 0;
+    return iicx->last_transfer_error;
+  }
+
+  // the emulated transfers complete immediately
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Waits until transfer is finished
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \return 0 if no ongoing transfer
+//! \return < 0 if error during transfer
+//! \note Note that the semaphore will be released automatically after an error
+//! (MIOS32_IIC_TransferBegin() has to be called again)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_TransferWait(u8 iic_port)
+{
+  return MIOS32_IIC_TransferCheck(iic_port);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Starts a new transfer. No device is connected to the emulated bus, so
+//! that MIOS32_IIC_TransferCheck() and MIOS32_IIC_TransferWait() will
+//! return MIOS32_IIC_ERROR_SLAVE_NOT_CONNECTED
+//! \param[in] iic_port the IIC port (0..MIOS32_IIC_NUM-1)
+//! \param[in] transfer type (IIC_Read, IIC_Write, IIC_Read_AbortIfFirstByteIs0, IIC_Write_WithoutStop)
+//! \param[in] address of IIC device (bit 0 always cleared)
+//! \param[in] *buffer pointer to transmit/receive buffer
+//! \param[in] len number of bytes which should be transmitted/received
+//! \return 0 no error
+//! \return < 0 on errors, if MIOS32_IIC_ERROR_PREV_OFFSET is added, the previous
+//!      transfer got an error (the previous task didn't use \ref MIOS32_IIC_TransferWait
+//!      to poll the transfer state)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IIC_Transfer(u8 iic_port, mios32_iic_transfer_t transfer, u8 address, u8 *buffer, u16 len)
+{
+  if( iic_port >= MIOS32_IIC_NUM )
+    return MIOS32_IIC_ERROR_INVALID_PORT;
+
+  iic_rec_t *iicx = &iic_rec[iic_port];// simplify addressing of record
+
+  // check if previous transfer has been finished with an error
+  if( iicx->transfer_error ) {
+    s32 error = iicx->transfer_error;
+    iicx->last_transfer_error = error;
+    iicx->transfer_error = 0;
+    return error + MIOS32_IIC_ERROR_PREV_OFFSET;
+  }
+
+  if( transfer != IIC_Read && transfer != IIC_Write &&
+      transfer != IIC_Read_AbortIfFirstByteIs0 && transfer != IIC_Write_WithoutStop )
+    return MIOS32_IIC_ERROR_UNSUPPORTED_TRANSFER_TYPE;
+
+  // the address isn't acknowledged
+  iicx->transfer_error = MIOS32_IIC_ERROR_SLAVE_NOT_CONNECTED;
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_IIC */
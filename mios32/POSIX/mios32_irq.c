@@ -0,0 +1,113 @@
+// $Id$
+//! \defgroup MIOS32_IRQ
+//!
+//! IRQ Enable/Disable routines for the POSIX emulation
+//!
+//! There are no interrupts on the host: timers, the FreeRTOS tick and the
+//! MIDI receivers are running in separate threads, which lock the same
+//! recursive mutex before they call their handlers.<BR>
+//! Accordingly MIOS32_IRQ_Disable() blocks all "interrupt handlers", and
+//! it also serializes all FreeRTOS critical sections.
+//! 
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <pthread.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_IRQ)
+
+
+// the emulated interrupt lock
+static pthread_mutex_t irq_mutex;
+static pthread_once_t irq_mutex_once = PTHREAD_ONCE_INIT;
+
+// the nesting counter allows to detect nesting errors
+static __thread u32 nested_ctr;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initializes the recursive mutex on first use
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_IRQ_MutexInit(void)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&irq_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function disables all interrupts (nested)
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Disable(void)
+{
+  pthread_once(&irq_mutex_once, MIOS32_IRQ_MutexInit);
+  pthread_mutex_lock(&irq_mutex);
+  ++nested_ctr;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function enables all interrupts (nested)
+//! \return < 0 on errors
+//! \return -1 on nesting errors (MIOS32_IRQ_Disable() hasn't been called before)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Enable(void)
+{
+  // check for nesting error
+  if( nested_ctr == 0 )
+    return -1; // nesting error
+
+  // decrease nesting level
+  --nested_ctr;
+  pthread_mutex_unlock(&irq_mutex);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Dummy: there is no interrupt controller on the host
+//! \param[in] IRQn the IRQ number
+//! \param[in] priority the priority
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_Install(u8 IRQn, u8 priority)
+{
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Dummy: there is no interrupt controller on the host
+//! \param[in] IRQn the IRQ number
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_IRQ_DeInstall(u8 IRQn)
+{
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_IRQ */
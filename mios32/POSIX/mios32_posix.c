@@ -0,0 +1,520 @@
+// $Id$
+//! \defgroup MIOS32_POSIX
+//!
+//! Host services of the POSIX emulation
+//!
+//! The MIDI ports USB0..USB3 and UART0..UART3 of the application are
+//! connected to files or to ALSA sequencer ports of the host.
+//! The connections are selected with environment variables:
+//! \code
+//!   MIOS32_POSIX_USB0_IN=<file>     # MIDI IN of USB0 is read from a file
+//!   MIOS32_POSIX_USB0_OUT=-         # MIDI OUT of USB0 is written to stdout
+//!   MIOS32_POSIX_UART0_IN=alsa      # ALSA sequencer port "UART0 IN"
+//!   MIOS32_POSIX_UART0_OUT=alsa     # ALSA sequencer port "UART0 OUT"
+//! \endcode
+//!
+//! Files contain one MIDI message per line: the time in mS since startup,
+//! followed by the bytes in hex format. Empty lines and lines which start
+//! with '#' are ignored:
+//! \code
+//!   # Note On C-3, Note Off after 500 mS
+//!   2000 90 3c 7f
+//!   2500 80 3c 00
+//! \endcode
+//! Input files are replayed with this timing (messages in the past are
+//! forwarded immediately, e.g. when a pipe is read), output files are written
+//! in the same format, so that they can be replayed or compared against
+//! a reference.
+//!
+//! The ALSA backend is only available if the application has been built
+//! with MIOS32_POSIX_ALSA=1 (see mios32_family.mk)
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include "mios32_posix.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef MIOS32_POSIX_USE_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  FILE *file;
+  u8 is_alsa;
+  u8 thread_started;
+  pthread_t thread;
+  mios32_posix_midi_rx_callback_t callback;
+} midi_in_port_t;
+
+typedef struct {
+  FILE *file;
+  u8 is_alsa;
+  pthread_mutex_t mutex;
+
+  // the byte stream is split into messages, one message per line
+  u8 running_status;
+  u8 in_sysex;
+  u8 expected_len;
+  u16 len;
+  u8 buffer[MIOS32_POSIX_MIDI_LINE_SIZE];
+} midi_out_port_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static const char port_name[MIOS32_POSIX_MIDI_NUM_PORTS][6] = {
+  "USB0", "USB1", "USB2", "USB3",
+  "UART0", "UART1", "UART2", "UART3",
+};
+
+static struct timespec start_time;
+
+static midi_in_port_t midi_in_port[MIOS32_POSIX_MIDI_NUM_PORTS];
+static midi_out_port_t midi_out_port[MIOS32_POSIX_MIDI_NUM_PORTS];
+
+#ifdef MIOS32_POSIX_USE_ALSA
+static snd_seq_t *alsa_seq;
+static pthread_mutex_t alsa_mutex = PTHREAD_MUTEX_INITIALIZER;
+static u8 alsa_thread_started;
+static pthread_t alsa_thread;
+static int alsa_in_port[MIOS32_POSIX_MIDI_NUM_PORTS];
+static int alsa_out_port[MIOS32_POSIX_MIDI_NUM_PORTS];
+static snd_midi_event_t *alsa_decoder[MIOS32_POSIX_MIDI_NUM_PORTS];
+static snd_midi_event_t *alsa_encoder[MIOS32_POSIX_MIDI_NUM_PORTS];
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static FILE *OpenPort(u8 posix_port, u8 out, u8 *is_alsa);
+static void FlushOutputs(void);
+
+#ifdef MIOS32_POSIX_USE_ALSA
+static s32 AlsaPortCreate(u8 posix_port, u8 out);
+static void *AlsaThread(void *arg);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the host services, called from MIOS32_SYS_Init()
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_POSIX_Init(u32 mode)
+{
+  u8 posix_port;
+
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  for(posix_port=0; posix_port<MIOS32_POSIX_MIDI_NUM_PORTS; ++posix_port) {
+    midi_in_port_t *in = &midi_in_port[posix_port];
+    midi_out_port_t *out = &midi_out_port[posix_port];
+
+    in->file = OpenPort(posix_port, 0, &in->is_alsa);
+
+    pthread_mutex_init(&out->mutex, NULL);
+    out->file = OpenPort(posix_port, 1, &out->is_alsa);
+  }
+
+  atexit(FlushOutputs);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return mS since MIOS32_POSIX_Init() - used as timestamp in MIDI files
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_POSIX_TimeGet_mS(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (u32)((now.tv_sec - start_time.tv_sec) * 1000LL + (now.tv_nsec - start_time.tv_nsec) / 1000000LL);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 1 if the MIDI IN of the given port is connected to the host
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_POSIX_MIDI_InputAvailable(u8 posix_port)
+{
+  if( posix_port >= MIOS32_POSIX_MIDI_NUM_PORTS )
+    return 0;
+
+  return (midi_in_port[posix_port].file != NULL || midi_in_port[posix_port].is_alsa) ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 1 if the MIDI OUT of the given port is connected to the host
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_POSIX_MIDI_OutputAvailable(u8 posix_port)
+{
+  if( posix_port >= MIOS32_POSIX_MIDI_NUM_PORTS )
+    return 0;
+
+  return (midi_out_port[posix_port].file != NULL || midi_out_port[posix_port].is_alsa) ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Receive thread of a file based MIDI IN port
+/////////////////////////////////////////////////////////////////////////////
+static void *FileInThread(void *arg)
+{
+  u8 posix_port = (u8)(size_t)arg;
+  midi_in_port_t *in = &midi_in_port[posix_port];
+  char line[4*MIOS32_POSIX_MIDI_LINE_SIZE];
+  u8 data[MIOS32_POSIX_MIDI_LINE_SIZE];
+
+  while( fgets(line, sizeof(line), in->file) != NULL ) {
+    char *pos = line;
+    char *next;
+
+    while( isspace((int)*pos) )
+      ++pos;
+    if( *pos == 0 || *pos == '#' )
+      continue;
+
+    unsigned long time_ms = strtoul(pos, &next, 10);
+    if( next == pos ) {
+      fprintf(stderr, "MIOS32_POSIX: invalid line in %s input: %s", port_name[posix_port], line);
+      continue;
+    }
+
+    u32 len = 0;
+    for(pos=next; len < sizeof(data); pos=next) {
+      unsigned long b = strtoul(pos, &next, 16);
+      if( next == pos )
+	break;
+      data[len++] = (u8)b;
+    }
+
+    if( !len )
+      continue;
+
+    // wait until the message is due
+    struct timespec due;
+    due.tv_sec = start_time.tv_sec + time_ms / 1000;
+    due.tv_nsec = start_time.tv_nsec + (time_ms % 1000) * 1000000L;
+    if( due.tv_nsec >= 1000000000L ) {
+      due.tv_nsec -= 1000000000L;
+      ++due.tv_sec;
+    }
+    while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR );
+
+    in->callback(posix_port, data, len);
+  }
+
+  return NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs the callback for a MIDI IN port and starts the receive thread
+//! \param[in] posix_port the port (see MIOS32_POSIX_MIDI_PORT_USB/UART)
+//! \param[in] callback is called from the receive thread with complete
+//!            MIDI messages. It has to lock MIOS32_IRQ_Disable() while it
+//!            accesses buffers which are shared with the application, like
+//!            an IRQ handler would do on the target.
+//! \return < 0 if the port isn't connected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_POSIX_MIDI_RxCallbackInit(u8 posix_port, mios32_posix_midi_rx_callback_t callback)
+{
+  if( !MIOS32_POSIX_MIDI_InputAvailable(posix_port) )
+    return -1; // port not connected
+
+  midi_in_port_t *in = &midi_in_port[posix_port];
+  in->callback = callback;
+
+#ifdef MIOS32_POSIX_USE_ALSA
+  if( in->is_alsa ) {
+    pthread_mutex_lock(&alsa_mutex);
+    if( !alsa_thread_started && pthread_create(&alsa_thread, NULL, AlsaThread, NULL) == 0 )
+      alsa_thread_started = 1;
+    pthread_mutex_unlock(&alsa_mutex);
+    return alsa_thread_started ? 0 : -2;
+  }
+#endif
+
+  if( !in->thread_started ) {
+    if( pthread_create(&in->thread, NULL, FileInThread, (void *)(size_t)posix_port) != 0 )
+      return -2; // thread couldn't be started
+    in->thread_started = 1;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Writes the collected message of an output file as a new line
+/////////////////////////////////////////////////////////////////////////////
+static void FileOutFlush(midi_out_port_t *out)
+{
+  if( !out->len )
+    return;
+
+  fprintf(out->file, "%u", MIOS32_POSIX_TimeGet_mS());
+  u32 i;
+  for(i=0; i<out->len; ++i)
+    fprintf(out->file, " %02x", out->buffer[i]);
+  fputc('\n', out->file);
+
+  out->len = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Splits the byte stream of an output file into messages
+/////////////////////////////////////////////////////////////////////////////
+static void FileOutByte(midi_out_port_t *out, u8 b)
+{
+  if( b >= 0xf8 ) {
+    // realtime messages are written immediately without interrupting the current message
+    fprintf(out->file, "%u %02x\n", MIOS32_POSIX_TimeGet_mS(), b);
+    return;
+  }
+
+  if( b & 0x80 ) {
+    if( out->in_sysex && b == 0xf7 ) {
+      out->buffer[out->len++] = b;
+      FileOutFlush(out);
+      out->in_sysex = 0;
+      return;
+    }
+
+    // a new status byte terminates incomplete messages
+    FileOutFlush(out);
+    out->in_sysex = (b == 0xf0);
+    out->running_status = (b < 0xf0) ? b : 0;
+    out->expected_len = 1 + ((b < 0xf0) ? mios32_midi_expected_bytes_common[(b >> 4) & 0x7] : mios32_midi_expected_bytes_system[b & 0xf]);
+
+    out->buffer[out->len++] = b;
+  } else {
+    if( !out->len && !out->in_sysex && out->running_status ) {
+      // running status: the status byte is repeated, so that each line contains a complete message
+      out->buffer[out->len++] = out->running_status;
+      out->expected_len = 1 + mios32_midi_expected_bytes_common[(out->running_status >> 4) & 0x7];
+    }
+
+    out->buffer[out->len++] = b;
+  }
+
+  if( (!out->in_sysex && out->len >= out->expected_len) || out->len >= MIOS32_POSIX_MIDI_LINE_SIZE )
+    FileOutFlush(out);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sends MIDI bytes to the host
+//! \param[in] posix_port the port (see MIOS32_POSIX_MIDI_PORT_USB/UART)
+//! \param[in] data the MIDI stream (messages can be split over multiple calls)
+//! \param[in] len number of bytes
+//! \return < 0 if the port isn't connected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_POSIX_MIDI_Send(u8 posix_port, u8 *data, u32 len)
+{
+  if( !MIOS32_POSIX_MIDI_OutputAvailable(posix_port) )
+    return -1; // port not connected
+
+  midi_out_port_t *out = &midi_out_port[posix_port];
+
+#ifdef MIOS32_POSIX_USE_ALSA
+  if( out->is_alsa ) {
+    pthread_mutex_lock(&alsa_mutex);
+    u32 i;
+    for(i=0; i<len; ++i) {
+      snd_seq_event_t ev;
+      snd_seq_ev_clear(&ev);
+      if( snd_midi_event_encode_byte(alsa_encoder[posix_port], data[i], &ev) == 1 ) {
+	snd_seq_ev_set_source(&ev, alsa_out_port[posix_port]);
+	snd_seq_ev_set_subs(&ev);
+	snd_seq_ev_set_direct(&ev);
+	snd_seq_event_output_direct(alsa_seq, &ev);
+      }
+    }
+    pthread_mutex_unlock(&alsa_mutex);
+    return 0;
+  }
+#endif
+
+  pthread_mutex_lock(&out->mutex);
+  u32 i;
+  for(i=0; i<len; ++i)
+    FileOutByte(out, data[i]);
+  pthread_mutex_unlock(&out->mutex);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Opens the file (or ALSA port) which is assigned to a MIDI port
+/////////////////////////////////////////////////////////////////////////////
+static FILE *OpenPort(u8 posix_port, u8 out, u8 *is_alsa)
+{
+  char env_name[40];
+  sprintf(env_name, "MIOS32_POSIX_%s_%s", port_name[posix_port], out ? "OUT" : "IN");
+
+  *is_alsa = 0;
+
+  const char *value = getenv(env_name);
+  if( value == NULL || *value == 0 )
+    return NULL; // not connected
+
+  if( strcmp(value, "alsa") == 0 ) {
+#ifdef MIOS32_POSIX_USE_ALSA
+    if( AlsaPortCreate(posix_port, out) >= 0 )
+      *is_alsa = 1;
+#else
+    fprintf(stderr, "MIOS32_POSIX: %s=alsa requires a build with MIOS32_POSIX_ALSA=1\n", env_name);
+#endif
+    return NULL;
+  }
+
+  FILE *file;
+  if( strcmp(value, "-") == 0 ) {
+    file = out ? stdout : stdin;
+  } else {
+    file = fopen(value, out ? "w" : "r");
+    if( file == NULL ) {
+      fprintf(stderr, "MIOS32_POSIX: %s: cannot open %s: %s\n", env_name, value, strerror(errno));
+      return NULL;
+    }
+  }
+
+  // written lines should be visible immediately, e.g. for "tail -f"
+  if( out )
+    setvbuf(file, NULL, _IOLBF, 0);
+
+  return file;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Flushes incomplete messages on exit
+/////////////////////////////////////////////////////////////////////////////
+static void FlushOutputs(void)
+{
+  u8 posix_port;
+
+  for(posix_port=0; posix_port<MIOS32_POSIX_MIDI_NUM_PORTS; ++posix_port) {
+    midi_out_port_t *out = &midi_out_port[posix_port];
+    if( out->file != NULL ) {
+      // don't wait for a sending thread which has been stopped by exit()
+      if( pthread_mutex_trylock(&out->mutex) == 0 ) {
+	FileOutFlush(out);
+	pthread_mutex_unlock(&out->mutex);
+      }
+      fflush(out->file);
+    }
+  }
+}
+
+
+#ifdef MIOS32_POSIX_USE_ALSA
+/////////////////////////////////////////////////////////////////////////////
+// Creates the ALSA sequencer port "<port name> IN" or "<port name> OUT"
+/////////////////////////////////////////////////////////////////////////////
+static s32 AlsaPortCreate(u8 posix_port, u8 out)
+{
+  if( alsa_seq == NULL ) {
+    if( snd_seq_open(&alsa_seq, "default", SND_SEQ_OPEN_DUPLEX, 0) < 0 ) {
+      fprintf(stderr, "MIOS32_POSIX: cannot open the ALSA sequencer\n");
+      alsa_seq = NULL;
+      return -1;
+    }
+    snd_seq_set_client_name(alsa_seq, "MIOS32");
+  }
+
+  char name[20];
+  sprintf(name, "%s %s", port_name[posix_port], out ? "OUT" : "IN");
+
+  unsigned int caps = out
+    ? (SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ)
+    : (SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE);
+  int port = snd_seq_create_simple_port(alsa_seq, name, caps, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  if( port < 0 ) {
+    fprintf(stderr, "MIOS32_POSIX: cannot create the ALSA port %s\n", name);
+    return -1;
+  }
+
+  snd_midi_event_t *parser;
+  if( snd_midi_event_new(MIOS32_POSIX_MIDI_LINE_SIZE, &parser) < 0 )
+    return -1;
+
+  if( out ) {
+    alsa_out_port[posix_port] = port;
+    alsa_encoder[posix_port] = parser;
+  } else {
+    // each decoded message should contain the status byte
+    snd_midi_event_no_status(parser, 1);
+    alsa_in_port[posix_port] = port;
+    alsa_decoder[posix_port] = parser;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Receive thread for all ALSA MIDI IN ports
+/////////////////////////////////////////////////////////////////////////////
+static void *AlsaThread(void *arg)
+{
+  u8 data[MIOS32_POSIX_MIDI_LINE_SIZE];
+
+  while( 1 ) {
+    snd_seq_event_t *ev;
+    if( snd_seq_event_input(alsa_seq, &ev) < 0 || ev == NULL )
+      continue;
+
+    u8 posix_port;
+    for(posix_port=0; posix_port<MIOS32_POSIX_MIDI_NUM_PORTS; ++posix_port) {
+      midi_in_port_t *in = &midi_in_port[posix_port];
+      if( in->is_alsa && in->callback != NULL && alsa_in_port[posix_port] == ev->dest.port ) {
+	long len = snd_midi_event_decode(alsa_decoder[posix_port], data, sizeof(data), ev);
+	if( len > 0 )
+	  in->callback(posix_port, data, (u32)len);
+	break;
+      }
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+//! \}
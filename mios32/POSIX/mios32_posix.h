@@ -0,0 +1,64 @@
+// $Id$
+/*
+ * Header file for the host services of the POSIX emulation
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS32_POSIX_H
+#define _MIOS32_POSIX_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of MIDI ports which can be connected to the host
+// port 0..3: USB0..USB3, port 4..7: UART0..UART3
+#define MIOS32_POSIX_MIDI_NUM_USB_PORTS   4
+#define MIOS32_POSIX_MIDI_NUM_UART_PORTS  4
+#define MIOS32_POSIX_MIDI_NUM_PORTS       (MIOS32_POSIX_MIDI_NUM_USB_PORTS + MIOS32_POSIX_MIDI_NUM_UART_PORTS)
+
+#define MIOS32_POSIX_MIDI_PORT_USB(cable) (cable)
+#define MIOS32_POSIX_MIDI_PORT_UART(uart) (MIOS32_POSIX_MIDI_NUM_USB_PORTS + (uart))
+
+// max. number of bytes per line in MIDI files (longer SysEx streams are split)
+#ifndef MIOS32_POSIX_MIDI_LINE_SIZE
+#define MIOS32_POSIX_MIDI_LINE_SIZE 256
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+// called from the receive thread of a port with a complete MIDI message
+// (or a part of a SysEx stream)
+typedef void (*mios32_posix_midi_rx_callback_t)(u8 posix_port, u8 *data, u32 len);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 MIOS32_POSIX_Init(u32 mode);
+
+extern u32 MIOS32_POSIX_TimeGet_mS(void);
+
+extern s32 MIOS32_POSIX_MIDI_InputAvailable(u8 posix_port);
+extern s32 MIOS32_POSIX_MIDI_OutputAvailable(u8 posix_port);
+extern s32 MIOS32_POSIX_MIDI_RxCallbackInit(u8 posix_port, mios32_posix_midi_rx_callback_t callback);
+extern s32 MIOS32_POSIX_MIDI_Send(u8 posix_port, u8 *data, u32 len);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+#endif /* _MIOS32_POSIX_H */
@@ -0,0 +1,260 @@
+// $Id$
+//! \defgroup MIOS32_SPI
+//!
+//! SPI ports of the POSIX emulation
+//!
+//! Nothing is connected to the three SPI ports: sent bytes are dropped,
+//! and 0xff is received, which is the idle state of the MISO line.
+//! Accordingly the SRIO driver sees released buttons at all DIN pins,
+//! and the SD Card driver doesn't find a card.
+//!
+//! Block transfers without callback complete immediately. If a callback
+//! is given, it is invoked from a separate thread once the time which the
+//! transfer would take on a MBHP_CORE_STM32F4 has passed (like the DMA
+//! interrupt on the target). This matters for applications which restart
+//! the next transfer from the callback (e.g. continuous SRIO scans).
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_SPI)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_SPI 3
+
+// peripheral clock which is divided by the prescaler (APB2 of STM32F407)
+#define SPI_PERIPHERAL_CLOCK_MHZ 84
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  pthread_t dma_thread;
+  u8 dma_thread_started;
+  mios32_spi_prescaler_t prescaler;
+  void (*dma_callback)(void);
+  struct timespec dma_finished;
+} spi_rec_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static spi_rec_t spi_rec[NUM_SPI];
+
+static pthread_mutex_t spi_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spi_cond = PTHREAD_COND_INITIALIZER;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void *MIOS32_SPI_DMA_Thread(void *arg);
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes SPI pins
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)initializes SPI IO Pins
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] spi_pin_driver configures the driver strength (ignored)
+//! \return 0 if no error
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_IO_Init(u8 spi, mios32_spi_pin_driver_t spi_pin_driver)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! (Re-)initializes SPI peripheral transfer mode
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] spi_mode configures clock and capture phase (ignored)
+//! \param[in] spi_prescaler configures the SPI speed (determines the transfer time of DMA transfers)
+//! \return 0 if no error
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferModeInit(u8 spi, mios32_spi_mode_t spi_mode, mios32_spi_prescaler_t spi_prescaler)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  spi_rec[spi].prescaler = spi_prescaler;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Controls the RC (Register Clock alias Chip Select) pin of a SPI port
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] rc_pin RCLK pin (0 or 1 for RCLK1 or RCLK2)
+//! \param[in] pin_value 0 or 1
+//! \return 0 if no error
+//! \return -2 if unsupported SPI port selected
+//! \return -3 if unsupported RCx pin selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_RC_PinSet(u8 spi, u8 rc_pin, u8 pin_value)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  if( rc_pin >= 2 )
+    return -3; // unsupported RC pin
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Transfers a byte to SPI output and reads back the return value from SPI input
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] b the byte which should be transfered
+//! \return >= 0: the read byte (always 0xff)
+//! \return -2 if unsupported SPI port selected
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferByte(u8 spi, u8 b)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  return 0xff;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Transfers a block of bytes
+//! \param[in] spi SPI number (0, 1 or 2)
+//! \param[in] send_buffer pointer to buffer which should be sent (dropped).
+//! \param[in] receive_buffer pointer to buffer which should get the received values.<BR>
+//! If NULL, received bytes will be discarded.
+//! \param[in] len number of bytes which should be transfered
+//! \param[in] callback pointer to callback function which will be executed
+//! from the DMA thread once the transfer is finished.<BR>
+//! If NULL, the transfer is finished before this function returns.
+//! \return >= 0 if no error during transfer
+//! \return -2 if unsupported SPI port selected
+//! \return -3 if the DMA thread can't be started
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SPI_TransferBlock(u8 spi, u8 *send_buffer, u8 *receive_buffer, u16 len, void *callback)
+{
+  if( spi >= NUM_SPI )
+    return -2; // unsupported SPI port
+
+  if( receive_buffer != NULL )
+    memset(receive_buffer, 0xff, len);
+
+  if( callback == NULL )
+    return 0; // no error
+
+  spi_rec_t *rec = &spi_rec[spi];
+
+  // transfer time: 8 SPI clocks per byte
+  unsigned long long ns = ((unsigned long long)len * 8 * (2 << rec->prescaler) * 1000) / SPI_PERIPHERAL_CLOCK_MHZ;
+
+  pthread_mutex_lock(&spi_mutex);
+
+  if( !rec->dma_thread_started ) {
+    if( pthread_create(&rec->dma_thread, NULL, MIOS32_SPI_DMA_Thread, rec) != 0 ) {
+      pthread_mutex_unlock(&spi_mutex);
+      return -3; // DMA thread can't be started
+    }
+    pthread_detach(rec->dma_thread);
+    rec->dma_thread_started = 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &rec->dma_finished);
+  ns += rec->dma_finished.tv_nsec;
+  rec->dma_finished.tv_sec += ns / 1000000000;
+  rec->dma_finished.tv_nsec = ns % 1000000000;
+  rec->dma_callback = callback;
+
+  pthread_cond_broadcast(&spi_cond);
+  pthread_mutex_unlock(&spi_mutex);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Emulates the DMA interrupt of a SPI port
+// The callback is executed with disabled IRQs like the interrupt handler on the target
+/////////////////////////////////////////////////////////////////////////////
+static void *MIOS32_SPI_DMA_Thread(void *arg)
+{
+  spi_rec_t *rec = (spi_rec_t *)arg;
+
+  while( 1 ) {
+    pthread_mutex_lock(&spi_mutex);
+    while( rec->dma_callback == NULL )
+      pthread_cond_wait(&spi_cond, &spi_mutex);
+    struct timespec finished = rec->dma_finished;
+    pthread_mutex_unlock(&spi_mutex);
+
+    while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &finished, NULL) != 0 );
+
+    MIOS32_IRQ_Disable();
+    pthread_mutex_lock(&spi_mutex);
+    void (*callback)(void) = NULL;
+    // the transfer could have been restarted meanwhile
+    if( rec->dma_finished.tv_sec == finished.tv_sec && rec->dma_finished.tv_nsec == finished.tv_nsec ) {
+      callback = rec->dma_callback;
+      rec->dma_callback = NULL;
+    }
+    pthread_mutex_unlock(&spi_mutex);
+
+    if( callback != NULL )
+      callback();
+    MIOS32_IRQ_Enable();
+  }
+
+  return NULL;
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_SPI */
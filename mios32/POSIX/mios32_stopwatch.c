@@ -0,0 +1,114 @@
+// $Id$
+//! \defgroup MIOS32_STOPWATCH
+//!
+//! Stopwatch functions for the POSIX emulation
+//!
+//! Based on CLOCK_MONOTONIC of the host. The 16bit range of the target
+//! counter is emulated, so that overruns are reported the same way.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_STOPWATCH)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 stopwatch_resolution = 1;
+static struct timespec stopwatch_start;
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the 16bit stopwatch timer with the desired resolution:
+//! <UL>
+//!  <LI>1: 1 uS resolution, time measurement possible in the range of 0.001mS .. 65.535 mS
+//!  <LI>10: 10 uS resolution: 0.01 mS .. 655.35 mS
+//!  <LI>100: 100 uS resolution: 0.1 mS .. 6.5535 seconds
+//!  <LI>1000: 1 mS resolution: 1 mS .. 65.535 seconds
+//!  <LI>other values should not be used!
+//! <UL>
+//!
+//! Example:<BR>
+//! \code
+//!   // initialize the stopwatch for 100 uS resolution
+//!   // (only has to be done once, e.g. in APP_Init())
+//!   MIOS32_STOPWATCH_Init(100);
+//!
+//!   // reset stopwatch
+//!   MIOS32_STOPWATCH_Reset();
+//!
+//!   // execute function
+//!   MyFunction();
+//!
+//!   // send execution time via DEFAULT COM interface
+//!   u32 delay = MIOS32_STOPWATCH_ValueGet();
+//!   printf("Execution time of MyFunction: ");
+//!   if( delay == 0xffffffff )
+//!     printf("Overrun!\n\r");
+//!   else
+//!     printf("%d.%d mS\n\r", delay/10, delay%10);
+//! \endcode
+//! \param[in] resolution 1, 10, 100 or 1000
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_STOPWATCH_Init(u32 resolution)
+{
+  if( resolution == 0 )
+    return -1; // invalid resolution
+
+  stopwatch_resolution = resolution;
+
+  return MIOS32_STOPWATCH_Reset();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Resets the stopwatch
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_STOPWATCH_Reset(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &stopwatch_start);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns current value of stopwatch
+//! \return 1..65535: valid stopwatch value
+//! \return 0xffffffff: counter overrun
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_STOPWATCH_ValueGet(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  long long us = (now.tv_sec - stopwatch_start.tv_sec) * 1000000LL + (now.tv_nsec - stopwatch_start.tv_nsec) / 1000;
+  long long value = 1 + us / stopwatch_resolution; // starts at 1 like on the target
+
+  return (value > 0xffff) ? 0xffffffff : (u32)value;
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_STOPWATCH */
@@ -0,0 +1,257 @@
+// $Id$
+//! \defgroup MIOS32_SYS
+//!
+//! System Initialisation for the POSIX emulation
+//!
+//! The application terminates on SIGINT/SIGTERM (e.g. Ctrl-C), and
+//! optionally after a given time, which is useful for benchmarks and
+//! regression tests:
+//! \code
+//!   MIOS32_POSIX_RUN_MS=10000 ./project_build/project
+//! \endcode
+//! 
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include "mios32_posix.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_SYS)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+// MIOS32_SYS_TimeGet() = time_offset + time since time_ref
+static u32 time_offset;
+static struct timespec time_ref;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Terminates the application on SIGINT/SIGTERM
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_SYS_SignalHandler(int sig)
+{
+  // exit() flushes the MIDI output files
+  exit(0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Terminates the application after MIOS32_POSIX_RUN_MS
+/////////////////////////////////////////////////////////////////////////////
+static void *MIOS32_SYS_RunTimeThread(void *arg)
+{
+  u32 run_ms = (u32)(size_t)arg;
+  struct timespec delay = { run_ms / 1000, (run_ms % 1000) * 1000000L };
+
+  while( nanosleep(&delay, &delay) != 0 );
+  exit(0);
+
+  return NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes the System for MIOS32:<BR>
+//! <UL>
+//!   <LI>connects the MIDI ports to the host via MIOS32_POSIX_Init()
+//!   <LI>installs the signal handlers
+//!   <LI>starts the run time limit if MIOS32_POSIX_RUN_MS is set
+//!   <LI>enables the system realtime clock
+//! </UL>
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  if( MIOS32_POSIX_Init(0) < 0 )
+    return -2; // host services not available
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = MIOS32_SYS_SignalHandler;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  const char *run_ms = getenv("MIOS32_POSIX_RUN_MS");
+  if( run_ms != NULL && atoi(run_ms) > 0 ) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, MIOS32_SYS_RunTimeThread, (void *)(size_t)atoi(run_ms));
+  }
+
+  // initialize system clock
+  mios32_sys_time_t t = { .seconds=0, .fraction_ms=0 };
+  MIOS32_SYS_TimeSet(t);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Shutdown MIOS32 and reset the microcontroller:<BR>
+//! <UL>
+//!   <LI>disable all RTOS tasks
+//!   <LI>turn off all board LEDs
+//!   <LI>terminate the process (there is no bootloader on the host,
+//!       it has to be restarted from the shell)
+//! </UL>
+//! \return < 0 if reset failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_Reset(void)
+{
+  // disable all interrupts
+  MIOS32_IRQ_Disable();
+
+#if !defined(MIOS32_DONT_USE_BOARD_LED)
+  // turn off all board LEDs
+  MIOS32_BOARD_LED_Set(0xffffffff, 0x00000000);
+#endif
+
+  exit(0);
+
+  return -1; // we will never reach this point
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the Chip ID of the core
+//! \return the chip ID (always 0 on the host)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_ChipIDGet(void)
+{
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the Flash size of the core
+//! \return the Flash size in bytes (always 0 on the host)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_FlashSizeGet(void)
+{
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the (data) RAM size of the core
+//! \return the RAM size in bytes (always 0 on the host)
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_SYS_RAMSizeGet(void)
+{
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the serial number as a string
+//! \param[out] str pointer to a string which can store at least 32 digits + zero terminator!
+//! (24 digits derived from the host ID)
+//! \return < 0 if feature not supported
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_SerialNumberGet(char *str)
+{
+  sprintf(str, "%024lX", (unsigned long)(u32)gethostid());
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes/Resets the System Real Time Clock
+//!
+//! The time can be re-initialized the following way:
+//! \code
+//!   // set System Time to one hour and 30 minutes
+//!   mios32_sys_time_t t = { .seconds=1*3600 + 30*60, .fraction_ms=0 };
+//!   MIOS32_SYS_TimeSet(t);
+//! \endcode
+//!
+//! After system reset it will always start with 0.
+//!
+//! \param[in] t the time in seconds + fraction part (mS)<BR>
+//! Note that this format isn't completely compatible to the NTP timestamp format,
+//! as the fraction has only mS accuracy
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_TimeSet(mios32_sys_time_t t)
+{
+  MIOS32_IRQ_Disable();
+  clock_gettime(CLOCK_MONOTONIC, &time_ref);
+  time_offset = t.seconds * 1000 + t.fraction_ms;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the System Real Time (with mS accuracy)
+//!
+//! Following example code converts the returned time into hours, minutes,
+//! seconds and milliseconds:
+//! \code
+//!   mios32_sys_time_t t = MIOS32_SYS_TimeGet();
+//!   int hours = t.seconds / 3600;
+//!   int minutes = (t.seconds % 3600) / 60;
+//!   int seconds = (t.seconds % 3600) % 60;
+//!   int milliseconds = t.fraction_ms;
+//! \endcode
+//! \return the system time in a mios32_sys_time_t structure
+/////////////////////////////////////////////////////////////////////////////
+mios32_sys_time_t MIOS32_SYS_TimeGet(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  MIOS32_IRQ_Disable();
+  unsigned long long ms = time_offset + (now.tv_sec - time_ref.tv_sec) * 1000LL + (now.tv_nsec - time_ref.tv_nsec) / 1000000LL;
+  MIOS32_IRQ_Enable();
+
+  mios32_sys_time_t t = {
+    .seconds = (u32)(ms / 1000),
+    .fraction_ms = (u32)(ms % 1000)
+  };
+
+  return t;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs a DMA callback function which is invoked on DMA interrupts\n
+//! Not available on the host.
+//! \param[in] dma the DMA number (currently always 0)
+//! \param[in] chn the DMA channel (0..7)
+//! \param[in] callback the callback function which will be invoked by DMA ISR
+//! \return -1 if function not implemented for this MIOS32_PROCESSOR
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SYS_DMA_CallbackSet(u8 dma, u8 chn, void *callback)
+{
+  return -1; // function not implemented for this MIOS32_PROCESSOR
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_SYS */
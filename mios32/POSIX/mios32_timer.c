@@ -0,0 +1,239 @@
+// $Id$
+//! \defgroup MIOS32_TIMER
+//!
+//! Timer functions for the POSIX emulation
+//!
+//! Each timer is served by a thread which sleeps with clock_nanosleep()
+//! until the next period (absolute CLOCK_MONOTONIC deadlines, so that the
+//! average rate doesn't drift). The callback is invoked with the emulated
+//! interrupts disabled, like an ISR on the target.
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_TIMER)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_TIMERS 3
+
+// if the timer thread is more than this number of periods behind (e.g. because
+// the host was suspended), missed periods are skipped instead of catched up
+#define MAX_PERIODS_BEHIND 10
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  pthread_t thread;
+  u8 thread_started;
+  u32 period; // in uS, 0: timer disabled
+  void (*callback)(void);
+} timer_state_t;
+
+static timer_state_t timer_state[NUM_TIMERS];
+
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond = PTHREAD_COND_INITIALIZER;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Timer thread (one per timer)
+/////////////////////////////////////////////////////////////////////////////
+static void *MIOS32_TIMER_Thread(void *arg)
+{
+  timer_state_t *t = (timer_state_t *)arg;
+  struct timespec next;
+
+  for(;;) {
+    // wait until the timer is enabled
+    pthread_mutex_lock(&timer_mutex);
+    while( !t->period )
+      pthread_cond_wait(&timer_cond, &timer_mutex);
+    pthread_mutex_unlock(&timer_mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for(;;) {
+      // period could be changed by MIOS32_TIMER_ReInit() or MIOS32_TIMER_DeInit()
+      pthread_mutex_lock(&timer_mutex);
+      u32 period = t->period;
+      void (*callback)(void) = t->callback;
+      pthread_mutex_unlock(&timer_mutex);
+
+      if( !period )
+	break;
+
+      next.tv_nsec += period * 1000L;
+      while( next.tv_nsec >= 1000000000L ) {
+	next.tv_nsec -= 1000000000L;
+	++next.tv_sec;
+      }
+
+      while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR );
+
+      // skip periods if we are too much behind
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      long long behind_ns = (now.tv_sec - next.tv_sec) * 1000000000LL + (now.tv_nsec - next.tv_nsec);
+      if( behind_ns > (long long)period * 1000LL * MAX_PERIODS_BEHIND )
+	next = now;
+
+      if( callback != NULL ) {
+	MIOS32_IRQ_Disable();
+	callback();
+	MIOS32_IRQ_Enable();
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initialize a timer
+//! \param[in] timer (0..2)<BR>
+//!     Each timer is served by a separate host thread
+//! \param[in] period in uS accuracy (1..65536)
+//! \param[in] _irq_handler (function name)
+//! \param[in] irq_priority: ignored by the emulation, all callbacks
+//!     are serialized by the emulated interrupt lock
+//!
+//! Example:<BR>
+//! \code
+//!   // initialize timer for 1000 uS (= 1 mS) period
+//!   MIOS32_TIMER_Init(0, 1000, MyTimer, MIOS32_IRQ_PRIO_MID);
+//! \endcode
+//! this will call following function periodically:
+//! \code
+//! void MyTimer(void)
+//! {
+//!    // your code
+//! }
+//! \endcode
+//! \return 0 if initialisation passed
+//! \return -1 if invalid timer number
+//! \return -2 if invalid period
+//! \return -3 if the timer thread couldn't be created
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_Init(u8 timer, u32 period, void (*_irq_handler)(void), u8 irq_priority)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  // check if valid period
+  if( period < 1 || period >= 65537 )
+    return -2;
+
+  timer_state_t *t = &timer_state[timer];
+  s32 status = 0;
+
+  pthread_mutex_lock(&timer_mutex);
+  t->callback = _irq_handler;
+  t->period = period;
+
+  if( !t->thread_started ) {
+    if( pthread_create(&t->thread, NULL, MIOS32_TIMER_Thread, t) == 0 ) {
+      pthread_detach(t->thread);
+      t->thread_started = 1;
+    } else {
+      t->period = 0;
+      status = -3;
+    }
+  }
+
+  pthread_cond_broadcast(&timer_cond);
+  pthread_mutex_unlock(&timer_mutex);
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Re-Initialize a timer with given period
+//!
+//! Example:<BR>
+//! \code
+//!   // change timer period to 2 mS
+//!   MIOS32_TIMER_ReInit(0, 2000);
+//! \endcode
+//! \param[in] timer (0..2)
+//! \param[in] period in uS accuracy (1..65536)
+//! \return 0 if initialisation passed
+//! \return if invalid timer number
+//! \return -2 if invalid period
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_ReInit(u8 timer, u32 period)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  // check if valid period
+  if( period < 1 || period >= 65537 )
+    return -2;
+
+  pthread_mutex_lock(&timer_mutex);
+  timer_state[timer].period = period;
+  pthread_cond_broadcast(&timer_cond);
+  pthread_mutex_unlock(&timer_mutex);
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! De-Initialize a timer
+//!
+//! Example:<BR>
+//! \code
+//!   // disable timer
+//!   MIOS32_TIMER_DeInit(0);
+//! \endcode
+//! \param[in] timer (0..2)
+//! \return 0 if timer has been disabled
+//! \return -1 if invalid timer number
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_TIMER_DeInit(u8 timer)
+{
+  // check if valid timer
+  if( timer >= NUM_TIMERS )
+    return -1; // invalid timer selected
+
+  // the thread stays idle until the timer is initialized again
+  pthread_mutex_lock(&timer_mutex);
+  timer_state[timer].period = 0;
+  pthread_mutex_unlock(&timer_mutex);
+
+  return 0; // no error
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_TIMER */
@@ -0,0 +1,556 @@
+// $Id$
+//! \defgroup MIOS32_UART
+//!
+//! U(S)ART functions for MIOS32 (POSIX emulation)
+//!
+//! The UARTs are connected to the MIDI ports UART0..UART3 of \ref MIOS32_POSIX.
+//! Outgoing bytes are forwarded immediately, there is no baudrate dependent
+//! transfer time.
+//!
+//! Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+//!
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_UART)
+
+#include <unistd.h>
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// how many UARTs are supported?
+#if MIOS32_UART_NUM > MIOS32_POSIX_MIDI_NUM_UART_PORTS
+# define NUM_SUPPORTED_UARTS MIOS32_POSIX_MIDI_NUM_UART_PORTS
+#else
+# define NUM_SUPPORTED_UARTS MIOS32_UART_NUM
+#endif
+
+// time to wait if the receive buffer is full (ca. one byte @31250 baud)
+#define RX_BUFFER_FULL_DELAY_US 320
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if NUM_SUPPORTED_UARTS >= 1
+static u8  uart_assigned_to_midi;
+static u32 uart_baudrate[NUM_SUPPORTED_UARTS];
+
+static u8 rx_buffer[NUM_SUPPORTED_UARTS][MIOS32_UART_RX_BUFFER_SIZE];
+static volatile u8 rx_buffer_tail[NUM_SUPPORTED_UARTS];
+static volatile u8 rx_buffer_head[NUM_SUPPORTED_UARTS];
+static volatile u8 rx_buffer_size[NUM_SUPPORTED_UARTS];
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+#if NUM_SUPPORTED_UARTS >= 1
+static void MIOS32_UART_RxCallback(u8 posix_port, u8 *data, u32 len);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes UART interfaces
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UARTs
+#else
+  // initialize UARTs and clear buffers
+  {
+    u8 uart;
+    MIOS32_IRQ_Disable();
+    for(uart=0; uart<NUM_SUPPORTED_UARTS; ++uart) {
+      rx_buffer_tail[uart] = rx_buffer_head[uart] = rx_buffer_size[uart] = 0;
+      MIOS32_UART_InitPortDefault(uart);
+    }
+    MIOS32_IRQ_Enable();
+  }
+
+  // connect the receive paths of the host
+  // (this function can be called multiple times, the callback is only installed once)
+  {
+    u8 uart;
+    for(uart=0; uart<NUM_SUPPORTED_UARTS; ++uart) {
+      u8 posix_port = MIOS32_POSIX_MIDI_PORT_UART(uart);
+      if( MIOS32_POSIX_MIDI_InputAvailable(posix_port) )
+	MIOS32_POSIX_MIDI_RxCallbackInit(posix_port, MIOS32_UART_RxCallback);
+    }
+  }
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 0 if UART is not assigned to a MIDI function
+//! \return 1 if UART is assigned to a MIDI function
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_IsAssignedToMIDI(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return 0; // no UART available
+#else
+  return (uart_assigned_to_midi & (1 << uart)) ? 1 : 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes a given UART interface based on given baudrate and TX output mode
+//! \param[in] uart UART number (0..3)
+//! \param[in] baudrate the baudrate
+//! \param[in] tx_pin_mode the TX pin mode (ignored by the emulation)
+//! \param[in] is_midi MIDI or common UART interface?
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_InitPort(u8 uart, u32 baudrate, mios32_board_pin_mode_t tx_pin_mode, u8 is_midi)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // unsupported UART
+
+  // MIDI assignment
+  if( is_midi ) {
+    uart_assigned_to_midi |= (1 << uart);
+  } else {
+    uart_assigned_to_midi &= ~(1 << uart);
+  }
+
+  // UART configuration
+  return MIOS32_UART_BaudrateSet(uart, baudrate);
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes a given UART interface based on default settings
+//! \param[in] uart UART number (0..3)
+//! \return < 0 if initialisation failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_InitPortDefault(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  switch( uart ) {
+#if NUM_SUPPORTED_UARTS >= 1 && MIOS32_UART0_ASSIGNMENT != 0
+  case 0: {
+    MIOS32_UART_InitPort(0, MIOS32_UART0_BAUDRATE, MIOS32_BOARD_PIN_MODE_OUTPUT_PP, MIOS32_UART0_ASSIGNMENT == 1);
+  } break;
+#endif
+
+#if NUM_SUPPORTED_UARTS >= 2 && MIOS32_UART1_ASSIGNMENT != 0
+  case 1: {
+    MIOS32_UART_InitPort(1, MIOS32_UART1_BAUDRATE, MIOS32_BOARD_PIN_MODE_OUTPUT_PP, MIOS32_UART1_ASSIGNMENT == 1);
+  } break;
+#endif
+
+#if NUM_SUPPORTED_UARTS >= 3 && MIOS32_UART2_ASSIGNMENT != 0
+  case 2: {
+    MIOS32_UART_InitPort(2, MIOS32_UART2_BAUDRATE, MIOS32_BOARD_PIN_MODE_OUTPUT_PP, MIOS32_UART2_ASSIGNMENT == 1);
+  } break;
+#endif
+
+#if NUM_SUPPORTED_UARTS >= 4 && MIOS32_UART3_ASSIGNMENT != 0
+  case 3: {
+    MIOS32_UART_InitPort(3, MIOS32_UART3_BAUDRATE, MIOS32_BOARD_PIN_MODE_OUTPUT_PP, MIOS32_UART3_ASSIGNMENT == 1);
+  } break;
+#endif
+
+  default:
+    return -1; // unsupported UART
+  }
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! sets the baudrate of a UART port
+//! \param[in] uart UART number (0..3)
+//! \param[in] baudrate the baudrate (only stored, the emulation transfers without delay)
+//! \return 0: baudrate has been changed
+//! \return -1: uart not available
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_BaudrateSet(u8 uart, u32 baudrate)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1;
+
+  // store baudrate in array
+  uart_baudrate[uart] = baudrate;
+
+  return 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns the current baudrate of a UART port
+//! \param[in] uart UART number (0..3)
+//! \return 0: uart not available
+//! \return all other values: the current baudrate
+/////////////////////////////////////////////////////////////////////////////
+u32 MIOS32_UART_BaudrateGet(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return 0; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return 0;
+  else
+    return uart_baudrate[uart];
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns number of free bytes in receive buffer
+//! \param[in] uart UART number (0..3)
+//! \return uart number of free bytes
+//! \return 1: uart available
+//! \return 0: uart not available
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_RxBufferFree(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return 0; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return 0;
+  else
+    return MIOS32_UART_RX_BUFFER_SIZE - rx_buffer_size[uart];
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns number of used bytes in receive buffer
+//! \param[in] uart UART number (0..3)
+//! \return > 0: number of used bytes
+//! \return 0 if uart not available
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_RxBufferUsed(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return 0; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return 0;
+  else
+    return rx_buffer_size[uart];
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! gets a byte from the receive buffer
+//! \param[in] uart UART number (0..3)
+//! \return -1 if UART not available
+//! \return -2 if no new byte available
+//! \return >= 0: number of received bytes
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_RxBufferGet(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // UART not available
+
+  if( !rx_buffer_size[uart] )
+    return -2; // nothing new in buffer
+
+  // get byte - this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  u8 b = rx_buffer[uart][rx_buffer_tail[uart]];
+  if( ++rx_buffer_tail[uart] >= MIOS32_UART_RX_BUFFER_SIZE )
+    rx_buffer_tail[uart] = 0;
+  --rx_buffer_size[uart];
+  MIOS32_IRQ_Enable();
+
+  return b; // return received byte
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns the next byte of the receive buffer without taking it
+//! \param[in] uart UART number (0..3)
+//! \return -1 if UART not available
+//! \return -2 if no new byte available
+//! \return >= 0: number of received bytes
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_RxBufferPeek(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // UART not available
+
+  if( !rx_buffer_size[uart] )
+    return -2; // nothing new in buffer
+
+  // get byte - this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  u8 b = rx_buffer[uart][rx_buffer_tail[uart]];
+  MIOS32_IRQ_Enable();
+
+  return b; // return received byte
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! puts a byte onto the receive buffer
+//! \param[in] uart UART number (0..3)
+//! \param[in] b byte which should be put into Rx buffer
+//! \return 0 if no error
+//! \return -1 if UART not available
+//! \return -2 if buffer full (retry)
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_RxBufferPut(u8 uart, u8 b)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // UART not available
+
+  // copy received byte into receive buffer
+  // this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  if( rx_buffer_size[uart] >= MIOS32_UART_RX_BUFFER_SIZE ) {
+    MIOS32_IRQ_Enable();
+    return -2; // buffer full (retry)
+  }
+
+  rx_buffer[uart][rx_buffer_head[uart]] = b;
+  if( ++rx_buffer_head[uart] >= MIOS32_UART_RX_BUFFER_SIZE )
+    rx_buffer_head[uart] = 0;
+  ++rx_buffer_size[uart];
+  MIOS32_IRQ_Enable();
+
+  // wake up the MIDI task (if enabled in the programming model)
+  if( MIOS32_UART_IsAssignedToMIDI(uart) )
+    MIOS32_MIDI_RxNotify();
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns number of free bytes in transmit buffer
+//! \param[in] uart UART number (0..3)
+//! \return number of free bytes
+//! \return 0 if uart not available
+//! \note the emulation forwards bytes immediately, the buffer is always empty
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferFree(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return 0; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return 0;
+  else
+    return MIOS32_UART_TX_BUFFER_SIZE;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! returns number of used bytes in transmit buffer
+//! \param[in] uart UART number (0..3)
+//! \return number of used bytes (always 0)
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferUsed(u8 uart)
+{
+  return 0; // bytes are forwarded immediately
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! gets a byte from the transmit buffer
+//! \param[in] uart UART number (0..3)
+//! \return -1 if UART not available
+//! \return -2 if no new byte available
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferGet(u8 uart)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // UART not available
+
+  return -2; // bytes are forwarded immediately
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! puts more than one byte onto the transmit buffer (used for atomic sends)
+//! \param[in] uart UART number (0..3)
+//! \param[in] *buffer pointer to buffer to be sent
+//! \param[in] len number of bytes to be sent
+//! \return 0 if no error
+//! \return -1 if UART not available
+//! \note bytes are dropped if the UART isn't connected to the host
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferPutMore_NonBlocking(u8 uart, u8 *buffer, u16 len)
+{
+#if NUM_SUPPORTED_UARTS == 0
+  return -1; // no UART available
+#else
+  if( uart >= NUM_SUPPORTED_UARTS )
+    return -1; // UART not available
+
+  u8 posix_port = MIOS32_POSIX_MIDI_PORT_UART(uart);
+  if( MIOS32_POSIX_MIDI_OutputAvailable(posix_port) )
+    MIOS32_POSIX_MIDI_Send(posix_port, buffer, len);
+
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! puts more than one byte onto the transmit buffer (used for atomic sends)<BR>
+//! (blocking function)
+//! \param[in] uart UART number (0..3)
+//! \param[in] *buffer pointer to buffer to be sent
+//! \param[in] len number of bytes to be sent
+//! \return 0 if no error
+//! \return -1 if UART not available
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferPutMore(u8 uart, u8 *buffer, u16 len)
+{
+  s32 error;
+
+  while( (error=MIOS32_UART_TxBufferPutMore_NonBlocking(uart, buffer, len)) == -2 );
+
+  return error;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! puts a byte onto the transmit buffer
+//! \param[in] uart UART number (0..3)
+//! \param[in] b byte which should be put into Tx buffer
+//! \return 0 if no error
+//! \return -1 if UART not available
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferPut_NonBlocking(u8 uart, u8 b)
+{
+  // for more comfortable usage...
+  // -> just forward to MIOS32_UART_TxBufferPutMore
+  return MIOS32_UART_TxBufferPutMore(uart, &b, 1);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! puts a byte onto the transmit buffer<BR>
+//! (blocking function)
+//! \param[in] uart UART number (0..3)
+//! \param[in] b byte which should be put into Tx buffer
+//! \return 0 if no error
+//! \return -1 if UART not available
+//! \note Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_UART_TxBufferPut(u8 uart, u8 b)
+{
+  s32 error;
+
+  while( (error=MIOS32_UART_TxBufferPutMore(uart, &b, 1)) == -2 );
+
+  return error;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Receive callback of the host
+// Replaces the Rx interrupt handler: bytes are either consumed by the
+// MIDI Rx callback, or put into the Rx buffer. Waits until the application
+// has taken bytes if the buffer is full, so that files can be replayed
+// without losing data.
+/////////////////////////////////////////////////////////////////////////////
+#if NUM_SUPPORTED_UARTS >= 1
+static void MIOS32_UART_RxCallback(u8 posix_port, u8 *data, u32 len)
+{
+  u8 uart = posix_port - MIOS32_POSIX_MIDI_PORT_UART(0);
+  mios32_midi_port_t port = UART0 + uart;
+
+  u32 i;
+  for(i=0; i<len; ++i) {
+    u8 b = data[i];
+
+    MIOS32_IRQ_Disable();
+    s32 status = MIOS32_UART_IsAssignedToMIDI(uart) ? MIOS32_MIDI_SendByteToRxCallback(port, b) : 0;
+    MIOS32_IRQ_Enable();
+
+    if( status == 0 ) {
+      while( MIOS32_UART_RxBufferPut(uart, b) == -2 ) {
+	// buffer full: wake up the MIDI task and retry
+	if( MIOS32_UART_IsAssignedToMIDI(uart) )
+	  MIOS32_MIDI_RxNotify();
+	usleep(RX_BUFFER_FULL_DELAY_US);
+      }
+    }
+  }
+}
+#endif
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_UART */
@@ -0,0 +1,85 @@
+// $Id$
+//! \defgroup MIOS32_USB
+//!
+//! USB driver for the POSIX emulation
+//!
+//! There is no USB peripheral: the USB MIDI cables are directly connected
+//! to the host via MIOS32_POSIX (see mios32_usb_midi.c)
+//! 
+//! Applications shouldn't call these functions directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+//! 
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_USB)
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes USB interface
+//! \param[in] mode
+//!   <UL>
+//!     <LI>if 0, USB peripheral won't be initialized if this has already been done before
+//!     <LI>if 1, USB peripheral re-initialisation will be forced
+//!     <LI>if 2, USB peripheral re-initialisation will be forced, driver hooks won't be overwritten.<BR>
+//!   </UL>
+//! \return < 0 if initialisation failed
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_COM or \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_Init(u32 mode)
+{
+  // currently only mode 0..2 supported
+  if( mode >= 3 )
+    return -1; // unsupported mode
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Allows to query, if the USB interface has already been initialized.<BR>
+//! This function is used by the bootloader to avoid a reconnection, it isn't
+//! relevant for typical applications!
+//! \return 1 (the emulated interface is always available)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_IsInitialized(void)
+{
+  return 1;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns != 0 if a single USB port has been forced in the bootloader
+//! config section (never on the host)
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_ForceSingleUSB(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \returns != 0 if device mode is enforced in the bootloader config section
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_ForceDeviceMode(void)
+{
+  return 1;
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_USB */
@@ -0,0 +1,350 @@
+// $Id$
+//! \defgroup MIOS32_USB_MIDI
+//!
+//! USB MIDI layer for the POSIX emulation
+//!
+//! The USB cables 0..3 are connected to the host via MIOS32_POSIX (files or
+//! ALSA sequencer ports). Outgoing packages are converted into a MIDI byte
+//! stream, incoming MIDI messages are converted into packages and put into
+//! the Rx buffer from the receive thread of the host port.
+//!
+//! Applications shouldn't call these functions directly, instead please use \ref MIOS32_MIDI layer functions
+//! 
+//! \{
+/* ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Copyright of the POSIX emulation: 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include "mios32_posix.h"
+
+#include <time.h>
+
+// this module can be optionally disabled in a local mios32_config.h file (included from mios32.h)
+#if !defined(MIOS32_DONT_USE_USB_MIDI)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of cables which can be connected to the host
+#define NUM_CABLES ((MIOS32_USB_MIDI_NUM_PORTS < MIOS32_POSIX_MIDI_NUM_USB_PORTS) ? MIOS32_USB_MIDI_NUM_PORTS : MIOS32_POSIX_MIDI_NUM_USB_PORTS)
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+// parser state of a receive stream
+typedef struct {
+  u8 running_status;
+  u8 expected_bytes;
+  u8 num_bytes;
+  u8 bytes[3];
+  u8 sysex;
+} rx_parser_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////////////////////////////////
+
+// Rx buffer
+static u32 rx_buffer[MIOS32_USB_MIDI_RX_BUFFER_SIZE];
+static volatile u16 rx_buffer_tail;
+static volatile u16 rx_buffer_head;
+static volatile u16 rx_buffer_size;
+
+static rx_parser_t rx_parser[NUM_CABLES];
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static void MIOS32_USB_MIDI_RxCallback(u8 posix_port, u8 *data, u32 len);
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Initializes USB MIDI layer
+//! \param[in] mode currently only mode 0 supported
+//! \return < 0 if initialisation failed
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_Init(u32 mode)
+{
+  // currently only mode 0 supported
+  if( mode != 0 )
+    return -1; // unsupported mode
+
+  MIOS32_USB_MIDI_ChangeConnectionState(1);
+
+  // start the receive threads of the connected cables
+  int cable;
+  for(cable=0; cable<NUM_CABLES; ++cable) {
+    if( MIOS32_POSIX_MIDI_InputAvailable(MIOS32_POSIX_MIDI_PORT_USB(cable)) )
+      MIOS32_POSIX_MIDI_RxCallbackInit(MIOS32_POSIX_MIDI_PORT_USB(cable), MIOS32_USB_MIDI_RxCallback);
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function is called by the USB driver on cable connection/disconnection
+//! \param[in] connected status (1 if connected)
+//! \return < 0 on errors
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_ChangeConnectionState(u8 connected)
+{
+  // clear buffer counters
+  MIOS32_IRQ_Disable();
+  rx_buffer_tail = rx_buffer_head = rx_buffer_size = 0;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function returns the connection status of the USB MIDI interface
+//! \param[in] cable number
+//! \return 1: interface available (MIDI IN or OUT of the cable is connected to the host)
+//! \return 0: interface not available
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_CheckAvailable(u8 cable)
+{
+  if( cable >= NUM_CABLES )
+    return 0;
+
+  u8 posix_port = MIOS32_POSIX_MIDI_PORT_USB(cable);
+  return (MIOS32_POSIX_MIDI_InputAvailable(posix_port) || MIOS32_POSIX_MIDI_OutputAvailable(posix_port)) ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends a MIDI package to the host
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: USB cable not connected to the host
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageSend_NonBlocking(mios32_midi_package_t package)
+{
+  if( package.cable >= NUM_CABLES )
+    return -1;
+
+  u8 posix_port = MIOS32_POSIX_MIDI_PORT_USB(package.cable);
+  if( !MIOS32_POSIX_MIDI_OutputAvailable(posix_port) )
+    return MIOS32_POSIX_MIDI_InputAvailable(posix_port) ? 0 : -1; // output dropped if only the input is connected
+
+  u8 len = mios32_midi_pcktype_num_bytes[package.cin];
+  if( !len )
+    return 0; // reserved/misc package: nothing to send
+
+  u8 data[3] = { package.evnt0, package.evnt1, package.evnt2 };
+  return (MIOS32_POSIX_MIDI_Send(posix_port, data, len) < 0) ? -1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function sends a MIDI package to the host
+//! (blocking function - the host never blocks, so it's the same like
+//! the non-blocking variant)
+//! \param[in] package MIDI package
+//! \return 0: no error
+//! \return -1: USB cable not connected to the host
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageSend(mios32_midi_package_t package)
+{
+  return MIOS32_USB_MIDI_PackageSend_NonBlocking(package);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function checks for a new package
+//! \param[out] package pointer to MIDI package (received package will be put into the given variable)
+//! \return -1 if no package in buffer
+//! \return >= 0: number of packages which are still in the buffer
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackageReceive(mios32_midi_package_t *package)
+{
+  // package received?
+  if( !rx_buffer_size )
+    return -1;
+
+  // get package - this operation should be atomic!
+  MIOS32_IRQ_Disable();
+  package->ALL = rx_buffer[rx_buffer_tail];
+  if( ++rx_buffer_tail >= MIOS32_USB_MIDI_RX_BUFFER_SIZE )
+    rx_buffer_tail = 0;
+  --rx_buffer_size;
+  MIOS32_IRQ_Enable();
+
+  return rx_buffer_size;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function should be called periodically each mS to handle timeout
+//! and expire counters.
+//!
+//! Nothing to do for the emulation: packages are received by the host
+//! threads, and sent immediately.
+//! 
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_Periodic_mS(void)
+{
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Not used by the emulation
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+void MIOS32_USB_MIDI_EP1_IN_Callback(u8 bEP, u8 bEPStatus)
+{
+}
+
+void MIOS32_USB_MIDI_EP2_OUT_Callback(u8 bEP, u8 bEPStatus)
+{
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Puts a received package into the Rx buffer
+// If the buffer is full, the receive thread waits until the application
+// has fetched packages (the host never drops MIDI data)
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_USB_MIDI_RxPackagePut(mios32_midi_package_t package)
+{
+  for(;;) {
+    MIOS32_IRQ_Disable();
+
+    if( rx_buffer_size < MIOS32_USB_MIDI_RX_BUFFER_SIZE ) {
+      if( MIOS32_MIDI_SendPackageToRxCallback(USB0 + package.cable, package) == 0 ) {
+	rx_buffer[rx_buffer_head] = package.ALL;
+
+	if( ++rx_buffer_head >= MIOS32_USB_MIDI_RX_BUFFER_SIZE )
+	  rx_buffer_head = 0;
+	++rx_buffer_size;
+      }
+      MIOS32_IRQ_Enable();
+      return;
+    }
+
+    MIOS32_IRQ_Enable();
+
+    // wake up the MIDI task, and wait until the buffer is free again
+    MIOS32_MIDI_RxNotify();
+    struct timespec delay = { 0, 100000L };
+    nanosleep(&delay, NULL);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Converts the byte stream of a cable into packages
+// Called from the receive thread of the host port
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_USB_MIDI_RxCallback(u8 posix_port, u8 *data, u32 len)
+{
+  u8 cable = posix_port - MIOS32_POSIX_MIDI_PORT_USB(0);
+  if( cable >= NUM_CABLES )
+    return;
+
+  rx_parser_t *p = &rx_parser[cable];
+
+  for(; len; --len, ++data) {
+    u8 b = *data;
+    mios32_midi_package_t package;
+    package.ALL = 0;
+    package.cable = cable;
+
+    if( b >= 0xf8 ) { // realtime messages are passed immediately (also within SysEx)
+      package.cin = 0xf;
+      package.evnt0 = b;
+      MIOS32_USB_MIDI_RxPackagePut(package);
+      continue;
+    }
+
+    if( b == 0xf7 && p->sysex ) { // end of SysEx: cin 5/6/7 for 1/2/3 bytes
+      p->bytes[p->num_bytes++] = b;
+      package.cin = 0x4 + p->num_bytes;
+      package.evnt0 = p->bytes[0];
+      package.evnt1 = (p->num_bytes >= 2) ? p->bytes[1] : 0x00;
+      package.evnt2 = (p->num_bytes >= 3) ? p->bytes[2] : 0x00;
+      MIOS32_USB_MIDI_RxPackagePut(package);
+      p->sysex = 0;
+      p->num_bytes = 0;
+      continue;
+    }
+
+    if( b & 0x80 ) { // new status byte (terminates an incomplete SysEx)
+      p->sysex = (b == 0xf0);
+      p->num_bytes = 0;
+      p->running_status = (b < 0xf0) ? b : 0x00;
+
+      if( !p->sysex ) {
+	p->expected_bytes = (b < 0xf0) ? mios32_midi_expected_bytes_common[(b >> 4) & 0x7] : mios32_midi_expected_bytes_system[b & 0xf];
+	p->bytes[p->num_bytes++] = b;
+      }
+    } else if( !p->sysex ) { // data byte
+      if( !p->num_bytes ) {
+	if( !p->running_status )
+	  continue; // no status: ignore
+	p->bytes[p->num_bytes++] = p->running_status;
+      }
+      p->bytes[p->num_bytes++] = b;
+    }
+
+    if( p->sysex ) { // the SysEx stream is forwarded in packages of 3 bytes (incl. 0xf0)
+      p->bytes[p->num_bytes++] = b;
+      if( p->num_bytes >= 3 ) {
+	package.cin = 0x4; // SysEx starts or continues
+	package.evnt0 = p->bytes[0];
+	package.evnt1 = p->bytes[1];
+	package.evnt2 = p->bytes[2];
+	MIOS32_USB_MIDI_RxPackagePut(package);
+	p->num_bytes = 0;
+      }
+      continue;
+    }
+
+    if( p->num_bytes > p->expected_bytes ) {
+      u8 status = p->bytes[0];
+      if( status < 0xf0 )
+	package.cin = status >> 4;
+      else
+	package.cin = (p->num_bytes == 1) ? 0x5 : (p->num_bytes == 2) ? 0x2 : 0x3; // system common
+
+      package.evnt0 = status;
+      package.evnt1 = (p->num_bytes >= 2) ? p->bytes[1] : 0x00;
+      package.evnt2 = (p->num_bytes >= 3) ? p->bytes[2] : 0x00;
+      MIOS32_USB_MIDI_RxPackagePut(package);
+      p->num_bytes = 0;
+    }
+  }
+
+  // wake up the MIDI task (if enabled in the programming model)
+  MIOS32_MIDI_RxNotify();
+}
+
+//! \}
+
+#endif /* MIOS32_DONT_USE_USB_MIDI */
@@ -363,6 +363,9 @@ static void MIOS32_USB_MIDI_RxBufferHandler(void)
 	}
       } while( --count > 0 );
 
+      // wake up the MIDI task (if enabled in the programming model)
+      MIOS32_MIDI_RxNotify();
+
       // notify, that data has been put into buffer
       rx_buffer_new_data = 0;
 
@@ -399,6 +402,9 @@ static void MIOS32_USB_MIDI_RxBufferHandler(void)
 	}
       } while( --count > 0 );
 
+      // wake up the MIDI task (if enabled in the programming model)
+      MIOS32_MIDI_RxNotify();
+
       // notify, that data has been put into buffer
       rx_buffer_new_data = 0;
 
@@ -574,6 +574,10 @@ s32 MIOS32_UART_RxBufferPut(u8 uart, u8 b)
   ++rx_buffer_size[uart];
   MIOS32_IRQ_Enable();
 
+  // wake up the MIDI task (if enabled in the programming model)
+  if( MIOS32_UART_IsAssignedToMIDI(uart) )
+    MIOS32_MIDI_RxNotify();
+
   return 0; // no error
 #endif
 }
@@ -384,6 +384,9 @@ static void MIOS32_USB_MIDI_RxBufferHandler(void)
 	}
       } while( --count > 0 );
 
+      // wake up the MIDI task (if enabled in the programming model)
+      MIOS32_MIDI_RxNotify();
+
       // notify, that data has been put into buffer
       rx_buffer_new_data = 0;
 
@@ -602,6 +605,9 @@ static USBH_Status USBH_Handle(USB_OTG_CORE_HANDLE *pdev, void *phost)
 	    } while( --count > 0 );
 	    MIOS32_IRQ_Enable();
 
+	    // wake up the MIDI task (if enabled in the programming model)
+	    MIOS32_MIDI_RxNotify();
+
 	    USBH_MIDI_transfer_state = USBH_MIDI_IDLE;
 	    force_rx_req = 1;
 	  }
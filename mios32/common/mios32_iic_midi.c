@@ -140,6 +140,9 @@ s32 MIOS32_IIC_MIDI_Init(u32 mode)
   MIOS32_SYS_LPC_PINDIR(MIOS32_IIC_MIDI7_RI_N_PORT, MIOS32_IIC_MIDI7_RI_N_PIN, 0);
 #endif
 
+#elif defined(MIOS32_FAMILY_POSIX)
+  // POSIX emulation: no RI_N pins, receive status is polled
+
 #else
 #error "MIOS32_IIC_MIDI_Init() not prepared for this MIOS32_FAMILY!"
 #endif
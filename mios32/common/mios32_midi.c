@@ -141,6 +141,7 @@ static s32 (*sysex_callback_func)(mios32_midi_port_t port, u8 sysex_byte);
 static s32 (*timeout_callback_func)(mios32_midi_port_t port);
 static s32 (*debug_command_callback_func)(mios32_midi_port_t port, char c);
 static s32 (*filebrowser_command_callback_func)(mios32_midi_port_t port, char c);
+static void (*rx_notify_callback_func)(void);
 
 static sysex_state_t sysex_state;
 static u8 sysex_device_id;
@@ -201,6 +202,7 @@ s32 MIOS32_MIDI_Init(u32 mode)
   // disable callback functions
   direct_rx_callback_func = NULL;
   direct_tx_callback_func = NULL;
+  rx_notify_callback_func = NULL;
   sysex_callback_func = NULL;
   timeout_callback_func = NULL;
   debug_command_callback_func = NULL;
@@ -1523,6 +1525,48 @@ s32 MIOS32_MIDI_SendPackageToRxCallback(mios32_midi_port_t port, mios32_midi_pac
   return 0; // no error
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! Installs the Rx notify callback function which is executed whenever new
+//! MIDI data has been put into the USB, UART or SPI MIDI receive buffer,
+//! partly from interrupt handlers.
+//!
+//! It's used by the programming model to wake up the MIDI task, so that
+//! incoming packages are forwarded immediately instead of with the next
+//! mS tick (see MIOS32_USE_MIDI_RX_NOTIFY in programming_models/traditional/main.c)
+//!
+//! The callback should only give a semaphore or similar, it must not call
+//! MIOS32_MIDI_Receive_Handler() directly!
+//! \param[in] *callback_rx_notify pointer to callback function:<BR>
+//! \code
+//!    void callback_rx_notify(void)
+//!    {
+//!    }
+//! \endcode
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxNotifyCallback_Init(void (*callback_rx_notify)(void))
+{
+  rx_notify_callback_func = callback_rx_notify;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function is used by MIOS32 internal functions to notify that new
+//! MIDI data has been put into a receive buffer.
+//!
+//! It shouldn't be used by applications.
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxNotify(void)
+{
+  if( rx_notify_callback_func != NULL )
+    rx_notify_callback_func();
+  return 0; // no error
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function allows to change the DEFAULT port.<BR>
 //! The preset which will be used after application reset can be set in
@@ -1964,7 +2008,7 @@ static s32 MIOS32_MIDI_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ac
   *sysex_buffer_ptr++ = 0xf7;
 
   // finally send SysEx stream
-  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)sysex_buffer_ptr - ((u32)&sysex_buffer[0]));
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1993,7 +2037,7 @@ static s32 MIOS32_MIDI_SYSEX_SendAckStr(mios32_midi_port_t port, char *str)
   *sysex_buffer_ptr++ = 0xf7;
 
   // finally send SysEx stream
-  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)sysex_buffer_ptr - ((u32)&sysex_buffer[0]));
+  return MIOS32_MIDI_SendSysEx(port, (u8 *)sysex_buffer, (u32)(sysex_buffer_ptr - &sysex_buffer[0]));
 }
 
 
@@ -47,6 +47,11 @@
 //!   s32 osc_method(mios32_osc_args_t *osc_args, u32 method_arg)
 //! \endcode
 //!
+//! Optionally a static search tree can be compiled with MIOS32_OSC_CompileSearchTree()
+//! during initialisation (MIOS32_OSC_COMPILED_LEVELS has to be set in mios32_config.h).
+//! Literal address parts are then found with hash tables instead of comparing the
+//! addresses of all nodes. The results of the search are the same.
+//!
 //! All specified OSC arguments are supported, such as following "tags":
 //! <UL>
 //!   <LI>'i': signed 32bit integer
@@ -144,16 +149,56 @@
 #if !defined(MIOS32_DONT_USE_OSC)
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+// a compiled level of the search tree, all offsets are pointing into compiled_pool
+typedef struct {
+  const mios32_osc_search_tree_t *search_tree;
+  u16 num_nodes;
+  u16 hash_mask;      // size of the hash table - 1 (size is a power of 2)
+  u16 hash_offset;    // hash table of literal addresses: node index + 1, 0 = free entry
+  u16 num_patterns;
+  u16 pattern_offset; // indices of nodes with wildcards in their address (ascending order)
+  u16 next_offset;    // compiled level of search_tree[i].next, 0xffff if not available
+} mios32_osc_compiled_level_t;
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree);
-static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 compiled_level);
+static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree, s32 compiled_level);
+static u8 MIOS32_OSC_MatchAddress(char *path, const char *address, size_t *sep_pos);
+static s32 MIOS32_OSC_DispatchNode(char *path, size_t sep_pos, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *node, s32 next_level);
+
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+static s32 MIOS32_OSC_CompileLevel(const mios32_osc_search_tree_t *search_tree);
+static u32 MIOS32_OSC_HashAddress(const char *str, size_t *len, u8 *wildcard);
+static s32 MIOS32_OSC_CompiledLiteralNext(mios32_osc_compiled_level_t *level, u32 *hash_pos, char *path, size_t len);
+static s32 MIOS32_OSC_CompiledLevelGet(const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_CompiledNextLevelGet(s32 compiled_level, u32 node_ix);
+#endif
 
 static size_t my_strnlen(char *str, size_t max_len);
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+static mios32_osc_compiled_level_t compiled_levels[MIOS32_OSC_COMPILED_LEVELS];
+static u16 compiled_pool[MIOS32_OSC_COMPILED_POOL_SIZE];
+static u8 num_compiled_levels;
+static u16 compiled_pool_used;
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes OSC layer
 //! \param[in] mode currently only mode 0 supported
@@ -493,6 +538,13 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
   // store osc arguments (and more...) into osc_args variable
   mios32_osc_args_t osc_args;
 
+  // search in compiled tree if available
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+  s32 compiled_level = MIOS32_OSC_CompiledLevelGet(search_tree);
+#else
+  s32 compiled_level = -1;
+#endif
+
   // check if we got a bundle
   if( strncmp((char *)packet, "#bundle", len) == 0 ) {
     u32 pos = 8;
@@ -518,7 +570,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 
       // parse element if size > 0
       if( elem_size ) {
-	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree);
+	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree, compiled_level);
 	if( status < 0 )
 	  return status;
       }
@@ -532,7 +584,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
     osc_args.timetag.seconds = 0;
     osc_args.timetag.fraction = 1;
 
-    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree);
+    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree, compiled_level);
     if( status < 0 )
       return status;
   }
@@ -541,6 +593,47 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Compiles a search tree for MIOS32_OSC_ParsePacket()
+//!
+//! Each level of the tree gets a hash table for addresses without wildcards,
+//! so that the matching node of a literal address part is found without
+//! comparing all addresses of the level. Addresses with '*' and '?' wildcards,
+//! and paths which contain wildcards, are still compared like before, and the
+//! methods are called in the same order.
+//!
+//! The compiled data is stored in a static pool with MIOS32_OSC_COMPILED_LEVELS
+//! levels and MIOS32_OSC_COMPILED_POOL_SIZE halfwords (both can be changed in
+//! mios32_config.h). Trees which don't fit into the pool are parsed without
+//! compilation.
+//!
+//! The function should be called once during initialisation before packets
+//! are parsed, the search tree must not be changed afterwards.
+//! \param[in] search_tree the same tree which is passed to MIOS32_OSC_ParsePacket()
+//! \return 0 if the tree has been compiled (or was already compiled)
+//! \return -1 if the compiled dispatcher is disabled (MIOS32_OSC_COMPILED_LEVELS == 0)
+//! \return -2 if MIOS32_OSC_COMPILED_LEVELS or MIOS32_OSC_COMPILED_POOL_SIZE is too small
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_CompileSearchTree(const mios32_osc_search_tree_t *search_tree)
+{
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+  u8 prev_num_compiled_levels = num_compiled_levels;
+  u16 prev_compiled_pool_used = compiled_pool_used;
+
+  if( MIOS32_OSC_CompileLevel(search_tree) < 0 ) {
+    // release the levels of the incomplete tree
+    num_compiled_levels = prev_num_compiled_levels;
+    compiled_pool_used = prev_compiled_pool_used;
+    return -2; // pool full
+  }
+
+  return 0; // no error
+#else
+  return -1; // compiled dispatcher disabled
+#endif
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Internal function:
 // parses a single OSC element
@@ -548,7 +641,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 // returns -3 if element contains an unsupported format
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 compiled_level)
 {
   // exit immediately if element is empty
   if( !len )
@@ -677,86 +770,331 @@ static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_
 
   // finally parse for elements which are matching the OSC address
   osc_args->num_path_parts = 0;
-  return MIOS32_OSC_SearchPath((char *)&path[1], osc_args, 0x00000000, search_tree);
+  return MIOS32_OSC_SearchPath((char *)&path[1], osc_args, 0x00000000, search_tree, compiled_level);
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Internal function:
 // searches in search_tree for matching OSC addresses
+// compiled_level selects the compiled variant of search_tree, -1 if not available
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree, s32 compiled_level)
 {
   if( osc_args->num_path_parts >= MIOS32_OSC_MAX_PATH_PARTS )
     return -4; // maximum number of path parts exceeded
 
-  while( search_tree->address != NULL ) {
-    // compare OSC address with name of tree item
-    u8 match = 1;
-    u8 wildcard = 0;
-
-    char *str1 = path;
-    char *str2 = (char *)search_tree->address;
-    size_t sep_pos = 0;
-
-    while( *str1 != 0 && *str1 != '/' ) {
-      if( *str1 == '*' || *str2 == '*' ) {
-	// '*' wildcard: continue to end of address part
-	while( *str1 != 0 && *str1 != '/' ) {
-	  ++sep_pos;
-	  ++str1;
-	}
-	wildcard = 1;
-	break;
-      } else {
-	// no wildcard: check for matching characters
-	++sep_pos;
-	if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
-	  match = 0;
-	  break;
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+  if( compiled_level >= 0 ) {
+    size_t sep_pos;
+    u8 wildcard;
+    u32 hash = MIOS32_OSC_HashAddress(path, &sep_pos, &wildcard);
+
+    // fast path for address parts without wildcards
+    // (patterns in the path are handled by the linear search below)
+    if( !wildcard ) {
+      mios32_osc_compiled_level_t *level = &compiled_levels[compiled_level];
+      u16 *patterns = &compiled_pool[level->pattern_offset];
+      u32 hash_pos = hash & level->hash_mask;
+      u32 pattern_pos = 0;
+
+      // literal addresses are taken from the hash table, addresses with wildcards are
+      // compared like in the linear search. Both lists are sorted, so that the methods
+      // are called in the same order like before
+      s32 literal_ix = MIOS32_OSC_CompiledLiteralNext(level, &hash_pos, path, sep_pos);
+      while( literal_ix >= 0 || pattern_pos < level->num_patterns ) {
+	u32 node_ix;
+
+	if( pattern_pos < level->num_patterns && (literal_ix < 0 || patterns[pattern_pos] < literal_ix) ) {
+	  size_t pattern_sep_pos;
+	  node_ix = patterns[pattern_pos++];
+	  if( !MIOS32_OSC_MatchAddress(path, search_tree[node_ix].address, &pattern_sep_pos) )
+	    continue;
+	} else {
+	  node_ix = literal_ix;
+	  literal_ix = MIOS32_OSC_CompiledLiteralNext(level, &hash_pos, path, sep_pos);
 	}
-	++str1;
-	++str2;
-      }
-    }
-    
-    if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
-      match = 0;
-
-    if( match ) {
-      // store number of path parts in local variable, since content of osc_args is changed recursively
-      // we don't want to copy the whole structure to save (a lot of...) memory
-      u8 num_path_parts = osc_args->num_path_parts;
-      // add pointer to path part
-      osc_args->path_part[num_path_parts] = (char *)search_tree->address;
-      osc_args->num_path_parts = num_path_parts + 1;
-
-      // OR method args of current node to the args to propagate optional parameters
-      u32 combined_method_arg = method_arg | search_tree->method_arg;
-
-      if( search_tree->osc_method ) {
-	s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = search_tree->osc_method;
-	osc_method(osc_args, combined_method_arg);
-      } else if( search_tree->next ) {
-
-	// continue search in next hierarchy level
-	s32 status = MIOS32_OSC_SearchPath((char *)&path[sep_pos+1], osc_args, combined_method_arg, search_tree->next);
+
+	s32 status = MIOS32_OSC_DispatchNode(path, sep_pos, osc_args, method_arg, &search_tree[node_ix],
+					     MIOS32_OSC_CompiledNextLevelGet(compiled_level, node_ix));
 	if( status < 0 )
 	  return status;
       }
 
-      // restore number of path parts (which has been changed recursively)
-      osc_args->num_path_parts = num_path_parts;
+      return 0; // no error
     }
+  }
+#endif
 
-    ++search_tree;
+  u32 node_ix;
+  for(node_ix=0; search_tree[node_ix].address != NULL; ++node_ix) {
+    // compare OSC address with name of tree item
+    size_t sep_pos;
+    if( MIOS32_OSC_MatchAddress(path, search_tree[node_ix].address, &sep_pos) ) {
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+      s32 next_level = MIOS32_OSC_CompiledNextLevelGet(compiled_level, node_ix);
+#else
+      s32 next_level = -1;
+#endif
+      s32 status = MIOS32_OSC_DispatchNode(path, sep_pos, osc_args, method_arg, &search_tree[node_ix], next_level);
+      if( status < 0 )
+	return status;
+    }
   }
 
   return 0; // no error
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// compares the current part of the OSC path with the address of a tree item
+// '*' and '?' wildcards are allowed in both strings
+// sep_pos returns the position of the next '/' (or the terminator) in path
+// returns 1 on match, 0 otherwise
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_OSC_MatchAddress(char *path, const char *address, size_t *sep_pos)
+{
+  u8 match = 1;
+  u8 wildcard = 0;
+
+  char *str1 = path;
+  char *str2 = (char *)address;
+  *sep_pos = 0;
+
+  while( *str1 != 0 && *str1 != '/' ) {
+    if( *str1 == '*' || *str2 == '*' ) {
+      // '*' wildcard: continue to end of address part
+      while( *str1 != 0 && *str1 != '/' ) {
+	++*sep_pos;
+	++str1;
+      }
+      wildcard = 1;
+      break;
+    } else {
+      // no wildcard: check for matching characters
+      ++*sep_pos;
+      if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
+	match = 0;
+	break;
+      }
+      ++str1;
+      ++str2;
+    }
+  }
+
+  if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
+    match = 0;
+
+  return match;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// calls the method of a matching tree item, or continues the search in the
+// next hierarchy level
+// returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_DispatchNode(char *path, size_t sep_pos, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *node, s32 next_level)
+{
+  // store number of path parts in local variable, since content of osc_args is changed recursively
+  // we don't want to copy the whole structure to save (a lot of...) memory
+  u8 num_path_parts = osc_args->num_path_parts;
+  // add pointer to path part
+  osc_args->path_part[num_path_parts] = (char *)node->address;
+  osc_args->num_path_parts = num_path_parts + 1;
+
+  // OR method args of current node to the args to propagate optional parameters
+  u32 combined_method_arg = method_arg | node->method_arg;
+
+  if( node->osc_method ) {
+    s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = node->osc_method;
+    osc_method(osc_args, combined_method_arg);
+  } else if( node->next ) {
+
+    // continue search in next hierarchy level
+    s32 status = MIOS32_OSC_SearchPath((char *)&path[sep_pos+1], osc_args, combined_method_arg, node->next, next_level);
+    if( status < 0 )
+      return status;
+  }
+
+  // restore number of path parts (which has been changed recursively)
+  osc_args->num_path_parts = num_path_parts;
+
+  return 0; // no error
+}
+
+
+#if MIOS32_OSC_COMPILED_LEVELS > 0
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// hashes an address part up to the next '/' or the terminator (djb2)
+// len returns the length of the part, wildcard is set if it contains '*' or '?'
+/////////////////////////////////////////////////////////////////////////////
+static u32 MIOS32_OSC_HashAddress(const char *str, size_t *len, u8 *wildcard)
+{
+  u32 hash = 5381;
+
+  *len = 0;
+  *wildcard = 0;
+  while( str[*len] != 0 && str[*len] != '/' ) {
+    if( str[*len] == '*' || str[*len] == '?' )
+      *wildcard = 1;
+    hash = ((hash << 5) + hash) + (u8)str[*len];
+    ++*len;
+  }
+
+  return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// returns the index of the next literal address in the hash table which
+// is equal to the path part, starting at *hash_pos
+// returns -1 if there are no more matching addresses
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompiledLiteralNext(mios32_osc_compiled_level_t *level, u32 *hash_pos, char *path, size_t len)
+{
+  u16 *hash_table = &compiled_pool[level->hash_offset];
+  u16 entry;
+
+  // linear probing: the table always contains free entries
+  while( (entry=hash_table[*hash_pos]) != 0 ) {
+    const char *address = level->search_tree[entry-1].address;
+    *hash_pos = (*hash_pos + 1) & level->hash_mask;
+
+    if( strncmp(address, path, len) == 0 && address[len] == 0 )
+      return entry-1;
+  }
+
+  return -1; // no more matches
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// returns the compiled level of a search tree, -1 if not compiled
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompiledLevelGet(const mios32_osc_search_tree_t *search_tree)
+{
+  s32 i;
+
+  for(i=0; i<num_compiled_levels; ++i)
+    if( compiled_levels[i].search_tree == search_tree )
+      return i;
+
+  return -1; // not compiled
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// returns the compiled level of search_tree[node_ix].next, -1 if not available
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompiledNextLevelGet(s32 compiled_level, u32 node_ix)
+{
+  if( compiled_level < 0 )
+    return -1;
+
+  u16 next_level = compiled_pool[compiled_levels[compiled_level].next_offset + node_ix];
+  return (next_level == 0xffff) ? -1 : next_level;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// compiles a search tree level and (recursively) all levels behind it
+// returns the compiled level, or -1 if MIOS32_OSC_COMPILED_LEVELS or
+// MIOS32_OSC_COMPILED_POOL_SIZE has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompileLevel(const mios32_osc_search_tree_t *search_tree)
+{
+  // levels can be shared by multiple nodes (e.g. one level for each MIDI channel)
+  s32 level_id = MIOS32_OSC_CompiledLevelGet(search_tree);
+  if( level_id >= 0 )
+    return level_id;
+
+  if( num_compiled_levels >= MIOS32_OSC_COMPILED_LEVELS )
+    return -1; // no free level
+
+  // count nodes
+  u32 num_nodes = 0;
+  u32 num_patterns = 0;
+  const mios32_osc_search_tree_t *node;
+  for(node=search_tree; node->address != NULL; ++node) {
+    size_t len;
+    u8 wildcard;
+    MIOS32_OSC_HashAddress(node->address, &len, &wildcard);
+    ++num_nodes;
+    if( wildcard )
+      ++num_patterns;
+  }
+
+  // the hash table should be at least half empty
+  u32 hash_size = 2;
+  while( hash_size < 2*(num_nodes-num_patterns) )
+    hash_size <<= 1;
+
+  u32 num_words = hash_size + num_patterns + num_nodes;
+  if( num_nodes >= 0xffff || (compiled_pool_used + num_words) > MIOS32_OSC_COMPILED_POOL_SIZE )
+    return -1; // pool full
+
+  // allocate the level before the next levels are compiled, so that it can be found recursively
+  level_id = num_compiled_levels++;
+  mios32_osc_compiled_level_t *level = &compiled_levels[level_id];
+  level->search_tree = search_tree;
+  level->num_nodes = num_nodes;
+  level->hash_mask = hash_size - 1;
+  level->hash_offset = compiled_pool_used;
+  level->num_patterns = num_patterns;
+  level->pattern_offset = level->hash_offset + hash_size;
+  level->next_offset = level->pattern_offset + num_patterns;
+  compiled_pool_used += num_words;
+
+  u16 *hash_table = &compiled_pool[level->hash_offset];
+  u16 *patterns = &compiled_pool[level->pattern_offset];
+  u16 *next_levels = &compiled_pool[level->next_offset];
+  memset(hash_table, 0, hash_size*sizeof(u16));
+
+  // nodes are inserted in ascending order, so that equal addresses are found in this order as well
+  u32 node_ix;
+  u32 pattern_pos = 0;
+  for(node_ix=0; node_ix<num_nodes; ++node_ix) {
+    size_t len;
+    u8 wildcard;
+    u32 hash = MIOS32_OSC_HashAddress(search_tree[node_ix].address, &len, &wildcard);
+
+    if( wildcard ) {
+      patterns[pattern_pos++] = node_ix;
+    } else {
+      u32 hash_pos = hash & level->hash_mask;
+      while( hash_table[hash_pos] != 0 )
+	hash_pos = (hash_pos + 1) & level->hash_mask;
+      hash_table[hash_pos] = node_ix + 1;
+    }
+  }
+
+  // compile next levels (the next pointer is ignored for methods)
+  for(node_ix=0; node_ix<num_nodes; ++node_ix) {
+    next_levels[node_ix] = 0xffff;
+
+    if( !search_tree[node_ix].osc_method && search_tree[node_ix].next ) {
+      s32 next_level = MIOS32_OSC_CompileLevel(search_tree[node_ix].next);
+      if( next_level < 0 )
+	return -1; // pool full
+
+      next_levels[node_ix] = next_level;
+    }
+  }
+
+  return level_id;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Sends the argument list of a method to the debug terminal.
 //!
@@ -18,6 +18,10 @@
 //!
 //! MIOS32_SDCARD_SectorRead/SectorWrite allow to read/write a 512 byte sector.
 //!
+//! MIOS32_SDCARD_SectorsRead/SectorsWrite allow to read/write multiple
+//! consecutive sectors with a single command (CMD18/CMD25), which saves the
+//! command/response handshake for each sector.
+//!
 //! If such an access returns an error, it can be assumed that the SD Card has
 //! been disconnected during the transfer.
 //!
@@ -108,6 +112,20 @@
 #define SDCMD_WRITE_SINGLE_BLOCK (0x40+24)
 #define SDCMD_WRITE_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_STOP_TRANSMISSION	(0x40+12)
+#define SDCMD_STOP_TRANSMISSION_CRC 0xff
+
+#define SDCMD_READ_MULTIPLE_BLOCK (0x40+18)
+#define SDCMD_READ_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_WRITE_MULTIPLE_BLOCK (0x40+25)
+#define SDCMD_WRITE_MULTIPLE_BLOCK_CRC 0xff
+
+/* Data tokens */
+#define SDTOKEN_START_BLOCK		0xfe
+#define SDTOKEN_START_MULTIPLE_WRITE	0xfc
+#define SDTOKEN_STOP_MULTIPLE_WRITE	0xfd
+
 
 /* Card type flags (CardType) */
 #define CT_MMC				0x01
@@ -367,6 +385,10 @@ s32 MIOS32_SDCARD_SendSDCCmd(u8 cmd, u32 addr, u8 crc)
 
   u8 timeout = 0;
 
+  // CMD12 is followed by a stuff byte which has to be skipped
+  if( cmd == SDCMD_STOP_TRANSMISSION )
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
   if( cmd == SDCMD_SEND_STATUS ) {
 
   // one dummy read
@@ -579,6 +601,198 @@ error:
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Reads multiple consecutive sectors with a single READ_MULTIPLE_BLOCK
+//! command (CMD18), each sector is transfered via DMA
+//! \param[in] sector 32bit number of the first sector
+//! \param[in] *buffer pointer to a buffer of count*512 bytes
+//! \param[in] count number of sectors
+//! \return 0 if all sectors have been successfully read
+//! \return -error if error occured during read operation (see MIOS32_SDCARD_SectorRead)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if timeout while waiting for start token
+//! \return -259 if the STOP_TRANSMISSION command failed
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 count)
+{
+  s32 status = 0;
+  int i;
+
+  if( count <= 1 )
+    return count ? MIOS32_SDCARD_SectorRead(sector, buffer) : 0;
+
+  if (!(CardType & CT_BLOCK))
+	sector *= 512;
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_READ_MULTIPLE_BLOCK, sector, SDCMD_READ_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  u32 block;
+  for(block=0; block<count; ++block, buffer += 512) {
+    // wait for start token of the data block
+    u8 ret = 0xff;
+    for(i=0; i<65536; ++i) { // TODO: check if sufficient
+      ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+      if( ret != 0xff )
+	break;
+    }
+    if( ret != SDTOKEN_START_BLOCK ) { // timeout or error token
+      status= -257;
+      break;
+    }
+
+    // read 512 bytes via DMA
+#ifdef MIOS32_SDCARD_TASK_SUSPEND_HOOK
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, MIOS32_SDCARD_TASK_RESUME_HOOK);
+    MIOS32_SDCARD_TASK_SUSPEND_HOOK();
+#else
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, NULL);
+#endif
+
+    // read (and ignore) CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  }
+
+  // stop transmission (also on errors, otherwise the card continues to send data)
+  if( MIOS32_SDCARD_SendSDCCmd(SDCMD_STOP_TRANSMISSION, 0, SDCMD_STOP_TRANSMISSION_CRC) < 0 ) {
+    if( !status )
+      status = -259;
+    goto error;
+  }
+
+  // wait until card isn't busy anymore
+  for(i=0; i<65536; ++i) { // TODO: check if sufficient
+    if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) != 0x00 )
+      break;
+  }
+  if( i == 65536 && !status )
+    status = -259;
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  MIOS32_SDCARD_MUTEX_GIVE;
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Writes multiple consecutive sectors with a single WRITE_MULTIPLE_BLOCK
+//! command (CMD25), each sector is transfered via DMA
+//! \param[in] sector 32bit number of the first sector
+//! \param[in] *buffer pointer to a buffer of count*512 bytes
+//! \param[in] count number of sectors
+//! \return 0 if all sectors have been successfully written
+//! \return -error if error occured during write operation (see MIOS32_SDCARD_SectorWrite)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if write operation not accepted
+//! \return -258 if timeout during write operation
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsWrite(u32 sector, u8 *buffer, u32 count)
+{
+  s32 status = 0;
+  int i;
+
+  if( count <= 1 )
+    return count ? MIOS32_SDCARD_SectorWrite(sector, buffer) : 0;
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  if (!(CardType & CT_BLOCK))
+	sector *= 512;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_WRITE_MULTIPLE_BLOCK, sector, SDCMD_WRITE_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  u32 block;
+  for(block=0; block<count; ++block, buffer += 512) {
+    // send start token
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, SDTOKEN_START_MULTIPLE_WRITE);
+
+    // send 512 bytes of data via DMA
+#ifdef MIOS32_SDCARD_TASK_SUSPEND_HOOK
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, buffer, NULL, 512, MIOS32_SDCARD_TASK_RESUME_HOOK);
+    MIOS32_SDCARD_TASK_SUSPEND_HOOK();
+#else
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, buffer, NULL, 512, NULL);
+#endif
+
+    // send CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+    // read response
+    u8 response = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    if( (response & 0x0f) != 0x5 ) {
+      status= -257;
+      break;
+    }
+
+    // wait for write completion
+    for(i=0; i<32*65536; ++i) { // TODO: check if sufficient
+      u8 ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+      if( ret != 0x00 )
+	break;
+    }
+    if( i == 32*65536 ) {
+      status= -258;
+      goto error;
+    }
+  }
+
+  if( status == -257 ) {
+    // data has been rejected: the transfer has to be terminated with CMD12
+    MIOS32_SDCARD_SendSDCCmd(SDCMD_STOP_TRANSMISSION, 0, SDCMD_STOP_TRANSMISSION_CRC);
+  } else {
+    // send stop token, followed by one byte before the card signals busy state
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, SDTOKEN_STOP_MULTIPLE_WRITE);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  }
+
+  // wait for write completion
+  for(i=0; i<32*65536; ++i) { // TODO: check if sufficient
+    u8 ret = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    if( ret != 0x00 )
+      break;
+  }
+  if( i == 32*65536 && !status ) {
+    status= -258;
+    goto error;
+  }
+
+  // required for clocking (see spec)
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+  MIOS32_SDCARD_MUTEX_GIVE;
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Reads the CID informations from SD Card
 //! \param[in] *cid pointer to buffer which holds the CID informations
@@ -126,6 +126,8 @@ s32 MIOS32_SPI_MIDI_Enabled(void)
 {
 #if MIOS32_SPI_MIDI_NUM_PORTS == 0
   return 0; // SPI MIDI interface not explicitely enabled in mios32_config.h
+#elif !defined(MIOS32_SYS_ADDR_BSL_INFO_BEGIN)
+  return 0; // no bootloader info range (e.g. POSIX emulation)
 #else
   u8 *spi_midi_confirm = (u8 *)MIOS32_SYS_ADDR_SPI_MIDI_CONFIRM;
   u8 *spi_midi = (u8 *)MIOS32_SYS_ADDR_SPI_MIDI;
@@ -240,6 +242,7 @@ static void MIOS32_SPI_MIDI_DMA_Callback(void)
   // transfer RX values into ringbuffer (if possible)
   if( rx_ringbuffer_size < MIOS32_SPI_MIDI_RX_RINGBUFFER_SIZE ) {
     int i;
+    u8 prev_rx_ringbuffer_size = rx_ringbuffer_size;
 
     // atomic operation to avoid conflict with other interrupts
     MIOS32_IRQ_Disable();
@@ -268,6 +271,10 @@ static void MIOS32_SPI_MIDI_DMA_Callback(void)
     }
 
     MIOS32_IRQ_Enable();
+
+    // wake up the MIDI task (if enabled in the programming model)
+    if( rx_ringbuffer_size != prev_rx_ringbuffer_size )
+      MIOS32_MIDI_RxNotify();
   }
 
   // transfer finished
@@ -47,8 +47,12 @@ THUMB_SOURCE += \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_usb_midi.c \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_usb_com.c \
 	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_uart.c \
-	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_iic.c \
-	$(MIOS32_PATH)/mios32/common/printf-stdarg.c
+	$(MIOS32_PATH)/mios32/$(FAMILY)/mios32_iic.c
+
+# the POSIX emulation uses the printf functions of the C library of the host
+ifneq ($(FAMILY),POSIX)
+THUMB_SOURCE += $(MIOS32_PATH)/mios32/common/printf-stdarg.c
+endif
 
 
 # MEMO: the gcc linker is clever enough to exclude functions from the final memory image
@@ -211,6 +211,14 @@ typedef struct {
 #define MIOS32_SPI2_MOSI_SET(v)  MIOS32_SYS_LPC_PINSET(0, 18, v)
 #elif defined(MIOS32_FAMILY_EMULATION)
 #define MIOS32_SPI2_HIGH_VOLTAGE 5
+#elif defined(MIOS32_FAMILY_POSIX)
+#define MIOS32_SPI2_HIGH_VOLTAGE 5
+
+// POSIX emulation: no pins which could be measured
+#define MIOS32_SPI2_SCLK_INIT    { }
+#define MIOS32_SPI2_SCLK_SET(v)  { }
+#define MIOS32_SPI2_MOSI_INIT    { }
+#define MIOS32_SPI2_MOSI_SET(v)  { }
 #else
 # error "Please adapt MIOS32_SPI settings!"
 #endif
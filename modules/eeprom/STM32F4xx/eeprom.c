@@ -20,6 +20,8 @@
   *   - added EEPROM_SendDebugMessage()
   *   - added the usage infos below
   *   - migrated to STM32F4
+  *   - variables are kept in a RAM index, the next free location is cached
+  *   - EEPROM_Init() erases the old page before the new one is marked as valid
   *
   ******************************************************************************
   * @copy
@@ -62,6 +64,14 @@
 //! Than lower the specified size, than faster EEPROM_Write() will work, especially
 //! once pages have to be switched.
 //!
+//! EEPROM_Read() returns the variables from a RAM index which is built from the
+//! valid page during EEPROM_Init() and updated by EEPROM_Write(). It allocates
+//! 2*EEPROM_EMULATED_SIZE bytes (+1 bit per variable). If RAM is more important
+//! than speed, the variables can be searched in flash instead:
+//! \code
+//! #define EEPROM_RAM_INDEX 0
+//! \endcode
+//!
 //! Example application:<BR>
 //!   $MIOS32_PATH/apps/tutorials/025_sysex_and_eeprom (see patch.c)
 //!
@@ -114,10 +124,26 @@
 // TK: not used
 //extern uint16_t VirtAddVarTab[NumbOfVar];
 
+/* Next free location of the page which receives the variables */
+static uint16_t EE_WritePage = NO_VALID_PAGE;
+static uint32_t EE_WriteAddress;
+
+#if EEPROM_RAM_INDEX
+/* Last updates of the variables, EE_IndexPage is the page they have been read from */
+static uint16_t EE_IndexData[EEPROM_EMULATED_SIZE];
+static uint8_t EE_IndexFound[(EEPROM_EMULATED_SIZE+7)/8];
+static uint16_t EE_IndexPage = NO_VALID_PAGE;
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 static FLASH_Status EE_Format(void);
+static FLASH_Status EE_ErasePage(uint16_t Page);
 static uint16_t EE_FindValidPage(uint8_t Operation);
+static s32 EE_ReadVariable(uint16_t ValidPage, uint16_t VirtAddress);
+#if EEPROM_RAM_INDEX
+static void EE_BuildIndex(uint16_t ValidPage);
+#endif
 static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Data);
 static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data);
 
@@ -140,6 +166,12 @@ s32 EEPROM_Init(u32 mode)
   if( mode != 0 && mode != 1 )
     return -1; // currently only mode 0 and 1 are supported
 
+  /* Flash content could have been changed since last initialisation */
+  EE_WritePage = NO_VALID_PAGE;
+#if EEPROM_RAM_INDEX
+  EE_IndexPage = NO_VALID_PAGE;
+#endif
+
   /* Unlock the Flash Program Erase controller */
   FLASH_Unlock();
 
@@ -160,9 +192,9 @@ s32 EEPROM_Init(u32 mode)
   }
 
   /* Get Page0 status */
-  PageStatus0 = (*(__IO uint16_t*)PAGE0_BASE_ADDRESS);
+  PageStatus0 = (*(__IO uint16_t*)(size_t)PAGE0_BASE_ADDRESS);
   /* Get Page1 status */
-  PageStatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
+  PageStatus1 = (*(__IO uint16_t*)(size_t)PAGE1_BASE_ADDRESS);
 
   /* Check for invalid header states and repair if necessary */
   switch (PageStatus0)
@@ -174,7 +206,7 @@ s32 EEPROM_Init(u32 mode)
 	FLASH_ClearFlag(0xffffffff);
 	
         /* Erase Page0 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE0_SECTOR, VoltageRange_3);
+	FlashStatus = EE_ErasePage(PAGE0);
         /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
@@ -187,7 +219,7 @@ s32 EEPROM_Init(u32 mode)
 	FLASH_ClearFlag(0xffffffff);
 
         /* Erase Page0 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE0_SECTOR, VoltageRange_3);
+	FlashStatus = EE_ErasePage(PAGE0);
         /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
@@ -219,7 +251,7 @@ s32 EEPROM_Init(u32 mode)
         /* Transfer data from Page1 to Page0 */
         for (VarIdx = 0; VarIdx < EEPROM_EMULATED_SIZE; VarIdx++)
         {
-          if (( *(__IO uint16_t*)(PAGE0_BASE_ADDRESS + 6)) == VarIdx)
+          if (( *(__IO uint16_t*)(size_t)(PAGE0_BASE_ADDRESS + 6)) == VarIdx)
           {
             x = VarIdx;
           }
@@ -244,16 +276,16 @@ s32 EEPROM_Init(u32 mode)
 	// clear error flags, otherwise next flash access could break with fail
 	FLASH_ClearFlag(0xffffffff);
 
-        /* Mark Page0 as valid */
-        FlashStatus = FLASH_ProgramHalfWord(PAGE0_BASE_ADDRESS, VALID_PAGE);
-        /* If program operation was failed, a Flash error code is returned */
+        /* Erase Page1 before Page0 is marked as valid, so that both pages are never valid */
+	FlashStatus = EE_ErasePage(PAGE1);
+        /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
 	  return -2; // FlashStatus;
         }
-        /* Erase Page1 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE1_SECTOR, VoltageRange_3);
-        /* If erase operation was failed, a Flash error code is returned */
+        /* Mark Page0 as valid */
+        FlashStatus = FLASH_ProgramHalfWord(PAGE0_BASE_ADDRESS, VALID_PAGE);
+        /* If program operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
 	  return -2; // FlashStatus;
@@ -265,7 +297,7 @@ s32 EEPROM_Init(u32 mode)
 	FLASH_ClearFlag(0xffffffff);
 
         /* Erase Page1 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE1_SECTOR, VoltageRange_3);
+	FlashStatus = EE_ErasePage(PAGE1);
         /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
@@ -308,7 +340,7 @@ s32 EEPROM_Init(u32 mode)
 	FLASH_ClearFlag(0xffffffff);
 	
         /* Erase Page1 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE1_SECTOR, VoltageRange_3);
+	FlashStatus = EE_ErasePage(PAGE1);
         /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
@@ -320,7 +352,7 @@ s32 EEPROM_Init(u32 mode)
         /* Transfer data from Page0 to Page1 */
         for (VarIdx = 0; VarIdx < EEPROM_EMULATED_SIZE; VarIdx++)
         {
-          if ((*(__IO uint16_t*)(PAGE1_BASE_ADDRESS + 6)) == VarIdx)
+          if ((*(__IO uint16_t*)(size_t)(PAGE1_BASE_ADDRESS + 6)) == VarIdx)
           {
             x = VarIdx;
           }
@@ -345,16 +377,16 @@ s32 EEPROM_Init(u32 mode)
 	// clear error flags, otherwise next flash access could break with fail
 	FLASH_ClearFlag(0xffffffff);
 
-        /* Mark Page1 as valid */
-        FlashStatus = FLASH_ProgramHalfWord(PAGE1_BASE_ADDRESS, VALID_PAGE);
-        /* If program operation was failed, a Flash error code is returned */
+        /* Erase Page0 before Page1 is marked as valid, so that both pages are never valid */
+	FlashStatus = EE_ErasePage(PAGE0);
+        /* If erase operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
 	  return -2; // FlashStatus;
         }
-        /* Erase Page0 */
-	FlashStatus = FLASH_EraseSector(EEPROM_PAGE0_SECTOR, VoltageRange_3);
-        /* If erase operation was failed, a Flash error code is returned */
+        /* Mark Page1 as valid */
+        FlashStatus = FLASH_ProgramHalfWord(PAGE1_BASE_ADDRESS, VALID_PAGE);
+        /* If program operation was failed, a Flash error code is returned */
         if (FlashStatus != FLASH_COMPLETE)
         {
 	  return -2; // FlashStatus;
@@ -376,6 +408,15 @@ s32 EEPROM_Init(u32 mode)
   /* Lock the Flash Program Erase controller */
   FLASH_Lock();
 
+#if EEPROM_RAM_INDEX
+  /* Read all variables of the valid page into the RAM index */
+  uint16_t ValidPage = EE_FindValidPage(READ_FROM_VALID_PAGE);
+  if (ValidPage != NO_VALID_PAGE)
+  {
+    EE_BuildIndex(ValidPage);
+  }
+#endif
+
   return 0; // no error
 }
 
@@ -391,10 +432,6 @@ s32 EEPROM_Init(u32 mode)
 s32 EEPROM_Read(u16 VirtAddress)
 {
   uint16_t ValidPage = PAGE0;
-  uint16_t AddressValue = 0x5555;
-  s32 ReadStatus = -1;
-  uint32_t Address = 0x08010000, PageStartAddress = 0x08010000;
-  uint16_t Data = 0;
 
   /* Get active Page for read operation */
   ValidPage = EE_FindValidPage(READ_FROM_VALID_PAGE);
@@ -405,6 +442,43 @@ s32 EEPROM_Read(u16 VirtAddress)
     return -2; // no valid page
   }
 
+#if EEPROM_RAM_INDEX
+  if (VirtAddress < EEPROM_EMULATED_SIZE)
+  {
+    /* Rebuild the index if it doesn't belong to the valid page anymore */
+    if (ValidPage != EE_IndexPage)
+    {
+      EE_BuildIndex(ValidPage);
+    }
+
+    if (!(EE_IndexFound[VirtAddress >> 3] & (1 << (VirtAddress & 7))))
+    {
+      return -1; // not programmed yet
+    }
+
+    return EE_IndexData[VirtAddress];
+  }
+#endif
+
+  /* Search the variable in flash */
+  return EE_ReadVariable(ValidPage, VirtAddress);
+}
+
+/**
+  * @brief  Searches the last stored variable data in the given page
+  * @param  ValidPage: page which contains the variables
+  * @param  VirtAddress: Variable virtual address
+  * @retval Success or error status:
+  *           - >= 0: the 16bit variable if it has been found
+  *           - -1: if the variable was not found (not programmed yet)
+  */
+static s32 EE_ReadVariable(uint16_t ValidPage, uint16_t VirtAddress)
+{
+  uint16_t AddressValue = 0x5555;
+  s32 ReadStatus = -1;
+  uint32_t Address = 0x08010000, PageStartAddress = 0x08010000;
+  uint16_t Data = 0;
+
   /* Get the valid Page start Address */
   PageStartAddress = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(ValidPage * PAGE_SIZE));
 
@@ -415,13 +489,13 @@ s32 EEPROM_Read(u16 VirtAddress)
   while (Address > (PageStartAddress + 2))
   {
     /* Get the current location content to be compared with virtual address */
-    AddressValue = (*(__IO uint16_t*)Address);
+    AddressValue = (*(__IO uint16_t*)(size_t)Address);
 
     /* Compare the read address with the virtual address */
     if (AddressValue == VirtAddress)
     {
       /* Get content of Address-2 which is variable value */
-      Data = (*(__IO uint16_t*)(Address - 2));
+      Data = (*(__IO uint16_t*)(size_t)(Address - 2));
 
       /* In case variable value is read, reset ReadStatus flag */
       ReadStatus = 0;
@@ -441,6 +515,49 @@ s32 EEPROM_Read(u16 VirtAddress)
   return Data; // return value of variable
 }
 
+#if EEPROM_RAM_INDEX
+/**
+  * @brief  Reads the last updates of all variables from the given page
+  *   into the RAM index
+  * @param  ValidPage: page which contains the variables
+  * @retval None
+  */
+static void EE_BuildIndex(uint16_t ValidPage)
+{
+  uint16_t AddressValue = 0x5555;
+  uint32_t Address = 0x08010000, PageEndAddress = 0x080107FF;
+  uint16_t VarIdx = 0;
+
+  for (VarIdx = 0; VarIdx < sizeof(EE_IndexFound); VarIdx++)
+  {
+    EE_IndexFound[VarIdx] = 0;
+  }
+
+  /* Get the first variable of the valid Page */
+  Address = (uint32_t)(EEPROM_START_ADDRESS + 4 + (uint32_t)(ValidPage * PAGE_SIZE));
+
+  /* Get the valid Page end Address */
+  PageEndAddress = (uint32_t)((EEPROM_START_ADDRESS - 2) + (uint32_t)((1 + ValidPage) * PAGE_SIZE));
+
+  /* Check each active page address starting from begining, later updates overwrite previous values */
+  while (Address < PageEndAddress)
+  {
+    AddressValue = (*(__IO uint16_t*)(size_t)(Address + 2));
+
+    if (AddressValue < EEPROM_EMULATED_SIZE)
+    {
+      EE_IndexData[AddressValue] = (*(__IO uint16_t*)(size_t)Address);
+      EE_IndexFound[AddressValue >> 3] |= (1 << (AddressValue & 7));
+    }
+
+    /* Next address location */
+    Address = Address + 4;
+  }
+
+  EE_IndexPage = ValidPage;
+}
+#endif
+
 /**
   * @brief  Writes/upadtes variable data in EEPROM.
   * @param  VirtAddress: Variable virtual address
@@ -476,6 +593,23 @@ s32 EEPROM_Write(u16 VirtAddress, u16 Data)
   /* Lock the Flash Program Erase controller */
   FLASH_Lock();
 
+#if EEPROM_RAM_INDEX
+  if (VirtAddress < EEPROM_EMULATED_SIZE)
+  {
+    if (Status == FLASH_COMPLETE)
+    {
+      /* Update the RAM index */
+      EE_IndexData[VirtAddress] = Data;
+      EE_IndexFound[VirtAddress >> 3] |= (1 << (VirtAddress & 7));
+    }
+    else
+    {
+      /* Flash content is unknown, read it again with the next access */
+      EE_IndexPage = NO_VALID_PAGE;
+    }
+  }
+#endif
+
   /* Return last operation status */
   switch( Status ) {
     case FLASH_COMPLETE: return 0;
@@ -500,7 +634,7 @@ static FLASH_Status EE_Format(void)
   FLASH_ClearFlag(0xffffffff);
 
   /* Erase Page0 */
-  FlashStatus = FLASH_EraseSector(EEPROM_PAGE0_SECTOR, VoltageRange_3);
+  FlashStatus = EE_ErasePage(PAGE0);
 
   /* If erase operation was failed, a Flash error code is returned */
   if (FlashStatus != FLASH_COMPLETE)
@@ -518,12 +652,33 @@ static FLASH_Status EE_Format(void)
   }
 
   /* Erase Page1 */
-  FlashStatus = FLASH_EraseSector(EEPROM_PAGE1_SECTOR, VoltageRange_3);
+  FlashStatus = EE_ErasePage(PAGE1);
 
   /* Return Page1 erase operation status */
   return FlashStatus;
 }
 
+/**
+  * @brief  Erases a page and invalidates the cached informations about it
+  * @param  Page: PAGE0 or PAGE1
+  * @retval Status of the erase operation
+  */
+static FLASH_Status EE_ErasePage(uint16_t Page)
+{
+  if (EE_WritePage == Page)
+  {
+    EE_WritePage = NO_VALID_PAGE;
+  }
+#if EEPROM_RAM_INDEX
+  if (EE_IndexPage == Page)
+  {
+    EE_IndexPage = NO_VALID_PAGE;
+  }
+#endif
+
+  return FLASH_EraseSector((Page == PAGE0) ? EEPROM_PAGE0_SECTOR : EEPROM_PAGE1_SECTOR, VoltageRange_3);
+}
+
 /**
   * @brief  Find valid Page for write or read operation
   * @param  Operation: operation to achieve on the valid page.
@@ -538,10 +693,10 @@ static uint16_t EE_FindValidPage(uint8_t Operation)
   uint16_t PageStatus0 = 6, PageStatus1 = 6;
 
   /* Get Page0 actual status */
-  PageStatus0 = (*(__IO uint16_t*)PAGE0_BASE_ADDRESS);
+  PageStatus0 = (*(__IO uint16_t*)(size_t)PAGE0_BASE_ADDRESS);
 
   /* Get Page1 actual status */
-  PageStatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
+  PageStatus1 = (*(__IO uint16_t*)(size_t)PAGE1_BASE_ADDRESS);
 
   /* Write or read operation */
   switch (Operation)
@@ -626,15 +781,25 @@ static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Da
   /* Get the valid Page end Address */
   PageEndAddress = (uint32_t)((EEPROM_START_ADDRESS - 2) + (uint32_t)((1 + ValidPage) * PAGE_SIZE));
 
+  /* TK: continue at the location after the last written variable if it's still free */
+  if (ValidPage == EE_WritePage && EE_WriteAddress < PageEndAddress &&
+      (*(__IO uint32_t*)(size_t)EE_WriteAddress) == 0xFFFFFFFF)
+  {
+    Address = EE_WriteAddress;
+  }
+
   /* Check each active page address starting from begining */
   while (Address < PageEndAddress)
   {
     /* Verify if Address and Address+2 contents are 0xFFFFFFFF */
-    if ((*(__IO uint32_t*)Address) == 0xFFFFFFFF)
+    if ((*(__IO uint32_t*)(size_t)Address) == 0xFFFFFFFF)
     {
       // clear error flags, otherwise next flash access could break with fail
       FLASH_ClearFlag(0xffffffff);
 
+      /* Location will be used, search from begining again if programming fails */
+      EE_WritePage = NO_VALID_PAGE;
+
       /* Set variable data */
       FlashStatus = FLASH_ProgramHalfWord(Address, Data);
       /* If program operation was failed, a Flash error code is returned */
@@ -644,6 +809,12 @@ static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Da
       }
       /* Set variable virtual address */
       FlashStatus = FLASH_ProgramHalfWord(Address + 2, VirtAddress);
+      if (FlashStatus == FLASH_COMPLETE)
+      {
+        /* Next variable will be written behind this one */
+        EE_WritePage = ValidPage;
+        EE_WriteAddress = Address + 4;
+      }
       /* Return program operation status */
       return FlashStatus;
     }
@@ -673,7 +844,7 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
 {
   FLASH_Status FlashStatus = FLASH_COMPLETE;
   uint32_t NewPageAddress = 0x080103FF;
-  uint32_t OldPageSector = FLASH_Sector_2;
+  uint16_t OldPage = PAGE0;
   
   uint16_t ValidPage = PAGE0, VarIdx = 0;
   uint16_t EepromStatus = 0;
@@ -687,8 +858,8 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
     /* New page address where variable will be moved to */
     NewPageAddress = PAGE0_BASE_ADDRESS;
 
-    /* Old page sector where variable will be taken from */
-    OldPageSector = EEPROM_PAGE1_SECTOR;
+    /* Old page where variable will be taken from */
+    OldPage = PAGE1;
   }
   else if (ValidPage == PAGE0)  /* Page0 valid */
   {
@@ -696,7 +867,7 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
     NewPageAddress = PAGE1_BASE_ADDRESS;
 
     /* Old page address where variable will be taken from */
-    OldPageSector = EEPROM_PAGE0_SECTOR;
+    OldPage = PAGE0;
   }
   else
   {
@@ -744,7 +915,7 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
   FLASH_ClearFlag(0xffffffff);
 
   /* Erase the old Page: Set old Page status to ERASED status */
-  FlashStatus = FLASH_EraseSector(OldPageSector, VoltageRange_3);
+  FlashStatus = EE_ErasePage(OldPage);
   /* If erase operation was failed, a Flash error code is returned */
   if (FlashStatus != FLASH_COMPLETE)
   {
@@ -759,6 +930,11 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
     return FlashStatus;
   }
 
+#if EEPROM_RAM_INDEX
+  /* The RAM index contains the variables of the new page now */
+  EE_IndexPage = (OldPage == PAGE0) ? PAGE1 : PAGE0;
+#endif
+
   /* Return last operation flash status */
   return FlashStatus;
 }
@@ -782,9 +958,9 @@ s32 EEPROM_SendDebugMessage(u32 mode)
 
   if( mode >= 1 ) {
     status |= MIOS32_MIDI_SendDebugMessage("Page 0 (0x%08x):\n", PAGE0_BASE_ADDRESS);
-    status |= MIOS32_MIDI_SendDebugHexDump((u8 *)PAGE0_BASE_ADDRESS, PAGE_SIZE);
+    status |= MIOS32_MIDI_SendDebugHexDump((u8 *)(size_t)PAGE0_BASE_ADDRESS, PAGE_SIZE);
     status |= MIOS32_MIDI_SendDebugMessage("Page 1 (0x%08x):\n", PAGE1_BASE_ADDRESS);
-    status |= MIOS32_MIDI_SendDebugHexDump((u8 *)PAGE1_BASE_ADDRESS, PAGE_SIZE);
+    status |= MIOS32_MIDI_SendDebugHexDump((u8 *)(size_t)PAGE1_BASE_ADDRESS, PAGE_SIZE);
   }
 
   if( mode != 1 ) {
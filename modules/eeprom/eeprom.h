@@ -56,6 +56,9 @@
 #   define EEPROM_START_ADDRESS    ((uint32_t)0x08008000)  // the linker script reserves 0x08008000..0x0800ffff for two EEPROM pages
 #   define EEPROM_PAGE0_SECTOR     FLASH_Sector_2
 #   define EEPROM_PAGE1_SECTOR     FLASH_Sector_3
+#  ifndef EEPROM_RAM_INDEX
+#   define EEPROM_RAM_INDEX 1  // 1: variables are read from a copy in RAM, 0: variables are searched in flash
+#  endif
 # else
 #  error "Processor not prepared for STM32 EEPROM emulation"
 # endif
@@ -0,0 +1,417 @@
+// $Id$
+/*
+ * Host test of the STM32F4 EEPROM emulation with power failures
+ *
+ * eeprom.c is compiled for STM32F4 against the mios32.h replacement of this
+ * directory. It's included by this file, so that its RAM variables can be
+ * scrambled at a power failure like by a reset. The two flash pages are mapped to their target address, the
+ * flash functions program and erase them like the STM32F4 does (bits can
+ * only be programmed from 1 to 0, erasing works on complete sectors).
+ *
+ * A workload of writes which switches the pages twice is replayed from an
+ * erased flash, and the power fails at each program or erase operation.
+ * After the restart with EEPROM_Init(0), the RAM index has to match the
+ * variables which are found in flash, and all variables have to keep their
+ * values, only the interrupted write may be lost. If EEPROM_Init() has to
+ * repair the pages, the power also fails at each operation of the repair.
+ * Thereafter some more writes are done, and the index is checked again.
+ *
+ * In a second pass, an interrupted programming of a variable leaves a random
+ * part of the bits programmed. Then values may be corrupted, but the index
+ * still has to match the flash content.
+ *
+ * Usage: eeprom_test [-v]
+ *   -v: print the number of checked power failures of each pass
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+
+#include <mios32.h>
+#include "eeprom.h"
+
+// the flash functions are declared in mios32.h
+#include "../STM32F4xx/eeprom.c"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Flash stand-in
+/////////////////////////////////////////////////////////////////////////////
+
+// sectors 0..3 with 16k each, the EEPROM uses sector 2 and 3
+#define FLASH_BASE_ADDR   0x08000000
+#define FLASH_SIZE        0x10000
+#define SECTOR_SIZE       0x4000
+
+#define PAGE_ADDR(page)   (EEPROM_START_ADDRESS + (page)*PAGE_SIZE)
+#define FLASH_U16(addr)   (*(volatile u16 *)(size_t)(addr))
+
+static u8 flash_unlocked;
+static u32 flash_ops;     // program and erase operations since the last reset
+static u32 cut_at;        // operation which is interrupted by the power failure, 0: none
+static u8 cut_torn;       // an interrupted programming leaves a part of the bits programmed
+static jmp_buf power_fail;
+
+static u8 pages_snapshot[2*PAGE_SIZE];
+
+static int num_errors;
+static int verbose;
+static char context[100];
+
+static u32 random_seed = 12345;
+
+static u32 randomValue(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return (random_seed >> 16) % range;
+}
+
+static void error(const char *msg)
+{
+  if( num_errors < 10 )
+    printf("  ERROR %s: %s\n", context, msg);
+  ++num_errors;
+}
+
+void FLASH_Unlock(void) { flash_unlocked = 1; }
+void FLASH_Lock(void) { flash_unlocked = 0; }
+void FLASH_ClearFlag(u32 FLASH_FLAG) {}
+
+FLASH_Status FLASH_EraseSector(u32 FLASH_Sector, u8 VoltageRange)
+{
+  u32 sector = FLASH_Sector / FLASH_Sector_1;
+
+  if( !flash_unlocked )
+    error("sector erased while the flash is locked");
+  if( sector != 2 && sector != 3 ) {
+    error("sector outside of the EEPROM pages erased");
+    return FLASH_ERROR_WRP;
+  }
+
+  if( ++flash_ops == cut_at )
+    longjmp(power_fail, 1); // the erase hasn't been started
+
+  memset((u8 *)(size_t)(FLASH_BASE_ADDR + sector*SECTOR_SIZE), 0xff, SECTOR_SIZE);
+  return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(u32 Address, u16 Data)
+{
+  if( !flash_unlocked )
+    error("flash programmed while it's locked");
+  if( Address < PAGE_ADDR(0) || Address >= PAGE_ADDR(2) || (Address & 1) ) {
+    error("halfword outside of the EEPROM pages programmed");
+    return FLASH_ERROR_PGA;
+  }
+  if( (FLASH_U16(Address) & Data) != Data )
+    error("programming requires to change a bit from 0 to 1");
+
+  if( ++flash_ops == cut_at ) {
+    // the page status is assumed to be programmed completely, since the
+    // emulation can't recover from an undefined status
+    if( cut_torn && Address != PAGE_ADDR(0) && Address != PAGE_ADDR(1) )
+      FLASH_U16(Address) &= Data | (u16)randomValue(0x10000);
+    longjmp(power_fail, 1);
+  }
+
+  FLASH_U16(Address) &= Data;
+  return FLASH_COMPLETE;
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...) { return 0; }
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Expected values
+/////////////////////////////////////////////////////////////////////////////
+
+// variables NUM_VARS..EEPROM_EMULATED_SIZE-1 are never written
+#define NUM_VARS     100
+// enough writes to switch the pages twice
+#define NUM_WRITES   8200
+#define MORE_WRITES  20
+
+static u16 workload_addr[NUM_WRITES];
+static u16 workload_data[NUM_WRITES];
+
+static s32 expected[EEPROM_EMULATED_SIZE]; // -1: not written yet
+
+static void createWorkload(void)
+{
+  s32 value[NUM_VARS];
+  int i;
+
+  for(i=0; i<NUM_VARS; ++i)
+    value[i] = -1;
+
+  for(i=0; i<NUM_WRITES; ++i) {
+    u16 addr = randomValue(NUM_VARS);
+    u16 data;
+    do {
+      data = randomValue(0x10000);
+    } while( data == value[addr] ); // each write has to program the flash
+    workload_addr[i] = addr;
+    workload_data[i] = data;
+    value[addr] = data;
+  }
+}
+
+// Searches the variables in the valid page like EE_ReadVariable() does
+// -2: no valid page, -1: not programmed
+static void flashSearch(s32 *value)
+{
+  int page, i;
+  u32 addr;
+
+  if( FLASH_U16(PAGE_ADDR(0)) == 0x0000 )
+    page = 0;
+  else if( FLASH_U16(PAGE_ADDR(1)) == 0x0000 )
+    page = 1;
+  else {
+    for(i=0; i<EEPROM_EMULATED_SIZE; ++i)
+      value[i] = -2;
+    return;
+  }
+
+  for(i=0; i<EEPROM_EMULATED_SIZE; ++i)
+    value[i] = -1;
+
+  // the last update of a variable is valid
+  for(addr=PAGE_ADDR(page)+4; addr<PAGE_ADDR(page+1); addr+=4) {
+    u16 var = FLASH_U16(addr + 2);
+    if( var < EEPROM_EMULATED_SIZE )
+      value[var] = FLASH_U16(addr);
+  }
+}
+
+static void checkIndex(void)
+{
+  s32 value[EEPROM_EMULATED_SIZE];
+  int i;
+
+  flashSearch(value);
+  for(i=0; i<EEPROM_EMULATED_SIZE; ++i) {
+    if( EEPROM_Read(i) != value[i] ) {
+      char msg[100];
+      sprintf(msg, "variable %d: index returns %d, flash contains %d", i, (int)EEPROM_Read(i), (int)value[i]);
+      error(msg);
+      return;
+    }
+  }
+}
+
+// the variable of an interrupted write may have the old or the new value
+static void checkValues(int interrupted_addr, s32 interrupted_data)
+{
+  int i;
+
+  for(i=0; i<EEPROM_EMULATED_SIZE; ++i) {
+    s32 value = EEPROM_Read(i);
+    if( value != expected[i] && !(i == interrupted_addr && value == interrupted_data) ) {
+      char msg[100];
+      sprintf(msg, "variable %d: read %d, expected %d", i, (int)value, (int)expected[i]);
+      error(msg);
+      return;
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Power failures
+/////////////////////////////////////////////////////////////////////////////
+
+// Replays the workload from an erased flash until the power fails at the
+// given operation (0: no failure)
+// Returns the index of the interrupted write, -1 if formatting has been
+// interrupted, NUM_WRITES if the workload has been completed
+static int replay(u32 cut)
+{
+  static volatile int write; // keeps its value over longjmp
+  int i;
+
+  memset((u8 *)(size_t)PAGE_ADDR(0), 0xff, 2*PAGE_SIZE);
+  for(i=0; i<EEPROM_EMULATED_SIZE; ++i)
+    expected[i] = -1;
+
+  flash_ops = 0;
+  cut_at = cut;
+  write = -1;
+  if( setjmp(power_fail) ) {
+    cut_at = 0;
+    return write;
+  }
+
+  if( EEPROM_Init(1) < 0 )
+    error("formatting failed");
+
+  for(write=0; write<NUM_WRITES; ++write) {
+    if( EEPROM_Write(workload_addr[write], workload_data[write]) < 0 )
+      error("write failed");
+    expected[workload_addr[write]] = workload_data[write];
+  }
+
+  cut_at = 0;
+  return write;
+}
+
+// Starts again after a power failure: RAM variables are not valid anymore
+// (EEPROM_Init() has to reset them), the flash is locked
+static s32 restart(u32 cut)
+{
+  int i;
+
+  EE_WritePage = randomValue(2);
+  EE_WriteAddress = PAGE_ADDR(0) + 4*randomValue(2*PAGE_SIZE/4);
+#if EEPROM_RAM_INDEX
+  EE_IndexPage = randomValue(2);
+  for(i=0; i<EEPROM_EMULATED_SIZE; ++i)
+    EE_IndexData[i] = randomValue(0x10000);
+  for(i=0; i<sizeof(EE_IndexFound); ++i)
+    EE_IndexFound[i] = randomValue(0x100);
+#endif
+
+  flash_unlocked = 0;
+  flash_ops = 0;
+  cut_at = cut;
+  if( setjmp(power_fail) ) {
+    cut_at = 0;
+    return -100;
+  }
+
+  s32 status = EEPROM_Init(0);
+  cut_at = 0;
+  return status;
+}
+
+static void checkRestart(int interrupted_addr, s32 interrupted_data)
+{
+  int i;
+
+  if( restart(0) < 0 ) {
+    error("EEPROM_Init() failed");
+    return;
+  }
+
+  checkIndex();
+  if( !cut_torn )
+    checkValues(interrupted_addr, interrupted_data);
+
+  // the value of the interrupted write is known now
+  if( interrupted_addr >= 0 )
+    expected[interrupted_addr] = EEPROM_Read(interrupted_addr);
+
+  // continue with some writes
+  for(i=0; i<MORE_WRITES; ++i) {
+    u16 addr = randomValue(NUM_VARS);
+    u16 data = randomValue(0x10000);
+    if( EEPROM_Write(addr, data) < 0 )
+      error("write after restart failed");
+    expected[addr] = data;
+  }
+
+  checkIndex();
+  if( !cut_torn )
+    checkValues(-1, -1);
+}
+
+static int testPowerFail(u8 torn)
+{
+  u32 total_ops, cut, repair_cut;
+  u32 num_cuts = 0, num_repair_cuts = 0;
+
+  num_errors = 0;
+  cut_torn = 0;
+  sprintf(context, "without power failure");
+  if( replay(0) != NUM_WRITES )
+    error("workload not completed");
+  total_ops = flash_ops;
+  checkIndex();
+  checkValues(-1, -1);
+
+  cut_torn = torn;
+  for(cut=1; cut<=total_ops && num_errors < 10; ++cut) {
+    int write = replay(cut);
+    int interrupted_addr = (write >= 0) ? workload_addr[write] : -1;
+    s32 interrupted_data = (write >= 0) ? workload_data[write] : -1;
+    s32 expected_before[EEPROM_EMULATED_SIZE];
+
+    sprintf(context, "after power failure at flash operation %u", (unsigned)cut);
+    ++num_cuts;
+
+    // count the operations which are required by EEPROM_Init() to repair the pages
+    memcpy(pages_snapshot, (u8 *)(size_t)PAGE_ADDR(0), 2*PAGE_SIZE);
+    memcpy(expected_before, expected, sizeof(expected));
+    u8 torn_before = cut_torn;
+    cut_torn = 0;
+    restart(0);
+    cut_torn = torn_before;
+    u32 repair_ops = flash_ops;
+
+    // the power fails again during the repair (the partly programmed variables
+    // are the same as in the first pass)
+    if( torn )
+      repair_ops = 0;
+    for(repair_cut=1; repair_cut<=repair_ops && num_errors < 10; ++repair_cut) {
+      sprintf(context, "after power failure at flash operation %u and at repair operation %u", (unsigned)cut, (unsigned)repair_cut);
+      ++num_repair_cuts;
+      memcpy((u8 *)(size_t)PAGE_ADDR(0), pages_snapshot, 2*PAGE_SIZE);
+      memcpy(expected, expected_before, sizeof(expected));
+      restart(repair_cut);
+      checkRestart(interrupted_addr, interrupted_data);
+    }
+
+    sprintf(context, "after power failure at flash operation %u", (unsigned)cut);
+    memcpy((u8 *)(size_t)PAGE_ADDR(0), pages_snapshot, 2*PAGE_SIZE);
+    memcpy(expected, expected_before, sizeof(expected));
+    checkRestart(interrupted_addr, interrupted_data);
+  }
+
+  if( verbose )
+    printf("  %u flash operations, %u power failures, %u during repairs\n", (unsigned)total_ops, (unsigned)num_cuts, (unsigned)num_repair_cuts);
+
+  printf("%-50s %s\n", torn ? "power failures with partly programmed variables" : "power failures between flash operations", num_errors ? "FAILED" : "ok");
+  return num_errors ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int failed = 0;
+
+  if( argc > 1 && strcmp(argv[1], "-v") == 0 )
+    verbose = 1;
+
+  if( mmap((void *)FLASH_BASE_ADDR, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)FLASH_BASE_ADDR ) {
+    printf("ERROR: failed to map the flash to 0x%08x\n", FLASH_BASE_ADDR);
+    return 1;
+  }
+
+  createWorkload();
+
+  failed += testPowerFail(0);
+  failed += testPowerFail(1);
+
+  if( failed ) {
+    printf("%d test(s) failed\n", failed);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
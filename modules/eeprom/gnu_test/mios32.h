@@ -0,0 +1,45 @@
+/* $Id$ */
+/*
+ * Replaces mios32.h for the host test of the STM32F4 EEPROM emulation.
+ * Only the data types and the flash functions used by eeprom.c are
+ * declared, they access the flash stand-in of eeprom_test.c
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mios32_datatypes.h>
+
+#define __IO volatile
+
+typedef enum
+{ 
+  FLASH_BUSY = 1,
+  FLASH_ERROR_PGS,
+  FLASH_ERROR_PGP,
+  FLASH_ERROR_PGA,
+  FLASH_ERROR_WRP,
+  FLASH_ERROR_PROGRAM,
+  FLASH_ERROR_OPERATION,
+  FLASH_COMPLETE
+} FLASH_Status;
+
+#define VoltageRange_3     ((u8)0x02)
+
+#define FLASH_Sector_0     ((u16)0x0000)
+#define FLASH_Sector_1     ((u16)0x0008)
+#define FLASH_Sector_2     ((u16)0x0010)
+#define FLASH_Sector_3     ((u16)0x0018)
+
+extern void FLASH_Unlock(void);
+extern void FLASH_Lock(void);
+extern void FLASH_ClearFlag(u32 FLASH_FLAG);
+extern FLASH_Status FLASH_EraseSector(u32 FLASH_Sector, u8 VoltageRange);
+extern FLASH_Status FLASH_ProgramHalfWord(u32 Address, u16 Data);
+
+extern s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...);
+extern s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len);
+
+#endif /* _MIOS32_H */
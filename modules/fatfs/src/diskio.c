@@ -89,23 +89,20 @@ DRESULT disk_read (
 )
 {
   if( drv == SDCARD ) {
-    int i;
-
-    for(i=0; i<count; ++i) {
 #if DEBUG_VERBOSE_LEVEL >= 2
-      MIOS32_MIDI_SendDebugMessage("[disk_read] sector %d (#%d/%d)\n", sector+i, i+1, count);
+    MIOS32_MIDI_SendDebugMessage("[disk_read] sector %d (%d sectors)\n", sector, count);
 #endif
 
-      if( MIOS32_SDCARD_SectorRead(sector + i, buff + i*512) < 0 ) {
+    // consecutive sectors are read with a single multi-block command
+    if( MIOS32_SDCARD_SectorsRead(sector, buff, count) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
-	MIOS32_MIDI_SendDebugMessage("[disk_read] error while reading sector %d\n", sector+i);
+      MIOS32_MIDI_SendDebugMessage("[disk_read] error while reading sector %d (%d sectors)\n", sector, count);
 #endif
-	return RES_ERROR;
-      } else {
+      return RES_ERROR;
+    } else {
 #if DEBUG_VERBOSE_LEVEL >= 3
-	MIOS32_MIDI_SendDebugMessage("[disk_read] sector %d (#%d/%d) finished\n", sector+i, i+1, count);
+      MIOS32_MIDI_SendDebugMessage("[disk_read] sector %d (%d sectors) finished\n", sector, count);
 #endif
-      }
     }
 
     return RES_OK;
@@ -128,22 +125,20 @@ DRESULT disk_write (
 )
 {
   if( drv == SDCARD ) {
-    int i;
-
-    for(i=0; i<count; ++i) {
 #if DEBUG_VERBOSE_LEVEL >= 2
-      MIOS32_MIDI_SendDebugMessage("[disk_write] sector %d (#%d/%d)\n", sector+i, i+1, count);
+    MIOS32_MIDI_SendDebugMessage("[disk_write] sector %d (%d sectors)\n", sector, count);
 #endif
-      if( MIOS32_SDCARD_SectorWrite(sector + i, (u8 *)buff + 512*i) < 0 ) {
+
+    // consecutive sectors are written with a single multi-block command
+    if( MIOS32_SDCARD_SectorsWrite(sector, (u8 *)buff, count) < 0 ) {
 #if DEBUG_VERBOSE_LEVEL >= 1
-	MIOS32_MIDI_SendDebugMessage("[disk_write] error while writing to sector %d\n", sector+i);
+      MIOS32_MIDI_SendDebugMessage("[disk_write] error while writing to sector %d (%d sectors)\n", sector, count);
 #endif
-	return RES_ERROR;
-      } else {
+      return RES_ERROR;
+    } else {
 #if DEBUG_VERBOSE_LEVEL >= 3
-      MIOS32_MIDI_SendDebugMessage("[disk_write] sector %d (#%d/%d) finished\n", sector+i, i+1, count);
+      MIOS32_MIDI_SendDebugMessage("[disk_write] sector %d (%d sectors) finished\n", sector, count);
 #endif
-      }
     }
 
     return RES_OK;
@@ -11,6 +11,10 @@
 //! each FatFs handler allocates more than 512 bytes to store the last read
 //! sector)
 //!
+//! If multiple files have to be read concurrently (e.g. for streaming), they
+//! can be opened with FILE_ReadOpenH(), which allocates one of FILE_NUM_HANDLES
+//! additional handlers.
+//!
 //! For read operations it is possible to re-open a file via a file_t reference
 //! so that no directory access is required to find the first sector of the
 //! file (again).
@@ -109,6 +113,13 @@ typedef struct
 /////////////////////////////////////////////////////////////////////////////
 
 static s32 FILE_MountFS(void);
+static s32 FILE_ReadOpenFil(FIL *fil, char *filepath);
+static FIL *FILE_HandleFil(s32 handle);
+static u32 FILE_ReadFromSectorBuffer(FIL *fil, u8 *buffer, u32 len);
+static s32 FILE_ReadBufferFil(FIL *fil, u8 *buffer, u32 len);
+static s32 FILE_ReadBufferUnknownLenFil(FIL *fil, u8 *buffer, u32 len);
+static s32 FILE_ReadLineFil(FIL *fil, u8 *buffer, u32 max_len);
+static s32 FILE_BrowserReadBinSendBlocks(mios32_midi_port_t port);
 
 static s32 FILE_CreateTarRecursive(char *filename, char *src_path, u8 exclude_tar_files, u8 depth, u8 max_depth, u32 *num_dirs, u32 *num_files);
 static s32 FILE_CreateTarHeader(char *filename, char *src_path, u8 is_dir, u32 filesize);
@@ -133,6 +144,10 @@ static u8 file_read_is_open; // only for safety purposes
 static FIL file_write;
 static u8 file_write_is_open; // only for safety purposes
 
+// additional read handles, each FIL contains its own sector buffer
+static FIL file_handle[FILE_NUM_HANDLES];
+static u8 file_handle_is_open[FILE_NUM_HANDLES];
+
 // SD Card status
 static u8 sdcard_available;
 static u8 volume_available;
@@ -148,6 +163,21 @@ static u8 tmp_buffer[TMP_BUFFER_SIZE];
 static u32 browser_write_file_size;
 static u32 browser_write_file_pos;
 
+// binary transfers of FILE_BrowserHandler ("readbin" command)
+// data is sent in blocks of FILE_BROWSER_BIN_BLOCK_SIZE bytes (multiple of SECTOR_SIZE),
+// max. FILE_BROWSER_BIN_WINDOW blocks are sent before an acknowledge is expected
+#ifndef FILE_BROWSER_BIN_BLOCK_SIZE
+#define FILE_BROWSER_BIN_BLOCK_SIZE (4*SECTOR_SIZE)
+#endif
+#ifndef FILE_BROWSER_BIN_WINDOW
+#define FILE_BROWSER_BIN_WINDOW 2
+#endif
+
+static s32 browser_read_handle = -1;
+static u32 browser_read_file_size;
+static u32 browser_read_file_pos;
+static u32 browser_read_ack_pos;
+
 static s32 (*browser_upload_callback_func)(char *filename);
 
 
@@ -158,11 +188,13 @@ s32 FILE_Init(u32 mode)
 {
   file_read_is_open = 0;
   file_write_is_open = 0;
+  memset(file_handle_is_open, 0, sizeof(file_handle_is_open));
   sdcard_available = 0;
   volume_available = 0;
   volume_free_bytes = 0;
 
   browser_upload_callback_func = NULL;
+  browser_read_handle = -1;
 
   // init SDCard access
   s32 error = MIOS32_SDCARD_Init(0);
@@ -243,6 +275,8 @@ static s32 FILE_MountFS(void)
 
   file_read_is_open = 0;
   file_write_is_open = 0;
+  memset(file_handle_is_open, 0, sizeof(file_handle_is_open)); // file objects of the previous mount are invalid
+  browser_read_handle = -1;
 
   if( (res=f_mount(0, &fs)) != FR_OK ) {
     DEBUG_MSG("[FILE] Failed to mount SD Card - error status: %d\n", res);
@@ -361,26 +395,13 @@ char *FILE_VolumeLabel(void)
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! opens a file for reading
-//! Note: to save memory, one a single file is allowed to be opened per
-//! time - always use FILE_ReadClose() before opening a new file!
-//! Use FILE_ReadReOpen() to continue reading
+//! Local function which opens a file for reading, used by FILE_ReadOpen()
+//! and FILE_ReadOpenH()
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadOpen(file_t* file, char *filepath)
+static s32 FILE_ReadOpenFil(FIL *fil, char *filepath)
 {
-#if DEBUG_VERBOSE_LEVEL >= 2
-  DEBUG_MSG("[FILE] Opening file '%s'\n", filepath);
-#endif
-
-  if( file_read_is_open ) {
-#if DEBUG_VERBOSE_LEVEL >= 1
-    DEBUG_MSG("[FILE] FAILURE: tried to open file '%s' for reading, but previous file hasn't been closed!\n", filepath);
-#endif
-    return FILE_ERR_OPEN_READ_WITHOUT_CLOSE;
-  }
-
-  if( (file_dfs_errno=f_open(&file_read, filepath, FA_OPEN_EXISTING | FA_READ)) != FR_OK ) {
+  if( (file_dfs_errno=f_open(fil, filepath, FA_OPEN_EXISTING | FA_READ)) != FR_OK ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
     DEBUG_MSG("[FILE] Error opening file - try mounting the partition again\n");
 #endif
@@ -393,7 +414,7 @@ s32 FILE_ReadOpen(file_t* file, char *filepath)
       return FILE_ERR_SD_CARD;
     }
 
-    if( (file_dfs_errno=f_open(&file_read, filepath, FA_OPEN_EXISTING | FA_READ)) != FR_OK ) {
+    if( (file_dfs_errno=f_open(fil, filepath, FA_OPEN_EXISTING | FA_READ)) != FR_OK ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
       DEBUG_MSG("[FILE] Still not able to open file - giving up!\n");
 #endif
@@ -402,8 +423,37 @@ s32 FILE_ReadOpen(file_t* file, char *filepath)
   }
 
 #if DEBUG_VERBOSE_LEVEL >= 2
-  DEBUG_MSG("[FILE] found '%s' of length %u\n", filepath, file_read.fsize);
+  DEBUG_MSG("[FILE] found '%s' of length %u\n", filepath, fil->fsize);
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! opens a file for reading
+//! Note: to save memory, one a single file is allowed to be opened per
+//! time - always use FILE_ReadClose() before opening a new file!
+//! Use FILE_ReadReOpen() to continue reading, or FILE_ReadOpenH() if
+//! multiple files have to be read concurrently
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadOpen(file_t* file, char *filepath)
+{
+#if DEBUG_VERBOSE_LEVEL >= 2
+  DEBUG_MSG("[FILE] Opening file '%s'\n", filepath);
+#endif
+
+  if( file_read_is_open ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+    DEBUG_MSG("[FILE] FAILURE: tried to open file '%s' for reading, but previous file hasn't been closed!\n", filepath);
 #endif
+    return FILE_ERR_OPEN_READ_WITHOUT_CLOSE;
+  }
+
+  s32 status;
+  if( (status=FILE_ReadOpenFil(&file_read, filepath)) < 0 )
+    return status;
 
   // store current file variables in file_t
   file->flag = file_read.flag;
@@ -500,13 +550,7 @@ s32 FILE_ReadClose(file_t *file)
 /////////////////////////////////////////////////////////////////////////////
 s32 FILE_ReadSeek(u32 offset)
 {
-  if( (file_dfs_errno=f_lseek(&file_read, offset)) != FR_OK ) {
-#if DEBUG_VERBOSE_LEVEL >= 2
-    DEBUG_MSG("[FILE_ReadSeek] ERROR: seek to offset %u failed (FatFs status: %d)\n", offset, file_dfs_errno);
-#endif
-    return FILE_ERR_SEEK;
-  }
-  return 0; // no error
+  return FILE_ReadSeekH(FILE_HANDLE_DEFAULT, offset);
 }
 
 
@@ -527,108 +571,236 @@ u32 FILE_ReadGetCurrentPosition(void)
 }
 
 
-
 /////////////////////////////////////////////////////////////////////////////
 //! Read from file
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
 s32 FILE_ReadBuffer(u8 *buffer, u32 len)
 {
-  UINT successcount;
+  return FILE_ReadBufferFil(&file_read, buffer, len);
+}
 
-  // exit if volume not available
-  if( !volume_available )
-    return FILE_ERR_NO_VOLUME;
 
-  if( (file_dfs_errno=f_read(&file_read, buffer, len, &successcount)) != FR_OK ) {
-#if DEBUG_VERBOSE_LEVEL >= 3
-    DEBUG_MSG("[FILE] Failed to read sector at position 0x%08x, status: %u\n", file_read.fptr, file_dfs_errno);
+/////////////////////////////////////////////////////////////////////////////
+//! Read from file with unknown size
+//! \return < 0 on errors (error codes are documented in file.h)
+//! \return >= 0: value contains the actual read bytes
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadBufferUnknownLen(u8 *buffer, u32 len)
+{
+  return FILE_ReadBufferUnknownLenFil(&file_read, buffer, len);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Read a string (terminated with CR) from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadLine(u8 *buffer, u32 max_len)
+{
+  return FILE_ReadLineFil(&file_read, buffer, max_len);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Read a 8bit value from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadByte(u8 *byte)
+{
+  return FILE_ReadByteH(FILE_HANDLE_DEFAULT, byte);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Read a 16bit value from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadHWord(u16 *hword)
+{
+  return FILE_ReadHWordH(FILE_HANDLE_DEFAULT, hword);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Read a 32bit value from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadWord(u32 *word)
+{
+  return FILE_ReadWordH(FILE_HANDLE_DEFAULT, word);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the FIL object of a read handle
+//! FILE_HANDLE_DEFAULT selects the file of FILE_ReadOpen()/FILE_ReadReOpen()
+//! \return NULL if the handle is invalid or hasn't been opened
+/////////////////////////////////////////////////////////////////////////////
+static FIL *FILE_HandleFil(s32 handle)
+{
+  if( handle == FILE_HANDLE_DEFAULT )
+    return &file_read;
+
+  if( handle < 0 || handle >= FILE_NUM_HANDLES || !file_handle_is_open[handle] )
+    return NULL;
+
+  return &file_handle[handle];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Opens a file for reading with a separate handle.\n
+//! In distance to FILE_ReadOpen() multiple files can be read concurrently
+//! (e.g. for multi-track streaming) without re-opening them. Each handle
+//! allocates one of FILE_NUM_HANDLES FatFs objects, which contains its own
+//! sector buffer, until it's released with FILE_ReadCloseH()
+//! \return >= 0: the handle number
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadOpenH(char *filepath)
+{
+#if DEBUG_VERBOSE_LEVEL >= 2
+  DEBUG_MSG("[FILE] Opening file '%s' with handle\n", filepath);
 #endif
-      return FILE_ERR_READ;
+
+  s32 handle;
+  for(handle=0; handle<FILE_NUM_HANDLES; ++handle) {
+    if( !file_handle_is_open[handle] )
+      break;
   }
-  if( successcount != len ) {
-#if DEBUG_VERBOSE_LEVEL >= 3
-    DEBUG_MSG("[FILE] Wrong successcount while reading from position 0x%08x (count: %d)\n", file_read.fptr, successcount);
+
+  if( handle >= FILE_NUM_HANDLES ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+    DEBUG_MSG("[FILE] FAILURE: tried to open file '%s' for reading, but all %d handles are in use!\n", filepath, FILE_NUM_HANDLES);
 #endif
-    return FILE_ERR_READCOUNT;
+    return FILE_ERR_NO_HANDLE;
   }
 
-  return 0; // no error
+  s32 status;
+  if( (status=FILE_ReadOpenFil(&file_handle[handle], filepath)) < 0 )
+    return status;
+
+  // file is opened
+  file_handle_is_open[handle] = 1;
+
+  return handle;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! Read from file with unknown size
+//! Releases a handle which has been opened with FILE_ReadOpenH()
 //! \return < 0 on errors (error codes are documented in file.h)
-//! \return >= 0: value contains the actual read bytes
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadBufferUnknownLen(u8 *buffer, u32 len)
+s32 FILE_ReadCloseH(s32 handle)
 {
-  UINT successcount;
+  if( handle < 0 || handle >= FILE_NUM_HANDLES || !file_handle_is_open[handle] )
+    return FILE_ERR_INVALID_HANDLE;
 
-  // exit if volume not available
-  if( !volume_available )
-    return FILE_ERR_NO_VOLUME;
+  // file has been closed
+  file_handle_is_open[handle] = 0;
 
-  if( (file_dfs_errno=f_read(&file_read, buffer, len, &successcount)) != FR_OK ) {
-#if DEBUG_VERBOSE_LEVEL >= 3
-    DEBUG_MSG("[FILE] Failed to read sector at position 0x%08x, status: %u\n", file_read.fptr, file_dfs_errno);
+  // don't close file via f_close()! (see also FILE_ReadClose())
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Changes to a new file position
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadSeekH(s32 handle, u32 offset)
+{
+  FIL *fil = FILE_HandleFil(handle);
+  if( fil == NULL )
+    return FILE_ERR_INVALID_HANDLE;
+
+  if( (file_dfs_errno=f_lseek(fil, offset)) != FR_OK ) {
+#if DEBUG_VERBOSE_LEVEL >= 2
+    DEBUG_MSG("[FILE_ReadSeek] ERROR: seek to offset %u failed (FatFs status: %d)\n", offset, file_dfs_errno);
 #endif
-      return FILE_ERR_READ;
+    return FILE_ERR_SEEK;
   }
+  return 0; // no error
+}
+
 
-  return successcount;
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the size of a read file
+/////////////////////////////////////////////////////////////////////////////
+u32 FILE_ReadGetCurrentSizeH(s32 handle)
+{
+  FIL *fil = FILE_HandleFil(handle);
+  return fil ? fil->fsize : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns current file pointer of a read file
+/////////////////////////////////////////////////////////////////////////////
+u32 FILE_ReadGetCurrentPositionH(s32 handle)
+{
+  FIL *fil = FILE_HandleFil(handle);
+  return fil ? fil->fptr : 0;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! Read a string (terminated with CR) from file
+//! Read from file
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadLine(u8 *buffer, u32 max_len)
+s32 FILE_ReadBufferH(s32 handle, u8 *buffer, u32 len)
 {
-  s32 status;
-  u32 num_read = 0;
+  FIL *fil = FILE_HandleFil(handle);
+  if( fil == NULL )
+    return FILE_ERR_INVALID_HANDLE;
 
-  while( file_read.fptr < file_read.fsize ) {
-    status = FILE_ReadBuffer(buffer, 1);
+  return FILE_ReadBufferFil(fil, buffer, len);
+}
 
-    if( status < 0 )
-      return status;
 
-    ++num_read;
+/////////////////////////////////////////////////////////////////////////////
+//! Read from file with unknown size
+//! \return < 0 on errors (error codes are documented in file.h)
+//! \return >= 0: value contains the actual read bytes
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadBufferUnknownLenH(s32 handle, u8 *buffer, u32 len)
+{
+  FIL *fil = FILE_HandleFil(handle);
+  if( fil == NULL )
+    return FILE_ERR_INVALID_HANDLE;
 
-    if( *buffer == '\n' || *buffer == '\r' )
-      break;
+  return FILE_ReadBufferUnknownLenFil(fil, buffer, len);
+}
 
-    if( num_read < max_len )
-      ++buffer;
-  }
 
-  // replace newline by terminator
-  *buffer = 0;
+/////////////////////////////////////////////////////////////////////////////
+//! Read a string (terminated with CR) from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadLineH(s32 handle, u8 *buffer, u32 max_len)
+{
+  FIL *fil = FILE_HandleFil(handle);
+  if( fil == NULL )
+    return FILE_ERR_INVALID_HANDLE;
 
-  return num_read;
+  return FILE_ReadLineFil(fil, buffer, max_len);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //! Read a 8bit value from file
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadByte(u8 *byte)
+s32 FILE_ReadByteH(s32 handle, u8 *byte)
 {
-  return FILE_ReadBuffer(byte, 1);
+  return FILE_ReadBufferH(handle, byte, 1);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 //! Read a 16bit value from file
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadHWord(u16 *hword)
+s32 FILE_ReadHWordH(s32 handle, u16 *hword)
 {
   // ensure little endian coding
   u8 tmp[2];
-  s32 status = FILE_ReadBuffer(tmp, 2);
+  s32 status = FILE_ReadBufferH(handle, tmp, 2);
   *hword = ((u16)tmp[0] << 0) | ((u16)tmp[1] << 8);
   return status;
 }
@@ -637,16 +809,152 @@ s32 FILE_ReadHWord(u16 *hword)
 //! Read a 32bit value from file
 //! \return < 0 on errors (error codes are documented in file.h)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadWord(u32 *word)
+s32 FILE_ReadWordH(s32 handle, u32 *word)
 {
   // ensure little endian coding
   u8 tmp[4];
-  s32 status = FILE_ReadBuffer(tmp, 4);
+  s32 status = FILE_ReadBufferH(handle, tmp, 4);
   *word = ((u32)tmp[0] << 0) | ((u32)tmp[1] << 8) | ((u32)tmp[2] << 16) | ((u32)tmp[3] << 24);
   return status;
 }
 
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function which takes data from the sector buffer of a file\n
+//! Whenever the file pointer isn't located at a sector boundary, FatFs keeps
+//! the sector which contains the file pointer in fil->buf (see f_read()
+//! and f_lseek()). Small reads are served from this buffer without the
+//! overhead of f_read(), the next sector is loaded by f_read().
+//! \return number of bytes which have been taken from the sector buffer
+/////////////////////////////////////////////////////////////////////////////
+static u32 FILE_ReadFromSectorBuffer(FIL *fil, u8 *buffer, u32 len)
+{
+  u32 sector_offset = fil->fptr % SECTOR_SIZE;
+
+  if( !sector_offset || (fil->flag & FA__ERROR) )
+    return 0; // sector has to be loaded by f_read()
+
+  u32 available = SECTOR_SIZE - sector_offset;
+  u32 remaining = fil->fsize - fil->fptr;
+  if( available > remaining )
+    available = remaining;
+  if( len > available )
+    len = available;
+
+  memcpy(buffer, &fil->buf[sector_offset], len);
+  fil->fptr += len;
+
+  return len;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function to read from a file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_ReadBufferFil(FIL *fil, u8 *buffer, u32 len)
+{
+  UINT successcount;
+
+  // exit if volume not available
+  if( !volume_available )
+    return FILE_ERR_NO_VOLUME;
+
+  // take as much as possible from the sector buffer
+  {
+    u32 num_buffered = FILE_ReadFromSectorBuffer(fil, buffer, len);
+    if( num_buffered >= len )
+      return 0; // no error
+    buffer += num_buffered;
+    len -= num_buffered;
+  }
+
+  if( (file_dfs_errno=f_read(fil, buffer, len, &successcount)) != FR_OK ) {
+#if DEBUG_VERBOSE_LEVEL >= 3
+    DEBUG_MSG("[FILE] Failed to read sector at position 0x%08x, status: %u\n", fil->fptr, file_dfs_errno);
+#endif
+      return FILE_ERR_READ;
+  }
+  if( successcount != len ) {
+#if DEBUG_VERBOSE_LEVEL >= 3
+    DEBUG_MSG("[FILE] Wrong successcount while reading from position 0x%08x (count: %d)\n", fil->fptr, successcount);
+#endif
+    return FILE_ERR_READCOUNT;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function to read from a file with unknown size
+//! \return < 0 on errors (error codes are documented in file.h)
+//! \return >= 0: value contains the actual read bytes
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_ReadBufferUnknownLenFil(FIL *fil, u8 *buffer, u32 len)
+{
+  UINT successcount;
+
+  // exit if volume not available
+  if( !volume_available )
+    return FILE_ERR_NO_VOLUME;
+
+  // take as much as possible from the sector buffer
+  u32 num_buffered = FILE_ReadFromSectorBuffer(fil, buffer, len);
+  if( num_buffered >= len )
+    return num_buffered;
+
+  if( (file_dfs_errno=f_read(fil, buffer + num_buffered, len - num_buffered, &successcount)) != FR_OK ) {
+#if DEBUG_VERBOSE_LEVEL >= 3
+    DEBUG_MSG("[FILE] Failed to read sector at position 0x%08x, status: %u\n", fil->fptr, file_dfs_errno);
+#endif
+      return FILE_ERR_READ;
+  }
+
+  return num_buffered + successcount;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function to read a string (terminated with CR) from a file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_ReadLineFil(FIL *fil, u8 *buffer, u32 max_len)
+{
+  s32 status;
+  u32 num_read = 0;
+
+  while( fil->fptr < fil->fsize ) {
+    u32 sector_offset = fil->fptr % SECTOR_SIZE;
+
+    if( sector_offset && volume_available && !(fil->flag & FA__ERROR) ) {
+      // take character directly from the sector buffer (see FILE_ReadFromSectorBuffer())
+      *buffer = fil->buf[sector_offset];
+      ++fil->fptr;
+    } else {
+      // load next sector
+      status = FILE_ReadBufferFil(fil, buffer, 1);
+
+      if( status < 0 )
+	return status;
+    }
+
+    ++num_read;
+
+    if( *buffer == '\n' || *buffer == '\r' )
+      break;
+
+    if( num_read < max_len )
+      ++buffer;
+  }
+
+  // replace newline by terminator
+  *buffer = 0;
+
+  return num_read;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //! Opens a file for writing
 //! \return < 0 on errors (error codes are documented in file.h)
@@ -1854,6 +2162,9 @@ s32 FILE_SendErrorMessage(s32 error_status)
   case FILE_ERR_MKDIR: DEBUG_MSG("[SDCARD_ERROR:%d] FILE_MakeDir() failed\n", error_status); break;
   case FILE_ERR_INVALID_SESSION_NAME: DEBUG_MSG("[SDCARD_ERROR:%d] FILE_LoadSessionName()\n", error_status); break;
   case FILE_ERR_UPDATE_FREE: DEBUG_MSG("[SDCARD_ERROR:%d] FILE_UpdateFreeBytes()\n", error_status); break;
+  case FILE_ERR_REMOVE: DEBUG_MSG("[SDCARD_ERROR:%d] FILE_Remove() failed\n", error_status); break;
+  case FILE_ERR_NO_HANDLE: DEBUG_MSG("[SDCARD_ERROR:%d] FILE_ReadOpenH() failed, all handles are in use\n", error_status); break;
+  case FILE_ERR_INVALID_HANDLE: DEBUG_MSG("[SDCARD_ERROR:%d] invalid file handle\n", error_status); break;
 
   default:
     // remaining errors just print the number
@@ -1865,6 +2176,155 @@ s32 FILE_SendErrorMessage(s32 error_status)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Local function to calculate the CRC32 (as used by zip/ethernet) of binary
+//! file transfers
+/////////////////////////////////////////////////////////////////////////////
+static u32 FILE_BrowserCrc32(u32 crc, u8 *buffer, u32 len)
+{
+  crc = ~crc;
+  while( len-- ) {
+    crc ^= *buffer++;
+    int bit;
+    for(bit=0; bit<8; ++bit)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+  }
+  return ~crc;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function which sends 7bit bytes of a binary SysEx stream
+//! 3 bytes are collected for a USB MIDI package. With flush=1 the remaining
+//! bytes are sent together with the F7 which terminates the SysEx stream.
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_BrowserBinSend(mios32_midi_port_t port, u8 b, u8 flush)
+{
+  static u8 package_bytes[3];
+  static u8 num_package_bytes = 0;
+  s32 status = 0;
+
+  if( !flush ) {
+    package_bytes[num_package_bytes++] = b & 0x7f;
+    if( num_package_bytes < 3 )
+      return 0;
+  } else {
+    package_bytes[num_package_bytes++] = 0xf7;
+  }
+
+  mios32_midi_package_t package;
+  package.type = flush ? (0x4 + num_package_bytes) : 0x4; // SysEx continues or ends with 1..3 bytes
+  package.evnt0 = package_bytes[0];
+  package.evnt1 = (num_package_bytes >= 2) ? package_bytes[1] : 0x00;
+  package.evnt2 = (num_package_bytes >= 3) ? package_bytes[2] : 0x00;
+  status |= MIOS32_MIDI_SendPackage(port, package);
+
+  num_package_bytes = 0;
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function which sends a group of max. 7 bytes in 7bit format:
+//! the first byte contains the MSBs, followed by the lower 7 bits of each byte
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_BrowserBinSendGroup(mios32_midi_port_t port, u8 *group, u8 len)
+{
+  s32 status = 0;
+  u8 msbs = 0;
+  int i;
+
+  for(i=0; i<len; ++i)
+    if( group[i] & 0x80 )
+      msbs |= (1 << i);
+
+  status |= FILE_BrowserBinSend(port, msbs, 0);
+  for(i=0; i<len; ++i)
+    status |= FILE_BrowserBinSend(port, group[i], 0);
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Local function which sends the next blocks of a "readbin" transfer until
+//! FILE_BROWSER_BIN_WINDOW blocks are waiting for an acknowledge.\n
+//! Block format: 'b' <address: 8 hex digits> <7bit packed data> <CRC32: 5 x 7bit>
+//! The data is read sector-wise from SD Card.
+/////////////////////////////////////////////////////////////////////////////
+static s32 FILE_BrowserReadBinSendBlocks(mios32_midi_port_t port)
+{
+  s32 status = 0;
+
+  while( browser_read_file_pos < browser_read_file_size &&
+	 browser_read_file_pos < (browser_read_ack_pos + FILE_BROWSER_BIN_WINDOW*FILE_BROWSER_BIN_BLOCK_SIZE) ) {
+    u32 pos = browser_read_file_pos;
+    u32 block_len = browser_read_file_size - pos;
+    if( block_len > FILE_BROWSER_BIN_BLOCK_SIZE )
+      block_len = FILE_BROWSER_BIN_BLOCK_SIZE;
+
+    // send status message to MIOS terminal for the case that MIOS Studio has been started
+    // while read operation in progress
+    if( (pos % (320*32)) == 0 ) {
+      DEBUG_MSG("[FILE] Download of %d bytes in progress (%d%%)", browser_read_file_size, (int)((100.0*(float)pos)/(float)browser_read_file_size));
+    }
+
+    // the address digits are packed together with the data: MIOS32_MIDI_SendDebugStringBody()
+    // would fill the last USB MIDI package of the 8 digits with a zero
+    char str[10];
+    sprintf(str, "%08X", (unsigned)pos);
+    status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'b');
+    int i;
+    for(i=0; i<8; ++i)
+      status |= FILE_BrowserBinSend(port, str[i], 0);
+
+    // note: SECTOR_SIZE isn't dividable by 7, the last group of a sector
+    // will be continued with the first bytes of the next sector
+    u8 group[7];
+    u8 group_len = 0;
+    u32 crc = 0;
+    u32 offset;
+    for(offset=0; offset<block_len; offset+=SECTOR_SIZE) {
+      u32 len = block_len - offset;
+      if( len > SECTOR_SIZE )
+	len = SECTOR_SIZE;
+
+      if( FILE_ReadBufferH(browser_read_handle, tmp_buffer, len) < 0 ) {
+	// abort transfer - MIOS Studio will notice the missing block
+	status |= FILE_BrowserBinSend(port, 0, 1);
+	FILE_ReadCloseH(browser_read_handle);
+	browser_read_handle = -1;
+	return FILE_ERR_READ;
+      }
+      crc = FILE_BrowserCrc32(crc, tmp_buffer, len);
+
+      for(i=0; i<len; ++i) {
+	group[group_len++] = tmp_buffer[i];
+	if( group_len >= 7 ) {
+	  status |= FILE_BrowserBinSendGroup(port, group, group_len);
+	  group_len = 0;
+	}
+      }
+
+      if( (offset + len) >= block_len && group_len )
+	status |= FILE_BrowserBinSendGroup(port, group, group_len);
+    }
+
+    status |= FILE_BrowserBinSend(port, (crc >> 28) & 0x0f, 0);
+    status |= FILE_BrowserBinSend(port, (crc >> 21) & 0x7f, 0);
+    status |= FILE_BrowserBinSend(port, (crc >> 14) & 0x7f, 0);
+    status |= FILE_BrowserBinSend(port, (crc >>  7) & 0x7f, 0);
+    status |= FILE_BrowserBinSend(port, (crc >>  0) & 0x7f, 0);
+    status |= FILE_BrowserBinSend(port, 0, 1);
+
+    browser_read_file_pos += block_len;
+  }
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Handler for MIOS Studio Filebrowser accesses.\n
 //! See $MIOS32_PATH/apps/controllers/midio128/src/terminal.c for usage example.
@@ -1994,7 +2454,80 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 
 	FILE_ReadClose(&file);
       }
-    } else if( strcmp(parameter, "write") == 0 ) {
+    } else if( strcmp(parameter, "readbin") == 0 ) {
+      command_taken = 1;
+      status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'B');
+
+      // cancel previous transfer (if any)
+      if( browser_read_handle >= 0 ) {
+	FILE_ReadCloseH(browser_read_handle);
+	browser_read_handle = -1;
+      }
+
+      if( !volume_available ) {
+	status |= MIOS32_MIDI_SendDebugStringBody(port, "!", 1); // SD Card not mounted
+      } else {
+	char *filepath = brkt;
+
+	if( (browser_read_handle = FILE_ReadOpenH(filepath)) < 0 ) {
+	  browser_read_handle = -1;
+	  status |= MIOS32_MIDI_SendDebugStringBody(port, "-", 1); // can't access file
+	} else {
+	  char str[20];
+	  browser_read_file_size = FILE_ReadGetCurrentSizeH(browser_read_handle);
+	  browser_read_file_pos = 0;
+	  browser_read_ack_pos = 0;
+	  sprintf(str, "%d", browser_read_file_size);
+	  status |= MIOS32_MIDI_SendDebugStringBody(port, str, strlen(str));
+	  status |= MIOS32_MIDI_SendDebugStringFooter(port);
+	  send_footer = 0; // done
+
+	  if( browser_read_file_size ) {
+	    status |= FILE_BrowserReadBinSendBlocks(port);
+	  } else {
+	    FILE_ReadCloseH(browser_read_handle);
+	    browser_read_handle = -1;
+	  }
+	}
+      }
+    } else if( strcmp(parameter, "readbinack") == 0 || strcmp(parameter, "readbinnak") == 0 ) {
+      command_taken = 1;
+      u8 nak = parameter[7] == 'n'; // readbin(n)ak
+
+      u32 address_offset = 0;
+      u8 parameters_valid = 0;
+      if( (parameter = strtok_r(NULL, separators, &brkt)) ) {
+	char *next;
+	long l = strtol(parameter, &next, 16);
+	if( parameter != next ) {
+	  address_offset = l;
+	  parameters_valid = 1;
+	}
+      }
+
+      if( browser_read_handle < 0 || !parameters_valid ||
+	  address_offset < browser_read_ack_pos || address_offset > browser_read_file_pos ||
+	  ((address_offset % FILE_BROWSER_BIN_BLOCK_SIZE) && address_offset != browser_read_file_size) ) {
+	status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'B');
+	status |= MIOS32_MIDI_SendDebugStringBody(port, "~", 1); // no transfer or invalid parameter
+      } else {
+	send_footer = 0; // only blocks will be sent
+	browser_read_ack_pos = address_offset;
+
+	if( browser_read_ack_pos >= browser_read_file_size ) {
+	  FILE_ReadCloseH(browser_read_handle);
+	  browser_read_handle = -1;
+	  DEBUG_MSG("[FILE] Download of %d bytes finished.", browser_read_file_size);
+	} else {
+	  if( nak ) {
+	    // continue with the requested block
+	    browser_read_file_pos = address_offset;
+	    FILE_ReadSeekH(browser_read_handle, address_offset);
+	  }
+	  status |= FILE_BrowserReadBinSendBlocks(port);
+	}
+      }
+    } else if( strcmp(parameter, "write") == 0 || strcmp(parameter, "writebin") == 0 ) {
       command_taken = 1;
       status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'W');
       u8 parameters_valid = 1;
@@ -2043,10 +2576,11 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 	  }
 	}
       }
-    } else if( strcmp(parameter, "writedata") == 0 ) {
+    } else if( strcmp(parameter, "writedata") == 0 || strcmp(parameter, "writebindata") == 0 ) {
       command_taken = 1;
       status |= MIOS32_MIDI_SendDebugStringHeader(port, 0x41, (u8)'W');
       u8 parameters_valid = 1;
+      u8 binary = parameter[5] == 'b';
 
       u32 address_offset = 0;
       if( !(parameter = strtok_r(NULL, separators, &brkt)) ) {
@@ -2061,6 +2595,18 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 	}
       }
 
+      u32 crc = 0;
+      if( binary && parameters_valid ) {
+	if( !(parameter = strtok_r(NULL, separators, &brkt)) ) {
+	  parameters_valid = 0;
+	} else {
+	  char *next;
+	  crc = strtoul(parameter, &next, 16);
+	  if( parameter == next )
+	    parameters_valid = 0;
+	}
+      }
+
       if( !parameters_valid || address_offset != browser_write_file_pos ) {
 	status |= MIOS32_MIDI_SendDebugStringBody(port, "~", 1); // missing or invalid parameter
       } else {
@@ -2070,29 +2616,55 @@ s32 FILE_BrowserHandler(mios32_midi_port_t port, char *command)
 
 	  char *str_ptr = brkt;
 	  int num_bytes;
-	  for(num_bytes=0; *str_ptr; ++num_bytes) { // we can receive any number of bytes
-	    u8 b;
-	    if( *str_ptr >= '0' && *str_ptr <= '9' )
-	      b = (*str_ptr - '0') << 4;
-	    else if( *str_ptr >= 'A' && *str_ptr <= 'F' )
-	      b = (*str_ptr - 'A' + 10) << 4;
-	    else
-	      break;
-	    ++str_ptr;
-
-	    if( *str_ptr >= '0' && *str_ptr <= '9' )
-	      b |= (*str_ptr - '0');
-	    else if( *str_ptr >= 'A' && *str_ptr <= 'F' )
-	      b |= (*str_ptr - 'A' + 10);
-	    else
-	      break;
-	    ++str_ptr;
-
-	    FILE_WriteByte(b);
+	  if( binary ) {
+	    // 6bit coding: 4 characters ('0'..'o') contain 3 bytes
+	    u32 bits = 0;
+	    int num_bits = 0;
+	    for(num_bytes=0; *str_ptr >= 0x30 && *str_ptr <= 0x6f && num_bytes < TMP_BUFFER_SIZE; ++str_ptr) {
+	      bits = (bits << 6) | (*str_ptr - 0x30);
+	      num_bits += 6;
+	      if( num_bits >= 8 ) {
+		num_bits -= 8;
+		tmp_buffer[num_bytes++] = (bits >> num_bits) & 0xff;
+	      }
+	    }
+	  } else {
+	    for(num_bytes=0; *str_ptr && num_bytes < TMP_BUFFER_SIZE; ++num_bytes) { // we can receive any number of bytes
+	      u8 b;
+	      if( *str_ptr >= '0' && *str_ptr <= '9' )
+		b = (*str_ptr - '0') << 4;
+	      else if( *str_ptr >= 'A' && *str_ptr <= 'F' )
+		b = (*str_ptr - 'A' + 10) << 4;
+	      else
+		break;
+	      ++str_ptr;
+
+	      if( *str_ptr >= '0' && *str_ptr <= '9' )
+		b |= (*str_ptr - '0');
+	      else if( *str_ptr >= 'A' && *str_ptr <= 'F' )
+		b |= (*str_ptr - 'A' + 10);
+	      else
+		break;
+	      ++str_ptr;
+
+	      tmp_buffer[num_bytes] = b;
+	    }
 	  }
 
-	  browser_write_file_pos += num_bytes;
-	  if( browser_write_file_pos >= browser_write_file_size ) {
+	  u8 checksum_error = binary && FILE_BrowserCrc32(0, tmp_buffer, num_bytes) != crc;
+	  if( !checksum_error ) {
+	    FILE_WriteBuffer(tmp_buffer, num_bytes);
+	    browser_write_file_pos += num_bytes;
+	  }
+
+	  if( checksum_error ) {
+	    FILE_WriteClose();
+	    status |= MIOS32_MIDI_SendDebugStringBody(port, "*", 1); // checksum error
+	    status |= MIOS32_MIDI_SendDebugStringFooter(port);
+	    send_footer = 0;
+
+	    DEBUG_MSG("[FILE] Upload aborted due to checksum error at position 0x%08x.", browser_write_file_pos);
+	  } else if( browser_write_file_pos >= browser_write_file_size ) {
 	    FILE_WriteClose();
 	    status |= MIOS32_MIDI_SendDebugStringBody(port, "#", 1); // done
 	    status |= MIOS32_MIDI_SendDebugStringFooter(port);
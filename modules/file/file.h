@@ -22,6 +22,15 @@ extern "C" {
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
+// number of additional read handles which can be opened with FILE_ReadOpenH()
+// each handle allocates a FatFs file object with its own sector buffer (~550 bytes)
+#ifndef FILE_NUM_HANDLES
+#define FILE_NUM_HANDLES 2
+#endif
+
+// selects the file opened with FILE_ReadOpen() in FILE_Read*H() functions
+#define FILE_HANDLE_DEFAULT -1
+
 // error codes
 // NOTE: FILE_SendErrorMessage() should be extended whenever new codes have been added!
 
@@ -51,6 +60,8 @@ extern "C" {
 #define FILE_ERR_INVALID_SESSION_NAME -24 // FILE_LoadSessionName()
 #define FILE_ERR_UPDATE_FREE      -25 // FILE_UpdateFreeBytes()
 #define FILE_ERR_REMOVE           -26 // FILE_Remove() failed
+#define FILE_ERR_NO_HANDLE        -27 // FILE_ReadOpenH() failed, all handles are in use
+#define FILE_ERR_INVALID_HANDLE   -28 // invalid handle passed to FILE_Read*H() function
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -102,6 +113,18 @@ extern s32 FILE_ReadByte(u8 *byte);
 extern s32 FILE_ReadHWord(u16 *hword);
 extern s32 FILE_ReadWord(u32 *word);
 
+extern s32 FILE_ReadOpenH(char *filepath);
+extern s32 FILE_ReadCloseH(s32 handle);
+extern s32 FILE_ReadSeekH(s32 handle, u32 offset);
+extern u32 FILE_ReadGetCurrentSizeH(s32 handle);
+extern u32 FILE_ReadGetCurrentPositionH(s32 handle);
+extern s32 FILE_ReadBufferH(s32 handle, u8 *buffer, u32 len);
+extern s32 FILE_ReadBufferUnknownLenH(s32 handle, u8 *buffer, u32 len);
+extern s32 FILE_ReadLineH(s32 handle, u8 *buffer, u32 max_len);
+extern s32 FILE_ReadByteH(s32 handle, u8 *byte);
+extern s32 FILE_ReadHWordH(s32 handle, u16 *hword);
+extern s32 FILE_ReadWordH(s32 handle, u32 *word);
+
 extern s32 FILE_WriteOpen(char *filepath, u8 create);
 extern s32 FILE_WriteClose(void);
 extern s32 FILE_WriteSeek(u32 offset);
@@ -0,0 +1,432 @@
+// $Id$
+/*
+ * Host test of the binary download of FILE_BrowserHandler ("readbin")
+ *
+ * file.c is compiled against the mios32.h replacement of this directory.
+ * It's included by this file, so that a volume can be simulated without an
+ * SD Card: the FatFs read functions access a file in RAM, and keep the
+ * sector of the file pointer in fil->buf like FatFs does.
+ *
+ * The USB MIDI packages sent by the firmware are assembled to SysEx
+ * streams, and decoded with the functions of MIOS Studio
+ * (tools/mios_studio/src/gui/MiosFileBrowserBin.h) in the same way like
+ * MiosFileBrowser::receiveBinaryBlock() does. The acknowledges are sent
+ * back to FILE_BrowserHandler() after it returned, like they would be
+ * received by the terminal task of an application.
+ *
+ * Files of different sizes are downloaded, and the received data has to
+ * match the file content. In a second pass one block of each file is
+ * corrupted, so that the retransmission after "readbinnak" is checked.
+ *
+ * Usage: file_bin_test [-v]
+ *   -v: print the debug messages of file.c and the transfer statistics
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <mios32.h>
+
+#include "../file.c"
+
+#include "MiosFileBrowserBin.h"
+
+
+static int verbose;
+
+#define TEST_FILE_NAME "/test.bin"
+#define TEST_FILE_MAX_SIZE 20000
+
+static u8 test_file[TEST_FILE_MAX_SIZE];
+static u32 test_file_size;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// FatFs stand-in: one file in RAM
+/////////////////////////////////////////////////////////////////////////////
+
+// FatFs keeps the sector of the file pointer in fil->buf if it isn't located at a sector boundary
+static void test_file_load_sector(FIL *fil)
+{
+  if( fil->fptr % _MAX_SS ) {
+    u32 sector_pos = fil->fptr - (fil->fptr % _MAX_SS);
+    u32 len = test_file_size - sector_pos;
+    if( len > _MAX_SS )
+      len = _MAX_SS;
+    memset(fil->buf, 0xee, _MAX_SS);
+    memcpy(fil->buf, &test_file[sector_pos], len);
+  }
+}
+
+FRESULT f_open(FIL *fil, const XCHAR *path, BYTE mode)
+{
+  if( strcmp((const char *)path, TEST_FILE_NAME) != 0 || !(mode & FA_READ) )
+    return FR_NO_FILE;
+
+  memset(fil, 0, sizeof(FIL));
+  fil->flag = FA_READ;
+  fil->fsize = test_file_size;
+  return FR_OK;
+}
+
+FRESULT f_read(FIL *fil, void *buffer, UINT len, UINT *successcount)
+{
+  u32 remaining = fil->fsize - fil->fptr;
+  if( len > remaining )
+    len = remaining;
+
+  memcpy(buffer, &test_file[fil->fptr], len);
+  fil->fptr += len;
+  test_file_load_sector(fil);
+
+  *successcount = len;
+  return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fil, DWORD offset)
+{
+  fil->fptr = (offset > fil->fsize) ? fil->fsize : offset;
+  test_file_load_sector(fil);
+  return FR_OK;
+}
+
+FRESULT f_close(FIL *fil) { return FR_OK; }
+FRESULT f_mount(BYTE drive, FATFS *fs) { return FR_NOT_READY; }
+FRESULT f_write(FIL *fil, const void *buffer, UINT len, UINT *successcount) { return FR_DENIED; }
+FRESULT f_opendir(DIR *dir, const XCHAR *path) { return FR_NO_PATH; }
+FRESULT f_readdir(DIR *dir, FILINFO *info) { return FR_NO_PATH; }
+FRESULT f_getfree(const XCHAR *path, DWORD *clusters, FATFS **fs) { return FR_NOT_READY; }
+FRESULT f_mkdir(const XCHAR *path) { return FR_DENIED; }
+FRESULT f_unlink(const XCHAR *path) { return FR_DENIED; }
+DRESULT disk_read(BYTE drive, BYTE *buffer, DWORD sector, BYTE count) { return RES_NOTRDY; }
+
+s32 MIOS32_SDCARD_Init(u32 mode) { return 0; }
+s32 MIOS32_SDCARD_CheckAvailable(u8 was_available) { return 1; }
+s32 MIOS32_SDCARD_CIDRead(mios32_sdcard_cid_t *cid) { return -1; }
+s32 MIOS32_SDCARD_CSDRead(mios32_sdcard_csd_t *csd) { return -1; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS Studio stand-in
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_SYSEX_LEN  8192
+#define MAX_COMMANDS   16
+#define MAX_COMMAND_LEN 40
+
+static u8 sysex[MAX_SYSEX_LEN];
+static u32 sysex_len;
+
+// commands for FILE_BrowserHandler() which are sent after it returned
+static char commands[MAX_COMMANDS][MAX_COMMAND_LEN];
+static int num_commands;
+
+static u8 read_data[TEST_FILE_MAX_SIZE];
+static u32 read_size;     // announced with the 'B' response
+static u32 read_received; // already received bytes
+static int read_size_received;
+static int read_nak_pending;
+static int read_errors;
+
+static int corrupt_block;  // number of the block which should be corrupted (-1: none)
+static int num_blocks;     // received blocks
+static int num_ignored;    // blocks which have been ignored after a NAK
+static int num_naks;
+
+static void STUDIO_SendCommand(const char *format, ...)
+{
+  if( num_commands >= MAX_COMMANDS ) {
+    printf("ERROR: too many commands\n");
+    ++read_errors;
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  vsnprintf(commands[num_commands++], MAX_COMMAND_LEN, format, args);
+  va_end(args);
+}
+
+// see MiosFileBrowser::receiveBinaryBlock()
+static void STUDIO_ReceiveBinaryBlock(u8 *data, u32 size)
+{
+  static u8 block[MAX_SYSEX_LEN];
+  u32 address = 0;
+
+  if( num_blocks++ == corrupt_block && size > (8+5+1) )
+    data[8+1] ^= 0x01; // first data byte (behind the MSBs) of the block
+
+  s32 block_size = miosFileBrowserUnpackBinBlock(data, size, &address, block);
+  if( block_size == -1 ) {
+    printf("ERROR: invalid payload at block #%d\n", num_blocks-1);
+    ++read_errors;
+    return;
+  }
+
+  // blocks which have been sent before a retry was requested are ignored
+  if( address != read_received ) {
+    ++num_ignored;
+    return;
+  }
+
+  if( block_size <= 0 || (address + block_size) > read_size ) {
+    if( !read_nak_pending ) {
+      read_nak_pending = 1;
+      ++num_naks;
+      STUDIO_SendCommand("readbinnak %08X", read_received);
+    }
+    return;
+  }
+
+  read_nak_pending = 0;
+  memcpy(&read_data[read_received], block, block_size);
+  read_received += block_size;
+
+  STUDIO_SendCommand("readbinack %08X", read_received);
+}
+
+// see MiosFileBrowser::handleIncomingMidiMessage()
+static void STUDIO_ReceiveSysEx(u8 *data, u32 size)
+{
+  static const u8 header[] = { 0xf0, 0x00, 0x00, 0x7e, 0x32, 0x00, MIOS32_MIDI_SYSEX_DEBUG, 0x41 };
+
+  if( size <= 9 || memcmp(data, header, sizeof(header)) != 0 || data[size-1] != 0xf7 ) {
+    printf("ERROR: unexpected SysEx message (%u bytes)\n", size);
+    ++read_errors;
+    return;
+  }
+
+  u32 message_offset = sizeof(header);
+  if( data[message_offset] == 'b' ) {
+    STUDIO_ReceiveBinaryBlock(data + message_offset + 1, size - message_offset - 2);
+  } else if( data[message_offset] == 'B' ) {
+    char str[20];
+    u32 len = size - message_offset - 2;
+    if( len >= sizeof(str) )
+      len = sizeof(str) - 1;
+    memcpy(str, &data[message_offset + 1], len);
+    str[len] = 0;
+    read_size = strtoul(str, NULL, 10);
+    read_size_received = 1;
+  } else {
+    printf("ERROR: unexpected response '%c'\n", data[message_offset]);
+    ++read_errors;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIDI output: the packages are assembled to SysEx streams
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  u8 len = (package.type == 0x5) ? 1 : ((package.type == 0x6) ? 2 : 3);
+
+  if( (sysex_len + len) > MAX_SYSEX_LEN ) {
+    printf("ERROR: SysEx stream too long\n");
+    exit(1);
+  }
+
+  sysex[sysex_len++] = package.evnt0;
+  if( len >= 2 )
+    sysex[sysex_len++] = package.evnt1;
+  if( len >= 3 )
+    sysex[sysex_len++] = package.evnt2;
+
+  if( package.type >= 0x5 ) { // SysEx ends
+    STUDIO_ReceiveSysEx(sysex, sysex_len);
+    sysex_len = 0;
+  }
+
+  return 0; // no error
+}
+
+// the debug string functions send the same packages like mios32/common/mios32_midi.c
+s32 MIOS32_MIDI_SendDebugStringHeader(mios32_midi_port_t port, char command, char first_byte)
+{
+  mios32_midi_package_t package;
+  package.ALL = 0;
+
+  package.type = 0x4;
+  package.evnt0 = 0xf0; package.evnt1 = 0x00; package.evnt2 = 0x00;
+  MIOS32_MIDI_SendPackage(port, package);
+  package.evnt0 = 0x7e; package.evnt1 = 0x32; package.evnt2 = 0x00; // device ID 0
+  MIOS32_MIDI_SendPackage(port, package);
+  package.evnt0 = MIOS32_MIDI_SYSEX_DEBUG; package.evnt1 = command; package.evnt2 = first_byte;
+  MIOS32_MIDI_SendPackage(port, package);
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringBody(mios32_midi_port_t port, char *str, u32 len)
+{
+  mios32_midi_package_t package;
+  package.ALL = 0;
+  package.type = 0x4;
+
+  // whole packages are sent, the string terminator fills the remaining bytes with zeroes
+  u32 i;
+  for(i=0; i<len; i+=3) {
+    u8 b;
+    u8 terminated = 0;
+
+    if( (b=str[i+0]) ) {
+      package.evnt0 = b & 0x7f;
+    } else {
+      package.evnt0 = 0x00;
+      terminated = 1;
+    }
+
+    if( !terminated && (b=str[i+1]) ) {
+      package.evnt1 = b & 0x7f;
+    } else {
+      package.evnt1 = 0x00;
+      terminated = 1;
+    }
+
+    if( !terminated && (b=str[i+2]) ) {
+      package.evnt2 = b & 0x7f;
+    } else {
+      package.evnt2 = 0x00;
+      terminated = 1;
+    }
+
+    MIOS32_MIDI_SendPackage(port, package);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugStringFooter(mios32_midi_port_t port)
+{
+  mios32_midi_package_t package;
+  package.ALL = 0;
+  package.type = 0x5;
+  package.evnt0 = 0xf7;
+  return MIOS32_MIDI_SendPackage(port, package);
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  if( verbose ) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+  }
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len) { return 0; }
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count) { return 0; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Downloads the test file, returns the number of errors
+/////////////////////////////////////////////////////////////////////////////
+static int download(u32 size, int corrupt)
+{
+  u32 i;
+
+  test_file_size = size;
+  for(i=0; i<size; ++i)
+    test_file[i] = (i < 256) ? i : rand(); // all byte values, then random data
+
+  memset(read_data, 0, sizeof(read_data));
+  read_size = 0;
+  read_received = 0;
+  read_size_received = 0;
+  read_nak_pending = 0;
+  read_errors = 0;
+  corrupt_block = corrupt ? 1 : -1;
+  num_blocks = 0;
+  num_ignored = 0;
+  num_naks = 0;
+  num_commands = 0;
+
+  char command[MAX_COMMAND_LEN];
+  strcpy(command, "readbin " TEST_FILE_NAME);
+  FILE_BrowserHandler(DEFAULT, command);
+
+  int num_calls;
+  for(num_calls=0; num_commands && num_calls<10000; ++num_calls) {
+    strcpy(command, commands[0]);
+    --num_commands;
+    memmove(commands[0], commands[1], num_commands * MAX_COMMAND_LEN);
+    FILE_BrowserHandler(DEFAULT, command);
+  }
+
+  if( !read_size_received ) {
+    printf("ERROR: file size hasn't been received\n");
+    ++read_errors;
+  } else if( read_size != size ) {
+    printf("ERROR: received file size %u, expected %u\n", read_size, size);
+    ++read_errors;
+  } else if( read_received != size ) {
+    printf("ERROR: received %u bytes, expected %u\n", read_received, size);
+    ++read_errors;
+  } else if( memcmp(read_data, test_file, size) != 0 ) {
+    printf("ERROR: received data doesn't match\n");
+    ++read_errors;
+  }
+
+  if( browser_read_handle >= 0 ) {
+    printf("ERROR: transfer hasn't been finished\n");
+    ++read_errors;
+  }
+
+  if( corrupt && size > FILE_BROWSER_BIN_BLOCK_SIZE && !num_naks ) {
+    printf("ERROR: corrupted block hasn't been requested again\n");
+    ++read_errors;
+  }
+
+  if( verbose || read_errors ) {
+    printf("%6u bytes%s: %d blocks, %d ignored, %d NAKs, %d errors\n",
+	   size, corrupt ? " (corrupted block)" : "", num_blocks, num_ignored, num_naks, read_errors);
+  }
+
+  return read_errors;
+}
+
+
+int main(int argc, char *argv[])
+{
+  static const u32 sizes[] = { 0, 1, 6, 7, 8, 511, 512, 513, 2047, 2048, 2049, 4096, 5000, TEST_FILE_MAX_SIZE };
+  int num_errors = 0;
+
+  if( argc > 1 && strcmp(argv[1], "-v") == 0 )
+    verbose = 1;
+
+  srand(1);
+
+  // volume is simulated by the FatFs stand-in
+  FILE_Init(0);
+  volume_available = 1;
+
+  int corrupt;
+  for(corrupt=0; corrupt<2; ++corrupt) {
+    int i;
+    for(i=0; i<sizeof(sizes)/sizeof(u32); ++i)
+      num_errors += download(sizes[i], corrupt);
+  }
+
+  if( num_errors ) {
+    printf("%d error(s) FAILED\n", num_errors);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,20 @@
+/* $Id$ */
+/*
+ * Replaces mios32.h for the host test of the file browser transfers.
+ * Only the data types and the MIDI/SD Card functions used by file.c are
+ * declared, they are implemented by file_bin_test.c
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mios32_datatypes.h>
+#include <mios32_midi.h>
+#include <mios32_sdcard.h>
+
+#endif /* _MIOS32_H */
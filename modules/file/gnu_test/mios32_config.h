@@ -0,0 +1,10 @@
+/* $Id$ */
+/*
+ * Local MIOS32 configuration file for the host test of the file browser
+ * transfers, it's included by ffconf.h
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+#endif /* _MIOS32_CONFIG_H */
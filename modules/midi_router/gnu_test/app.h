@@ -0,0 +1,9 @@
+/* $Id$ */
+/*
+ * Replaces app.h for the host test of the MIDI router.
+ */
+
+#ifndef _APP_H
+#define _APP_H
+
+#endif /* _APP_H */
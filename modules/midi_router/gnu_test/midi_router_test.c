@@ -0,0 +1,536 @@
+// $Id$
+/*
+ * Host test of the MIDI router
+ *
+ * midi_router.c is compiled against replacements of mios32.h, tasks.h,
+ * app.h and osc_client.h. The forwarded packages and SysEx streams are
+ * compared with the node walk which was used before the routes have been
+ * compiled into per-port tables (REF_MIDI_ROUTER_Receive() and
+ * REF_MIDI_ROUTER_ReceiveSysEx() below).
+ *
+ * The equivalence test uses random 16-node configurations with repeated
+ * destination ports, OSC->OSC nodes and ports without selection mask, and
+ * changes single nodes while events are received, like the UI does.
+ * The throughput test measures both variants with the same configuration
+ * and compares the MIDI OUT mutex acquisitions.
+ *
+ * Usage: midi_router_test [<number of packages for the throughput test>]
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <mios32.h>
+#include <osc_client.h>
+#include "tasks.h"
+#include "midi_router.h"
+#include "midi_port.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Output log
+/////////////////////////////////////////////////////////////////////////////
+#define MAX_LOG 64
+
+typedef struct {
+  u8 port;
+  u8 sysex;
+  u32 data; // package, or length of the SysEx stream
+  u32 hash; // checksum of the SysEx stream
+} out_event_t;
+
+typedef struct {
+  out_event_t event[MAX_LOG];
+  int num;
+  int overflow;
+} out_log_t;
+
+static out_log_t *out_log;
+static u32 num_sent;
+
+u32 mutex_midiout_takes;
+
+static void logEvent(u8 port, u8 sysex, u32 data, u32 hash)
+{
+  ++num_sent;
+  if( !out_log )
+    return;
+
+  if( out_log->num >= MAX_LOG ) {
+    out_log->overflow = 1;
+    return;
+  }
+
+  out_event_t *e = &out_log->event[out_log->num++];
+  e->port = port;
+  e->sysex = sysex;
+  e->data = data;
+  e->hash = hash;
+}
+
+static u32 streamHash(u8 *stream, u32 count)
+{
+  u32 hash = 2166136261u;
+  u32 i;
+  for(i=0; i<count; ++i)
+    hash = (hash ^ stream[i]) * 16777619u;
+  return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stubs of the MIOS32 and MIDI port layers
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  logEvent(port, 0, package.ALL, 0);
+  return 0;
+}
+
+s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
+{
+  logEvent(port, 1, count, streamHash(stream, count));
+  return 0;
+}
+
+s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count)
+{
+  logEvent(OSC0 + osc_port, 1, count, streamHash(stream, count));
+  return 0;
+}
+
+s32 MIOS32_MIDI_CheckAvailable(mios32_midi_port_t port) { return 1; }
+
+// DEFAULT, USB0..3, UART0..3, OSC0..3, SPIM0..1
+static const mios32_midi_port_t in_ports[MIDI_PORT_NUM_IN_PORTS] = {
+  DEFAULT, USB0, USB1, USB2, USB3, UART0, UART1, UART2, UART3, OSC0, OSC1, OSC2, OSC3, SPIM0, SPIM1
+};
+
+u8 MIDI_PORT_InIxGet(mios32_midi_port_t port)
+{
+  u8 ix;
+  for(ix=0; ix<MIDI_PORT_NUM_IN_PORTS; ++ix) {
+    if( in_ports[ix] == port )
+      return ix;
+  }
+  return 0;
+}
+
+s32 MIDI_PORT_InNumGet(void) { return MIDI_PORT_NUM_IN_PORTS; }
+s32 MIDI_PORT_OutNumGet(void) { return MIDI_PORT_NUM_IN_PORTS; }
+s32 MIDI_PORT_ClkNumGet(void) { return 0; }
+char *MIDI_PORT_InNameGet(u8 port_ix) { return "port"; }
+char *MIDI_PORT_OutNameGet(u8 port_ix) { return "port"; }
+char *MIDI_PORT_ClkNameGet(u8 port_ix) { return "port"; }
+mios32_midi_port_t MIDI_PORT_InPortGet(u8 port_ix) { return in_ports[port_ix]; }
+mios32_midi_port_t MIDI_PORT_OutPortGet(u8 port_ix) { return in_ports[port_ix]; }
+mios32_midi_port_t MIDI_PORT_ClkPortGet(u8 port_ix) { return USB0; }
+u8 MIDI_PORT_OutIxGet(mios32_midi_port_t port) { return MIDI_PORT_InIxGet(port); }
+s32 MIDI_PORT_ClkCheckAvailable(mios32_midi_port_t port) { return 1; }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Reference: the node walk which was used before the compiled routes
+/////////////////////////////////////////////////////////////////////////////
+#define REF_NUM_SYSEX_BUFFERS     (MIDI_PORT_NUM_IN_PORTS-1)
+
+static u8 ref_sysex_buffer[REF_NUM_SYSEX_BUFFERS][MIDI_ROUTER_SYSEX_BUFFER_SIZE];
+static u32 ref_sysex_buffer_len[REF_NUM_SYSEX_BUFFERS];
+
+static u32 REF_MIDI_ROUTER_PortMaskGet(mios32_midi_port_t port)
+{
+  u8 port_ix = port & 0xf;
+  if( port >= USB0 && port <= OSC7 && port_ix <= 7 ) {
+    return 1 << ((((port-USB0) & 0x30) >> 1) | port_ix);
+  }
+
+  return 0;
+}
+
+static s32 REF_MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_package)
+{
+  // filter SysEx which is handled by separate parser
+  if( midi_package.evnt0 < 0xf8 &&
+      (midi_package.cin == 0xf ||
+      (midi_package.cin >= 0x4 && midi_package.cin <= 0x7)) )
+    return 0; // no error
+
+  u32 sysex_dst_fwd_done = 0;
+  int node;
+  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
+
+      // forwarding OSC to OSC will very likely result into a stack overflow (or feedback loop) -> avoid this!
+      if( ((port & 0xf0) == OSC0) && ((n->dst_port & 0xf0) == OSC0) )
+	continue;
+
+      if( midi_package.event >= NoteOff && midi_package.event <= PitchBend ) {
+	if( n->src_chn == 17 || midi_package.chn == (n->src_chn-1) ) {
+	  mios32_midi_package_t fwd_package = midi_package;
+	  if( n->dst_chn <= 16 )
+	    fwd_package.chn = (n->dst_chn-1);
+	  mios32_midi_port_t port = n->dst_port;
+	  MUTEX_MIDIOUT_TAKE;
+	  MIOS32_MIDI_SendPackage(port, fwd_package);
+	  MUTEX_MIDIOUT_GIVE;
+	}
+      } else {
+	// Realtime events: ensure that they are only forwarded once
+	u32 mask = REF_MIDI_ROUTER_PortMaskGet(n->dst_port);
+	if( !mask || !(sysex_dst_fwd_done & mask) ) {
+	  sysex_dst_fwd_done |= mask;
+	  MUTEX_MIDIOUT_TAKE;
+	  MIOS32_MIDI_SendPackage(n->dst_port, midi_package);
+	  MUTEX_MIDIOUT_GIVE;
+	}
+      }
+    }
+  }
+
+  return 0; // no error
+}
+
+static s32 REF_MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
+{
+  // determine SysEx buffer
+  int sysex_in = MIDI_PORT_InIxGet(port);
+
+  if( sysex_in == 0 )
+    return -1; // not assigned
+
+  // because DEFAULT is not buffered
+  sysex_in -= 1;
+
+  // just to ensure...
+  if( sysex_in >= REF_NUM_SYSEX_BUFFERS )
+    return -2; // error in sysex assignments
+
+  u32 buffer_len = ref_sysex_buffer_len[sysex_in];
+  if( midi_in == 0xf7 || (midi_in == 0xf0 && buffer_len != 0) || buffer_len >= (MIDI_ROUTER_SYSEX_BUFFER_SIZE-1) ) {
+
+    if( midi_in == 0xf7 && buffer_len < MIDI_ROUTER_SYSEX_BUFFER_SIZE ) // note: we always have a free byte for F7
+      ref_sysex_buffer[sysex_in][ref_sysex_buffer_len[sysex_in]++] = midi_in;
+
+    u32 sysex_dst_fwd_done = 0;
+    int node;
+    midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
+    for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+      if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
+	// SysEx, only forwarded once per destination port
+	u32 mask = REF_MIDI_ROUTER_PortMaskGet(n->dst_port);
+	if( !mask || !(sysex_dst_fwd_done & mask) ) {
+	  sysex_dst_fwd_done |= mask;
+
+	  mios32_midi_port_t port = n->dst_port;
+	  MUTEX_MIDIOUT_TAKE;
+	  if( (port & 0xf0) == OSC0 )
+	    OSC_CLIENT_SendSysEx(port & 0x0f, ref_sysex_buffer[sysex_in], ref_sysex_buffer_len[sysex_in]);
+	  else
+	    MIOS32_MIDI_SendSysEx(port, ref_sysex_buffer[sysex_in], ref_sysex_buffer_len[sysex_in]);
+	  MUTEX_MIDIOUT_GIVE;
+	}
+      }
+    }
+
+    // empty buffer
+    ref_sysex_buffer_len[sysex_in] = 0;
+
+    // fill with next byte if buffer size hasn't been exceeded
+    if( midi_in != 0xf7 )
+      ref_sysex_buffer[sysex_in][ref_sysex_buffer_len[sysex_in]++] = midi_in;
+
+  } else {
+    // add to buffer
+    ref_sysex_buffer[sysex_in][ref_sysex_buffer_len[sysex_in]++] = midi_in;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Random configurations and events
+/////////////////////////////////////////////////////////////////////////////
+
+// IIC0 has no SysEx buffer, DEFAULT and SPIM0..1 have no selection mask
+static const mios32_midi_port_t test_ports[] = {
+  DEFAULT, USB0, USB1, UART0, UART1, IIC0, OSC0, OSC1, SPIM0, SPIM1
+};
+#define NUM_TEST_PORTS (sizeof(test_ports)/sizeof(mios32_midi_port_t))
+
+static u32 random_seed = 12345;
+
+static u32 randomValue(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return (random_seed >> 16) % range;
+}
+
+static u8 randomChannel(void)
+{
+  switch( randomValue(4) ) {
+  case 0: return 0;  // off
+  case 1: return 17; // all
+  }
+  return 1 + randomValue(16);
+}
+
+static void randomNode(int node)
+{
+  midi_router_node_entry_t *n = &midi_router_node[node];
+  n->src_port = test_ports[randomValue(NUM_TEST_PORTS)];
+  n->src_chn = randomChannel();
+  n->dst_port = test_ports[randomValue(NUM_TEST_PORTS)];
+  n->dst_chn = randomChannel();
+}
+
+static mios32_midi_package_t randomPackage(void)
+{
+  mios32_midi_package_t p;
+  p.ALL = 0;
+
+  switch( randomValue(8) ) {
+  case 0: // realtime
+    p.type = 0xf;
+    p.evnt0 = 0xf8 + randomValue(8);
+    break;
+  case 1: // MTC quarter frame
+    p.type = 0x2;
+    p.evnt0 = 0xf1;
+    p.evnt1 = randomValue(0x80);
+    break;
+  case 2: // SysEx package, handled by the SysEx parser
+    p.type = 0x4 + randomValue(4);
+    p.evnt0 = 0xf0;
+    p.evnt1 = randomValue(0x80);
+    p.evnt2 = randomValue(0x80);
+    break;
+  default: // channel event
+    p.type = 0x8 + randomValue(7);
+    p.evnt0 = (p.type << 4) | randomValue(16);
+    p.evnt1 = randomValue(0x80);
+    p.evnt2 = randomValue(0x80);
+  }
+
+  return p;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Equivalence test
+/////////////////////////////////////////////////////////////////////////////
+static out_log_t ref_log;
+static out_log_t new_log;
+static int num_errors;
+
+static int compareLogs(const char *what, mios32_midi_port_t port)
+{
+  if( ref_log.overflow || new_log.overflow ) {
+    printf("  ERROR: output log overflow\n");
+    return 1;
+  }
+
+  if( ref_log.num == new_log.num && memcmp(ref_log.event, new_log.event, ref_log.num * sizeof(out_event_t)) == 0 )
+    return 0;
+
+  if( num_errors < 10 ) {
+    int i;
+    printf("  ERROR: %s from port 0x%02x forwarded differently\n", what, port);
+    for(i=0; i<MIDI_ROUTER_NUM_NODES; ++i) {
+      midi_router_node_entry_t *n = &midi_router_node[i];
+      printf("    node %2d: 0x%02x chn %2d -> 0x%02x chn %2d\n", i+1, n->src_port, n->src_chn, n->dst_port, n->dst_chn);
+    }
+    for(i=0; i<ref_log.num; ++i)
+      printf("    expected: 0x%02x %s %08x\n", ref_log.event[i].port, ref_log.event[i].sysex ? "SysEx" : "", (unsigned)ref_log.event[i].data);
+    for(i=0; i<new_log.num; ++i)
+      printf("    got:      0x%02x %s %08x\n", new_log.event[i].port, new_log.event[i].sysex ? "SysEx" : "", (unsigned)new_log.event[i].data);
+  }
+  ++num_errors;
+  return 1;
+}
+
+static void receivePackage(mios32_midi_port_t port, mios32_midi_package_t p)
+{
+  ref_log.num = ref_log.overflow = 0;
+  out_log = &ref_log;
+  REF_MIDI_ROUTER_Receive(port, p);
+
+  new_log.num = new_log.overflow = 0;
+  out_log = &new_log;
+  MIDI_ROUTER_Receive(port, p);
+
+  out_log = NULL;
+  compareLogs("package", port);
+}
+
+static void receiveSysExByte(mios32_midi_port_t port, u8 b)
+{
+  ref_log.num = ref_log.overflow = 0;
+  out_log = &ref_log;
+  s32 ref_status = REF_MIDI_ROUTER_ReceiveSysEx(port, b);
+
+  new_log.num = new_log.overflow = 0;
+  out_log = &new_log;
+  s32 new_status = MIDI_ROUTER_ReceiveSysEx(port, b);
+
+  out_log = NULL;
+  if( ref_status != new_status ) {
+    printf("  ERROR: SysEx byte from port 0x%02x returned %d instead of %d\n", port, (int)new_status, (int)ref_status);
+    ++num_errors;
+  }
+  compareLogs("SysEx", port);
+}
+
+static void receiveSysExStream(mios32_midi_port_t port)
+{
+  // some streams exceed the buffer, so that they are forwarded in chunks
+  u32 len = randomValue(10) ? randomValue(40) : randomValue(2*MIDI_ROUTER_SYSEX_BUFFER_SIZE);
+  u32 i;
+
+  receiveSysExByte(port, 0xf0);
+  for(i=0; i<len; ++i)
+    receiveSysExByte(port, randomValue(0x80));
+  receiveSysExByte(port, 0xf7);
+}
+
+static int testEquivalence(void)
+{
+  int config, event, node;
+  u32 packages = 0, streams = 0;
+
+  num_errors = 0;
+  for(config=0; config<2000; ++config) {
+    for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node)
+      randomNode(node);
+
+    for(event=0; event<200; ++event) {
+      mios32_midi_port_t port = test_ports[randomValue(NUM_TEST_PORTS)];
+
+      if( randomValue(20) == 0 ) {
+	receiveSysExStream(port);
+	++streams;
+      } else {
+	receivePackage(port, randomPackage());
+	++packages;
+      }
+
+      // the nodes are changed while events are received
+      if( randomValue(50) == 0 )
+	randomNode(randomValue(MIDI_ROUTER_NUM_NODES));
+    }
+  }
+
+  printf("%-40s %u packages, %u SysEx streams: %s\n", "equivalence with the node walk", (unsigned)packages, (unsigned)streams, num_errors ? "FAILED" : "ok");
+  return num_errors ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Throughput test
+/////////////////////////////////////////////////////////////////////////////
+static mios32_midi_port_t *tp_ports;
+static mios32_midi_package_t *tp_packages;
+
+static double runThroughput(s32 (*receive)(mios32_midi_port_t port, mios32_midi_package_t midi_package), u32 num, u32 *sent, u32 *takes)
+{
+  u32 i;
+  clock_t start;
+
+  num_sent = 0;
+  mutex_midiout_takes = 0;
+  start = clock();
+  for(i=0; i<num; ++i)
+    receive(tp_ports[i], tp_packages[i]);
+  *sent = num_sent;
+  *takes = mutex_midiout_takes;
+
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int testThroughput(u32 num)
+{
+  // 16 nodes of a typical setup: each USB and UART input is forwarded to two outputs
+  static const midi_router_node_entry_t nodes[MIDI_ROUTER_NUM_NODES] = {
+    { USB0,  17, UART0, 17 }, { USB0,  17, UART1, 17 },
+    { USB1,   1, UART2, 17 }, { USB1,   2, UART3,  1 },
+    { USB2,  17, OSC0,  17 }, { USB2,  17, USB2,  17 },
+    { USB3,  10, UART0, 17 }, { USB3,  17, UART1, 17 },
+    { UART0, 17, USB0,  17 }, { UART0, 17, OSC0,  17 },
+    { UART1, 17, USB1,  17 }, { UART1,  5, USB1,   6 },
+    { UART2, 17, USB2,  17 }, { UART2, 17, SPIM0, 17 },
+    { UART3, 17, USB3,  17 }, { OSC0,  17, UART3, 17 },
+  };
+  static const mios32_midi_port_t ports[] = {
+    USB0, USB1, USB2, USB3, UART0, UART1, UART2, UART3, OSC0, SPIM0
+  };
+  u32 i;
+
+  memcpy(midi_router_node, nodes, sizeof(nodes));
+
+  tp_ports = (mios32_midi_port_t *)malloc(num * sizeof(mios32_midi_port_t));
+  tp_packages = (mios32_midi_package_t *)malloc(num * sizeof(mios32_midi_package_t));
+  for(i=0; i<num; ++i) {
+    tp_ports[i] = ports[randomValue(sizeof(ports)/sizeof(mios32_midi_port_t))];
+    tp_packages[i] = randomPackage();
+  }
+
+  u32 ref_sent, ref_takes, new_sent, new_takes;
+  double ref_time = runThroughput(REF_MIDI_ROUTER_Receive, num, &ref_sent, &ref_takes);
+  double new_time = runThroughput(MIDI_ROUTER_Receive, num, &new_sent, &new_takes);
+
+  free(tp_ports);
+  free(tp_packages);
+
+  printf("  node walk:      %6.1f ns/package, %.2f mutex takes/package\n", 1e9 * ref_time / num, (double)ref_takes / num);
+  printf("  compiled route: %6.1f ns/package, %.2f mutex takes/package\n", 1e9 * new_time / num, (double)new_takes / num);
+
+  int failed = 0;
+  if( new_sent != ref_sent ) {
+    printf("  ERROR: %u packages forwarded instead of %u\n", (unsigned)new_sent, (unsigned)ref_sent);
+    failed = 1;
+  }
+  if( new_takes > ref_takes ) {
+    printf("  ERROR: MIDI OUT mutex taken more often than by the node walk\n");
+    failed = 1;
+  }
+
+  printf("%-40s %u packages: %s\n", "throughput with 16 nodes", (unsigned)num, failed ? "FAILED" : "ok");
+  return failed;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int failed = 0;
+  u32 num_throughput = 1000000;
+
+  if( argc > 1 )
+    num_throughput = atoi(argv[1]);
+
+  MIDI_ROUTER_Init(0);
+
+  failed += testEquivalence();
+  failed += testThroughput(num_throughput);
+
+  if( failed ) {
+    printf("%d test(s) failed\n", failed);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
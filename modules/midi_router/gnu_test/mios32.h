@@ -0,0 +1,22 @@
+/* $Id$ */
+/*
+ * Replaces mios32.h for the host test of the MIDI router.
+ * Only the data types, the MIDI definitions and the port numbers used by
+ * midi_port.h are included.
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <mios32_datatypes.h>
+#include <mios32_midi.h>
+
+#define MIOS32_USB_MIDI_NUM_PORTS  4
+#define MIOS32_UART_NUM            4
+#define MIOS32_SPI_MIDI_NUM_PORTS  2
+
+#endif /* _MIOS32_H */
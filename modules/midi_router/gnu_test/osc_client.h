@@ -0,0 +1,11 @@
+/* $Id$ */
+/*
+ * Replaces osc_client.h for the host test of the MIDI router.
+ */
+
+#ifndef _OSC_CLIENT_H
+#define _OSC_CLIENT_H
+
+extern s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count);
+
+#endif /* _OSC_CLIENT_H */
@@ -0,0 +1,15 @@
+/* $Id$ */
+/*
+ * Replaces tasks.h for the host test of the MIDI router.
+ * The MIDI OUT mutex only counts how often it has been taken.
+ */
+
+#ifndef _TASKS_H
+#define _TASKS_H
+
+extern u32 mutex_midiout_takes;
+
+#define MUTEX_MIDIOUT_TAKE { ++mutex_midiout_takes; }
+#define MUTEX_MIDIOUT_GIVE { }
+
+#endif /* _TASKS_H */
@@ -35,6 +35,24 @@
 // SysEx buffer for each input (exclusive Default)
 #define NUM_SYSEX_BUFFERS     (MIDI_PORT_NUM_IN_PORTS-1)
 
+// compiled routes are grouped by source port: USB0..7, UART0..7, IIC0..7, OSC0..7 and all others
+#define NUM_ROUTE_GROUPS      33
+
+
+/////////////////////////////////////////////////////////////////////////////
+// local types
+/////////////////////////////////////////////////////////////////////////////
+
+// a router node, prepared for the forwarding functions
+typedef struct {
+  u16 chn_mask;    // channel events: bit n set: forward channel n+1
+  u8  src_port;    // only checked for the last group (ports without index)
+  u8  dst_port;
+  u8  dst_chn;     // 0..15: change channel, 0xff: keep channel
+  u8  fwd_common;  // realtime/system common events: forwarded once per destination port
+  u8  fwd_sysex;   // SysEx streams: forwarded once per destination port
+} midi_router_route_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // global variables
@@ -69,6 +87,20 @@ u32 midi_router_mclk_out;
 static u8 sysex_buffer[NUM_SYSEX_BUFFERS][MIDI_ROUTER_SYSEX_BUFFER_SIZE];
 static u32 sysex_buffer_len[NUM_SYSEX_BUFFERS];
 
+// compiled node table
+// the nodes are changed directly by the applications (UI, configuration files),
+// therefore route_nodes[] keeps a copy of the compiled state to notice changes
+static midi_router_node_entry_t route_nodes[MIDI_ROUTER_NUM_NODES];
+static midi_router_route_t route[MIDI_ROUTER_NUM_NODES];
+static u16 route_first[NUM_ROUTE_GROUPS+1]; // routes of group g: route_first[g]..route_first[g+1]-1
+
+
+/////////////////////////////////////////////////////////////////////////////
+// local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 MIDI_ROUTER_RoutesCompile(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // This function initializes the MIDI router
@@ -88,21 +120,126 @@ s32 MIDI_ROUTER_Init(u32 mode)
   for(i=0; i<NUM_SYSEX_BUFFERS; ++i)
     sysex_buffer_len[i] = 0;
 
+  // compile the initial node table
+  MIDI_ROUTER_RoutesCompile();
+
   return 0; // no error
 }
 
 
 /////////////////////////////////////////////////////////////////////////////
-// Returns 32bit selection mask for USB0..7, UART0..7, IIC0..7, OSC0..7
+// Returns index 0..31 for USB0..7, UART0..7, IIC0..7, OSC0..7
+// Returns 32 for all other ports
 /////////////////////////////////////////////////////////////////////////////
-static inline u32 MIDI_ROUTER_PortMaskGet(mios32_midi_port_t port)
+static inline u8 MIDI_ROUTER_PortIxGet(mios32_midi_port_t port)
 {
   u8 port_ix = port & 0xf;
   if( port >= USB0 && port <= OSC7 && port_ix <= 7 ) {
-    return 1 << ((((port-USB0) & 0x30) >> 1) | port_ix);
+    return (((port-USB0) & 0x30) >> 1) | port_ix;
   }
 
-  return 0;
+  return 32;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 32bit selection mask for USB0..7, UART0..7, IIC0..7, OSC0..7
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 MIDI_ROUTER_PortMaskGet(mios32_midi_port_t port)
+{
+  u8 port_ix = MIDI_ROUTER_PortIxGet(port);
+  return (port_ix < 32) ? (1 << port_ix) : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiles the router nodes into routes which are grouped by source port
+// Channel masks, channel remapping and the "forward once per destination port"
+// checks for realtime and SysEx events are evaluated here, so that
+// MIDI_ROUTER_Receive() and MIDI_ROUTER_ReceiveSysEx() only have to walk over
+// the routes of the source port.
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIDI_ROUTER_RoutesCompile(void)
+{
+  u16 num_routes[NUM_ROUTE_GROUPS];
+  int group;
+  for(group=0; group<NUM_ROUTE_GROUPS; ++group)
+    num_routes[group] = 0;
+
+  memcpy(route_nodes, midi_router_node, sizeof(route_nodes));
+
+  // count the routes of each group
+  int node;
+  midi_router_node_entry_t *n = &route_nodes[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    if( n->src_chn && n->dst_chn )
+      ++num_routes[MIDI_ROUTER_PortIxGet(n->src_port)];
+  }
+
+  u16 ix = 0;
+  for(group=0; group<NUM_ROUTE_GROUPS; ++group) {
+    route_first[group] = ix;
+    ix += num_routes[group];
+    num_routes[group] = 0;
+  }
+  route_first[NUM_ROUTE_GROUPS] = ix;
+
+  // fill the groups, the order of the nodes is kept
+  n = &route_nodes[0];
+  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
+    if( n->src_chn && n->dst_chn ) {
+      group = MIDI_ROUTER_PortIxGet(n->src_port);
+      midi_router_route_t *r = &route[route_first[group] + num_routes[group]++];
+
+      r->src_port = n->src_port;
+      r->dst_port = n->dst_port;
+      r->dst_chn = (n->dst_chn <= 16) ? (n->dst_chn-1) : 0xff;
+
+      // forwarding OSC to OSC will very likely result into a stack overflow (or feedback loop) -> avoid this!
+      // (this only applies to MIDI events, SysEx is forwarded)
+      u8 osc_to_osc = ((n->src_port & 0xf0) == OSC0) && ((n->dst_port & 0xf0) == OSC0);
+
+      if( osc_to_osc )
+	r->chn_mask = 0x0000;
+      else if( n->src_chn == 17 )
+	r->chn_mask = 0xffff;
+      else if( n->src_chn <= 16 )
+	r->chn_mask = 1 << (n->src_chn-1);
+      else
+	r->chn_mask = 0x0000;
+
+      // realtime events and SysEx: ensure that they are only forwarded once
+      // (ports without selection mask are not filtered)
+      r->fwd_common = !osc_to_osc;
+      r->fwd_sysex = 1;
+      u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
+      if( mask ) {
+	midi_router_route_t *prev = &route[route_first[group]];
+	for(; prev != r; ++prev) {
+	  if( prev->src_port == r->src_port && prev->dst_port == r->dst_port ) {
+	    if( prev->fwd_common )
+	      r->fwd_common = 0;
+	    r->fwd_sysex = 0;
+	  }
+	}
+      }
+    }
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiles the routes again if the router nodes have been changed
+/////////////////////////////////////////////////////////////////////////////
+static inline void MIDI_ROUTER_RoutesUpdate(void)
+{
+  if( memcmp(route_nodes, midi_router_node, sizeof(route_nodes)) != 0 ) {
+    MUTEX_MIDIOUT_TAKE;
+    MIDI_ROUTER_RoutesCompile();
+    MUTEX_MIDIOUT_GIVE;
+  }
 }
 
 
@@ -117,38 +254,34 @@ s32 MIDI_ROUTER_Receive(mios32_midi_port_t port, mios32_midi_package_t midi_pack
       (midi_package.cin >= 0x4 && midi_package.cin <= 0x7)) )
     return 0; // no error
 
-  u32 sysex_dst_fwd_done = 0;
-  int node;
-  midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
-  for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
-    if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
-
-      // forwarding OSC to OSC will very likely result into a stack overflow (or feedback loop) -> avoid this!
-      if( ((port & 0xf0) == OSC0) && ((n->dst_port & 0xf0) == OSC0) )
-	continue;
-
-      if( midi_package.event >= NoteOff && midi_package.event <= PitchBend ) {
-	if( n->src_chn == 17 || midi_package.chn == (n->src_chn-1) ) {
-	  mios32_midi_package_t fwd_package = midi_package;
-	  if( n->dst_chn <= 16 )
-	    fwd_package.chn = (n->dst_chn-1);
-	  mios32_midi_port_t port = n->dst_port;
-	  MUTEX_MIDIOUT_TAKE;
-	  MIOS32_MIDI_SendPackage(port, fwd_package);
-	  MUTEX_MIDIOUT_GIVE;
-	}
-      } else {
-	// Realtime events: ensure that they are only forwarded once
-	u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
-	if( !mask || !(sysex_dst_fwd_done & mask) ) {
-	  sysex_dst_fwd_done |= mask;
-	  MUTEX_MIDIOUT_TAKE;
-	  MIOS32_MIDI_SendPackage(n->dst_port, midi_package);
-	  MUTEX_MIDIOUT_GIVE;
-	}
+  MIDI_ROUTER_RoutesUpdate();
+
+  u8 group = MIDI_ROUTER_PortIxGet(port);
+  if( route_first[group] == route_first[group+1] )
+    return 0; // no route for this port
+
+  MUTEX_MIDIOUT_TAKE;
+  midi_router_route_t *r = &route[route_first[group]];
+  midi_router_route_t *r_end = &route[route_first[group+1]];
+  if( midi_package.event >= NoteOff && midi_package.event <= PitchBend ) {
+    u16 chn_mask = 1 << midi_package.chn;
+    for(; r != r_end; ++r) {
+      if( (r->chn_mask & chn_mask) && (group < 32 || r->src_port == port) ) {
+	mios32_midi_package_t fwd_package = midi_package;
+	if( r->dst_chn != 0xff )
+	  fwd_package.chn = r->dst_chn;
+	MIOS32_MIDI_SendPackage(r->dst_port, fwd_package);
+      }
+    }
+  } else {
+    // Realtime events: only forwarded once per destination port
+    for(; r != r_end; ++r) {
+      if( r->fwd_common && (group < 32 || r->src_port == port) ) {
+	MIOS32_MIDI_SendPackage(r->dst_port, midi_package);
       }
     }
   }
+  MUTEX_MIDIOUT_GIVE;
 
   return 0; // no error
 }
@@ -182,25 +315,24 @@ s32 MIDI_ROUTER_ReceiveSysEx(mios32_midi_port_t port, u8 midi_in)
     if( midi_in == 0xf7 && buffer_len < MIDI_ROUTER_SYSEX_BUFFER_SIZE ) // note: we always have a free byte for F7
       sysex_buffer[sysex_in][sysex_buffer_len[sysex_in]++] = midi_in;
 
-    u32 sysex_dst_fwd_done = 0;
-    int node;
-    midi_router_node_entry_t *n = (midi_router_node_entry_t *)&midi_router_node[0];
-    for(node=0; node<MIDI_ROUTER_NUM_NODES; ++node, ++n) {
-      if( n->src_chn && n->dst_chn && (n->src_port == port) ) {
-	// SysEx, only forwarded once per destination port
-	u32 mask = MIDI_ROUTER_PortMaskGet(n->dst_port);
-	if( !mask || !(sysex_dst_fwd_done & mask) ) {
-	  sysex_dst_fwd_done |= mask;
+    MIDI_ROUTER_RoutesUpdate();
 
-	  mios32_midi_port_t port = n->dst_port;
-	  MUTEX_MIDIOUT_TAKE;
+    u8 group = MIDI_ROUTER_PortIxGet(port);
+    if( route_first[group] != route_first[group+1] ) {
+      MUTEX_MIDIOUT_TAKE;
+      midi_router_route_t *r = &route[route_first[group]];
+      midi_router_route_t *r_end = &route[route_first[group+1]];
+      for(; r != r_end; ++r) {
+	// SysEx, only forwarded once per destination port
+	if( r->fwd_sysex && (group < 32 || r->src_port == port) ) {
+	  mios32_midi_port_t port = r->dst_port;
 	  if( (port & 0xf0) == OSC0 )
 	    OSC_CLIENT_SendSysEx(port & 0x0f, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
 	  else
 	    MIOS32_MIDI_SendSysEx(port, sysex_buffer[sysex_in], sysex_buffer_len[sysex_in]);
-	  MUTEX_MIDIOUT_GIVE;
 	}
       }
+      MUTEX_MIDIOUT_GIVE;
     }
 
     // empty buffer
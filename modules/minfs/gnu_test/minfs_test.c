@@ -1,9 +1,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+// the access counts are only checked with the default cache configuration,
+// with MINFS_RAM_CACHE_NUM_BLOCKS or MINFS_FREE_MAP_NUM_BLOCKS set in CFLAGS
+// they are only printed (minfs.h defines the default of the latter)
+#if !defined(MINFS_RAM_CACHE_NUM_BLOCKS) && !defined(MINFS_FREE_MAP_NUM_BLOCKS)
+#define CHECK_ACCESS_COUNT 1
+#endif
+
 #include "../minfs.h"
 
 #define DATA_LEN 255
+#define APPEND_LEN 16
+#define APPEND_NUM 40
+#define EXTEND_LEN 200
  
 static MINFS_file_t f;
 char data[DATA_LEN];
@@ -11,6 +22,45 @@ static int32_t status;
 
 static MINFS_fs_t fs;
 
+#ifdef CHECK_ACCESS_COUNT
+// expected cache hits and device block accesses of each measured operation
+// with the default cache configuration of minfs_ram.c (4 buffers, free bitmap)
+typedef struct{
+  const char *op;
+  uint32_t num_hits;
+  uint32_t num_reads;
+  uint32_t num_writes;
+} access_count_t;
+
+static const access_count_t expected_count[] = {
+  { "format/open",  2,  1, 0 },
+  { "open",         3,  1, 0 },
+  { "write",        6,  4, 3 },
+  { "open",         2,  2, 2 },
+  { "write",        6,  4, 4 },
+  { "open",         0,  2, 2 },
+  { "read",         5,  4, 1 },
+  { "open",         0,  2, 0 },
+  { "read",         5,  4, 0 },
+  { "open",         2,  2, 0 },
+  { "append",      96, 10, 9 },
+  { "read back",   69,  9, 3 },
+  { "extend",       2,  0, 0 },
+  { "append end",   1,  1, 0 },
+  { "truncate",     3,  0, 0 },
+  { "unlink",       2,  1, 0 },
+  { "flush",        0,  0, 4 },
+};
+#define NUM_EXPECTED_COUNT (sizeof(expected_count) / sizeof(access_count_t))
+
+static uint32_t access_count_i;
+#endif
+static uint32_t access_count_errors;
+
+// provided by minfs_ram.c
+extern void MINFS_RAM_Init(void);
+extern int32_t MINFS_RAM_Flush(MINFS_fs_t *p_fs);
+extern void MINFS_RAM_GetAccessCount(uint32_t *p_num_hits, uint32_t *p_num_reads, uint32_t *p_num_writes);
 
 
 // ------- local prototypes -------
@@ -18,11 +68,17 @@ static uint32_t fs_init(void);
 static uint32_t file_open(uint16_t file_i);
 static uint32_t file_write(void);
 static uint32_t file_read(void);
+static uint32_t file_append(void);
+static void check_access_count(const char *op);
+static void check_data(const char *expected);
 
 
 // ------- main -------
 int main(void){
-  strcpy(data, "MINFS is a minimal filesystem.\nIt features numbered files, PEC, Block caching interface,\nsupport for random data r/w form or to the storage unit (in this case without PEC).");
+  static const char text1[] = "MINFS is a minimal filesystem.\nIt features numbered files, PEC, Block caching interface,\nsupport for random data r/w form or to the storage unit (in this case without PEC).";
+  static const char text2[] = "Block size and the number of blocks are configurable at format time\nand will be stored in the fs-header at the beginning of the first block.\nMaximal number of files is limited by the number of blocks.";
+
+  strcpy(data, text1);
   
   fs_init();
 
@@ -30,7 +86,7 @@ int main(void){
   
   file_write();
 
-  strcpy(data, "Block size and the number of blocks are configurable at format time\nand will be stored in the fs-header at the beginning of the first block.\nMaximal number of files is limited by the number of blocks.");
+  strcpy(data, text2);
 
   file_open(2);
 
@@ -39,12 +95,25 @@ int main(void){
   file_open(1);
   
   file_read();
+  check_data(text1);
 
   file_open(2);
 
   file_read();
+  check_data(text2);
+
+  file_append();
 
+  if( status = MINFS_RAM_Flush(&fs) ){
+    printf("Error on flush: %d\n", status);
+    exit(1);
+  }
+  check_access_count("flush");
 
+  if( access_count_errors ){
+    printf("%u access count(s) differ from the expected values!\n", access_count_errors);
+    exit(1);
+  }
   exit(0);
 }
 
@@ -54,7 +123,7 @@ static uint32_t fs_init(void){
   MINFS_RAM_Init();
   // format file-system
   fs.info.block_size = 6;
-  fs.info.num_blocks = 64;
+  fs.info.num_blocks = 32;
   fs.info.flags = MINFS_FLAGS_NOPEC;
   fs.info.os_flags = 0;
   fs.fs_id = 1;
@@ -68,6 +137,7 @@ static uint32_t fs_init(void){
     exit(0);
   }
   printf("FS formated and opened!\n");
+  check_access_count("format/open");
   return 0;
 }
 
@@ -78,6 +148,7 @@ static uint32_t file_open(uint16_t file_i){
     exit(0);
   }
   printf("file openened: %d!\n", file_i);
+  check_access_count("open");
   return 0;
 }
 
@@ -87,6 +158,7 @@ static uint32_t file_write(void){
     exit(0);
   }
   printf("Write to file :%d!\n", f.file_id);
+  check_access_count("write");
   return 0;
 }
 
@@ -101,6 +173,121 @@ static uint32_t file_read(void){
     exit(0);
   }
   printf("Read from file %d!\n", f.file_id);
+  check_access_count("read");
   printf("\n%s\n\n", data);
   return 0;
 }
+
+static uint32_t file_append(void){
+  char chunk[APPEND_LEN];
+  uint32_t i, j, len, end_pos;
+  file_open(3);
+  // append small chunks, seek to the end before each write
+  for(i = 0; i < APPEND_NUM; i++){
+    if( (status = MINFS_FileSeek(&f, f.info.size, NULL)) && status != MINFS_STATUS_EOF ){
+      printf("Error on file-seek: %d\n", status);
+      exit(1);
+    }
+    memset(chunk, 'a' + i % 26, APPEND_LEN);
+    if( (status = MINFS_FileWrite(&f, chunk, APPEND_LEN, NULL)) && status != MINFS_STATUS_EOF ){
+      printf("Error on file append: %d\n", status);
+      exit(1);
+    }
+  }
+  printf("Appended %d x %d bytes to file %d!\n", APPEND_NUM, APPEND_LEN, f.file_id);
+  check_access_count("append");
+  // read back each chunk, starting with the last one
+  for(i = APPEND_NUM; i-- > 0; ){
+    if( status = MINFS_FileSeek(&f, i * APPEND_LEN, NULL) ){
+      printf("Error on file-seek: %d\n", status);
+      exit(1);
+    }
+    len = APPEND_LEN;
+    if( (status = MINFS_FileRead(&f, chunk, &len, NULL)) && status != MINFS_STATUS_EOF ){
+      printf("Error on file-read: %d\n", status);
+      exit(1);
+    }
+    for(j = 0; j < APPEND_LEN; j++){
+      if( chunk[j] != 'a' + i % 26 ){
+        printf("Bad data in file %d at %d!\n", f.file_id, i * APPEND_LEN + j);
+        exit(1);
+      }
+    }
+  }
+  printf("Read back file %d!\n", f.file_id);
+  check_access_count("read back");
+  // the current position is in the first block now, extend the file by
+  // a few blocks and append a chunk at its end (the last block is known
+  // without a chain walk)
+  if( status = MINFS_FileSetSize(&f, f.info.size + EXTEND_LEN, NULL) ){
+    printf("Error on file extend: %d\n", status);
+    exit(1);
+  }
+  check_access_count("extend");
+  if( status = MINFS_FileSeek(&f, 0, NULL) ){
+    printf("Error on file-seek: %d\n", status);
+    exit(1);
+  }
+  if( (status = MINFS_FileSeek(&f, f.info.size, NULL)) && status != MINFS_STATUS_EOF ){
+    printf("Error on file-seek: %d\n", status);
+    exit(1);
+  }
+  end_pos = f.info.size;
+  memset(chunk, 'z', APPEND_LEN);
+  if( (status = MINFS_FileWrite(&f, chunk, APPEND_LEN, NULL)) && status != MINFS_STATUS_EOF ){
+    printf("Error on file append: %d\n", status);
+    exit(1);
+  }
+  check_access_count("append end");
+  if( status = MINFS_FileSeek(&f, end_pos, NULL) ){
+    printf("Error on file-seek: %d\n", status);
+    exit(1);
+  }
+  len = APPEND_LEN;
+  if( ((status = MINFS_FileRead(&f, chunk, &len, NULL)) && status != MINFS_STATUS_EOF) || len != APPEND_LEN ){
+    printf("Error on file-read: %d\n", status);
+    exit(1);
+  }
+  for(j = 0; j < APPEND_LEN; j++){
+    if( chunk[j] != 'z' ){
+      printf("Bad data in file %d at %d!\n", f.file_id, end_pos + j);
+      exit(1);
+    }
+  }
+  // truncate the file, and free it
+  if( status = MINFS_FileSetSize(&f, APPEND_LEN, NULL) ){
+    printf("Error on file truncate: %d\n", status);
+    exit(1);
+  }
+  check_access_count("truncate");
+  if( status = MINFS_FileUnlink(&fs, f.file_id, 1, NULL) ){
+    printf("Error on file unlink: %d\n", status);
+    exit(1);
+  }
+  check_access_count("unlink");
+  return 0;
+}
+
+static void check_access_count(const char *op){
+  uint32_t num_hits, num_reads, num_writes;
+  MINFS_RAM_GetAccessCount(&num_hits, &num_reads, &num_writes);
+  printf("  %-12s cache hits: %3u, device block reads: %3u, writes: %3u\n", op, num_hits, num_reads, num_writes);
+#ifdef CHECK_ACCESS_COUNT
+  if( access_count_i >= NUM_EXPECTED_COUNT || strcmp(expected_count[access_count_i].op, op) ){
+    printf("Unexpected operation %s!\n", op);
+    exit(1);
+  }
+  const access_count_t *p_exp = &expected_count[access_count_i++];
+  if( num_hits != p_exp->num_hits || num_reads != p_exp->num_reads || num_writes != p_exp->num_writes ){
+    printf("  %-12s expected:   %3u,                     %3u,         %3u\n", "", p_exp->num_hits, p_exp->num_reads, p_exp->num_writes);
+    access_count_errors++;
+  }
+#endif
+}
+
+static void check_data(const char *expected){
+  if( strcmp(data, expected) ){
+    printf("Data of file %d differs from the written data!\n", f.file_id);
+    exit(1);
+  }
+}
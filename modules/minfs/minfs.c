@@ -58,11 +58,11 @@ static const uint32_t BECV = 1; // dummy value to check endianes
 #define LE_SET(p_dst, src, len){ \
   *( (uint8_t*)p_dst ) = (uint8_t)src; \
   if( len > 1 ) \
-    *( (uint8_t*)(p_dst + 1) ) |= (uint8_t)( src >> 8 ); \
+    *( (uint8_t*)(p_dst + 1) ) = (uint8_t)( src >> 8 ); \
   if( len > 2 ) \
-    *( (uint8_t*)(p_dst + 2) ) |= (uint8_t)( src >> 16 ); \
+    *( (uint8_t*)(p_dst + 2) ) = (uint8_t)( src >> 16 ); \
   if( len > 3 ) \
-    *( (uint8_t*)(p_dst + 3) ) |= (uint8_t)( src >> 24 ); \
+    *( (uint8_t*)(p_dst + 3) ) = (uint8_t)( src >> 24 ); \
 }
 
 // copies 1-4 bytes type-casted
@@ -104,6 +104,11 @@ static const uint32_t BECV = 1; // dummy value to check endianes
 #define MINFS_RW_MODE_READ 0
 #define MINFS_RW_MODE_WRITE 1
 
+// free-blocks bitmap access
+#define FREE_MAP_GET(p_fs, block_n) ( (p_fs)->free_map[(block_n) >> 5] & (1UL << ((block_n) & 31)) )
+#define FREE_MAP_SET(p_fs, block_n) ( (p_fs)->free_map[(block_n) >> 5] |= (1UL << ((block_n) & 31)) )
+#define FREE_MAP_CLR(p_fs, block_n) ( (p_fs)->free_map[(block_n) >> 5] &= ~(1UL << ((block_n) & 31)) )
+
 
 //------------------------------------------------------------------------------
 //------------------- Function Hooks to caching and device layer ---------------
@@ -203,9 +208,18 @@ static int32_t File_HeaderWrite(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t fil
 // Block chain layer
 static int32_t BlockChain_Seek(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t offset, MINFS_block_buf_t **pp_block_buf);
 static int32_t BlockChain_Link(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t block_target, MINFS_block_buf_t **pp_block_buf);
-static int32_t BlockChain_PopFree(MINFS_fs_t *p_fs, uint32_t num_blocks, MINFS_block_buf_t **pp_block_buf);
+static int32_t BlockChain_PopFree(MINFS_fs_t *p_fs, uint32_t num_blocks, uint32_t *p_end_block, MINFS_block_buf_t **pp_block_buf);
 static int32_t BlockChain_PushFree(MINFS_fs_t *p_fs, uint32_t start_block, MINFS_block_buf_t **pp_block_buf);
 
+// Free-blocks bitmap
+#if MINFS_FREE_MAP_NUM_BLOCKS
+static int32_t FreeMap_Build(MINFS_fs_t *p_fs, MINFS_block_buf_t **pp_block_buf);
+static int32_t FreeMap_Pop(MINFS_fs_t *p_fs, uint32_t num_blocks, uint32_t *p_end_block, MINFS_block_buf_t **pp_block_buf);
+static int32_t FreeMap_Push(MINFS_fs_t *p_fs, uint32_t start_block, MINFS_block_buf_t **pp_block_buf);
+static uint32_t FreeMap_Next(MINFS_fs_t *p_fs, uint32_t block_n);
+static uint32_t FreeMap_Prev(MINFS_fs_t *p_fs, uint32_t block_n);
+#endif
+
 // Buffer and RW layer
 static int32_t BlockBuffer_Get(MINFS_fs_t *p_fs, MINFS_block_buf_t **pp_block_buf, uint32_t block_n, uint32_t file_id, uint8_t populate);
 static int32_t BlockBuffer_Write(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf, uint16_t data_offset, uint16_t data_len);
@@ -279,6 +293,9 @@ int32_t MINFS_FlushBlockBuffer(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf)
 /////////////////////////////////////////////////////////////////////////////
 int32_t MINFS_Format(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf){
   int32_t status;
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  p_fs->free_map_valid = 0;
+#endif
   // calculate and validate fs-params
   if( status = CalcFSParams(p_fs) )
     return status;
@@ -330,6 +347,11 @@ int32_t MINFS_Format(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf){
   // write filesize 0 to file-index
   if( status = File_HeaderWrite(p_fs, p_fs->calc.first_datablock_n, 0, 0, &p_block_buf) )
     return status; // return error status
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  // build the free-blocks bitmap
+  if( status = FreeMap_Build(p_fs, &p_block_buf) )
+    return status; // return error status
+#endif
   // success
   return 0;
 }
@@ -348,6 +370,9 @@ int32_t MINFS_FSOpen(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf){
   // prepare fs-struct
   p_fs->info.block_size = 4; // minimal block size
   p_fs->info.flags = 0;
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  p_fs->free_map_valid = 0;
+#endif
   // get buffer
   if( status = BlockBuffer_Get(p_fs, &p_block_buf, 0, MINFS_FILE_NULL, 0) )
     return status; // return error status
@@ -367,6 +392,11 @@ int32_t MINFS_FSOpen(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf){
   // calculate and validate fs-params
   if( status = CalcFSParams(p_fs) )
     return status;
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  // build the free-blocks bitmap
+  if( status = FreeMap_Build(p_fs, &p_block_buf) )
+    return status; // return error status
+#endif
   // success
   return 0;
 }
@@ -871,7 +901,7 @@ static int32_t File_Touch(MINFS_file_t *p_file_0, uint32_t file_id, MINFS_block_
   if( status != MINFS_ERROR_FILE_NOT_EXISTS )
     return status; // return error status
   // file does not exists, pop a free block
-  if( (block_n = BlockChain_PopFree( p_file_0->p_fs, 1, pp_block_buf )) < 0 )
+  if( (block_n = BlockChain_PopFree( p_file_0->p_fs, 1, NULL, pp_block_buf )) < 0 )
     return block_n; // return error status
   // set file pointer to the free block
   if( status = File_SetFilePointer(p_file_0, file_id, block_n, pp_block_buf) )
@@ -920,6 +950,7 @@ static int32_t File_Open(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t file_id, M
   p_file->current_block_n = block_n;
   p_file->data_ptr_block_offset = sizeof(MINFS_file_header_t);
   p_file->first_block_n = block_n;
+  p_file->last_block_n = MINFS_BLOCK_NULL; // will be cached by File_Seek / File_SetSize
   p_file->p_fs = p_fs;
   // success
   return 0;
@@ -940,7 +971,7 @@ static int32_t File_Seek(MINFS_file_t *p_file, uint32_t pos, MINFS_block_buf_t *
   if( pos == p_file->data_ptr )
     return 0;
   int32_t ret_status = 0;
-  uint32_t seek_start_data_ptr;
+  uint32_t seek_start_block_i;
   uint32_t seek_start_block_n;
   // move forward ?
   if( pos > p_file->data_ptr ){
@@ -961,8 +992,9 @@ static int32_t File_Seek(MINFS_file_t *p_file, uint32_t pos, MINFS_block_buf_t *
       p_file->data_ptr = pos;
       return ret_status;
     } 
-    // seek from current position
-    seek_start_data_ptr = p_file->data_ptr;
+    // seek from current position (data_ptr_block_offset may be block_data_len,
+    // so the block index has to be calculated from the block start)
+    seek_start_block_i = (p_file->data_ptr + sizeof(MINFS_file_header_t) - p_file->data_ptr_block_offset) / p_file->p_fs->calc.block_data_len;
     seek_start_block_n = p_file->current_block_n;
   } else {
     // still in current buffer ?
@@ -972,18 +1004,29 @@ static int32_t File_Seek(MINFS_file_t *p_file, uint32_t pos, MINFS_block_buf_t *
       return ret_status;
     }
     // seek from start
-    seek_start_data_ptr = 0;
+    seek_start_block_i = 0;
     seek_start_block_n = p_file->first_block_n;
   }
-  // calculate block offset and seek
-  uint32_t block_n_offset = (pos + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len 
-      - ( seek_start_data_ptr + sizeof(MINFS_file_header_t)) /  p_file->p_fs->calc.block_data_len;
   int32_t status;
-  if( (status = BlockChain_Seek(p_file->p_fs, seek_start_block_n, block_n_offset, pp_block_buf)) < 0)
-    return status; // return error status
-  // if EOC, the file's block chain is broken
-  if( status == MINFS_BLOCK_EOC )
-    return MINFS_ERROR_FILE_CHAIN;
+  // will the last block of the file be reached?
+  uint8_t last_block = (pos + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len
+      == (p_file->info.size + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len;
+  if( last_block && p_file->last_block_n != MINFS_BLOCK_NULL ){
+    // last block is already known, no need to walk the block chain
+    status = p_file->last_block_n;
+  } else {
+    // calculate block offset and seek
+    uint32_t block_n_offset = (pos + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len 
+        - seek_start_block_i;
+    if( (status = BlockChain_Seek(p_file->p_fs, seek_start_block_n, block_n_offset, pp_block_buf)) < 0)
+      return status; // return error status
+    // if EOC, the file's block chain is broken
+    if( status == MINFS_BLOCK_EOC )
+      return MINFS_ERROR_FILE_CHAIN;
+    // remember the last block for further seeks / file extension
+    if( last_block )
+      p_file->last_block_n = status;
+  }
   // update *p_file fields
   p_file->current_block_n = status;
   p_file->data_ptr = pos;
@@ -1013,10 +1056,9 @@ static int32_t File_SetSize(MINFS_file_t *p_file, uint32_t new_size, MINFS_block
     if( (p_file->info.size - new_size) >= current_size_block_offset ){
       int32_t new_last_block_n;
       int32_t fbc_cont_block;
-      // find new last block
-      uint32_t new_num_blocks = ( new_size + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len
-        + ( ( new_size + sizeof(MINFS_file_header_t)) % p_file->p_fs->calc.block_data_len ) ? 1 : 0;
-      if( (new_last_block_n = BlockChain_Seek(p_file->p_fs, p_file->first_block_n, new_num_blocks - 1, pp_block_buf)) < 0 )
+      // find new last block (a file always owns the block of the byte following its end)
+      uint32_t new_last_block_i = ( new_size + sizeof(MINFS_file_header_t)) / p_file->p_fs->calc.block_data_len;
+      if( (new_last_block_n = BlockChain_Seek(p_file->p_fs, p_file->first_block_n, new_last_block_i, pp_block_buf)) < 0 )
         return new_last_block_n; // return error status
       // if EOC, the file's block chain is broken
       if( new_last_block_n == MINFS_BLOCK_EOC )
@@ -1034,6 +1076,7 @@ static int32_t File_SetSize(MINFS_file_t *p_file, uint32_t new_size, MINFS_block
       // push cut-off free blocks
       if( status = BlockChain_PushFree(p_file->p_fs, fbc_cont_block, pp_block_buf) )
         return status; // return error status
+      p_file->last_block_n = new_last_block_n;
       // set new current-block to new last block if data_ptr is beyond file size
       if( p_file->data_ptr > new_size )
 	p_file->current_block_n = new_last_block_n;
@@ -1042,17 +1085,15 @@ static int32_t File_SetSize(MINFS_file_t *p_file, uint32_t new_size, MINFS_block
     if( p_file->data_ptr > new_size ){
       p_file->data_ptr = new_size;
       p_file->data_ptr_block_offset = ( new_size + sizeof(MINFS_file_header_t)) % p_file->p_fs->calc.block_data_len;
-      // we are at the end of the file, if data_ptr_block_offset is 0, this means we'r at the end of the last block,
-      // the correct offset is block_data_len
-      if( p_file->data_ptr_block_offset == 0 )
-        p_file->data_ptr_block_offset = p_file->p_fs->calc.block_data_len;
     }
   }else{// extend file
     // add blocks ?
     if( (new_size - p_file->info.size + current_size_block_offset) >  p_file->p_fs->calc.block_data_len ){
-      // find last block of file
+      // find last block of file (if not already known)
       int32_t file_last_block_n;
-      if( (file_last_block_n = BlockChain_Seek(p_file->p_fs, p_file->current_block_n, MINFS_SEEK_END, pp_block_buf)) < 0 )
+      if( p_file->last_block_n != MINFS_BLOCK_NULL )
+        file_last_block_n = p_file->last_block_n;
+      else if( (file_last_block_n = BlockChain_Seek(p_file->p_fs, p_file->current_block_n, MINFS_SEEK_END, pp_block_buf)) < 0 )
         return file_last_block_n; // return error status
       // pop free blocks
       /*
@@ -1067,12 +1108,14 @@ static int32_t File_SetSize(MINFS_file_t *p_file, uint32_t new_size, MINFS_block
       uint32_t add_blocks_count = add_block_bytes_count / p_file->p_fs->calc.block_data_len + 1;
 
       int32_t add_blocks_first_n;
-      if( (add_blocks_first_n = BlockChain_PopFree(p_file->p_fs, add_blocks_count, pp_block_buf)) < 0)
+      uint32_t add_blocks_last_n;
+      if( (add_blocks_first_n = BlockChain_PopFree(p_file->p_fs, add_blocks_count, &add_blocks_last_n, pp_block_buf)) < 0)
         return add_blocks_first_n; // return error status
       // add free blocks to files block-chain
       int32_t status;
       if( status = BlockChain_Link(p_file->p_fs, file_last_block_n, add_blocks_first_n, pp_block_buf) )
         return status; // return error status
+      p_file->last_block_n = add_blocks_last_n;
     }
   }
   // finally, update file-header with new size
@@ -1190,12 +1233,18 @@ static int32_t File_HeaderWrite(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t fil
 //
 // IN:  <p_fs> Pointer to a populated fs-structure
 //      <num_blocks> Number of free blocks to pop
+//      <p_end_block> If not NULL, the last popped block number will be stored here
 //      <block_buf> Pointer to a MINFS_block_buf_t pointer
 // OUT: First block number, on error < 0 (MINFS_ERROR_XXXX or MINFS_STATUS_FULL)
 /////////////////////////////////////////////////////////////////////////////
-static int32_t BlockChain_PopFree(MINFS_fs_t *p_fs, uint32_t num_blocks, MINFS_block_buf_t **pp_block_buf){
+static int32_t BlockChain_PopFree(MINFS_fs_t *p_fs, uint32_t num_blocks, uint32_t *p_end_block, MINFS_block_buf_t **pp_block_buf){
   if( num_blocks == 0 )
     return MINFS_BLOCK_EOC; // return EOC-pointer
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  // no need to walk the free-blocks chain if the bitmap is available
+  if( p_fs->free_map_valid )
+    return FreeMap_Pop(p_fs, num_blocks, p_end_block, pp_block_buf);
+#endif
   // seek first block to pop off the fbc 
   // p_fs->info.num_blocks is the virtual start block of the fbc
   int32_t start_block;
@@ -1223,6 +1272,8 @@ static int32_t BlockChain_PopFree(MINFS_fs_t *p_fs, uint32_t num_blocks, MINFS_b
   // continue free blocks chain at entry after the last popped block
   if( status = BlockChain_Link(p_fs, p_fs->info.num_blocks, fbc_cont_block, pp_block_buf) )
     return status;
+  if( p_end_block != NULL )
+    *p_end_block = end_block;
   // success, return start block of poped blocks chain
   return start_block;  
 }
@@ -1240,6 +1291,11 @@ static int32_t BlockChain_PushFree(MINFS_fs_t *p_fs, uint32_t start_block, MINFS
   // check if start_block is a data-block
   if( start_block < p_fs->calc.first_datablock_n || start_block >= p_fs->info.num_blocks )
     return MINFS_ERROR_BLOCK_N;
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  // keep the free-blocks chain in ascending order if the bitmap is available
+  if( p_fs->free_map_valid )
+    return FreeMap_Push(p_fs, start_block, pp_block_buf);
+#endif
   // find last block of the chain
   uint32_t end_block;
   if( (end_block = BlockChain_Seek(p_fs, start_block, MINFS_SEEK_END, pp_block_buf)) < 0 )
@@ -1294,13 +1350,14 @@ static int32_t BlockChain_Seek(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t offs
     // check if EOC
     if( block_n == MINFS_BLOCK_EOC ){
       // if seek-end requested, return the last block number
-      if( offset = MINFS_SEEK_END )
+      if( offset == MINFS_SEEK_END )
         return last_block_n;
       // offset was not reached, return EOC
       return MINFS_BLOCK_EOC;
     }
-    // goto next element
-    offset--;
+    // goto next element (MINFS_SEEK_END: until EOC)
+    if( offset != MINFS_SEEK_END )
+      offset--;
   }
   // reached the block-offset
   return block_n;
@@ -1337,6 +1394,176 @@ static int32_t BlockChain_Link(MINFS_fs_t *p_fs, uint32_t block_n, uint32_t bloc
 }
 
 
+#if MINFS_FREE_MAP_NUM_BLOCKS
+/////////////////////////////////////////////////////////////////////////////
+// Builds the free-blocks bitmap by walking the free-blocks-chain once.
+// The bitmap is only used if the chain is in ascending block order (this is
+// how MINFS_Format creates it), because then the bitmap alone tells which
+// free block follows which. A chain in any other order will be re-linked.
+// If the file-system has more than MINFS_FREE_MAP_NUM_BLOCKS blocks, the
+// free-blocks-chain will be walked on allocation instead.
+// 
+// IN:  <p_fs> Pointer to a populated fs-structure
+//      <block_buf> Pointer to a MINFS_block_buf_t pointer
+// OUT: 0 on success, else < 0 (MINFS_ERROR_XXXX)
+/////////////////////////////////////////////////////////////////////////////
+static int32_t FreeMap_Build(MINFS_fs_t *p_fs, MINFS_block_buf_t **pp_block_buf){
+  p_fs->free_map_valid = 0;
+  // bitmap too small?
+  if( p_fs->info.num_blocks > MINFS_FREE_MAP_NUM_BLOCKS )
+    return 0;
+  memset(p_fs->free_map, 0, sizeof(p_fs->free_map));
+  p_fs->free_count = 0;
+  // walk the free-blocks-chain, starting at the virtual block <num_blocks>
+  int32_t block_n = p_fs->info.num_blocks;
+  uint32_t last_block_n = 0;
+  uint8_t sorted = 1;
+  while( (block_n = BlockChain_Seek(p_fs, block_n, 1, pp_block_buf)) != MINFS_BLOCK_EOC ){
+    if( block_n < 0 )
+      return block_n; // return error status
+    // the chain is broken if it leaves the data-blocks or contains a block twice
+    if( block_n <= p_fs->calc.first_datablock_n || block_n >= p_fs->info.num_blocks || FREE_MAP_GET(p_fs, block_n) )
+      return MINFS_ERROR_FILE_CHAIN;
+    FREE_MAP_SET(p_fs, block_n);
+    p_fs->free_count++;
+    if( block_n < last_block_n )
+      sorted = 0;
+    last_block_n = block_n;
+  }
+  // re-link the chain in ascending order
+  if( !sorted ){
+    int32_t status;
+    last_block_n = p_fs->info.num_blocks;
+    for( block_n = FreeMap_Next(p_fs, p_fs->calc.first_datablock_n); block_n != MINFS_BLOCK_EOC; block_n = FreeMap_Next(p_fs, block_n) ){
+      if( status = BlockChain_Link(p_fs, last_block_n, block_n, pp_block_buf) )
+        return status; // return error status
+      last_block_n = block_n;
+    }
+    if( status = BlockChain_Link(p_fs, last_block_n, MINFS_BLOCK_EOC, pp_block_buf) )
+      return status; // return error status
+  }
+  // success
+  p_fs->free_map_valid = 1;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Pops num_block from the free-block-chain by using the free-blocks bitmap.
+// The chain is in ascending order, so the first num_blocks free blocks are
+// already linked together, only the end of the popped chain and the start
+// of the free-blocks-chain have to be changed.
+// 
+// IN:  <p_fs> Pointer to a populated fs-structure
+//      <num_blocks> Number of free blocks to pop (> 0)
+//      <p_end_block> If not NULL, the last popped block number will be stored here
+//      <block_buf> Pointer to a MINFS_block_buf_t pointer
+// OUT: First block number, on error < 0 (MINFS_ERROR_XXXX or MINFS_STATUS_FULL)
+/////////////////////////////////////////////////////////////////////////////
+static int32_t FreeMap_Pop(MINFS_fs_t *p_fs, uint32_t num_blocks, uint32_t *p_end_block, MINFS_block_buf_t **pp_block_buf){
+  if( num_blocks > p_fs->free_count )
+    return MINFS_STATUS_FULL; // can't get the requested number of free blocks
+  // find first and last block to pop off the fbc
+  uint32_t start_block, end_block, fbc_cont_block, i;
+  start_block = end_block = FreeMap_Next(p_fs, p_fs->calc.first_datablock_n);
+  for(i = 1; i < num_blocks; i++)
+    end_block = FreeMap_Next(p_fs, end_block);
+  fbc_cont_block = FreeMap_Next(p_fs, end_block);
+  // set entry for last popped block to EOC
+  int32_t status;
+  if( status = BlockChain_Link(p_fs, end_block, MINFS_BLOCK_EOC, pp_block_buf) )
+    return status;
+  // continue free blocks chain at entry after the last popped block
+  if( status = BlockChain_Link(p_fs, p_fs->info.num_blocks, fbc_cont_block, pp_block_buf) )
+    return status;
+  // remove the popped blocks from the bitmap
+  for(i = start_block; i != fbc_cont_block; i = FreeMap_Next(p_fs, i))
+    FREE_MAP_CLR(p_fs, i);
+  p_fs->free_count -= num_blocks;
+  if( p_end_block != NULL )
+    *p_end_block = end_block;
+  // success, return start block of popped blocks chain
+  return start_block;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Adds a block-chain (start_block -> EOC) to the free-blocks-chain by using
+// the free-blocks bitmap. Each block will be inserted at its place in the
+// ascending free-blocks-chain.
+// 
+// IN:  <p_fs> Pointer to a populated fs-structure
+//      <start_block> Start-block of the chain
+//      <block_buf> Pointer to a MINFS_block_buf_t pointer
+// OUT: 0 on success, on error < 0 (MINFS_ERROR_XXXX)
+/////////////////////////////////////////////////////////////////////////////
+static int32_t FreeMap_Push(MINFS_fs_t *p_fs, uint32_t start_block, MINFS_block_buf_t **pp_block_buf){
+  int32_t block_n = start_block, next_block_n, status;
+  do{
+    // the chain is broken if it leaves the data-blocks or contains a free block
+    if( block_n <= p_fs->calc.first_datablock_n || block_n >= p_fs->info.num_blocks || FREE_MAP_GET(p_fs, block_n) )
+      return MINFS_ERROR_FILE_CHAIN;
+    // get the next block before the entry will be overwritten
+    if( (next_block_n = BlockChain_Seek(p_fs, block_n, 1, pp_block_buf)) < 0 )
+      return next_block_n; // return error status
+    FREE_MAP_SET(p_fs, block_n);
+    p_fs->free_count++;
+    // link previous free block (or virtual start block) to block_n, and block_n to the next free block
+    if( status = BlockChain_Link(p_fs, FreeMap_Prev(p_fs, block_n), block_n, pp_block_buf) )
+      return status;
+    if( status = BlockChain_Link(p_fs, block_n, FreeMap_Next(p_fs, block_n), pp_block_buf) )
+      return status;
+  } while( (block_n = next_block_n) != MINFS_BLOCK_EOC );
+  // success
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Finds the next free block after block_n in the free-blocks bitmap
+// 
+// IN:  <p_fs> Pointer to a populated fs-structure
+//      <block_n> Block number to start the search after
+// OUT: Next free block number, MINFS_BLOCK_EOC if there is none
+/////////////////////////////////////////////////////////////////////////////
+static uint32_t FreeMap_Next(MINFS_fs_t *p_fs, uint32_t block_n){
+  while( ++block_n < p_fs->info.num_blocks ){
+    // skip 32 blocks at once if none of them is free
+    if( !(block_n & 31) && !p_fs->free_map[block_n >> 5] ){
+      block_n += 31;
+      continue;
+    }
+    if( FREE_MAP_GET(p_fs, block_n) )
+      return block_n;
+  }
+  return MINFS_BLOCK_EOC;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Finds the previous free block before block_n in the free-blocks bitmap
+// 
+// IN:  <p_fs> Pointer to a populated fs-structure
+//      <block_n> Block number to start the search before
+// OUT: Previous free block number, <num_blocks> (virtual start block of the
+//      free-blocks-chain) if there is none
+/////////////////////////////////////////////////////////////////////////////
+static uint32_t FreeMap_Prev(MINFS_fs_t *p_fs, uint32_t block_n){
+  while( block_n > p_fs->calc.first_datablock_n + 1 ){
+    block_n--;
+    // skip 32 blocks at once if none of them is free
+    if( (block_n & 31) == 31 && !p_fs->free_map[block_n >> 5] ){
+      block_n -= 31;
+      continue;
+    }
+    if( FREE_MAP_GET(p_fs, block_n) )
+      return block_n;
+  }
+  return p_fs->info.num_blocks;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Returns a buffer. Will be called before any call to Read or Write, at least
 // one time for each block that should be read from / wrote to.
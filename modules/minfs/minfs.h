@@ -80,6 +80,13 @@
 #define MINFS_MODE_FFID_NEXT 0
 #define MINFS_MODE_FFID_FIRST 0
 
+// size of the in-RAM free-blocks bitmap in MINFS_fs_t (number of blocks).
+// File-systems with more blocks (or 0 to disable the bitmap) allocate blocks
+// by walking the free-blocks chain on the device.
+#ifndef MINFS_FREE_MAP_NUM_BLOCKS
+#define MINFS_FREE_MAP_NUM_BLOCKS 1024
+#endif
+
 
 
 
@@ -113,6 +120,11 @@ typedef struct{
   MINFS_fs_info_t info;
   uint8_t fs_id; // remember fs_id value (identifies the fs on OS level)
   MINFS_fs_calc_t calc; // values calculated once at fs-info-get / format
+#if MINFS_FREE_MAP_NUM_BLOCKS
+  uint8_t free_map_valid; // free_map was built at FSOpen / Format
+  uint32_t free_count; // number of free blocks
+  uint32_t free_map[(MINFS_FREE_MAP_NUM_BLOCKS + 31) / 32]; // one bit per block, set if free
+#endif
 } MINFS_fs_t;
 
 typedef struct{
@@ -133,6 +145,7 @@ typedef struct{
   uint32_t current_block_n; // current block number
   uint32_t data_ptr_block_offset; // data pointer offset in the current block
   uint32_t first_block_n; // first block of the file
+  uint32_t last_block_n; // last block of the file (MINFS_BLOCK_NULL if not known yet)
 } MINFS_file_t;
 
 // structure to hold information about a block-buffer
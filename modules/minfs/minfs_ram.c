@@ -21,6 +21,12 @@
 #define DEV_BLOCK_SIZE 64
 #define DEV_NUM_BLOCKS 32
 
+// number of block-buffers for the device (fs_id 1), the least recently used
+// buffer will be written back when a new block is needed
+#ifndef MINFS_RAM_CACHE_NUM_BLOCKS
+#define MINFS_RAM_CACHE_NUM_BLOCKS 4
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
@@ -30,17 +36,63 @@ typedef uint8_t databuf_t[DEV_BLOCK_SIZE];
 // virtual device blocks (or memory-fs)
 static databuf_t storage_blocks[DEV_NUM_BLOCKS];
 
-// block-buffer
+// block-buffer for the memory-fs
 static MINFS_block_buf_t block_buf;
-static databuf_t block_buf_buffer;
+
+// block-cache for the device
+static MINFS_block_buf_t cache_buf[MINFS_RAM_CACHE_NUM_BLOCKS];
+static databuf_t cache_buf_buffer[MINFS_RAM_CACHE_NUM_BLOCKS];
+static uint32_t cache_buf_used[MINFS_RAM_CACHE_NUM_BLOCKS]; // cache_tick of last access
+static uint32_t cache_tick;
+
+// device access counters
+static uint32_t cache_num_hits;
+static uint32_t dev_num_reads;
+static uint32_t dev_num_writes;
 
 /////////////////////////////////////////////////////////////////////////////
 // Blockbuffer initialization
 ////////////////////////////////////////////////////////////////////////////
 
 void MINFS_RAM_Init(void){
+  int i;
   MINFS_InitBlockBuffer(&block_buf);
-  block_buf.p_buf = block_buf_buffer;
+  for(i = 0; i < MINFS_RAM_CACHE_NUM_BLOCKS; i++){
+    MINFS_InitBlockBuffer(&cache_buf[i]);
+    cache_buf[i].p_buf = cache_buf_buffer[i];
+    cache_buf_used[i] = 0;
+  }
+  cache_tick = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Writes all changed block-buffers of the cache to the device. Has to be
+// called at the end of each MINFS-session.
+// IN:  <p_fs> Pointer to filesystem-info structure
+// OUT: 0 on success, else < 0 (MINFS_ERROR_XXXX)
+/////////////////////////////////////////////////////////////////////////////
+int32_t MINFS_RAM_Flush(MINFS_fs_t *p_fs){
+  int i;
+  int32_t status;
+  for(i = 0; i < MINFS_RAM_CACHE_NUM_BLOCKS; i++){
+    if( cache_buf[i].block_n != MINFS_BLOCK_NULL && cache_buf[i].flags.changed ){
+      if( status = MINFS_FlushBlockBuffer(p_fs, &cache_buf[i]) )
+        return status; // return error status
+    }
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of block-buffer requests served by the cache, and the
+// number of device block reads and writes since the last call
+// (used by the gnu_test to measure the operations)
+/////////////////////////////////////////////////////////////////////////////
+void MINFS_RAM_GetAccessCount(uint32_t *p_num_hits, uint32_t *p_num_reads, uint32_t *p_num_writes){
+  *p_num_hits = cache_num_hits;
+  *p_num_reads = dev_num_reads;
+  *p_num_writes = dev_num_writes;
+  cache_num_hits = dev_num_reads = dev_num_writes = 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -49,12 +101,10 @@ void MINFS_RAM_Init(void){
 int32_t MINFS_Read(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf, uint16_t data_offset, uint16_t data_len){
   if( p_fs->fs_id == 1){
     // simulate an external storage device (with random-access ability).
-    // if PEC is enabled, only whole blocks will be read (data_len == 0)
-    if(!data_len){
-      data_len = DEV_BLOCK_SIZE; // read entire block
-      p_block_buf->flags.populated = 1; // indicate that the whole block was read and copied to the buffer
-   }
-    memcpy( (uint8_t*)( (uint8_t*)(p_block_buf->p_buf) + data_offset ), (uint8_t*)( (uint8_t*)(storage_blocks[p_block_buf->block_n]) + data_offset ), data_len);
+    // always read the entire block, further accesses will be served by the cache
+    memcpy(p_block_buf->p_buf, storage_blocks[p_block_buf->block_n], DEV_BLOCK_SIZE);
+    p_block_buf->flags.populated = 1; // indicate that the whole block was read and copied to the buffer
+    dev_num_reads++;
   }
   return 0;
 }
@@ -62,22 +112,45 @@ int32_t MINFS_Read(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf, uint16_t da
 int32_t MINFS_Write(MINFS_fs_t *p_fs, MINFS_block_buf_t *p_block_buf, uint16_t data_offset, uint16_t data_len){
   if( p_fs->fs_id == 1){
     // simulate an external storage device (with random-access ability).
-    // if PEC is enabled, only whole blocks will be written (data_len == 0)
-    memcpy(&(storage_blocks[p_block_buf->block_n][data_offset]), (uint8_t*)(p_block_buf->p_buf) + data_offset, data_len ? data_len : DEV_BLOCK_SIZE);
+    // data portions stay in the cache (changed-flag remains set), the block
+    // will be written when the buffer is flushed (data_len == 0)
+    if( data_len ){
+      // a whole block (MINFS_Format) doesn't have to be populated anymore
+      if( data_offset == 0 && data_len >= p_fs->calc.block_data_len )
+        p_block_buf->flags.populated = 1;
+      return 0;
+    }
+    memcpy(storage_blocks[p_block_buf->block_n], p_block_buf->p_buf, DEV_BLOCK_SIZE);
     p_block_buf->flags.changed = 0;
+    dev_num_writes++;
   }
   return 0;
 }
 
 int32_t MINFS_GetBlockBuffer(MINFS_fs_t *p_fs, MINFS_block_buf_t **pp_block_buf, uint32_t block_n, uint32_t file_id){
-  // assign blockbuffer to return
-  (*pp_block_buf) = &block_buf;
   // if used as in-memory-filesystem, the data-block is assigned directly
   // flags and block_n are set, no call to read or write - hook will ever occur!
   if( p_fs->fs_id == 0){
+    (*pp_block_buf) = &block_buf;
     block_buf.block_n = block_n;
     block_buf.flags.populated = 1;
     block_buf.p_buf = storage_blocks[block_n];
+    return 0;
+  }
+  // search the cache for block_n, else take the least recently used buffer.
+  // A changed buffer will be flushed by MINFS before it is used for block_n.
+  int i, lru_i = 0;
+  for(i = 0; i < MINFS_RAM_CACHE_NUM_BLOCKS; i++){
+    if( cache_buf[i].block_n == block_n )
+      break;
+    if( (cache_tick - cache_buf_used[i]) > (cache_tick - cache_buf_used[lru_i]) )
+      lru_i = i;
   }
+  if( i == MINFS_RAM_CACHE_NUM_BLOCKS )
+    i = lru_i;
+  else
+    cache_num_hits++;
+  cache_buf_used[i] = ++cache_tick;
+  (*pp_block_buf) = &cache_buf[i];
   return 0;
 }
@@ -20,6 +20,12 @@ THUMB_SOURCE += \
 	$(MIOS32_PATH)/modules/msd/STM32F4xx/msd.c
 endif
 
+ifeq ($(FAMILY),POSIX)
+C_INCLUDE += -I $(MIOS32_PATH)/modules/msd/POSIX
+THUMB_SOURCE += \
+	$(MIOS32_PATH)/modules/msd/POSIX/msd.c
+endif
+
 ifeq ($(FAMILY),LPC17xx)
 C_INCLUDE += -I $(MIOS32_PATH)/modules/msd/LPC17xx
 THUMB_SOURCE += \
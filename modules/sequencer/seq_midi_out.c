@@ -49,8 +49,22 @@ typedef struct seq_midi_out_queue_item_t {
   mios32_midi_package_t package;
   u32                   timestamp;
   struct seq_midi_out_queue_item_t *next;
+  struct seq_midi_out_queue_item_t *prev;
+  struct seq_midi_out_queue_item_t *tag_next; // list of all items with the same tag
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  struct seq_midi_out_queue_item_t *tag_prev;
+  u16                   wheel_list; // index of the wheel list which contains the item
+#endif
 } seq_midi_out_queue_item_t;
 
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+// a list of the timing wheel
+typedef struct {
+  seq_midi_out_queue_item_t *head;
+  seq_midi_out_queue_item_t *tail;
+} seq_midi_out_wheel_list_t;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
@@ -58,6 +72,23 @@ typedef struct seq_midi_out_queue_item_t {
 
 static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void);
 static void SEQ_MIDI_OUT_SlotFree(seq_midi_out_queue_item_t *item);
+static u8 SEQ_MIDI_OUT_InsertBefore(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 timestamp);
+static u8 SEQ_MIDI_OUT_TagMatch(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter, u32 *delayed_timestamp);
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+static void SEQ_MIDI_OUT_WheelInsert(seq_midi_out_queue_item_t *item, u8 prepend);
+static void SEQ_MIDI_OUT_WheelUnlink(seq_midi_out_queue_item_t *item);
+static void SEQ_MIDI_OUT_WheelMoveTo(u32 new_cursor);
+static void SEQ_MIDI_OUT_WheelRebase(u32 new_cursor);
+static void SEQ_MIDI_OUT_WheelDispatch(void);
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_WheelDetachAll(void);
+static void SEQ_MIDI_OUT_TagLink(seq_midi_out_queue_item_t *item);
+static void SEQ_MIDI_OUT_TagUnlink(seq_midi_out_queue_item_t *item);
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_TagSort(seq_midi_out_queue_item_t *items);
+#else
+static void SEQ_MIDI_OUT_ListInsert(seq_midi_out_queue_item_t *new_item, seq_midi_out_queue_item_t *after_item);
+static void SEQ_MIDI_OUT_ListUnlink(seq_midi_out_queue_item_t *item, seq_midi_out_queue_item_t *tag_item);
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -83,8 +114,41 @@ static s32 (*callback_bpm_is_running)(void);
 static u32 (*callback_bpm_tick_get)(void);
 static s32 (*callback_bpm_set)(float bpm);
 
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+// the timing wheel:
+// - list 0..WHEEL_SIZE-1: first level, one list for each tick of the current block
+// - list WHEEL_SIZE..2*WHEEL_SIZE-1: second level, one list for each of the following blocks
+// - list 2*WHEEL_SIZE: overflow list for all events which are scheduled later
+// - list 2*WHEEL_SIZE+1: late list for events which are sent for a tick before the
+//   cursor, sorted like the sorted list and played before the events of the cursor tick
+#define WHEEL_SIZE      (1 << SEQ_MIDI_OUT_WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SIZE-1)
+#define WHEEL_L1_LIST   (WHEEL_SIZE)
+#define WHEEL_OVF_LIST  (2*WHEEL_SIZE)
+#define WHEEL_LATE_LIST (2*WHEEL_SIZE+1)
+#define WHEEL_NUM_LISTS (2*WHEEL_SIZE+2)
+
+static seq_midi_out_wheel_list_t wheel_list[WHEEL_NUM_LISTS];
+static seq_midi_out_queue_item_t *wheel_clk_last[WHEEL_SIZE]; // last Clock/Tempo event of a tick
+static seq_midi_out_queue_item_t *wheel_first_on[WHEEL_SIZE]; // first On/OnOff event of a tick
+static u32 wheel_cursor;    // the tick which has been dispatched last
+static u32 wheel_l0_count;  // number of events in first level and late list
+static u32 wheel_l1_count;  // number of events in second level
+static u32 wheel_ovf_count; // number of events in overflow list
+static u32 wheel_ovf_min;   // earliest timestamp in overflow list (could be earlier if events have been removed)
+
+// all items of a tag (mios32_midi_package_t.cable) in the order they have been sent,
+// so that SEQ_MIDI_OUT_ReSchedule() doesn't need to search through the whole wheel
+static seq_midi_out_wheel_list_t tag_list[16];
+#else
 static seq_midi_out_queue_item_t *midi_queue;
 
+// the first item of each tag (mios32_midi_package_t.cable) in the queue, further items
+// are linked via tag_next in the same order like in the queue, so that
+// SEQ_MIDI_OUT_ReSchedule() doesn't need to search through the whole queue
+static seq_midi_out_queue_item_t *tag_first[16];
+#endif
+
 
 #if SEQ_MIDI_OUT_MALLOC_METHOD >= 0 && SEQ_MIDI_OUT_MALLOC_METHOD <= 3
 
@@ -333,74 +397,14 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   DEBUG_MSG("[SEQ_MIDI_OUT_Send:%u] (tag %d) %02x %02x %02x len:%u @%u\n", timestamp, midi_package.cable, midi_package.evnt0, midi_package.evnt1, midi_package.evnt2, len, SEQ_BPM_TickGet());
 #endif
 
-  // search in queue for last item which has the same (or earlier) timestamp
-  seq_midi_out_queue_item_t *item;
-  if( (item=midi_queue) == NULL ) {
-    // no item in queue -- first element
-    midi_queue = new_item;
-  } else {
-    u8 insert_before_item = 0;
-    seq_midi_out_queue_item_t *last_item = NULL;
-    seq_midi_out_queue_item_t *next_item;
-    do {
-      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
-      if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
-	  item->timestamp >= timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
-	// found any event with same timestamp, insert clock before these events
-	// note that the Clock event order doesn't get lost if clock events 
-	// are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
-	insert_before_item = 1;
-	break;
-      }
-
-      // CCs are sorted before notes at a given timestamp
-      // (new CC before On events at the same timestamp)
-      // CCs are still played after Off or Clock events
-      if( event_type == SEQ_MIDI_OUT_CCEvent && 
-	  item->timestamp == timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
-	// found On event with same timestamp, play CC before On event
-	insert_before_item = 1;
-	break;
-      }
-
-      if( item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	insert_before_item = 1;
-	break;
-      }
-
-      if( (next_item=item->next) == NULL ) {
-	// end of queue reached, insert new item at the end
-	break;
-      }
-	
-      if( next_item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	break;
-      }
-
-      // switch to next item
-      last_item = item;
-      item = next_item;
-    } while( 1 );
-
-    // insert/add item into/to list
-    if( insert_before_item ) {
-      if( last_item == NULL )
-	midi_queue = new_item;
-      else
-	last_item->next = new_item;
-      new_item->next = item;
-    } else {
-      item->next = new_item;
-      new_item->next = next_item;
-    }
-  }
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  // sort item into timing wheel
+  SEQ_MIDI_OUT_WheelInsert(new_item, 0);
+  SEQ_MIDI_OUT_TagLink(new_item);
+#else
+  // sort item into queue
+  SEQ_MIDI_OUT_ListInsert(new_item, NULL);
+#endif
 
   // schedule off event now if length > 16bit (since it cannot be stored in event record)
   if( event_type == SEQ_MIDI_OUT_OnOffEvent && len > 0xffff ) {
@@ -408,9 +412,9 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   }
 
   // display queue
-#if DEBUG_VERBOSE_LEVEL >= 4
+#if DEBUG_VERBOSE_LEVEL >= 4 && SEQ_MIDI_OUT_SCHEDULER == 0
   DEBUG_MSG("--- vvv ---\n");
-  item=midi_queue;
+  seq_midi_out_queue_item_t *item=midi_queue;
   while( item != NULL ) {
     DEBUG_MSG("[%u] (tag %d) %02x %02x %02x len:%u @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, item->len, SEQ_BPM_TickGet());
     item = item->next;
@@ -437,6 +441,16 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
 //! event at timestamp 0xffffffff, reschedule it to timestamp == bpm_tick
 //! once the sequencer determined, that the off event should be played.
 //!
+//! Events are checked in the order they will be played. The search stops
+//! at the first matching event which will be played at or before the new
+//! timestamp anyhow, later events of the tag won't be re-scheduled.
+//!
+//! Only the events of the given tag have to be checked, each tag has its own
+//! list. Each re-scheduled event is moved without searching through the queue
+//! again (with SEQ_MIDI_OUT_SCHEDULER == 0 only the first event has to be
+//! sorted into the queue, further events with the same timestamp are placed
+//! behind it).
+//!
 //! \param[in] tag (0..15) the mios32_midi_package.t.cable number of events which should be re-scheduled
 //! \param[in] event_type the event type which should be rescheduled
 //! \param[in] timestamp the bpm_tick value at which the event should be sent
@@ -448,95 +462,145 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter)
 {
-  // search in queue for items with the given tag
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  seq_midi_out_queue_item_t *item;
+  seq_midi_out_queue_item_t *stop_item = NULL;
+  u32 delayed_timestamp = timestamp;
+
+  // Same result like the sorted list: the list is searched in timestamp order
+  // and the search stops at the first matching event which will be played
+  // earlier anyhow, so that later events won't be re-scheduled.
+  // The tag list isn't sorted, therefore this stop event is determined first.
+  // Events with the same timestamp are compared in the order they have been sent.
+  for(item=tag_list[tag & 0x0f].head; item != NULL; item=item->tag_next) {
+    if( SEQ_MIDI_OUT_TagMatch(item, event_type, timestamp, reschedule_filter, &delayed_timestamp) &&
+	item->timestamp <= delayed_timestamp &&
+	(stop_item == NULL || item->timestamp < stop_item->timestamp) )
+      stop_item = item;
+  }
 
-  seq_midi_out_queue_item_t *prev_item = NULL;
-  seq_midi_out_queue_item_t *item = midi_queue;
-  while( item != NULL ) {
-    // filter event_type and tag
-    // and ignore events, which will be played with next invocation of the Out Handler to avoid,
-    // that a re-scheduled event will be checked again
-    u8 evnt1 = item->package.evnt1;
-    if( (item->event_type == event_type) && (item->package.cable == tag) &&
-	(reschedule_filter == NULL ||
-	 !(reschedule_filter[evnt1>>5] & (1 << (evnt1 & 0x1f)))) ) {
-      // ensure that we get a free memory slot by releasing the current item before queuing the off item
-#if 0
-      seq_midi_out_queue_item_t copy = *item;
-#else
-      // ???
-      seq_midi_out_queue_item_t copy;
-      copy.port = item->port;
-      copy.event_type = item->event_type;
-      copy.len = item->len;
-      copy.package.ALL = item->package.ALL;
-      copy.timestamp = item->timestamp;
-      copy.next = item->next;
-#endif
+  // remove the events which have to be re-scheduled from the timing wheel
+  // they are collected in a list which is linked via the next pointer
+  seq_midi_out_queue_item_t *moved_items = NULL;
+  seq_midi_out_queue_item_t *last_moved_item = NULL;
+  u8 before_stop_item = 1;
+  for(item=tag_list[tag & 0x0f].head; item != NULL; item=item->tag_next) {
+    if( item == stop_item )
+      before_stop_item = 0;
+
+    if( !SEQ_MIDI_OUT_TagMatch(item, event_type, timestamp, reschedule_filter, &delayed_timestamp) )
+      continue;
+
+    // ignore events, which will be played earlier anyhow
+    if( item->timestamp <= delayed_timestamp )
+      continue;
+
+    // ignore events which are located behind the stop item in the sorted list
+    if( stop_item != NULL &&
+	(item->timestamp > stop_item->timestamp || (item->timestamp == stop_item->timestamp && !before_stop_item)) )
+      continue;
+
+    SEQ_MIDI_OUT_WheelUnlink(item);
+    if( last_moved_item == NULL )
+      moved_items = item;
+    else
+      last_moved_item->next = item;
+    last_moved_item = item;
+  }
 
-      u32 delayed_timestamp = timestamp;
-#if SEQ_MIDI_OUT_SUPPORT_DELAY
-      if( copy.port < PPQN_DELAY_NUM ) {
-	s8 delay = ppqn_delay[copy.port];
-	if( (delay < 0) && (delayed_timestamp < -delay) ) {
-	  delayed_timestamp = 0;
-	} else {
-	  delayed_timestamp += delay;
-	}
-      }
+  // re-sort the events into the timing wheel in the order of their old timestamps,
+  // so that events which are re-scheduled to the same timestamp are sent in the
+  // same order like with the sorted list
+  moved_items = SEQ_MIDI_OUT_TagSort(moved_items);
+  while( (item=moved_items) != NULL ) {
+    moved_items = item->next;
+    SEQ_MIDI_OUT_TagMatch(item, event_type, timestamp, reschedule_filter, &delayed_timestamp);
+
+#if DEBUG_VERBOSE_LEVEL >= 2
+    DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] (tag %d) %02x %02x %02x @%u\n", timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
 #endif
+
+    item->timestamp = delayed_timestamp;
+    SEQ_MIDI_OUT_WheelInsert(item, 0);
+  }
+#else
+  // the tag list is sorted like the queue
+  seq_midi_out_queue_item_t *item = tag_first[tag & 0x0f];
+  seq_midi_out_queue_item_t *tag_item = NULL; // last item of the tag which stays in the queue
+  seq_midi_out_queue_item_t *moved_items = NULL;
+  seq_midi_out_queue_item_t *last_moved_item = NULL;
+  u32 delayed_timestamp;
+
+  while( item != NULL ) {
+    seq_midi_out_queue_item_t *next_item = item->tag_next;
+
+    // filter event_type
+    if( SEQ_MIDI_OUT_TagMatch(item, event_type, timestamp, reschedule_filter, &delayed_timestamp) ) {
+      // stop at the first event which will be played earlier anyhow
       if( item->timestamp <= delayed_timestamp )
 	break;
 
-      // remove item from queue
-      seq_midi_out_queue_item_t *next_item = item->next;
-      SEQ_MIDI_OUT_SlotFree(item);
-      item = next_item;
+      // remove item from queue, it will be sorted into the queue again below
+      SEQ_MIDI_OUT_ListUnlink(item, tag_item);
+      item->timestamp = delayed_timestamp;
+      item->next = NULL;
+      if( last_moved_item == NULL )
+	moved_items = item;
+      else
+	last_moved_item->next = item;
+      last_moved_item = item;
+    } else {
+      tag_item = item;
+    }
 
-      // fix link to next item
-      if( prev_item == NULL ) {
-	midi_queue = item;
-      } else {
-	prev_item->next = item;
-      }
+    item = next_item;
+  }
+
+  // re-schedule the items at the new timestamp
+  // an item which gets the same timestamp like the previous one will be placed behind it,
+  // the queue doesn't need to be searched again
+  seq_midi_out_queue_item_t *prev_item = NULL;
+  while( (item=moved_items) != NULL ) {
+    moved_items = item->next;
 
 #if DEBUG_VERBOSE_LEVEL >= 2
-      DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] (tag %d) %02x %02x %02x @%u\n", timestamp, copy.package.cable, copy.package.evnt0, copy.package.evnt1, copy.package.evnt2, SEQ_BPM_TickGet());
-#endif
-
-      // re-schedule copied item at new timestamp
-      SEQ_MIDI_OUT_Send(copy.port, copy.package, copy.event_type, timestamp, copy.len);
-
-      // determine new prev_item if required
-      // TODO: find more elegant solution which doesn't require to search through the linked list!
-      if( item != NULL ) {
-	prev_item = NULL;
-	seq_midi_out_queue_item_t *tmp_item = midi_queue;
-	while( tmp_item != NULL ) {
-	  if( tmp_item->next == item ) {
-	    prev_item = tmp_item;
-	    break;
-	  } else
-	    tmp_item = tmp_item->next;
-	}
+    DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] (tag %d) %02x %02x %02x @%u\n", timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
+#endif
 
-	if( prev_item == NULL ) {
-#if DEBUG_VERBOSE_LEVEL >= 1
-	  // (always print out - this condition should never happen!)
-	  DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] Malfunction - prev_item not found anymore!\n", timestamp);
+    SEQ_MIDI_OUT_ListInsert(item, (prev_item != NULL && prev_item->timestamp == item->timestamp) ? prev_item : NULL);
+    prev_item = item;
+  }
 #endif
-	  return -1; // data corruption!
-	}
-      }
 
-    } else {
-      // switch to next item
-      prev_item = item;
-      item = item->next;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function re-schedules MIDI events of multiple tags at once, e.g.
+//! to stop the sustained notes of all tracks.
+//!
+//! Only the events of the selected tags have to be checked.
+//!
+//! \param[in] tag_mask one flag for each tag (bit 0: tag 0, ... bit 15: tag 15)
+//! \param[in] event_type the event type which should be rescheduled
+//! \param[in] timestamp the bpm_tick value at which the events should be sent
+//! \param[in] reschedule_filter see SEQ_MIDI_OUT_ReSchedule()
+//! 
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIDI_OUT_ReScheduleTags(u16 tag_mask, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter)
+{
+  s32 status = 0;
+  u8 tag;
+
+  for(tag=0; tag<16; ++tag) {
+    if( tag_mask & (1 << tag) ) {
+      status |= SEQ_MIDI_OUT_ReSchedule(tag, event_type, timestamp, reschedule_filter);
     }
   }
 
-  return 0; // no error
+  return status;
 }
 
 
@@ -547,15 +611,29 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
 s32 SEQ_MIDI_OUT_FlushQueue(void)
 {
   seq_midi_out_queue_item_t *item;
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  seq_midi_out_queue_item_t *next_item;
+  for(item=SEQ_MIDI_OUT_WheelDetachAll(); item != NULL; item=next_item) {
+    if( item->event_type == SEQ_MIDI_OUT_OffEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent ) {
+      item->package.velocity = 0; // ensure that velocity is 0
+      callback_midi_send_package(item->port, item->package);
+    }
+
+    next_item = item->next;
+    SEQ_MIDI_OUT_TagUnlink(item);
+    SEQ_MIDI_OUT_SlotFree(item);
+  }
+#else
   while( (item=midi_queue) != NULL ) {
     if( item->event_type == SEQ_MIDI_OUT_OffEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent ) {
       item->package.velocity = 0; // ensure that velocity is 0
       callback_midi_send_package(item->port, item->package);
     }
 
-    midi_queue = item->next;
+    SEQ_MIDI_OUT_ListUnlink(item, NULL);
     SEQ_MIDI_OUT_SlotFree(item);
   }
+#endif
 
   return 0; // no error
 }
@@ -569,10 +647,19 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
 {
   // ensure that all items are delocated
   seq_midi_out_queue_item_t *item;
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  seq_midi_out_queue_item_t *next_item;
+  for(item=SEQ_MIDI_OUT_WheelDetachAll(); item != NULL; item=next_item) {
+    next_item = item->next;
+    SEQ_MIDI_OUT_TagUnlink(item);
+    SEQ_MIDI_OUT_SlotFree(item);
+  }
+#else
   while( (item=midi_queue) != NULL ) {
-    midi_queue = item->next;
+    SEQ_MIDI_OUT_ListUnlink(item, NULL);
     SEQ_MIDI_OUT_SlotFree(item);
   }
+#endif
 
   // free memory
 #if SEQ_MIDI_OUT_MALLOC_METHOD == 4
@@ -609,6 +696,35 @@ s32 SEQ_MIDI_OUT_Handler(void)
   if( !callback_bpm_is_running() )
     return 0;
 
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  u32 now = callback_bpm_tick_get();
+
+  // re-sort all events if the tick has been moved backwards (e.g. song position changed)
+  if( now < wheel_cursor )
+    SEQ_MIDI_OUT_WheelRebase(now);
+
+  // dispatch all ticks until now (or which have been missed earlier)
+  // the cursor stays at the current tick, so that events which are sent for this
+  // tick after the dispatch are played with the next handler call like with the sorted list
+  while( 1 ) {
+    if( wheel_l0_count )
+      SEQ_MIDI_OUT_WheelDispatch();
+
+    if( wheel_cursor == now )
+      break;
+
+    // skip ticks which don't contain events
+    u32 next_tick = wheel_cursor + 1;
+    if( !wheel_l0_count ) {
+      next_tick = wheel_l1_count ? ((wheel_cursor | WHEEL_MASK) + 1) : now;
+      if( wheel_ovf_count && wheel_ovf_min < next_tick )
+	next_tick = wheel_ovf_min;
+      if( next_tick > now || next_tick <= wheel_cursor )
+	next_tick = now;
+    }
+    SEQ_MIDI_OUT_WheelMoveTo(next_tick);
+  }
+#else
   // search in queue for items which have to be played now (or have been missed earlier)
   // note that we are going through a sorted list, therefore we can exit once a timestamp
   // has been found which has to be played later than now
@@ -646,8 +762,8 @@ s32 SEQ_MIDI_OUT_Handler(void)
 #endif
       copy.package.velocity = 0; // ensure that velocity is 0
 
-      // remove item from queue
-      midi_queue = item->next;
+      // remove item from queue (it's the first item of its tag as well)
+      SEQ_MIDI_OUT_ListUnlink(item, NULL);
       SEQ_MIDI_OUT_SlotFree(item);
 
       u32 delayed_timestamp = copy.len + copy.timestamp;
@@ -665,16 +781,576 @@ s32 SEQ_MIDI_OUT_Handler(void)
 
       SEQ_MIDI_OUT_Send(copy.port, copy.package, SEQ_MIDI_OUT_OffEvent, delayed_timestamp, 0);
     } else {
-      // remove item from queue
-      midi_queue = item->next;
+      // remove item from queue (it's the first item of its tag as well)
+      SEQ_MIDI_OUT_ListUnlink(item, NULL);
       SEQ_MIDI_OUT_SlotFree(item);
     }
   }
+#endif
 
   return 0; // no error
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local function which checks if a new event has to be inserted before the
+// given item of a list which is sorted by timestamp
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIDI_OUT_InsertBefore(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 timestamp)
+{
+  // Clock and Tempo events are sorted before CC and Note events at a given timestamp
+  if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
+      item->timestamp >= timestamp &&
+      (item->event_type == SEQ_MIDI_OUT_OnEvent || 
+       item->event_type == SEQ_MIDI_OUT_OffEvent || 
+       item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
+       item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
+    // found any event with same timestamp, insert clock before these events
+    // note that the Clock event order doesn't get lost if clock events 
+    // are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
+    return 1;
+  }
+
+  // CCs are sorted before notes at a given timestamp
+  // (new CC before On events at the same timestamp)
+  // CCs are still played after Off or Clock events
+  if( event_type == SEQ_MIDI_OUT_CCEvent && 
+      item->timestamp == timestamp &&
+      (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
+    // found On event with same timestamp, play CC before On event
+    return 1;
+  }
+
+  // found entry with later timestamp
+  return item->timestamp > timestamp;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to get the re-schedule timestamp of an item
+// returns 0 if the item doesn't match the event_type and reschedule_filter
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIDI_OUT_TagMatch(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter, u32 *delayed_timestamp)
+{
+  u8 evnt1 = item->package.evnt1;
+  if( item->event_type != event_type ||
+      (reschedule_filter != NULL && (reschedule_filter[evnt1>>5] & (1 << (evnt1 & 0x1f)))) )
+    return 0;
+
+  *delayed_timestamp = timestamp;
+#if SEQ_MIDI_OUT_SUPPORT_DELAY
+  if( item->port < PPQN_DELAY_NUM ) {
+    s8 delay = ppqn_delay[item->port];
+    if( (delay < 0) && (*delayed_timestamp < -delay) ) {
+      *delayed_timestamp = 0;
+    } else {
+      *delayed_timestamp += delay;
+    }
+  }
+#endif
+
+  return 1;
+}
+
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+/////////////////////////////////////////////////////////////////////////////
+// Local function to link an item into a wheel list
+// the item will be inserted before the given item, or added to the end of
+// the list if before_item is NULL
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelLink(seq_midi_out_queue_item_t *item, u16 list_ix, seq_midi_out_queue_item_t *before_item)
+{
+  seq_midi_out_wheel_list_t *list = &wheel_list[list_ix];
+
+  item->wheel_list = list_ix;
+  item->next = before_item;
+  if( before_item == NULL ) {
+    item->prev = list->tail;
+    if( list->tail == NULL )
+      list->head = item;
+    else
+      list->tail->next = item;
+    list->tail = item;
+  } else {
+    item->prev = before_item->prev;
+    if( before_item->prev == NULL )
+      list->head = item;
+    else
+      before_item->prev->next = item;
+    before_item->prev = item;
+  }
+
+  if( list_ix < WHEEL_L1_LIST || list_ix == WHEEL_LATE_LIST )
+    ++wheel_l0_count;
+  else if( list_ix < WHEEL_OVF_LIST )
+    ++wheel_l1_count;
+  else
+    ++wheel_ovf_count;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to remove an item from its wheel list
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelUnlink(seq_midi_out_queue_item_t *item)
+{
+  u16 list_ix = item->wheel_list;
+  seq_midi_out_wheel_list_t *list = &wheel_list[list_ix];
+
+  if( list_ix < WHEEL_L1_LIST ) {
+    // update insert positions of the tick
+    // (the Clock/Tempo events are always located at the beginning of the list)
+    if( wheel_clk_last[list_ix] == item )
+      wheel_clk_last[list_ix] = item->prev;
+
+    if( wheel_first_on[list_ix] == item ) {
+      seq_midi_out_queue_item_t *on_item = item->next;
+      while( on_item != NULL &&
+	     on_item->event_type != SEQ_MIDI_OUT_OnEvent &&
+	     on_item->event_type != SEQ_MIDI_OUT_OnOffEvent )
+	on_item = on_item->next;
+      wheel_first_on[list_ix] = on_item;
+    }
+
+    --wheel_l0_count;
+  } else if( list_ix == WHEEL_LATE_LIST ) {
+    --wheel_l0_count;
+  } else if( list_ix < WHEEL_OVF_LIST ) {
+    --wheel_l1_count;
+  } else {
+    --wheel_ovf_count;
+  }
+
+  if( item->prev == NULL )
+    list->head = item->next;
+  else
+    item->prev->next = item->next;
+
+  if( item->next == NULL )
+    list->tail = item->prev;
+  else
+    item->next->prev = item->prev;
+
+  item->next = NULL;
+  item->prev = NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to sort an item into the timing wheel
+// if prepend is set, the item will be inserted at the beginning of a second
+// level or overflow list (used when items are cascaded from a higher level)
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelInsert(seq_midi_out_queue_item_t *item, u8 prepend)
+{
+  u32 timestamp = item->timestamp;
+
+  if( timestamp < wheel_cursor ) {
+    // events which should have been played already will be sent with the next handler call
+    // they are sorted like in the sorted list, so that they are played in the same order
+    seq_midi_out_queue_item_t *before_item = wheel_list[WHEEL_LATE_LIST].head;
+    while( before_item != NULL && !SEQ_MIDI_OUT_InsertBefore(before_item, item->event_type, timestamp) )
+      before_item = before_item->next;
+    SEQ_MIDI_OUT_WheelLink(item, WHEEL_LATE_LIST, before_item);
+    return;
+  }
+
+  u32 block_delta = (timestamp >> SEQ_MIDI_OUT_WHEEL_BITS) - (wheel_cursor >> SEQ_MIDI_OUT_WHEEL_BITS);
+
+  if( block_delta == 0 ) {
+    // first level: sort by event type
+    u16 list_ix = timestamp & WHEEL_MASK;
+
+    switch( item->event_type ) {
+    case SEQ_MIDI_OUT_ClkEvent:
+    case SEQ_MIDI_OUT_TempoEvent:
+      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
+      // note that the Clock event order doesn't get lost if clock events 
+      // are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
+      SEQ_MIDI_OUT_WheelLink(item, list_ix, (wheel_clk_last[list_ix] == NULL)
+			     ? wheel_list[list_ix].head
+			     : wheel_clk_last[list_ix]->next);
+      wheel_clk_last[list_ix] = item;
+      break;
+
+    case SEQ_MIDI_OUT_CCEvent:
+      // CCs are sorted before notes at a given timestamp
+      // (new CC before On events at the same timestamp)
+      SEQ_MIDI_OUT_WheelLink(item, list_ix, wheel_first_on[list_ix]);
+      break;
+
+    case SEQ_MIDI_OUT_OnEvent:
+    case SEQ_MIDI_OUT_OnOffEvent:
+      SEQ_MIDI_OUT_WheelLink(item, list_ix, NULL);
+      if( wheel_first_on[list_ix] == NULL )
+	wheel_first_on[list_ix] = item;
+      break;
+
+    default:
+      SEQ_MIDI_OUT_WheelLink(item, list_ix, NULL);
+    }
+  } else if( block_delta < WHEEL_SIZE ) {
+    // second level: will be sorted once the block is reached
+    u16 list_ix = WHEEL_L1_LIST + ((timestamp >> SEQ_MIDI_OUT_WHEEL_BITS) & WHEEL_MASK);
+    SEQ_MIDI_OUT_WheelLink(item, list_ix, prepend ? wheel_list[list_ix].head : NULL);
+  } else {
+    // overflow: will be sorted once the second level covers the timestamp
+    SEQ_MIDI_OUT_WheelLink(item, WHEEL_OVF_LIST, prepend ? wheel_list[WHEEL_OVF_LIST].head : NULL);
+    if( timestamp < wheel_ovf_min )
+      wheel_ovf_min = timestamp;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to re-sort all items of a second level or overflow list
+// Cascaded items have been scheduled before all items which are stored in
+// the lower levels for the same timestamp, therefore they are inserted at
+// the beginning of the lists to keep the order in which events have been sent.
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelCascade(u16 list_ix)
+{
+  seq_midi_out_wheel_list_t *list = &wheel_list[list_ix];
+  seq_midi_out_queue_item_t *item = list->tail;
+  seq_midi_out_queue_item_t *first_level_items = NULL;
+
+  // detach the list, so that items which are sorted into the same list again won't be checked twice
+  list->head = NULL;
+  list->tail = NULL;
+  if( list_ix == WHEEL_OVF_LIST )
+    wheel_ovf_min = 0xffffffff;
+
+  // go through the list backwards, so that prepended items keep their order
+  while( item != NULL ) {
+    seq_midi_out_queue_item_t *prev_item = item->prev;
+
+    if( list_ix == WHEEL_OVF_LIST )
+      --wheel_ovf_count;
+    else
+      --wheel_l1_count;
+
+    if( item->timestamp < wheel_cursor ||
+	(item->timestamp >> SEQ_MIDI_OUT_WHEEL_BITS) == (wheel_cursor >> SEQ_MIDI_OUT_WHEEL_BITS) ) {
+      // first level items are sorted by event type in original order below
+      item->next = first_level_items;
+      first_level_items = item;
+    } else {
+      SEQ_MIDI_OUT_WheelInsert(item, 1);
+    }
+
+    item = prev_item;
+  }
+
+  while( first_level_items != NULL ) {
+    item = first_level_items;
+    first_level_items = item->next;
+    SEQ_MIDI_OUT_WheelInsert(item, 0);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to move the cursor forward
+// Items of the second level and overflow list will be cascaded into the
+// lower levels once the cursor enters a new block.
+// It's expected, that all first level items before new_cursor have been dispatched.
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelMoveTo(u32 new_cursor)
+{
+  u32 block = wheel_cursor >> SEQ_MIDI_OUT_WHEEL_BITS;
+  u32 new_block = new_cursor >> SEQ_MIDI_OUT_WHEEL_BITS;
+
+  wheel_cursor = new_cursor;
+
+  if( new_block != block ) {
+    // second level: sort items of the reached (or passed) blocks into the first level
+    if( wheel_l1_count ) {
+      u32 num_blocks = new_block - block;
+      if( num_blocks > WHEEL_SIZE )
+	num_blocks = WHEEL_SIZE;
+
+      while( num_blocks-- ) {
+	++block;
+	SEQ_MIDI_OUT_WheelCascade(WHEEL_L1_LIST + (block & WHEEL_MASK));
+      }
+    }
+
+    // overflow: sort items which are in range of the second level now
+    if( wheel_ovf_count &&
+	(wheel_ovf_min < new_cursor || ((wheel_ovf_min >> SEQ_MIDI_OUT_WHEEL_BITS) - new_block) < WHEEL_SIZE) ) {
+      SEQ_MIDI_OUT_WheelCascade(WHEEL_OVF_LIST);
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to re-sort all items for a new cursor position
+// (used if the tick has been moved backwards)
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelRebase(u32 new_cursor)
+{
+  seq_midi_out_queue_item_t *item = SEQ_MIDI_OUT_WheelDetachAll();
+
+  wheel_cursor = new_cursor;
+
+  while( item != NULL ) {
+    seq_midi_out_queue_item_t *next_item = item->next;
+    SEQ_MIDI_OUT_WheelInsert(item, 0);
+    item = next_item;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to play all items of the late list and of the tick at the
+// cursor position
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_WheelDispatch(void)
+{
+  u16 list_ix = wheel_cursor & WHEEL_MASK;
+  seq_midi_out_queue_item_t *item;
+
+  // note: Off events which are scheduled for the same tick will be added to the lists again
+  while( (item=wheel_list[WHEEL_LATE_LIST].head) != NULL ||
+	 (item=wheel_list[list_ix].head) != NULL ) {
+    SEQ_MIDI_OUT_WheelUnlink(item);
+
+#if DEBUG_VERBOSE_LEVEL >= 2
+#if DEBUG_VERBOSE_LEVEL == 2
+    if( item->event_type != SEQ_MIDI_OUT_ClkEvent )
+#endif
+    DEBUG_MSG("[SEQ_MIDI_OUT_Handler:%u] (tag %d) %02x %02x %02x @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
+#endif
+
+    // if tempo event: change BPM stored in midi_package.ALL
+    if( item->event_type == SEQ_MIDI_OUT_TempoEvent ) {
+      callback_bpm_set(item->package.ALL);
+    } else {
+      callback_midi_send_package(item->port, item->package);
+    }
+
+    // schedule Off event if requested
+    if( item->event_type == SEQ_MIDI_OUT_OnOffEvent && item->len ) {
+      // the item can be re-used for the Off event
+      // (timestamp already contains the port delay)
+      item->package.velocity = 0; // ensure that velocity is 0
+      item->event_type = SEQ_MIDI_OUT_OffEvent;
+      item->timestamp += item->len;
+      item->len = 0;
+      SEQ_MIDI_OUT_WheelInsert(item, 0);
+    } else {
+      SEQ_MIDI_OUT_TagUnlink(item);
+      SEQ_MIDI_OUT_SlotFree(item);
+    }
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to remove all items from the timing wheel
+// returns a list of all items (linked via next pointer), sorted by wheel level
+/////////////////////////////////////////////////////////////////////////////
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_WheelDetachAll(void)
+{
+  seq_midi_out_queue_item_t *first_item = NULL;
+  seq_midi_out_queue_item_t *last_item = NULL;
+
+  u16 i;
+  for(i=0; i<WHEEL_NUM_LISTS; ++i) {
+    // start with the late list, and with the list of the cursor position at each level
+    u16 list_ix;
+    if( i == 0 )
+      list_ix = WHEEL_LATE_LIST;
+    else if( i <= WHEEL_L1_LIST )
+      list_ix = (wheel_cursor + i - 1) & WHEEL_MASK;
+    else if( i <= WHEEL_OVF_LIST )
+      list_ix = WHEEL_L1_LIST + (((wheel_cursor >> SEQ_MIDI_OUT_WHEEL_BITS) + i - 1) & WHEEL_MASK);
+    else
+      list_ix = WHEEL_OVF_LIST;
+
+    seq_midi_out_wheel_list_t *list = &wheel_list[list_ix];
+    if( list->head != NULL ) {
+      if( last_item == NULL )
+	first_item = list->head;
+      else
+	last_item->next = list->head;
+      last_item = list->tail;
+
+      list->head = NULL;
+      list->tail = NULL;
+    }
+
+    if( list_ix < WHEEL_L1_LIST ) {
+      wheel_clk_last[list_ix] = NULL;
+      wheel_first_on[list_ix] = NULL;
+    }
+  }
+
+  wheel_l0_count = 0;
+  wheel_l1_count = 0;
+  wheel_ovf_count = 0;
+  wheel_ovf_min = 0xffffffff;
+
+  return first_item;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to add an item to the end of the list of its tag
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_TagLink(seq_midi_out_queue_item_t *item)
+{
+  seq_midi_out_wheel_list_t *list = &tag_list[item->package.cable];
+
+  item->tag_next = NULL;
+  item->tag_prev = list->tail;
+  if( list->tail == NULL )
+    list->head = item;
+  else
+    list->tail->tag_next = item;
+  list->tail = item;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to remove an item from the list of its tag
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_TagUnlink(seq_midi_out_queue_item_t *item)
+{
+  seq_midi_out_wheel_list_t *list = &tag_list[item->package.cable];
+
+  if( item->tag_prev == NULL )
+    list->head = item->tag_next;
+  else
+    item->tag_prev->tag_next = item->tag_next;
+
+  if( item->tag_next == NULL )
+    list->tail = item->tag_prev;
+  else
+    item->tag_next->tag_prev = item->tag_prev;
+
+  item->tag_next = NULL;
+  item->tag_prev = NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to sort items (linked via next pointer) by timestamp
+// Merge sort: items with the same timestamp keep their order
+/////////////////////////////////////////////////////////////////////////////
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_TagSort(seq_midi_out_queue_item_t *items)
+{
+  if( items == NULL || items->next == NULL )
+    return items;
+
+  // split the list in the middle
+  seq_midi_out_queue_item_t *middle_item = items;
+  seq_midi_out_queue_item_t *item = items->next;
+  while( item != NULL && item->next != NULL ) {
+    middle_item = middle_item->next;
+    item = item->next->next;
+  }
+  seq_midi_out_queue_item_t *second_items = middle_item->next;
+  middle_item->next = NULL;
+
+  items = SEQ_MIDI_OUT_TagSort(items);
+  second_items = SEQ_MIDI_OUT_TagSort(second_items);
+
+  // merge both lists, take the item of the first list if timestamps are equal
+  seq_midi_out_queue_item_t *first_item = NULL;
+  seq_midi_out_queue_item_t *last_item = NULL;
+  while( items != NULL || second_items != NULL ) {
+    if( second_items == NULL || (items != NULL && items->timestamp <= second_items->timestamp) ) {
+      item = items;
+      items = items->next;
+    } else {
+      item = second_items;
+      second_items = second_items->next;
+    }
+
+    if( last_item == NULL )
+      first_item = item;
+    else
+      last_item->next = item;
+    last_item = item;
+  }
+
+  return first_item;
+}
+#else
+/////////////////////////////////////////////////////////////////////////////
+// Local function to sort an item into the queue and into the list of its tag
+// if after_item != NULL, the item will be inserted behind after_item without
+// searching through the queue (after_item must have the same tag, event type
+// and timestamp)
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_ListInsert(seq_midi_out_queue_item_t *new_item, seq_midi_out_queue_item_t *after_item)
+{
+  u8 tag = new_item->package.cable;
+  seq_midi_out_queue_item_t *last_item = after_item;
+  seq_midi_out_queue_item_t *tag_item = after_item; // last item of the same tag before the new item
+  seq_midi_out_queue_item_t *item;
+
+  if( after_item != NULL ) {
+    item = after_item->next;
+  } else {
+    // search in queue for last item which has the same (or earlier) timestamp
+    item = midi_queue;
+    while( item != NULL && !SEQ_MIDI_OUT_InsertBefore(item, new_item->event_type, new_item->timestamp) ) {
+      if( item->package.cable == tag )
+	tag_item = item;
+
+      // switch to next item
+      last_item = item;
+      item = item->next;
+    }
+  }
+
+  // insert/add item into/to queue
+  new_item->prev = last_item;
+  new_item->next = item;
+  if( last_item == NULL )
+    midi_queue = new_item;
+  else
+    last_item->next = new_item;
+  if( item != NULL )
+    item->prev = new_item;
+
+  // insert item into the list of its tag
+  if( tag_item == NULL ) {
+    new_item->tag_next = tag_first[tag];
+    tag_first[tag] = new_item;
+  } else {
+    new_item->tag_next = tag_item->tag_next;
+    tag_item->tag_next = new_item;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to remove an item from the queue and from the list of its tag
+// tag_item is the previous item of the same tag (NULL if the item is the first one)
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_ListUnlink(seq_midi_out_queue_item_t *item, seq_midi_out_queue_item_t *tag_item)
+{
+  if( item->prev == NULL )
+    midi_queue = item->next;
+  else
+    item->prev->next = item->next;
+
+  if( item->next != NULL )
+    item->next->prev = item->prev;
+
+  if( tag_item == NULL )
+    tag_first[item->package.cable] = item->tag_next;
+  else
+    tag_item->tag_next = item->tag_next;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local function to allocate memory
 // returns NULL if no memory free
@@ -35,7 +35,7 @@ extern "C" {
 #endif
 
 // max number of scheduled events which will allocate memory
-// each event allocates 12 bytes
+// each event allocates 24 bytes (32 bytes with SEQ_MIDI_OUT_SCHEDULER 1)
 // MAX_EVENTS must be a power of two! (e.g. 64, 128, 256, 512, ...)
 #ifndef SEQ_MIDI_OUT_MAX_EVENTS
 #define SEQ_MIDI_OUT_MAX_EVENTS 128
@@ -51,6 +51,25 @@ extern "C" {
 #define SEQ_MIDI_OUT_SUPPORT_DELAY 0
 #endif
 
+// scheduler method:
+// 0: sorted linked list (insert has to search through the whole queue, re-schedule
+//    only through the events of the given tag)
+// 1: hierarchical timing wheel (insert, re-schedule and dispatch in constant time)
+#ifndef SEQ_MIDI_OUT_SCHEDULER
+#define SEQ_MIDI_OUT_SCHEDULER 0
+#endif
+
+// timing wheel dimension (only relevant for SEQ_MIDI_OUT_SCHEDULER 1)
+// each of the two wheel levels consists of (1 << SEQ_MIDI_OUT_WHEEL_BITS) slots.
+// The first level stores one tick per slot, the second level one block of
+// (1 << SEQ_MIDI_OUT_WHEEL_BITS) ticks per slot. Events which are scheduled
+// later (e.g. sustained notes) are stored in an overflow list.
+// each slot allocates 24 bytes, each event 8 additional bytes for the
+// wheel lists
+#ifndef SEQ_MIDI_OUT_WHEEL_BITS
+#define SEQ_MIDI_OUT_WHEEL_BITS 6
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -79,6 +98,7 @@ extern s32 SEQ_MIDI_OUT_Callback_BPM_Set_Set(void *_callback_bpm_set);
 
 extern s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len);
 extern s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter);
+extern s32 SEQ_MIDI_OUT_ReScheduleTags(u16 tag_mask, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter);
 extern s32 SEQ_MIDI_OUT_FlushQueue(void);
 extern s32 SEQ_MIDI_OUT_FreeHeap(void);
 extern s32 SEQ_MIDI_OUT_Handler(void);
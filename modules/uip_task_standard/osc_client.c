@@ -21,6 +21,7 @@
 
 #if !defined(MIOS32_FAMILY_EMULATION)
 #include "uip.h"
+#include "uip_task.h"
 #endif
 #include "osc_server.h"
 #include "osc_client.h"
@@ -37,6 +38,19 @@
 #endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+// the bundle buffer is accessed by the sending task and the uIP task
+/////////////////////////////////////////////////////////////////////////////
+
+#if !defined(MIOS32_FAMILY_EMULATION)
+# define MUTEX_BUNDLE_TAKE MUTEX_UIP_TAKE
+# define MUTEX_BUNDLE_GIVE MUTEX_UIP_GIVE
+#else
+# define MUTEX_BUNDLE_TAKE {}
+# define MUTEX_BUNDLE_GIVE {}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Transfer mode names
 // must be aligned with definitions in osc_client.h!!!
@@ -71,6 +85,11 @@ static u16 osc_transfer_mode[OSC_CLIENT_NUM_PORTS];
 static u8 sysex_buffer[OSC_CLIENT_NUM_PORTS][OSC_CLIENT_SYSEX_BUFFER_SIZE];
 static u8 sysex_buffer_len[OSC_CLIENT_NUM_PORTS];
 
+// bundle buffer: collects the messages which are sent within 1 mS
+static u8 osc_bundle_mode[OSC_CLIENT_NUM_PORTS];
+static u8 bundle_buffer[OSC_CLIENT_NUM_PORTS][OSC_CLIENT_BUNDLE_BUFFER_SIZE];
+static u16 bundle_buffer_len[OSC_CLIENT_NUM_PORTS];
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialize the OSC client
@@ -82,12 +101,127 @@ s32 OSC_CLIENT_Init(u32 mode)
   for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i) {
     osc_transfer_mode[i] = OSC_CLIENT_TRANSFER_MODE_MIDI;
     sysex_buffer_len[i] = 0;
+    osc_bundle_mode[i] = OSC_CLIENT_BUNDLE_MODE_DEFAULT;
+    bundle_buffer_len[i] = 0;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Bundle Mode Set/Get functions
+// If enabled, all messages which are sent to the OSC port within 1 mS are
+// collected and sent as a single #bundle datagram by OSC_CLIENT_Periodic_mS()
+// Note: OSC_CLIENT_Periodic_mS() is called by the uIP task, an emulation
+// has to call it by itself!
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleModeSet(u8 osc_port, u8 enable)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid connection
+
+  // send pending messages before the mode is changed
+  OSC_CLIENT_BundleFlush(osc_port);
+
+  osc_bundle_mode[osc_port] = enable;
+  return 0;
+}
+
+u8 OSC_CLIENT_BundleModeGet(u8 osc_port)
+{
+  return osc_bundle_mode[osc_port];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends the messages which have been collected in the bundle buffer
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleFlush(u8 osc_port)
+{
+  s32 status = 0;
+
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid connection
+
+  if( !bundle_buffer_len[osc_port] )
+    return 0; // nothing to send
+
+  MUTEX_BUNDLE_TAKE;
+
+  if( bundle_buffer_len[osc_port] ) {
+    status = OSC_SERVER_SendPacket(osc_port, bundle_buffer[osc_port], bundle_buffer_len[osc_port]);
+    bundle_buffer_len[osc_port] = 0;
   }
 
+  MUTEX_BUNDLE_GIVE;
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Should be called each mS to send the collected bundles
+// (done by UIP_TASK_Handler())
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_Periodic_mS(void)
+{
+  int i;
+
+  for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i)
+    OSC_CLIENT_BundleFlush(i);
+
   return 0; // no error
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Sends a message immediately, or adds it to the bundle buffer
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_SendMessage(u8 osc_port, u8 *message, u32 len)
+{
+  if( !osc_bundle_mode[osc_port] || len == 0 )
+    return OSC_SERVER_SendPacket(osc_port, message, len);
+
+  // "#bundle" + timetag + size of the bundle element
+  const u32 header_len = 8 + 8;
+
+  if( (header_len + 4 + len) > OSC_CLIENT_BUNDLE_BUFFER_SIZE )
+    return OSC_SERVER_SendPacket(osc_port, message, len); // message too long for a bundle
+
+  s32 status = 0;
+
+  MUTEX_BUNDLE_TAKE;
+
+  u8 *buffer = bundle_buffer[osc_port];
+  u16 *buffer_len = &bundle_buffer_len[osc_port];
+
+  // no free space anymore: send the bundle which has been collected so far
+  if( *buffer_len && (*buffer_len + 4 + len) > OSC_CLIENT_BUNDLE_BUFFER_SIZE )
+    status = OSC_CLIENT_BundleFlush(osc_port);
+
+  u8 *end_ptr = &buffer[*buffer_len];
+  if( *buffer_len == 0 ) {
+    // timetag 1 ("immediately"): the messages are already due
+    mios32_osc_timetag_t timetag;
+    timetag.seconds = 0;
+    timetag.fraction = 1;
+    end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
+    end_ptr = MIOS32_OSC_PutTimetag(end_ptr, timetag);
+  }
+
+  end_ptr = MIOS32_OSC_PutWord(end_ptr, len);
+  memcpy(end_ptr, message, len);
+  end_ptr += len;
+
+  *buffer_len = (u16)(end_ptr - buffer);
+
+  MUTEX_BUNDLE_GIVE;
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Transfer Mode Set/Get functions
 /////////////////////////////////////////////////////////////////////////////
@@ -403,7 +537,7 @@ s32 OSC_CLIENT_SendMIDIEvent(u8 osc_port, mios32_midi_package_t package)
   }
 
   // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  return OSC_CLIENT_SendMessage(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -485,7 +619,7 @@ s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nrpn_valu
   }
 
   // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  return OSC_CLIENT_SendMessage(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -522,7 +656,7 @@ s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count)
     end_ptr = MIOS32_OSC_PutString(end_ptr, ",b");
     end_ptr = MIOS32_OSC_PutBlob(end_ptr, (u8 *)&stream[send_offset], bytes_to_send);
 
-    OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+    OSC_CLIENT_SendMessage(osc_port, packet, (u32)(end_ptr-packet));
 
     send_offset += bytes_to_send;
   };
@@ -552,6 +686,9 @@ s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 nu
   u8 *insert_len_ptr;
   int i;
 
+  // keep the order of messages which are waiting in the bundle buffer
+  OSC_CLIENT_BundleFlush(osc_port);
+
   end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
   end_ptr = MIOS32_OSC_PutTimetag(end_ptr, timetag);
   for(i=0; i<num_events; ++i) {
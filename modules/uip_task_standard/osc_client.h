@@ -24,6 +24,18 @@ extern "C" {
 
 #define OSC_CLIENT_NUM_PORTS 4
 
+// default bundle mode of all OSC ports (see OSC_CLIENT_BundleModeSet())
+// can be changed from mios32_config.h
+#ifndef OSC_CLIENT_BUNDLE_MODE_DEFAULT
+#define OSC_CLIENT_BUNDLE_MODE_DEFAULT 0
+#endif
+
+// size of the bundle buffer of each OSC port
+// must not exceed the UDP payload which can be sent by uIP (1472 bytes with UIP_CONF_BUFFER_SIZE 1518)
+#ifndef OSC_CLIENT_BUNDLE_BUFFER_SIZE
+#define OSC_CLIENT_BUNDLE_BUFFER_SIZE 512
+#endif
+
 
 // transfer modes
 // keep OSC_CLIENT_TransferModeFullNameGet() and OSC_CLIENT_TransferModeShortNameGet() aligned with the assignments!
@@ -53,6 +65,11 @@ extern u8 OSC_CLIENT_TransferModeGet(u8 osc_port);
 extern const char* OSC_CLIENT_TransferModeFullNameGet(u8 mode);
 extern const char* OSC_CLIENT_TransferModeShortNameGet(u8 mode);
 
+extern s32 OSC_CLIENT_BundleModeSet(u8 osc_port, u8 enable);
+extern u8 OSC_CLIENT_BundleModeGet(u8 osc_port);
+extern s32 OSC_CLIENT_BundleFlush(u8 osc_port);
+extern s32 OSC_CLIENT_Periodic_mS(void);
+
 extern s32 OSC_CLIENT_SendMIDIEvent(u8 osc_port, mios32_midi_package_t p);
 extern s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nrpn_value);
 extern s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count);
@@ -123,6 +123,9 @@ s32 OSC_SERVER_Init(u32 mode)
   ESP8266_UdpRxCallback_Init(OSC_SERVER_ESP8266_NotifyUdpPacket); // hook to notify received UDP packets
 #endif
 
+  // compile the search tree (only done if MIOS32_OSC_COMPILED_LEVELS is enabled, and only once)
+  MIOS32_OSC_CompileSearchTree(parse_root);
+
   return 0; // no error
 }
 
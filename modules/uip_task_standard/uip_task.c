@@ -265,6 +265,9 @@ static void UIP_TASK_Handler(void *pvParameters)
     // release exclusive access to UIP functions
     MUTEX_UIP_GIVE;
 
+    // send OSC messages which have been bundled during the last mS
+    OSC_CLIENT_Periodic_mS();
+
 #if OSC_SERVER_ESP8266_ENABLED
     // ESP8266 handling
     ESP8266_Periodic_mS();
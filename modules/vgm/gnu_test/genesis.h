@@ -0,0 +1,21 @@
+/* $Id$ */
+/*
+ * Replaces genesis.h for the host test of the VGM player.
+ * The chip writes go to the fake bus of vgm_test.c, which checks the
+ * busy times of the chips.
+ */
+
+#ifndef _GENESIS_H
+#define _GENESIS_H
+
+#include <mios32.h>
+
+#ifndef GENESIS_COUNT
+#define GENESIS_COUNT 2
+#endif
+
+extern void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data);
+extern void Genesis_PSGWrite(u8 board, u8 data);
+extern void Genesis_CaptureOPN2OpStates(u8 board);
+
+#endif /* _GENESIS_H */
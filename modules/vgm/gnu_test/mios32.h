@@ -0,0 +1,61 @@
+/* $Id$ */
+/*
+ * Replaces mios32.h for the host test of the VGM player.
+ * Only the data types and the timer/IRQ/LED definitions used by
+ * vgmplayer.c are included. The timers are plain structs which are
+ * clocked by the test.
+ */
+
+#ifndef _MIOS32_H
+#define _MIOS32_H
+
+#include <stddef.h>
+#include <mios32_datatypes.h>
+
+typedef struct {
+  vu32 CNT;
+  vu32 ARR;
+} TIM_TypeDef;
+
+extern TIM_TypeDef fake_tim2;
+extern TIM_TypeDef fake_tim3;
+extern TIM_TypeDef fake_tim5;
+
+#define TIM2 (&fake_tim2)
+#define TIM3 (&fake_tim3)
+#define TIM5 (&fake_tim5)
+
+typedef struct {
+  u16 TIM_Prescaler;
+  u16 TIM_CounterMode;
+  u32 TIM_Period;
+  u16 TIM_ClockDivision;
+} TIM_TimeBaseInitTypeDef;
+
+#define RESET   0
+#define SET     1
+#define DISABLE 0
+#define ENABLE  1
+
+#define TIM_IT_Update        0x0001
+#define TIM_CounterMode_Up   0x0000
+#define RCC_APB1Periph_TIM2  0x00000001
+#define RCC_APB1Periph_TIM3  0x00000002
+#define RCC_APB1Periph_TIM5  0x00000008
+#define TIM3_IRQn            29
+#define MIOS32_IRQ_PRIO_INSANE 1
+
+extern u32 TIM_GetITStatus(TIM_TypeDef* TIMx, u16 TIM_IT);
+extern void TIM_ClearITPendingBit(TIM_TypeDef* TIMx, u16 TIM_IT);
+extern void TIM_Cmd(TIM_TypeDef* TIMx, u32 NewState);
+extern void TIM_ITConfig(TIM_TypeDef* TIMx, u16 TIM_IT, u32 NewState);
+extern void TIM_TimeBaseInit(TIM_TypeDef* TIMx, TIM_TimeBaseInitTypeDef* TIM_TimeBaseInitStruct);
+extern void TIM_ARRPreloadConfig(TIM_TypeDef* TIMx, u32 NewState);
+extern void RCC_APB1PeriphClockCmd(u32 RCC_APB1Periph, u32 NewState);
+
+extern s32 MIOS32_IRQ_Install(u8 IRQn, u8 priority);
+
+extern s32 MIOS32_BOARD_LED_Set(u32 leds, u32 value);
+extern u32 MIOS32_BOARD_LED_Get(void);
+
+#endif /* _MIOS32_H */
@@ -0,0 +1,491 @@
+// $Id$
+/*
+ * Host replay test of the VGM player
+ *
+ * vgmplayer.c is compiled against replacements of mios32.h and genesis.h.
+ * The timers are clocked by the test: TIM3_IRQHandler() is called like by
+ * the work timer, and the time is advanced by the delay which the player
+ * programmed into TIM3->ARR. Each chip write takes some bus time.
+ *
+ * The heads replay scripts of chip writes and waits (VGM_Head_cmdNext() is
+ * provided by the test). The fake Genesis bus checks that
+ *   - no OPN2 or PSG is written while it's still busy from the previous write
+ *   - each write belongs to the command which is advanced next, i.e. the
+ *     writes of a head are done in script order, invalid commands are
+ *     skipped without a bus access, and stopped heads don't write
+ *   - no write is done before its wait has elapsed, and writes are not
+ *     delayed by more than a few samples in normal load
+ *   - a burst of writes of all heads keeps the chips busy without gaps
+ *   - operator states are only captured while the chip is not busy
+ * TIM2 starts shortly before its wraparound, so that the busy checks are
+ * also done across the wraparound.
+ *
+ * Usage: vgm_test [-v]
+ *   -v: print each bus write
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mios32.h>
+#include <genesis.h>
+#include "vgmplayer.h"
+#include "vgmhead.h"
+#include "vgmperfmon.h"
+
+extern void TIM3_IRQHandler(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Timers
+/////////////////////////////////////////////////////////////////////////////
+
+// TIM2 wraps around after ~150 samples
+#define HR_START (0xffffffffu - 300000u)
+
+TIM_TypeDef fake_tim2;
+TIM_TypeDef fake_tim3;
+TIM_TypeDef fake_tim5;
+
+static unsigned long long hr_elapsed;
+
+static void advanceTime(u32 hr_ticks)
+{
+  hr_elapsed += hr_ticks;
+  TIM2->CNT = HR_START + (u32)hr_elapsed;
+  TIM5->CNT = (u32)(hr_elapsed / VGMP_HRTICKSPERSAMPLE);
+}
+
+u32 TIM_GetITStatus(TIM_TypeDef* TIMx, u16 TIM_IT) { return SET; }
+void TIM_ClearITPendingBit(TIM_TypeDef* TIMx, u16 TIM_IT) {}
+void TIM_Cmd(TIM_TypeDef* TIMx, u32 NewState) {}
+void TIM_ITConfig(TIM_TypeDef* TIMx, u16 TIM_IT, u32 NewState) {}
+void TIM_TimeBaseInit(TIM_TypeDef* TIMx, TIM_TimeBaseInitTypeDef* TIM_TimeBaseInitStruct) {}
+void TIM_ARRPreloadConfig(TIM_TypeDef* TIMx, u32 NewState) {}
+void RCC_APB1PeriphClockCmd(u32 RCC_APB1Periph, u32 NewState) {}
+s32 MIOS32_IRQ_Install(u8 IRQn, u8 priority) { return 0; }
+
+static u32 leds;
+s32 MIOS32_BOARD_LED_Set(u32 mask, u32 value) { leds = (leds & ~mask) | (value & mask); return 0; }
+u32 MIOS32_BOARD_LED_Get(void) { return leds; }
+
+void VGM_PerfMon_ClockIn(u8 task) {}
+void VGM_PerfMon_ClockOut(u8 task) {}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Fake Genesis bus
+/////////////////////////////////////////////////////////////////////////////
+
+// hr_ticks which a write or an operator state capture occupies the bus
+#define BUS_WRITE_TICKS   42
+#define BUS_CAPTURE_TICKS 1500
+
+typedef struct {
+  unsigned long long opn2_ready;
+  unsigned long long psg_ready;
+  unsigned long long opn2_busy_ticks;
+} fake_chip_t;
+
+static fake_chip_t chips[GENESIS_COUNT];
+
+static VgmChipWriteCmd last_write;
+static unsigned long long last_write_time;   // hr_ticks at which the last write started
+static unsigned long long last_write_ready;  // hr_ticks at which the chip got ready for it
+static u32 num_writes;
+static u32 num_captures;
+static int num_errors;
+static int verbose;
+
+static void error(const char *msg)
+{
+  if( num_errors < 10 )
+    printf("  ERROR at sample %u: %s\n", (unsigned)TIM5->CNT, msg);
+  ++num_errors;
+}
+
+void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data)
+{
+  if( board >= GENESIS_COUNT ) {
+    error("OPN2 write to invalid board");
+    return;
+  }
+  if( hr_elapsed < chips[board].opn2_ready )
+    error("OPN2 written while busy");
+  last_write_time = hr_elapsed;
+  last_write_ready = chips[board].opn2_ready;
+  advanceTime(BUS_WRITE_TICKS);
+
+  // the chip doesn't need a delay after the 0x2x registers, except for key on/off
+  u32 busy = (address >= 0x20 && address < 0x2f && address != 0x28) ? 0 : VGMP_OPN2BUSYDELAY;
+  chips[board].opn2_ready = hr_elapsed + busy;
+  chips[board].opn2_busy_ticks += BUS_WRITE_TICKS + busy;
+
+  last_write.cmd = (board << 4) | 0x02 | (addrhi & 1);
+  last_write.addr = address;
+  last_write.data = data;
+  ++num_writes;
+
+  if( verbose )
+    printf("  %6u: OPN2 %d port %d [%02x] = %02x\n", (unsigned)TIM5->CNT, board, addrhi & 1, address, data);
+}
+
+void Genesis_PSGWrite(u8 board, u8 data)
+{
+  if( board >= GENESIS_COUNT ) {
+    error("PSG write to invalid board");
+    return;
+  }
+  if( hr_elapsed < chips[board].psg_ready )
+    error("PSG written while busy");
+  last_write_time = hr_elapsed;
+  last_write_ready = chips[board].psg_ready;
+  advanceTime(BUS_WRITE_TICKS);
+  chips[board].psg_ready = hr_elapsed + VGMP_PSGBUSYDELAY;
+
+  last_write.cmd = (board << 4);
+  last_write.addr = 0;
+  last_write.data = data;
+  ++num_writes;
+
+  if( verbose )
+    printf("  %6u: PSG  %d %02x\n", (unsigned)TIM5->CNT, board, data);
+}
+
+void Genesis_CaptureOPN2OpStates(u8 board)
+{
+  if( board >= GENESIS_COUNT ) {
+    error("capture of invalid board");
+    return;
+  }
+  if( hr_elapsed < chips[board].opn2_ready )
+    error("OPN2 operator states captured while busy");
+  advanceTime(BUS_CAPTURE_TICKS);
+  ++num_captures;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Scripted heads
+/////////////////////////////////////////////////////////////////////////////
+
+#define MAX_SCRIPT 512
+
+typedef struct {
+  u32 wait;              // >0: wait for the given number of samples, 0: chip write
+  VgmChipWriteCmd cmd;
+} script_cmd_t;
+
+typedef struct {
+  script_cmd_t cmds[MAX_SCRIPT];
+  u32 num_cmds;
+  s32 pos;
+  unsigned long long last_done; // hr_ticks at which the previous command has been completed
+} script_t;
+
+VgmHead* vgm_heads[VGM_HEAD_MAXNUM];
+u32 vgm_numheads;
+
+static VgmHead heads[VGM_HEAD_MAXNUM];
+static script_t scripts[VGM_HEAD_MAXNUM];
+
+static u32 writes_checked;
+static u32 max_idle;
+
+static u32 random_seed = 12345;
+
+static u32 randomValue(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return (random_seed >> 16) % range;
+}
+
+static void addWait(u8 h, u32 samples)
+{
+  script_t *s = &scripts[h];
+  s->cmds[s->num_cmds].wait = samples;
+  s->cmds[s->num_cmds].cmd.all = 0;
+  ++s->num_cmds;
+}
+
+static void addWrite(u8 h, u8 cmd, u8 addr, u8 data)
+{
+  script_t *s = &scripts[h];
+  s->cmds[s->num_cmds].wait = 0;
+  s->cmds[s->num_cmds].cmd.all = 0;
+  s->cmds[s->num_cmds].cmd.cmd = cmd;
+  s->cmds[s->num_cmds].cmd.addr = addr;
+  s->cmds[s->num_cmds].cmd.data = data;
+  ++s->num_cmds;
+}
+
+static u8 isValidWrite(VgmChipWriteCmd cmd)
+{
+  u8 chip = cmd.cmd >> 4;
+  u8 subcmd = cmd.cmd & 0x0f;
+  return chip < GENESIS_COUNT && (subcmd == 0 || subcmd == 2 || subcmd == 3);
+}
+
+// Replaces the VGM_Head_cmdNext() of vgmhead.c: checks the bus writes which
+// have been done for the current command, and loads the next one
+void VGM_Head_cmdNext(VgmHead* head, u32 vgm_time)
+{
+  script_t *s = (script_t *)head->data;
+
+  if( !head->playing )
+    error("command of a stopped head advanced");
+
+  if( head->iswrite && !head->isdone ) {
+    VgmChipWriteCmd cmd = s->cmds[s->pos].cmd;
+    if( isValidWrite(cmd) ) {
+      if( num_writes != writes_checked + 1 ) {
+        error("missing or additional bus write");
+      } else {
+        if( (cmd.cmd & 0x0f) == 0 ) {
+          cmd.addr = 0;
+        }
+        if( last_write.cmd != cmd.cmd || last_write.addr != cmd.addr || last_write.data != cmd.data )
+          error("bus write doesn't match the command of the head");
+      }
+      if( (s32)(TIM5->CNT - head->ticks) < 0 ) {
+        error("chip written before the wait has elapsed");
+      } else {
+        // time for which the write could have been done already: neither the
+        // head was waiting, nor the chip was busy
+        unsigned long long possible = (unsigned long long)head->ticks * VGMP_HRTICKSPERSAMPLE;
+        if( possible < s->last_done )
+          possible = s->last_done;
+        if( possible < last_write_ready )
+          possible = last_write_ready;
+        if( last_write_time > possible && last_write_time - possible > max_idle )
+          max_idle = last_write_time - possible;
+      }
+    } else if( num_writes != writes_checked ) {
+      error("invalid command has been written to the bus");
+    }
+  } else if( num_writes != writes_checked ) {
+    error("bus write without a chip write command");
+  }
+  writes_checked = num_writes;
+  s->last_done = hr_elapsed;
+
+  ++s->pos;
+  if( s->pos >= s->num_cmds ) {
+    head->isdone = 1;
+    head->iswait = 0;
+    head->iswrite = 0;
+  } else if( s->cmds[s->pos].wait ) {
+    head->iswait = 1;
+    head->iswrite = 0;
+    head->ticks += s->cmds[s->pos].wait;
+  } else {
+    head->iswait = 0;
+    head->iswrite = 1;
+    head->writecmd = s->cmds[s->pos].cmd;
+  }
+}
+
+static void resetTest(u8 num_heads)
+{
+  int h;
+
+  memset(heads, 0, sizeof(heads));
+  memset(scripts, 0, sizeof(scripts));
+  memset(vgm_heads, 0, sizeof(vgm_heads));
+  for(h=0; h<num_heads; ++h) {
+    vgm_heads[h] = &heads[h];
+    heads[h].data = &scripts[h];
+  }
+  vgm_numheads = num_heads;
+
+  max_idle = 0;
+  num_captures = 0;
+  num_errors = 0;
+  VGM_Player_docapture = 0;
+  for(h=0; h<GENESIS_COUNT; ++h)
+    chips[h].opn2_busy_ticks = 0;
+}
+
+// like VGM_Head_Restart()
+static void startHead(u8 h)
+{
+  heads[h].ticks = TIM5->CNT;
+  heads[h].iswait = 1;
+  heads[h].iswrite = 0;
+  heads[h].isdone = 0;
+  heads[h].playing = 1;
+  scripts[h].pos = -1;
+  scripts[h].last_done = hr_elapsed;
+}
+
+static u8 allDone(void)
+{
+  int h;
+  for(h=0; h<vgm_numheads; ++h) {
+    if( !heads[h].isdone )
+      return 0;
+  }
+  return 1;
+}
+
+// calls the work timer interrupt until all heads are done, or until the given sample
+static void run(u32 until_sample)
+{
+  while( !allDone() && (s32)(TIM5->CNT - until_sample) < 0 ) {
+    TIM3_IRQHandler();
+    advanceTime(TIM3->ARR);
+  }
+}
+
+static int checkResult(const char *name)
+{
+  int h;
+  for(h=0; h<vgm_numheads; ++h) {
+    if( !heads[h].isdone ) {
+      error("head hasn't finished its script");
+      break;
+    }
+  }
+  printf("%-40s %5u writes, max. %5u hr_ticks idle: %s\n", name, (unsigned)num_writes, (unsigned)max_idle, num_errors ? "FAILED" : "ok");
+  return num_errors ? 1 : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test cases
+/////////////////////////////////////////////////////////////////////////////
+
+// A few heads which play on both chips with short waits, like in a song
+static int testSparse(void)
+{
+  int h, i;
+
+  resetTest(4);
+  for(h=0; h<4; ++h) {
+    u8 chip = (h & 1) << 4;
+    for(i=0; i<100; ++i) {
+      switch( randomValue(4) ) {
+      case 0: addWrite(h, chip | 0x00, 0, 0x80 | randomValue(0x80)); break;
+      case 1: addWrite(h, chip | 0x02, 0x30 + randomValue(0x80), randomValue(0x100)); break;
+      case 2: addWrite(h, chip | 0x03, 0xa0 + randomValue(0x10), randomValue(0x100)); break;
+      case 3: addWrite(h, chip | 0x02, 0x28, randomValue(0x100)); break;
+      }
+      if( randomValue(3) == 0 )
+        addWait(h, 1 + randomValue(30));
+    }
+    startHead(h);
+  }
+  VGM_Player_docapture = 1;
+  run(TIM5->CNT + 10000);
+
+  if( num_captures == 0 )
+    error("no operator states have been captured");
+  // the end of a wait is only known with sample resolution, and a capture may delay a write
+  if( max_idle > VGMP_HRTICKSPERSAMPLE + BUS_CAPTURE_TICKS )
+    error("chip idle although a write was pending");
+
+  return checkResult("sparse writes with capture");
+}
+
+// All heads write a burst to the same two chips at the same time: the
+// writes have to follow each other without gaps
+static int testBurst(void)
+{
+  int h, i;
+  u32 start_sample;
+  unsigned long long start_ticks;
+
+  resetTest(VGM_HEAD_MAXNUM);
+  for(h=0; h<VGM_HEAD_MAXNUM; ++h) {
+    u8 chip = (h & 1) << 4;
+    for(i=0; i<8; ++i) {
+      addWrite(h, chip | 0x02 | (i & 1), 0x30 + h, i);
+    }
+    addWrite(h, chip | 0x02, 0x22, h);
+    addWrite(h, chip | 0x00, 0, 0x90 | (h & 0x0f));
+    startHead(h);
+  }
+  start_ticks = hr_elapsed;
+  start_sample = TIM5->CNT;
+  run(start_sample + 10000);
+
+  for(h=0; h<GENESIS_COUNT; ++h) {
+    // allow one work timer period per write for the head switching
+    if( hr_elapsed - start_ticks > chips[h].opn2_busy_ticks * 105 / 100 + VGMP_MAXDELAY ) {
+      error("the chips have been idle during the burst");
+      printf("  chip %d: busy for %llu of %llu hr_ticks\n", h, chips[h].opn2_busy_ticks, hr_elapsed - start_ticks);
+    }
+  }
+
+  // the next write is due as soon as the chip is ready again
+  if( max_idle > 2*BUS_WRITE_TICKS )
+    error("chip idle although a write was pending");
+
+  return checkResult("burst of all heads");
+}
+
+// Invalid commands are skipped, and stopped heads don't write
+static int testInvalidAndStopped(void)
+{
+  int h, i;
+  u32 stop_sample;
+
+  resetTest(8);
+  for(h=0; h<8; ++h) {
+    u8 chip = (h & 1) << 4;
+    for(i=0; i<40; ++i) {
+      addWrite(h, chip | 0x02, 0x40 + h, i);
+      if( (i % 5) == h % 5 ) {
+        addWrite(h, 0x72, 0x40, i); // board doesn't exist
+        addWrite(h, chip | 0x01, 0x40, i); // invalid subcommand
+      }
+      addWait(h, 2);
+    }
+    startHead(h);
+  }
+
+  run(TIM5->CNT + 20);
+  heads[3].playing = 0;
+  stop_sample = TIM5->CNT + 30;
+  run(stop_sample);
+  heads[3].playing = 1;
+  run(TIM5->CNT + 10000);
+
+  return checkResult("invalid commands and stopped head");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  int failed = 0;
+
+  if( argc > 1 && strcmp(argv[1], "-v") == 0 )
+    verbose = 1;
+
+  advanceTime(0);
+  VGM_Player_Init();
+
+  failed += testSparse();
+  failed += testBurst();
+  failed += testInvalidAndStopped();
+
+  if( failed ) {
+    printf("%d test(s) failed\n", failed);
+    return 1;
+  }
+
+  printf("All tests passed\n");
+  return 0;
+}
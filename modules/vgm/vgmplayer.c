@@ -18,15 +18,68 @@
 
 
 typedef struct {
-    u32 opn2_lastwritetime;
-    u32 psg_lastwritetime;
+    u32 opn2_busyuntil;
+    u32 psg_busyuntil;
 } vgmp_chipdata;
 
+typedef struct {
+    VgmHead* head;
+    u32 due; //hr_time at which the pending chip write can be done
+} vgmp_sched;
+
 static vgmp_chipdata chipdata[GENESIS_COUNT];
 u8 VGM_Player_docapture;
 static u8 nextchiptocapture;
 static u32 lasttimecaptured;
 
+//Min-heap of the heads which have a chip write pending, ordered by due time.
+//It's rebuilt in each work callback, since heads are started, stopped and
+//restarted by the application without notifying the player.
+static vgmp_sched sched[VGM_HEAD_MAXNUM];
+static u8 schedsize;
+
+//Remaining hr_ticks until the chip is ready again (0 if it's not busy).
+//busyuntil is at most maxdelay ahead, everything else is in the past, so
+//this also works across timer wraparound.
+static inline u32 VgmPlayer_BusyRemaining(u32 busyuntil, u32 hr_time, u32 maxdelay){
+    u32 u = busyuntil - hr_time;
+    return (u <= maxdelay) ? u : 0;
+}
+
+//Returns the hr_time at which the chip write of the head can be done
+static u32 VgmPlayer_GetWriteDue(VgmHead* h, u32 hr_time){
+    u8 chip = (h->writecmd.cmd >> 4);
+    u8 subcmd = (h->writecmd.cmd & 0x0F);
+    if(chip >= GENESIS_COUNT || subcmd > 4 || subcmd == 1){
+        //Invalid command, will just be skipped
+        return hr_time;
+    }else if(subcmd == 0){
+        return hr_time + VgmPlayer_BusyRemaining(chipdata[chip].psg_busyuntil, hr_time, VGMP_PSGBUSYDELAY);
+    }else{
+        return hr_time + VgmPlayer_BusyRemaining(chipdata[chip].opn2_busyuntil, hr_time, VGMP_OPN2BUSYDELAY);
+    }
+}
+
+static void VgmPlayer_SchedSiftDown(u8 i){
+    vgmp_sched e = sched[i];
+    u8 c;
+    while((c = (i << 1) + 1) < schedsize){
+        if(c+1 < schedsize && (s32)(sched[c+1].due - sched[c].due) < 0) ++c;
+        if((s32)(sched[c].due - e.due) >= 0) break;
+        sched[i] = sched[c];
+        i = c;
+    }
+    sched[i] = e;
+}
+
+//Removes the first element of the heap
+static void VgmPlayer_SchedPop(){
+    --schedsize;
+    if(schedsize == 0) return;
+    sched[0] = sched[schedsize];
+    VgmPlayer_SchedSiftDown(0);
+}
+
 u16 VgmPlayer_WorkCallback(){
     ////////////////////////////////////////////////////////////////////////
     // PLAY VGMS
@@ -36,10 +89,12 @@ u16 VgmPlayer_WorkCallback(){
     VgmHead* h;
     u32 minwait = 0xFFFFFFFF; s32 s; u32 u;
     u32 vgm_time = TIM5->CNT;
+    u32 hr_time = TIM2->CNT;
     VgmChipWriteCmd cmd;
-    u8 wrotetochip, chip, subcmd;
-    //Scan all VGMs for delays
+    u8 chip, subcmd;
+    //Scan all VGMs for delays, collect pending chip write commands
     u8 i;
+    schedsize = 0;
     for(i=0; i<vgm_numheads; ++i){
         h = vgm_heads[i];
         if(h != NULL && h->playing){
@@ -57,59 +112,73 @@ u16 VgmPlayer_WorkCallback(){
                     }
                 }
             }
+            //Check for command
+            if(VGM_Head_cmdIsChipWrite(h)){
+                sched[schedsize].head = h;
+                sched[schedsize].due = VgmPlayer_GetWriteDue(h, hr_time);
+                ++schedsize;
+            }
         }
     }
-    //Scan all VGMs for pending chip write commands
-    wrotetochip = 1;
-    while(wrotetochip){
-        wrotetochip = 0;
-        for(i=0; i<vgm_numheads; ++i){
-            h = vgm_heads[i];
-            if(h != NULL && h->playing){
-                //Check for command
-                if(VGM_Head_cmdIsChipWrite(h)){
-                    cmd = h->writecmd;
-                    chip = (cmd.cmd >> 4);
-                    subcmd = (cmd.cmd & 0x0F);
-                    if(chip >= GENESIS_COUNT || subcmd > 4 || subcmd == 1){
-                        VGM_Head_cmdNext(h, vgm_time);
-                        wrotetochip = 1;
-                    }else if(subcmd == 0){
-                        //PSG write
-                        u = TIM2->CNT - chipdata[chip].psg_lastwritetime;
-                        if(u < VGMP_PSGBUSYDELAY){
-                            u = VGMP_PSGBUSYDELAY - u;
-                            if(u < minwait){
-                                minwait = u;
-                            }
-                        }else{
-                            Genesis_PSGWrite(chip, cmd.data);
-                            VGM_Head_cmdNext(h, vgm_time);
-                            chipdata[chip].psg_lastwritetime = TIM2->CNT;
-                            wrotetochip = 1;
-                        }
-                    }else{
-                        //OPN2 write
-                        u = TIM2->CNT - chipdata[chip].opn2_lastwritetime;
-                        if(u < VGMP_OPN2BUSYDELAY){
-                            u = VGMP_OPN2BUSYDELAY - u;
-                            if(u < minwait){
-                                minwait = u;
-                            }
-                        }else{
-                            Genesis_OPN2Write(chip, (cmd.cmd & 0x01), cmd.addr, cmd.data);
-                            VGM_Head_cmdNext(h, vgm_time);
-                            //Don't delay after 0x2x commands
-                            if(cmd.addr >= 0x20 && cmd.addr < 0x2F && cmd.addr != 0x28){
-                                chipdata[chip].opn2_lastwritetime = TIM2->CNT - VGMP_OPN2BUSYDELAY;
-                            }else{
-                                chipdata[chip].opn2_lastwritetime = TIM2->CNT;
-                            }
-                            wrotetochip = 1;
-                        }
-                    }
+    if(schedsize > 1){
+        for(i=(schedsize >> 1); i>0; --i){
+            VgmPlayer_SchedSiftDown(i-1);
+        }
+    }
+    //Do the chip writes in the order in which they're due
+    while(schedsize){
+        hr_time = TIM2->CNT;
+        s = (s32)(sched[0].due - hr_time);
+        if(s > 0){
+            //Nothing else to do until then
+            if((u32)s < minwait){
+                minwait = s;
+            }
+            break;
+        }
+        h = sched[0].head;
+        //Other heads may have written to the same chip since the due time was
+        //computed, so check again
+        u = VgmPlayer_GetWriteDue(h, hr_time);
+        if(u != hr_time){
+            sched[0].due = u;
+            VgmPlayer_SchedSiftDown(0);
+            continue;
+        }
+        cmd = h->writecmd;
+        chip = (cmd.cmd >> 4);
+        subcmd = (cmd.cmd & 0x0F);
+        if(chip >= GENESIS_COUNT || subcmd > 4 || subcmd == 1){
+            VGM_Head_cmdNext(h, vgm_time);
+        }else if(subcmd == 0){
+            //PSG write
+            Genesis_PSGWrite(chip, cmd.data);
+            VGM_Head_cmdNext(h, vgm_time);
+            chipdata[chip].psg_busyuntil = TIM2->CNT + VGMP_PSGBUSYDELAY;
+        }else{
+            //OPN2 write
+            Genesis_OPN2Write(chip, (cmd.cmd & 0x01), cmd.addr, cmd.data);
+            VGM_Head_cmdNext(h, vgm_time);
+            //Don't delay after 0x2x commands
+            if(cmd.addr >= 0x20 && cmd.addr < 0x2F && cmd.addr != 0x28){
+                chipdata[chip].opn2_busyuntil = TIM2->CNT;
+            }else{
+                chipdata[chip].opn2_busyuntil = TIM2->CNT + VGMP_OPN2BUSYDELAY;
+            }
+        }
+        if(VGM_Head_cmdIsChipWrite(h)){
+            sched[0].due = VgmPlayer_GetWriteDue(h, TIM2->CNT);
+            VgmPlayer_SchedSiftDown(0);
+        }else{
+            //Waits are handled in the next callback
+            if(VGM_Head_cmdIsWait(h)){
+                s = VGM_Head_cmdGetWaitRemaining(h, vgm_time);
+                u = (s <= 0) ? 0 : (s * VGMP_HRTICKSPERSAMPLE);
+                if(u < minwait){
+                    minwait = u;
                 }
             }
+            VgmPlayer_SchedPop();
         }
     }
     //Set up next delay
@@ -119,7 +188,7 @@ u16 VgmPlayer_WorkCallback(){
     }else if(minwait > VGMP_MAXDELAY){
         if(VGM_Player_docapture 
                 && (TIM2->CNT - lasttimecaptured >= 30000)
-                && (TIM2->CNT - chipdata[nextchiptocapture].opn2_lastwritetime >= VGMP_OPN2BUSYDELAY)){
+                && !VgmPlayer_BusyRemaining(chipdata[nextchiptocapture].opn2_busyuntil, TIM2->CNT, VGMP_OPN2BUSYDELAY)){
             //If we have plenty of time, capture some operator states
             Genesis_CaptureOPN2OpStates(nextchiptocapture);
             lasttimecaptured = TIM2->CNT;
@@ -192,6 +261,12 @@ void VGM_Player_Init(){
     VGM_Player_docapture = 0;
     nextchiptocapture = 0;
     lasttimecaptured = TIM2->CNT;
+    //Init chip busy timelines
+    u8 i;
+    for(i=0; i<GENESIS_COUNT; ++i){
+        chipdata[i].opn2_busyuntil = TIM2->CNT;
+        chipdata[i].psg_busyuntil = TIM2->CNT;
+    }
 }
 
 
@@ -25,13 +25,18 @@
 #include <FreeRTOS.h>
 #include <task.h>
 #include <queue.h>
+#ifdef MIOS32_USE_MIDI_RX_NOTIFY
+#include <semphr.h>
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
 // External Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+#ifndef MIOS32_FAMILY_POSIX
 extern void __libc_init_array(void);  /* calls CTORS of static objects */
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -48,6 +53,33 @@ extern void __libc_init_array(void);  /* calls CTORS of static objects */
 #endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+// MIDI receive notification (enabled with MIOS32_USE_MIDI_RX_NOTIFY)
+/////////////////////////////////////////////////////////////////////////////
+
+// MIOS32_MIDI_RxNotify() is called from UART/USB/DMA IRQs which are running
+// above configMAX_SYSCALL_INTERRUPT_PRIORITY and therefore are not allowed to
+// call FreeRTOS functions. Instead, an otherwise unused IRQ is triggered, which
+// runs at MIOS32_IRQ_PRIO_LOW and gives the semaphore to the MIDI task.
+#if defined(MIOS32_USE_MIDI_RX_NOTIFY) && !defined(MIOS32_MIDI_RX_NOTIFY_IRQn)
+# if defined(MIOS32_FAMILY_STM32F10x)
+#  define MIOS32_MIDI_RX_NOTIFY_IRQn       CAN1_SCE_IRQn   // CAN not used by MIOS32
+#  define MIOS32_MIDI_RX_NOTIFY_IRQHandler CAN1_SCE_IRQHandler
+# elif defined(MIOS32_FAMILY_STM32F4xx)
+#  define MIOS32_MIDI_RX_NOTIFY_IRQn       CRYP_IRQn       // no crypto processor in STM32F407
+#  define MIOS32_MIDI_RX_NOTIFY_IRQHandler CRYP_IRQHandler
+# elif defined(MIOS32_FAMILY_LPC17xx)
+#  define MIOS32_MIDI_RX_NOTIFY_IRQn       QEI_IRQn        // quadrature encoder interface not used by MIOS32
+#  define MIOS32_MIDI_RX_NOTIFY_IRQHandler QEI_IRQHandler
+# elif defined(MIOS32_FAMILY_POSIX)
+#  define MIOS32_MIDI_RX_NOTIFY_IRQn       0               // no interrupt controller, the handler is called directly
+#  define MIOS32_MIDI_RX_NOTIFY_IRQHandler MIDI_RxNotify_Handler
+# else
+#  error "MIOS32_USE_MIDI_RX_NOTIFY: please define MIOS32_MIDI_RX_NOTIFY_IRQn and MIOS32_MIDI_RX_NOTIFY_IRQHandler for this processor family"
+# endif
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
@@ -55,11 +87,22 @@ static void TASK_Hooks(void *pvParameters);
 static void TASK_MIDI_Hooks(void *pvParameters);
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if !defined(MIOS32_DONT_USE_MIDI) && defined(MIOS32_USE_MIDI_RX_NOTIFY)
+// given whenever new MIDI data has been received, wakes up TASK_MIDI_Hooks
+static xSemaphoreHandle xMIDIRxSemaphore;
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // FreeRTOS Heap
 /////////////////////////////////////////////////////////////////////////////
 
-#if configAPPLICATION_ALLOCATED_HEAP
+// (the POSIX emulation allocates from the heap of the host)
+#if configAPPLICATION_ALLOCATED_HEAP && !defined(MIOS32_FAMILY_POSIX)
 # if defined(MIOS32_FAMILY_LPC17xx) && !defined(MIOS32_FREERTOS_HEAP_SECTION)
 #  define MIOS32_FREERTOS_HEAP_SECTION __attribute__ ((section (".bss_ahb")))
 # else
@@ -154,7 +197,10 @@ int main(void)
 #endif
 
   // call C++ constructors
+  // (POSIX emulation: already done by the C library of the host before main() is called)
+#ifndef MIOS32_FAMILY_POSIX
   __libc_init_array();
+#endif
 
   // initialize application
   APP_Init();
@@ -234,15 +280,54 @@ void vApplicationIdleHook(void)
 // MIDI events if a hook in TASK_Hooks() blocks)
 /////////////////////////////////////////////////////////////////////////////
 #if !defined(MIOS32_DONT_USE_MIDI)
+
+#ifdef MIOS32_USE_MIDI_RX_NOTIFY
+void MIOS32_MIDI_RX_NOTIFY_IRQHandler(void);
+
+// called by MIOS32_MIDI_RxNotify(), partly from high priority IRQs
+static void MIDI_RxNotify(void)
+{
+#ifdef MIOS32_FAMILY_POSIX
+  MIOS32_MIDI_RX_NOTIFY_IRQHandler();
+#else
+  NVIC_SetPendingIRQ(MIOS32_MIDI_RX_NOTIFY_IRQn);
+#endif
+}
+
+// low priority IRQ which is allowed to call FreeRTOS functions
+void MIOS32_MIDI_RX_NOTIFY_IRQHandler(void)
+{
+  portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+  xSemaphoreGiveFromISR(xMIDIRxSemaphore, &xHigherPriorityTaskWoken);
+  portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+}
+#endif
+
 static void TASK_MIDI_Hooks(void *pvParameters)
 {
   portTickType xLastExecutionTime;
 
+#ifdef MIOS32_USE_MIDI_RX_NOTIFY
+  // wake up this task whenever new MIDI data has been received
+  xMIDIRxSemaphore = xSemaphoreCreateBinary();
+  MIOS32_IRQ_Install(MIOS32_MIDI_RX_NOTIFY_IRQn, MIOS32_IRQ_PRIO_LOW);
+  MIOS32_MIDI_RxNotifyCallback_Init(MIDI_RxNotify);
+#endif
+
   // Initialise the xLastExecutionTime variable on task entry
   xLastExecutionTime = xTaskGetTickCount();
 
   while( 1 ) {
+#ifdef MIOS32_USE_MIDI_RX_NOTIFY
+    // wait for the next tick, but forward incoming MIDI packages immediately
+    while( xTaskGetTickCount() == xLastExecutionTime ) {
+      if( xSemaphoreTake(xMIDIRxSemaphore, 1 / portTICK_RATE_MS) == pdTRUE )
+	MIOS32_MIDI_Receive_Handler(APP_MIDI_NotifyPackage);
+    }
+    xLastExecutionTime += 1 / portTICK_RATE_MS;
+#else
     vTaskDelayUntil(&xLastExecutionTime, 1 / portTICK_RATE_MS);
+#endif
 
     // skip delay gap if we had to wait for more than 5 ticks to avoid 
     // unnecessary repeats until xLastExecutionTime reached xTaskGetTickCount() again
@@ -430,7 +515,9 @@ void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackT
 
 /////////////////////////////////////////////////////////////////////////////
 // _exit() for newer newlib versions
+// (not for the POSIX emulation: exit() terminates the process on the host)
 /////////////////////////////////////////////////////////////////////////////
+#ifndef MIOS32_FAMILY_POSIX
 void exit(int par)
 {
 #ifndef MIOS32_DONT_USE_LCD
@@ -457,11 +544,13 @@ void exit(int par)
 
 // see http://www.linuxquestions.org/questions/programming-9/fyi-shared-libs-and-iostream-c-331113/
 void *__dso_handle = NULL;
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Customized HardFault Handler which prints out debugging informations
 /////////////////////////////////////////////////////////////////////////////
+#ifndef MIOS32_FAMILY_POSIX
 void HardFault_Handler_c(unsigned int * hardfault_args)
 {
   // from the book: "The definiteve guide to the ARM Cortex-M3"
@@ -528,6 +617,7 @@ void HardFault_Handler(void)
   __asm("MRSNE R0, PSP");
   __asm("B HardFault_Handler_c");
 }
+#endif
 
 // used if configCHECK_FOR_STACK_OVERFLOW enabled (set to 1 or 2) in FreeRTOSConfig.h
 #if configCHECK_FOR_STACK_OVERFLOW
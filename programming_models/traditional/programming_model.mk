@@ -3,6 +3,26 @@
 
 # philetaylor - changed to use umm_malloc and added MemMang to the include dirs.
 
+ifeq ($(FAMILY),POSIX)
+# the POSIX emulation maps FreeRTOS tasks and queues to threads of the host
+# see also $(MIOS32_PATH)/mios32/POSIX/README.txt
+
+FREE_RTOS      =    $(MIOS32_PATH)/mios32/POSIX/FreeRTOS
+
+# extend include path
+C_INCLUDE += 	-I $(MIOS32_PATH)/programming_models/traditional \
+		-I $(FREE_RTOS)/Source/include \
+		-I $(FREE_RTOS)/Source/portable/GCC/POSIX
+
+# add modules to thumb sources
+# (heap and C++ runtime are provided by the C library of the host)
+THUMB_SOURCE += \
+		$(MIOS32_PATH)/programming_models/traditional/main.c \
+		$(FREE_RTOS)/Source/tasks.c \
+		$(FREE_RTOS)/Source/queue.c \
+		$(FREE_RTOS)/Source/portable/GCC/POSIX/port.c
+
+else
 # where is FreeRTOS located
 
 FREE_RTOS      =    $(MIOS32_PATH)/FreeRTOS
@@ -43,6 +63,7 @@ endif
 
 THUMB_CPP_SOURCE += $(MIOS32_PATH)/programming_models/traditional/mini_cpp.cpp \
 		    $(MIOS32_PATH)/programming_models/traditional/freertos_heap.cpp
+endif
 
 # add MIOS32 sources
 include $(MIOS32_PATH)/mios32/mios32.mk
@@ -248,14 +248,17 @@ bool HexFileLoader::loadFile(const File &inFile, String &statusMessage)
 
 
 //==============================================================================
-MidiMessage HexFileLoader::createMidiMessageForBlock(const uint8 &deviceId, const uint32 &blockAddress, bool forMios32)
+// if a sequence number is given, the MIOS32 block will be sent with the sequenced write command
+MidiMessage HexFileLoader::createMidiMessageForBlock(const uint8 &deviceId, const uint32 &blockAddress, bool forMios32, const int &sequenceNumber)
 {
     Array<uint8> dataArray;
     Array<uint8> dumpArray = hexDump[blockAddress];
     int size = 0x100;
     uint8 checksum = 0x00;
 
-    if( forMios32 )
+    if( forMios32 && sequenceNumber >= 0 )
+        dataArray = SysexHelper::createMios32SequencedWriteBlock(deviceId, sequenceNumber, blockAddress, size, checksum);
+    else if( forMios32 )
         dataArray = SysexHelper::createMios32WriteBlock(deviceId, blockAddress, size, checksum);
     else {
         uint32 miosBlockAddress = 0xffffffff; // invalid
@@ -310,3 +313,27 @@ MidiMessage HexFileLoader::createMidiMessageForBlock(const uint8 &deviceId, cons
     dataArray.add(0xf7);
     return SysexHelper::createMidiMessage(dataArray);
 }
+
+
+//==============================================================================
+// CRC32 (IEEE 802.3) of an address range like calculated by the MIOS32 bootloader
+// bytes which are not part of the hex file are expected in erased state (0xff)
+uint32 HexFileLoader::calcCrc32(const uint32 &address, const uint32 &size)
+{
+    uint32 crc = 0xffffffff;
+    std::map<uint32, Array<uint8> >::iterator it = hexDump.end();
+
+    for(uint32 offset=0; offset<size; ++offset) {
+        uint32 byteAddress = address + offset;
+        if( offset == 0 || (byteAddress & 0xff) == 0 )
+            it = hexDump.find(byteAddress & 0xffffff00);
+
+        uint8 b = (it != hexDump.end()) ? (*it).second[byteAddress & 0xff] : 0xff;
+
+        crc ^= b;
+        for(int bCounter=0; bCounter<8; ++bCounter)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+    }
+
+    return ~crc;
+}
@@ -31,7 +31,8 @@ public:
     //==============================================================================
     bool loadFile(const File &inFile, String &statusMessage);
 
-    MidiMessage createMidiMessageForBlock(const uint8 &deviceId, const uint32 &blockAddress, bool forMios32);
+    MidiMessage createMidiMessageForBlock(const uint8 &deviceId, const uint32 &blockAddress, bool forMios32, const int &sequenceNumber = -1);
+    uint32 calcCrc32(const uint32 &address, const uint32 &size);
 
     std::vector<uint32> hexDumpAddressBlocks;
 
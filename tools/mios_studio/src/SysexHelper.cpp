@@ -198,6 +198,62 @@ Array<uint8> SysexHelper::createMios32WriteBlock(const uint8 &deviceId, const ui
     return dataArray;
 }
 
+Array<uint8> SysexHelper::createMios32SequencedWriteBlock(const uint8 &deviceId, const uint8 &sequenceNumber, const uint32 &address, const uint32 &size, uint8 &checksum)
+{
+    Array<uint8> dataArray = createMios32Header(deviceId);
+    checksum = 0x00;
+    uint8 b;
+
+    dataArray.add(0x04);
+    dataArray.add(b = sequenceNumber & 0x7f); checksum += b;
+    dataArray.add(b = (address >> 25) & 0x7f); checksum += b;
+    dataArray.add(b = (address >> 18) & 0x7f); checksum += b;
+    dataArray.add(b = (address >> 11) & 0x7f); checksum += b;
+    dataArray.add(b = (address >> 4) & 0x7f); checksum += b;
+    dataArray.add(b = (size >> 25) & 0x7f); checksum += b;
+    dataArray.add(b = (size >> 18) & 0x7f); checksum += b;
+    dataArray.add(b = (size >> 11) & 0x7f); checksum += b;
+    dataArray.add(b = (size >> 4) & 0x7f); checksum += b;
+
+    return dataArray;
+}
+
+int SysexHelper::getMios32SequenceNumber(const uint8 *data, const uint32 &size)
+{
+    // F0 00 00 7E 32 <device-id> <0e/0f> <arg> <sequence-number> F7
+    return (size >= 10 && data[8] < 0x80 && data[9] == 0xf7) ? data[8] : -1;
+}
+
+
+//==============================================================================
+bool SysexHelper::isValidMios32Checksum(const uint8 *data, const uint32 &size, const int &deviceId)
+{
+    // F0 00 00 7E 32 <device-id> 03 <address: 4 bytes> <size: 4 bytes> <crc32: 5 bytes> <checksum> F7
+    if( !isValidMios32Header(data, size, deviceId) || data[6] != 0x03 || size != 22 || data[21] != 0xf7 )
+        return false;
+
+    uint8 checksum = 0x00;
+    for(int i=7; i<20; ++i)
+        checksum += data[i];
+
+    return (-(int)checksum & 0x7f) == data[20];
+}
+
+Array<uint8> SysexHelper::createMios32ChecksumRequest(const uint8 &deviceId, const uint32 &address, const uint32 &size)
+{
+    Array<uint8> dataArray = createMios32Header(deviceId);
+    dataArray.add(0x03);
+    dataArray.add((address >> 25) & 0x7f);
+    dataArray.add((address >> 18) & 0x7f);
+    dataArray.add((address >> 11) & 0x7f);
+    dataArray.add((address >> 4) & 0x7f);
+    dataArray.add((size >> 25) & 0x7f);
+    dataArray.add((size >> 18) & 0x7f);
+    dataArray.add((size >> 11) & 0x7f);
+    dataArray.add((size >> 4) & 0x7f);
+    return dataArray;
+}
+
 
 //==============================================================================
 bool SysexHelper::isValidMios8UploadRequest(const uint8 *data, const uint32 &size, const int &deviceId)
@@ -261,6 +317,7 @@ String SysexHelper::decodeMiosErrorCode(uint8 errorCode)
     case 0x0e: return "Invalid SysEx command";
     case 0x0f: return "Device ID cannot be programmed again";
     case 0x10: return "Unsupported Debug Command";
+    case 0x11: return "Block received out of sequence";
     }
 
     return "Unknown Error Code";
@@ -54,6 +54,12 @@ public:
     static Array<uint8> createMios8WriteBlock(const uint8 &deviceId, const uint32 &address, const uint8 &extension, const uint32 &size, uint8 &checksum);
     static bool isValidMios32WriteBlock(const uint8 *data, const uint32 &size, const int &deviceId);
     static Array<uint8> createMios32WriteBlock(const uint8 &deviceId, const uint32 &address, const uint32 &size, uint8 &checksum);
+    static Array<uint8> createMios32SequencedWriteBlock(const uint8 &deviceId, const uint8 &sequenceNumber, const uint32 &address, const uint32 &size, uint8 &checksum);
+    static int getMios32SequenceNumber(const uint8 *data, const uint32 &size); // of an (error) acknowledge, -1 if not available
+
+    //==============================================================================
+    static bool isValidMios32Checksum(const uint8 *data, const uint32 &size, const int &deviceId);
+    static Array<uint8> createMios32ChecksumRequest(const uint8 &deviceId, const uint32 &address, const uint32 &size);
 
     //==============================================================================
     static bool isValidMios8UploadRequest(const uint8 *data, const uint32 &size, const int &deviceId);
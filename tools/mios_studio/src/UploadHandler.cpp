@@ -26,6 +26,7 @@ UploadHandler::UploadHandler(MiosStudio *_miosStudio)
     , currentErrorCode(-1)
     , totalBlocks(0)
     , excludedBlocks(0)
+    , skippedBlocks(0)
     , runningStatus(0x00)
     , deviceId(0x00)
     , recoveredErrorsCounter(0)
@@ -330,6 +331,37 @@ void UploadHandler::handleIncomingMidiMessage(MidiInput* source, const MidiMessa
 
     }
 
+    // checksum requested by MIOS Studio?
+    if( uploadHandlerThread->mios32ChecksumRequest ) {
+        if( SysexHelper::isValidMios32Checksum(data, size, currentDeviceId) ) {
+            uploadHandlerThread->checksumAddress = (data[7] << 25) | (data[8] << 18) | (data[9] << 11) | (data[10] << 4);
+            uploadHandlerThread->checksumSize = (data[11] << 25) | (data[12] << 18) | (data[13] << 11) | (data[14] << 4);
+            uploadHandlerThread->checksumCrc = ((uint32)data[15] << 28) | (data[16] << 21) | (data[17] << 14) | (data[18] << 7) | data[19];
+            uploadHandlerThread->mios32ChecksumRequest = 0;
+            uploadHandlerThread->notify(); // wakeup run() thread
+        } else if( SysexHelper::isValidMios32Error(data, size, currentDeviceId) ) {
+            uploadHandlerThread->mios32ChecksumRequest = 0;
+            uploadHandlerThread->uploadErrorCode = data[7]; // data[7] contains error code
+            uploadHandlerThread->notify(); // wakeup run() thread
+        }
+    }
+
+    // acknowledge on sequenced write blocks? They are queued, since multiple blocks are in flight
+    if( uploadHandlerThread->mios32SequencedUploadRequest ) {
+        int sequenceNumber = SysexHelper::getMios32SequenceNumber(data, size);
+        int errorCode = -1;
+        if( SysexHelper::isValidMios32Acknowledge(data, size, currentDeviceId) )
+            errorCode = 0;
+        else if( SysexHelper::isValidMios32Error(data, size, currentDeviceId) )
+            errorCode = data[7]; // data[7] contains error code
+
+        if( sequenceNumber >= 0 && errorCode >= 0 ) {
+            const ScopedLock sl(uploadHandlerThread->sequenceAcksLock); // lock will be released at end of block
+            uploadHandlerThread->sequenceAcks.add((errorCode << 8) | sequenceNumber);
+            uploadHandlerThread->notify(); // wakeup run() thread
+        }
+    }
+
     // acknowledge on write block initiated by MIOS Studio?
     if( uploadHandlerThread->mios32UploadRequest ) {
         if( SysexHelper::isValidMios32Acknowledge(data, size, currentDeviceId) ) {
@@ -386,10 +418,16 @@ UploadHandlerThread::UploadHandlerThread(MiosStudio *_miosStudio, UploadHandler
     , mios8RebootRequest(0)
     , mios32RebootRequest(0)
     , uploadErrorCode(-1)
+    , mios32ChecksumRequest(0)
+    , checksumAddress(0)
+    , checksumSize(0)
+    , checksumCrc(0)
+    , mios32SequencedUploadRequest(0)
     , autoStartOnUploadRequest(0)
 {
     // update status variables of caller
     uploadHandler->excludedBlocks = 0;
+    uploadHandler->skippedBlocks = 0;
     uploadHandler->totalBlocks = uploadHandler->hexFileLoader.hexDumpAddressBlocks.size();
     uploadHandler->currentBlock = 0;
     uploadHandler->recoveredErrorsCounter = 0;
@@ -488,6 +526,200 @@ void UploadHandlerThread::sendMios32Query(uint8 query)
 }
 
 
+void UploadHandlerThread::sendMios32ChecksumRequest(uint32 address)
+{
+    Array<uint8> dataArray = SysexHelper::createMios32ChecksumRequest(deviceId, address, 0x100);
+    dataArray.add(0xf7);
+    MidiMessage message = SysexHelper::createMidiMessage(dataArray);
+    miosStudio->sendMidiMessage(message);
+}
+
+
+bool UploadHandlerThread::isMios32BootloaderBlock(uint32 blockAddress, bool forMios32_LPC17)
+{
+    if( forMios32_LPC17 )
+        return blockAddress >= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_LPC17_BL_START &&
+               blockAddress <= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_LPC17_BL_END;
+
+    // TODO: check for STM32
+    return blockAddress >= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_STM32_BL_START &&
+           blockAddress <= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_STM32_BL_END;
+}
+
+
+//==============================================================================
+// MIOS32 Bootloader Upload Procedure
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//
+// 1) request the checksum of the flash sector which contains the next block.
+//    The bootloader returns the sector range and its CRC32, if it matches with
+//    the hex file, all blocks of the sector are skipped.
+//    An older bootloader returns "Invalid SysEx command", in this case the function
+//    returns false and the blocks have to be uploaded one after another.
+// 2) upload the changed blocks with sequence numbers, up to MIOS32_UPLOAD_WINDOW_SIZE
+//    blocks are sent before the first one has been acknowledged. The bootloader only
+//    writes blocks in sequence order, after a timeout or an error acknowledge the
+//    upload continues with the first block which hasn't been acknowledged yet.
+//
+// errorStatusMessage is set if the upload failed
+bool UploadHandlerThread::uploadMios32Sequenced(bool forMios32_LPC17)
+{
+    HexFileLoader &hexFileLoader = uploadHandler->hexFileLoader;
+    std::vector<int> uploadBlocks; // index in hexDumpAddressBlocks
+    uint32 excludedBlocks = 0;
+    uint32 skippedBlocks = 0;
+    int maxRetries = 16;
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Step 1) compare checksums of the flash sectors
+    //////////////////////////////////////////////////////////////////////////////////////
+    for(int block=0; block<uploadHandler->totalBlocks; ) {
+        if( threadShouldExit() )
+            return true;
+
+        uint32 blockAddress = hexFileLoader.hexDumpAddressBlocks[block];
+        if( isMios32BootloaderBlock(blockAddress, forMios32_LPC17) ) {
+            ++excludedBlocks;
+            ++block;
+            continue; // skip bootloader range
+        }
+
+        int retry = 0;
+        bool validChecksum = false;
+        do {
+            uploadErrorCode = -1;
+            mios32ChecksumRequest = 1;
+            sendMios32ChecksumRequest(blockAddress);
+
+            // wait for wakeup from handleIncomingMidiMessage() - timeout after 1 second
+            wait(1000);
+
+            // note: a late reply of a previous request could be received
+            validChecksum = !mios32ChecksumRequest && uploadErrorCode < 0 &&
+                blockAddress >= checksumAddress && blockAddress < (checksumAddress + checksumSize);
+        } while( !validChecksum && uploadErrorCode != 0x0e && ++retry < maxRetries );
+
+        mios32ChecksumRequest = 0;
+
+        if( uploadErrorCode == 0x0e ) // Invalid SysEx command
+            return false; // bootloader doesn't support the sequenced upload
+
+        if( !validChecksum ) {
+            if( uploadErrorCode >= 0 ) {
+                errorStatusMessage += "Upload aborted due to error #" + String(uploadErrorCode) + ": ";
+                errorStatusMessage += SysexHelper::decodeMiosErrorCode(uploadErrorCode);
+            } else {
+                errorStatusMessage += "No response from core after " + String(maxRetries) + " retries!";
+            }
+            return true;
+        }
+
+        // take over all blocks of the sector
+        uint32 sectorAddress = checksumAddress;
+        uint32 sectorSize = checksumSize;
+        bool changed = hexFileLoader.calcCrc32(sectorAddress, sectorSize) != checksumCrc;
+        for(; block<uploadHandler->totalBlocks && hexFileLoader.hexDumpAddressBlocks[block] < (sectorAddress + sectorSize); ++block) {
+            if( changed )
+                uploadBlocks.push_back(block);
+            else
+                ++skippedBlocks;
+        }
+    }
+
+    uploadHandler->excludedBlocks = excludedBlocks;
+    uploadHandler->skippedBlocks = skippedBlocks;
+
+
+    //////////////////////////////////////////////////////////////////////////////////////
+    // Step 2) sequenced upload
+    //////////////////////////////////////////////////////////////////////////////////////
+    {
+        const ScopedLock sl(sequenceAcksLock); // lock will be released at end of block
+        sequenceAcks.clear();
+    }
+    mios32SequencedUploadRequest = 1;
+
+    int numBlocks = uploadBlocks.size();
+    int firstBlock = 0; // first block which hasn't been acknowledged yet
+    int nextBlock = 0;
+    int retry = 0;
+    bool resent = false; // set after a retry until the core acknowledges again
+    int64 timeout = Time::getCurrentTime().toMilliseconds() + 1000;
+    while( firstBlock < numBlocks ) {
+        if( threadShouldExit() )
+            return true;
+
+        for(; nextBlock < numBlocks && (nextBlock - firstBlock) < MIOS32_UPLOAD_WINDOW_SIZE; ++nextBlock) {
+            uint32 blockAddress = hexFileLoader.hexDumpAddressBlocks[uploadBlocks[nextBlock]];
+            MidiMessage message = hexFileLoader.createMidiMessageForBlock(deviceId, blockAddress, true, nextBlock & 0x7f);
+            miosStudio->sendMidiMessage(message);
+        }
+
+        Array<int> acks;
+        {
+            const ScopedLock sl(sequenceAcksLock); // lock will be released at end of block
+            acks.swapWith(sequenceAcks);
+        }
+
+        int64 now = Time::getCurrentTime().toMilliseconds();
+        if( acks.size() == 0 ) {
+            if( now < timeout ) {
+                // wait for wakeup from handleIncomingMidiMessage()
+                wait((int)(timeout - now));
+                continue;
+            }
+
+            // timeout: send the blocks again which haven't been acknowledged
+            if( ++retry >= maxRetries ) {
+                errorStatusMessage += "No response from core after " + String(maxRetries) + " retries!";
+                break;
+            }
+            ++uploadHandler->recoveredErrorsCounter;
+            nextBlock = firstBlock;
+            resent = true;
+            timeout = now + 1000;
+            continue;
+        }
+
+        for(int i=0; i<acks.size(); ++i) {
+            int errorCode = acks[i] >> 8;
+            int distance = ((acks[i] & 0x7f) - firstBlock) & 0x7f;
+
+            if( distance >= (nextBlock - firstBlock) )
+                continue; // block not in flight anymore
+
+            if( errorCode == 0 ) {
+                // the core writes in sequence order: all previous blocks have been written as well
+                firstBlock += distance + 1;
+                uploadHandler->currentBlock = uploadBlocks[firstBlock - 1];
+                retry = 0;
+                resent = false;
+                timeout = now + 1000;
+            } else if( (errorCode == 0x11) ? !resent : (distance == 0) ) {
+                // a block got lost ("out of sequence", error #0x11) or has been rejected: send it and the following blocks again
+                // further "out of sequence" replies belong to the blocks which have been sent before
+                if( ++retry >= maxRetries ) {
+                    errorStatusMessage += "Upload aborted due to error #" + String(errorCode) + ": ";
+                    errorStatusMessage += SysexHelper::decodeMiosErrorCode(errorCode);
+                    break;
+                }
+                ++uploadHandler->recoveredErrorsCounter;
+                nextBlock = firstBlock;
+                resent = true;
+                timeout = now + 1000;
+            }
+        }
+
+        if( errorStatusMessage != String() )
+            break;
+    }
+
+    mios32SequencedUploadRequest = 0;
+
+    return true;
+}
+
+
 void UploadHandlerThread::run()
 {
     // Core Detection Procedure
@@ -768,28 +1000,22 @@ void UploadHandlerThread::run()
     //////////////////////////////////////////////////////////////////////////////////////
     int64 timeUploadBegin = Time::getCurrentTime().toMilliseconds();
 
-    for(int block=0; block<uploadHandler->totalBlocks; ++block) {
+    // MIOS32: skip unchanged flash sectors and upload the remaining blocks with sequence numbers
+    // if the bootloader supports this, otherwise the blocks are uploaded one after another
+    bool uploadedSequenced = forMios32 && uploadMios32Sequenced(forMios32_LPC17);
+    if( errorStatusMessage != String() || threadShouldExit() )
+        return;
+
+    for(int block=0; !uploadedSequenced && block<uploadHandler->totalBlocks; ++block) {
         uploadHandler->currentBlock = block;
 
         if( threadShouldExit() )
             return;
 
         uint32 blockAddress = uploadHandler->hexFileLoader.hexDumpAddressBlocks[block];
-        if( forMios32 ) {
-            if( forMios32_LPC17 ) {
-                if( blockAddress >= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_LPC17_BL_START &&
-                    blockAddress <= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_LPC17_BL_END ) {
-                    ++uploadHandler->excludedBlocks;
-                    continue; // skip bootloader range
-                }
-            } else {
-                // TODO: check for STM32
-                if( blockAddress >= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_STM32_BL_START &&
-                    blockAddress <= uploadHandler->hexFileLoader.HEX_RANGE_MIOS32_STM32_BL_END ) {
-                    ++uploadHandler->excludedBlocks;
-                    continue; // skip bootloader range
-                }
-            }
+        if( forMios32 && isMios32BootloaderBlock(blockAddress, forMios32_LPC17) ) {
+            ++uploadHandler->excludedBlocks;
+            continue; // skip bootloader range
         }
 
         int maxRetries = 16;
@@ -65,12 +65,31 @@ public:
 
     volatile int uploadErrorCode;
 
+    // checksum of a flash sector returned by the MIOS32 bootloader
+    volatile bool mios32ChecksumRequest;
+    volatile uint32 checksumAddress;
+    volatile uint32 checksumSize;
+    volatile uint32 checksumCrc;
+
+    // (error) acknowledges of sequenced blocks: (<error code> << 8) | <sequence number>, error code 0 on acknowledge
+    volatile bool mios32SequencedUploadRequest;
+    CriticalSection sequenceAcksLock;
+    Array<int> sequenceAcks;
+
+    // number of blocks which are sent by the sequenced upload before the first one has been acknowledged
+    // (the USB MIDI receive buffer of the MIOS32 bootloader can store 4 blocks)
+    static const int MIOS32_UPLOAD_WINDOW_SIZE = 4;
+
 protected:
     void sendMios8Query(void);
     void sendMios32Query(uint8 query);
     void sendMios8InvalidBlock(void);
     void sendMios8RebootCore(void);
     void sendMios32RebootCore(void);
+    void sendMios32ChecksumRequest(uint32 address);
+
+    bool isMios32BootloaderBlock(uint32 blockAddress, bool forMios32_LPC17);
+    bool uploadMios32Sequenced(bool forMios32_LPC17);
 
 };
 
@@ -120,6 +139,7 @@ public:
     uint32 currentBlock;
     uint32 totalBlocks;
     uint32 excludedBlocks;
+    uint32 skippedBlocks;
     int currentErrorCode;
     int recoveredErrorsCounter;
 
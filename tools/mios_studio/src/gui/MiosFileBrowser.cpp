@@ -13,6 +13,7 @@
  */
 
 #include "MiosFileBrowser.h"
+#include "MiosFileBrowserBin.h"
 #include "MiosStudio.h"
 
 //==============================================================================
@@ -168,10 +169,17 @@ MiosFileBrowser::MiosFileBrowser(MiosStudio *_miosStudio)
     , currentReadFileBrowserItem(NULL)
     , currentReadFileStream()
     , currentReadError(false)
+    , currentReadBinary(false)
+    , currentReadNakPending(false)
     , currentWriteInProgress(false)
     , currentWriteError(false)
+    , currentWriteBinary(false)
+    , currentWriteBlockSize(32)
     , writeBlockCtrDefault(32) // send 32 blocks (=two 512 byte SD Card Sectors) at once to speed-up write operations
     , writeBlockSizeDefault(32) // send 32 bytes per block
+    , writeBinBlockSizeDefault(48) // send 48 bytes per block in binary mode (64 characters, fits into the 100 character command buffer of the application)
+    , binaryTransferSupported(true) // will be cleared if the application doesn't support readbin/writebin
+    , binaryCommandPending(false)
 {
     addAndMakeVisible(editLabel = new Label(T("Edit"), String()));
     editLabel->setJustificationType(Justification::left);
@@ -649,7 +657,7 @@ bool MiosFileBrowser::downloadFileSelection(unsigned selection)
 
         if( openHexEditorAfterRead || openTextEditorAfterRead ) {
             disableFileButtons();
-            sendCommand(T("read ") + currentReadFileName);
+            downloadRequest();
             return true;
         } else {
             // restore default path
@@ -683,7 +691,7 @@ bool MiosFileBrowser::downloadFileSelection(unsigned selection)
                     setStatus(T("Failed to open ") + currentReadFile.getFullPathName());
                 } else {
                     disableFileButtons();
-                    sendCommand(T("read ") + currentReadFileName);
+                    downloadRequest();
                     return true;
                 }
             }
@@ -697,6 +705,41 @@ bool MiosFileBrowser::downloadFileSelection(unsigned selection)
     return false;
 }
 
+void MiosFileBrowser::downloadRequest(void)
+{
+    // binary transfer if supported by the application, otherwise ASCII hex
+    currentReadBinary = binaryTransferSupported;
+    currentReadNakPending = false;
+    binaryCommandPending = currentReadBinary;
+    sendCommand((currentReadBinary ? T("readbin ") : T("read ")) + currentReadFileName);
+}
+
+void MiosFileBrowser::downloadDataReceived(void)
+{
+    String statusMessage;
+    unsigned receivedSize = currentReadData.size();
+    uint32 currentReadFinished = Time::currentTimeMillis();
+    float downloadTime = (float)(currentReadFinished-currentReadStartTime) / 1000.0;
+    float dataRate = ((float)receivedSize/1000.0) / downloadTime;
+    if( receivedSize >= currentReadSize ) {
+        statusMessage = String(T("Download of ") + currentReadFileName +
+                               T(" (") + String(receivedSize) + T(" bytes) completed in ") +
+                               String::formatted(T("%2.1fs (%2.1f kb/s)"), downloadTime, dataRate));
+        currentReadInProgress = false;
+
+        setStatus(statusMessage);
+        downloadFinished();
+    } else {
+        statusMessage = String(T("Downloading ") + currentReadFileName + T(": ") +
+                               String(receivedSize) + T(" bytes received") +
+                               String::formatted(T(" (%d%%, %2.1f kb/s)"),
+                                                 (int)(100.0*(float)receivedSize/(float)currentReadSize),
+                                                 dataRate));
+        setStatus(statusMessage);
+        startTimer(5000);
+    }
+}
+
 bool MiosFileBrowser::downloadFinished(void)
 {
     if( openHexEditorAfterRead ) {
@@ -884,7 +927,12 @@ bool MiosFileBrowser::uploadBuffer(String filename, const Array<uint8>& buffer)
     currentWriteFirstBlockOffset = 0;
     currentWriteBlockCtr = writeBlockCtrDefault;
     currentWriteStartTime = Time::currentTimeMillis();
-    sendCommand(T("write ") + currentWriteFileName + T(" ") + String(currentWriteSize));
+
+    // binary transfer if supported by the application, otherwise ASCII hex
+    currentWriteBinary = binaryTransferSupported;
+    currentWriteBlockSize = currentWriteBinary ? writeBinBlockSizeDefault : writeBlockSizeDefault;
+    binaryCommandPending = currentWriteBinary;
+    sendCommand((currentWriteBinary ? T("writebin ") : T("write ")) + currentWriteFileName + T(" ") + String(currentWriteSize));
     startTimer(5000);
 
     return true;
@@ -973,7 +1021,20 @@ void MiosFileBrowser::receiveCommand(const String& command)
 
         ////////////////////////////////////////////////////////////////////
         case '?': {
-            statusMessage = String(T("Command not supported by MIOS32 application - please check if a firmware update is available!"));
+            if( binaryCommandPending ) {
+                // readbin/writebin not supported by the application: fall back to ASCII hex transfers
+                binaryTransferSupported = false;
+                binaryCommandPending = false;
+                if( currentWriteInProgress ) {
+                    String filename(currentWriteFileName);
+                    Array<uint8> data(currentWriteData);
+                    uploadBuffer(filename, data);
+                } else {
+                    downloadRequest();
+                }
+            } else {
+                statusMessage = String(T("Command not supported by MIOS32 application - please check if a firmware update is available!"));
+            }
         } break;
 
         ////////////////////////////////////////////////////////////////////
@@ -1023,8 +1084,15 @@ void MiosFileBrowser::receiveCommand(const String& command)
         } break;
 
         ////////////////////////////////////////////////////////////////////
+        case 'B': // binary read
         case 'R': {
-            if( command[1] == '!' ) {
+            binaryCommandPending = false;
+
+            if( command[1] == '~' ) {
+                statusMessage = String(T("FATAL: invalid parameters for read operation!"));
+                currentReadInProgress = false;
+                currentReadError = true;
+            } else if( command[1] == '!' ) {
                 statusMessage = String(T("SD Card not mounted!"));
             } else if( command[1] == '-' ) {
                 statusMessage = String(T("Failed to access " + currentReadFileName + "!"));
@@ -1069,33 +1137,15 @@ void MiosFileBrowser::receiveCommand(const String& command)
                         currentReadData.set(address + (pos/2), b);
                     }
 
-                    unsigned receivedSize = currentReadData.size();
-                    uint32 currentReadFinished = Time::currentTimeMillis();
-                    float downloadTime = (float)(currentReadFinished-currentReadStartTime) / 1000.0;
-                    float dataRate = ((float)receivedSize/1000.0) / downloadTime;
-                    if( receivedSize >= currentReadSize ) {
-                        statusMessage = String(T("Download of ") + currentReadFileName +
-                                               T(" (") + String(receivedSize) + T(" bytes) completed in ") +
-                                               String::formatted(T("%2.1fs (%2.1f kb/s)"), downloadTime, dataRate));
-                        currentReadInProgress = false;
-
-                        setStatus(statusMessage);
-                        downloadFinished();
-                        statusMessage = String(); // status has been updated by downloadFinished()
-                    } else {
-                        statusMessage = String(T("Downloading ") + currentReadFileName + T(": ") +
-                                               String(receivedSize) + T(" bytes received") +
-                                               String::formatted(T(" (%d%%, %2.1f kb/s)"),
-                                                                 (int)(100.0*(float)receivedSize/(float)currentReadSize),
-                                                                 dataRate));
-                        startTimer(5000);
-                    }
+                    downloadDataReceived(); // updates the status
                 }
             }
         } break;
 
         ////////////////////////////////////////////////////////////////////
         case 'W': {
+            binaryCommandPending = false;
+
             if( currentWriteError ) {
                 // ignore
             } else if( !currentWriteInProgress ) {
@@ -1106,6 +1156,11 @@ void MiosFileBrowser::receiveCommand(const String& command)
                 statusMessage = String(T("Failed to access " + currentWriteFileName + "!"));
             } else if( command[1] == '~' ) {
                 statusMessage = String(T("FATAL: invalid parameters for write operation!"));
+            } else if( command[1] == '*' ) {
+                currentWriteError = true;
+                currentWriteInProgress = false;
+                enableFileButtons();
+                statusMessage = String(T("Upload of ") + currentWriteFileName + T(" aborted due to a checksum error!"));
             } else if( command[1] == '#' ) {
                 uploadFinished();
                 statusMessage = String(); // status has been updated by uploadFinished()
@@ -1114,7 +1169,7 @@ void MiosFileBrowser::receiveCommand(const String& command)
 
                 if( currentWriteBlockCtr < writeBlockCtrDefault ) {
                     // check for valid response
-                    unsigned expectedOffset = currentWriteFirstBlockOffset + (writeBlockSizeDefault*(currentWriteBlockCtr+1));
+                    unsigned expectedOffset = currentWriteFirstBlockOffset + (currentWriteBlockSize*(currentWriteBlockCtr+1));
                     if( addressOffset != expectedOffset ) {
                         currentWriteError = true;
                         setStatus(String::formatted(T("ERROR: the application has requested file position 0x%08X, but filebrowser expected 0x%08X! Please check with TK!"), addressOffset, expectedOffset));
@@ -1128,14 +1183,37 @@ void MiosFileBrowser::receiveCommand(const String& command)
                     currentWriteFirstBlockOffset = addressOffset;
                     currentWriteBlockCtr = 0;
 
-                    for(unsigned block=0; block<writeBlockCtrDefault; ++block, addressOffset += writeBlockSizeDefault) {
-                        String writeCommand(String::formatted(T("writedata %08X "), addressOffset));
-                        for(int i=0; i<writeBlockSizeDefault && (i+addressOffset)<currentWriteSize; ++i) {
-                            writeCommand += String::formatted(T("%02X"), currentWriteData[addressOffset + i]);
+                    for(unsigned block=0; block<writeBlockCtrDefault; ++block, addressOffset += currentWriteBlockSize) {
+                        unsigned blockSize = currentWriteSize - addressOffset;
+                        if( blockSize > currentWriteBlockSize )
+                            blockSize = currentWriteBlockSize;
+
+                        if( currentWriteBinary ) {
+                            // 6bit coding: 3 bytes are sent with 4 characters ('0'..'o')
+                            const uint8 *data = (const uint8 *)&currentWriteData.getReference(addressOffset);
+                            String writeCommand(String::formatted(T("writebindata %08X %08X "), addressOffset, calcCrc32(data, blockSize)));
+                            uint32 bits = 0;
+                            int numBits = 0;
+                            for(int i=0; i<blockSize; ++i) {
+                                bits = (bits << 8) | data[i];
+                                numBits += 8;
+                                while( numBits >= 6 ) {
+                                    numBits -= 6;
+                                    writeCommand += (char)(0x30 + ((bits >> numBits) & 0x3f));
+                                }
+                            }
+                            if( numBits )
+                                writeCommand += (char)(0x30 + ((bits << (6-numBits)) & 0x3f));
+                            sendCommand(writeCommand);
+                        } else {
+                            String writeCommand(String::formatted(T("writedata %08X "), addressOffset));
+                            for(int i=0; i<blockSize; ++i) {
+                                writeCommand += String::formatted(T("%02X"), currentWriteData[addressOffset + i]);
+                            }
+                            sendCommand(writeCommand);
                         }
-                        sendCommand(writeCommand);
 
-                        if( (writeBlockSizeDefault+addressOffset) >= currentWriteSize )
+                        if( (currentWriteBlockSize+addressOffset) >= currentWriteSize )
                             break;
                     }
 
@@ -1195,6 +1273,58 @@ void MiosFileBrowser::receiveCommand(const String& command)
     }
 }
 
+//==============================================================================
+void MiosFileBrowser::receiveBinaryBlock(const uint8 *data, uint32 size)
+{
+    // format: <address: 8 hex digits> <7bit packed data> <CRC32: 5 x 7bit> (F7 already removed)
+    stopTimer(); // will be restarted if required
+
+    if( !currentReadInProgress || !currentReadBinary ) {
+        setStatus(T("There is a read operation in progress - please wait!"));
+        return;
+    }
+
+    HeapBlock<uint8> block(size); // the unpacked data is smaller than the packed one
+    uint32 address = 0;
+    int32 blockSize = miosFileBrowserUnpackBinBlock(data, size, &address, block);
+    if( blockSize == -1 ) {
+        setStatus(currentReadFileName + T(" received invalid payload!"));
+        currentReadError = true;
+        return;
+    }
+
+    // blocks which have been sent before a retry was requested are ignored
+    unsigned expectedAddress = currentReadData.size();
+    if( address != expectedAddress ) {
+        startTimer(5000);
+        return;
+    }
+
+    if( blockSize <= 0 || (address + blockSize) > currentReadSize ) {
+        // request the block again (only once, following blocks will be ignored until it has been received)
+        if( !currentReadNakPending ) {
+            currentReadNakPending = true;
+            sendCommand(String::formatted(T("readbinnak %08X"), expectedAddress));
+        }
+        startTimer(5000);
+        return;
+    }
+
+    currentReadNakPending = false;
+    currentReadData.addArray(block.getData(), blockSize);
+
+    // acknowledge received data, this allows the application to send the next block
+    sendCommand(String::formatted(T("readbinack %08X"), currentReadData.size()));
+
+    downloadDataReceived(); // updates the status
+}
+
+//==============================================================================
+uint32 MiosFileBrowser::calcCrc32(const uint8 *data, uint32 size)
+{
+    return miosFileBrowserCrc32(data, size);
+}
+
 //==============================================================================
 bool MiosFileBrowser::uploadFileInProgress(void)
 {
@@ -1225,7 +1355,10 @@ void MiosFileBrowser::handleIncomingMidiMessage(const MidiMessage& message, uint
         setStatus(T("Filebrowser access not implemented by this application!"));
     }
 
-    if( messageReceived ) {
+    if( messageReceived && size > 9 && data[messageOffset] == 'b' ) {
+        // binary block: don't convert to string, since it can contain zeroes
+        receiveBinaryBlock(data + messageOffset + 1, size - messageOffset - 2);
+    } else if( messageReceived ) {
         String command;
 
         for(int i=messageOffset; i<size; ++i) {
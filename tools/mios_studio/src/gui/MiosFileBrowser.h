@@ -78,6 +78,8 @@ public:
 
     //==============================================================================
     bool downloadFileSelection(unsigned selection);
+    void downloadRequest(void);
+    void downloadDataReceived(void);
     bool downloadFinished(void);
 
     //==============================================================================
@@ -102,6 +104,8 @@ public:
     //==============================================================================
     void sendCommand(const String& command);
     void receiveCommand(const String& command);
+    void receiveBinaryBlock(const uint8 *data, uint32 size);
+    static uint32 calcCrc32(const uint8 *data, uint32 size);
 
     //==============================================================================
     bool uploadFileInProgress(void);
@@ -152,6 +156,8 @@ protected:
     unsigned     currentReadSize;
     Array<uint8> currentReadData;
     uint32       currentReadStartTime;
+    bool         currentReadBinary;
+    bool         currentReadNakPending;
 
     bool         currentWriteInProgress;
     bool         currentWriteError;
@@ -161,9 +167,15 @@ protected:
     unsigned     currentWriteFirstBlockOffset;
     unsigned     currentWriteBlockCtr;
     uint32       currentWriteStartTime;
+    bool         currentWriteBinary;
+    unsigned     currentWriteBlockSize;
 
     unsigned     writeBlockCtrDefault;
     unsigned     writeBlockSizeDefault;
+    unsigned     writeBinBlockSizeDefault;
+
+    bool         binaryTransferSupported;
+    bool         binaryCommandPending;
 
     HexTextEditor* hexEditor;
     TextEditor*    textEditor;
@@ -0,0 +1,85 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Decoder for the binary blocks of the MIOS32 file browser ("readbin" command)
+ *
+ * The functions don't depend on JUCE, so that they can also be compiled by
+ * the host test of the firmware encoder ($MIOS32_PATH/modules/file/gnu_test)
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2026 agent (agent@local)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _MIOS_FILE_BROWSER_BIN_H
+#define _MIOS_FILE_BROWSER_BIN_H
+
+#include <stdint.h>
+
+// CRC32 as used by zip/ethernet, the same algorithm is used by the MIOS32 FILE module
+static inline uint32_t miosFileBrowserCrc32(const uint8_t *data, uint32_t size)
+{
+    uint32_t crc = 0xffffffff;
+    uint32_t i;
+    for(i=0; i<size; ++i) {
+        int bit;
+        crc ^= data[i];
+        for(bit=0; bit<8; ++bit)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+    }
+    return ~crc;
+}
+
+// Unpacks a binary block which has been sent by FILE_BrowserHandler
+// format: <address: 8 hex digits> <7bit packed data> <CRC32: 5 x 7bit> (without 'b' and F7)
+// The block buffer has to provide space for 7*size/8 bytes.
+// returns the number of unpacked bytes, -1 if the payload is invalid, -2 on a CRC error
+// (address is already valid on CRC errors)
+static inline int32_t miosFileBrowserUnpackBinBlock(const uint8_t *data, uint32_t size, uint32_t *address, uint8_t *block)
+{
+    uint32_t i;
+
+    if( size < (8+5) )
+        return -1;
+
+    *address = 0;
+    for(i=0; i<8; ++i) {
+        uint8_t c = data[i];
+        uint8_t digit;
+        if( c >= '0' && c <= '9' )
+            digit = c - '0';
+        else if( c >= 'A' && c <= 'F' )
+            digit = c - 'A' + 10;
+        else if( c >= 'a' && c <= 'f' )
+            digit = c - 'a' + 10;
+        else
+            return -1;
+        *address = (*address << 4) | digit;
+    }
+
+    // each group starts with a byte which contains the MSBs of max. 7 following bytes
+    const uint8_t *packed = data + 8;
+    uint32_t packedSize = size - 8 - 5;
+    int32_t blockSize = 0;
+    uint32_t pos;
+    for(pos=0; pos<packedSize; pos+=8) {
+        uint8_t msbs = packed[pos];
+        for(i=0; i<7 && (pos+1+i)<packedSize; ++i)
+            block[blockSize++] = packed[pos+1+i] | ((msbs & (1 << i)) ? 0x80 : 0x00);
+    }
+
+    const uint8_t *crcBytes = packed + packedSize;
+    uint32_t crc = ((uint32_t)crcBytes[0] << 28) | ((uint32_t)crcBytes[1] << 21) | ((uint32_t)crcBytes[2] << 14) |
+                   ((uint32_t)crcBytes[3] << 7) | (uint32_t)crcBytes[4];
+
+    if( crc != miosFileBrowserCrc32(block, blockSize) )
+        return -2;
+
+    return blockSize;
+}
+
+#endif /* _MIOS_FILE_BROWSER_BIN_H */
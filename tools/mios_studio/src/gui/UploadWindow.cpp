@@ -370,7 +370,7 @@ void UploadWindow::timerCallback(const int timerId)
                 addLogEntry(Colours::red, errorMessage);
                 uploadQuery->clear();
             } else {
-                uint32 totalBlocks = miosStudio->uploadHandler->totalBlocks - miosStudio->uploadHandler->excludedBlocks;
+                uint32 totalBlocks = miosStudio->uploadHandler->totalBlocks - miosStudio->uploadHandler->excludedBlocks - miosStudio->uploadHandler->skippedBlocks;
                 float timeUpload = miosStudio->uploadHandler->timeUpload;
                 float transferRateKb = ((totalBlocks * 256) / timeUpload) / 1024;
                 addLogEntry(Colours::green, String::formatted(T("Upload of %d bytes completed after %3.2fs (%3.2f kb/s)"),
@@ -378,6 +378,11 @@ void UploadWindow::timerCallback(const int timerId)
                                                                          timeUpload,
                                                                          transferRateKb));
 
+                if( miosStudio->uploadHandler->skippedBlocks > 0 ) {
+                    addLogEntry(Colours::grey, String::formatted(T("%d unchanged blocks skipped"),
+                                                                            miosStudio->uploadHandler->skippedBlocks));
+                }
+
                 if( miosStudio->uploadHandler->recoveredErrorsCounter > 0 ) {
                     addLogEntry(Colours::grey, String::formatted(T("%d ignorable errors during upload solved (no issue!)"),
                                                                             miosStudio->uploadHandler->recoveredErrorsCounter));